@@ -575,6 +575,30 @@ var (
 		mkField("CustomScreenDPI", Int, 0,
 			"actual resolution of the main screen in DPI (if this value "+
 				"isn't positive, the system's UI setting is used)").setExpert().setVersion("2.5"),
+		mkField("RenderCacheSize", Int, 0,
+			"maximum size in MB of the cache of rendered page bitmaps (if this "+
+				"value isn't positive, the limit is derived from installed RAM)").setExpert(),
+		mkField("EnableTextIndexCache", Bool, false,
+			"if true, extracted page text is cached on disk (next to the thumbnail "+
+				"cache) so that search in large documents is instant across sessions").setExpert(),
+		mkField("EnableTileDiskCache", Bool, false,
+			"if true, compressed tiles evicted from the render cache are also saved "+
+				"to disk (next to the thumbnail cache) and reused when the same "+
+				"document is reopened").setExpert(),
+		mkField("SmoothScroll", Bool, true,
+			"if true, mouse wheel scrolling coasts with inertia instead of "+
+				"jumping line by line").setExpert(),
+		mkField("HighlightSearchMatches", Bool, true,
+			"if true, a successful search highlights all matches on the visible "+
+				"pages, not just the current one").setExpert(),
+		mkField("LowMemoryMode", Utf8String, "auto",
+			"controls the low-memory profile, which shrinks the render cache and "+
+				"disables speculative rendering and text extraction: \"on\" and \"off\" "+
+				"force it, \"auto\" follows the OS' memory pressure signal").setExpert(),
+		mkField("TabHibernateAfterMin", Int, 120,
+			"a background tab whose document hasn't been viewed for this many "+
+				"minutes is unloaded to save memory and transparently reloaded on "+
+				"its next activation (0 disables tab hibernation)").setExpert(),
 		mkEmptyLine(),
 
 		mkField("RememberStatePerDocument", Bool, true,
@@ -516,59 +516,87 @@ static void* fz_resize_array(fz_context* ctx, void* p, unsigned int count, unsig
     return np;
 }
 
-typedef struct cached_font {
-    struct cached_font* next;
+/* The bytes of a font file are immutable, so they're read once and shared
+   by all contexts for the life of the process: each context wraps the same
+   data in its own fz_buffer via fz_new_buffer_from_shared_data(), which
+   doesn't take ownership. Before, every document context read its own copy
+   of every font file, so many open documents duplicated the same faces. */
+typedef struct cached_font_data {
+    struct cached_font_data* next;
     sys_font_info* fi;
-    fz_context* ctx;
-    fz_buffer* buffer;
-} cached_font;
+    unsigned char* data;
+    size_t size;
+} cached_font_data;
+
+static cached_font_data* cached_fonts = 0;
+
+static unsigned char* read_file_data(const char* path, size_t* sizeOut) {
+    unsigned char* data = NULL;
+    long size;
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return NULL;
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) <= 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return NULL;
+    }
+    data = (unsigned char*)malloc(size);
+    if (data && fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    *sizeOut = (size_t)size;
+    return data;
+}
 
-static cached_font* cached_fonts = 0;
+static cached_font_data* get_cached_font_data(sys_font_info* fi) {
+    cached_font_data* f;
+    unsigned char* data;
+    size_t size = 0;
 
-static fz_buffer* get_cached_font_buffer(fz_context* ctx, sys_font_info* fi) {
     EnterCriticalSection(&cs_fonts);
-    cached_font* f = cached_fonts;
-    fz_buffer* buffer = NULL;
-    while (f) {
-        if (f->ctx == ctx && f->fi == fi) {
-            buffer = f->buffer;
+    for (f = cached_fonts; f; f = f->next) {
+        if (f->fi == fi)
             break;
-        }
-        f = f->next;
     }
     LeaveCriticalSection(&cs_fonts);
-    return buffer;
-}
+    if (f)
+        return f;
 
-void drop_cached_fonts_for_ctx(fz_context* ctx) {
-    EnterCriticalSection(&cs_fonts);
+    data = read_file_data(fi->fontpath, &size);
+    if (!data)
+        return NULL;
 
-    cached_font** currp = &cached_fonts;
-    cached_font** nextp;
-    cached_font* curr;
-    cached_font* next;
-    int refs;
-    while (1) {
-        curr = *currp;
-        if (!curr) {
+    EnterCriticalSection(&cs_fonts);
+    /* another thread may have read the same font in the meantime */
+    for (f = cached_fonts; f; f = f->next) {
+        if (f->fi == fi)
             break;
-        }
-        nextp = &(curr->next);
-        if (curr->ctx == ctx) {
-            next = *nextp;
-            refs = curr->buffer->refs;
-            if (refs != 1) {
-                // TODO: crash?
-                fz_warn(ctx, "drop_cached_fonts_for_ctx: bad refcount %d", refs);
-            }
-            fz_drop_buffer(curr->ctx, curr->buffer);
-            free(curr);
-            *currp = next;
+    }
+    if (f) {
+        free(data);
+    } else {
+        f = (cached_font_data*)malloc(sizeof(cached_font_data));
+        if (f) {
+            f->fi = fi;
+            f->data = data;
+            f->size = size;
+            f->next = cached_fonts;
+            cached_fonts = f;
         } else {
-            currp = nextp;
+            free(data);
         }
     }
     LeaveCriticalSection(&cs_fonts);
+    return f;
+}
+
+/* kept for binary compatibility: font file data is now shared process-wide
+   (see cached_font_data) and the per-context fz_buffer wrappers are dropped
+   together with the fonts referencing them, so there's nothing to do here */
+void drop_cached_fonts_for_ctx(fz_context* ctx) {
+    (void)ctx;
 }
 
 static fz_font* pdf_load_windows_font_by_name(fz_context* ctx, const char* orig_name) {
@@ -644,28 +672,25 @@ static fz_font* pdf_load_windows_font_by_name(fz_context* ctx, const char* orig_
     if (!found)
         fz_throw(ctx, FZ_ERROR_GENERIC, "couldn't find system font '%s'", orig_name);
 
-    buffer = get_cached_font_buffer(ctx, found);
-    if (buffer) {
-        fz_warn(ctx, "found cached non-embedded buffer for font '%s' from '%s'", orig_name, found->fontpath);
-    } else {
-        buffer = fz_read_file(ctx, found->fontpath);
-        if (!buffer) {
-            return NULL;
-        }
-        cached_font* f = (cached_font*)malloc(sizeof(cached_font));
-        f->fi = found;
-        f->ctx = ctx;
-        f->buffer = buffer;
-        EnterCriticalSection(&cs_fonts);
-        f->next = cached_fonts;
-        cached_fonts = f;
-        LeaveCriticalSection(&cs_fonts);
+    cached_font_data* cached = get_cached_font_data(found);
+    if (!cached)
+        fz_throw(ctx, FZ_ERROR_GENERIC, "couldn't read system font '%s' from '%s'", orig_name, found->fontpath);
 
-        fz_warn(ctx, "loading non-embedded font '%s' from '%s'", orig_name, found->fontpath);
-    }
+    /* a cheap per-context wrapper around the process-wide font file data */
+    buffer = fz_new_buffer_from_shared_data(ctx, cached->data, cached->size);
 
     int use_glyph_bbox = strcmp(found->fontface, "DroidSansFallback") != 0;
-    font = fz_new_font_from_buffer(ctx, orig_name, buffer, found->index, use_glyph_bbox);
+    fz_var(font);
+    fz_try(ctx) {
+        font = fz_new_font_from_buffer(ctx, orig_name, buffer, found->index, use_glyph_bbox);
+    }
+    fz_always(ctx) {
+        /* the font holds its own reference */
+        fz_drop_buffer(ctx, buffer);
+    }
+    fz_catch(ctx) {
+        fz_rethrow(ctx);
+    }
     font->flags.ft_substitute = 1;
     return font;
 }
@@ -773,6 +798,14 @@ void init_system_font_list(void) {
 }
 
 void destroy_system_font_list(void) {
+    cached_font_data* f = cached_fonts;
+    while (f) {
+        cached_font_data* next = f->next;
+        free(f->data);
+        free(f);
+        f = next;
+    }
+    cached_fonts = 0;
     free(fontlistMS.fontmap);
     memset(&fontlistMS, 0, sizeof(fontlistMS));
     DeleteCriticalSection(&cs_fonts);
@@ -390,6 +390,25 @@ void fz_set_pixmap_image_tile(fz_context *ctx, fz_pixmap_image *cimg, fz_pixmap
 */
 fz_pixmap *fz_load_jpx(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspace *cs);
 
+/**
+	As fz_load_jpx, but decodes at a reduced resolution using the
+	codestream's native resolution levels.
+
+	l2factor: NULL, or a pointer to the maximum log2 subsampling
+	requested. On return it is updated to the subsampling still left
+	to be done in software (the decoder consumes as many levels as
+	the codestream offers, up to the request).
+*/
+fz_pixmap *fz_load_jpx_reduced(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspace *cs, int *l2factor);
+
+/**
+	Set the number of threads used for JPEG2000 tile decoding.
+	0 or 1 decodes single-threaded. Applies process-wide (the
+	underlying openjpeg codec is already serialized by a global
+	lock); call once before the first decode.
+*/
+void fz_set_jpx_decode_threads(fz_context *ctx, int num_threads);
+
 /**
 	Exposed for CBZ.
 */
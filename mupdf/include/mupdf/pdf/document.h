@@ -282,6 +282,12 @@ typedef struct
 	int64_t offset; /* Offset of first object */
 } pdf_hint_shared;
 
+typedef struct pdf_jbig2_globals_cache
+{
+	int num; /* Object number of the globals stream */
+	fz_jbig2_globals *globals;
+} pdf_jbig2_globals_cache;
+
 struct pdf_document
 {
 	fz_document super;
@@ -373,6 +379,13 @@ struct pdf_document
 	int max_type3_fonts;
 	fz_font **type3_fonts;
 
+	/* Decoded JBIG2 globals (symbol dictionaries shared by many pages),
+	 * pinned for the life of the document so that store eviction can't
+	 * force a re-decode mid-document (see pdf_load_jbig2_globals). */
+	int num_jbig2_globals;
+	int max_jbig2_globals;
+	pdf_jbig2_globals_cache *jbig2_globals;
+
 	struct {
 		fz_hash_table *fonts;
 	} resources;
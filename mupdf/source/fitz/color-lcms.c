@@ -56,10 +56,199 @@ struct fz_icc_link
 {
 	fz_storable storable;
 	void *handle;
+	int shared;
 };
 
 #ifdef HAVE_LCMS2MT
 
+/* Process-wide cache of simple (non-proofing) transforms. Different
+ * documents routinely need the very same transform (e.g. sRGB to the
+ * BGR display space), and with one lcms instance per context each of
+ * them would rebuild it from scratch. Cached transforms are created on
+ * a private process-lifetime cmsContext, so they can outlive any
+ * document's context and be used from several at once (lcms2mt objects
+ * carry no context of their own; one is passed per call). Entries are
+ * kept, bounded, even while unused so the next document gets them for
+ * free.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define MAX_SHARED_TRANSFORMS 32
+
+typedef struct fz_shared_transform
+{
+	unsigned char src_md5[16];
+	unsigned char dst_md5[16];
+	cmsUInt32Number src_fmt;
+	cmsUInt32Number dst_fmt;
+	cmsUInt32Number intent;
+	cmsUInt32Number flags;
+	void *handle;
+	int refs;
+	struct fz_shared_transform *next;
+} fz_shared_transform;
+
+static fz_shared_transform *fz_shared_transforms = NULL;
+static int fz_shared_transform_count = 0;
+static cmsContext fz_shared_instance = NULL;
+
+#ifdef _WIN32
+
+static CRITICAL_SECTION fz_shared_transform_lock;
+static INIT_ONCE fz_shared_transform_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK fz_shared_transform_lock_init(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+	InitializeCriticalSection(&fz_shared_transform_lock);
+	return TRUE;
+}
+
+static void fz_lock_shared_transforms(void)
+{
+	InitOnceExecuteOnce(&fz_shared_transform_once, fz_shared_transform_lock_init, NULL, NULL);
+	EnterCriticalSection(&fz_shared_transform_lock);
+}
+
+static void fz_unlock_shared_transforms(void)
+{
+	LeaveCriticalSection(&fz_shared_transform_lock);
+}
+
+#else
+
+static pthread_mutex_t fz_shared_transform_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void fz_lock_shared_transforms(void)
+{
+	pthread_mutex_lock(&fz_shared_transform_mutex);
+}
+
+static void fz_unlock_shared_transforms(void)
+{
+	pthread_mutex_unlock(&fz_shared_transform_mutex);
+}
+
+#endif
+
+/* Returns a cached (possibly just created and cached) transform, or NULL
+ * if none could be created; the caller then builds an unshared transform
+ * on its own context as before. The cache and its entries deliberately
+ * use the default allocator: they outlive every fz_context.
+ */
+static void *
+fz_find_shared_icc_transform(fz_colorspace *src, fz_colorspace *dst,
+	cmsUInt32Number src_fmt, cmsUInt32Number dst_fmt,
+	cmsUInt32Number intent, cmsUInt32Number flags)
+{
+	fz_shared_transform *t, **prev;
+	void *handle;
+
+	fz_lock_shared_transforms();
+
+	if (fz_shared_instance == NULL)
+		fz_shared_instance = cmsCreateContext(NULL, NULL);
+	if (fz_shared_instance == NULL)
+	{
+		fz_unlock_shared_transforms();
+		return NULL;
+	}
+
+	for (t = fz_shared_transforms; t; t = t->next)
+	{
+		if (memcmp(t->src_md5, src->u.icc.md5, 16) == 0 &&
+			memcmp(t->dst_md5, dst->u.icc.md5, 16) == 0 &&
+			t->src_fmt == src_fmt && t->dst_fmt == dst_fmt &&
+			t->intent == intent && t->flags == flags)
+		{
+			t->refs++;
+			fz_unlock_shared_transforms();
+			return t->handle;
+		}
+	}
+
+	handle = cmsCreateTransform(fz_shared_instance, src->u.icc.profile, src_fmt, dst->u.icc.profile, dst_fmt, intent, flags);
+	if (handle == NULL)
+	{
+		fz_unlock_shared_transforms();
+		return NULL;
+	}
+
+	if (fz_shared_transform_count >= MAX_SHARED_TRANSFORMS)
+	{
+		/* evict one idle entry; if every entry is in use the cache grows */
+		for (prev = &fz_shared_transforms; *prev; prev = &(*prev)->next)
+		{
+			if ((*prev)->refs == 0)
+			{
+				fz_shared_transform *dead = *prev;
+				*prev = dead->next;
+				cmsDeleteTransform(fz_shared_instance, dead->handle);
+				free(dead);
+				fz_shared_transform_count--;
+				break;
+			}
+		}
+	}
+
+	t = malloc(sizeof(fz_shared_transform));
+	if (t == NULL)
+	{
+		cmsDeleteTransform(fz_shared_instance, handle);
+		fz_unlock_shared_transforms();
+		return NULL;
+	}
+	memcpy(t->src_md5, src->u.icc.md5, 16);
+	memcpy(t->dst_md5, dst->u.icc.md5, 16);
+	t->src_fmt = src_fmt;
+	t->dst_fmt = dst_fmt;
+	t->intent = intent;
+	t->flags = flags;
+	t->handle = handle;
+	t->refs = 1;
+	t->next = fz_shared_transforms;
+	fz_shared_transforms = t;
+	fz_shared_transform_count++;
+
+	fz_unlock_shared_transforms();
+	return handle;
+}
+
+static void
+fz_release_shared_icc_transform(void *handle)
+{
+	fz_shared_transform *t;
+
+	fz_lock_shared_transforms();
+	for (t = fz_shared_transforms; t; t = t->next)
+	{
+		if (t->handle == handle)
+		{
+			t->refs--;
+			break;
+		}
+	}
+	fz_unlock_shared_transforms();
+}
+
+/* For functions operating on an existing link: a shared transform must
+ * always be called with the instance it was created on, never with a
+ * (mortal) document context.
+ */
+#define LINKGLOINIT(l) cmsContext glo = (l)->shared ? fz_shared_instance : ctx->colorspace->icc_instance;
+
+#else
+
+#define LINKGLOINIT(l)
+
+#endif
+
+#ifdef HAVE_LCMS2MT
+
 static void fz_lcms_log_error(cmsContext id, cmsUInt32Number error_code, const char *error_text)
 {
 	fz_context *ctx = (fz_context *)cmsGetContextUserData(id);
@@ -184,9 +373,20 @@ int fz_icc_profile_components(fz_context *ctx, fz_icc_profile *profile)
 
 void fz_drop_icc_link_imp(fz_context *ctx, fz_storable *storable)
 {
-	GLOINIT
 	fz_icc_link *link = (fz_icc_link*)storable;
-	cmsDeleteTransform(GLO link->handle);
+#ifdef HAVE_LCMS2MT
+	if (link->shared)
+	{
+		/* shared transforms stay cached for the next document */
+		fz_release_shared_icc_transform(link->handle);
+		fz_free(ctx, link);
+		return;
+	}
+#endif
+	{
+		GLOINIT
+		cmsDeleteTransform(GLO link->handle);
+	}
 	fz_free(ctx, link);
 }
 
@@ -215,6 +415,7 @@ fz_new_icc_link(fz_context *ctx,
 	cmsUInt32Number flags;
 	cmsHTRANSFORM transform;
 	fz_icc_link *link;
+	int shared = 0;
 
 	flags = cmsFLAGS_LOWRESPRECALC;
 
@@ -253,7 +454,13 @@ fz_new_icc_link(fz_context *ctx,
 
 	if (prf_pro == NULL)
 	{
-		transform = cmsCreateTransform(GLO src_pro, src_fmt, dst_pro, dst_fmt, rend.ri, flags);
+		transform = NULL;
+#ifdef HAVE_LCMS2MT
+		transform = fz_find_shared_icc_transform(src, dst, src_fmt, dst_fmt, rend.ri, flags);
+		shared = (transform != NULL);
+#endif
+		if (!transform)
+			transform = cmsCreateTransform(GLO src_pro, src_fmt, dst_pro, dst_fmt, rend.ri, flags);
 		if (!transform)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "cmsCreateTransform(%s,%s) failed", src->name, dst->name);
 	}
@@ -311,10 +518,16 @@ fz_new_icc_link(fz_context *ctx,
 		link = fz_malloc_struct(ctx, fz_icc_link);
 		FZ_INIT_STORABLE(link, 1, fz_drop_icc_link_imp);
 		link->handle = transform;
+		link->shared = shared;
 	}
 	fz_catch(ctx)
 	{
-		cmsDeleteTransform(GLO transform);
+#ifdef HAVE_LCMS2MT
+		if (shared)
+			fz_release_shared_icc_transform(transform);
+		else
+#endif
+			cmsDeleteTransform(GLO transform);
 		fz_rethrow(ctx);
 	}
 	return link;
@@ -323,7 +536,7 @@ fz_new_icc_link(fz_context *ctx,
 void
 fz_icc_transform_color(fz_context *ctx, fz_color_converter *cc, const float *src, float *dst)
 {
-	GLOINIT
+	LINKGLOINIT(cc->link)
 #if LCMS_USE_FLOAT
 	cmsDoTransform(GLO cc->link->handle, src, dst, 1);
 #else
@@ -352,7 +565,7 @@ fz_icc_transform_color(fz_context *ctx, fz_color_converter *cc, const float *src
 void
 fz_icc_transform_pixmap(fz_context *ctx, fz_icc_link *link, const fz_pixmap *src, fz_pixmap *dst, int copy_spots)
 {
-	GLOINIT
+	LINKGLOINIT(link)
 	int cmm_num_src, cmm_num_dst, cmm_extras;
 	unsigned char *inputpos, *outputpos, *buffer;
 	int ss = src->stride;
@@ -703,7 +703,9 @@ compressed_image_get_pixmap(fz_context *ctx, fz_image *image_, fz_irect *subarea
 		tile = fz_load_jxr(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
 		break;
 	case FZ_IMAGE_JPX:
-		tile = fz_load_jpx(ctx, image->buffer->buffer->data, image->buffer->buffer->len, NULL);
+		/* JP2 codestreams carry native resolution levels, so the
+		 * decoder can do (part of) the subsampling for us. */
+		tile = fz_load_jpx_reduced(ctx, image->buffer->buffer->data, image->buffer->buffer->len, NULL, l2factor);
 		break;
 	case FZ_IMAGE_JPEG:
 		/* Scan JPEG stream and patch missing height values in header */
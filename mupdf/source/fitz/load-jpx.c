@@ -216,6 +216,20 @@ void * opj_aligned_realloc(void *ptr, size_t size)
 }
 #endif
 
+/* Number of threads openjpeg may use for tile/codeblock decoding.
+ * The decode as a whole is serialized by the global opj lock above,
+ * so the worker threads only ever serve one decode at a time; their
+ * allocations go through opj_malloc with the context set by the
+ * locking thread (fz_malloc is protected by FZ_LOCK_ALLOC). */
+static int fz_jpx_num_threads = 0;
+
+void fz_set_jpx_decode_threads(fz_context *ctx, int num_threads)
+{
+	if (num_threads < 0)
+		num_threads = 0;
+	fz_jpx_num_threads = num_threads;
+}
+
 static void fz_opj_error_callback(const char *msg, void *client_data)
 {
 	fz_context *ctx = (fz_context *)client_data;
@@ -379,7 +393,7 @@ template_copy_comp(unsigned char *dst0, int w, int h, int stride, const OPJ_INT3
 }
 
 static void
-copy_jpx_to_pixmap(fz_context *ctx, fz_pixmap *img, opj_image_t *jpx)
+copy_jpx_to_pixmap(fz_context *ctx, fz_pixmap *img, opj_image_t *jpx, int reduce)
 {
 	unsigned char *dst;
 	int stride, comps;
@@ -398,8 +412,10 @@ copy_jpx_to_pixmap(fz_context *ctx, fz_pixmap *img, opj_image_t *jpx)
 		OPJ_UINT32 cdy = comp->dy;
 		OPJ_UINT32 cw = comp->w;
 		OPJ_UINT32 ch = comp->h;
-		int32_t oy = safe_mul32(ctx, comp->y0, cdy) - jpx->y0;
-		int32_t ox = safe_mul32(ctx, comp->x0, cdx) - jpx->x0;
+		/* comp->x0/y0 are in full reference grid units; a reduced
+		 * decode shrinks the grid (and comp->w/h) by 1<<reduce */
+		int32_t oy = (safe_mul32(ctx, comp->y0, cdy) - jpx->y0) >> reduce;
+		int32_t ox = (safe_mul32(ctx, comp->x0, cdx) - jpx->x0) >> reduce;
 		unsigned char *dst0 = dst + oy * stride;
 
 		if (comp->data == NULL)
@@ -418,7 +434,7 @@ copy_jpx_to_pixmap(fz_context *ctx, fz_pixmap *img, opj_image_t *jpx)
 }
 
 static fz_pixmap *
-jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_t size, fz_colorspace *defcs, int onlymeta)
+jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_t size, fz_colorspace *defcs, int onlymeta, int *l2factor)
 {
 	fz_pixmap *img = NULL;
 	opj_dparameters_t params;
@@ -428,6 +444,7 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 	OPJ_CODEC_FORMAT format;
 	int a, n, k;
 	int w, h;
+	int reduce = 0;
 	stream_block sb;
 	OPJ_UINT32 i;
 
@@ -456,6 +473,9 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 		fz_throw(ctx, FZ_ERROR_GENERIC, "j2k decode failed");
 	}
 
+	if (fz_jpx_num_threads > 1 && opj_has_thread_support())
+		opj_codec_set_threads(codec, fz_jpx_num_threads);
+
 	stream = opj_stream_default_create(OPJ_TRUE);
 	sb.data = data;
 	sb.pos = 0;
@@ -475,6 +495,28 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 		fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to read JPX header");
 	}
 
+	/* When the caller can accept a subsampled image, decode at the
+	 * closest native resolution level instead of decoding everything
+	 * and throwing most of it away in software. */
+	reduce = l2factor ? *l2factor : 0;
+	if (reduce > 0)
+	{
+		opj_codestream_info_v2_t *cinfo = opj_get_cstr_info(codec);
+		if (cinfo)
+		{
+			if (cinfo->m_default_tile_info.tccp_info)
+			{
+				int numres = (int)cinfo->m_default_tile_info.tccp_info[0].numresolutions;
+				if (reduce > numres - 1)
+					reduce = numres - 1;
+			}
+			opj_destroy_cstr_info(&cinfo);
+		}
+		if (reduce > 0 && !opj_set_decoded_resolution_factor(codec, (OPJ_UINT32)reduce))
+			reduce = 0;
+		*l2factor -= reduce;
+	}
+
 	if (!opj_decode(codec, stream, jpx))
 	{
 		opj_stream_destroy(stream);
@@ -509,8 +551,8 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 		}
 	}
 
-	w = state->width = jpx->x1 - jpx->x0;
-	h = state->height = jpx->y1 - jpx->y0;
+	w = jpx->x1 - jpx->x0;
+	h = jpx->y1 - jpx->y0;
 	state->xres = 72; /* openjpeg does not read the JPEG 2000 resc box */
 	state->yres = 72; /* openjpeg does not read the JPEG 2000 resc box */
 
@@ -520,6 +562,10 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 		fz_throw(ctx, FZ_ERROR_GENERIC, "Unbelievable size for jpx");
 	}
 
+	/* openjpeg ceil-divides the reference grid by 1<<reduce */
+	w = state->width = (w + (1 << reduce) - 1) >> reduce;
+	h = state->height = (h + (1 << reduce) - 1) >> reduce;
+
 	state->cs = NULL;
 
 	if (defcs)
@@ -581,7 +627,7 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 		a = !!a; /* ignore any superfluous alpha channels */
 		img = fz_new_pixmap(ctx, state->cs, w, h, NULL, a);
 		fz_clear_pixmap_with_value(ctx, img, 0);
-		copy_jpx_to_pixmap(ctx, img, jpx);
+		copy_jpx_to_pixmap(ctx, img, jpx, reduce);
 
 		if (jpx->color_space == OPJ_CLRSPC_SYCC && n == 3 && a == 0)
 			jpx_ycc_to_rgb(ctx, img, 1, 1);
@@ -604,6 +650,12 @@ jpx_read_image(fz_context *ctx, fz_jpxd *state, const unsigned char *data, size_
 
 fz_pixmap *
 fz_load_jpx(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspace *defcs)
+{
+	return fz_load_jpx_reduced(ctx, data, size, defcs, NULL);
+}
+
+fz_pixmap *
+fz_load_jpx_reduced(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspace *defcs, int *l2factor)
 {
 	fz_jpxd state = { 0 };
 	fz_pixmap *pix = NULL;
@@ -611,7 +663,7 @@ fz_load_jpx(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspa
 	fz_try(ctx)
 	{
 		opj_lock(ctx);
-		pix = jpx_read_image(ctx, &state, data, size, defcs, 0);
+		pix = jpx_read_image(ctx, &state, data, size, defcs, 0, l2factor);
 	}
 	fz_always(ctx)
 		opj_unlock(ctx);
@@ -629,7 +681,7 @@ fz_load_jpx_info(fz_context *ctx, const unsigned char *data, size_t size, int *w
 	fz_try(ctx)
 	{
 		opj_lock(ctx);
-		jpx_read_image(ctx, &state, data, size, NULL, 1);
+		jpx_read_image(ctx, &state, data, size, NULL, 1, NULL);
 	}
 	fz_always(ctx)
 		opj_unlock(ctx);
@@ -651,6 +703,17 @@ fz_load_jpx(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspa
 	fz_throw(ctx, FZ_ERROR_GENERIC, "JPX support disabled");
 }
 
+fz_pixmap *
+fz_load_jpx_reduced(fz_context *ctx, const unsigned char *data, size_t size, fz_colorspace *defcs, int *l2factor)
+{
+	fz_throw(ctx, FZ_ERROR_GENERIC, "JPX support disabled");
+}
+
+void
+fz_set_jpx_decode_threads(fz_context *ctx, int num_threads)
+{
+}
+
 void
 fz_load_jpx_info(fz_context *ctx, const unsigned char *data, size_t size, int *wp, int *hp, int *xresp, int *yresp, fz_colorspace **cspacep)
 {
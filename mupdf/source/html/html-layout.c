@@ -94,11 +94,138 @@ static void init_string_walker(fz_context *ctx, string_walker *walker, hb_buffer
 	walker->small_caps = small_caps;
 }
 
+/* Shaping is done in font units (we set the char size to units_per_EM
+ * below), so the result for a given run of text is identical at every
+ * zoom level. Layout and draw both re-walk the same flow nodes, so we
+ * cache shaped runs per font, hanging off the font's shaper data and
+ * protected by the hb lock like everything else harfbuzz touches.
+ */
+
+typedef struct shaped_run
+{
+	struct shaped_run *next;
+	int script;
+	int language;
+	int rtl;
+	int small_caps;
+	size_t len;
+	char *text;
+	unsigned int glyph_count;
+	hb_glyph_info_t *glyph_info;
+	hb_glyph_position_t *glyph_pos;
+} shaped_run;
+
+#define SHAPED_RUN_HASH_SIZE 256
+/* stop caching (rather than evicting) once a pathological font hits this */
+#define MAX_SHAPED_RUNS_PER_FONT 4096
+
+typedef struct
+{
+	hb_font_t *hb_font;
+	shaped_run *run_hash[SHAPED_RUN_HASH_SIZE];
+	int run_count;
+} shaper_cache;
+
+static unsigned int
+shaped_run_hash(const char *text, size_t len, int script, int language, int rtl, int small_caps)
+{
+	unsigned int h = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		h = (h ^ (unsigned char)text[i]) * 16777619u;
+	h = (h ^ (unsigned int)script) * 16777619u;
+	h = (h ^ (unsigned int)language) * 16777619u;
+	h = (h ^ (unsigned int)(rtl | (small_caps << 1))) * 16777619u;
+	return h;
+}
+
+static shaped_run *
+find_shaped_run(shaper_cache *cache, unsigned int hash, const char *text, size_t len, int script, int language, int rtl, int small_caps)
+{
+	shaped_run **head = &cache->run_hash[hash & (SHAPED_RUN_HASH_SIZE-1)];
+	shaped_run **prev = head;
+	shaped_run *run;
+
+	for (run = *prev; run; prev = &run->next, run = run->next)
+	{
+		if (run->len == len && run->script == script && run->language == language &&
+			run->rtl == rtl && run->small_caps == small_caps &&
+			!memcmp(run->text, text, len))
+		{
+			/* move to the front of the chain */
+			*prev = run->next;
+			run->next = *head;
+			*head = run;
+			return run;
+		}
+	}
+	return NULL;
+}
+
+static void
+store_shaped_run(fz_context *ctx, shaper_cache *cache, unsigned int hash, const char *text, size_t len, int script, int language, int rtl, int small_caps, unsigned int glyph_count, const hb_glyph_info_t *glyph_info, const hb_glyph_position_t *glyph_pos)
+{
+	shaped_run **head = &cache->run_hash[hash & (SHAPED_RUN_HASH_SIZE-1)];
+	shaped_run *run;
+
+	if (glyph_count == 0 || len == 0 || cache->run_count >= MAX_SHAPED_RUNS_PER_FONT)
+		return;
+
+	/* no-throw allocations: failing to cache is not an error */
+	run = fz_malloc_no_throw(ctx, sizeof(shaped_run));
+	if (run == NULL)
+		return;
+	memset(run, 0, sizeof(*run));
+	run->text = fz_malloc_no_throw(ctx, len);
+	run->glyph_info = fz_malloc_no_throw(ctx, glyph_count * sizeof(hb_glyph_info_t));
+	run->glyph_pos = fz_malloc_no_throw(ctx, glyph_count * sizeof(hb_glyph_position_t));
+	if (run->text == NULL || run->glyph_info == NULL || run->glyph_pos == NULL)
+	{
+		fz_free(ctx, run->text);
+		fz_free(ctx, run->glyph_info);
+		fz_free(ctx, run->glyph_pos);
+		fz_free(ctx, run);
+		return;
+	}
+
+	memcpy(run->text, text, len);
+	memcpy(run->glyph_info, glyph_info, glyph_count * sizeof(hb_glyph_info_t));
+	memcpy(run->glyph_pos, glyph_pos, glyph_count * sizeof(hb_glyph_position_t));
+	run->len = len;
+	run->script = script;
+	run->language = language;
+	run->rtl = rtl;
+	run->small_caps = small_caps;
+	run->glyph_count = glyph_count;
+
+	run->next = *head;
+	*head = run;
+	cache->run_count++;
+}
+
 static void
 destroy_hb_shaper_data(fz_context *ctx, void *handle)
 {
+	shaper_cache *cache = handle;
+	int i;
+
 	fz_hb_lock(ctx);
-	hb_font_destroy(handle);
+	for (i = 0; i < SHAPED_RUN_HASH_SIZE; i++)
+	{
+		shaped_run *run = cache->run_hash[i];
+		while (run)
+		{
+			shaped_run *next = run->next;
+			fz_free(ctx, run->text);
+			fz_free(ctx, run->glyph_info);
+			fz_free(ctx, run->glyph_pos);
+			fz_free(ctx, run);
+			run = next;
+		}
+	}
+	hb_font_destroy(cache->hb_font);
+	fz_free(ctx, cache);
 	fz_hb_unlock(ctx);
 }
 
@@ -164,26 +291,57 @@ static int walk_string(string_walker *walker)
 		}
 		/* hb_buffer_set_cluster_level(hb_buf, HB_BUFFER_CLUSTER_LEVEL_CHARACTERS); */
 
-		hb_buffer_add_utf8(walker->hb_buf, walker->start, walker->end - walker->start, 0, -1);
-
 		if (!quickshape)
 		{
 			fz_shaper_data_t *hb = fz_font_shaper_data(ctx, walker->font);
+			shaper_cache *cache;
+			shaped_run *run;
+			size_t len = walker->end - walker->start;
+			unsigned int hash;
+
 			Memento_startLeaking(); /* HarfBuzz leaks harmlessly */
 			if (hb->shaper_handle == NULL)
 			{
+				cache = fz_malloc_struct(ctx, shaper_cache);
+				cache->hb_font = hb_ft_font_create(face, NULL);
 				hb->destroy = destroy_hb_shaper_data;
-				hb->shaper_handle = hb_ft_font_create(face, NULL);
+				hb->shaper_handle = cache;
 			}
+			cache = hb->shaper_handle;
 
-			hb_buffer_guess_segment_properties(walker->hb_buf);
-
-			if (walker->small_caps)
-				hb_shape(hb->shaper_handle, walker->hb_buf, small_caps_feature, nelem(small_caps_feature));
+			hash = shaped_run_hash(walker->start, len, walker->script, walker->language, walker->rtl, walker->small_caps);
+			run = find_shaped_run(cache, hash, walker->start, len, walker->script, walker->language, walker->rtl, walker->small_caps);
+			if (run && !hb_buffer_set_length(walker->hb_buf, run->glyph_count))
+				run = NULL; /* OOM growing the buffer; just re-shape */
+			if (run)
+			{
+				unsigned int n;
+				memcpy(hb_buffer_get_glyph_infos(walker->hb_buf, &n), run->glyph_info, run->glyph_count * sizeof(hb_glyph_info_t));
+				memcpy(hb_buffer_get_glyph_positions(walker->hb_buf, &n), run->glyph_pos, run->glyph_count * sizeof(hb_glyph_position_t));
+				hb_buffer_set_content_type(walker->hb_buf, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+			}
 			else
-				hb_shape(hb->shaper_handle, walker->hb_buf, NULL, 0);
+			{
+				unsigned int n;
+				hb_glyph_info_t *info;
+				hb_glyph_position_t *pos;
+
+				hb_buffer_add_utf8(walker->hb_buf, walker->start, walker->end - walker->start, 0, -1);
+				hb_buffer_guess_segment_properties(walker->hb_buf);
+
+				if (walker->small_caps)
+					hb_shape(cache->hb_font, walker->hb_buf, small_caps_feature, nelem(small_caps_feature));
+				else
+					hb_shape(cache->hb_font, walker->hb_buf, NULL, 0);
+
+				info = hb_buffer_get_glyph_infos(walker->hb_buf, &n);
+				pos = hb_buffer_get_glyph_positions(walker->hb_buf, &n);
+				store_shaped_run(ctx, cache, hash, walker->start, len, walker->script, walker->language, walker->rtl, walker->small_caps, n, info, pos);
+			}
 			Memento_stopLeaking();
 		}
+		else
+			hb_buffer_add_utf8(walker->hb_buf, walker->start, walker->end - walker->start, 0, -1);
 
 		walker->glyph_pos = hb_buffer_get_glyph_positions(walker->hb_buf, &walker->glyph_count);
 		walker->glyph_info = hb_buffer_get_glyph_infos(walker->hb_buf, NULL);
@@ -60,17 +60,61 @@ pdf_stream_has_crypt(fz_context *ctx, pdf_obj *stm)
 	return 0;
 }
 
+/* Decoding a JBIG2 globals stream means re-running the shared symbol
+ * dictionary decode, which for scanned documents dwarfs the per-page
+ * work. The store caches the decoded result, but can evict it under
+ * memory pressure, so we additionally pin one reference per globals
+ * stream on the document itself (keyed by object number) until the
+ * document is dropped. */
+static fz_jbig2_globals *
+pdf_find_pinned_jbig2_globals(fz_context *ctx, pdf_document *doc, int num)
+{
+	int i;
+
+	if (doc == NULL || num == 0)
+		return NULL;
+	for (i = 0; i < doc->num_jbig2_globals; i++)
+		if (doc->jbig2_globals[i].num == num)
+			return fz_keep_jbig2_globals(ctx, doc->jbig2_globals[i].globals);
+	return NULL;
+}
+
+static void
+pdf_pin_jbig2_globals(fz_context *ctx, pdf_document *doc, int num, fz_jbig2_globals *globals)
+{
+	if (doc == NULL || num == 0)
+		return;
+
+	if (doc->num_jbig2_globals == doc->max_jbig2_globals)
+	{
+		int new_max = doc->max_jbig2_globals * 2;
+		if (new_max == 0)
+			new_max = 4;
+		doc->jbig2_globals = fz_realloc_array(ctx, doc->jbig2_globals, new_max, pdf_jbig2_globals_cache);
+		doc->max_jbig2_globals = new_max;
+	}
+
+	doc->jbig2_globals[doc->num_jbig2_globals].num = num;
+	doc->jbig2_globals[doc->num_jbig2_globals].globals = fz_keep_jbig2_globals(ctx, globals);
+	doc->num_jbig2_globals++;
+}
+
 static fz_jbig2_globals *
 pdf_load_jbig2_globals(fz_context *ctx, pdf_obj *dict)
 {
 	fz_jbig2_globals *globals;
 	fz_buffer *buf = NULL;
+	pdf_document *doc = pdf_get_bound_document(ctx, dict);
+	int num = pdf_to_num(ctx, dict);
 
 	fz_var(buf);
 
 	if ((globals = pdf_find_item(ctx, fz_drop_jbig2_globals_imp, dict)) != NULL)
 		return globals;
 
+	if ((globals = pdf_find_pinned_jbig2_globals(ctx, doc, num)) != NULL)
+		return globals;
+
 	if (pdf_mark_obj(ctx, dict))
 		fz_throw(ctx, FZ_ERROR_GENERIC, "cyclic reference when loading JBIG2 globals");
 
@@ -79,6 +123,7 @@ pdf_load_jbig2_globals(fz_context *ctx, pdf_obj *dict)
 		buf = pdf_load_stream(ctx, dict);
 		globals = fz_load_jbig2_globals(ctx, buf);
 		pdf_store_item(ctx, dict, globals, fz_buffer_storage(ctx, buf, NULL));
+		pdf_pin_jbig2_globals(ctx, doc, num, globals);
 	}
 	fz_always(ctx)
 	{
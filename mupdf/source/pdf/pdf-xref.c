@@ -1773,6 +1773,11 @@ pdf_drop_document_imp(fz_context *ctx, pdf_document *doc)
 
 	fz_free(ctx, doc->type3_fonts);
 
+	for (i=0; i < doc->num_jbig2_globals; i++)
+		fz_drop_jbig2_globals(ctx, doc->jbig2_globals[i].globals);
+
+	fz_free(ctx, doc->jbig2_globals);
+
 	pdf_drop_ocg(ctx, doc);
 
 	pdf_empty_store(ctx, doc);
@@ -407,11 +407,13 @@ function sumatrapdf_files()
     "ChmModel.*",
     "Commands.*",
     "CrashHandler.*",
+    "DibPool.*",
     "DisplayModel.*",
     "DisplayMode.*",
     "Doc.*",
     "EbookController.*",
     "EbookControls.*",
+    "EbookLayoutCache.*",
     "EditAnnotations.*",
     "ExternalViewers.*",
     "Favorites.*",
@@ -425,17 +427,22 @@ function sumatrapdf_files()
     "InstUninstCommon.cpp",
     "Uninstaller.cpp",
     "MemLeakDetect.*",
+    "MemoryPolicy.*",
     "Menu.*",
     "MuiEbookPageDef.*",
     "Notifications.*",
+    "OcrEngine.*",
+    "PageThumbnails.*",
     "PagesLayoutDef.*",
     "ParseBKM.*",
     "PdfSync.*",
     "Print.*",
     "ProgressUpdateUI.*",
+    "QuickOpen.*",
     "RenderCache.*",
     "resource.h",
     "SaveAsPdf.*",
+    "SearchAllTabs.*",
     "SearchAndDDE.*",
     "Selection.*",
     "SettingsStructs.*",
@@ -453,9 +460,11 @@ function sumatrapdf_files()
     "TableOfContents.*",
     "Tabs.*",
     "Tester.*",
+    "TextIndexCache.*",
     "TextSearch.*",
     "TextSelection.*",
     "Theme.*",
+    "TileDiskCache.*",
     "TocEditor.*",
     "TocEditTitle.*",
     "Toolbar.*",
@@ -500,6 +509,7 @@ function utils_files()
     "Dict.*",
     "DirIter.*",
     "Dpi.*",
+    "EtwTrace.*",
     "GeomUtil.*",
     "GuessFileType.*",
     "FileUtil.*",
@@ -511,10 +521,12 @@ function utils_files()
     "HtmlPullParser.*",
     "HtmlPrettyPrint.*",
     "HttpUtil.*",
+    "IdleTask.*",
     "JsonParser.*",
     "Log.*",
     "LogDbg.*",
     "LzmaSimpleArchive.*",
+    "MemAccounting.*",
     "MinHook.*",
     "PEB.h",
     "RegistryPaths.*",
@@ -908,6 +920,7 @@ function test_util_files()
     "StrUtil.*",
     "StrUtil_win.cpp",
     "SquareTreeParser.*",
+    "ThreadUtil.*",
     "TrivialHtmlParser.*",
     "UtAssert.*",
     --"VarintGob*",
@@ -953,6 +966,7 @@ function pdf_preview_files()
     "mui/TextRender.*",
     "MUPDF_Exports.cpp",
     "Annotation.*",
+    "DibPool.*",
     "EngineBase.*",
     "EngineFzUtil.*",
     "EnginePdf.*",
@@ -982,6 +996,7 @@ function pdf_filter_files()
     "utils/PalmDbReader.*",
     "MUPDF_Exports.cpp",
     "Annotation.*",
+    "DibPool.*",
     "EngineBase.*",
     "EngineFzUtil.*",
     "EnginePdf.*",
@@ -285,7 +285,9 @@ workspace "SumatraPDF"
     -- and we can't provide our own in a different directory because
     -- msvc will include the one in ext/openjpeg/src/lib/openjp2 first
     -- because #include "opj_config_private.h" searches current directory first
-    defines { "_CRT_SECURE_NO_WARNINGS", "USE_JPIP", "OPJ_STATIC", "OPJ_EXPORTS" }
+    -- MUTEX_win32 compiles thread.c with real thread support so that
+    -- opj_codec_set_threads() can parallelize tile decoding
+    defines { "_CRT_SECURE_NO_WARNINGS", "USE_JPIP", "OPJ_STATIC", "OPJ_EXPORTS", "MUTEX_win32" }
     openjpeg_files()
 
 
@@ -15,11 +15,13 @@ ACCEL gAccelerators[] = {
     {FCONTROL | FVIRTKEY, 'C', CmdCopySelection},
     {FCONTROL | FVIRTKEY, 'D', CmdProperties},
     {FCONTROL | FVIRTKEY, 'F', CmdFindFirst},
+    {FSHIFT | FCONTROL | FVIRTKEY, 'F', CmdSearchAllTabs},
     {FCONTROL | FVIRTKEY, 'G', CmdGoToPage},
     {FCONTROL | FVIRTKEY, 'L', CmdViewPresentationMode},
     {FSHIFT | FCONTROL | FVIRTKEY, 'L', CmdViewFullScreen},
     {FCONTROL | FVIRTKEY, 'N', CmdNewWindow},
     {FSHIFT | FCONTROL | FVIRTKEY, 'N', CmdDuplicateInNewWindow},
+    {FCONTROL | FVIRTKEY, 'K', CmdQuickOpen},
     {FCONTROL | FVIRTKEY, 'O', CmdOpen},
     {FCONTROL | FVIRTKEY, 'S', CmdSaveAs},
     {FSHIFT | FCONTROL | FVIRTKEY, 'S', CmdSaveAsBookmark},
@@ -320,9 +320,8 @@ COLORREF Annotation::Color() {
     return res;
 }
 
-// return true if color changed
-bool Annotation::SetColor(COLORREF c) {
-    ScopedCritSec cs(pdf->ctxAccess);
+// caller must hold ctxAccess; returns true if the color changed
+static bool SetColorLocked(AnnotationPdf* pdf, COLORREF c) {
     bool didChange = false;
     float color[4];
     int n;
@@ -343,6 +342,13 @@ bool Annotation::SetColor(COLORREF c) {
         pdf_set_annot_color(pdf->ctx, pdf->annot, newN, newColor);
     }
     pdf_update_appearance(pdf->ctx, pdf->annot);
+    return didChange;
+}
+
+// return true if color changed
+bool Annotation::SetColor(COLORREF c) {
+    ScopedCritSec cs(pdf->ctxAccess);
+    bool didChange = SetColorLocked(pdf, c);
     if (didChange) {
         isChanged = true;
     }
@@ -517,6 +523,64 @@ Annotation* MakeAnnotationPdf(CRITICAL_SECTION* ctxAccess, fz_context* ctx, pdf_
     return res;
 }
 
+/* Bulk mutations. Changing annotations one by one takes and releases the
+   document lock for every annotation and callers tend to re-render the
+   page after each change, which makes "delete all highlights" on a
+   heavily reviewed document cost hundreds of render passes. The
+   functions below apply all changes under one lock as a single pdf
+   document operation (a no-op unless journalling is enabled, but it
+   keeps undo at the granularity of the user action); callers use
+   PagesWithAnnotations() to invalidate each affected page exactly once
+   afterwards. All annotations must belong to the same document. */
+
+Vec<int> PagesWithAnnotations(Vec<Annotation*>& annots) {
+    Vec<int> pages;
+    for (auto& annot : annots) {
+        int pageNo = annot->PageNo();
+        if (!pages.Contains(pageNo)) {
+            pages.Append(pageNo);
+        }
+    }
+    return pages;
+}
+
+void DeleteAnnotationsBulk(Vec<Annotation*>& annots) {
+    if (annots.size() == 0) {
+        return;
+    }
+    AnnotationPdf* first = annots.at(0)->pdf;
+    ScopedCritSec cs(first->ctxAccess);
+    pdf_begin_operation(first->ctx, first->page->doc, "delete annotations");
+    for (auto& annot : annots) {
+        CrashIf(annot->isDeleted);
+        CrashIf(annot->pdf->ctxAccess != first->ctxAccess);
+        pdf_delete_annot(annot->pdf->ctx, annot->pdf->page, annot->pdf->annot);
+        annot->isDeleted = true;
+        annot->isChanged = true;
+    }
+    pdf_end_operation(first->ctx, first->page->doc);
+}
+
+// returns the number of annotations whose color did change
+int SetColorBulk(Vec<Annotation*>& annots, COLORREF col) {
+    if (annots.size() == 0) {
+        return 0;
+    }
+    AnnotationPdf* first = annots.at(0)->pdf;
+    ScopedCritSec cs(first->ctxAccess);
+    int nChanged = 0;
+    pdf_begin_operation(first->ctx, first->page->doc, "set annotations color");
+    for (auto& annot : annots) {
+        CrashIf(annot->pdf->ctxAccess != first->ctxAccess);
+        if (SetColorLocked(annot->pdf, col)) {
+            annot->isChanged = true;
+            nChanged++;
+        }
+    }
+    pdf_end_operation(first->ctx, first->page->doc);
+    return nChanged;
+}
+
 Vec<Annotation*> FilterAnnotationsForPage(Vec<Annotation*>* annots, int pageNo) {
     Vec<Annotation*> result;
     if (!annots) {
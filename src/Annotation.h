@@ -115,3 +115,11 @@ bool IsAnnotationEq(Annotation* a1, Annotation* a2);
 
 void DeleteVecAnnotations(Vec<Annotation*>* annots);
 Vec<Annotation*> FilterAnnotationsForPage(Vec<Annotation*>* annots, int pageNo);
+
+// bulk mutations: apply a change to all annotations as a single pdf
+// document operation under one document lock (see Annotation.cpp)
+void DeleteAnnotationsBulk(Vec<Annotation*>& annots);
+int SetColorBulk(Vec<Annotation*>& annots, COLORREF col);
+// distinct pages the annotations are on, for invalidating each affected
+// page exactly once after a bulk mutation
+Vec<int> PagesWithAnnotations(Vec<Annotation*>& annots);
@@ -4,6 +4,7 @@
 #include "utils/BaseUtil.h"
 #include "utils/FileUtil.h"
 #include "utils/FileWatcher.h"
+#include "utils/ThreadUtil.h"
 #include "utils/UITask.h"
 #include "utils/ScopedWin.h"
 
@@ -37,6 +38,14 @@ extern void RememberDefaultWindowPosition(WindowInfo* win);
 
 static WatchedFile* gWatchedSettingsFile = nullptr;
 
+// the settings text as last read from or written to disk; the base for
+// preserving unknown settings on save and for detecting no-op saves
+// without re-reading the file (which got slow with a big file history)
+static char* gLastSavedPrefs = nullptr;
+
+// pending background write of the settings file (see Save)
+static TaskHandle* gPrefsWriteTask = nullptr;
+
 // number of weeks past since 2011-01-01
 static int GetWeekCount() {
     SYSTEMTIME date20110101 = {0};
@@ -79,6 +88,8 @@ bool Load() {
     CrashAlwaysIf(!gGlobalPrefs);
     auto* gprefs = gGlobalPrefs;
 
+    str::ReplacePtr(&gLastSavedPrefs, prefsData.data);
+
     // in pre-release builds between 3.1.10079 and 3.1.10377,
     // RestoreSession was a string with the additional option "auto"
     // TODO: remove this after 3.2 has been released
@@ -128,6 +139,8 @@ bool Load() {
 
     // TODO: verify that all states have a non-nullptr file path?
     gFileHistory.UpdateStatesSource(gprefs->fileStates);
+    // the cached DisplayState pointers point into the old file states
+    gFavorites.InvalidateCache();
     SetDefaultEbookFont(gprefs->ebookUI.fontName, gprefs->ebookUI.fontSize);
 
     if (!file::Exists(path.Get())) {
@@ -211,31 +224,83 @@ bool Save() {
     if (!path.data) {
         return false;
     }
-    std::span<u8> prevPrefs = file::ReadFile(path.data);
-    const char* prevPrefsData = (char*)prevPrefs.data();
-    std::span<u8> prefs = SerializeGlobalPrefs(gGlobalPrefs, prevPrefsData);
-    defer {
-        str::Free(prevPrefs.data());
-        str::Free(prefs.data());
-    };
+    std::span<u8> prefs = SerializeGlobalPrefs(gGlobalPrefs, gLastSavedPrefs);
     CrashIf(prefs.empty());
     if (prefs.empty()) {
         return false;
     }
 
     // only save if anything's changed at all
-    if (prevPrefs.size() == prefs.size() && str::Eq(prefs, prevPrefs)) {
+    size_t prefsSize = prefs.size();
+    if (gLastSavedPrefs && str::Len(gLastSavedPrefs) == prefsSize && str::Eq((char*)prefs.data(), gLastSavedPrefs)) {
+        str::Free(prefs.data());
         return true;
     }
 
-    bool ok = file::WriteFile(path.Get(), prefs);
-    if (!ok) {
-        return false;
+    free(gLastSavedPrefs);
+    gLastSavedPrefs = (char*)prefs.data();
+
+    // write the file on a background thread: with a big file history
+    // serializing is fast but the synchronous write used to stutter the UI
+    // (e.g. when closing a tab)
+    if (gPrefsWriteTask) {
+        // let the previous write finish so that writes stay ordered
+        gPrefsWriteTask->Wait();
+        DropTaskHandle(gPrefsWriteTask);
+        gPrefsWriteTask = nullptr;
     }
-    gGlobalPrefs->lastPrefUpdate = file::GetModificationTime(path.Get());
+    WCHAR* pathCopy = str::Dup(path.Get());
+    char* data = str::Dup(gLastSavedPrefs);
+    auto fn = [pathCopy, data, prefsSize] {
+        bool ok = file::WriteFile(pathCopy, {(u8*)data, prefsSize});
+        if (ok) {
+            FILETIME time = file::GetModificationTime(pathCopy);
+            // lastPrefUpdate keeps the file watcher from reloading our own
+            // write; it's only read on the UI thread, so update it there
+            uitask::Post([time] {
+                if (gGlobalPrefs) {
+                    gGlobalPrefs->lastPrefUpdate = time;
+                }
+            });
+        }
+        str::Free(data);
+        str::Free(pathCopy);
+    };
+    gPrefsWriteTask = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
     return true;
 }
 
+// how long a burst of state changes is coalesced into a single save
+#define PREFS_SAVE_DELAY_IN_MS 1000
+
+static LONG gSaveScheduled = 0;
+
+// debounced Save() for interactive paths (closing a tab, toggling a
+// favorite etc.): a burst of state changes results in a single save a
+// moment later instead of re-serializing the settings for each one.
+// Shutdown paths must keep calling Save() directly as a scheduled save
+// might not come around anymore
+void ScheduleSave() {
+    if (!HasPermission(Perm_SavePreferences)) {
+        return;
+    }
+    if (0 != InterlockedCompareExchange(&gSaveScheduled, 1, 0)) {
+        // an already scheduled save will pick up this change as well
+        return;
+    }
+    auto fn = [] {
+        Sleep(PREFS_SAVE_DELAY_IN_MS);
+        // the prefs structures are only safe to touch on the UI thread
+        uitask::Post([] {
+            InterlockedExchange(&gSaveScheduled, 0);
+            if (gGlobalPrefs) {
+                Save();
+            }
+        });
+    };
+    DropTaskHandle(GetThreadPool()->Submit(fn, TaskPriority::Background));
+}
+
 // refresh the preferences when a different SumatraPDF process saves them
 // or if they are edited by the user using a text editor
 bool Reload() {
@@ -301,6 +366,13 @@ bool Reload() {
 }
 
 void CleanUp() {
+    if (gPrefsWriteTask) {
+        // make sure the last snapshot reaches the disk
+        gPrefsWriteTask->Wait();
+        DropTaskHandle(gPrefsWriteTask);
+        gPrefsWriteTask = nullptr;
+    }
+    str::ReplacePtr(&gLastSavedPrefs, nullptr);
     DeleteGlobalPrefs(gGlobalPrefs);
     gGlobalPrefs = nullptr;
 }
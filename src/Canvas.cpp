@@ -5,8 +5,11 @@
 #include "utils/WinDynCalls.h"
 #include "utils/Dpi.h"
 #include "utils/FileUtil.h"
+#include "utils/FrameTimeoutCalculator.h"
 #include "utils/LogDbg.h"
+#include "utils/ThreadUtil.h"
 #include "utils/Timer.h"
+#include "utils/IdleTask.h"
 #include "utils/UITask.h"
 #include "utils/WinUtil.h"
 #include "AppColors.h"
@@ -77,6 +80,145 @@ void UpdateDeltaPerLine() {
 
 ///// methods needed for FixedPageUI canvases with document loaded /////
 
+/* Hover preview over the vertical scrollbar: a small popup showing the page
+   that the hovered track position corresponds to, so that scrubbing through
+   a long document isn't blind while renders catch up. It's drawn purely from
+   bitmaps already in RenderCache and never requests a render; pages that
+   haven't been rendered yet only show the page label. */
+
+#define SCROLL_PREVIEW_CLASS_NAME L"SUMATRA_PDF_SCROLL_PREVIEW"
+
+// a single popup is shared by all windows: there's only one cursor
+static HWND gScrollPreviewWnd = nullptr;
+static WindowInfo* gScrollPreviewWin = nullptr;
+static int gScrollPreviewPage = 0;
+
+static void PaintScrollPreview(HWND hwnd) {
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hwnd, &ps);
+    Rect rc = ClientRect(hwnd);
+    FillRect(hdc, &ps.rcPaint, GetStockBrush(WHITE_BRUSH));
+
+    WindowInfo* win = gScrollPreviewWin;
+    DisplayModel* dm = win ? win->AsFixed() : nullptr;
+    int pageNo = gScrollPreviewPage;
+    if (dm && win->ctrl->ValidPageNo(pageNo)) {
+        int labelDy = DpiScale(hwnd, 16);
+        Rect page(1, 1, rc.dx - 2, rc.dy - labelDy - 2);
+        // cache-only: a page that was never rendered stays blank
+        gRenderCache.PaintCachedPreview(hdc, page, dm, pageNo);
+
+        AutoFreeWstr label(win->ctrl->GetPageLabel(pageNo));
+        RECT rcLabel{0, rc.dy - labelDy, rc.dx, rc.dy};
+        HFONT prevFont = (HFONT)SelectObject(hdc, GetDefaultGuiFont());
+        SetBkMode(hdc, TRANSPARENT);
+        DrawTextW(hdc, label, -1, &rcLabel, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+        SelectObject(hdc, prevFont);
+    }
+    EndPaint(hwnd, &ps);
+}
+
+static LRESULT CALLBACK WndProcScrollPreview(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
+    if (WM_PAINT == msg) {
+        PaintScrollPreview(hwnd);
+        return 0;
+    }
+    return DefWindowProc(hwnd, msg, wp, lp);
+}
+
+// hides the popup; with a non-null win only if it's showing for that window
+static void HideScrollPreview(WindowInfo* win = nullptr) {
+    if (win && win != gScrollPreviewWin) {
+        return;
+    }
+    if (gScrollPreviewWnd) {
+        ShowWindow(gScrollPreviewWnd, SW_HIDE);
+    }
+    gScrollPreviewWin = nullptr;
+    gScrollPreviewPage = 0;
+}
+
+// yScreen is the cursor position in screen coordinates
+static void UpdateScrollPreview(WindowInfo* win, int yScreen) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm || win->ctrl->PageCount() < 2 || !dm->NeedVScroll()) {
+        HideScrollPreview();
+        return;
+    }
+
+    Rect rcCanvas = WindowRect(win->hwndCanvas);
+    int arrowDy = GetSystemMetrics(SM_CYVSCROLL);
+    int trackTop = rcCanvas.y + arrowDy;
+    int trackDy = rcCanvas.dy - 2 * arrowDy;
+    if (dm->IsHScrollbarVisible()) {
+        trackDy -= GetSystemMetrics(SM_CYHSCROLL);
+    }
+    if (trackDy <= 0) {
+        HideScrollPreview();
+        return;
+    }
+    float frac = limitValue((yScreen - trackTop) / (float)trackDy, 0.f, 1.f);
+
+    // the page whose layout position the hovered track position scrolls to
+    int maxScrollY = std::max(dm->GetCanvasSize().dy - dm->GetViewPort().dy, 0);
+    int targetY = (int)(frac * (float)maxScrollY) + dm->GetViewPort().dy / 2;
+    int pageCount = win->ctrl->PageCount();
+    int pageNo = 1;
+    for (int i = 1; i <= pageCount; i++) {
+        PageInfo* pageInfo = dm->GetPageInfo(i);
+        if (!pageInfo || !pageInfo->shown) {
+            continue;
+        }
+        pageNo = i;
+        if (pageInfo->pos.y + pageInfo->pos.dy >= targetY) {
+            break;
+        }
+    }
+
+    if (!gScrollPreviewWnd) {
+        WNDCLASSEX wcex = {0};
+        wcex.cbSize = sizeof(wcex);
+        wcex.lpfnWndProc = WndProcScrollPreview;
+        wcex.hInstance = GetModuleHandle(nullptr);
+        wcex.hCursor = LoadCursor(nullptr, IDC_ARROW);
+        wcex.lpszClassName = SCROLL_PREVIEW_CLASS_NAME;
+        RegisterClassEx(&wcex);
+        DWORD exStyle = WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE;
+        gScrollPreviewWnd = CreateWindowExW(exStyle, SCROLL_PREVIEW_CLASS_NAME, nullptr, WS_POPUP | WS_BORDER, 0, 0,
+                                            0, 0, nullptr, nullptr, GetModuleHandle(nullptr), nullptr);
+        if (!gScrollPreviewWnd) {
+            return;
+        }
+    }
+
+    // size the popup to the page's aspect ratio, plus a label strip
+    PageInfo* pageInfo = dm->GetPageInfo(pageNo);
+    int maxDim = DpiScale(win->hwndCanvas, 160);
+    int labelDy = DpiScale(win->hwndCanvas, 16);
+    int dx = maxDim;
+    int dy = maxDim;
+    if (pageInfo && pageInfo->pos.dx > 0 && pageInfo->pos.dy > 0) {
+        if (pageInfo->pos.dx >= pageInfo->pos.dy) {
+            dy = maxDim * pageInfo->pos.dy / pageInfo->pos.dx;
+        } else {
+            dx = maxDim * pageInfo->pos.dx / pageInfo->pos.dy;
+        }
+    }
+    dy += labelDy;
+
+    int x = rcCanvas.x + rcCanvas.dx - GetSystemMetrics(SM_CXVSCROLL) - dx - DpiScale(win->hwndCanvas, 8);
+    int y = limitValue(yScreen - dy / 2, rcCanvas.y, rcCanvas.y + rcCanvas.dy - dy);
+
+    bool pageChanged = win != gScrollPreviewWin || pageNo != gScrollPreviewPage;
+    gScrollPreviewWin = win;
+    gScrollPreviewPage = pageNo;
+    SetWindowPos(gScrollPreviewWnd, HWND_TOPMOST, x, y, dx, dy, SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    if (pageChanged) {
+        InvalidateRect(gScrollPreviewWnd, nullptr, TRUE);
+        UpdateWindow(gScrollPreviewWnd);
+    }
+}
+
 static void OnVScroll(WindowInfo* win, WPARAM wp) {
     CrashIf(!win->AsFixed());
 
@@ -135,6 +277,16 @@ static void OnVScroll(WindowInfo* win, WPARAM wp) {
     if (si.nPos != currPos || msg == SB_THUMBTRACK) {
         win->AsFixed()->ScrollYTo(si.nPos);
     }
+
+    // while the thumb is being dragged, show the page preview at the cursor
+    if (SB_THUMBTRACK == msg) {
+        POINT pt;
+        if (GetCursorPos(&pt)) {
+            UpdateScrollPreview(win, pt.y);
+        }
+    } else if (SB_ENDSCROLL == msg) {
+        HideScrollPreview(win);
+    }
 }
 
 static void OnHScroll(WindowInfo* win, WPARAM wp) {
@@ -272,7 +424,6 @@ void CancelDrag(WindowInfo* win) {
     auto [x, y] = pt;
     StopMouseDrag(win, x, y, true);
     win->mouseAction = MouseAction::Idle;
-    delete win->linkOnLastButtonDown;
     win->linkOnLastButtonDown = nullptr;
     SetCursorCached(IDC_ARROW);
 }
@@ -292,6 +443,40 @@ bool IsDrag(int x1, int x2, int y1, int y2) {
     return false;
 }
 
+// bounding box of everything PaintSelection draws for the selection in
+// progress, in client coordinates; empty if nothing of it is on screen.
+// the 2px inflation covers the outline PaintTransparentRectangles adds
+static Rect SelectionScreenRect(WindowInfo* win) {
+    if (MouseAction::Selecting == win->mouseAction) {
+        Rect r = win->selectionRect;
+        if (r.dx < 0) {
+            r.x += r.dx;
+            r.dx *= -1;
+        }
+        if (r.dy < 0) {
+            r.y += r.dy;
+            r.dy *= -1;
+        }
+        r.Inflate(2, 2);
+        return r;
+    }
+
+    // during text selection: the highlighted glyph rectangles
+    Rect r;
+    Vec<SelectionOnPage>* s = win->currentTab->selectionOnPage;
+    if (!s) {
+        return r;
+    }
+    DisplayModel* dm = win->AsFixed();
+    for (SelectionOnPage& sel : *s) {
+        r = r.Union(sel.GetRect(dm));
+    }
+    if (!r.IsEmpty()) {
+        r.Inflate(2, 2);
+    }
+    return r;
+}
+
 static void OnMouseMove(WindowInfo* win, int x, int y, [[maybe_unused]] WPARAM flags) {
     CrashIf(!win->AsFixed());
 
@@ -316,7 +501,6 @@ static void OnMouseMove(WindowInfo* win, int x, int y, [[maybe_unused]] WPARAM f
             return;
         }
         win->dragStartPending = false;
-        delete win->linkOnLastButtonDown;
         win->linkOnLastButtonDown = nullptr;
     }
 
@@ -333,12 +517,21 @@ static void OnMouseMove(WindowInfo* win, int x, int y, [[maybe_unused]] WPARAM f
                 SetCursorCached(IDC_IBEAM);
             }
         /* fall through */
-        case MouseAction::Selecting:
+        case MouseAction::Selecting: {
+            Rect dirty = SelectionScreenRect(win);
             win->selectionRect.dx = x - win->selectionRect.x;
             win->selectionRect.dy = y - win->selectionRect.y;
+            if (MouseAction::SelectingText == win->mouseAction) {
+                // recompute the selection now, so that the dirty rect
+                // below covers the new highlight (PaintSelection would
+                // otherwise only do it during the paint itself)
+                UpdateTextSelection(win);
+            }
             OnSelectionEdgeAutoscroll(win, x, y);
-            RepaintAsync(win, 0);
+            dirty = dirty.Union(SelectionScreenRect(win));
+            RepaintAsync(win, 0, dirty);
             break;
+        }
         case MouseAction::Dragging:
             if (annot) {
                 Size size = win->annotationBeingMovedSize;
@@ -401,6 +594,16 @@ static void SetObjectUnderMouse(WindowInfo* win, int x, int y) {
     Point pt{x, y};
 
     Annotation* annot = dm->GetAnnotationAtPos(pt, moveableAnnotations);
+    if (annot && dm->GetEngine()->refs > 1) {
+        // dragging would move the annotation in a document shared with
+        // other views; switch to a private copy first and re-resolve the
+        // annotation against it (the copy has its own object identities)
+        delete annot;
+        annot = nullptr;
+        if (EnsureExclusiveEngine(win->currentTab)) {
+            annot = dm->GetAnnotationAtPos(pt, moveableAnnotations);
+        }
+    }
     if (annot) {
         win->annotationOnLastButtonDown = annot;
         CreateMovePatternLazy(win);
@@ -415,12 +618,8 @@ static void SetObjectUnderMouse(WindowInfo* win, int x, int y) {
     }
 
     IPageElement* pageEl = dm->GetElementAtPos(pt);
-    if (pageEl) {
-        if (pageEl->Is(kindPageElementDest)) {
-            win->linkOnLastButtonDown = pageEl;
-        } else {
-            delete pageEl;
-        }
+    if (pageEl && pageEl->Is(kindPageElementDest)) {
+        win->linkOnLastButtonDown = pageEl;
     }
 }
 
@@ -492,9 +691,6 @@ static void OnMouseLeftButtonUp(WindowInfo* win, int x, int y, WPARAM key) {
     // TODO: win->linkHandler->GotoLink might spin the event loop
     IPageElement* link = win->linkOnLastButtonDown;
     win->linkOnLastButtonDown = nullptr;
-    defer {
-        delete link;
-    };
 
     TabInfo* tab = win->currentTab;
     if (didDragMouse) {
@@ -532,8 +728,9 @@ static void OnMouseLeftButtonUp(WindowInfo* win, int x, int y, WPARAM key) {
 
     if (win->fwdSearchMark.show && gGlobalPrefs->forwardSearch.highlightPermanent) {
         /* if there's a permanent forward search mark, hide it */
+        Rect dirty = ForwardSearchMarkScreenRect(win);
         win->fwdSearchMark.show = false;
-        RepaintAsync(win, 0);
+        RepaintAsync(win, 0, dirty);
         return;
     }
 
@@ -590,7 +787,6 @@ static void OnMouseLeftButtonDblClk(WindowInfo* win, int x, int y, WPARAM key) {
         win->showSelection = win->currentTab->selectionOnPage != nullptr;
         RepaintAsync(win, 0);
     }
-    delete pageEl;
 }
 
 static void OnMouseMiddleButtonDown(WindowInfo* win, int x, int y, [[maybe_unused]] WPARAM key) {
@@ -749,8 +945,6 @@ static void DebugShowLinks(DisplayModel* dm, HDC hdc) {
                 PaintRect(hdc, isect);
             }
         }
-        DeleteVecMembers(*els);
-        delete els;
     }
 
     DeletePen(SelectObject(hdc, oldPen));
@@ -794,6 +988,40 @@ static void DrawDocument(WindowInfo* win, HDC hdc, RECT* rcArea) {
     }
     DisplayModel* dm = win->AsFixed();
 
+    // a tab that was just re-activated may not have its visible pages in
+    // RenderCache anymore; blit the composite captured when the tab was
+    // deactivated (see CaptureCanvasSnapshot) instead of flashing a blank
+    // canvas until the renders arrive
+    TabInfo* tab = win->currentTab;
+    if (tab && tab->canvasSnapshot) {
+        bool sizeMatches = tab->canvasSnapshotSize == dm->GetViewPort().Size();
+        bool allRendered = true;
+        for (int pageNo = 1; sizeMatches && pageNo <= dm->PageCount(); ++pageNo) {
+            PageInfo* pageInfo = dm->GetPageInfo(pageNo);
+            if (!pageInfo || 0.0f == pageInfo->visibleRatio) {
+                continue;
+            }
+            if (!gRenderCache.Exists(dm, pageNo, dm->GetRotation(), dm->GetZoomReal(pageNo))) {
+                allRendered = false;
+                break;
+            }
+        }
+        if (sizeMatches && !allRendered) {
+            HDC bmpDC = CreateCompatibleDC(hdc);
+            if (bmpDC) {
+                HGDIOBJ prevBmp = SelectObject(bmpDC, tab->canvasSnapshot);
+                BitBlt(hdc, 0, 0, tab->canvasSnapshotSize.dx, tab->canvasSnapshotSize.dy, bmpDC, 0, 0, SRCCOPY);
+                SelectObject(bmpDC, prevBmp);
+                DeleteDC(bmpDC);
+                // RenderCache requests a repaint when the renders finish
+                return;
+            }
+        }
+        // fresh renders are available (or the canvas was resized)
+        DeleteObject(tab->canvasSnapshot);
+        tab->canvasSnapshot = nullptr;
+    }
+
     bool isImage = dm->GetEngine()->IsImageCollection();
     // draw comic books and single images on a black background
     // (without frame and shadow)
@@ -929,6 +1157,10 @@ static void DrawDocument(WindowInfo* win, HDC hdc, RECT* rcArea) {
         DeleteDC(bmpDC);
     }
 
+    // paint all the search matches first so that the current match
+    // (part of the selection) is drawn on top of its own highlight
+    PaintSearchMatches(win, hdc);
+
     if (win->showSelection) {
         PaintSelection(win, hdc);
     }
@@ -942,6 +1174,52 @@ static void DrawDocument(WindowInfo* win, HDC hdc, RECT* rcArea) {
     }
 }
 
+// a scroll-only repaint doesn't change what's drawn, just where on the canvas:
+// shift the pixels already in the buffer by the scroll delta with one blit and
+// re-draw only the strips that scrolled into view, instead of re-blitting
+// every visible tile (at 4K the latter is what makes scrolling CPU-bound)
+static bool DrawScrolledDocument(WindowInfo* win, RECT* rcArea) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm || dm != win->lastPaintDm || win->buffer != win->lastPaintBuffer ||
+        dm->repaintRev != win->lastPaintRepaintRev) {
+        return false;
+    }
+    if (win->mouseAction == MouseAction::Selecting || win->mouseAction == MouseAction::SelectingText) {
+        // the shifted pixels would show the selection's previous state
+        // (dragging and auto-scrolling are pure scrolls and stay eligible)
+        return false;
+    }
+    if (gGlobalPrefs->fixedPageUI.gradientColors->size() > 0) {
+        // the background gradient depends on the scroll position
+        return false;
+    }
+    Rect client = ClientRect(win->hwndCanvas);
+    if (Rect::FromRECT(*rcArea) != client) {
+        // a partial repaint can't have come from scrolling alone
+        return false;
+    }
+    Point pos = dm->GetViewPort().TL();
+    int dx = win->lastPaintScrollPos.x - pos.x;
+    int dy = win->lastPaintScrollPos.y - pos.y;
+    if ((0 == dx && 0 == dy) || abs(dx) >= client.dx || abs(dy) >= client.dy) {
+        return false;
+    }
+
+    HDC hdc = win->buffer->GetDC();
+    // BitBlt handles the overlapping source and destination
+    BitBlt(hdc, std::max(dx, 0), std::max(dy, 0), client.dx - abs(dx), client.dy - abs(dy), hdc, std::max(-dx, 0),
+           std::max(-dy, 0), SRCCOPY);
+    if (dy != 0) {
+        RECT strip = ToRECT(Rect(0, dy > 0 ? 0 : client.dy + dy, client.dx, abs(dy)));
+        DrawDocument(win, hdc, &strip);
+    }
+    if (dx != 0) {
+        RECT strip = ToRECT(Rect(dx > 0 ? 0 : client.dx + dx, 0, abs(dx), client.dy));
+        DrawDocument(win, hdc, &strip);
+    }
+    return true;
+}
+
 static void OnPaintDocument(WindowInfo* win) {
     auto t = TimeGet();
     PAINTSTRUCT ps;
@@ -955,13 +1233,33 @@ static void OnPaintDocument(WindowInfo* win) {
             FillRect(hdc, &ps.rcPaint, GetStockBrush(WHITE_BRUSH));
             break;
         default:
-            DrawDocument(win, win->buffer->GetDC(), &ps.rcPaint);
+            if (!DrawScrolledDocument(win, &ps.rcPaint)) {
+                DrawDocument(win, win->buffer->GetDC(), &ps.rcPaint);
+            }
             win->buffer->Flush(hdc);
+            win->lastPaintBuffer = win->buffer;
+            win->lastPaintDm = win->AsFixed();
+            if (win->lastPaintDm) {
+                win->lastPaintScrollPos = win->lastPaintDm->GetViewPort().TL();
+                win->lastPaintRepaintRev = win->lastPaintDm->repaintRev;
+            }
     }
 
     EndPaint(win->hwndCanvas, &ps);
     if (gShowFrameRate) {
         win->frameRateWnd->ShowFrameRateDur(TimeSinceInMs(t));
+        // "pwr" confirms that background work is being throttled for the
+        // battery's sake (idle CPU should be near zero then)
+        AutoFreeWstr perfInfo(str::Format(L"q %d  r %d ms%s", gRenderCache.requestCount, gRenderCache.lastRenderDurMs,
+                                          IsPowerSavingActive() ? L"  pwr" : L""));
+        // the most recent idle-task increment, to spot tasks that
+        // overstay their time budget
+        if (idletask::LastRunTaskName()) {
+            AutoFreeWstr idleName(strconv::Utf8ToWstr(idletask::LastRunTaskName()));
+            perfInfo.Set(str::Format(L"%s  i %s %d ms", perfInfo.Get(), idleName.Get(),
+                                     (int)idletask::LastRunTaskMs()));
+        }
+        win->frameRateWnd->ShowPerfInfo(perfInfo);
     }
 }
 
@@ -998,7 +1296,6 @@ static LRESULT OnSetCursorMouseIdle(WindowInfo* win, HWND hwnd) {
     win->ShowToolTip(text, rc, true);
 
     bool isLink = pageEl->Is(kindPageElementDest);
-    delete pageEl;
 
     if (isLink) {
         SetCursorCached(IDC_HAND);
@@ -1032,6 +1329,151 @@ static LRESULT OnSetCursor(WindowInfo* win, HWND hwnd) {
     return win->presentation ? TRUE : FALSE;
 }
 
+/* Arms a per-frame animation timer. While power saving is active the
+   timer gets a coalescing tolerance so that Windows can batch the wakeup
+   with other timers: a frame arriving a few ms late is invisible, an
+   extra CPU wakeup costs battery. */
+static void SetAnimationTimer(HWND hwnd, UINT_PTR timerId, UINT delayInMs) {
+    if (IsPowerSavingActive()) {
+        SetCoalescableTimer(hwnd, timerId, delayInMs, nullptr, std::max(delayInMs / 2, (UINT)10));
+        return;
+    }
+    SetTimer(hwnd, timerId, delayInMs, nullptr);
+}
+
+/* Animate a zoom change instead of snapping to the new level: advance the
+   zoom geometrically over ZOOM_ANIM_DURATION_IN_MS towards the target.
+   The intermediate levels have no rendered bitmaps yet, so painting them
+   scales the nearest cached zoom level of each tile on the fly (see
+   RenderCache::FindNearestZoom); the exact rendering of the target level
+   proceeds in the background and replaces the scaled preview when done. */
+static void StartZoomAnimation(WindowInfo* win, float zoomTarget, Point fixPt) {
+    DisplayModel* dm = win->AsFixed();
+    CrashIf(!dm);
+    float zoomStart = dm->GetZoomVirtual(true);
+    // virtual zoom levels (fit page/width/content) also change the scroll
+    // position, animating towards them does more harm than good; snap for
+    // them and whenever there's nothing to animate
+    if (zoomTarget <= 0 || zoomStart <= 0 || zoomStart == zoomTarget || win->presentation) {
+        win->zoomAnimTarget = 0;
+        KillTimer(win->hwndCanvas, ZOOM_ANIM_TIMER_ID);
+        dm->SetZoomVirtual(zoomTarget, &fixPt);
+        return;
+    }
+    // when retargeted mid-flight, this restarts from the intermediate
+    // level that's currently displayed
+    win->zoomAnimDm = dm;
+    win->zoomAnimStart = zoomStart;
+    win->zoomAnimTarget = zoomTarget;
+    win->zoomAnimStartTime = GetTickCount();
+    win->zoomAnimFixPt = fixPt;
+    // on battery the animation runs at half the frame rate; the steps
+    // interpolate by elapsed time, so it finishes just as fast
+    UINT delayInMs = IsPowerSavingActive() ? 2 * ZOOM_ANIM_DELAY_IN_MS : ZOOM_ANIM_DELAY_IN_MS;
+    SetAnimationTimer(win->hwndCanvas, ZOOM_ANIM_TIMER_ID, delayInMs);
+}
+
+static void OnZoomAnimStep(WindowInfo* win) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm || dm != win->zoomAnimDm || 0 == win->zoomAnimTarget) {
+        win->zoomAnimTarget = 0;
+        KillTimer(win->hwndCanvas, ZOOM_ANIM_TIMER_ID);
+        return;
+    }
+    DWORD elapsed = GetTickCount() - win->zoomAnimStartTime;
+    if (elapsed >= ZOOM_ANIM_DURATION_IN_MS) {
+        float zoom = win->zoomAnimTarget;
+        win->zoomAnimTarget = 0;
+        KillTimer(win->hwndCanvas, ZOOM_ANIM_TIMER_ID);
+        dm->SetZoomVirtual(zoom, &win->zoomAnimFixPt);
+        UpdateToolbarState(win);
+        return;
+    }
+    // interpolate geometrically so that every step changes the zoom by the
+    // same factor; a linear ramp would appear to slow down as it goes
+    float t = (float)elapsed / ZOOM_ANIM_DURATION_IN_MS;
+    float zoom = win->zoomAnimStart * powf(win->zoomAnimTarget / win->zoomAnimStart, t);
+    dm->SetZoomVirtual(zoom, &win->zoomAnimFixPt);
+}
+
+// frame rate of an inertial scroll; a pure scroll paints from the cached
+// bitmaps (see DrawScrolledDocument), so the frames are cheap
+#define SCROLL_ANIM_FPS 60
+// fraction of the velocity that's left after one second of coasting
+#define SCROLL_ANIM_DECAY 0.002f
+// coasting stops once the velocity drops below this (pixels per second)
+#define SCROLL_ANIM_MIN_VELOCITY 30.f
+
+/* Scroll with inertia instead of jumping: every wheel notch adds velocity
+   and a per-frame timer advances the scroll position while the velocity
+   decays exponentially. Frames are paced by a FrameTimeoutCalculator so
+   that the animation advances in real time regardless of timer jitter,
+   and the per-frame ScrollYBy calls feed UpdateScrollVelocity, giving
+   the render prefetcher a steady velocity signal. */
+static void StartInertialScroll(WindowInfo* win, float velocity) {
+    DisplayModel* dm = win->AsFixed();
+    CrashIf(!dm);
+    if (dm != win->scrollAnimDm || 0 == win->scrollAnimVelocity || !win->scrollAnimFtc) {
+        int fps = SCROLL_ANIM_FPS;
+        if (IsPowerSavingActive()) {
+            // half the frame rate on battery: coasting at 30 fps is still
+            // smooth enough and costs half the wakeups
+            fps /= 2;
+        }
+        // (re)start the frame clock: a calculator left over from an earlier
+        // coast would consider all the frames since then overdue
+        delete win->scrollAnimFtc;
+        win->scrollAnimFtc = new FrameTimeoutCalculator(fps);
+        win->scrollAnimDt = 1.f / (float)fps;
+        win->scrollAnimDm = dm;
+        win->scrollAnimVelocity = 0;
+        win->scrollAnimError = 0;
+    }
+    if ((velocity < 0) != (win->scrollAnimVelocity < 0)) {
+        // a notch against the travel direction stops the coast instead of
+        // merely damping it
+        win->scrollAnimVelocity = 0;
+    }
+    win->scrollAnimVelocity += velocity;
+    SetAnimationTimer(win->hwndCanvas, SCROLL_ANIM_TIMER_ID, win->scrollAnimFtc->GetTimeoutInMilliseconds());
+}
+
+static void OnInertialScrollStep(WindowInfo* win) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm || dm != win->scrollAnimDm || 0 == win->scrollAnimVelocity || !win->scrollAnimFtc) {
+        win->scrollAnimVelocity = 0;
+        KillTimer(win->hwndCanvas, SCROLL_ANIM_TIMER_ID);
+        return;
+    }
+    DWORD timeout = win->scrollAnimFtc->GetTimeoutInMilliseconds();
+    if (timeout > 0) {
+        // the timer fired early, wait out the rest of the frame
+        SetAnimationTimer(win->hwndCanvas, SCROLL_ANIM_TIMER_ID, timeout);
+        return;
+    }
+    win->scrollAnimFtc->Step();
+
+    const float dt = win->scrollAnimDt;
+    float dist = win->scrollAnimVelocity * dt + win->scrollAnimError;
+    int dy = (int)dist;
+    win->scrollAnimError = dist - (float)dy;
+    if (dy != 0) {
+        int yBefore = dm->GetViewPort().y;
+        dm->ScrollYBy(dy, true);
+        if (dm->GetViewPort().y == yBefore) {
+            // hit the top or the bottom of the document
+            win->scrollAnimVelocity = 0;
+        }
+    }
+    win->scrollAnimVelocity *= powf(SCROLL_ANIM_DECAY, dt);
+    if (fabsf(win->scrollAnimVelocity) < SCROLL_ANIM_MIN_VELOCITY) {
+        win->scrollAnimVelocity = 0;
+        KillTimer(win->hwndCanvas, SCROLL_ANIM_TIMER_ID);
+        return;
+    }
+    SetAnimationTimer(win->hwndCanvas, SCROLL_ANIM_TIMER_ID, win->scrollAnimFtc->GetTimeoutInMilliseconds());
+}
+
 static LRESULT CanvasOnMouseWheel(WindowInfo* win, UINT msg, WPARAM wp, LPARAM lp) {
     // Scroll the ToC sidebar, if it's visible and the cursor is in it
     if (win->tocVisible && IsCursorOverWindow(win->tocTreeCtrl->hwnd) && !gWheelMsgRedirect) {
@@ -1051,8 +1493,17 @@ static LRESULT CanvasOnMouseWheel(WindowInfo* win, UINT msg, WPARAM wp, LPARAM l
         Point pt;
         GetCursorPosInHwnd(win->hwndCanvas, pt);
 
-        float zoom = win->ctrl->GetNextZoomStep(delta < 0 ? ZOOM_MIN : ZOOM_MAX);
-        win->ctrl->SetZoomVirtual(zoom, &pt);
+        DisplayModel* dm = win->AsFixed();
+        if (dm) {
+            // take the next step from the target of an animation still in
+            // flight, so that fast wheel spins don't get eaten
+            float baseZoom = win->zoomAnimTarget != 0 ? win->zoomAnimTarget : dm->GetZoomVirtual(true);
+            float zoom = dm->GetNextZoomStep(delta < 0 ? ZOOM_MIN : ZOOM_MAX, baseZoom);
+            StartZoomAnimation(win, zoom, pt);
+        } else {
+            float zoom = win->ctrl->GetNextZoomStep(delta < 0 ? ZOOM_MIN : ZOOM_MAX);
+            win->ctrl->SetZoomVirtual(zoom, &pt);
+        }
         UpdateToolbarState(win);
 
         // don't show the context menu when zooming with the right mouse-button down
@@ -1104,6 +1555,16 @@ static LRESULT CanvasOnMouseWheel(WindowInfo* win, UINT msg, WPARAM wp, LPARAM l
         return 0;
     }
 
+    DisplayModel* dm = win->AsFixed();
+    if (gGlobalPrefs->smoothScroll && !horizontal && dm && IsContinuous(dm->GetDisplayMode())) {
+        // one notch coasts about as far as the line-by-line jump below
+        // would scroll it: integrating the decay gives a total distance
+        // of velocity / -ln(SCROLL_ANIM_DECAY)
+        float perNotch = 3.f * (float)DpiScale(win->hwndCanvas, 16) * -logf(SCROLL_ANIM_DECAY);
+        StartInertialScroll(win, -perNotch * (float)delta / WHEEL_DELTA);
+        return 0;
+    }
+
     win->wheelAccumDelta += delta;
     int currentScrollPos = GetScrollPos(win->hwndCanvas, SB_VERT);
 
@@ -1237,11 +1698,11 @@ static LRESULT OnGesture(WindowInfo* win, UINT msg, WPARAM wp, LPARAM lp) {
                 // Playing with the app, I found that I often didn't go quit a full 90 or 180
                 // degrees. Allowing rotate without a full finger rotate seemed more natural.
                 if (degrees < -120 || degrees > 120) {
-                    win->AsFixed()->RotateBy(180);
+                    RotateDocBy(win->AsFixed(), 180);
                 } else if (degrees < -45) {
-                    win->AsFixed()->RotateBy(-90);
+                    RotateDocBy(win->AsFixed(), -90);
                 } else if (degrees > 45) {
-                    win->AsFixed()->RotateBy(90);
+                    RotateDocBy(win->AsFixed(), 90);
                 }
             }
             break;
@@ -1338,6 +1799,25 @@ static LRESULT WndProcCanvasFixedPageUI(WindowInfo* win, HWND hwnd, UINT msg, WP
         case WM_GESTURE:
             return OnGesture(win, msg, wp, lp);
 
+        case WM_NCMOUSEMOVE:
+            // lp carries screen coordinates for non-client messages
+            if (HTVSCROLL == wp) {
+                UpdateScrollPreview(win, GET_Y_LPARAM(lp));
+                TRACKMOUSEEVENT tme{sizeof(tme), TME_LEAVE | TME_NONCLIENT, hwnd, 0};
+                TrackMouseEvent(&tme);
+            } else {
+                HideScrollPreview(win);
+            }
+            return DefWindowProc(hwnd, msg, wp, lp);
+
+        case WM_NCMOUSELEAVE:
+            HideScrollPreview(win);
+            return DefWindowProc(hwnd, msg, wp, lp);
+
+        case WM_DESTROY:
+            HideScrollPreview(win);
+            return DefWindowProc(hwnd, msg, wp, lp);
+
         case WM_NCPAINT: {
             // check whether scrolling is required in the horizontal and/or vertical axes
             int requiredScrollAxes = -1;
@@ -1462,7 +1942,7 @@ static LRESULT WndProcCanvasLoadError(WindowInfo* win, HWND hwnd, UINT msg, WPAR
 
 ///// methods needed for all types of canvas /////
 
-void RepaintAsync(WindowInfo* win, int delayInMs) {
+static void ScheduleRepaint(WindowInfo* win, int delayInMs) {
     // even though RepaintAsync is mostly called from the UI thread,
     // we depend on the repaint message to happen asynchronously
     uitask::Post([win, delayInMs] {
@@ -1477,15 +1957,48 @@ void RepaintAsync(WindowInfo* win, int delayInMs) {
     });
 }
 
+void RepaintAsync(WindowInfo* win, int delayInMs) {
+    win->pendingRepaintAll = true;
+    ScheduleRepaint(win, delayInMs);
+}
+
+// repaints only dirtyRect (in client coordinates): the rest of the canvas
+// keeps the pixels from the double buffer and is never re-drawn, which is
+// what makes e.g. selection rubber-banding smooth on a 4K canvas. dirtyRect
+// must cover everything that changed since the last paint - when in doubt,
+// use the full-canvas variant. unlike that variant, this one may only be
+// called from the UI thread (the rect accumulation isn't thread-safe)
+void RepaintAsync(WindowInfo* win, int delayInMs, Rect dirtyRect) {
+    if (dirtyRect.IsEmpty()) {
+        // what changed isn't on screen
+        return;
+    }
+    if (!win->pendingRepaintAll) {
+        win->pendingRepaintRect = win->pendingRepaintRect.Union(dirtyRect);
+    }
+    ScheduleRepaint(win, delayInMs);
+}
+
 static void OnTimer(WindowInfo* win, HWND hwnd, WPARAM timerId) {
     Point pt;
 
     switch (timerId) {
-        case REPAINT_TIMER_ID:
+        case REPAINT_TIMER_ID: {
             win->delayedRepaintTimer = 0;
             KillTimer(hwnd, REPAINT_TIMER_ID);
-            win->RedrawAllIncludingNonClient(true);
+            Rect dirty = win->pendingRepaintRect;
+            bool repaintAll = win->pendingRepaintAll || dirty.IsEmpty();
+            win->pendingRepaintRect = Rect();
+            win->pendingRepaintAll = false;
+            if (repaintAll) {
+                win->RedrawAllIncludingNonClient(true);
+            } else {
+                RECT r = ToRECT(dirty);
+                InvalidateRect(win->hwndCanvas, &r, FALSE);
+                UpdateWindow(win->hwndCanvas);
+            }
             break;
+        }
 
         case SMOOTHSCROLL_TIMER_ID:
             if (MouseAction::Scrolling == win->mouseAction) {
@@ -1502,6 +2015,14 @@ static void OnTimer(WindowInfo* win, HWND hwnd, WPARAM timerId) {
             }
             break;
 
+        case ZOOM_ANIM_TIMER_ID:
+            OnZoomAnimStep(win);
+            break;
+
+        case SCROLL_ANIM_TIMER_ID:
+            OnInertialScrollStep(win);
+            break;
+
         case HIDE_CURSOR_TIMER_ID:
             KillTimer(hwnd, HIDE_CURSOR_TIMER_ID);
             if (win->presentation) {
@@ -1515,10 +2036,12 @@ static void OnTimer(WindowInfo* win, HWND hwnd, WPARAM timerId) {
                 SetTimer(hwnd, HIDE_FWDSRCHMARK_TIMER_ID, HIDE_FWDSRCHMARK_DECAYINTERVAL_IN_MS, nullptr);
             } else if (win->fwdSearchMark.hideStep >= HIDE_FWDSRCHMARK_STEPS) {
                 KillTimer(hwnd, HIDE_FWDSRCHMARK_TIMER_ID);
+                Rect dirty = ForwardSearchMarkScreenRect(win);
                 win->fwdSearchMark.show = false;
-                RepaintAsync(win, 0);
+                RepaintAsync(win, 0, dirty);
             } else {
-                RepaintAsync(win, 0);
+                // only the mark's alpha changes, repaint just its rectangle
+                RepaintAsync(win, 0, ForwardSearchMarkScreenRect(win));
             }
             break;
 
@@ -1560,7 +2083,7 @@ static void OnDropFiles(HDROP hDrop, bool dragFinish) {
             win = CreateAndShowWindowInfo(nullptr);
             args.win = win;
         }
-        LoadDocument(args);
+        LoadDocumentAsync(args);
     }
     if (dragFinish) {
         DragFinish(hDrop);
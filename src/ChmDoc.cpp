@@ -276,6 +276,11 @@ bool ChmDoc::Load(const WCHAR* fileName) {
         return false;
     }
 
+    // the default cache of 5 decompressed blocks is far too small for large
+    // vendor CHMs, where following a link can mean re-decompressing megabytes
+    // from the last LZX reset point over and over
+    chm_set_param(chmHandle, CHM_PARAM_MAX_BLOCKS_CACHED, 64);
+
     ParseWindowsData();
     if (!ParseSystemData()) {
         return false;
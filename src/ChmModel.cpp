@@ -4,6 +4,7 @@
 #include "utils/BaseUtil.h"
 #include "utils/Dict.h"
 #include "utils/HtmlWindow.h"
+#include "utils/ThreadUtil.h"
 #include "utils/UITask.h"
 #include "utils/ScopedWin.h"
 
@@ -89,6 +90,17 @@ ChmModel::ChmModel(ControllerCallback* cb) : Controller(cb) {
 }
 
 ChmModel::~ChmModel() {
+    // must happen before taking docAccess: the tasks take the lock
+    // for each page they extract
+    InterlockedExchange(&preloadStop, 1);
+    if (preloadTask) {
+        preloadTask->Wait();
+        DropTaskHandle(preloadTask);
+    }
+    if (prefetchTask) {
+        prefetchTask->Wait();
+        DropTaskHandle(prefetchTask);
+    }
     EnterCriticalSection(&docAccess);
     // TODO: deleting htmlWindow seems to spin a modal loop which
     //       can lead to WM_PAINT being dispatched for the parent
@@ -219,6 +231,42 @@ void ChmModel::DisplayPage(const WCHAR* pageUrl) {
     if (htmlWindow) {
         htmlWindow->NavigateToDataUrl(pageUrl);
     }
+
+    // while the user reads this topic, warm up the neighboring topics in
+    // ToC order, so that sequential reading doesn't wait on CHMLib
+    PrefetchAdjacentPages();
+}
+
+// Extract the data of the topics before and after the displayed one into
+// urlDataCache on a thread pool thread. PreloadPageDataAsync() does this
+// for the whole ToC after opening, but stops at its byte budget; this
+// keeps the immediate neighborhood warm wherever the user is reading.
+// The destructor stops and waits out the task (see preloadStop)
+void ChmModel::PrefetchAdjacentPages() {
+    if (prefetchTask) {
+        if (!prefetchTask->IsDone()) {
+            // still extracting the previous neighborhood (two pages at
+            // most), whose pages mostly overlap with this one's
+            return;
+        }
+        DropTaskHandle(prefetchTask);
+        prefetchTask = nullptr;
+    }
+    int pageNo = currentPageNo;
+    auto fn = [this, pageNo] {
+        // the next topic first: that's where sequential reading goes
+        int toWarm[2] = {pageNo + 1, pageNo - 1};
+        for (int no : toWarm) {
+            if (no < 1 || no > PageCount()) {
+                continue;
+            }
+            if (InterlockedCompareExchange(&preloadStop, 0, 0)) {
+                return;
+            }
+            GetDataForUrl(pages.at(no - 1));
+        }
+    };
+    prefetchTask = GetThreadPool()->Submit(fn, TaskPriority::Prefetch);
 }
 
 void ChmModel::ScrollToLink(PageDestination* link) {
@@ -439,6 +487,34 @@ bool ChmModel::OnBeforeNavigate(const WCHAR* url, bool newWindow) {
     return false;
 }
 
+// Extract the data of the pages referenced from the ToC into
+// urlDataCache on a thread pool thread, so that navigating a large CHM
+// hits warm data instead of waiting for CHMLib to decompress the page.
+// Each page is extracted under docAccess, so the UI thread never waits
+// for more than a single extraction.
+// pages is complete after Load() and read-only from then on; the
+// destructor stops and waits out the task before tearing anything down
+void ChmModel::PreloadPageDataAsync() {
+    CrashIf(preloadTask);
+    auto fn = [this] {
+        // cap the amount of data kept decompressed; a fully extracted
+        // vendor CHM can be many times the size of the file
+        size_t budget = 32 * 1024 * 1024;
+        int nPages = PageCount();
+        for (int pageNo = 1; pageNo <= nPages; pageNo++) {
+            if (InterlockedCompareExchange(&preloadStop, 0, 0)) {
+                return;
+            }
+            std::span<u8> data = GetDataForUrl(pages.at(pageNo - 1));
+            if (data.size() >= budget) {
+                return;
+            }
+            budget -= data.size();
+        }
+    };
+    preloadTask = GetThreadPool()->Submit(fn, TaskPriority::Prefetch);
+}
+
 // Load and cache data for a given url inside CHM file.
 std::span<u8> ChmModel::GetDataForUrl(const WCHAR* url) {
     ScopedCritSec scope(&docAccess);
@@ -715,5 +791,6 @@ ChmModel* ChmModel::Create(const WCHAR* fileName, ControllerCallback* cb) {
         delete cm;
         return nullptr;
     }
+    cm->PreloadPageDataAsync();
     return cm;
 }
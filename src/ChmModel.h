@@ -6,6 +6,7 @@ struct ChmTocTraceItem;
 class HtmlWindow;
 class HtmlWindowCallback;
 struct ChmCacheEntry;
+struct TaskHandle;
 
 struct ChmModel : Controller {
     explicit ChmModel(ControllerCallback* cb);
@@ -83,7 +84,15 @@ struct ChmModel : Controller {
     // is deleted (e.g. for titles and URLs for ChmTocItem and ChmCacheEntry)
     PoolAllocator poolAlloc;
 
+    // extracts the ToC pages into urlDataCache in the background
+    TaskHandle* preloadTask = nullptr;
+    LONG preloadStop = 0;
+    // warms the topics adjacent to the displayed one (see PrefetchAdjacentPages)
+    TaskHandle* prefetchTask = nullptr;
+
     bool Load(const WCHAR* fileName);
+    void PreloadPageDataAsync();
+    void PrefetchAdjacentPages();
     void DisplayPage(const WCHAR* pageUrl);
 
     ChmCacheEntry* FindDataForUrl(const WCHAR* url);
@@ -9,8 +9,10 @@ Cmd* enum (e.g. CmdOpen) and a human-readable name (not used yet).
 #define COMMANDS(V)                                                       \
     V(CmdOpen, "Open File...")                                            \
     V(CmdOpenFolder, "Open Folder...")                                    \
+    V(CmdQuickOpen, "Quick Open...")                                      \
     V(CmdClose, "Close Document")                                         \
     V(CmdSaveAs, "Save File As...")                                       \
+    V(CmdSaveAsOptimized, "Save Optimized As...")                         \
     V(CmdPrint, "Print Document...")                                      \
     V(CmdShowInFolder, "Show File In Folder...")                          \
     V(CmdRenameFile, "Rename File...")                                    \
@@ -33,6 +35,8 @@ Cmd* enum (e.g. CmdOpen) and a human-readable name (not used yet).
     V(CmdViewShowHideToolbar, "View: Toogle Toolbar")                     \
     V(CmdViewShowHideScrollbars, "View: Toogle Scrollbars")               \
     V(CmdViewShowHideMenuBar, "View: Toggle Menu Bar")                    \
+    V(CmdViewReflowMode, "View: Reflow Text")                             \
+    V(CmdViewShowHideThumbnails, "View: Toggle Thumbnails")               \
     V(CmdCopySelection, "Copy Selection")                                 \
     V(CmdSelectAll, "Select All")                                         \
     V(CmdNewWindow, "Open New Window")                                    \
@@ -53,6 +57,7 @@ Cmd* enum (e.g. CmdOpen) and a human-readable name (not used yet).
     V(CmdFindMatch, "Find: Match Case")                                   \
     V(CmdFindNextSel, "Find: Next Selection")                             \
     V(CmdFindPrevSel, "Find: Previous Selection")                         \
+    V(CmdSearchAllTabs, "Search All Tabs")                                \
     V(CmdSaveAnnotations, "Save Annotations")                             \
     V(CmdEditAnnotations, "Edit Annotations")                             \
     V(CmdZoomFitPage, "Zoom: Fit Page")                                   \
@@ -124,6 +129,7 @@ Cmd* enum (e.g. CmdOpen) and a human-readable name (not used yet).
     V(CmdDebugDownloadSymbols, "Debug: Download Symbols")                 \
     V(CmdDebugTestApp, "Debug: Test App")                                 \
     V(CmdDebugShowNotif, "Debug: Show Notification")                      \
+    V(CmdDebugShowMemoryUsage, "Debug: Show Memory Usage")                \
     V(CmdDebugMui, "Debug: Mui")                                          \
     V(CmdNewBookmarks, "New Bookmarks")                                   \
     V(CmdCreateAnnotText, "Create Text Annotation")                       \
@@ -22,6 +22,9 @@ struct ControllerCallback {
     virtual void Repaint() = 0;
     virtual void UpdateScrollbars(Size canvas) = 0;
     virtual void RequestRendering(int pageNo) = 0;
+    // cancel rendering requests that haven't started yet (e.g. page
+    // prefetches that predicted the wrong scroll direction)
+    virtual void CancelQueuedRendering() = 0;
     virtual void CleanUp(DisplayModel* dm) = 0;
     virtual void RenderThumbnail(DisplayModel* dm, Size size, const onBitmapRenderedCb&) = 0;
     // ChmModel //
@@ -13,6 +13,8 @@
 #include "utils/FileUtil.h"
 #include "utils/HttpUtil.h"
 #include "utils/LzmaSimpleArchive.h"
+#include "utils/MemAccounting.h"
+#include "utils/ThreadUtil.h"
 #include "utils/WinUtil.h"
 #include "utils/LogDbg.h"
 #include "utils/Log.h"
@@ -21,6 +23,7 @@
 #include "SumatraPDF.h"
 #include "AppTools.h"
 #include "CrashHandler.h"
+#include "DibPool.h"
 #include "Version.h"
 #include "SumatraConfig.h"
 #include "AppPrefs.h"
@@ -115,6 +118,10 @@ static std::span<u8> BuildCrashInfoText() {
     s.Append("\n");
     s.Append(gModulesInfo);
 
+    s.Append("\n-------- Memory usage --------\n\n");
+    memacct::FmtReport(s);
+    DibPoolFmtStats(s);
+
     s.Append("\n\n-------- Log -----------------\n\n");
     s.AppendView(gLogBuf->AsView());
 
@@ -271,6 +278,27 @@ bool CrashHandlerDownloadSymbols() {
     return true;
 }
 
+// Pre-fetches the symbols for this build into gSymbolsDir (which persists
+// across runs) on a background thread, so that a later crash can usually be
+// resolved from the local cache without hitting the network; it also gets
+// dbghelp.dll loaded and initialized outside of both startup and the crash
+// path. Called once the message queue went idle after startup.
+void CrashHandlerDownloadSymbolsAsync() {
+    if (gDisableSymbolsDownload || !gDumpThread) {
+        return;
+    }
+    if (!CrashHandlerCanUseNet()) {
+        return;
+    }
+    static LONG started = 0;
+    if (InterlockedExchange(&started, 1)) {
+        return;
+    }
+    // not on the shared thread pool because the download can block for
+    // a long time, which would starve the pool's workers
+    RunAsync([] { CrashHandlerDownloadSymbols(); });
+}
+
 // If we can't resolve the symbols, we assume it's because we don't have symbols
 // so we'll try to download them and retry. If we can resolve symbols, we'll
 // get the callstacks etc. and submit to our server for analysis.
@@ -299,19 +327,29 @@ void SubmitCrashInfo() {
     dbglog("SubmitCrashInfo() finished\n");
 }
 
+// set at install time so that writing the dump doesn't have to query the
+// environment; set the SUMATRAPDF_FULLDUMP environment variable for more
+// complete dumps
+static bool gFullCrashDump = false;
+
 static DWORD WINAPI CrashDumpThread([[maybe_unused]] LPVOID data) {
     WaitForSingleObject(gDumpEvent, INFINITE);
     if (!gCrashed) {
         return 0;
     }
 
-    SubmitCrashInfo();
+    // always write a MiniDump (for the latest crash only) and do it first:
+    // it's the only part of crash handling that doesn't allocate, so it
+    // succeeds even when the crash was caused by memory exhaustion
+    dbghelp::WriteMiniDump(gCrashDumpPath, &gMei, gFullCrashDump);
+
+    // log writes to the file are deferred to a flusher thread; get the
+    // tail that preceded the crash onto disk while we still can
+    FlushLogToFile();
 
-    // always write a MiniDump (for the latest crash only)
-    // set the SUMATRAPDF_FULLDUMP environment variable for more complete dumps
-    DWORD n = GetEnvironmentVariableA("SUMATRAPDF_FULLDUMP", nullptr, 0);
-    bool fullDump = (0 != n);
-    dbghelp::WriteMiniDump(gCrashDumpPath, &gMei, fullDump);
+    // symbol resolution and the report upload allocate (from the
+    // preallocated crash heap) and can fail, so they go last
+    SubmitCrashInfo();
     return 0;
 }
 
@@ -683,8 +721,13 @@ void InstallCrashHandler(const WCHAR* crashDumpPath, const WCHAR* crashFilePath,
     // we pre-allocate as much as possible to minimize allocations
     // when crash handler is invoked. It's ok to use standard
     // allocation functions here.
-    gCrashHandlerAllocator = new HeapAllocator();
+    // the crash heap gets 4 MB committed up front: enough for the crash
+    // report text (callstacks, modules, the log buffer) plus the copy
+    // made for the upload, so that building the report doesn't have to
+    // grow the heap on a machine that may be out of memory
+    gCrashHandlerAllocator = new HeapAllocator(4 * 1024 * 1024);
     gSymbolsUrl = BuildSymbolsUrl();
+    gFullCrashDump = 0 != GetEnvironmentVariableA("SUMATRAPDF_FULLDUMP", nullptr, 0);
 
     AutoFreeWstr path = prefs::GetSettingsPath();
     // can be empty on first run but that's fine because then we know it has default values
@@ -7,4 +7,5 @@ void InstallCrashHandler(const WCHAR* crashDumpPath, const WCHAR* crashFilePath,
 void SubmitCrashInfo();
 void UninstallCrashHandler();
 bool CrashHandlerDownloadSymbols();
+void CrashHandlerDownloadSymbolsAsync();
 bool SetSymbolsDir(const WCHAR* symDir);
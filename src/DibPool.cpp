@@ -0,0 +1,194 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+#include "utils/MemAccounting.h"
+#include "utils/ScopedWin.h"
+
+#include "DibPool.h"
+
+// how many bytes of idle sections the pool holds on to before releases
+// start freeing for real; enough for a handful of full-screen pages
+#define MAX_POOLED_DIB_BYTES (64 * 1024 * 1024)
+
+struct DibPoolEntry {
+    HBITMAP hbmp = nullptr;
+    HANDLE hMap = nullptr;
+    void* data = nullptr;
+    int dx = 0;
+    int dy = 0;
+    i64 size = 0;
+    bool inUse = false;
+    // tick of the last release, for freeing the stalest sections first
+    // when the pool is over budget
+    LONG64 lastUsed = 0;
+};
+
+static CRITICAL_SECTION gDibPoolLock;
+// the first acquire can come from any of the render threads, so the lock
+// is set up during static initialization
+static struct DibPoolLockInit {
+    DibPoolLockInit() {
+        InitializeCriticalSection(&gDibPoolLock);
+    }
+} gDibPoolLockInit;
+static Vec<DibPoolEntry>* gDibPool = nullptr;
+static LONG64 gDibPoolUseCounter = 0;
+
+// counters mirrored outside the lock so that DibPoolFmtStats stays safe
+// to call from the crash handler
+static LONG gDibHandlesInUse = 0;
+static LONG gDibHandlesPooled = 0;
+
+static void DibPoolLock() {
+    EnterCriticalSection(&gDibPoolLock);
+}
+
+static void DibPoolUnlock() {
+    LeaveCriticalSection(&gDibPoolLock);
+}
+
+// frees an idle entry for real; caller holds the lock
+static void FreePoolEntry(DibPoolEntry* e) {
+    CrashIf(e->inUse);
+    DeleteObject(e->hbmp);
+    CloseHandle(e->hMap);
+    memacct::Add(memacct::SubsysDibPool, -e->size);
+    InterlockedDecrement(&gDibHandlesPooled);
+}
+
+// frees the stalest idle sections until the pool is within its budget
+// again; caller holds the lock
+static void TrimPool(i64 maxBytes) {
+    for (;;) {
+        i64 pooledBytes = 0;
+        int stalest = -1;
+        for (int i = 0; i < gDibPool->isize(); i++) {
+            DibPoolEntry* e = &gDibPool->at(i);
+            if (e->inUse) {
+                continue;
+            }
+            pooledBytes += e->size;
+            if (stalest < 0 || e->lastUsed < gDibPool->at(stalest).lastUsed) {
+                stalest = i;
+            }
+        }
+        if (pooledBytes <= maxBytes || stalest < 0) {
+            return;
+        }
+        FreePoolEntry(&gDibPool->at(stalest));
+        gDibPool->RemoveAtFast(stalest);
+    }
+}
+
+HBITMAP DibPoolAcquire(int dx, int dy, void** dataOut) {
+    *dataOut = nullptr;
+    i64 size = (i64)dx * 4 * dy;
+    if (dx <= 0 || dy <= 0 || size > INT_MAX) {
+        return nullptr;
+    }
+
+    DibPoolLock();
+    if (!gDibPool) {
+        gDibPool = new Vec<DibPoolEntry>();
+    }
+    for (int i = 0; i < gDibPool->isize(); i++) {
+        DibPoolEntry* e = &gDibPool->at(i);
+        if (e->inUse || e->dx != dx || e->dy != dy) {
+            continue;
+        }
+        e->inUse = true;
+        memacct::Add(memacct::SubsysDibPool, -e->size);
+        InterlockedDecrement(&gDibHandlesPooled);
+        InterlockedIncrement(&gDibHandlesInUse);
+        *dataOut = e->data;
+        HBITMAP hbmp = e->hbmp;
+        DibPoolUnlock();
+        return hbmp;
+    }
+    DibPoolUnlock();
+
+    // no section of this size is idle, make a new one (outside the lock,
+    // CreateDIBSection can be slow)
+    BITMAPINFO bmi{};
+    BITMAPINFOHEADER* bmih = &bmi.bmiHeader;
+    bmih->biSize = sizeof(*bmih);
+    bmih->biWidth = dx;
+    bmih->biHeight = -dy;
+    bmih->biPlanes = 1;
+    bmih->biCompression = BI_RGB;
+    bmih->biBitCount = 32;
+    bmih->biSizeImage = (DWORD)size;
+
+    void* data = nullptr;
+    HANDLE hMap = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)size, nullptr);
+    HBITMAP hbmp = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &data, hMap, 0);
+    if (!hbmp || !data) {
+        if (hbmp) {
+            DeleteObject(hbmp);
+        }
+        if (hMap) {
+            CloseHandle(hMap);
+        }
+        return nullptr;
+    }
+
+    DibPoolEntry e;
+    e.hbmp = hbmp;
+    e.hMap = hMap;
+    e.data = data;
+    e.dx = dx;
+    e.dy = dy;
+    e.size = size;
+    e.inUse = true;
+
+    DibPoolLock();
+    gDibPool->Append(e);
+    DibPoolUnlock();
+    InterlockedIncrement(&gDibHandlesInUse);
+    *dataOut = data;
+    return hbmp;
+}
+
+bool DibPoolRelease(HBITMAP hbmp) {
+    if (!hbmp || !gDibPool) {
+        return false;
+    }
+    DibPoolLock();
+    for (int i = 0; i < gDibPool->isize(); i++) {
+        DibPoolEntry* e = &gDibPool->at(i);
+        if (e->hbmp != hbmp) {
+            continue;
+        }
+        CrashIf(!e->inUse);
+        e->inUse = false;
+        e->lastUsed = ++gDibPoolUseCounter;
+        memacct::Add(memacct::SubsysDibPool, e->size);
+        InterlockedDecrement(&gDibHandlesInUse);
+        InterlockedIncrement(&gDibHandlesPooled);
+        TrimPool(MAX_POOLED_DIB_BYTES);
+        DibPoolUnlock();
+        return true;
+    }
+    DibPoolUnlock();
+    return false;
+}
+
+void DibPoolFmtStats(str::Str& s) {
+    s.AppendFmt("dib pool handles: %d in use, %d idle\n", (int)gDibHandlesInUse, (int)gDibHandlesPooled);
+}
+
+void DibPoolFreeAll() {
+    if (!gDibPool) {
+        return;
+    }
+    DibPoolLock();
+    // sections still handed out (there shouldn't be any at shutdown) keep
+    // their kernel objects; freeing them under their owners would be worse
+    TrimPool(0);
+    if (gDibPool->isize() == 0) {
+        delete gDibPool;
+        gDibPool = nullptr;
+    }
+    DibPoolUnlock();
+}
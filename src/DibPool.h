@@ -0,0 +1,24 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// acquires a 32bpp top-down DIB section of exactly dx x dy pixels,
+// preferably by recycling a section of the same dimensions released by a
+// destroyed RenderedBitmap, so that cache turnover doesn't create and
+// destroy a kernel object (plus a large allocation) for every rendered
+// page. The pool keeps the section's backing file mapping handle for its
+// whole lifetime; callers only see the HBITMAP and the pixel data.
+// returns nullptr on GDI resource exhaustion.
+// recycled pixels are not cleared
+HBITMAP DibPoolAcquire(int dx, int dy, void** dataOut);
+
+// gives a section back to the pool (or frees it when the pool is over
+// its budget); returns false if hbmp didn't come from the pool, in which
+// case the caller still owns it (i.e. calls DeleteObject)
+bool DibPoolRelease(HBITMAP hbmp);
+
+// appends the pool's handle counts to a memory report; reads the
+// counters without taking the pool's lock so that it stays safe to call
+// from the crash handler
+void DibPoolFmtStats(str::Str& s);
+
+void DibPoolFreeAll();
@@ -46,6 +46,9 @@
 #include "utils/BaseUtil.h"
 #include "utils/WinUtil.h"
 #include "utils/ScopedWin.h"
+#include "utils/ThreadUtil.h"
+#include "utils/UITask.h"
+#include "utils/EtwTrace.h"
 #include "utils/Log.h"
 
 #include "wingui/TreeModel.h"
@@ -59,14 +62,24 @@
 #include "Controller.h"
 #include "DisplayModel.h"
 #include "GlobalPrefs.h"
+#include "MemoryPolicy.h"
 #include "PdfSync.h"
 #include "ProgressUpdateUI.h"
 #include "TextSelection.h"
 #include "TextSearch.h"
+#include "TextIndexCache.h"
+#include "OcrEngine.h"
 
 // if true, we pre-render the pages right before and after the visible pages
 static bool gPredictiveRender = true;
 
+// how many pages beyond the visible ones to queue for rendering (in the
+// direction of travel) when the user is scrolling fast
+#define MAX_PREFETCH_PAGES 4
+// how fast (in pixels per ms) the view must move before we start
+// prefetching whole pages ahead of the scroll
+#define PREFETCH_MIN_VELOCITY 0.5f
+
 static int ColumnsFromDisplayMode(DisplayMode displayMode) {
     if (!IsSingle(displayMode)) {
         return 2;
@@ -125,6 +138,11 @@ TocTree* DisplayModel::GetToc() {
     if (!engine) {
         return nullptr;
     }
+    if (tocBuildTask && !IsTocReady()) {
+        // don't race a background build (see BuildTocAsync); once it's
+        // done, engine->GetToc() just returns the cached tree
+        tocBuildTask->Wait();
+    }
     return engine->GetToc();
 }
 
@@ -213,6 +231,11 @@ bool DisplayModel::GetDisplayR2L() const {
 }
 
 void DisplayModel::RepaintDisplay() {
+    repaintRev++;
+    cb->Repaint();
+}
+
+void DisplayModel::RepaintForScroll() {
     cb->Repaint();
 }
 
@@ -250,7 +273,7 @@ SizeF DisplayModel::PageSizeAfterRotation(int pageNo, bool fitToContent) const {
         return {};
     }
     if (fitToContent && pageInfo->contentBox.IsEmpty()) {
-        pageInfo->contentBox = engine->PageContentBox(pageNo);
+        pageInfo->contentBox = CachedPageContentBox(pageNo);
         if (pageInfo->contentBox.IsEmpty()) {
             return PageSizeAfterRotation(pageNo);
         }
@@ -289,7 +312,8 @@ static int LastPageInARowNo(int pageNo, int columns, bool showCover, int pageCou
 }
 
 // must call SetInitialViewSettings() after creation
-DisplayModel::DisplayModel(EngineBase* engine, ControllerCallback* cb) : Controller(cb) {
+DisplayModel::DisplayModel(EngineBase* engine, ControllerCallback* cb, DocumentTextCache* sharedTextCache)
+    : Controller(cb) {
     this->engine = engine;
     CrashIf(!engine || engine->PageCount() <= 0);
     engineType = engine->kind;
@@ -310,21 +334,341 @@ DisplayModel::DisplayModel(EngineBase* engine, ControllerCallback* cb) : Control
     pageSpacing.dy += 4;
 #endif
 
-    textCache = new DocumentTextCache(engine);
+    if (sharedTextCache) {
+        textCache = sharedTextCache->AddRef();
+    } else {
+        textCache = new DocumentTextCache(engine);
+    }
     textSelection = new TextSelection(engine, textCache);
     textSearch = new TextSearch(engine, textCache);
+    if (!sharedTextCache && GetMemoryPolicy().allowEagerTextIndexing) {
+        // a shared cache is filled (or already was) by the view it came
+        // from; under memory pressure pages are instead extracted on
+        // first use by search or selection
+        StartTextIndexing();
+    }
+    StartContentBoxSweep();
 }
 
 DisplayModel::~DisplayModel() {
     dontRenderFlag = true;
+    StopTextIndexing();
+    if (tocBuildTask) {
+        // the task uses the engine, which is deleted below
+        tocBuildTask->Wait();
+        DropTaskHandle(tocBuildTask);
+    }
+    if (contentBoxSweepTask) {
+        // the sweep checks dontRenderFlag between pages
+        contentBoxSweepTask->Wait();
+        DropTaskHandle(contentBoxSweepTask);
+    }
     cb->CleanUp(this);
 
     delete pdfSync;
     delete textSearch;
     delete textSelection;
-    delete textCache;
-    delete engine;
+    // both can be shared with another DisplayModel over the same document
+    textCache->DropRef();
+    engine->DropRef();
     free(pagesInfo);
+    free(pageTops);
+    free(pageBottoms);
+    free(contentBoxes);
+    free(contentBoxDone);
+}
+
+bool DisplayModel::UnshareEngine() {
+    if (engine->refs == 1) {
+        return true;
+    }
+    EngineBase* clone = engine->Clone();
+    if (!clone) {
+        return false;
+    }
+    // the indexing thread extracts through the engine and cache that
+    // are about to be swapped out from under it
+    StopTextIndexing();
+    EngineBase* oldEngine = engine;
+    engine = clone;
+    if (textCache->refs > 1) {
+        // the extracted text stays with the views of the original
+        // engine; pages this view needs again are re-extracted lazily
+        // from the clone
+        textCache->DropRef();
+        textCache = new DocumentTextCache(engine);
+    } else {
+        textCache->engine = engine;
+    }
+    textSelection->engine = engine;
+    textSelection->textCache = textCache;
+    textSearch->engine = engine;
+    textSearch->textCache = textCache;
+    // the other views keep the original engine alive, so renders and
+    // background tasks still running against it stay valid (and their
+    // results match, it's the same document)
+    oldEngine->DropRef();
+    return true;
+}
+
+// max number of engine clones text extraction is fanned out over
+#define MAX_TEXT_INDEX_WORKERS 4
+
+/* Extracts the text of all pages into the DocumentTextCache in the
+   background, so that the first search (and text selection) doesn't have
+   to walk a cold document page by page. Extraction is fanned out over
+   engine clones where the engine supports cloning; the workers pull the
+   next unextracted page from a shared counter and store the result into
+   the page's slot, so results end up in page order regardless of which
+   worker got there first. */
+class TextIndexThread : public ThreadBase {
+    DocumentTextCache* textCache;
+    EngineBase* engine;
+    int nPages;
+    LONG nextPageNo = 0;
+
+  public:
+    TextIndexThread(DocumentTextCache* textCache, EngineBase* engine, int nPages)
+        : ThreadBase("TextIndexThread"), textCache(textCache), engine(engine), nPages(nPages) {
+    }
+
+    void ExtractWith(EngineBase* e) {
+        for (;;) {
+            if (WasCancelRequested()) {
+                return;
+            }
+            int pageNo = (int)InterlockedIncrement(&nextPageNo);
+            if (pageNo > nPages) {
+                return;
+            }
+            if (textCache->HasTextForPage(pageNo)) {
+                continue;
+            }
+            textCache->SetTextForPage(pageNo, e->ExtractPageText(pageNo));
+        }
+    }
+
+    void ExtractAllPages();
+    bool OcrPagesWithoutText(EngineBase* e);
+
+    void Run() override;
+};
+
+struct TextIndexWorker {
+    TextIndexThread* indexThread = nullptr;
+    // clone owned (and freed) by the worker
+    EngineBase* engine = nullptr;
+};
+
+static DWORD WINAPI TextIndexWorkerThread(LPVOID data) {
+    TextIndexWorker* worker = (TextIndexWorker*)data;
+    worker->indexThread->ExtractWith(worker->engine);
+    delete worker->engine;
+    return 0;
+}
+
+// rasterizes every page the extraction found no text on and replaces its
+// cache entry with what the registered OCR engine recognized, so that
+// search and selection work over scanned documents
+bool TextIndexThread::OcrPagesWithoutText(EngineBase* e) {
+    OcrEngine* ocr = GetOcrEngine();
+    float zoom = (float)ocr->PreferredDpi() / e->fileDPI;
+    bool changed = false;
+    for (int pageNo = 1; pageNo <= nPages && !WasCancelRequested(); pageNo++) {
+        int len = 0;
+        textCache->GetTextForPage(pageNo, &len);
+        if (len > 0) {
+            continue;
+        }
+        RenderPageArgs args(pageNo, zoom, 0);
+        RenderedBitmap* bmp = e->RenderPage(args);
+        if (!bmp) {
+            continue;
+        }
+        OcrPageResult res;
+        bool ok = ocr->RecognizePage(bmp, &res);
+        delete bmp;
+        if (!ok || res.len <= 0) {
+            free(res.text);
+            free(res.coords);
+            continue;
+        }
+        // the engine reports glyph boxes in bitmap pixels; map them back
+        // into page coordinates. Line break glyphs keep their empty
+        // extent (that's how GetIndexForPage finds the line runs)
+        for (int i = 0; i < res.len; i++) {
+            if (!res.coords[i].x && !res.coords[i].dx) {
+                continue;
+            }
+            RectF box = e->Transform(ToRectFl(res.coords[i]), pageNo, zoom, 0, true);
+            res.coords[i] = box.Round();
+        }
+        PageText recognized;
+        recognized.text = res.text;
+        recognized.coords = res.coords;
+        recognized.len = res.len;
+        textCache->ReplaceEmptyTextForPage(pageNo, recognized);
+        changed = true;
+    }
+    return changed;
+}
+
+void TextIndexThread::Run() {
+    const WCHAR* filePath = engine->FileName();
+    bool useIndexCache = gGlobalPrefs->enableTextIndexCache && filePath != nullptr;
+    bool restored = useIndexCache && LoadTextIndexCache(filePath, textCache);
+    if (!restored) {
+        ExtractAllPages();
+        if (useIndexCache && !WasCancelRequested()) {
+            SaveTextIndexCache(filePath, textCache);
+        }
+    }
+
+    // even with all pages restored from the on-disk index the OCR pass
+    // still runs: the index may have been saved without a recognizer
+    // registered
+    if (!GetOcrEngine() || WasCancelRequested()) {
+        return;
+    }
+    // pages without any text are usually scans; recognize them at idle
+    // priority so that the (much slower) OCR never competes with
+    // interactive work. A clone keeps page rasterization off the
+    // document's own engine for the same reason
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+    EngineBase* clone = engine->Clone();
+    bool changed = OcrPagesWithoutText(clone ? clone : engine);
+    delete clone;
+    if (changed && useIndexCache && !WasCancelRequested()) {
+        SaveTextIndexCache(filePath, textCache);
+    }
+}
+
+void TextIndexThread::ExtractAllPages() {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int nWorkers = limitValue((int)si.dwNumberOfProcessors / 2, 1, MAX_TEXT_INDEX_WORKERS);
+    if (IsPowerSavingActive()) {
+        // on battery, trickle through the document on this thread alone
+        // instead of lighting up half the cores
+        nWorkers = 1;
+    }
+
+    // the first worker is this thread reusing the document's engine
+    // (serialized against other users by the engine's internal lock),
+    // additional workers get private clones so they can extract truly
+    // in parallel
+    TextIndexWorker workers[MAX_TEXT_INDEX_WORKERS];
+    HANDLE threads[MAX_TEXT_INDEX_WORKERS];
+    int nStarted = 0;
+    for (int i = 1; i < nWorkers && !WasCancelRequested(); i++) {
+        EngineBase* clone = engine->Clone();
+        if (!clone) {
+            // engine doesn't support cloning
+            break;
+        }
+        workers[nStarted] = {this, clone};
+        threads[nStarted] = CreateThread(nullptr, 0, TextIndexWorkerThread, &workers[nStarted], 0, 0);
+        if (!threads[nStarted]) {
+            delete clone;
+            break;
+        }
+        nStarted++;
+    }
+
+    ExtractWith(engine);
+
+    if (nStarted > 0) {
+        WaitForMultipleObjects(nStarted, threads, TRUE, INFINITE);
+        for (int i = 0; i < nStarted; i++) {
+            CloseHandle(threads[i]);
+        }
+    }
+}
+
+void DisplayModel::StartTextIndexing() {
+    CrashIf(textIndexThread);
+    textIndexThread = new TextIndexThread(textCache, engine, PageCount());
+    textIndexThread->Start();
+}
+
+void DisplayModel::StopTextIndexing() {
+    if (!textIndexThread) {
+        return;
+    }
+    textIndexThread->RequestCancel();
+    // the thread holds the text cache's lock for at most one page
+    textIndexThread->Join();
+    delete textIndexThread;
+    textIndexThread = nullptr;
+}
+
+/* Computes the content box of every page on the thread pool, so that the
+   first switch to fit-content zoom (which needs all of them) doesn't have
+   to interpret page after page with a bbox device. The boxes are persisted
+   next to the text index and restored on the next open of the document. */
+void DisplayModel::StartContentBoxSweep() {
+    CrashIf(contentBoxSweepTask);
+    int nPages = PageCount();
+    if (nPages <= 0) {
+        return;
+    }
+    contentBoxes = AllocArray<RectF>(nPages);
+    contentBoxDone = AllocArray<LONG>(nPages);
+    contentBoxSweepTask = GetThreadPool()->Submit(
+        [this, nPages] {
+            const WCHAR* filePath = engine->FileName();
+            bool useCache = gGlobalPrefs->enableTextIndexCache && filePath != nullptr;
+            if (useCache && LoadContentBoxCache(filePath, nPages, contentBoxes)) {
+                for (int i = 0; i < nPages; i++) {
+                    InterlockedExchange(&contentBoxDone[i], 1);
+                }
+                return;
+            }
+            for (int i = 0; i < nPages; i++) {
+                if (dontRenderFlag) {
+                    // the document is being closed; don't persist a
+                    // partial sweep
+                    return;
+                }
+                contentBoxes[i] = engine->PageContentBox(i + 1);
+                InterlockedExchange(&contentBoxDone[i], 1);
+            }
+            if (useCache) {
+                SaveContentBoxCache(filePath, nPages, contentBoxes);
+            }
+        },
+        TaskPriority::Prefetch);
+}
+
+// returns the page's content box, preferring what the background sweep
+// has already computed over a blocking PageContentBox call
+RectF DisplayModel::CachedPageContentBox(int pageNo) const {
+    if (contentBoxDone && InterlockedAdd(&contentBoxDone[pageNo - 1], 0)) {
+        return contentBoxes[pageNo - 1];
+    }
+    return engine->PageContentBox(pageNo);
+}
+
+bool DisplayModel::IsTocReady() {
+    return InterlockedAdd(&tocBuildDone, 0) > 0;
+}
+
+void DisplayModel::BuildTocAsync(const std::function<void()>& onBuilt) {
+    CrashIf(tocBuildTask);
+    if (tocBuildTask) {
+        return;
+    }
+    tocBuildTask = GetThreadPool()->Submit(
+        [this, onBuilt] {
+            engine->GetToc();
+            InterlockedIncrement(&tocBuildDone);
+            if (onBuilt) {
+                // onBuilt must not capture this DisplayModel: by the time
+                // the uitask runs, the document might have been closed
+                uitask::Post(onBuilt);
+            }
+        },
+        TaskPriority::Prefetch);
 }
 
 PageInfo* DisplayModel::GetPageInfo(int pageNo) const {
@@ -379,6 +723,8 @@ void DisplayModel::BuildPagesInfo() {
     CrashIf(pagesInfo);
     int pageCount = PageCount();
     pagesInfo = AllocArray<PageInfo>(pageCount);
+    pageTops = AllocArray<int>(pageCount);
+    pageBottoms = AllocArray<int>(pageCount);
 
     RectF defaultRect;
     float fileDPI = engine->GetFileDPI();
@@ -495,7 +841,7 @@ float DisplayModel::ZoomRealFromVirtualForPage(float zoomVirtual, int pageNo) co
         for (int i = first; i <= last; i++) {
             PageInfo* pageInfo = GetPageInfo(i);
             if (pageInfo->contentBox.IsEmpty()) {
-                pageInfo->contentBox = engine->PageContentBox(i);
+                pageInfo->contentBox = CachedPageContentBox(i);
             }
 
             RectF pageBox = engine->Transform(pageInfo->page, i, 1.0, rotation);
@@ -540,7 +886,11 @@ int DisplayModel::FirstVisiblePageNo() const {
         return INVALID_PAGE_NO;
     }
 
-    for (int pageNo = 1; pageNo <= PageCount(); ++pageNo) {
+    // only pages within the band calculated by RecalcVisibleParts() can
+    // have a non-zero visibleRatio
+    int first = visibleBandValid ? visibleBandFirst : 1;
+    int last = visibleBandValid ? visibleBandLast : PageCount();
+    for (int pageNo = first; pageNo <= last; ++pageNo) {
         PageInfo* pageInfo = GetPageInfo(pageNo);
         if (pageInfo->visibleRatio > 0.0) {
             return pageNo;
@@ -566,7 +916,9 @@ int DisplayModel::CurrentPageNo() const {
     int mostVisiblePage = INVALID_PAGE_NO;
     float ratio = 0;
 
-    for (int pageNo = 1; pageNo <= PageCount(); pageNo++) {
+    int first = visibleBandValid ? visibleBandFirst : 1;
+    int last = visibleBandValid ? visibleBandLast : PageCount();
+    for (int pageNo = first; pageNo <= last; pageNo++) {
         PageInfo* pageInfo = GetPageInfo(pageNo);
         if (pageInfo->visibleRatio > ratio) {
             mostVisiblePage = pageNo;
@@ -660,6 +1012,12 @@ void DisplayModel::Relayout(float newZoomVirtual, int newRotation) {
     if (!pagesInfo) {
         return;
     }
+    ScopedTraceEvent trc("relayout", PageCount());
+
+    // queued render requests were made for the previous layout; bumping
+    // the generation lets RenderCache drop them unstarted (see
+    // RenderCache::GetNextRequest)
+    InterlockedIncrement(&renderGeneration);
 
     rotation = NormalizeRotation(newRotation);
 
@@ -667,6 +1025,15 @@ void DisplayModel::Relayout(float newZoomVirtual, int newRotation) {
     bool needVScroll = false;
     viewPort = Rect(viewPort.TL(), totalViewPortSize);
 
+    /* most documents have runs of equal-sized pages (usually all of them),
+       so remember the last transformed page size and only go through the
+       engine in PageSizeAfterRotation() when the mediabox or zoom changes.
+       This keeps the cost of zooming mostly independent of page count */
+    RectF lastPageRect;
+    float lastZoom = INVALID_ZOOM;
+    int lastPosDx = 0;
+    int lastPosDy = 0;
+
 RestartLayout:
     int currPosY = windowMargin.top;
     float currZoomReal = zoomReal;
@@ -690,12 +1057,21 @@ RestartLayout:
             CrashIf(0.0 != pageInfo->visibleRatio);
             continue;
         }
-        SizeF pageSize = PageSizeAfterRotation(pageNo);
         Rect pos;
-        // don't add the full 0.5 for rounding to account for precision errors
         float zoom = GetZoomReal(pageNo);
-        pos.dx = (int)(pageSize.dx * zoom + 0.499);
-        pos.dy = (int)(pageSize.dy * zoom + 0.499);
+        if (pageInfo->page == lastPageRect && zoom == lastZoom) {
+            pos.dx = lastPosDx;
+            pos.dy = lastPosDy;
+        } else {
+            SizeF pageSize = PageSizeAfterRotation(pageNo);
+            // don't add the full 0.5 for rounding to account for precision errors
+            pos.dx = (int)(pageSize.dx * zoom + 0.499);
+            pos.dy = (int)(pageSize.dy * zoom + 0.499);
+            lastPageRect = pageInfo->page;
+            lastZoom = zoom;
+            lastPosDx = pos.dx;
+            lastPosDy = pos.dy;
+        }
 
         if (rowMaxPageDy < pos.dy) {
             rowMaxPageDy = pos.dy;
@@ -848,6 +1224,24 @@ RestartLayout:
     }
 
     canvasSize = Size(std::max(canvasDx, viewPort.dx), std::max(canvasDy, viewPort.dy));
+
+    /* refresh the packed vertical extents used by RecalcVisibleParts();
+       pages that aren't shown inherit their predecessor's extent so that
+       both arrays stay sorted */
+    int prevTop = 0;
+    int prevBottom = 0;
+    for (int pageNo = 1; pageNo <= PageCount(); ++pageNo) {
+        PageInfo* pageInfo = &(pagesInfo[pageNo - 1]);
+        if (pageInfo->shown) {
+            prevTop = pageInfo->pos.y;
+            prevBottom = pageInfo->pos.y + pageInfo->pos.dy;
+        }
+        pageTops[pageNo - 1] = prevTop;
+        pageBottoms[pageNo - 1] = prevBottom;
+    }
+    // any page might have changed position or visibility; until the next
+    // RecalcVisibleParts() the band can't be trusted
+    visibleBandValid = false;
 }
 
 void DisplayModel::ChangeStartPage(int newStartPage) {
@@ -883,9 +1277,48 @@ void DisplayModel::RecalcVisibleParts() {
     if (!pagesInfo) {
         return;
     }
+    int nPages = PageCount();
 
-    for (int pageNo = 1; pageNo <= PageCount(); ++pageNo) {
-        PageInfo* pageInfo = GetPageInfo(pageNo);
+    // refresh every page's screen position and reset its visibility.
+    // The walk is cheap (two subtractions per page); doing all PageInfo
+    // writes here, on the UI thread, means the render workers can keep
+    // reading PageInfos concurrently without racing a lazily refreshing
+    // getter
+    for (int pageNo = 1; pageNo <= nPages; ++pageNo) {
+        PageInfo* pageInfo = &(pagesInfo[pageNo - 1]);
+        pageInfo->visibleRatio = 0.0;
+        pageInfo->pageOnScreen = pageInfo->pos;
+        pageInfo->pageOnScreen.Offset(-viewPort.x, -viewPort.y);
+    }
+
+    // find the run of pages whose vertical extent can intersect the
+    // viewport; both arrays are sorted (see Relayout()), so two binary
+    // searches over packed ints replace a walk over all PageInfos
+    int lo = 0;
+    int hi = nPages;
+    while (lo < hi) { // first page ending below the viewport's top
+        int mid = (lo + hi) / 2;
+        if (pageBottoms[mid] <= viewPort.y) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    visibleBandFirst = lo + 1;
+    hi = nPages;
+    while (lo < hi) { // first page starting below the viewport's bottom
+        int mid = (lo + hi) / 2;
+        if (pageTops[mid] < viewPort.y + viewPort.dy) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    visibleBandLast = lo;
+    visibleBandValid = true;
+
+    for (int pageNo = visibleBandFirst; pageNo <= visibleBandLast; ++pageNo) {
+        PageInfo* pageInfo = &(pagesInfo[pageNo - 1]);
         if (!pageInfo->shown) {
             CrashIf(0.0 != pageInfo->visibleRatio);
             continue;
@@ -893,15 +1326,11 @@ void DisplayModel::RecalcVisibleParts() {
 
         Rect pageRect = pageInfo->pos;
         Rect visiblePart = pageRect.Intersect(viewPort);
-
-        pageInfo->visibleRatio = 0.0;
         if (!visiblePart.IsEmpty()) {
             CrashIf(pageRect.dx <= 0 || pageRect.dy <= 0);
             // calculate with floating point precision to prevent an integer overflow
             pageInfo->visibleRatio = 1.0f * visiblePart.dx * visiblePart.dy / ((float)pageRect.dx * pageRect.dy);
         }
-        pageInfo->pageOnScreen = pageRect;
-        pageInfo->pageOnScreen.Offset(-viewPort.x, -viewPort.y);
     }
 }
 
@@ -1067,7 +1496,9 @@ void DisplayModel::RenderVisibleParts() {
     int firstVisiblePage = 0;
     int lastVisiblePage = 0;
 
-    for (int pageNo = 1; pageNo <= PageCount(); ++pageNo) {
+    int first = visibleBandValid ? visibleBandFirst : 1;
+    int last = visibleBandValid ? visibleBandLast : PageCount();
+    for (int pageNo = first; pageNo <= last; ++pageNo) {
         PageInfo* pageInfo = GetPageInfo(pageNo);
         if (pageInfo->visibleRatio > 0.0) {
             CrashIf(!pageInfo->shown);
@@ -1090,7 +1521,10 @@ void DisplayModel::RenderVisibleParts() {
         cb->RequestRendering(pageNo);
     }
 
-    if (gPredictiveRender) {
+    // rendering ahead trades CPU (and thus battery) for latency, so it's
+    // also off while power saving
+    bool predictiveRender = gPredictiveRender && GetMemoryPolicy().allowPrefetch && !IsPowerSavingActive();
+    if (predictiveRender) {
         // prerender two more pages in facing and book view modes
         // if the rendering queue still has place for them
         if (!IsSingle(GetDisplayMode())) {
@@ -1109,6 +1543,34 @@ void DisplayModel::RenderVisibleParts() {
         }
     }
 
+    // when the user is fling-scrolling, also request the next pages in
+    // the direction of travel so that each screenful is already rendered
+    // by the time it comes into view
+    if (predictiveRender && scrollDirection != 0 && scrollVelocity >= PREFETCH_MIN_VELOCITY) {
+        // the faster the scroll, the further ahead we reach
+        int n = limitValue(1 + (int)(scrollVelocity / PREFETCH_MIN_VELOCITY), 1, MAX_PREFETCH_PAGES);
+        for (int i = 1; i <= n; i++) {
+            int pageNo = scrollDirection > 0 ? lastVisiblePage + i : firstVisiblePage - i;
+            if (ValidPageNo(pageNo)) {
+                cb->RequestRendering(pageNo);
+            }
+        }
+    }
+
+    // while presenting, the previous and next slides are always kept
+    // rendered (each at its own fit-page resolution) so that advancing
+    // is a pure blit even on displays where a render takes a visible
+    // beat. Requested after the generic prediction so they sit above it
+    // in the LIFO queue, right below the visible slide
+    if (presentationMode) {
+        if (firstVisiblePage > 1) {
+            cb->RequestRendering(firstVisiblePage - 1);
+        }
+        if (lastVisiblePage < PageCount()) {
+            cb->RequestRendering(lastVisiblePage + 1);
+        }
+    }
+
     // request the visible pages last so that the above requested
     // invisible pages are not rendered if the queue fills up
     for (int pageNo = lastVisiblePage; pageNo >= firstVisiblePage; pageNo--) {
@@ -1116,6 +1578,38 @@ void DisplayModel::RenderVisibleParts() {
     }
 }
 
+/* Called whenever the viewport is about to move vertically by dy screen
+   pixels. Derives the direction and speed of travel for predictive page
+   rendering. The state resets after a pause and on reversal, so that a
+   single slow scroll doesn't trigger prefetching; on reversal the queued
+   prefetches point the wrong way and are cancelled. */
+void DisplayModel::UpdateScrollVelocity(int dy) {
+    if (0 == dy) {
+        return;
+    }
+    DWORD now = GetTickCount();
+    DWORD elapsedMs = now - lastScrollTimestamp;
+    lastScrollTimestamp = now;
+
+    int dir = dy > 0 ? 1 : -1;
+    if (dir != scrollDirection || elapsedMs > 500) {
+        if (scrollDirection != 0 && dir != scrollDirection) {
+            cb->CancelQueuedRendering();
+        }
+        scrollDirection = dir;
+        scrollVelocity = 0.f;
+        return;
+    }
+
+    if (0 == elapsedMs) {
+        elapsedMs = 1;
+    }
+    float v = (float)abs(dy) / (float)elapsedMs;
+    // exponential smoothing so that a single large jump (e.g. dragging
+    // the scrollbar thumb) doesn't count as a fling
+    scrollVelocity = 0.5f * scrollVelocity + 0.5f * v;
+}
+
 void DisplayModel::SetViewPortSize(Size newViewPortSize) {
     ScrollState ss;
 
@@ -1146,7 +1640,7 @@ RectF DisplayModel::GetContentBox(int pageNo) {
     // we cache the contentBox
     PageInfo* pageInfo = GetPageInfo(pageNo);
     if (pageInfo->contentBox.IsEmpty()) {
-        pageInfo->contentBox = engine->PageContentBox(pageNo);
+        pageInfo->contentBox = CachedPageContentBox(pageNo);
     }
     cbox = pageInfo->contentBox;
     float zoom = pageInfo->zoomReal;
@@ -1411,7 +1905,7 @@ void DisplayModel::ScrollXTo(int xOff) {
     if (CurrentPageNo() != currPageNo) {
         cb->PageNoChanged(this, CurrentPageNo());
     }
-    RepaintDisplay();
+    RepaintForScroll();
 }
 
 void DisplayModel::ScrollXBy(int dx) {
@@ -1423,6 +1917,7 @@ void DisplayModel::ScrollXBy(int dx) {
 
 void DisplayModel::ScrollYTo(int yOff) {
     int currPageNo = CurrentPageNo();
+    UpdateScrollVelocity(yOff - viewPort.y);
     viewPort.y = yOff;
     RecalcVisibleParts();
     RenderVisibleParts();
@@ -1431,7 +1926,7 @@ void DisplayModel::ScrollYTo(int yOff) {
     if (newPageNo != currPageNo) {
         cb->PageNoChanged(this, newPageNo);
     }
-    RepaintDisplay();
+    RepaintForScroll();
 }
 
 /* Scroll the doc in y-axis by 'dy'. If 'changePage' is TRUE, automatically
@@ -1481,6 +1976,7 @@ void DisplayModel::ScrollYBy(int dy, bool changePage) {
     }
 
     currPageNo = CurrentPageNo();
+    UpdateScrollVelocity(newYOff - viewPort.y);
     viewPort.y = newYOff;
     RecalcVisibleParts();
     RenderVisibleParts();
@@ -1549,8 +2045,15 @@ float DisplayModel::GetZoomVirtual(bool absolute) const {
 }
 
 float DisplayModel::GetNextZoomStep(float towardsLevel) const {
+    return GetNextZoomStep(towardsLevel, GetZoomVirtual(true));
+}
+
+// like GetNextZoomStep, but with an explicit starting level; needed when an
+// animated zoom is still in flight and the next step has to be taken from
+// its target rather than from the currently displayed intermediate zoom
+float DisplayModel::GetNextZoomStep(float towardsLevel, float fromZoom) const {
     if (gGlobalPrefs->zoomIncrement > 0) {
-        float zoom = GetZoomVirtual(true);
+        float zoom = fromZoom;
         if (zoom < towardsLevel) {
             return std::min(zoom * (gGlobalPrefs->zoomIncrement / 100 + 1), towardsLevel);
         }
@@ -1575,7 +2078,7 @@ float DisplayModel::GetNextZoomStep(float towardsLevel) const {
     CrashIf(nZooms != 0 && (zoomLevels->at(0) < ZOOM_MIN || zoomLevels->Last() > ZOOM_MAX));
     CrashIf(nZooms != 0 && zoomLevels->at(0) > zoomLevels->Last());
 
-    float currZoom = GetZoomVirtual(true);
+    float currZoom = fromZoom;
     if (currZoom == towardsLevel) {
         return towardsLevel;
     }
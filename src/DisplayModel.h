@@ -24,7 +24,8 @@ struct PageInfo {
 
     /* data that changes due to scrolling. Calculated in DisplayModel::RecalcVisibleParts() */
     float visibleRatio; /* (0.0 = invisible, 1.0 = fully visible) */
-    /* position of page relative to visible view port: pos.Offset(-viewPort.x, -viewPort.y) */
+    /* position of page relative to visible view port: pos.Offset(-viewPort.x, -viewPort.y).
+       Derived data, refreshed by DisplayModel::RecalcVisibleParts() */
     Rect pageOnScreen{};
 
     // when zoomVirtual in DisplayMode is ZOOM_FIT_PAGE, ZOOM_FIT_WIDTH
@@ -48,7 +49,9 @@ struct DocumentTextCache;
 struct TextSelection;
 class TextSearch;
 struct TextSel;
+class TextIndexThread;
 class Synchronizer;
+struct TaskHandle;
 
 // TODO: in hindsight, zoomVirtual is not a good name since it's either
 // virtual zoom level OR physical zoom level. Would be good to find
@@ -59,7 +62,10 @@ class Synchronizer;
    All the display changes should be done through changing this model via
    API and re-displaying things based on new display information */
 struct DisplayModel : public Controller {
-    DisplayModel(EngineBase* engine, ControllerCallback* cb);
+    // sharedTextCache is for views over a shared engine (see
+    // OnDuplicateInNewWindow): the new model adds a ref instead of
+    // extracting the document's text a second time
+    DisplayModel(EngineBase* engine, ControllerCallback* cb, DocumentTextCache* sharedTextCache = nullptr);
     DisplayModel(DisplayModel const&) = delete;
     DisplayModel& operator=(DisplayModel const&) = delete;
 
@@ -84,6 +90,7 @@ struct DisplayModel : public Controller {
     void SetZoomVirtual(float zoom, Point* fixPt) override;
     float GetZoomVirtual(bool absolute = false) const override;
     float GetNextZoomStep(float towards) const override;
+    float GetNextZoomStep(float towards, float fromZoom) const;
     void SetViewPortSize(Size size) override;
 
     // table of contents
@@ -114,6 +121,11 @@ struct DisplayModel : public Controller {
 
     EngineBase* GetEngine() const;
     Kind GetEngineType() const;
+    // replaces an engine shared with other views of the same document
+    // by a private clone, so that modifications (annotations) stay out
+    // of the other views (see EnsureExclusiveEngine in SumatraPDF.cpp);
+    // no-op if the engine isn't shared
+    bool UnshareEngine();
 
     // controller-specific data (easier to save here than on WindowInfo)
     Kind engineType{nullptr};
@@ -124,6 +136,19 @@ struct DisplayModel : public Controller {
     TextSelection* textSelection{nullptr};
     // access only from Search thread
     TextSearch* textSearch{nullptr};
+    // fills textCache in the background after document load
+    TextIndexThread* textIndexThread{nullptr};
+
+    // builds the engine's TOC tree in the background (see BuildTocAsync)
+    TaskHandle* tocBuildTask{nullptr};
+    LONG tocBuildDone{0};
+
+    // per-page content boxes computed by the background sweep started at
+    // load; contentBoxes[i] is only valid once contentBoxDone[i] is set
+    // (see StartContentBoxSweep)
+    RectF* contentBoxes{nullptr};
+    LONG* contentBoxDone{nullptr};
+    TaskHandle* contentBoxSweepTask{nullptr};
 
     PageInfo* GetPageInfo(int pageNo) const;
 
@@ -132,6 +157,12 @@ struct DisplayModel : public Controller {
     float GetZoomReal(int pageNo) const;
     void Relayout(float zoomVirtual, int rotation);
 
+    // bumped by every Relayout; render requests are tagged with it so that
+    // RenderCache can drop queued renders whose zoom or rotation predate
+    // the current layout (e.g. intermediate levels of a rapid Ctrl+wheel
+    // zoom) instead of rendering them before the final level
+    LONG renderGeneration{0};
+
     Rect GetViewPort() const;
     bool IsHScrollbarVisible() const;
     bool IsVScrollbarVisible() const;
@@ -150,6 +181,12 @@ struct DisplayModel : public Controller {
     void ScrollXBy(int dx);
     void ScrollYTo(int yOff);
     void ScrollYBy(int dy, bool changePage);
+    // tracks recent scroll direction and speed so that RenderVisibleParts
+    // can prefetch pages in the direction of travel during fast scrolling
+    void UpdateScrollVelocity(int dy);
+    int scrollDirection = 0;    // 1 when scrolling down, -1 up, 0 when idle
+    float scrollVelocity = 0.f; // pixels per ms in the travel direction
+    DWORD lastScrollTimestamp = 0;
     /* a "virtual" zoom level. Can be either a real zoom level in percent
        (i.e. 100.0 is original size) or one of virtual values ZOOM_FIT_PAGE,
        ZOOM_FIT_WIDTH or ZOOM_FIT_CONTENT, whose real value depends on draw area size */
@@ -180,6 +217,30 @@ struct DisplayModel : public Controller {
     bool ShouldCacheRendering(int pageNo);
     // called when we decide that the display needs to be redrawn
     void RepaintDisplay();
+    // like RepaintDisplay, but for pure scrolls, which don't change what is
+    // drawn, just where on the canvas (lets the canvas shift the already
+    // painted pixels, see DrawScrolledDocument in Canvas.cpp)
+    void RepaintForScroll();
+    // incremented whenever a repaint is requested for any other reason than
+    // scrolling
+    int repaintRev = 0;
+
+    // background extraction of the document's text into textCache,
+    // so that a first search doesn't start from a cold cache
+    void StartTextIndexing();
+    void StopTextIndexing();
+
+    // computes every page's content box on the thread pool (persisted per
+    // document like the text index), so that switching to fit-content zoom
+    // or trimming margins doesn't interpret each page on first use
+    void StartContentBoxSweep();
+    RectF CachedPageContentBox(int pageNo) const;
+
+    // builds the TOC tree on the thread pool and calls onBuilt (as a
+    // uitask) when it's ready, so that a document with a huge outline
+    // paints and responds before the sidebar is filled
+    void BuildTocAsync(const std::function<void()>& onBuilt);
+    bool IsTocReady();
 
     /* allow resizing a window without triggering a new rendering (needed for window destruction) */
     bool dontRenderFlag = false;
@@ -205,6 +266,18 @@ struct DisplayModel : public Controller {
     /* an array of PageInfo, len of array is pageCount */
     PageInfo* pagesInfo{nullptr};
 
+    /* packed copies of the pages' vertical extents (pos.y resp.
+       pos.y + pos.dy), rebuilt by Relayout(). Visibility determination
+       binary-searches these instead of walking the fat PageInfo array,
+       which matters when scrolling a many-thousand-page document */
+    int* pageTops{nullptr};
+    int* pageBottoms{nullptr};
+    /* pages outside this range are known to have visibleRatio == 0.0;
+       updated by RecalcVisibleParts(), invalidated by Relayout() */
+    int visibleBandFirst{0};
+    int visibleBandLast{0};
+    bool visibleBandValid{false};
+
     DisplayMode displayMode{DisplayMode::Automatic};
     /* In non-continuous mode is the first page from a file that we're
        displaying.
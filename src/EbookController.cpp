@@ -31,6 +31,7 @@
 #include "GlobalPrefs.h"
 
 #include "EbookControls.h"
+#include "EbookLayoutCache.h"
 #include "Translations.h"
 
 static const WCHAR* GetFontName() {
@@ -260,6 +261,9 @@ void EbookController::CloseCurrentDocument() {
     ctrls->pagesLayout->GetPage2()->SetPage(nullptr);
     StopFormattingThread();
     DeletePages(&pages);
+    DeletePages(&previewPages);
+    // pending decodes read the document's image data
+    DropDecodedHtmlImages();
     doc.Delete();
     pageSize = Size(0, 0);
 }
@@ -321,6 +325,9 @@ void EbookController::HandlePagesFromEbookLayout(EbookFormattingData* ft) {
             incomingPages = nullptr;
             DeletePages(&toDelete);
             GoToPage(pageNo, false);
+            // the formatting thread caught up with the preview page
+            // shown from the layout cache, it's no longer needed
+            DeletePages(&previewPages);
         }
     } else {
         CrashIf(!pages);
@@ -332,6 +339,7 @@ void EbookController::HandlePagesFromEbookLayout(EbookFormattingData* ft) {
     if (ft->finished) {
         CrashIf(!pages);
         StopFormattingThread();
+        SaveLayoutToCache();
     }
     UpdateStatus();
     // don't call DeleteEbookFormattingData since
@@ -339,6 +347,70 @@ void EbookController::HandlePagesFromEbookLayout(EbookFormattingData* ft) {
     delete ft;
 }
 
+// format just the page(s) starting at reparseIdx and display them right
+// away, without waiting for the formatting thread to get there. The thread
+// still re-formats the whole book and its pages replace ours on promotion.
+// pass pageNo == 0 if the page number under the new layout isn't known yet
+bool EbookController::ShowPreviewPage(Size size, int reparseIdx, int pageNo) {
+    HtmlFormatterArgs* args = CreateFormatterArgsDoc(doc, size.dx, size.dy, &textAllocator);
+    args->reparseIdx = reparseIdx;
+    HtmlFormatter* formatter = doc.CreateFormatter(args);
+    HtmlPage* p1 = formatter->Next();
+    HtmlPage* p2 = IsDoublePage() ? formatter->Next() : nullptr;
+    delete formatter;
+    delete args;
+    if (!p1) {
+        delete p2;
+        return false;
+    }
+    // don't delete the previous preview until the controls no longer show it
+    Vec<HtmlPage*>* toDelete = previewPages;
+    previewPages = new Vec<HtmlPage*>();
+    previewPages->Append(p1);
+    if (p2) {
+        previewPages->Append(p2);
+    }
+    if (pageNo > 0) {
+        currPageNo = pageNo;
+    }
+    ctrls->pagesLayout->GetPage1()->SetPage(p1);
+    ctrls->pagesLayout->GetPage2()->SetPage(p2);
+    DeletePages(&toDelete);
+    return true;
+}
+
+// if the pagination for this document was cached for the same layout key
+// (font, font size, page dimensions), show the page at the saved reading
+// position without waiting for the book to reformat from the beginning
+bool EbookController::TryShowCachedPage(Size size) {
+    EbookLayoutKey key = {GetFontName(), GetFontSize(), size.dx, size.dy};
+    Vec<int> pageBreaks;
+    if (!LoadEbookLayout(doc.GetFilePath(), key, pageBreaks)) {
+        return false;
+    }
+    // find the page containing currPageReparseIdx
+    int pageIdx = 0;
+    for (int i = 0; i < pageBreaks.isize(); i++) {
+        if (pageBreaks.at(i) > currPageReparseIdx) {
+            break;
+        }
+        pageIdx = i;
+    }
+    return ShowPreviewPage(size, pageBreaks.at(pageIdx), pageIdx + 1);
+}
+
+void EbookController::SaveLayoutToCache() {
+    if (!pages || pageSize.IsEmpty()) {
+        return;
+    }
+    EbookLayoutKey key = {GetFontName(), GetFontSize(), pageSize.dx, pageSize.dy};
+    Vec<int> pageBreaks;
+    for (HtmlPage* p : *pages) {
+        pageBreaks.Append(p->reparseIdx);
+    }
+    SaveEbookLayout(doc.GetFilePath(), key, pageBreaks);
+}
+
 void EbookController::TriggerLayout() {
     Size s = ctrls->pagesLayout->GetPage1()->GetDrawableSize();
     Size size(s.dx, s.dy);
@@ -361,6 +433,18 @@ void EbookController::TriggerLayout() {
     pageSize = size; // set it early to prevent re-doing layout at the same size
 
     StopFormattingThread();
+
+    // show the page at the current reading position before kicking off the
+    // full reformat, which can take many seconds for a large book. Must
+    // happen while no thread is running (textAllocator is shared)
+    if (!pages && !previewPages) {
+        TryShowCachedPage(size);
+    } else {
+        // reflow after a resize: the old page break at currPageReparseIdx is
+        // a good enough starting point until the exact pagination arrives
+        ShowPreviewPage(size, currPageReparseIdx, 0);
+    }
+
     CrashIf(incomingPages);
     incomingPages = new Vec<HtmlPage*>(1024);
 
@@ -110,6 +110,11 @@ struct EbookController : Controller {
     // pages being sent from background formatting thread
     Vec<HtmlPage*>* incomingPages = nullptr;
 
+    // page(s) at the current reading position, formatted synchronously
+    // (from the persisted pagination on reopen or from the old pagination
+    // on reflow) and shown before the formatting thread catches up
+    Vec<HtmlPage*>* previewPages = nullptr;
+
     // currPageNo is in range 1..$numberOfPages.
     int currPageNo = 0;
     // reparseIdx of the current page (the first one if we're showing 2)
@@ -141,6 +146,9 @@ struct EbookController : Controller {
     int GetMaxPageCount() const;
     bool IsDoublePage() const;
     void ExtractPageAnchors();
+    bool ShowPreviewPage(Size size, int reparseIdx, int pageNo);
+    bool TryShowCachedPage(Size size);
+    void SaveLayoutToCache();
     void AddNavPoint();
     void OnClickedLink(int pageNo, DrawInstr* link);
 
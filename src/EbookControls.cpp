@@ -244,7 +244,8 @@ void PageControl::Paint(Graphics* gfx, int offX, int offY) {
     textRender->SetTextBgColor(bgColor);
 
     auto timerDrawHtml = TimeGet();
-    DrawHtmlPage(gfx, textRender, &page->instructions, (float)r.X, (float)r.Y, IsDebugPaint(), textColor);
+    DrawHtmlPage(gfx, textRender, &page->instructions, (float)r.X, (float)r.Y, IsDebugPaint(), textColor, nullptr,
+                 GetHwndParent(this));
     double durDraw = TimeSinceInMs(timerDrawHtml);
     gfx->SetClip(&origClipRegion, CombineModeReplace);
     delete textRender;
@@ -9,6 +9,7 @@
 #include "utils/HtmlParserLookup.h"
 #include "utils/HtmlPullParser.h"
 #include "utils/PalmDbReader.h"
+#include "utils/ThreadUtil.h"
 #include "utils/TrivialHtmlParser.h"
 #include "utils/WinUtil.h"
 #include "utils/ScopedWin.h"
@@ -320,6 +321,68 @@ static bool isImageMediaType(const WCHAR* mediatype) {
     return str::Eq(mediatype, L"image/png") || str::Eq(mediatype, L"image/jpeg") || str::Eq(mediatype, L"image/gif");
 }
 
+// extracts and decodes the spine chapters a worker claims via nextChapterIdx.
+// every worker opens its own archive handle since MultiFormatArchive isn't
+// safe for concurrent use; workers only ever write to their claimed slots
+static void LoadChaptersWorker(const WCHAR* zipPath, WStrVec* chapterPaths, Vec<char*>* chapterHtml,
+                               LONG* nextChapterIdx) {
+    MultiFormatArchive* zip = OpenZipArchive(zipPath, true);
+    if (!zip) {
+        // the chapters this worker would have claimed are picked
+        // up by the serial fallback in LoadSpineChapters
+        return;
+    }
+    int nChapters = chapterPaths->isize();
+    for (;;) {
+        int i = (int)InterlockedIncrement(nextChapterIdx) - 1;
+        if (i >= nChapters) {
+            break;
+        }
+        AutoFree html = zip->GetFileDataByName(chapterPaths->at(i));
+        if (!html.data) {
+            continue;
+        }
+        chapterHtml->at(i) = DecodeTextToUtf8(html.data, true);
+    }
+    delete zip;
+}
+
+// chapter files inside an EPUB are compressed independently, so when loading
+// from a file on disk they're extracted and decoded on the thread pool.
+// stream-based documents (whose archive can't be re-opened per worker) and
+// chapters left behind by a failed worker are loaded serially
+static void LoadSpineChapters(MultiFormatArchive* zip, const WCHAR* zipPath, WStrVec& chapterPaths,
+                              Vec<char*>& chapterHtml) {
+    int nChapters = chapterPaths.isize();
+    if (zipPath && nChapters > 1) {
+        ThreadPool* pool = GetThreadPool();
+        int nWorkers = std::min(nChapters, pool->threadCount);
+        LONG nextChapterIdx = 0;
+        WStrVec* pathsPtr = &chapterPaths;
+        Vec<char*>* htmlPtr = &chapterHtml;
+        LONG* idxPtr = &nextChapterIdx;
+        Vec<TaskHandle*> tasks;
+        for (int i = 0; i < nWorkers; i++) {
+            auto fn = [zipPath, pathsPtr, htmlPtr, idxPtr] { LoadChaptersWorker(zipPath, pathsPtr, htmlPtr, idxPtr); };
+            tasks.Append(pool->Submit(fn, TaskPriority::Interactive));
+        }
+        for (TaskHandle* task : tasks) {
+            task->Wait();
+            DropTaskHandle(task);
+        }
+    }
+    for (int i = 0; i < nChapters; i++) {
+        if (chapterHtml.at(i)) {
+            continue;
+        }
+        AutoFree html = zip->GetFileDataByName(chapterPaths.at(i));
+        if (!html.data) {
+            continue;
+        }
+        chapterHtml.at(i) = DecodeTextToUtf8(html.data, true);
+    }
+}
+
 bool EpubDoc::Load() {
     if (!zip) {
         return false;
@@ -452,19 +515,28 @@ bool EpubDoc::Load() {
         }
 
         const WCHAR* fileName = pathList.at(idList.Find(idref));
-        AutoFreeWstr fullPath = str::Join(contentPath, fileName);
-        AutoFree html = zip->GetFileDataByName(fullPath);
-        if (!html.data) {
-            continue;
-        }
-        char* decoded = DecodeTextToUtf8(html.data, true);
-        html.TakeOwnershipOf(decoded);
+        spinePaths.Append(str::Join(contentPath, fileName));
+    }
+
+    if (lazySpine) {
+        // chapters are extracted one at a time through GetSpineItemHtml
+        // so that e.g. the IFilter doesn't hold the entire book in memory
+        return spinePaths.size() > 0;
+    }
+
+    Vec<char*> chapterHtml;
+    chapterHtml.AppendBlanks(spinePaths.size());
+    LoadSpineChapters(zip, this->fileName, spinePaths, chapterHtml);
+
+    // assemble in spine order
+    for (int i = 0; i < spinePaths.isize(); i++) {
+        AutoFree html(chapterHtml.at(i));
         if (!html.data) {
             continue;
         }
         // insert explicit page-breaks between sections including
         // an anchor with the file name at the top (for internal links)
-        AutoFree utf8_path = strconv::WstrToUtf8(fullPath);
+        AutoFree utf8_path = strconv::WstrToUtf8(spinePaths.at(i));
         DebugCrashIf(str::FindChar(utf8_path.Get(), '"'));
         str::TransChars(utf8_path.Get(), "\"", "'");
         htmlData.AppendFmt("<pagebreak page_path=\"%s\" page_marker />", utf8_path.Get());
@@ -474,6 +546,23 @@ bool EpubDoc::Load() {
     return htmlData.size() > 0;
 }
 
+int EpubDoc::SpineCount() const {
+    return spinePaths.isize();
+}
+
+char* EpubDoc::GetSpineItemHtml(int idx) {
+    CrashIf(idx < 0 || idx >= spinePaths.isize());
+    AutoFree html;
+    {
+        ScopedCritSec scope(&zipAccess);
+        html.Set(zip->GetFileDataByName(spinePaths.at(idx)));
+    }
+    if (!html.data) {
+        return nullptr;
+    }
+    return DecodeTextToUtf8(html.data, true);
+}
+
 void EpubDoc::ParseMetadata(const char* content) {
     struct {
         DocumentProperty prop;
@@ -754,9 +843,10 @@ EpubDoc* EpubDoc::CreateFromFile(const WCHAR* path) {
     return doc;
 }
 
-EpubDoc* EpubDoc::CreateFromStream(IStream* stream) {
+EpubDoc* EpubDoc::CreateFromStream(IStream* stream, bool lazySpine) {
     EpubDoc* doc = new EpubDoc(stream);
-    if (!doc || !doc->Load()) {
+    doc->lazySpine = lazySpine;
+    if (!doc->Load()) {
         delete doc;
         return nullptr;
     }
@@ -26,11 +26,15 @@ class EpubDoc {
 
     str::Str htmlData;
     Vec<ImageData2> images;
+    WStrVec spinePaths;
     AutoFreeWstr tocPath;
     AutoFreeWstr fileName;
     PropertyMap props;
     bool isNcxToc = false;
     bool isRtlDoc = false;
+    // when set, Load() only collects spinePaths and doesn't assemble
+    // htmlData; chapters are extracted on demand via GetSpineItemHtml
+    bool lazySpine = false;
 
     bool Load();
     void ParseMetadata(const char* content);
@@ -44,6 +48,11 @@ class EpubDoc {
 
     std::span<u8> GetHtmlData() const;
 
+    // one chapter at a time access for lazy-spine documents (see CEpubFilter);
+    // the returned UTF-8 data is owned by the caller
+    int SpineCount() const;
+    char* GetSpineItemHtml(int idx);
+
     ImageData* GetImageData(const char* fileName, const char* pagePath);
     std::span<u8> GetFileData(const char* relPath, const char* pagePath);
 
@@ -57,7 +66,7 @@ class EpubDoc {
     static bool IsSupportedFileType(Kind kind);
 
     static EpubDoc* CreateFromFile(const WCHAR* path);
-    static EpubDoc* CreateFromStream(IStream* stream);
+    static EpubDoc* CreateFromStream(IStream* stream, bool lazySpine = false);
 };
 
 /* ********** FictionBook (FB2) ********** */
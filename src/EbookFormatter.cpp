@@ -166,6 +166,7 @@ void EpubFormatter::HandleTagPagebreak(HtmlToken* t) {
         pagePath.Set(str::DupN(attr->val, attr->valLen));
         // reset CSS style rules for the new document
         styleRules.Reset();
+        styleRuleCache.Reset();
     }
 }
 
@@ -0,0 +1,127 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+#include "utils/FileUtil.h"
+#include "utils/WinUtil.h"
+
+#include "wingui/TreeModel.h"
+
+#include "Annotation.h"
+#include "EngineBase.h"
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "FileHistory.h"
+
+#include "AppTools.h"
+#include "FileThumbnails.h"
+#include "EbookLayoutCache.h"
+
+/* Formatting a large EPUB/MOBI through HtmlFormatter can take many seconds,
+   so the resulting pagination (the reparse index of each page break) is
+   persisted per document, keyed the same way as the thumbnail cache. On
+   reopen with an unchanged layout key the page at the saved reading position
+   can be formatted and shown immediately, without waiting for the book to
+   reformat from the beginning. */
+
+#define EBOOK_LAYOUT_DIR_NAME L"sumatrapdfcache"
+
+#define EBOOK_LAYOUT_MAGIC 0x4C455053 // 'SPEL'
+#define EBOOK_LAYOUT_VERSION 1
+
+struct EbookLayoutHeader {
+    u32 magic;
+    u32 version;
+    float fontSize;
+    i32 pageDx;
+    i32 pageDy;
+    FILETIME docModified; // invalidates the pagination when the document changes
+    i32 nPageBreaks;
+    u32 fontNameLen; // in WCHARs; the name follows the header, the page breaks follow the name
+};
+
+static WCHAR* GetEbookLayoutPath(const WCHAR* filePath) {
+    u8 digest[16];
+    if (!GetDocumentCacheKey(filePath, digest)) {
+        return nullptr;
+    }
+    AutoFree fingerPrint(_MemToHex(&digest));
+
+    AutoFreeWstr cachePath(AppGenDataFilename(EBOOK_LAYOUT_DIR_NAME));
+    if (!cachePath) {
+        return nullptr;
+    }
+    AutoFreeWstr fname(strconv::FromAnsi(fingerPrint));
+
+    return str::Format(L"%s\\%s.layout", cachePath.Get(), fname.Get());
+}
+
+bool LoadEbookLayout(const WCHAR* filePath, const EbookLayoutKey& key, Vec<int>& pageBreaksOut) {
+    AutoFreeWstr path(GetEbookLayoutPath(filePath));
+    if (!path) {
+        return false;
+    }
+    AutoFree data(file::ReadFile(path.Get()));
+    size_t len = data.size();
+    if (len < sizeof(EbookLayoutHeader)) {
+        return false;
+    }
+    EbookLayoutHeader* hdr = (EbookLayoutHeader*)data.Get();
+    if (hdr->magic != EBOOK_LAYOUT_MAGIC || hdr->version != EBOOK_LAYOUT_VERSION) {
+        return false;
+    }
+    if (hdr->fontSize != key.fontSize || hdr->pageDx != key.pageDx || hdr->pageDy != key.pageDy) {
+        return false;
+    }
+    size_t nameOff = sizeof(EbookLayoutHeader);
+    size_t breaksOff = nameOff + (size_t)hdr->fontNameLen * sizeof(WCHAR);
+    size_t end = breaksOff + (size_t)hdr->nPageBreaks * sizeof(i32);
+    if (hdr->nPageBreaks <= 0 || end > len) {
+        return false;
+    }
+    if (str::Len(key.fontName) != hdr->fontNameLen) {
+        return false;
+    }
+    const WCHAR* fontName = (const WCHAR*)(data.Get() + nameOff);
+    if (!str::EqN(fontName, key.fontName, hdr->fontNameLen)) {
+        return false;
+    }
+    FILETIME docModified = file::GetModificationTime(filePath);
+    if (0 != FileTimeDiffInSecs(docModified, hdr->docModified)) {
+        return false;
+    }
+
+    i32* breaks = (i32*)(data.Get() + breaksOff);
+    for (i32 i = 0; i < hdr->nPageBreaks; i++) {
+        pageBreaksOut.Append(breaks[i]);
+    }
+    return true;
+}
+
+bool SaveEbookLayout(const WCHAR* filePath, const EbookLayoutKey& key, Vec<int>& pageBreaks) {
+    if (0 == pageBreaks.size()) {
+        return false;
+    }
+    AutoFreeWstr path(GetEbookLayoutPath(filePath));
+    if (!path) {
+        return false;
+    }
+    AutoFreeWstr cachePath(path::GetDir(path));
+    if (!dir::Create(cachePath)) {
+        return false;
+    }
+
+    EbookLayoutHeader hdr{EBOOK_LAYOUT_MAGIC,
+                          EBOOK_LAYOUT_VERSION,
+                          key.fontSize,
+                          key.pageDx,
+                          key.pageDy,
+                          file::GetModificationTime(filePath),
+                          (i32)pageBreaks.isize(),
+                          (u32)str::Len(key.fontName)};
+    str::Str d;
+    d.Append((char*)&hdr, sizeof(hdr));
+    d.Append((char*)key.fontName, (size_t)hdr.fontNameLen * sizeof(WCHAR));
+    d.Append((char*)pageBreaks.LendData(), pageBreaks.size() * sizeof(i32));
+    return file::WriteFile(path.Get(), d.AsSpan());
+}
@@ -0,0 +1,14 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+// the layout-affecting settings a pagination was computed for; a cached
+// pagination is only reused when all of them (and the document) are unchanged
+struct EbookLayoutKey {
+    const WCHAR* fontName;
+    float fontSize;
+    int pageDx;
+    int pageDy;
+};
+
+bool LoadEbookLayout(const WCHAR* filePath, const EbookLayoutKey& key, Vec<int>& pageBreaksOut);
+bool SaveEbookLayout(const WCHAR* filePath, const EbookLayoutKey& key, Vec<int>& pageBreaks);
@@ -128,6 +128,55 @@ const char* GetKnownColorName(COLORREF c) {
     return nullptr;
 }
 
+// a virtual (owner-data) model over the not-deleted annotations: item
+// text is formatted on demand and nothing is stored per item, so the
+// list stays responsive for documents with thousands of annotations
+struct AnnotationsListBoxModel : ListBoxModel {
+    // the annotations are not owned; deleted ones are filtered out by Rebuild()
+    Vec<Annotation*> annots;
+    // formatting buffer; an Item() result is only valid until the next call
+    str::Str buf;
+
+    ~AnnotationsListBoxModel() override;
+    int ItemsCount() override;
+    Size Draw(bool measure) override;
+    std::string_view Item(int) override;
+
+    void Rebuild(Vec<Annotation*>* allAnnots);
+};
+
+AnnotationsListBoxModel::~AnnotationsListBoxModel() {
+}
+
+int AnnotationsListBoxModel::ItemsCount() {
+    return annots.isize();
+}
+
+Size AnnotationsListBoxModel::Draw([[maybe_unused]] bool measure) {
+    CrashIf(true);
+    return Size{};
+}
+
+std::string_view AnnotationsListBoxModel::Item(int itemNo) {
+    Annotation* annot = annots.at(itemNo);
+    buf.Reset();
+    buf.AppendFmt("page %d, ", annot->pageNo);
+    buf.AppendView(AnnotationReadableName(annot->type));
+    return buf.AsView();
+}
+
+void AnnotationsListBoxModel::Rebuild(Vec<Annotation*>* allAnnots) {
+    annots.Reset();
+    if (!allAnnots) {
+        return;
+    }
+    for (auto& annot : *allAnnots) {
+        if (!annot->isDeleted) {
+            annots.Append(annot);
+        }
+    }
+}
+
 struct EditAnnotationsWindow {
     TabInfo* tab = nullptr;
     Window* mainWindow = nullptr;
@@ -176,7 +225,7 @@ struct EditAnnotationsWindow {
     StaticCtrl* staticSaveTip = nullptr;
     ButtonCtrl* buttonSavePDF = nullptr;
 
-    ListBoxModel* lbModel = nullptr;
+    AnnotationsListBoxModel* lbModel = nullptr;
 
     Vec<Annotation*>* annotations = nullptr;
     // currently selected annotation
@@ -265,6 +314,10 @@ static void DeleteAnnotations(EditAnnotationsWindow* win) {
     delete win->annotations;
     win->annotations = nullptr;
     win->annot = nullptr;
+    if (win->lbModel) {
+        // don't leave dangling pointers in the list box model
+        win->lbModel->annots.Reset();
+    }
 }
 
 EditAnnotationsWindow::~EditAnnotationsWindow() {
@@ -290,28 +343,21 @@ static void EnableSaveIfAnnotationsChanged(EditAnnotationsWindow* win) {
 }
 
 static void RebuildAnnotations(EditAnnotationsWindow* win) {
-    auto model = new ListBoxModelStrings();
-    int n = 0;
-    if (win->annotations) {
-        n = win->annotations->isize();
-    }
+    // the model formats items on demand, so this only refreshes the
+    // filtered list of annotations and the item count
+    win->lbModel->Rebuild(win->annotations);
+    win->listBox->UpdateItemsCount();
+    EnableSaveIfAnnotationsChanged(win);
+}
 
-    str::Str s;
-    for (int i = 0; i < n; i++) {
-        auto annot = win->annotations->at(i);
-        if (annot->isDeleted) {
-            continue;
-        }
-        s.Reset();
-        s.AppendFmt("page %d, ", annot->pageNo);
-        s.AppendView(AnnotationReadableName(annot->type));
-        model->strings.Append(s.AsView());
+// editing an annotation only changes the page it's on, so invalidate just that
+// page instead of dropping every rendered page the way WindowInfoRerender does
+static void RerenderForAnnotation(EditAnnotationsWindow* win) {
+    if (!win->annot) {
+        WindowInfoRerender(win->tab->win);
+        return;
     }
-
-    win->listBox->SetModel(model);
-    delete win->lbModel;
-    win->lbModel = model;
-    EnableSaveIfAnnotationsChanged(win);
+    WindowInfoRerenderPage(win->tab->win, win->annot->PageNo());
 }
 
 static void WndCloseHandler(EditAnnotationsWindow* win, WindowCloseEvent* ev) {
@@ -334,7 +380,10 @@ static void ButtonSavePDFHandler(EditAnnotationsWindow* win) {
     }
 
     EngineBase* engine = tab->AsFixed()->GetEngine();
-    bool ok = EnginePdfSaveUpdated(engine, {});
+    // shift-click: save compacted i.e. fully rewrite the file instead of
+    // appending an incremental update
+    bool compact = IsShiftPressed();
+    bool ok = EnginePdfSaveUpdated(engine, {}, compact);
     // TODO: show a notification if saved or error message if failed to save
     if (!ok) {
         return;
@@ -474,7 +523,7 @@ static void TextAlignmentSelectionChanged(EditAnnotationsWindow* win, DropDownSe
     int newQuadding = ev->idx;
     win->annot->SetQuadding(newQuadding);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoTextFont(EditAnnotationsWindow* win, Annotation* annot) {
@@ -498,7 +547,7 @@ static void TextFontSelectionChanged(EditAnnotationsWindow* win, DropDownSelecti
     const char* font = seqstrings::IdxToStr(gFontNames, ev->idx);
     win->annot->SetDefaultAppearanceTextFont(font);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoTextSize(EditAnnotationsWindow* win, Annotation* annot) {
@@ -521,7 +570,7 @@ static void TextFontSizeChanging(EditAnnotationsWindow* win, TrackbarPosChanging
     AutoFreeStr s = str::Format("Text Size: %d", fontSize);
     win->staticTextSize->SetText(s.AsView());
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoTextColor(EditAnnotationsWindow* win, Annotation* annot) {
@@ -538,7 +587,7 @@ static void TextColorSelectionChanged(EditAnnotationsWindow* win, DropDownSelect
     auto col = GetDropDownColor(ev->item);
     win->annot->SetDefaultAppearanceTextColor(col);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoBorder(EditAnnotationsWindow* win, Annotation* annot) {
@@ -563,7 +612,7 @@ static void BorderWidthChanging(EditAnnotationsWindow* win, TrackbarPosChangingE
     AutoFreeStr s = str::Format("Border: %d", borderWidth);
     win->staticBorder->SetText(s.AsView());
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoLineStartEnd(EditAnnotationsWindow* win, Annotation* annot) {
@@ -595,7 +644,7 @@ static void LineStartEndSelectionChanged(EditAnnotationsWindow* win, DropDownSel
         end = newVal;
     }
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoIcon(EditAnnotationsWindow* win, Annotation* annot) {
@@ -628,7 +677,7 @@ static void DoIcon(EditAnnotationsWindow* win, Annotation* annot) {
 static void IconSelectionChanged(EditAnnotationsWindow* win, DropDownSelectionChangedEvent* ev) {
     win->annot->SetIconName(ev->item);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoColor(EditAnnotationsWindow* win, Annotation* annot) {
@@ -643,11 +692,38 @@ static void DoColor(EditAnnotationsWindow* win, Annotation* annot) {
     win->dropDownColor->SetIsVisible(true);
 }
 
+// all annotations that are of the same type as the currently selected one
+static void CollectAnnotationsOfSelectedType(EditAnnotationsWindow* win, Vec<Annotation*>& annotsOut) {
+    AnnotationType type = win->annot->Type();
+    for (auto& annot : *win->annotations) {
+        if (!annot->isDeleted && annot->Type() == type) {
+            annotsOut.Append(annot);
+        }
+    }
+}
+
+// after a bulk mutation: re-render each affected page exactly once
+static void RerenderPagesWithAnnotations(EditAnnotationsWindow* win, Vec<Annotation*>& annots) {
+    Vec<int> pages = PagesWithAnnotations(annots);
+    for (int pageNo : pages) {
+        WindowInfoRerenderPage(win->tab->win, pageNo);
+    }
+}
+
 static void ColorSelectionChanged(EditAnnotationsWindow* win, DropDownSelectionChangedEvent* ev) {
     auto col = GetDropDownColor(ev->item);
+    if (IsCtrlPressed()) {
+        // ctrl: re-color all annotations of the same type in one batch
+        Vec<Annotation*> annots;
+        CollectAnnotationsOfSelectedType(win, annots);
+        SetColorBulk(annots, col);
+        EnableSaveIfAnnotationsChanged(win);
+        RerenderPagesWithAnnotations(win, annots);
+        return;
+    }
     win->annot->SetColor(col);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoInteriorColor(EditAnnotationsWindow* win, Annotation* annot) {
@@ -666,7 +742,7 @@ static void InteriorColorSelectionChanged(EditAnnotationsWindow* win, DropDownSe
     auto col = GetDropDownColor(ev->item);
     win->annot->SetInteriorColor(col);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void DoOpacity(EditAnnotationsWindow* win, Annotation* annot) {
@@ -696,28 +772,17 @@ static void OpacityChanging(EditAnnotationsWindow* win, TrackbarPosChangingEvent
     AutoFreeStr s = str::Format("Opacity: %d", opacity);
     win->staticOpacity->SetText(s.AsView());
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void UpdateUIForSelectedAnnotation(EditAnnotationsWindow* win, int itemNo) {
     int annotPageNo = -1;
     win->annot = nullptr;
 
-    // get annotation at index itemNo, skipping deleted annotations
-    int idx = 0;
-    int nAnnots = win->annotations->isize();
-    for (int i = 0; itemNo >= 0 && i < nAnnots; i++) {
-        auto annot = win->annotations->at(i);
-        if (annot->isDeleted) {
-            continue;
-        }
-        if (idx < itemNo) {
-            ++idx;
-            continue;
-        }
-        win->annot = annot;
-        annotPageNo = annot->PageNo();
-        break;
+    // the model holds the not-deleted annotations in list box order
+    if (itemNo >= 0 && itemNo < win->lbModel->ItemsCount()) {
+        win->annot = win->lbModel->annots.at(itemNo);
+        annotPageNo = win->annot->PageNo();
     }
 
     HidePerAnnotControls(win);
@@ -786,10 +851,22 @@ static void ButtonEmbedAttachment(EditAnnotationsWindow* win) {
 
 static void ButtonDeleteHandler(EditAnnotationsWindow* win) {
     CrashIf(!win->annot);
+    if (IsCtrlPressed()) {
+        // ctrl-click: delete all annotations of the same type (e.g. every
+        // highlight) in one batch, with one render pass per affected page
+        Vec<Annotation*> annots;
+        CollectAnnotationsOfSelectedType(win, annots);
+        DeleteAnnotationsBulk(annots);
+        RebuildAnnotations(win);
+        UpdateUIForSelectedAnnotation(win, -1);
+        RerenderPagesWithAnnotations(win, annots);
+        return;
+    }
+    int pageNo = win->annot->PageNo();
     win->annot->Delete();
     RebuildAnnotations(win);
     UpdateUIForSelectedAnnotation(win, -1);
-    WindowInfoRerender(win->tab->win);
+    WindowInfoRerenderPage(win->tab->win, pageNo);
 }
 
 static void ListBoxSelectionChanged(EditAnnotationsWindow* win, ListBoxSelectionChangedEvent* ev) {
@@ -803,7 +880,7 @@ static void ContentsChanged(EditAnnotationsWindow* win, EditTextChangedEvent* ev
     ev->didHandle = true;
     win->annot->SetContents(ev->text);
     EnableSaveIfAnnotationsChanged(win);
-    WindowInfoRerender(win->tab->win);
+    RerenderForAnnotation(win);
 }
 
 static void WndSizeHandler(EditAnnotationsWindow* win, SizeEvent* ev) {
@@ -857,9 +934,12 @@ static void CreateMainLayout(EditAnnotationsWindow* win) {
         auto w = new ListBoxCtrl(parent);
         w->idealSizeLines = 5;
         w->SetInsetsPt(4, 0);
+        // owner-data so that documents with thousands of annotations
+        // don't copy a string per annotation into the control
+        w->isVirtual = true;
         bool ok = w->Create();
         CrashIf(!ok);
-        win->lbModel = new ListBoxModelStrings();
+        win->lbModel = new AnnotationsListBoxModel();
         w->SetModel(win->lbModel);
         w->onSelectionChanged = std::bind(ListBoxSelectionChanged, win, _1);
         win->listBox = w;
@@ -1194,9 +1274,11 @@ static bool SelectAnnotationInListBox(EditAnnotationsWindow* win, Annotation* an
         win->listBox->SetCurrentSelection(-1);
         return false;
     }
-    int n = win->annotations->isize();
+    // search the model so that the index matches the list box rows
+    // (deleted annotations are filtered out there)
+    int n = win->lbModel->ItemsCount();
     for (int i = 0; i < n; i++) {
-        Annotation* a = win->annotations->at(i);
+        Annotation* a = win->lbModel->annots.at(i);
         if (IsAnnotationEq(a, annot)) {
             win->listBox->SetCurrentSelection(i);
             UpdateUIForSelectedAnnotation(win, i);
@@ -1224,6 +1306,12 @@ static void AddAnnotationToWindow(EditAnnotationsWindow* win, Annotation* annot)
 
 // takes ownership of selectedAnnot
 void StartEditAnnotations(TabInfo* tab, Annotation* annot) {
+    // the window edits the document, so it must not operate on an engine
+    // shared with other views; the sites creating an annotation already
+    // detached from a shared engine before resolving it
+    if (!annot && !EnsureExclusiveEngine(tab)) {
+        return;
+    }
     EditAnnotationsWindow* win = tab->editAnnotsWindow;
     if (win) {
         win->skipGoToPage = (annot != nullptr);
@@ -11,6 +11,7 @@
 
 #include "Annotation.h"
 #include "EngineBase.h"
+#include "DibPool.h"
 
 void FreePageText(PageText* pageText) {
     str::Free(pageText->text);
@@ -21,7 +22,11 @@ void FreePageText(PageText* pageText) {
 }
 
 RenderedBitmap::~RenderedBitmap() {
-    DeleteObject(hbmp);
+    // a pooled DIB section goes back to DibPool for the next render of
+    // the same dimensions instead of through the kernel
+    if (!DibPoolRelease(hbmp)) {
+        DeleteObject(hbmp);
+    }
 }
 
 RenderedBitmap* RenderedBitmap::Clone() const {
@@ -375,6 +380,12 @@ TocTree::TocTree(TocItem* root) {
 }
 
 TocTree::~TocTree() {
+    if (allocator) {
+        // the items live in the pool and their destructors never run;
+        // everything they point to is in the pool as well
+        delete allocator;
+        return;
+    }
     delete root;
 }
 
@@ -462,6 +473,20 @@ EngineBase::~EngineBase() {
     free(decryptionKey);
 }
 
+EngineBase* EngineBase::AddRef() {
+    CrashIf(refs < 1);
+    refs++;
+    return this;
+}
+
+void EngineBase::DropRef() {
+    CrashIf(refs < 1);
+    refs--;
+    if (refs == 0) {
+        delete this;
+    }
+}
+
 int EngineBase::PageCount() const {
     CrashIf(pageCount < 0);
     return pageCount;
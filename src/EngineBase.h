@@ -16,6 +16,7 @@ extern Kind kindEnginePdb;
 extern Kind kindEngineChm;
 extern Kind kindEngineHtml;
 extern Kind kindEngineTxt;
+extern Kind kindEngineReflow;
 
 /* certain OCGs will only be rendered for some of these (e.g. watermarks) */
 enum class RenderTarget { View, Print, Export };
@@ -254,6 +255,11 @@ TocItem* CloneTocItemRecur(TocItem*, bool);
 
 struct TocTree : TreeModel {
     TocItem* root = nullptr;
+    // when set, the tree's items (including their strings and destinations)
+    // live in this pool, so that building and tearing down a tree with tens
+    // of thousands of items costs a few large allocations instead of many
+    // small ones (see EnginePdf::GetToc)
+    PoolAllocator* allocator = nullptr;
 
     TocTree() = default;
     TocTree(TocItem* root);
@@ -311,10 +317,21 @@ class EngineBase {
     // TODO: migrate other engines to use this
     AutoFreeWstr fileNameBase;
 
+    // number of owners of this engine. An engine can be shared (e.g. by
+    // two DisplayModels showing the same document in different windows;
+    // access is serialized inside the engines that support this). Owners
+    // that might share call AddRef()/DropRef() instead of delete; only
+    // use from the UI thread
+    int refs = 1;
+
     virtual ~EngineBase();
     // creates a clone of this engine (e.g. for printing on a different thread)
     virtual EngineBase* Clone() = 0;
 
+    EngineBase* AddRef();
+    // deletes the engine when the last owner lets go
+    void DropRef();
+
     // number of pages the loaded document contains
     int PageCount() const;
 
@@ -371,11 +388,12 @@ class EngineBase {
     // the DPI for a file is needed when converting internal measures to physical ones
     float GetFileDPI() const;
 
-    // returns a list of all available elements for this page
-    // caller must delete the result (including all elements contained in the Vec)
+    // returns a list of all available elements for this page or nullptr
+    // the Vec and the elements are owned by the engine (cached per page,
+    // shared between callers) and stay valid until the engine is deleted
     virtual Vec<IPageElement*>* GetElements(int pageNo) = 0;
     // returns the element at a given point or nullptr if there's none
-    // caller must delete the result
+    // the element is owned by the engine, callers must not delete it
     virtual IPageElement* GetElementAtPos(int pageNo, PointF pt) = 0;
 
     // creates a PageDestination from a name (or nullptr for invalid names)
@@ -5,6 +5,7 @@
 #include "utils/ScopedWin.h"
 #include "utils/WinUtil.h"
 #include "utils/GuessFileType.h"
+#include "utils/EtwTrace.h"
 
 #include "wingui/TreeModel.h"
 
@@ -130,20 +131,46 @@ static EngineBase* CreateEngineForKind(Kind kind, const WCHAR* path, PasswordUI*
     return engine;
 }
 
+/* File types whose sniffing is based on an unambiguous signature. When
+   the content identifies one of these, a disagreeing extension is known
+   to be wrong (mislabeled download, bad association on a share) and the
+   engine for the extension isn't even tried — its failed open would cost
+   another full round of file reads. The extension still breaks the tie
+   between formats sharing a container (.cbz vs plain .zip) and decides
+   the types that can't be sniffed (.txt, .html, .fb2, .vbkm). */
+static Kind gMagicSniffKinds[] = {
+    kindFilePDF,  kindFilePS,  kindFileXps,  kindFileDjVu, kindFileChm,  kindFileEpub, kindFileMobi, kindFilePng,
+    kindFileJpeg, kindFileGif, kindFileTiff, kindFileBmp,  kindFileWebp, kindFileJp2,
+};
+
 EngineBase* CreateEngine(const WCHAR* path, PasswordUI* pwdUI, bool enableChmEngine, bool enableEngineEbooks) {
     CrashIf(!path);
+    ScopedTraceEvent trc("doc-load");
+
+    // a single small header read (see GuessFileTypeFromContent) combines
+    // with the extension to pick the right engine directly, instead of
+    // discovering a wrong extension only after a full failed engine open
+    Kind nameKind = GuessFileTypeFromName(path);
+    Kind sniffed = GuessFileTypeFromContent(path);
+
+    Kind kind = nameKind;
+    if (!kind) {
+        // no (or unknown) extension: the content is all there is
+        kind = sniffed;
+    } else if (sniffed && sniffed != nameKind && KindInArray(gMagicSniffKinds, (int)dimof(gMagicSniffKinds), sniffed)) {
+        kind = sniffed;
+    }
 
-    // try to open with the engine guess from file name
-    // if that fails, try to guess the file type based on content
-    Kind kind = GuessFileTypeFromName(path);
     EngineBase* engine = CreateEngineForKind(kind, path, pwdUI, enableChmEngine, enableEngineEbooks);
     if (engine) {
         return engine;
     }
 
-    Kind newKind = GuessFileTypeFromContent(path);
-    if (kind != newKind) {
-        engine = CreateEngineForKind(newKind, path, pwdUI, enableChmEngine, enableEngineEbooks);
+    // the dispatch was wrong (e.g. a valid signature on an otherwise
+    // broken file): try the other guess before giving up
+    Kind other = (kind == sniffed) ? nameKind : sniffed;
+    if (other && other != kind) {
+        engine = CreateEngineForKind(other, path, pwdUI, enableChmEngine, enableEngineEbooks);
     }
     return engine;
 }
@@ -278,10 +278,38 @@ class EngineDjVu : public EngineBase {
     miniexp_t* annos = nullptr;
     TocTree* tocTree = nullptr;
 
+    // the hidden text layer of each page, decoded from ddjvuapi on first
+    // access; text layers are tiny compared to the page images, so keeping
+    // the whole book's text around is cheap and spares search and selection
+    // from re-requesting and re-parsing the s-expressions per pass.
+    // all access is guarded by gDjVuContext->lock
+    PageText* pageTexts = nullptr;
+    bool* pageTextLoaded = nullptr;
+
+    // per-page element lists built once from the annotations; the lists
+    // and their elements are owned by the engine (see EngineBase.h)
+    Vec<IPageElement*>** pageElements = nullptr;
+
     Vec<ddjvu_fileinfo_t> fileInfos;
 
-    RenderedBitmap* CreateRenderedBitmap(const char* bmpData, Size size, bool grayscale) const;
+    // a small cache of decoded pages: decoding a scanned page can take
+    // a few hundred ms while rendering from a decoded page is cheap, so
+    // keep the pages around the current one decoded.
+    // all access is guarded by gDjVuContext->lock
+    struct PageCacheEntry {
+        ddjvu_page_t* page = nullptr;
+        int pageNo = 0; // 0 for an unused entry
+        u32 lastUsed = 0;
+    };
+    PageCacheEntry pageCache[8];
+    u32 pageCacheCounter = 0;
+
+    ddjvu_page_t* GetDjVuPage(int pageNo, bool waitUntilDecoded);
+    void StartDecodingNeighbors(int pageNo);
+
+    RenderedBitmap* CreateRenderedBitmap(Size size, bool grayscale, char** dataOut) const;
     bool ExtractPageText(miniexp_t item, str::WStr& extracted, Vec<Rect>& coords);
+    PageText DecodePageText(int pageNo);
     char* ResolveNamedDest(const char* name);
     TocItem* BuildTocTree(TocItem* parent, miniexp_t entry, int& idCounter);
     bool Load(const WCHAR* fileName);
@@ -304,6 +332,22 @@ EngineDjVu::~EngineDjVu() {
     delete tocTree;
     free(mediaboxes);
 
+    if (pageElements) {
+        for (int i = 0; i < pageCount; i++) {
+            if (pageElements[i]) {
+                DeleteVecMembers(*pageElements[i]);
+                delete pageElements[i];
+            }
+        }
+        free(pageElements);
+    }
+
+    for (PageCacheEntry& e : pageCache) {
+        if (e.page) {
+            ddjvu_page_release(e.page);
+        }
+    }
+
     if (annos) {
         for (int i = 0; i < pageCount; i++) {
             if (annos[i]) {
@@ -312,6 +356,13 @@ EngineDjVu::~EngineDjVu() {
         }
         free(annos);
     }
+    if (pageTexts) {
+        for (int i = 0; i < pageCount; i++) {
+            FreePageText(&pageTexts[i]);
+        }
+        free(pageTexts);
+    }
+    free(pageTextLoaded);
     if (outline != miniexp_nil) {
         ddjvu_miniexp_release(doc, outline);
     }
@@ -488,6 +539,9 @@ bool EngineDjVu::FinishLoading() {
         annos[i] = miniexp_dummy;
     }
 
+    pageTexts = AllocArray<PageText>(pageCount);
+    pageTextLoaded = AllocArray<bool>(pageCount);
+
     while ((outline = ddjvu_document_get_outline(doc)) == miniexp_dummy) {
         gDjVuContext->SpinMessageLoop();
     }
@@ -512,7 +566,9 @@ bool EngineDjVu::FinishLoading() {
     return true;
 }
 
-RenderedBitmap* EngineDjVu::CreateRenderedBitmap(const char* bmpData, Size size, bool grayscale) const {
+// creates an empty DIB-backed bitmap for ddjvu to render straight into;
+// *dataOut points at the pixels (top-down, rows padded to 4 bytes)
+RenderedBitmap* EngineDjVu::CreateRenderedBitmap(Size size, bool grayscale, char** dataOut) const {
     int stride = ((size.dx * (grayscale ? 1 : 3) + 3) / 4) * 4;
 
     BITMAPINFO* bmi = (BITMAPINFO*)calloc(1, sizeof(BITMAPINFOHEADER) + (grayscale ? 256 * sizeof(RGBQUAD) : 0));
@@ -539,15 +595,62 @@ RenderedBitmap* EngineDjVu::CreateRenderedBitmap(const char* bmpData, Size size,
     HANDLE hMap =
         CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, bmi->bmiHeader.biSizeImage, nullptr);
     HBITMAP hbmp = CreateDIBSection(nullptr, bmi, DIB_RGB_COLORS, &data, hMap, 0);
-    if (hbmp) {
-        memcpy(data, bmpData, bmi->bmiHeader.biSizeImage);
-    }
 
     free(bmi);
 
+    *dataOut = (char*)data;
     return new RenderedBitmap(hbmp, size, hMap);
 }
 
+// returns a page from the cache, creating it (which makes libdjvu start
+// decoding it on its own thread) if needed. The returned page is owned
+// by the cache and must not be released by the caller.
+// caller must hold gDjVuContext->lock
+ddjvu_page_t* EngineDjVu::GetDjVuPage(int pageNo, bool waitUntilDecoded) {
+    PageCacheEntry* e = nullptr;
+    for (PageCacheEntry& entry : pageCache) {
+        if (entry.pageNo == pageNo) {
+            e = &entry;
+            break;
+        }
+    }
+    if (!e) {
+        // evict the least recently used entry (unused ones have lastUsed 0)
+        e = &pageCache[0];
+        for (PageCacheEntry& entry : pageCache) {
+            if (entry.lastUsed < e->lastUsed) {
+                e = &entry;
+            }
+        }
+        if (e->page) {
+            ddjvu_page_release(e->page);
+        }
+        e->page = ddjvu_page_create_by_pageno(doc, pageNo - 1);
+        e->pageNo = e->page ? pageNo : 0;
+    }
+    e->lastUsed = ++pageCacheCounter;
+    if (!e->page) {
+        return nullptr;
+    }
+    if (waitUntilDecoded) {
+        while (!ddjvu_page_decoding_done(e->page)) {
+            gDjVuContext->SpinMessageLoop();
+        }
+    }
+    return e->page;
+}
+
+// start decoding the neighbors of a just rendered page without waiting
+// for them, so that the next page turn usually finds its page decoded
+void EngineDjVu::StartDecodingNeighbors(int pageNo) {
+    if (pageNo < pageCount) {
+        GetDjVuPage(pageNo + 1, false);
+    }
+    if (pageNo > 1) {
+        GetDjVuPage(pageNo - 1, false);
+    }
+}
+
 RenderedBitmap* EngineDjVu::RenderPage(RenderPageArgs& args) {
     ScopedCritSec scope(&gDjVuContext->lock);
     auto pageRect = args.pageRect;
@@ -559,16 +662,13 @@ RenderedBitmap* EngineDjVu::RenderPage(RenderPageArgs& args) {
     Rect full = Transform(PageMediabox(pageNo), pageNo, zoom, rotation).Round();
     screen = full.Intersect(screen);
 
-    ddjvu_page_t* page = ddjvu_page_create_by_pageno(doc, pageNo - 1);
+    ddjvu_page_t* page = GetDjVuPage(pageNo, true);
     if (!page) {
         return nullptr;
     }
     int rotation4 = (((-rotation / 90) % 4) + 4) % 4;
     ddjvu_page_set_rotation(page, (ddjvu_page_rotation_t)rotation4);
 
-    while (!ddjvu_page_decoding_done(page)) {
-        gDjVuContext->SpinMessageLoop();
-    }
     if (ddjvu_page_decoding_error(page)) {
         return nullptr;
     }
@@ -579,7 +679,6 @@ RenderedBitmap* EngineDjVu::RenderPage(RenderPageArgs& args) {
 
     defer {
         ddjvu_format_release(fmt);
-        ddjvu_page_release(page);
     };
 
     int topToBottom = TRUE;
@@ -587,25 +686,28 @@ RenderedBitmap* EngineDjVu::RenderPage(RenderPageArgs& args) {
     ddjvu_rect_t prect = {full.x, full.y, (uint)full.dx, (uint)full.dy};
     ddjvu_rect_t rrect = {screen.x, 2 * full.y - screen.y + full.dy - screen.dy, (uint)screen.dx, (uint)screen.dy};
 
-    RenderedBitmap* bmp = nullptr;
     size_t bytesPerPixel = isBitonal ? 1 : 3;
     size_t dx = (size_t)screen.dx;
     size_t dy = (size_t)screen.dy;
+    // same padded stride as the DIB section's
     size_t stride = ((dx * bytesPerPixel + 3) / 4) * 4;
-    size_t nBytes = stride * (dy + 5);
-    AutoFree bmpData = AllocArray<char>(nBytes);
+    // render straight into the bitmap's DIB section instead of going
+    // through a temporary buffer that would have to be copied over
+    char* bmpData = nullptr;
+    RenderedBitmap* bmp = CreateRenderedBitmap(screen.Size(), isBitonal, &bmpData);
     if (!bmpData) {
+        delete bmp;
         return nullptr;
     }
 
     ddjvu_render_mode_t mode = isBitonal ? DDJVU_RENDER_MASKONLY : DDJVU_RENDER_COLOR;
-    int ok = ddjvu_page_render(page, mode, &prect, &rrect, fmt, (unsigned long)stride, bmpData.Get());
+    int ok = ddjvu_page_render(page, mode, &prect, &rrect, fmt, (unsigned long)stride, bmpData);
     if (!ok) {
         // nothing was rendered, leave the page blank (same as WinDjView)
         memset(bmpData, 0xFF, stride * dy);
-        isBitonal = true;
     }
-    bmp = CreateRenderedBitmap(bmpData, screen.Size(), isBitonal);
+
+    StartDecodingNeighbors(pageNo);
 
     return bmp;
 }
@@ -614,15 +716,12 @@ RectF EngineDjVu::PageContentBox(int pageNo, [[maybe_unused]] RenderTarget targe
     ScopedCritSec scope(&gDjVuContext->lock);
 
     RectF pageRc = PageMediabox(pageNo);
-    ddjvu_page_t* page = ddjvu_page_create_by_pageno(doc, pageNo - 1);
+    ddjvu_page_t* page = GetDjVuPage(pageNo, true);
     if (!page) {
         return pageRc;
     }
     ddjvu_page_set_rotation(page, DDJVU_ROTATE_0);
 
-    while (!ddjvu_page_decoding_done(page)) {
-        gDjVuContext->SpinMessageLoop();
-    }
     if (ddjvu_page_decoding_error(page)) {
         return pageRc;
     }
@@ -632,7 +731,6 @@ RectF EngineDjVu::PageContentBox(int pageNo, [[maybe_unused]] RenderTarget targe
 
     defer {
         ddjvu_format_release(fmt);
-        ddjvu_page_release(page);
     };
 
     ddjvu_format_set_row_order(fmt, /* top_to_bottom */ TRUE);
@@ -822,9 +920,10 @@ bool EngineDjVu::ExtractPageText(miniexp_t item, str::WStr& extracted, Vec<Rect>
     return !item;
 }
 
-PageText EngineDjVu::ExtractPageText(int pageNo) {
+// decodes the page's hidden text layer; the caller must hold
+// gDjVuContext->lock
+PageText EngineDjVu::DecodePageText(int pageNo) {
     const WCHAR* lineSep = L"\n";
-    ScopedCritSec scope(&gDjVuContext->lock);
 
     miniexp_t pagetext;
     while ((pagetext = ddjvu_document_get_pagetext(doc, pageNo - 1, nullptr)) == miniexp_dummy) {
@@ -880,8 +979,33 @@ PageText EngineDjVu::ExtractPageText(int pageNo) {
     return res;
 }
 
+PageText EngineDjVu::ExtractPageText(int pageNo) {
+    ScopedCritSec scope(&gDjVuContext->lock);
+
+    int idx = pageNo - 1;
+    if (!pageTextLoaded[idx]) {
+        pageTexts[idx] = DecodePageText(pageNo);
+        pageTextLoaded[idx] = true;
+    }
+
+    PageText* cached = &pageTexts[idx];
+    if (!cached->text) {
+        return {};
+    }
+    // callers take ownership of the result (see FreePageText), so they
+    // get a copy of the cached layer
+    PageText res;
+    res.len = cached->len;
+    res.text = (WCHAR*)memdup(cached->text, ((size_t)cached->len + 1) * sizeof(WCHAR));
+    res.coords = (Rect*)memdup(cached->coords, (size_t)cached->len * sizeof(Rect));
+    return res;
+}
+
 Vec<IPageElement*>* EngineDjVu::GetElements(int pageNo) {
     CrashIf(pageNo < 1 || pageNo > PageCount());
+    if (pageElements && pageElements[pageNo - 1]) {
+        return pageElements[pageNo - 1];
+    }
     if (annos && miniexp_dummy == annos[pageNo - 1]) {
         ScopedCritSec scope(&gDjVuContext->lock);
         while ((annos[pageNo - 1] = ddjvu_document_get_pageanno(doc, pageNo - 1)) == miniexp_dummy) {
@@ -894,7 +1018,11 @@ Vec<IPageElement*>* EngineDjVu::GetElements(int pageNo) {
 
     ScopedCritSec scope(&gDjVuContext->lock);
 
+    if (!pageElements) {
+        pageElements = AllocArray<Vec<IPageElement*>*>(pageCount);
+    }
     auto els = new Vec<IPageElement*>();
+    pageElements[pageNo - 1] = els;
     Rect page = PageMediabox(pageNo).Round();
 
     ddjvu_status_t status;
@@ -985,24 +1113,15 @@ IPageElement* EngineDjVu::GetElementAtPos(int pageNo, PointF pt) {
         return nullptr;
     }
 
-    // elements are extracted bottom-to-top but are accessed
-    // in top-to-bottom order, so reverse the list first
-    els->Reverse();
-
-    IPageElement* el = nullptr;
-    for (size_t i = 0; i < els->size() && !el; i++) {
-        if (els->at(i)->GetRect().Contains(pt)) {
-            el = els->at(i);
+    // elements are extracted bottom-to-top but hit-testing must prefer
+    // the top-most element, so scan the list in reverse
+    for (size_t i = els->size(); i > 0; i--) {
+        IPageElement* el = els->at(i - 1);
+        if (el->GetRect().Contains(pt)) {
+            return el;
         }
     }
-
-    if (el) {
-        els->Remove(el);
-    }
-    DeleteVecMembers(*els);
-    delete els;
-
-    return el;
+    return nullptr;
 }
 
 // returns a numeric DjVu link to a named page (if the name resolves)
@@ -310,9 +310,7 @@ void DumpPageContent(EngineBase* engine, int pageNo, bool fullDump) {
             Out1("\t\t\t/>\n");
         }
         Out1("\t\t</PageElements>\n");
-        DeleteVecMembers(*els);
     }
-    delete els;
 
     Out1("\t</Page>\n");
 }
@@ -386,7 +384,8 @@ bool CheckRenderPath(const WCHAR* path) {
     return true;
 }
 
-bool RenderDocument(EngineBase* engine, const WCHAR* renderPath, float zoom = 1.f, bool silent = false) {
+bool RenderDocument(EngineBase* engine, const WCHAR* renderPath, float zoom = 1.f, bool silent = false,
+                    int maxPages = 0) {
     if (!CheckRenderPath(renderPath)) {
         return false;
     }
@@ -423,7 +422,11 @@ bool RenderDocument(EngineBase* engine, const WCHAR* renderPath, float zoom = 1.
     }
 
     bool success = true;
-    for (int pageNo = 1; pageNo <= engine->PageCount(); pageNo++) {
+    int lastPage = engine->PageCount();
+    if (maxPages > 0 && maxPages < lastPage) {
+        lastPage = maxPages;
+    }
+    for (int pageNo = 1; pageNo <= lastPage; pageNo++) {
         RenderPageArgs args(pageNo, zoom, 0);
         RenderedBitmap* bmp = engine->RenderPage(args);
         success &= bmp != nullptr;
@@ -470,6 +473,525 @@ class PasswordHolder : public PasswordUI {
     }
 };
 
+/* ---- batch mode ----
+
+   Drives a list of files through parallel child EngineDump processes
+   (one invocation per file), so that a crash or hang in a single
+   document can't take down a whole corpus run. The driver enforces a
+   per-file timeout, rate-limits process launches and writes one JSON
+   object per file (path, outcome, exit code, duration) to the results
+   file. Per-file artifacts are whatever -render produces; the
+   children's dump output is discarded. */
+
+// parallel cold-opens are I/O bound, so more workers than this just
+// makes the disk seek
+#define MAX_BATCH_WORKERS 16
+
+struct BatchOptions {
+    const WCHAR* password = nullptr;
+    const WCHAR* renderPath = nullptr;
+    float renderZoom = 1.f;
+    int maxPages = 0;
+    int nWorkers = 0;       // 0: pick from processor count
+    int timeoutSecs = 60;   // per file
+    int throttleMs = 0;     // minimum delay between process launches
+    const WCHAR* outPath = nullptr;
+};
+
+struct BatchWorker {
+    HANDLE hProcess = nullptr;
+    int fileIdx = -1;
+    DWORD startTick = 0;
+};
+
+static void AppendJsonString(str::Str& out, const char* s) {
+    out.AppendChar('"');
+    for (const char* c = s; *c; c++) {
+        switch (*c) {
+            case '"':
+                out.Append("\\\"");
+                break;
+            case '\\':
+                out.Append("\\\\");
+                break;
+            case '\n':
+                out.Append("\\n");
+                break;
+            case '\r':
+                out.Append("\\r");
+                break;
+            case '\t':
+                out.Append("\\t");
+                break;
+            default:
+                if ((u8)*c < 0x20) {
+                    out.AppendFmt("\\u%04x", *c);
+                } else {
+                    out.AppendChar(*c);
+                }
+        }
+    }
+    out.AppendChar('"');
+}
+
+static bool ReadFileList(const WCHAR* listPath, WStrVec& files) {
+    AutoFree data(file::ReadFile(listPath));
+    if (!data.data) {
+        return false;
+    }
+    char* cur = data.data;
+    if (str::StartsWith(cur, UTF8_BOM)) {
+        cur += 3;
+    }
+    while (cur && *cur) {
+        char* next = (char*)str::FindChar(cur, '\n');
+        if (next) {
+            *next++ = 0;
+        }
+        size_t n = str::Len(cur);
+        while (n > 0 && (cur[n - 1] == '\r' || cur[n - 1] == ' ' || cur[n - 1] == '\t')) {
+            cur[--n] = 0;
+        }
+        if (*cur) {
+            files.Append(strconv::Utf8ToWstr(cur));
+        }
+        cur = next;
+    }
+    return files.size() > 0;
+}
+
+// a "%s" in the render template is replaced with the document's base
+// name, so that parallel children don't overwrite each other's output
+static WCHAR* PerFileRenderPath(const WCHAR* tmpl, const WCHAR* filePath) {
+    if (!str::Find(tmpl, L"%s")) {
+        return str::Dup(tmpl);
+    }
+    const WCHAR* baseName = path::GetBaseNameNoFree(filePath);
+    return str::Replace(tmpl, L"%s", baseName);
+}
+
+static WCHAR* BuildChildCmdLine(const WCHAR* exePath, const BatchOptions& opts, const WCHAR* filePath) {
+    str::WStr cmd(256);
+    // the dump output is discarded, so don't pay for creating it
+    cmd.AppendFmt(L"\"%s\" -loadonly", exePath);
+    if (opts.password) {
+        cmd.AppendFmt(L" -pwd \"%s\"", opts.password);
+    }
+    if (opts.maxPages > 0) {
+        cmd.AppendFmt(L" -maxpages %d", opts.maxPages);
+    }
+    if (opts.renderPath) {
+        AutoFreeWstr perFile(PerFileRenderPath(opts.renderPath, filePath));
+        if (opts.renderZoom != 1.f) {
+            cmd.AppendFmt(L" -render %.0f%% \"%s\"", opts.renderZoom * 100.f, perFile.Get());
+        } else {
+            cmd.AppendFmt(L" -render \"%s\"", perFile.Get());
+        }
+    }
+    cmd.AppendFmt(L" \"%s\"", filePath);
+    return cmd.StealData();
+}
+
+static bool LaunchBatchChild(const WCHAR* exePath, const BatchOptions& opts, const WCHAR* filePath, HANDLE hNul,
+                             BatchWorker& w) {
+    AutoFreeWstr cmd(BuildChildCmdLine(exePath, opts, filePath));
+    STARTUPINFOW si{};
+    si.cb = sizeof(si);
+    if (hNul != INVALID_HANDLE_VALUE) {
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdOutput = hNul;
+        si.hStdError = hNul;
+    }
+    PROCESS_INFORMATION pi{};
+    BOOL ok = CreateProcessW(nullptr, cmd.Get(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi);
+    if (!ok) {
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    w.hProcess = pi.hProcess;
+    w.startTick = GetTickCount();
+    return true;
+}
+
+static void WriteBatchResult(FILE* outFile, const WCHAR* filePath, bool ok, DWORD exitCode, bool timedOut,
+                             DWORD durMs) {
+    AutoFree pathUtf8(strconv::WstrToUtf8(filePath));
+    str::Str line(256);
+    line.Append("{\"file\":");
+    AppendJsonString(line, pathUtf8.Get() ? pathUtf8.Get() : "");
+    line.AppendFmt(",\"ok\":%s,\"exitCode\":%u,\"timedOut\":%s,\"durMs\":%u}\n", ok ? "true" : "false",
+                   (unsigned)exitCode, timedOut ? "true" : "false", (unsigned)durMs);
+    fwrite(line.Get(), 1, line.size(), outFile);
+    fflush(outFile);
+}
+
+static int RunBatch(const BatchOptions& opts, const WCHAR* listPath) {
+    WStrVec files;
+    if (!ReadFileList(listPath, files)) {
+        ErrOut("Error: Couldn't read any file paths from %s!", path::GetBaseNameNoFree(listPath));
+        return 2;
+    }
+
+    FILE* outFile = stdout;
+    if (opts.outPath) {
+        if (_wfopen_s(&outFile, opts.outPath, L"wb") != 0) {
+            ErrOut("Error: Couldn't create results file %s!", path::GetBaseNameNoFree(opts.outPath));
+            return 2;
+        }
+    }
+
+    int nWorkers = opts.nWorkers;
+    if (nWorkers <= 0) {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        nWorkers = (int)si.dwNumberOfProcessors - 1;
+    }
+    nWorkers = limitValue(nWorkers, 1, MAX_BATCH_WORKERS);
+    if (nWorkers > (int)files.size()) {
+        nWorkers = (int)files.size();
+    }
+
+    AutoFreeWstr exePath(GetExePath());
+    DWORD timeoutMs = (DWORD)opts.timeoutSecs * 1000;
+
+    // children write their (discarded) output to NUL
+    SECURITY_ATTRIBUTES sa{};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+    HANDLE hNul = CreateFileW(L"NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0,
+                              nullptr);
+
+    Vec<BatchWorker> workers;
+    for (int i = 0; i < nWorkers; i++) {
+        workers.Append(BatchWorker());
+    }
+
+    size_t nextFile = 0;
+    int nOk = 0, nFailed = 0, nTimedOut = 0;
+    DWORD batchStart = GetTickCount();
+
+    for (;;) {
+        // top up idle workers
+        for (BatchWorker& w : workers) {
+            if (w.hProcess || nextFile >= files.size()) {
+                continue;
+            }
+            if (opts.throttleMs > 0 && nextFile > 0) {
+                Sleep((DWORD)opts.throttleMs);
+            }
+            int idx = (int)nextFile++;
+            if (LaunchBatchChild(exePath, opts, files.at(idx), hNul, w)) {
+                w.fileIdx = idx;
+            } else {
+                WriteBatchResult(outFile, files.at(idx), false, (DWORD)-1, false, 0);
+                nFailed++;
+            }
+        }
+
+        HANDLE handles[MAX_BATCH_WORKERS];
+        DWORD nRunning = 0;
+        for (BatchWorker& w : workers) {
+            if (w.hProcess) {
+                handles[nRunning++] = w.hProcess;
+            }
+        }
+        if (0 == nRunning) {
+            break;
+        }
+        WaitForMultipleObjects(nRunning, handles, FALSE, 250);
+
+        for (BatchWorker& w : workers) {
+            if (!w.hProcess) {
+                continue;
+            }
+            DWORD durMs = GetTickCount() - w.startTick;
+            if (WAIT_OBJECT_0 == WaitForSingleObject(w.hProcess, 0)) {
+                DWORD exitCode = (DWORD)-1;
+                GetExitCodeProcess(w.hProcess, &exitCode);
+                bool ok = 0 == exitCode;
+                WriteBatchResult(outFile, files.at(w.fileIdx), ok, exitCode, false, durMs);
+                ok ? nOk++ : nFailed++;
+            } else if (durMs < timeoutMs) {
+                continue;
+            } else {
+                TerminateProcess(w.hProcess, 1);
+                WaitForSingleObject(w.hProcess, INFINITE);
+                WriteBatchResult(outFile, files.at(w.fileIdx), false, (DWORD)-1, true, durMs);
+                nTimedOut++;
+            }
+            CloseHandle(w.hProcess);
+            w.hProcess = nullptr;
+            w.fileIdx = -1;
+        }
+    }
+
+    if (INVALID_HANDLE_VALUE != hNul) {
+        CloseHandle(hNul);
+    }
+    if (outFile != stdout) {
+        fclose(outFile);
+    }
+
+    DWORD totalSecs = (GetTickCount() - batchStart) / 1000;
+    ErrOut("Batch done: %d ok, %d failed, %d timed out in %us (%d workers)", nOk, nFailed, nTimedOut,
+           (unsigned)totalSecs, nWorkers);
+    return (nFailed + nTimedOut) > 0 ? 1 : 0;
+}
+
+/* ---- server mode ----
+
+   A named-pipe render server that keeps a pool of warm engines, so
+   that tools issuing many requests against the same documents pay the
+   process and document-load cost once instead of per request.
+
+   Clients connect to \\.\pipe\<name> (message mode) and send one
+   UTF-8 message per request, fields separated by tabs:
+
+     load <path>                     -> payload: page count
+     render <path> <page> <zoom%>    -> payload: BMP of the page
+     extracttext <path> <page>       -> payload: UTF-8 text (page 0: whole document)
+     gettoc <path>                   -> payload: lines of "<level>\t<title>\t<page>"
+     quit
+
+   The reply is a single message: "ok <payloadLen>\n" followed by the
+   payload, or "err <message>\n". */
+
+#define DEFAULT_WARM_ENGINES 8
+
+struct WarmEngine {
+    WCHAR* filePath = nullptr;
+    EngineBase* engine = nullptr;
+    DWORD lastUseTick = 0;
+};
+
+static Vec<WarmEngine> gWarmEngines;
+static int gMaxWarmEngines = DEFAULT_WARM_ENGINES;
+
+static EngineBase* GetWarmEngine(const WCHAR* filePath) {
+    for (size_t i = 0; i < gWarmEngines.size(); i++) {
+        WarmEngine* we = &gWarmEngines.at(i);
+        if (path::IsSame(we->filePath, filePath)) {
+            we->lastUseTick = GetTickCount();
+            return we->engine;
+        }
+    }
+
+    EngineBase* engine = CreateEngine(filePath, nullptr);
+    if (!engine) {
+        return nullptr;
+    }
+
+    if ((int)gWarmEngines.size() >= gMaxWarmEngines) {
+        size_t lru = 0;
+        for (size_t i = 1; i < gWarmEngines.size(); i++) {
+            if (gWarmEngines.at(i).lastUseTick < gWarmEngines.at(lru).lastUseTick) {
+                lru = i;
+            }
+        }
+        WarmEngine evicted = gWarmEngines.at(lru);
+        gWarmEngines.RemoveAt(lru);
+        str::Free(evicted.filePath);
+        delete evicted.engine;
+    }
+
+    WarmEngine we;
+    we.filePath = str::Dup(filePath);
+    we.engine = engine;
+    we.lastUseTick = GetTickCount();
+    gWarmEngines.Append(we);
+    return engine;
+}
+
+static void DropWarmEngines() {
+    for (size_t i = 0; i < gWarmEngines.size(); i++) {
+        str::Free(gWarmEngines.at(i).filePath);
+        delete gWarmEngines.at(i).engine;
+    }
+    gWarmEngines.Reset();
+}
+
+static void ServerReplyOk(str::Str& reply, const char* payload, size_t payloadLen) {
+    reply.AppendFmt("ok %u\n", (unsigned)payloadLen);
+    if (payloadLen > 0) {
+        reply.Append(payload, payloadLen);
+    }
+}
+
+static void ServerReplyErr(str::Str& reply, const char* msg) {
+    reply.AppendFmt("err %s\n", msg);
+}
+
+static void ServerTocItem(str::Str& out, TocItem* item, int level) {
+    for (; item; item = item->next) {
+        AutoFree title(strconv::WstrToUtf8(item->title));
+        out.AppendFmt("%d\t%s\t%d\n", level, title.Get() ? title.Get() : "", item->pageNo);
+        if (item->child) {
+            ServerTocItem(out, item->child, level + 1);
+        }
+    }
+}
+
+static void HandleServerRequest(const char* req, str::Str& reply, bool& quit) {
+    AutoFreeWstr reqW(strconv::Utf8ToWstr(req ? req : ""));
+    WStrVec fields;
+    WCHAR* s = reqW.Get();
+    while (s) {
+        WCHAR* next = (WCHAR*)str::FindChar(s, '\t');
+        if (next) {
+            *next++ = 0;
+        }
+        fields.Append(str::Dup(s));
+        s = next;
+    }
+    if (fields.size() == 0) {
+        ServerReplyErr(reply, "empty request");
+        return;
+    }
+
+    const WCHAR* cmd = fields.at(0);
+    if (str::Eq(cmd, L"quit")) {
+        quit = true;
+        ServerReplyOk(reply, nullptr, 0);
+        return;
+    }
+    if (fields.size() < 2) {
+        ServerReplyErr(reply, "missing file path");
+        return;
+    }
+
+    EngineBase* engine = GetWarmEngine(fields.at(1));
+    if (!engine) {
+        ServerReplyErr(reply, "couldn't load the document");
+        return;
+    }
+
+    if (str::Eq(cmd, L"load")) {
+        str::Str payload;
+        payload.AppendFmt("%d", engine->PageCount());
+        ServerReplyOk(reply, payload.Get(), payload.size());
+        return;
+    }
+
+    if (str::Eq(cmd, L"render")) {
+        int pageNo = fields.size() > 2 ? _wtoi(fields.at(2)) : 1;
+        float zoom = fields.size() > 3 ? (float)_wtof(fields.at(3)) / 100.f : 1.f;
+        if (pageNo < 1 || pageNo > engine->PageCount() || zoom <= 0.f) {
+            ServerReplyErr(reply, "bad page number or zoom");
+            return;
+        }
+        RenderPageArgs args(pageNo, zoom, 0);
+        RenderedBitmap* bmp = engine->RenderPage(args);
+        if (!bmp) {
+            ServerReplyErr(reply, "render failed");
+            return;
+        }
+        std::span<u8> imgData = SerializeBitmap(bmp->GetBitmap());
+        delete bmp;
+        if (imgData.empty()) {
+            ServerReplyErr(reply, "render failed");
+            return;
+        }
+        ServerReplyOk(reply, (const char*)imgData.data(), imgData.size());
+        str::Free(imgData.data());
+        return;
+    }
+
+    if (str::Eq(cmd, L"extracttext")) {
+        int pageNo = fields.size() > 2 ? _wtoi(fields.at(2)) : 0;
+        if (pageNo < 0 || pageNo > engine->PageCount()) {
+            ServerReplyErr(reply, "bad page number");
+            return;
+        }
+        int firstPage = pageNo ? pageNo : 1;
+        int lastPage = pageNo ? pageNo : engine->PageCount();
+        str::WStr text(1024);
+        for (int i = firstPage; i <= lastPage; i++) {
+            PageText pageText = engine->ExtractPageText(i);
+            if (pageText.text != nullptr) {
+                text.Append(pageText.text);
+            }
+            FreePageText(&pageText);
+        }
+        AutoFree textUtf8(strconv::WstrToUtf8(text.Get()));
+        ServerReplyOk(reply, textUtf8.Get(), textUtf8.size());
+        return;
+    }
+
+    if (str::Eq(cmd, L"gettoc")) {
+        str::Str payload;
+        TocTree* tree = engine->GetToc();
+        if (tree && tree->root) {
+            ServerTocItem(payload, tree->root, 0);
+        }
+        ServerReplyOk(reply, payload.Get(), payload.size());
+        return;
+    }
+
+    ServerReplyErr(reply, "unknown command");
+}
+
+static int RunServer(const WCHAR* pipeName, int maxEngines) {
+    ScopedGdiPlus gdiPlus;
+    ScopedMiniMui miniMui;
+
+    gMaxWarmEngines = limitValue(maxEngines, 1, 64);
+    AutoFreeWstr fullName(str::Format(L"\\\\.\\pipe\\%s", pipeName));
+
+    bool quit = false;
+    while (!quit) {
+        HANDLE hPipe = CreateNamedPipeW(fullName, PIPE_ACCESS_DUPLEX,
+                                        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT, 1, 1 << 20, 1 << 20, 0,
+                                        nullptr);
+        if (INVALID_HANDLE_VALUE == hPipe) {
+            ErrOut("Error: Couldn't create pipe %s!", fullName.Get());
+            DropWarmEngines();
+            return 2;
+        }
+        BOOL connected = ConnectNamedPipe(hPipe, nullptr) ? TRUE : (GetLastError() == ERROR_PIPE_CONNECTED);
+        if (!connected) {
+            CloseHandle(hPipe);
+            continue;
+        }
+
+        bool disconnected = false;
+        while (!disconnected && !quit) {
+            str::Str req;
+            char buf[4096];
+            DWORD nRead = 0;
+            for (;;) {
+                BOOL ok = ReadFile(hPipe, buf, sizeof(buf), &nRead, nullptr);
+                if (ok || GetLastError() == ERROR_MORE_DATA) {
+                    req.Append(buf, nRead);
+                }
+                if (ok) {
+                    break;
+                }
+                if (GetLastError() != ERROR_MORE_DATA) {
+                    disconnected = true;
+                    break;
+                }
+            }
+            if (disconnected) {
+                break;
+            }
+
+            str::Str reply;
+            HandleServerRequest(req.Get(), reply, quit);
+            DWORD nWritten = 0;
+            if (!WriteFile(hPipe, reply.Get(), (DWORD)reply.size(), &nWritten, nullptr)) {
+                disconnected = true;
+            }
+        }
+
+        FlushFileBuffers(hPipe);
+        DisconnectNamedPipe(hPipe);
+        CloseHandle(hPipe);
+    }
+
+    DropWarmEngines();
+    return 0;
+}
+
 int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     setlocale(LC_ALL, "C");
     DisableDataExecution();
@@ -478,8 +1000,12 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     ParseCmdLine(GetCommandLine(), argList);
     if (argList.size() < 2) {
     Usage:
-        ErrOut("%s [-pwd <password>][-quick][-render <path-%%d.tga>] <filename>",
+        ErrOut("%s [-pwd <password>][-quick][-render <path-%%d.tga>][-maxpages <n>] <filename>",
+               path::GetBaseNameNoFree(argList.at(0)));
+        ErrOut("%s -batch <filelist.txt> [-render <path-%%s-%%d.tga>][-maxpages <n>][-workers <n>]"
+               "[-timeout <secs>][-throttle <ms>][-out <results.jsonl>]",
                path::GetBaseNameNoFree(argList.at(0)));
+        ErrOut("%s -server <pipename> [-engines <n>]", path::GetBaseNameNoFree(argList.at(0)));
         return 2;
     }
 
@@ -490,6 +1016,11 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     float renderZoom = 1.f;
     bool loadOnly = false, silent = false;
     int breakAlloc = 0;
+    int maxPages = 0;
+    WCHAR* batchListPath = nullptr;
+    BatchOptions batchOpts;
+    WCHAR* serverPipeName = nullptr;
+    int serverEngines = DEFAULT_WARM_ENGINES;
 
     for (size_t i = 1; i < argList.size(); i++) {
         if (str::Eq(argList.at(i), L"-pwd") && i + 1 < argList.size() && !password) {
@@ -514,12 +1045,44 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
             fullDump = true;
         } else if (str::Eq(argList.at(i), L"-breakalloc") && i + 1 < argList.size()) {
             breakAlloc = _wtoi(argList.at(++i));
+        } else if (str::Eq(argList.at(i), L"-maxpages") && i + 1 < argList.size()) {
+            maxPages = _wtoi(argList.at(++i));
+        } else if (str::Eq(argList.at(i), L"-batch") && i + 1 < argList.size() && !batchListPath) {
+            batchListPath = argList.at(++i);
+        } else if (str::Eq(argList.at(i), L"-workers") && i + 1 < argList.size()) {
+            batchOpts.nWorkers = _wtoi(argList.at(++i));
+        } else if (str::Eq(argList.at(i), L"-timeout") && i + 1 < argList.size()) {
+            batchOpts.timeoutSecs = _wtoi(argList.at(++i));
+        } else if (str::Eq(argList.at(i), L"-throttle") && i + 1 < argList.size()) {
+            batchOpts.throttleMs = _wtoi(argList.at(++i));
+        } else if (str::Eq(argList.at(i), L"-out") && i + 1 < argList.size()) {
+            batchOpts.outPath = argList.at(++i);
+        } else if (str::Eq(argList.at(i), L"-server") && i + 1 < argList.size() && !serverPipeName) {
+            serverPipeName = argList.at(++i);
+        } else if (str::Eq(argList.at(i), L"-engines") && i + 1 < argList.size()) {
+            serverEngines = _wtoi(argList.at(++i));
         } else if (!filePath) {
             filePath.SetCopy(argList.at(i));
         } else {
             goto Usage;
         }
     }
+    if (serverPipeName) {
+        if (filePath || batchListPath) {
+            goto Usage;
+        }
+        return RunServer(serverPipeName, serverEngines);
+    }
+    if (batchListPath) {
+        if (batchOpts.timeoutSecs <= 0 || filePath) {
+            goto Usage;
+        }
+        batchOpts.password = password;
+        batchOpts.renderPath = renderPath;
+        batchOpts.renderZoom = renderZoom;
+        batchOpts.maxPages = maxPages;
+        return RunBatch(batchOpts, batchListPath);
+    }
     if (!filePath) {
         goto Usage;
     }
@@ -571,7 +1134,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
         DumpData(engine, fullDump);
     }
     if (renderPath) {
-        RenderDocument(engine, renderPath, renderZoom, silent);
+        RenderDocument(engine, renderPath, renderZoom, silent, maxPages);
     }
     delete engine;
 
@@ -35,6 +35,7 @@ Kind kindEnginePdb = "enginePdb";
 Kind kindEngineChm = "engineChm";
 Kind kindEngineHtml = "engineHtml";
 Kind kindEngineTxt = "engineTxt";
+Kind kindEngineReflow = "engineReflow";
 
 static AutoFreeWstr gDefaultFontName;
 static float gDefaultFontSize = 10.f;
@@ -67,6 +68,21 @@ struct PageAnchor {
     }
 };
 
+// a page rendered at given zoom / rotation; RenderPage() keeps a few of
+// these around so that scrolling doesn't re-run text drawing through mui
+// for every repaint
+struct EbookRenderedPage {
+    int pageNo;
+    float zoom;
+    int rotation;
+    RectF pageRc;
+    Size size;
+    HBITMAP hbmp;
+};
+
+// enough for the visible page(s) plus the neighbors RenderCache prefetches
+constexpr size_t kMaxRenderedPageCache = 4;
+
 class EbookAbortCookie : public AbortCookie {
   public:
     bool abort{false};
@@ -106,6 +122,13 @@ class EngineEbook : public EngineBase {
 
   protected:
     Vec<HtmlPage*>* pages = nullptr;
+    // per-page element lists built once from the draw instructions; the
+    // lists and their elements are owned by the engine (see EngineBase.h)
+    Vec<IPageElement*>** pageElements = nullptr;
+    // most recently rendered pages, newest last; guarded by pagesAccess.
+    // pages are formatted once at load, so entries only go stale when the
+    // render parameters (zoom / rotation / rect) change
+    Vec<EbookRenderedPage> renderedPages;
     Vec<PageAnchor> anchors;
     // contains for each page the last anchor indicating
     // a break between two merged documents
@@ -186,6 +209,20 @@ EngineEbook::~EngineEbook() {
     }
     delete pages;
 
+    if (pageElements) {
+        for (int i = 0; i < pageCount; i++) {
+            if (pageElements[i]) {
+                DeleteVecMembers(*pageElements[i]);
+                delete pageElements[i];
+            }
+        }
+        free(pageElements);
+    }
+
+    for (auto& rp : renderedPages) {
+        DeleteObject(rp.hbmp);
+    }
+
     LeaveCriticalSection(&pagesAccess);
     DeleteCriticalSection(&pagesAccess);
 }
@@ -280,6 +317,24 @@ RectF EngineEbook::Transform(const RectF& rect, [[maybe_unused]] int pageNo, flo
     return RectF::FromXY(pts[0].X, pts[0].Y, pts[1].X, pts[1].Y);
 }
 
+// copies a 32-bit memory bitmap; returns nullptr on failure
+static HBITMAP CopyMemoryBitmap(HBITMAP src, Size size, HANDLE* hDataMapping) {
+    HBITMAP dst = CreateMemoryBitmap(size, hDataMapping);
+    if (!dst) {
+        return nullptr;
+    }
+    HDC srcDC = CreateCompatibleDC(nullptr);
+    HDC dstDC = CreateCompatibleDC(nullptr);
+    HGDIOBJ prevSrc = SelectObject(srcDC, src);
+    HGDIOBJ prevDst = SelectObject(dstDC, dst);
+    BitBlt(dstDC, 0, 0, size.dx, size.dy, srcDC, 0, 0, SRCCOPY);
+    SelectObject(srcDC, prevSrc);
+    SelectObject(dstDC, prevDst);
+    DeleteDC(srcDC);
+    DeleteDC(dstDC);
+    return dst;
+}
+
 RenderedBitmap* EngineEbook::RenderPage(RenderPageArgs& args) {
     auto pageNo = args.pageNo;
     auto zoom = args.zoom;
@@ -291,6 +346,21 @@ RenderedBitmap* EngineEbook::RenderPage(RenderPageArgs& args) {
     Point screenTL = screen.TL();
     screen.Offset(-screen.x, -screen.y);
 
+    ScopedCritSec scope(&pagesAccess);
+
+    // a cached copy makes repaints during scrolling memcpy-fast
+    for (auto& rp : renderedPages) {
+        if (rp.pageNo != pageNo || rp.zoom != zoom || rp.rotation != rotation || rp.pageRc != pageRc) {
+            continue;
+        }
+        HANDLE hMapCopy = nullptr;
+        HBITMAP hbmpCopy = CopyMemoryBitmap(rp.hbmp, rp.size, &hMapCopy);
+        if (!hbmpCopy) {
+            break;
+        }
+        return new RenderedBitmap(hbmpCopy, rp.size, hMapCopy);
+    }
+
     HANDLE hMap = nullptr;
     HBITMAP hbmp = CreateMemoryBitmap(screen.Size(), &hMap);
     HDC hDC = CreateCompatibleDC(nullptr);
@@ -316,8 +386,6 @@ RenderedBitmap* EngineEbook::RenderPage(RenderPageArgs& args) {
         *args.cookie_out = cookie;
     }
 
-    ScopedCritSec scope(&pagesAccess);
-
     mui::ITextRender* textDraw = mui::TextRenderGdiplus::Create(&g);
     DrawHtmlPage(&g, textDraw, GetHtmlPage(pageNo), pageBorder, pageBorder, false, Color((ARGB)Color::Black),
                  cookie ? &cookie->abort : nullptr);
@@ -330,6 +398,17 @@ RenderedBitmap* EngineEbook::RenderPage(RenderPageArgs& args) {
         return nullptr;
     }
 
+    // remember a copy of the fully drawn page (the caller takes ownership
+    // of the bitmap we return)
+    HBITMAP hbmpCached = CopyMemoryBitmap(hbmp, screen.Size(), nullptr);
+    if (hbmpCached) {
+        if (renderedPages.size() >= kMaxRenderedPageCache) {
+            DeleteObject(renderedPages.at(0).hbmp);
+            renderedPages.RemoveAt(0);
+        }
+        renderedPages.Append({pageNo, zoom, rotation, pageRc, screen.Size(), hbmpCached});
+    }
+
     return new RenderedBitmap(hbmp, screen.Size(), hMap);
 }
 
@@ -445,7 +524,16 @@ PageElement* EngineEbook::CreatePageLink(DrawInstr* link, Rect rect, int pageNo)
 }
 
 Vec<IPageElement*>* EngineEbook::GetElements(int pageNo) {
+    ScopedCritSec scope(&pagesAccess);
+
+    if (!pageElements) {
+        pageElements = AllocArray<Vec<IPageElement*>*>(pageCount);
+    }
+    if (pageElements[pageNo - 1]) {
+        return pageElements[pageNo - 1];
+    }
     auto els = new Vec<IPageElement*>();
+    pageElements[pageNo - 1] = els;
 
     Vec<DrawInstr>* pageInstrs = GetHtmlPage(pageNo);
     size_t n = pageInstrs->size();
@@ -494,20 +582,12 @@ IPageElement* EngineEbook::GetElementAtPos(int pageNo, PointF pt) {
         return nullptr;
     }
 
-    IPageElement* el = nullptr;
-    for (size_t i = 0; i < els->size() && !el; i++) {
-        if (els->at(i)->GetRect().Contains(pt)) {
-            el = els->at(i);
+    for (auto* el : *els) {
+        if (el->GetRect().Contains(pt)) {
+            return el;
         }
     }
-
-    if (el) {
-        els->Remove(el);
-    }
-    DeleteVecMembers(*els);
-    delete els;
-
-    return el;
+    return nullptr;
 }
 
 PageDestination* EngineEbook::GetNamedDest(const WCHAR* name) {
@@ -1289,6 +1369,7 @@ void ChmFormatter::HandleTagPagebreak(HtmlToken* t) {
         pagePath.Set(str::DupN(attr->val, attr->valLen));
         // reset CSS style rules for the new document
         styleRules.Reset();
+        styleRuleCache.Reset();
     }
 }
 
@@ -1770,6 +1851,167 @@ EngineBase* CreateTxtEngineFromFile(const WCHAR* fileName) {
     return EngineTxt::CreateFromFile(fileName);
 }
 
+/* EngineBase that reflows the text of a fixed-layout document */
+
+/* The text of every page is extracted (in reading order, as far as
+   ExtractPageText provides it) and re-laid out through the HtmlFormatter
+   pipeline, like an ebook. Drawing the resulting text runs is much cheaper
+   than rasterizing the source page and adapts to any page size, which makes
+   dense PDFs readable on small and slow devices. A page_marker anchor is
+   emitted per source page, so that positions in the reflowed document map
+   back to source pages (resolve the source page number via GetNamedDest). */
+
+// appends the extracted text of one page, escaping HTML markup characters;
+// single line breaks become spaces so that the text can reflow, while
+// empty lines are kept as paragraph breaks
+static void AppendPageTextAsHtml(str::Str& html, const PageText& pageText) {
+    html.Append("<p>");
+    bool prevWasNewline = false;
+    for (int i = 0; i < pageText.len; i++) {
+        WCHAR c = pageText.text[i];
+        if ('\r' == c) {
+            continue;
+        }
+        if ('\n' == c) {
+            if (prevWasNewline) {
+                html.Append("</p><p>");
+            } else {
+                html.AppendChar(' ');
+            }
+            prevWasNewline = true;
+            continue;
+        }
+        prevWasNewline = false;
+        if ('&' == c) {
+            html.Append("&amp;");
+        } else if ('<' == c) {
+            html.Append("&lt;");
+        } else if ('>' == c) {
+            html.Append("&gt;");
+        } else if (c < 0x80) {
+            html.AppendChar((char)c);
+        } else {
+            // non-ASCII characters go through numeric entities, which
+            // ResolveHtmlEntities turns back into text at layout time
+            html.AppendFmt("&#%d;", (int)c);
+        }
+    }
+    html.Append("</p>");
+}
+
+/* the base HtmlFormatter ignores <pagebreak>, so turn the per-source-page
+   markers into anchors the same way EpubFormatter does for chapters */
+class ReflowFormatter : public HtmlFormatter {
+    bool seenMarker = false;
+
+    void HandleTagPagebreak(HtmlToken* t) override {
+        AttrInfo* attr = t->GetAttrByName("page_path");
+        if (!attr || seenMarker) {
+            ForceNewPage();
+        }
+        if (attr) {
+            Gdiplus::RectF bbox(0, currY, pageDx, 0);
+            currPage->instructions.Append(DrawInstr::Anchor(attr->val, attr->valLen, bbox));
+            seenMarker = true;
+        }
+    }
+
+  public:
+    explicit ReflowFormatter(HtmlFormatterArgs* args) : HtmlFormatter(args) {
+    }
+};
+
+class EngineReflow : public EngineEbook {
+  public:
+    EngineReflow() : EngineEbook() {
+        kind = kindEngineReflow;
+    }
+    virtual ~EngineReflow() {
+        delete srcEngine;
+    }
+    EngineBase* Clone() override {
+        EngineBase* clone = srcEngine ? srcEngine->Clone() : nullptr;
+        if (!clone) {
+            return nullptr;
+        }
+        return CreateFromEngine(clone);
+    }
+
+    WCHAR* GetProperty(DocumentProperty prop) override {
+        return prop != DocumentProperty::FontList ? srcEngine->GetProperty(prop) : ExtractFontList();
+    }
+
+    static EngineBase* CreateFromEngine(EngineBase* engine);
+
+  protected:
+    // the fixed-layout engine the text was extracted from
+    EngineBase* srcEngine = nullptr;
+    // the generated HTML; the draw instructions point into it
+    AutoFree htmlData;
+
+    bool Load(EngineBase* engine);
+};
+
+bool EngineReflow::Load(EngineBase* engine) {
+    srcEngine = engine;
+    const WCHAR* fileName = engine->FileName();
+    if (fileName) {
+        SetFileName(fileName);
+        defaultFileExt = path::GetExtNoFree(fileName);
+    }
+
+    str::Str html;
+    int srcPageCount = engine->PageCount();
+    for (int pageNo = 1; pageNo <= srcPageCount; pageNo++) {
+        // one base anchor per source page, so that positions in the
+        // reflowed document map back to the source page
+        html.AppendFmt("<pagebreak page_path=\"%d\" page_marker />", pageNo);
+        PageText pageText = engine->ExtractPageText(pageNo);
+        if (pageText.text) {
+            AppendPageTextAsHtml(html, pageText);
+        }
+        FreePageText(&pageText);
+    }
+    htmlData.Set(html.StealAsSpan());
+
+    HtmlFormatterArgs args;
+    args.htmlStr = htmlData.AsSpan();
+    args.pageDx = (float)pageRect.dx - 2 * pageBorder;
+    args.pageDy = (float)pageRect.dy - 2 * pageBorder;
+    args.SetFontName(GetDefaultFontName());
+    args.fontSize = GetDefaultFontSize();
+    args.textAllocator = &allocator;
+    args.textRenderMethod = mui::TextRenderMethodGdiplus;
+
+    pages = ReflowFormatter(&args).FormatAllPages(false);
+    // must set pageCount before ExtractPageAnchors
+    pageCount = (int)pages->size();
+    if (!ExtractPageAnchors()) {
+        return false;
+    }
+
+    return pageCount > 0;
+}
+
+EngineBase* EngineReflow::CreateFromEngine(EngineBase* engine) {
+    EngineReflow* reflowEngine = new EngineReflow();
+    if (!reflowEngine->Load(engine)) {
+        // the caller keeps ownership of engine on failure
+        reflowEngine->srcEngine = nullptr;
+        delete reflowEngine;
+        return nullptr;
+    }
+    return reflowEngine;
+}
+
+// takes ownership of engine on success; on failure engine is left untouched
+EngineBase* CreateReflowEngineFromEngine(EngineBase* engine) {
+    if (!engine || engine->IsImageCollection()) {
+        return nullptr;
+    }
+    return EngineReflow::CreateFromEngine(engine);
+}
+
 void EngineEbookCleanup() {
     gDefaultFontName.Reset();
 }
@@ -11,6 +11,10 @@ EngineBase* CreatePdbEngineFromFile(const WCHAR* fileName);
 EngineBase* CreateChmEngineFromFile(const WCHAR* fileName);
 EngineBase* CreateHtmlEngineFromFile(const WCHAR* fileName);
 EngineBase* CreateTxtEngineFromFile(const WCHAR* fileName);
+// reflows the extracted text of a fixed-layout document (e.g. a PDF) like
+// an ebook; takes ownership of engine on success, on failure (no text to
+// reflow) returns nullptr and leaves engine untouched
+EngineBase* CreateReflowEngineFromEngine(EngineBase* engine);
 
 void SetDefaultEbookFont(const WCHAR* name, float size);
 void EngineEbookCleanup();
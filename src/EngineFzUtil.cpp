@@ -9,13 +9,16 @@ extern "C" {
 
 #include "utils/BaseUtil.h"
 #include "utils/Archive.h"
+#include "utils/CryptoUtil.h"
 #include "utils/ScopedWin.h"
 #include "utils/FileUtil.h"
+#include "utils/HttpUtil.h"
 #include "utils/HtmlParserLookup.h"
 #include "utils/HtmlPullParser.h"
 #include "utils/TrivialHtmlParser.h"
 #include "utils/WinUtil.h"
 #include "utils/ZipUtil.h"
+#include "utils/MemAccounting.h"
 #include "utils/Log.h"
 
 #include "AppColors.h"
@@ -24,6 +27,7 @@ extern "C" {
 #include "Annotation.h"
 #include "EngineBase.h"
 #include "EngineFzUtil.h"
+#include "DibPool.h"
 
 // extensions to Fitz that are usable for both PDF and XPS
 
@@ -32,6 +36,56 @@ extern "C" {
 // so that their content can be loaded on demand in order to preserve memory
 #define MAX_MEMORY_FILE_SIZE (32 * 1024 * 1024)
 
+/* Counting allocator handed to fz_new_context. Each block gets a header
+   remembering its size (16 bytes, so the returned pointer is as aligned
+   as malloc() would be) and the live total is counted against
+   memacct::SubsysMupdf. */
+
+struct FzAllocHeader {
+    size_t size;
+    size_t unused;
+};
+
+static void* fz_malloc_counting([[maybe_unused]] void* user, size_t size) {
+    auto h = (FzAllocHeader*)malloc(sizeof(FzAllocHeader) + size);
+    if (!h) {
+        return nullptr;
+    }
+    h->size = size;
+    memacct::Add(memacct::SubsysMupdf, (i64)size);
+    return h + 1;
+}
+
+static void* fz_realloc_counting(void* user, void* old, size_t size) {
+    if (!old) {
+        return fz_malloc_counting(user, size);
+    }
+    auto h = (FzAllocHeader*)old - 1;
+    i64 oldSize = (i64)h->size;
+    h = (FzAllocHeader*)realloc(h, sizeof(FzAllocHeader) + size);
+    if (!h) {
+        return nullptr;
+    }
+    h->size = size;
+    memacct::Add(memacct::SubsysMupdf, (i64)size - oldSize);
+    return h + 1;
+}
+
+static void fz_free_counting([[maybe_unused]] void* user, void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    auto h = (FzAllocHeader*)ptr - 1;
+    memacct::Add(memacct::SubsysMupdf, -(i64)h->size);
+    free(h);
+}
+
+static fz_alloc_context fz_alloc_ctx_counting = {nullptr, fz_malloc_counting, fz_realloc_counting, fz_free_counting};
+
+fz_alloc_context* fz_memacct_alloc_ctx() {
+    return &fz_alloc_ctx_counting;
+}
+
 RectF ToRectFl(fz_rect rect) {
     return RectF::FromXY(rect.x0, rect.y0, rect.x1, rect.y1);
 }
@@ -160,6 +214,186 @@ fz_stream* fz_open_istream(fz_context* ctx, IStream* stream) {
     return stm;
 }
 
+struct mapped_file_filter {
+    HANDLE hFile;
+    HANDLE hMap;
+    u8* data;
+    i64 size;
+};
+
+extern "C" int next_mapped(fz_context* ctx, fz_stream* stm, [[maybe_unused]] size_t max) {
+    mapped_file_filter* state = (mapped_file_filter*)stm->state;
+    if (stm->pos >= state->size) {
+        stm->rp = stm->wp;
+        return EOF;
+    }
+    // the whole file is mapped, hand out everything from the current
+    // position; the OS pages the data in as mupdf reads it
+    stm->rp = state->data + stm->pos;
+    stm->wp = state->data + state->size;
+    stm->pos = state->size;
+    return *stm->rp++;
+}
+
+extern "C" void seek_mapped(fz_context* ctx, fz_stream* stm, i64 offset, int whence) {
+    mapped_file_filter* state = (mapped_file_filter*)stm->state;
+    i64 pos = stm->pos - (stm->wp - stm->rp);
+    if (1 == whence) {
+        pos += offset;
+    } else if (2 == whence) {
+        pos = state->size + offset;
+    } else {
+        pos = offset;
+    }
+    pos = limitValue(pos, (i64)0, state->size);
+    stm->pos = pos;
+    stm->rp = stm->wp = state->data + pos;
+}
+
+extern "C" void drop_mapped(fz_context* ctx, void* state_) {
+    mapped_file_filter* state = (mapped_file_filter*)state_;
+    UnmapViewOfFile(state->data);
+    CloseHandle(state->hMap);
+    CloseHandle(state->hFile);
+    fz_free(ctx, state);
+}
+
+// opens the file as a stream backed by a memory-mapped view. returns
+// nullptr when mapping isn't possible (e.g. an empty file or no address
+// space for the view in a 32-bit build) and the caller should fall back
+// to regular file reads
+static fz_stream* fz_open_file_mapped(fz_context* ctx, const WCHAR* filePath) {
+    HANDLE hFile = CreateFileW(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(hFile, &size) || 0 == size.QuadPart) {
+        CloseHandle(hFile);
+        return nullptr;
+    }
+    HANDLE hMap = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMap) {
+        CloseHandle(hFile);
+        return nullptr;
+    }
+    u8* data = (u8*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(hMap);
+        CloseHandle(hFile);
+        return nullptr;
+    }
+
+    mapped_file_filter* state = fz_malloc_struct(ctx, mapped_file_filter);
+    state->hFile = hFile;
+    state->hMap = hMap;
+    state->data = data;
+    state->size = size.QuadPart;
+
+    fz_stream* stm = fz_new_stream(ctx, state, next_mapped, drop_mapped);
+    stm->seek = seek_mapped;
+    return stm;
+}
+
+// granularity of the block cache behind fz_open_url. small enough that
+// the first page of a linearized PDF costs only a few requests, large
+// enough to keep the request count reasonable when reading sequentially
+#define URL_STREAM_BLOCK_SIZE (64 * 1024)
+
+struct url_stream_filter {
+    WCHAR* url;
+    i64 size;
+    int blockCount;
+    u8** blocks; // lazily downloaded blocks of URL_STREAM_BLOCK_SIZE bytes each
+    u8 empty[1]; // rp/wp point here after a seek, until the next read
+};
+
+extern "C" int next_url(fz_context* ctx, fz_stream* stm, [[maybe_unused]] size_t max) {
+    url_stream_filter* state = (url_stream_filter*)stm->state;
+    i64 pos = stm->pos;
+    if (pos >= state->size) {
+        stm->rp = stm->wp;
+        return EOF;
+    }
+    int blockNo = (int)(pos / URL_STREAM_BLOCK_SIZE);
+    i64 blockStart = (i64)blockNo * URL_STREAM_BLOCK_SIZE;
+    i64 blockLen = state->size - blockStart;
+    if (blockLen > URL_STREAM_BLOCK_SIZE) {
+        blockLen = URL_STREAM_BLOCK_SIZE;
+    }
+    u8* block = state->blocks[blockNo];
+    if (!block) {
+        // fz_throw longjmps, so keep the HttpRsp destructor out of its way
+        {
+            HttpRsp rsp;
+            if (HttpGetRange(state->url, blockStart, blockLen, &rsp) && (i64)rsp.data.size() == blockLen) {
+                block = (u8*)fz_malloc_no_throw(ctx, (size_t)blockLen);
+            }
+            if (block) {
+                memcpy(block, rsp.data.Get(), (size_t)blockLen);
+                state->blocks[blockNo] = block;
+            }
+        }
+        if (!block) {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "failed to download block %d", blockNo);
+        }
+    }
+    stm->rp = block + (pos - blockStart);
+    stm->wp = block + blockLen;
+    stm->pos = blockStart + blockLen;
+    return *stm->rp++;
+}
+
+extern "C" void seek_url(fz_context* ctx, fz_stream* stm, i64 offset, int whence) {
+    url_stream_filter* state = (url_stream_filter*)stm->state;
+    i64 pos = stm->pos - (stm->wp - stm->rp);
+    if (1 == whence) {
+        pos += offset;
+    } else if (2 == whence) {
+        pos = state->size + offset;
+    } else {
+        pos = offset;
+    }
+    pos = limitValue(pos, (i64)0, state->size);
+    stm->pos = pos;
+    // nothing buffered at the new position; next_url downloads on demand
+    stm->rp = stm->wp = state->empty;
+}
+
+extern "C" void drop_url(fz_context* ctx, void* state_) {
+    url_stream_filter* state = (url_stream_filter*)state_;
+    for (int i = 0; i < state->blockCount; i++) {
+        fz_free(ctx, state->blocks[i]);
+    }
+    free(state->blocks);
+    str::Free(state->url);
+    fz_free(ctx, state);
+}
+
+// opens an http(s) url as a seekable stream that downloads fixed-size
+// blocks on demand via HTTP range requests and caches them for the
+// lifetime of the stream. a linearized PDF only needs a few blocks from
+// the start of the file to render its first page, so it's displayed long
+// before a full download would have finished. returns nullptr when the
+// server doesn't support range requests
+static fz_stream* fz_open_url(fz_context* ctx, const WCHAR* url) {
+    i64 size = HttpGetContentSize(url);
+    if (size <= 0) {
+        return nullptr;
+    }
+
+    int blockCount = (int)((size + URL_STREAM_BLOCK_SIZE - 1) / URL_STREAM_BLOCK_SIZE);
+    url_stream_filter* state = fz_malloc_struct(ctx, url_stream_filter);
+    state->url = str::Dup(url);
+    state->size = size;
+    state->blockCount = blockCount;
+    state->blocks = AllocArray<u8*>(blockCount);
+
+    fz_stream* stm = fz_new_stream(ctx, state, next_url, drop_url);
+    stm->seek = seek_url;
+    return stm;
+}
+
 void* fz_memdup(fz_context* ctx, void* p, size_t size) {
     void* res = fz_malloc_no_throw(ctx, size);
     if (!res) {
@@ -171,6 +405,9 @@ void* fz_memdup(fz_context* ctx, void* p, size_t size) {
 
 fz_stream* fz_open_file2(fz_context* ctx, const WCHAR* filePath) {
     fz_stream* stm = nullptr;
+    if (path::IsUrl(filePath)) {
+        return fz_open_url(ctx, filePath);
+    }
     AutoFreeStr path = strconv::WstrToUtf8(filePath);
     i64 fileSize = file::GetSize(path.AsView());
     // load small files entirely into memory so that they can be
@@ -208,6 +445,14 @@ fz_stream* fz_open_file2(fz_context* ctx, const WCHAR* filePath) {
         return stm;
     }
 
+    // map large files instead of reading them: only the xref and the
+    // objects mupdf actually touches get paged in, so the time to the
+    // first page doesn't depend on file size
+    stm = fz_open_file_mapped(ctx, filePath);
+    if (stm) {
+        return stm;
+    }
+
     fz_try(ctx) {
         stm = fz_open_file_w(ctx, filePath);
     }
@@ -237,31 +482,83 @@ std::span<u8> fz_extract_stream_data(fz_context* ctx, fz_stream* stream) {
     return {res, size};
 }
 
+// streams up to this size are read whole and hashed in full, which keeps
+// the fingerprint identical to the ones older versions stored (e.g. as
+// part of a cached decryption key); larger ones get a sampled fingerprint
+#define FZ_FULL_FINGERPRINT_MAX_SIZE (16 * 1024 * 1024)
+#define FZ_FINGERPRINT_BLOCK_SIZE (64 * 1024)
+#define FZ_FINGERPRINT_STRIDE_BLOCKS 14
+
+static void fz_md5_stream_range(fz_context* ctx, fz_stream* stm, fz_md5* md5, i64 offset, i64 size, u8* buf) {
+    fz_seek(ctx, stm, offset, 0);
+    while (size > 0) {
+        i64 toRead = FZ_FINGERPRINT_BLOCK_SIZE;
+        if (size < toRead) {
+            toRead = size;
+        }
+        size_t nRead = fz_read(ctx, stm, buf, (size_t)toRead);
+        if (0 == nRead) {
+            fz_throw(ctx, FZ_ERROR_GENERIC, "premature end of stream");
+        }
+        fz_md5_update(md5, buf, (unsigned int)nRead);
+        size -= (i64)nRead;
+    }
+}
+
+/* MD5 fingerprint identifying the stream's content (e.g. for matching a
+   document against its cached decryption key in file history). Small
+   streams are hashed in full; for anything larger the hash covers the
+   length plus head, tail and evenly strided sample blocks, so identity
+   checks don't read gigabytes. The worst case of the sampled scheme - a
+   huge encrypted document edited without a size change going undetected -
+   merely re-prompts for a password or re-enters it needlessly. */
 void fz_stream_fingerprint(fz_context* ctx, fz_stream* stm, u8 digest[16]) {
     i64 fileLen = -1;
     fz_buffer* buf = nullptr;
+    u8* block = nullptr;
 
     fz_try(ctx) {
         fz_seek(ctx, stm, 0, 2);
         fileLen = fz_tell(ctx, stm);
-        fz_seek(ctx, stm, 0, 0);
-        buf = fz_read_all(ctx, stm, fileLen);
+        if (fileLen <= FZ_FULL_FINGERPRINT_MAX_SIZE) {
+            fz_seek(ctx, stm, 0, 0);
+            buf = fz_read_all(ctx, stm, fileLen);
+        } else {
+            block = (u8*)fz_malloc(ctx, FZ_FINGERPRINT_BLOCK_SIZE);
+            fz_md5 md5;
+            fz_md5_init(&md5);
+            fz_md5_update(&md5, (u8*)&fileLen, sizeof(fileLen));
+            fz_md5_stream_range(ctx, stm, &md5, 0, FZ_FINGERPRINT_BLOCK_SIZE, block);
+            i64 stride = (fileLen - 2 * (i64)FZ_FINGERPRINT_BLOCK_SIZE) / (FZ_FINGERPRINT_STRIDE_BLOCKS + 1);
+            for (int i = 1; i <= FZ_FINGERPRINT_STRIDE_BLOCKS; i++) {
+                fz_md5_stream_range(ctx, stm, &md5, FZ_FINGERPRINT_BLOCK_SIZE + stride * i,
+                                    FZ_FINGERPRINT_BLOCK_SIZE, block);
+            }
+            fz_md5_stream_range(ctx, stm, &md5, fileLen - FZ_FINGERPRINT_BLOCK_SIZE, FZ_FINGERPRINT_BLOCK_SIZE, block);
+            fz_md5_final(&md5, digest);
+        }
+    }
+    fz_always(ctx) {
+        fz_free(ctx, block);
     }
     fz_catch(ctx) {
         fz_warn(ctx, "couldn't read stream data, using a nullptr fingerprint instead");
         ZeroMemory(digest, 16);
         return;
     }
-    CrashIf(nullptr == buf);
+    if (!buf) {
+        // the sampled path already filled in the digest
+        return;
+    }
     u8* data;
     size_t size = fz_buffer_extract(ctx, buf, &data);
     CrashIf((size_t)fileLen != size);
     fz_drop_buffer(ctx, buf);
 
-    fz_md5 md5;
-    fz_md5_init(&md5);
-    fz_md5_update(&md5, data, size);
-    fz_md5_final(&md5, digest);
+    // CryptoAPI rather than fz_md5 so that full-content hashing uses the
+    // platform's accelerated implementation; the digest is the same
+    CalcMD5DigestWin(data, size, digest);
+    fz_free(ctx, data);
 }
 
 // try to produce an 8-bit palette for saving some memory
@@ -416,11 +713,19 @@ RenderedBitmap* new_rendered_fz_pixmap(fz_context* ctx, fz_pixmap* pixmap) {
     bmih->biClrUsed = 0;
 
     void* data = nullptr;
-    HANDLE hFile = INVALID_HANDLE_VALUE;
-    DWORD fl = PAGE_READWRITE;
-    HANDLE hMap = CreateFileMappingW(hFile, nullptr, fl, 0, imgSize, nullptr);
-    uint usage = DIB_RGB_COLORS;
-    HBITMAP hbmp = CreateDIBSection(nullptr, bmi, usage, &data, hMap, 0);
+    HANDLE hMap = nullptr;
+    HBITMAP hbmp = nullptr;
+    if (n == 4 && bgrPixmap->stride == (i64)w * 4) {
+        // the pooled sections are 32bpp with packed rows; RenderedBitmap's
+        // destructor gives them back to the pool
+        hbmp = DibPoolAcquire(w, h, &data);
+    } else {
+        HANDLE hFile = INVALID_HANDLE_VALUE;
+        DWORD fl = PAGE_READWRITE;
+        hMap = CreateFileMappingW(hFile, nullptr, fl, 0, imgSize, nullptr);
+        uint usage = DIB_RGB_COLORS;
+        hbmp = CreateDIBSection(nullptr, bmi, usage, &data, hMap, 0);
+    }
     if (data) {
         u8* samples = bgrPixmap->samples;
         memcpy(data, samples, imgSize);
@@ -435,6 +740,49 @@ RenderedBitmap* new_rendered_fz_pixmap(fz_context* ctx, fz_pixmap* pixmap) {
     return new RenderedBitmap(hbmp, Size(w, h), hMap);
 }
 
+// creates a BGRA pixmap whose samples live directly inside a DIB section, so
+// that the draw device rasterizes straight into the bitmap that later gets
+// blitted to screen. Compared to new_rendered_fz_pixmap this skips both the
+// colorspace-converted copy of the pixmap and the memcpy into the DIB.
+// the section comes from DibPool (its backing mapping handle stays with the
+// pool, so *hMapOut is always nullptr); on success the caller owns hbmpOut
+// (usually by handing it to a RenderedBitmap, whose destructor returns it
+// to the pool). returns nullptr if no DIB can be created, in which case
+// the caller should fall back to a plain pixmap
+fz_pixmap* fz_new_pixmap_in_dib_section(fz_context* ctx, fz_irect bbox, HBITMAP* hbmpOut, HANDLE* hMapOut) {
+    *hbmpOut = nullptr;
+    *hMapOut = nullptr;
+
+    int w = bbox.x1 - bbox.x0;
+    int h = bbox.y1 - bbox.y0;
+    // 32bpp top-down DIB rows have no padding, so its layout matches the pixmap's
+    i64 imgSize = (i64)w * 4 * h;
+    if (w <= 0 || h <= 0 || imgSize > INT_MAX) {
+        return nullptr;
+    }
+
+    void* data = nullptr;
+    HBITMAP hbmp = DibPoolAcquire(w, h, &data);
+    if (!hbmp || !data) {
+        return nullptr;
+    }
+
+    fz_pixmap* pix = nullptr;
+    fz_try(ctx) {
+        // the pixmap doesn't take ownership of the samples
+        pix = fz_new_pixmap_with_bbox_and_data(ctx, fz_device_bgr(ctx), bbox, nullptr, 1, (u8*)data);
+    }
+    fz_catch(ctx) {
+        pix = nullptr;
+    }
+    if (!pix) {
+        DibPoolRelease(hbmp);
+        return nullptr;
+    }
+    *hbmpOut = hbmp;
+    return pix;
+}
+
 static inline int wchars_per_rune(int rune) {
     if (rune & 0x1F0000) {
         return 2;
@@ -995,15 +1343,33 @@ static RectF CalcDestRect(fz_link* link, fz_outline* outline) {
 #endif
 }
 
+// moves a heap-allocated string into pool and frees the original;
+// returns the string unchanged if pool is nullptr
+static WCHAR* MoveToPool(PoolAllocator* pool, WCHAR* s) {
+    if (!pool || !s) {
+        return s;
+    }
+    WCHAR* res = Allocator::StrDup(pool, s);
+    free(s);
+    return res;
+}
+
 // TODO: clean this up
-PageDestination* newFzDestination(fz_outline* outline) {
+// if pool is given, the destination and its strings are allocated out of
+// it and the destructor is never run (see TocTree::allocator)
+PageDestination* newFzDestination(fz_outline* outline, PoolAllocator* pool) {
     fz_link* link = nullptr;
-    auto dest = new PageDestination();
+    PageDestination* dest;
+    if (pool) {
+        dest = new (pool->Alloc(sizeof(PageDestination))) PageDestination();
+    } else {
+        dest = new PageDestination();
+    }
     dest->kind = CalcDestKind(link, outline);
     CrashIf(!dest->kind);
     dest->rect = CalcDestRect(link, outline);
-    dest->value = CalcValue(link, outline);
-    dest->name = CalcDestName(link, outline);
+    dest->value = MoveToPool(pool, CalcValue(link, outline));
+    dest->name = MoveToPool(pool, CalcDestName(link, outline));
     dest->pageNo = CalcDestPageNo(link, outline);
     return dest;
 }
@@ -1039,55 +1405,54 @@ PageElement* newFzImage(int pageNo, fz_rect rect, size_t imageIdx) {
     return res;
 }
 
-TocItem* newTocItemWithDestination(TocItem* parent, WCHAR* title, PageDestination* dest) {
-    auto res = new TocItem(parent, title, 0);
+// if pool is given, the item and its title are allocated out of it and
+// the destructor is never run (see TocTree::allocator)
+TocItem* newTocItemWithDestination(TocItem* parent, WCHAR* title, PageDestination* dest, PoolAllocator* pool) {
+    TocItem* res;
+    if (pool) {
+        res = new (pool->Alloc(sizeof(TocItem))) TocItem();
+        res->parent = parent;
+        res->title = Allocator::StrDup(pool, title);
+    } else {
+        res = new TocItem(parent, title, 0);
+    }
     res->dest = dest;
     return res;
 }
 
 IPageElement* FzGetElementAtPos(FzPageInfo* pageInfo, PointF pt) {
-    if (!pageInfo) {
+    Vec<IPageElement*>* els = FzGetElements(pageInfo);
+    if (!els) {
         return nullptr;
     }
-    int pageNo = pageInfo->pageNo;
-    fz_link* link = pageInfo->links;
-    fz_point p = {(float)pt.x, (float)pt.y};
-    while (link) {
-        if (fz_is_pt_in_rect(link->rect, p)) {
-            return newFzLink(pageNo, link, nullptr);
-        }
-        link = link->next;
-    }
-
-    for (auto* pel : pageInfo->autoLinks) {
-        if (pel->GetRect().Contains(pt)) {
-            return clonePageElement(pel);
-        }
-    }
-
-    for (auto* pel : pageInfo->comments) {
-        if (pel->GetRect().Contains(pt)) {
-            return clonePageElement(pel);
-        }
-    }
-
-    size_t imageIdx = 0;
-    for (auto& img : pageInfo->images) {
-        fz_rect ir = img.rect;
-        if (fz_is_pt_in_rect(ir, p)) {
-            return newFzImage(pageNo, ir, imageIdx);
+    // links win over comments win over images when they overlap
+    Kind kinds[] = {kindPageElementDest, kindPageElementComment, kindPageElementImage};
+    for (Kind kind : kinds) {
+        for (auto* el : *els) {
+            if (el->Is(kind) && el->GetRect().Contains(pt)) {
+                return el;
+            }
         }
-        imageIdx++;
     }
     return nullptr;
 }
 
-// TODO: construct this only once per page and change the API
-// to not free the result of GetElements()
-void FzGetElements(Vec<IPageElement*>* els, FzPageInfo* pageInfo) {
+// the returned Vec and its elements are owned by the engine: built once
+// per page, shared by all callers, freed in the engine's destructor
+Vec<IPageElement*>* FzGetElements(FzPageInfo* pageInfo) {
     if (!pageInfo) {
-        return;
+        return nullptr;
+    }
+    if (pageInfo->elementsBuilt) {
+        return &pageInfo->elements;
+    }
+    if (!pageInfo->fullyLoaded) {
+        // links / comments / images not extracted yet; caching now would
+        // pin an empty list
+        return nullptr;
     }
+    pageInfo->elementsBuilt = true;
+    Vec<IPageElement*>* els = &pageInfo->elements;
 
     // since all elements lists are in last-to-first order, append
     // item types in inverse order and reverse the whole list at the end
@@ -1119,6 +1484,7 @@ void FzGetElements(Vec<IPageElement*>* els, FzPageInfo* pageInfo) {
     }
 
     els->Reverse();
+    return els;
 }
 
 void FzLinkifyPageText(FzPageInfo* pageInfo, fz_stext_page* stext) {
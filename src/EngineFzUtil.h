@@ -37,12 +37,32 @@ struct FzPageInfo {
     // comments are made out of annotations
     Vec<IPageElement*> comments;
 
+    // page elements (links, comments, images) in the order returned by
+    // GetElements(), built lazily by FzGetElements() and owned by the
+    // engine. The elements own all their data, so unlike links / comments
+    // above the cache survives page eviction and pointers handed out to
+    // callers stay valid for the life of the engine
+    Vec<IPageElement*> elements;
+    bool elementsBuilt = false;
+
     RectF mediabox = {};
     Vec<FitzImagePos> images;
 
+    // cached record of the page's content stream; re-rendering at a new
+    // zoom / rotation replays it instead of re-interpreting the page
+    fz_display_list* displayList = nullptr;
+    // the annotations' (and widgets') appearance streams, recorded
+    // separately so that editing an annotation only invalidates this
+    // list and not the page contents above
+    fz_display_list* annotsList = nullptr;
+
     // if false, only loaded page (fast)
     // if true, loaded expensive info (extracted text etc.)
     bool fullyLoaded = false;
+
+    // tick of the most recent GetFzPageInfo() for this page, used to
+    // evict page objects that haven't been touched in a while
+    DWORD lastUseTimestamp = 0;
 };
 
 struct LinkRectList {
@@ -50,6 +70,10 @@ struct LinkRectList {
     Vec<fz_rect> coords;
 };
 
+// allocator for fz_new_context that counts live bytes against
+// memacct::SubsysMupdf, so that crash reports can attribute memory use
+fz_alloc_context* fz_memacct_alloc_ctx();
+
 fz_rect To_fz_rect(RectF rect);
 RectF ToRectFl(fz_rect rect);
 fz_matrix fz_create_view_ctm(fz_rect mediabox, float zoom, int rotation);
@@ -66,18 +90,21 @@ void fz_stream_fingerprint(fz_context* ctx, fz_stream* stm, u8 digest[16]);
 std::span<u8> fz_extract_stream_data(fz_context* ctx, fz_stream* stream);
 
 RenderedBitmap* new_rendered_fz_pixmap(fz_context* ctx, fz_pixmap* pixmap);
+// a pixmap that rasterizes directly into a DIB section (no copy when handing
+// the result to a RenderedBitmap); nullptr means fall back to a plain pixmap
+fz_pixmap* fz_new_pixmap_in_dib_section(fz_context* ctx, fz_irect bbox, HBITMAP* hbmpOut, HANDLE* hMapOut);
 
 WCHAR* fz_text_page_to_str(fz_stext_page* text, Rect** coordsOut);
 
 LinkRectList* LinkifyText(const WCHAR* pageText, Rect* coords);
 int is_external_link(const char* uri);
 int resolve_link(const char* uri, float* xp, float* yp);
-TocItem* newTocItemWithDestination(TocItem* parent, WCHAR* title, PageDestination* dest);
+TocItem* newTocItemWithDestination(TocItem* parent, WCHAR* title, PageDestination* dest, PoolAllocator* pool = nullptr);
 PageElement* newFzImage(int pageNo, fz_rect rect, size_t imageIdx);
 PageElement* newFzLink(int pageNo, fz_link* link, fz_outline* outline);
-PageDestination* newFzDestination(fz_outline*);
+PageDestination* newFzDestination(fz_outline*, PoolAllocator* pool = nullptr);
 IPageElement* FzGetElementAtPos(FzPageInfo* pageInfo, PointF pt);
-void FzGetElements(Vec<IPageElement*>* els, FzPageInfo* pageInfo);
+Vec<IPageElement*>* FzGetElements(FzPageInfo* pageInfo);
 void FzLinkifyPageText(FzPageInfo* pageInfo, fz_stext_page* stext);
 fz_pixmap* fz_convert_pixmap2(fz_context* ctx, fz_pixmap* pix, fz_colorspace* ds, fz_colorspace* prf,
                               fz_default_colorspaces* default_cs, fz_color_params color_params, int keep_alpha);
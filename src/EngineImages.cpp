@@ -12,6 +12,7 @@
 #include "utils/HtmlPullParser.h"
 #include "utils/JsonParser.h"
 #include "utils/WinUtil.h"
+#include "utils/ThreadUtil.h"
 #include "utils/Timer.h"
 #include "utils/DirIter.h"
 #include "utils/Log.h"
@@ -71,6 +72,9 @@ Kind kindEngineComicBooks = "engineComicBooks";
 // number of decoded bitmaps to cache for quicker rendering
 #define MAX_IMAGE_PAGE_CACHE 10
 
+// number of pages past the last requested one to decode in the background
+#define MAX_DECODE_AHEAD_PAGES 3
+
 ///// EngineImages methods apply to all types of engines handling full-page images /////
 
 struct ImagePage {
@@ -124,6 +128,9 @@ class EngineImages : public EngineBase {
     CRITICAL_SECTION cacheAccess;
     Vec<ImagePage*> pageCache;
     Vec<RectF> mediaboxes;
+    // per-page element lists built once; the lists and their elements
+    // are owned by the engine (see EngineBase.h)
+    Vec<IPageElement*>** pageElements = nullptr;
 
     void GetTransform(Matrix& m, int pageNo, float zoom, int rotation);
 
@@ -132,6 +139,17 @@ class EngineImages : public EngineBase {
 
     ImagePage* GetPage(int pageNo, bool tryOnly = false);
     void DropPage(ImagePage* page, bool forceRemove);
+
+    // only enabled where LoadBitmapForPage() is safe to call from
+    // multiple threads at once (currently EngineCbx)
+    bool decodeAheadEnabled = false;
+    // guarded by cacheAccess
+    Vec<int> pagesBeingDecoded;
+    volatile LONG pendingDecodes = 0;
+
+    void DecodePagesAhead(int pageNo);
+    void DecodePageInBackground(int pageNo);
+    void WaitForPendingDecodes();
 };
 
 EngineImages::EngineImages() {
@@ -144,12 +162,22 @@ EngineImages::EngineImages() {
 }
 
 EngineImages::~EngineImages() {
+    WaitForPendingDecodes();
     EnterCriticalSection(&cacheAccess);
     while (pageCache.size() > 0) {
         ImagePage* lastPage = pageCache.Last();
         CrashIf(lastPage->refs != 1);
         DropPage(lastPage, true);
     }
+    if (pageElements) {
+        for (int i = 0; i < pageCount; i++) {
+            if (pageElements[i]) {
+                DeleteVecMembers(*pageElements[i]);
+                delete pageElements[i];
+            }
+        }
+        free(pageElements);
+    }
     LeaveCriticalSection(&cacheAccess);
     DeleteCriticalSection(&cacheAccess);
 }
@@ -245,29 +273,30 @@ RectF EngineImages::Transform(const RectF& rect, int pageNo, float zoom, int rot
     return res;
 }
 
-static PageElement* newImageElement(ImagePage* page) {
+static PageElement* newImageElement(int pageNo, RectF rect) {
     auto res = new PageElement();
     res->kind_ = kindPageElementImage;
-    res->pageNo = page->pageNo;
-    int dx = page->bmp->GetWidth();
-    int dy = page->bmp->GetHeight();
-    res->rect = RectF(0, 0, (float)dx, (float)dy);
-    res->imageID = page->pageNo;
+    res->pageNo = pageNo;
+    res->rect = RectF(0, 0, rect.dx, rect.dy);
+    res->imageID = pageNo;
     return res;
 }
 
 Vec<IPageElement*>* EngineImages::GetElements(int pageNo) {
-    // TODO: this is inefficient because we don't need to
-    // decompress the image. just need to know the size
-    ImagePage* page = GetPage(pageNo);
-    if (!page) {
-        return nullptr;
-    }
+    // the image covers the whole page, so the size is known without
+    // having to decompress the image
+    RectF mbox = PageMediabox(pageNo);
 
+    ScopedCritSec scope(&cacheAccess);
+    if (!pageElements) {
+        pageElements = AllocArray<Vec<IPageElement*>*>(pageCount);
+    }
+    if (pageElements[pageNo - 1]) {
+        return pageElements[pageNo - 1];
+    }
     auto els = new Vec<IPageElement*>();
-    auto el = newImageElement(page);
-    els->Append(el);
-    DropPage(page, false);
+    els->Append(newImageElement(pageNo, mbox));
+    pageElements[pageNo - 1] = els;
     return els;
 }
 
@@ -275,13 +304,11 @@ IPageElement* EngineImages::GetElementAtPos(int pageNo, PointF pt) {
     if (!PageMediabox(pageNo).Contains(pt)) {
         return nullptr;
     }
-    ImagePage* page = GetPage(pageNo);
-    if (!page) {
+    Vec<IPageElement*>* els = GetElements(pageNo);
+    if (!els || els->IsEmpty()) {
         return nullptr;
     }
-    auto res = newImageElement(page);
-    DropPage(page, false);
-    return res;
+    return els->at(0);
 }
 
 RenderedBitmap* EngineImages::GetImageForPageElement(IPageElement* ipel) {
@@ -360,10 +387,85 @@ ImagePage* EngineImages::GetPage(int pageNo, bool tryOnly) {
         return nullptr;
     }
 
+    if (!tryOnly) {
+        // the user is likely to need the following pages next
+        DecodePagesAhead(pageNo);
+    }
+
     result->refs++;
     return result;
 }
 
+// decode a single page on a worker thread and put it in pageCache, so
+// that a following GetPage() finds it already decoded
+void EngineImages::DecodePageInBackground(int pageNo) {
+    {
+        ScopedCritSec scope(&cacheAccess);
+        for (size_t i = 0; i < pageCache.size(); i++) {
+            if (pageCache.at(i)->pageNo == pageNo) {
+                return;
+            }
+        }
+        if (pagesBeingDecoded.Contains(pageNo)) {
+            return;
+        }
+        pagesBeingDecoded.Append(pageNo);
+    }
+
+    InterlockedIncrement(&pendingDecodes);
+    // decode on the shared thread pool instead of a dedicated thread, so
+    // that decoding several pages ahead doesn't oversubscribe the cores
+    TaskHandle* task = GetThreadPool()->Submit(
+        [this, pageNo] {
+            bool deleteAfterUse = false;
+            Bitmap* bmp = LoadBitmapForPage(pageNo, deleteAfterUse);
+
+            EnterCriticalSection(&cacheAccess);
+            pagesBeingDecoded.Remove(pageNo);
+            bool keep = bmp && pageCache.size() < MAX_IMAGE_PAGE_CACHE;
+            for (size_t i = 0; keep && i < pageCache.size(); i++) {
+                if (pageCache.at(i)->pageNo == pageNo) {
+                    // someone decoded it in the meantime
+                    keep = false;
+                }
+            }
+            if (keep) {
+                ImagePage* page = new ImagePage(pageNo, bmp);
+                page->ownBmp = deleteAfterUse;
+                pageCache.InsertAt(0, page);
+            }
+            LeaveCriticalSection(&cacheAccess);
+
+            if (!keep && bmp && deleteAfterUse) {
+                delete bmp;
+            }
+            InterlockedDecrement(&pendingDecodes);
+        },
+        TaskPriority::Prefetch);
+    DropTaskHandle(task);
+}
+
+// decode the pages following pageNo in the background so that turning
+// the page doesn't have to wait for a (possibly slow) JPEG decode
+void EngineImages::DecodePagesAhead(int pageNo) {
+    if (!decodeAheadEnabled) {
+        return;
+    }
+    for (int i = 1; i <= MAX_DECODE_AHEAD_PAGES; i++) {
+        if (pageNo + i > pageCount) {
+            break;
+        }
+        DecodePageInBackground(pageNo + i);
+    }
+}
+
+// must be called before the data LoadBitmapForPage() reads is freed
+void EngineImages::WaitForPendingDecodes() {
+    while (InterlockedCompareExchange(&pendingDecodes, 0, 0) > 0) {
+        Sleep(1);
+    }
+}
+
 void EngineImages::DropPage(ImagePage* page, bool forceRemove) {
     ScopedCritSec scope(&cacheAccess);
     page->refs--;
@@ -909,13 +1011,18 @@ class EngineCbx : public EngineImages, public json::ValueVisitor {
 EngineCbx::EngineCbx(MultiFormatArchive* arch) {
     cbxFile = arch;
     kind = kindEngineComicBooks;
+    // LoadBitmapForPage() only reads the immutable images array
+    decodeAheadEnabled = true;
 }
 
 EngineCbx::~EngineCbx() {
+    // background decodes read the images array freed below
+    WaitForPendingDecodes();
+
     delete tocTree;
 
-    // can be set in error conditions but generally is
-    // deleted in FinishLoading
+    // kept alive after FinishLoading so that entries can be
+    // decompressed on first use
     delete cbxFile;
 
     for (auto&& img : images) {
@@ -1063,17 +1170,10 @@ bool EngineCbx::FinishLoading() {
     }
     tocTree = new TocTree(root);
 
-    for (int i = 0; i < pageCount; i++) {
-        size_t fileId = files[i]->fileId;
-        std::span<u8> sv = cbxFile->GetFileDataById(fileId);
-        ImageData img;
-        img.data = (char*)sv.data();
-        img.len = sv.size();
-        images.Append(img);
-    }
-
-    delete cbxFile;
-    cbxFile = nullptr;
+    // entries are decompressed lazily in GetImageData(): unpacking a
+    // multi-GB archive up front would delay showing the first page by
+    // seconds. cbxFile is kept alive for that (guarded by cacheAccess)
+    images.AppendBlanks(nFiles);
 
     return true;
 }
@@ -1084,7 +1184,15 @@ TocTree* EngineCbx::GetToc() {
 
 ImageData EngineCbx::GetImageData(int pageNo) {
     CrashIf((pageNo < 1) || (pageNo > PageCount()));
-    return images[pageNo - 1];
+    ScopedCritSec scope(&cacheAccess);
+    ImageData& img = images[pageNo - 1];
+    if (!img.data && cbxFile) {
+        size_t fileId = files[pageNo - 1]->fileId;
+        std::span<u8> sv = cbxFile->GetFileDataById(fileId);
+        img.data = (char*)sv.data();
+        img.len = sv.size();
+    }
+    return img;
 }
 
 static char* GetTextContent(HtmlPullParser& parser) {
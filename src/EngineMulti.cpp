@@ -15,6 +15,7 @@ extern "C" {
 #include "utils/HtmlParserLookup.h"
 #include "utils/HtmlPullParser.h"
 #include "utils/TrivialHtmlParser.h"
+#include "utils/ThreadUtil.h"
 #include "utils/WinUtil.h"
 #include "utils/ZipUtil.h"
 #include "utils/Log.h"
@@ -33,6 +34,9 @@ extern "C" {
 struct EngineInfo {
     TocItem* tocRoot = nullptr;
     EngineBase* engine = nullptr;
+    // number of pages that precede this engine's first page in the
+    // multi-engine document, set in UpdatePagesForEngines
+    int pageNoBase = 0;
 };
 
 struct EnginePage {
@@ -180,11 +184,15 @@ RenderedBitmap* EngineMulti::GetImageForPageElement(IPageElement* ipel) {
 }
 
 PageDestination* EngineMulti::GetNamedDest(const WCHAR* name) {
-    for (auto&& pe : pageToEngine) {
-        EngineBase* e = pe.engine;
-        auto dest = e->GetNamedDest(name);
+    for (auto&& ei : enginesInfo) {
+        if (ei.tocRoot->isUnchecked) {
+            continue;
+        }
+        auto dest = ei.engine->GetNamedDest(name);
         if (dest) {
-            // TODO: fix up page number in returned destination
+            if (dest->pageNo >= 1) {
+                dest->pageNo += ei.pageNoBase;
+            }
             return dest;
         }
     }
@@ -239,12 +247,13 @@ WCHAR* EngineMulti::GetPageLabel(int pageNo) const {
 }
 
 int EngineMulti::GetPageByLabel(const WCHAR* label) const {
-    for (auto&& pe : pageToEngine) {
-        EngineBase* e = pe.engine;
-        int pageNo = e->GetPageByLabel(label);
+    for (auto&& ei : enginesInfo) {
+        if (ei.tocRoot->isUnchecked) {
+            continue;
+        }
+        int pageNo = ei.engine->GetPageByLabel(label);
         if (pageNo != -1) {
-            // TODO: fixup page number
-            return pageNo;
+            return pageNo + ei.pageNoBase;
         }
     }
     return -1;
@@ -363,13 +372,33 @@ TocItem* CreateWrapperItem(EngineBase* engine) {
     return tocWrapper;
 }
 
+// an engine created on a pool worker, to be collected in order
+struct LoadedEngine {
+    EngineBase* engine = nullptr;
+    TaskHandle* task = nullptr;
+};
+
 bool EngineMulti::LoadFromFiles(std::string_view dir, VecStr& files) {
     int n = files.Size();
-    TocItem* tocFiles = nullptr;
+    // each engine opens an independent document, so a binder of many
+    // files can create them all in parallel; collecting the results in
+    // submission order below keeps the page order stable
+    LoadedEngine* loaded = AllocArray<LoadedEngine>(n);
     for (int i = 0; i < n; i++) {
         std::string_view path = files.at(i);
-        AutoFreeWstr pathW = strconv::Utf8ToWstr(path);
-        EngineBase* engine = CreateEngine(pathW);
+        LoadedEngine* le = &loaded[i];
+        auto fn = [path, le] {
+            AutoFreeWstr pathW = strconv::Utf8ToWstr(path);
+            le->engine = CreateEngine(pathW);
+        };
+        le->task = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
+    }
+
+    TocItem* tocFiles = nullptr;
+    for (int i = 0; i < n; i++) {
+        loaded[i].task->Wait();
+        DropTaskHandle(loaded[i].task);
+        EngineBase* engine = loaded[i].engine;
         if (!engine) {
             continue;
         }
@@ -386,6 +415,7 @@ bool EngineMulti::LoadFromFiles(std::string_view dir, VecStr& files) {
         ei.tocRoot = wrapper;
         enginesInfo.Append(ei);
     }
+    free(loaded);
     if (tocFiles == nullptr) {
         return false;
     }
@@ -409,6 +439,7 @@ void EngineMulti::UpdatePagesForEngines(Vec<EngineInfo>& enginesInfo) {
         if (root->isUnchecked) {
             continue;
         }
+        ei.pageNoBase = nTotalPages;
         int nPages = ei.engine->PageCount();
 #if 0
         Vec<bool> visiblePages;
@@ -468,33 +499,53 @@ bool EngineMulti::Load(const WCHAR* fileName, PasswordUI* pwdUI) {
     delete vbkm.tree;
     vbkm.tree = nullptr;
 
-    // load all referenced files
-    auto loadEngines = [this, &filePath](TocItem* ti) -> bool {
+    // find all referenced files and create an engine per file in parallel,
+    // the way LoadFromFiles() does; a .vbkm can reference hundreds of files
+    Vec<TocItem*> engineItems;
+    auto collectEngineItems = [&engineItems](TocItem* ti) -> bool {
         if (ti->engineFilePath == nullptr) {
             return true;
         }
         if (ti->isUnchecked) {
             return true;
         }
+        engineItems.Append(ti);
+        return true;
+    };
+    VisitTocTree(tocRoot, collectEngineItems);
 
-        EngineBase* engine = nullptr;
-        AutoFreeStr path = FindEnginePath(filePath.AsView(), ti->engineFilePath);
-        if (path.empty()) {
-            return false;
-        }
-        AutoFreeWstr pathW = strconv::Utf8ToWstr(path.AsView());
-        engine = CreateEngine(pathW, nullptr);
+    int n = engineItems.isize();
+    const char* vbkmPath = filePath.Get();
+    LoadedEngine* loaded = AllocArray<LoadedEngine>(n);
+    for (int i = 0; i < n; i++) {
+        TocItem* ti = engineItems.at(i);
+        LoadedEngine* le = &loaded[i];
+        auto fn = [vbkmPath, ti, le] {
+            AutoFreeStr path = FindEnginePath(vbkmPath, ti->engineFilePath);
+            if (path.empty()) {
+                return;
+            }
+            AutoFreeWstr pathW = strconv::Utf8ToWstr(path.AsView());
+            le->engine = CreateEngine(pathW, nullptr);
+        };
+        le->task = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
+    }
+
+    for (int i = 0; i < n; i++) {
+        loaded[i].task->Wait();
+        DropTaskHandle(loaded[i].task);
+        EngineBase* engine = loaded[i].engine;
         if (!engine) {
-            return false;
+            // engines already in enginesInfo are freed by the destructor
+            ok = false;
+            continue;
         }
         EngineInfo ei;
         ei.engine = engine;
-        ei.tocRoot = ti;
+        ei.tocRoot = engineItems.at(i);
         this->enginesInfo.Append(ei);
-        return true;
-    };
-
-    ok = VisitTocTree(tocRoot, loadEngines);
+    }
+    free(loaded);
     if (!ok) {
         delete tocRoot;
         return false;
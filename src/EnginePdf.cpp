@@ -8,14 +8,17 @@ extern "C" {
 
 #include "utils/BaseUtil.h"
 #include "utils/Archive.h"
+#include "utils/Dict.h"
 #include "utils/ScopedWin.h"
 #include "utils/FileUtil.h"
 #include "utils/GuessFileType.h"
 #include "utils/HtmlParserLookup.h"
 #include "utils/HtmlPullParser.h"
 #include "utils/TrivialHtmlParser.h"
+#include "utils/ThreadUtil.h"
 #include "utils/WinUtil.h"
 #include "utils/ZipUtil.h"
+#include "utils/EtwTrace.h"
 #include "utils/Log.h"
 #include "utils/LogDbg.h"
 
@@ -26,6 +29,7 @@ extern "C" {
 #include "EngineBase.h"
 #include "EngineFzUtil.h"
 #include "EnginePdf.h"
+#include "DibPool.h"
 
 // in mupdf_load_system_font.c
 extern "C" void drop_cached_fonts_for_ctx(fz_context*);
@@ -332,6 +336,7 @@ class EnginePdf : public EngineBase {
     int GetPageByLabel(const WCHAR* label) const override;
 
     int GetAnnotations(Vec<Annotation*>* annotsOut);
+    void DropAnnotAppearanceCache(int pageNo);
 
     static EngineBase* CreateFromFile(const WCHAR* path, PasswordUI* pwdUI);
     static EngineBase* CreateFromStream(IStream* stream, PasswordUI* pwdUI);
@@ -352,8 +357,19 @@ class EnginePdf : public EngineBase {
     Vec<FzPageInfo> _pages;
     fz_outline* outline = nullptr;
     fz_outline* attachments = nullptr;
+    // outline / attachments are loaded on first GetToc(), not at open
+    bool outlineLoaded = false;
     pdf_obj* _info = nullptr;
     WStrVec* _pageLabels = nullptr;
+    // label -> first page with that label, so that GetPageByLabel doesn't
+    // scan _pageLabels linearly for every typed page number
+    dict::MapWStrToInt* _pageLabelIndex = nullptr;
+    // name -> destination for every named destination in the document,
+    // built from a single walk of the PDF name tree on the first
+    // GetNamedDest call (the destinations are owned by _namedDests)
+    dict::MapWStrToPtr* _namedDestIndex = nullptr;
+    Vec<PageDestination*> _namedDests;
+    bool namedDestsLoaded = false;
 
     TocTree* tocTree = nullptr;
 
@@ -363,12 +379,16 @@ class EnginePdf : public EngineBase {
     // bool Load(fz_stream* stm, PasswordUI* pwdUI = nullptr);
     bool LoadFromStream(fz_stream* stm, PasswordUI* pwdUI = nullptr);
     bool FinishLoading();
+    void LoadOutlineAndAttachments();
+    void BuildNamedDestIndex();
 
     FzPageInfo* GetFzPageInfoFast(int pageNo);
     FzPageInfo* GetFzPageInfo(int pageNo, bool loadQuick);
+    void DropUnusedPageInfos(int keepPageNo);
     fz_matrix viewctm(int pageNo, float zoom, int rotation);
     fz_matrix viewctm(fz_page* page, float zoom, int rotation);
-    TocItem* BuildTocTree(TocItem* parent, fz_outline* outline, int& idCounter, bool isAttachment);
+    TocItem* BuildTocTree(TocItem* parent, fz_outline* outline, int& idCounter, bool isAttachment,
+                          PoolAllocator* pool);
     WCHAR* ExtractFontList();
 
     std::span<u8> LoadStreamFromPDFFile(const WCHAR* filePath);
@@ -407,6 +427,23 @@ static void installFitzErrorCallbacks(fz_context* ctx) {
     fz_set_error_callback(ctx, fz_print_cb, nullptr);
 }
 
+// openjpeg decodes are serialized by a global lock, so a single decode
+// may as well use most of the machine
+#define MAX_JPX_DECODE_THREADS 8
+
+static void configureJpxDecodeThreads() {
+    static bool didConfigure = false;
+    if (didConfigure) {
+        return;
+    }
+    didConfigure = true;
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int nThreads = limitValue((int)si.dwNumberOfProcessors - 1, 1, MAX_JPX_DECODE_THREADS);
+    // process-wide, not per context
+    fz_set_jpx_decode_threads(nullptr, nThreads);
+}
+
 EnginePdf::EnginePdf() {
     kind = kindEnginePdf;
     defaultFileExt = L".pdf";
@@ -421,8 +458,9 @@ EnginePdf::EnginePdf() {
     fz_locks_ctx.user = this;
     fz_locks_ctx.lock = fz_lock_context_cs;
     fz_locks_ctx.unlock = fz_unlock_context_cs;
-    ctx = fz_new_context(nullptr, &fz_locks_ctx, FZ_STORE_DEFAULT);
+    ctx = fz_new_context(fz_memacct_alloc_ctx(), &fz_locks_ctx, FZ_STORE_DEFAULT);
     installFitzErrorCallbacks(ctx);
+    configureJpxDecodeThreads();
 
     pdf_install_load_system_font_funcs(ctx);
 }
@@ -441,8 +479,15 @@ EnginePdf::~EnginePdf() {
         if (pi->page) {
             fz_drop_page(ctx, pi->page);
         }
+        if (pi->displayList) {
+            fz_drop_display_list(ctx, pi->displayList);
+        }
+        if (pi->annotsList) {
+            fz_drop_display_list(ctx, pi->annotsList);
+        }
         DeleteVecMembers(pi->autoLinks);
         DeleteVecMembers(pi->comments);
+        DeleteVecMembers(pi->elements);
     }
 
     fz_drop_outline(ctx, outline);
@@ -454,6 +499,9 @@ EnginePdf::~EnginePdf() {
     fz_drop_context(ctx);
 
     delete _pageLabels;
+    delete _pageLabelIndex;
+    delete _namedDestIndex;
+    DeleteVecMembers(_namedDests);
     delete tocTree;
 
     for (size_t i = 0; i < dimof(mutexes); i++) {
@@ -778,6 +826,77 @@ static bool IsLinearizedFile(EnginePdf* e) {
     return isLinear;
 }
 
+// computing a page's mediabox requires loading its page dict object; for very
+// long documents doing that for every page is the bulk of the loading time.
+// The sweep is split between a few worker threads, each reading the file
+// through a private fz_context / pdf_document (a context must only be used
+// by one thread at a time)
+#define MAX_MEDIABOX_WORKERS 4
+// below this the threads cost more than they save
+#define MIN_PAGES_FOR_PARALLEL_SWEEP 1000
+
+struct MediaboxSweep {
+    const WCHAR* filePath = nullptr;
+    pdf_rev_page_map* map = nullptr;
+    int nPages = 0;
+    fz_rect* boxes = nullptr;
+    volatile LONG nextIdx = -1;
+};
+
+static void SweepMediaboxes(fz_context* ctx, pdf_document* doc, MediaboxSweep* sweep) {
+    for (;;) {
+        int i = (int)InterlockedIncrement(&sweep->nextIdx);
+        if (i >= sweep->nPages) {
+            return;
+        }
+        // this does the job of pdf_bound_page but without doing pdf_load_page()
+        int objNo = sweep->map[i].object;
+        fz_rect mbox{};
+        fz_matrix page_ctm{};
+        fz_try(ctx) {
+            pdf_obj* pageref = pdf_load_object(ctx, doc, objNo);
+            pdf_page_obj_transform(ctx, pageref, &mbox, &page_ctm);
+            mbox = fz_transform_rect(mbox, page_ctm);
+            pdf_drop_obj(ctx, pageref);
+        }
+        fz_catch(ctx) {
+        }
+        sweep->boxes[i] = mbox;
+    }
+}
+
+static DWORD WINAPI MediaboxWorkerThread(LPVOID data) {
+    MediaboxSweep* sweep = (MediaboxSweep*)data;
+    fz_context* ctx = fz_new_context(fz_memacct_alloc_ctx(), nullptr, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        return 0;
+    }
+    pdf_document* doc = nullptr;
+    fz_var(doc);
+    fz_try(ctx) {
+        fz_stream* stm = fz_open_file2(ctx, sweep->filePath);
+        if (stm) {
+            doc = pdf_open_document_with_stream(ctx, stm);
+            fz_drop_stream(ctx, stm);
+        }
+        // the object numbers in sweep->map come from the main document and
+        // are only valid if the worker sees the same, unrepaired xref
+        if (doc && doc->repair_attempted) {
+            pdf_drop_document(ctx, doc);
+            doc = nullptr;
+        }
+    }
+    fz_catch(ctx) {
+        doc = nullptr;
+    }
+    if (doc) {
+        SweepMediaboxes(ctx, doc, sweep);
+        pdf_drop_document(ctx, doc);
+    }
+    fz_drop_context(ctx);
+    return 0;
+}
+
 bool EnginePdf::FinishLoading() {
     pageCount = 0;
     fz_try(ctx) {
@@ -840,21 +959,44 @@ bool EnginePdf::FinishLoading() {
             pageInfo->mediabox = ToRectFl(mbox);
         }
     } else {
-        // this does the job of pdf_bound_page but without doing pdf_load_page()
         pdf_rev_page_map* map = doc->rev_page_map;
-        for (int i = 0; i < nPages; i++) {
-            int pageNo = map[i].page;
-            int objNo = map[i].object;
-            fz_rect mbox{};
-            fz_matrix page_ctm{};
-            fz_try(ctx) {
-                pdf_obj* pageref = pdf_load_object(ctx, doc, objNo);
-                pdf_page_obj_transform(ctx, pageref, &mbox, &page_ctm);
-                mbox = fz_transform_rect(mbox, page_ctm);
-                pdf_drop_obj(ctx, pageref);
+        fz_rect* boxes = AllocArray<fz_rect>(nPages);
+
+        MediaboxSweep sweep;
+        sweep.filePath = FileName();
+        sweep.map = map;
+        sweep.nPages = nPages;
+        sweep.boxes = boxes;
+
+        HANDLE threads[MAX_MEDIABOX_WORKERS];
+        int nStarted = 0;
+        if (nPages >= MIN_PAGES_FOR_PARALLEL_SWEEP && sweep.filePath && !doc->repair_attempted) {
+            SYSTEM_INFO si;
+            GetSystemInfo(&si);
+            int nWorkers = limitValue((int)si.dwNumberOfProcessors - 1, 1, MAX_MEDIABOX_WORKERS);
+            for (int i = 1; i < nWorkers; i++) {
+                threads[nStarted] = CreateThread(nullptr, 0, MediaboxWorkerThread, &sweep, 0, 0);
+                if (!threads[nStarted]) {
+                    break;
+                }
+                nStarted++;
             }
-            fz_catch(ctx) {
+        }
+
+        // this thread uses the already loaded document and drains the
+        // queue together with the workers
+        SweepMediaboxes(ctx, doc, &sweep);
+
+        if (nStarted > 0) {
+            WaitForMultipleObjects(nStarted, threads, TRUE, INFINITE);
+            for (int i = 0; i < nStarted; i++) {
+                CloseHandle(threads[i]);
             }
+        }
+
+        for (int i = 0; i < nPages; i++) {
+            int pageNo = map[i].page;
+            fz_rect mbox = sweep.boxes[i];
             if (fz_is_empty_rect(mbox)) {
                 fz_warn(ctx, "cannot find page size for page %d", i);
                 mbox.x0 = 0;
@@ -866,24 +1008,7 @@ bool EnginePdf::FinishLoading() {
             pageInfo->mediabox = ToRectFl(mbox);
             pageInfo->pageNo = pageNo + 1;
         }
-    }
-
-    fz_try(ctx) {
-        outline = fz_load_outline(ctx, _doc);
-    }
-    fz_catch(ctx) {
-        // ignore errors from pdf_load_outline()
-        // this information is not critical and checking the
-        // error might prevent loading some pdfs that would
-        // otherwise get displayed
-        fz_warn(ctx, "Couldn't load outline");
-    }
-
-    fz_try(ctx) {
-        attachments = pdf_load_attachments(ctx, doc);
-    }
-    fz_catch(ctx) {
-        fz_warn(ctx, "Couldn't load attachments");
+        free(boxes);
     }
 
     pdf_obj* orig_info = nullptr;
@@ -946,6 +1071,13 @@ bool EnginePdf::FinishLoading() {
     }
     if (_pageLabels) {
         hasPageLabels = true;
+        // Insert() keeps the first page for a duplicate label, matching
+        // what the WStrVec::Find scan used to return
+        _pageLabelIndex = new dict::MapWStrToInt((size_t)PageCount() * 2);
+        int nLabels = _pageLabels->isize();
+        for (int i = 0; i < nLabels; i++) {
+            _pageLabelIndex->Insert(_pageLabels->at(i), i + 1, nullptr);
+        }
     }
 
     // TODO: support javascript
@@ -959,17 +1091,24 @@ bool EnginePdf::FinishLoading() {
     return true;
 }
 
-PageDestination* destFromAttachment(EnginePdf* engine, fz_outline* outline) {
-    PageDestination* dest = new PageDestination();
+// the destination and its strings live in pool (see TocTree::allocator)
+PageDestination* destFromAttachment(EnginePdf* engine, fz_outline* outline, PoolAllocator* pool) {
+    PageDestination* dest = new (pool->Alloc(sizeof(PageDestination))) PageDestination();
     dest->kind = kindDestinationLaunchEmbedded;
     // WCHAR* path = strconv::Utf8ToWstr(outline->uri);
-    dest->name = strconv::Utf8ToWstr(outline->title);
+    AutoFreeWstr name(strconv::Utf8ToWstr(outline->title));
+    dest->name = Allocator::StrDup(pool, name.Get());
     // page is really a stream number
-    dest->value = str::Format(L"%s:%d", engine->FileName(), outline->page);
+    AutoFreeWstr value(str::Format(L"%s:%d", engine->FileName(), outline->page));
+    dest->value = Allocator::StrDup(pool, value.Get());
     return dest;
 }
 
-TocItem* EnginePdf::BuildTocTree(TocItem* parent, fz_outline* outline, int& idCounter, bool isAttachment) {
+// all items (and everything they point to) are allocated out of pool, so
+// that a tree with tens of thousands of items can be torn down by freeing
+// the pool's blocks instead of destroying the items one by one
+TocItem* EnginePdf::BuildTocTree(TocItem* parent, fz_outline* outline, int& idCounter, bool isAttachment,
+                                 PoolAllocator* pool) {
     TocItem* root = nullptr;
     TocItem* curr = nullptr;
 
@@ -988,16 +1127,16 @@ TocItem* EnginePdf::BuildTocTree(TocItem* parent, fz_outline* outline, int& idCo
         Kind kindRaw = nullptr;
         if (isAttachment) {
             kindRaw = kindTocFzOutlineAttachment;
-            dest = destFromAttachment(this, outline);
+            dest = destFromAttachment(this, outline, pool);
         } else {
             kindRaw = kindTocFzOutline;
-            dest = newFzDestination(outline);
+            dest = newFzDestination(outline, pool);
         }
 
-        TocItem* item = newTocItemWithDestination(parent, name, dest);
+        TocItem* item = newTocItemWithDestination(parent, name, dest, pool);
         item->kindRaw = kindRaw;
-        item->rawVal1 = str::Dup(outline->title);
-        item->rawVal2 = str::Dup(outline->uri);
+        item->rawVal1 = Allocator::StrDup(pool, outline->title);
+        item->rawVal2 = Allocator::StrDup(pool, outline->uri);
 
         free(name);
         item->isOpenDefault = outline->is_open;
@@ -1011,7 +1150,7 @@ TocItem* EnginePdf::BuildTocTree(TocItem* parent, fz_outline* outline, int& idCo
         }
 
         if (outline->down) {
-            item->child = BuildTocTree(item, outline->down, idCounter, isAttachment);
+            item->child = BuildTocTree(item, outline->down, idCounter, isAttachment, pool);
         }
 
         if (!root) {
@@ -1032,43 +1171,163 @@ TocItem* EnginePdf::BuildTocTree(TocItem* parent, fz_outline* outline, int& idCo
 }
 
 // TODO: maybe build in FinishLoading
+// resolving the destination of every bookmark walks a large part of the
+// object graph and can take seconds on documents with many thousands of
+// bookmarks. The result is only needed once the ToC is first shown, so
+// this is deferred from FinishLoading() to keep the open path fast
+void EnginePdf::LoadOutlineAndAttachments() {
+    if (outlineLoaded) {
+        return;
+    }
+    ScopedCritSec scope(ctxAccess);
+    if (outlineLoaded) {
+        return;
+    }
+    outlineLoaded = true;
+
+    pdf_document* doc = (pdf_document*)_doc;
+    fz_try(ctx) {
+        outline = fz_load_outline(ctx, _doc);
+    }
+    fz_catch(ctx) {
+        // ignore errors from pdf_load_outline()
+        // this information is not critical and checking the
+        // error might prevent loading some pdfs that would
+        // otherwise get displayed
+        fz_warn(ctx, "Couldn't load outline");
+    }
+
+    fz_try(ctx) {
+        attachments = pdf_load_attachments(ctx, doc);
+    }
+    fz_catch(ctx) {
+        fz_warn(ctx, "Couldn't load attachments");
+    }
+}
+
 TocTree* EnginePdf::GetToc() {
     if (tocTree) {
         return tocTree;
     }
+    LoadOutlineAndAttachments();
     if (outline == nullptr && attachments == nullptr) {
         return nullptr;
     }
 
     int idCounter = 0;
 
+    PoolAllocator* pool = new PoolAllocator();
     TocItem* root = nullptr;
     if (outline) {
-        root = BuildTocTree(nullptr, outline, idCounter, false);
+        root = BuildTocTree(nullptr, outline, idCounter, false, pool);
     }
     if (!attachments) {
         if (!root) {
+            delete pool;
             return nullptr;
         }
         tocTree = new TocTree(root);
+        tocTree->allocator = pool;
         return tocTree;
     }
-    TocItem* att = BuildTocTree(nullptr, attachments, idCounter, true);
+    TocItem* att = BuildTocTree(nullptr, attachments, idCounter, true, pool);
     if (!root) {
         tocTree = new TocTree(att);
+        tocTree->allocator = pool;
         return tocTree;
     }
     root->AddSiblingAtEnd(att);
     tocTree = new TocTree(root);
+    tocTree->allocator = pool;
     return tocTree;
 }
 
+/* Resolving a name with pdf_lookup_dest walks the PDF name tree on every
+   call; documents that link internally a lot (e.g. API references) have
+   tens of thousands of names and every link click pays for the walk.
+   Flatten the tree into a hash index once instead, on the first lookup.
+   Both pagesAccess and ctxAccess must be held. */
+void EnginePdf::BuildNamedDestIndex() {
+    namedDestsLoaded = true;
+    pdf_document* doc = (pdf_document*)_doc;
+
+    // names can live in the PDF 1.1 /Dests dictionary (looked up first,
+    // like pdf_lookup_dest does) and in the PDF 1.2 name tree
+    pdf_obj* dests = nullptr;
+    fz_try(ctx) {
+        pdf_obj* root = pdf_dict_get(ctx, pdf_trailer(ctx, doc), PDF_NAME(Root));
+        dests = pdf_dict_get(ctx, root, PDF_NAME(Dests));
+    }
+    fz_catch(ctx) {
+        dests = nullptr;
+    }
+    pdf_obj* tree = nullptr;
+    fz_var(tree);
+    fz_try(ctx) {
+        tree = pdf_load_name_tree(ctx, doc, PDF_NAME(Dests));
+    }
+    fz_catch(ctx) {
+        fz_warn(ctx, "Couldn't load the Dests name tree");
+        tree = nullptr;
+    }
+    if (!dests && !tree) {
+        return;
+    }
+
+    size_t count = (size_t)pdf_dict_len(ctx, dests) + (size_t)pdf_dict_len(ctx, tree);
+    _namedDestIndex = new dict::MapWStrToPtr(count * 2 + 16);
+    pdf_obj* dicts[2] = {dests, tree};
+    for (pdf_obj* d : dicts) {
+        int n = pdf_dict_len(ctx, d);
+        for (int i = 0; i < n; i++) {
+            char* uri = nullptr;
+            fz_var(uri);
+            fz_try(ctx) {
+                uri = pdf_parse_link_dest(ctx, doc, pdf_dict_get_val(ctx, d, i));
+            }
+            fz_catch(ctx) {
+                uri = nullptr;
+            }
+            if (!uri) {
+                // a single broken destination shouldn't spoil the rest
+                continue;
+            }
+            float x, y;
+            int pageNo = resolve_link(uri, &x, &y);
+            fz_free(ctx, uri);
+            AutoFreeWstr name(strconv::Utf8ToWstr(pdf_to_name(ctx, pdf_dict_get_key(ctx, d, i))));
+            PageDestination* dest = newSimpleDest(pageNo, RectF{x, y, 0, 0});
+            void* prev = nullptr;
+            if (_namedDestIndex->Insert(name, dest, &prev)) {
+                _namedDests.Append(dest);
+            } else {
+                // the /Dests dictionary takes precedence over the tree
+                delete dest;
+            }
+        }
+    }
+    pdf_drop_obj(ctx, tree);
+}
+
 PageDestination* EnginePdf::GetNamedDest(const WCHAR* name) {
     ScopedCritSec scope1(&pagesAccess);
     ScopedCritSec scope2(ctxAccess);
 
     pdf_document* doc = (pdf_document*)_doc;
 
+    if (!namedDestsLoaded) {
+        BuildNamedDestIndex();
+    }
+    if (_namedDestIndex) {
+        void* val = nullptr;
+        if (_namedDestIndex->Get(name, &val)) {
+            // callers own the returned destination
+            return clonePageDestination((PageDestination*)val);
+        }
+    }
+    // fall through to the per-call lookup: a name whose encoding the
+    // flattening normalized differently can still resolve this way
+
     AutoFree name_utf8(strconv::WstrToUtf8(name));
     pdf_obj* dest = nullptr;
 
@@ -1118,9 +1377,73 @@ FzPageInfo* EnginePdf::GetFzPageInfoFast(int pageNo) {
     if (!pageInfo->page || !pageInfo->fullyLoaded) {
         return nullptr;
     }
+    pageInfo->lastUseTimestamp = GetTickCount();
     return pageInfo;
 }
 
+// bound the number of pages kept loaded: a linear read through a huge
+// document would otherwise accumulate every fz_page (plus its links and
+// cached elements) for the rest of the session
+constexpr int kMaxLoadedPages = 64;
+// never evict a page used this recently (in ms); callers briefly use the
+// FzPageInfo returned by GetFzPageInfo outside of pagesAccess
+constexpr DWORD kMinEvictAgeMs = 5 * 1000;
+
+/* Evict the least recently used loaded pages until at most kMaxLoadedPages
+   remain. Everything dropped here (fz_page, links, comments, image
+   positions) is rebuilt by the next GetFzPageInfo for that page.
+   Both pagesAccess and ctxAccess must be held. */
+void EnginePdf::DropUnusedPageInfos(int keepPageNo) {
+    int nLoaded = 0;
+    for (int i = 0; i < pageCount; i++) {
+        if (_pages[i].page) {
+            nLoaded++;
+        }
+    }
+
+    DWORD now = GetTickCount();
+    while (nLoaded > kMaxLoadedPages) {
+        FzPageInfo* lru = nullptr;
+        for (int i = 0; i < pageCount; i++) {
+            FzPageInfo* pi = &_pages[i];
+            if (!pi->page || pi->pageNo == keepPageNo) {
+                continue;
+            }
+            if (now - pi->lastUseTimestamp < kMinEvictAgeMs) {
+                continue;
+            }
+            if (!lru || pi->lastUseTimestamp < lru->lastUseTimestamp) {
+                lru = pi;
+            }
+        }
+        if (!lru) {
+            // all remaining pages are in (or close to) use
+            return;
+        }
+        if (lru->links) {
+            fz_drop_link(ctx, lru->links);
+            lru->links = nullptr;
+        }
+        fz_drop_page(ctx, lru->page);
+        lru->page = nullptr;
+        if (lru->displayList) {
+            fz_drop_display_list(ctx, lru->displayList);
+            lru->displayList = nullptr;
+        }
+        if (lru->annotsList) {
+            fz_drop_display_list(ctx, lru->annotsList);
+            lru->annotsList = nullptr;
+        }
+        DeleteVecMembers(lru->autoLinks);
+        DeleteVecMembers(lru->comments);
+        lru->images.Reset();
+        // elements is deliberately kept: callers hold pointers into it
+        // (e.g. across a click) and it's only freed in the destructor
+        lru->fullyLoaded = false;
+        nLoaded--;
+    }
+}
+
 static PageElement* newFzComment(const WCHAR* comment, int pageNo, RectF rect) {
     auto res = new PageElement();
     res->kind_ = kindPageElementComment;
@@ -1224,17 +1547,20 @@ FzPageInfo* EnginePdf::GetFzPageInfo(int pageNo, bool loadQuick) {
 
     ScopedCritSec ctxScope(ctxAccess);
     if (!pageInfo->page) {
+        ScopedTraceEvent trc("page-load", pageNo);
         fz_try(ctx) {
             pageInfo->page = fz_load_page(ctx, _doc, pageIdx);
         }
         fz_catch(ctx) {
         }
+        DropUnusedPageInfos(pageNo);
     }
 
     fz_page* page = pageInfo->page;
     if (!page) {
         return nullptr;
     }
+    pageInfo->lastUseTimestamp = GetTickCount();
 
     if (loadQuick || pageInfo->fullyLoaded) {
         return pageInfo;
@@ -1340,6 +1666,136 @@ RectF EnginePdf::Transform(const RectF& rect, int pageNo, float zoom, int rotati
     return ToRectFl(rect2);
 }
 
+// don't bother splitting a render into bands below this size; for small
+// pixmaps the fixed cost of fanning out beats the parallel speedup
+#define MIN_BANDED_RENDER_PIXELS (4 * 1024 * 1024)
+// each band should be tall enough to amortize its setup cost
+#define MIN_RENDER_BAND_DY 256
+
+// one horizontal band of a banded page render (see RunDisplayListBanded)
+struct PageRenderBand {
+    fz_context* ctx = nullptr; // private clone, dropped by whoever ran the band
+    fz_display_list* list = nullptr;
+    fz_pixmap* pix = nullptr; // the shared full-page target
+    fz_irect bbox{};
+    fz_matrix ctm{};
+    fz_cookie* cookie = nullptr;
+    LONG ran = 0;
+    LONG ok = 0;
+};
+
+// rasterizes one horizontal band of the display list straight into the
+// band's rows of the shared target pixmap (bands span the full width, so
+// a band's samples are one contiguous run inside the target)
+static void RenderPageBand(PageRenderBand* band) {
+    fz_context* bandCtx = band->ctx;
+    fz_pixmap* pix = band->pix;
+    u8* samples = pix->samples + (size_t)(band->bbox.y0 - pix->y) * pix->stride;
+
+    fz_pixmap* bandPix = nullptr;
+    fz_device* dev = nullptr;
+    fz_var(bandPix);
+    fz_var(dev);
+    fz_try(bandCtx) {
+        // doesn't take ownership of the samples
+        bandPix = fz_new_pixmap_with_bbox_and_data(bandCtx, pix->colorspace, band->bbox, nullptr, pix->alpha,
+                                                   samples);
+        dev = fz_new_draw_device(bandCtx, fz_identity, bandPix);
+        fz_run_display_list(bandCtx, band->list, dev, band->ctm, fz_rect_from_irect(band->bbox), band->cookie);
+        fz_close_device(bandCtx, dev);
+        band->ok = 1;
+    }
+    fz_always(bandCtx) {
+        fz_drop_device(bandCtx, dev);
+        fz_drop_pixmap(bandCtx, bandPix);
+    }
+    fz_catch(bandCtx) {
+        band->ok = 0;
+    }
+}
+
+// splits the rasterization of a display list into horizontal bands
+// rendered concurrently over the worker pool, so that a single huge page
+// (tiling only kicks in at high zoom) uses all cores instead of one.
+// Every band - including the one rendered on the calling thread - replays
+// the list with a private fz_context clone (the engine's context is
+// created with locks, so the clones share its store). The band workers
+// take the fitz locks, among them the allocation lock that doubles as the
+// engine's ctxAccess, so ctxAccess (held by the caller, RenderPage) is
+// released while waiting for them.
+// Returns 0 without touching pix when the render is too small to benefit
+// or no clones could be made - the caller then renders single-threaded as
+// before; returns 1 on success and -1 when a band failed to render
+static int RunDisplayListBanded(fz_context* ctx, fz_display_list* list, fz_pixmap* pix, fz_matrix ctm,
+                                fz_cookie* cookie, CRITICAL_SECTION* ctxAccess) {
+    i64 nPixels = (i64)pix->w * (i64)pix->h;
+    int nBands = std::min(GetThreadPool()->threadCount, pix->h / MIN_RENDER_BAND_DY);
+    if (nPixels < MIN_BANDED_RENDER_PIXELS || nBands < 2) {
+        return 0;
+    }
+
+    Vec<PageRenderBand> bands;
+    int bandDy = (pix->h + nBands - 1) / nBands;
+    for (int i = 0; i < nBands; i++) {
+        PageRenderBand band;
+        band.list = list;
+        band.pix = pix;
+        band.bbox.x0 = pix->x;
+        band.bbox.x1 = pix->x + pix->w;
+        band.bbox.y0 = pix->y + i * bandDy;
+        band.bbox.y1 = std::min(pix->y + (i + 1) * bandDy, pix->y + pix->h);
+        band.ctm = ctm;
+        band.cookie = cookie;
+        bands.Append(band);
+    }
+
+    // clone the contexts up front so that the single-threaded fallback is
+    // still possible when that fails
+    for (int i = 0; i < nBands; i++) {
+        fz_context* clone = fz_clone_context(ctx);
+        if (!clone) {
+            for (int j = 0; j < i; j++) {
+                fz_drop_context(bands[j].ctx);
+            }
+            return 0;
+        }
+        bands[i].ctx = clone;
+    }
+
+    LeaveCriticalSection(ctxAccess);
+
+    Vec<TaskHandle*> tasks;
+    for (int i = 1; i < nBands; i++) {
+        PageRenderBand* band = &bands[i];
+        auto fn = [band] {
+            band->ran = 1;
+            RenderPageBand(band);
+            fz_drop_context(band->ctx);
+        };
+        tasks.Append(GetThreadPool()->Submit(fn, TaskPriority::Interactive));
+    }
+
+    bands[0].ran = 1;
+    RenderPageBand(&bands[0]);
+    fz_drop_context(bands[0].ctx);
+
+    bool ok = bands[0].ok != 0;
+    for (int i = 1; i < nBands; i++) {
+        tasks[i - 1]->Wait();
+        DropTaskHandle(tasks[i - 1]);
+        if (!bands[i].ran) {
+            // cancelled before it could run (pool shutdown)
+            fz_drop_context(bands[i].ctx);
+            ok = false;
+        } else if (!bands[i].ok) {
+            ok = false;
+        }
+    }
+
+    EnterCriticalSection(ctxAccess);
+    return ok ? 1 : -1;
+}
+
 RenderedBitmap* EnginePdf::RenderPage(RenderPageArgs& args) {
     auto pageNo = args.pageNo;
 
@@ -1381,10 +1837,18 @@ RenderedBitmap* EnginePdf::RenderPage(RenderPageArgs& args) {
     fz_pixmap* pix = nullptr;
     fz_device* dev = nullptr;
     RenderedBitmap* bitmap = nullptr;
+    fz_display_list* list = nullptr;
+    fz_display_list* annotsList = nullptr;
+    HBITMAP dibBmp = nullptr;
+    HANDLE dibMap = nullptr;
 
     fz_var(dev);
     fz_var(pix);
     fz_var(bitmap);
+    fz_var(list);
+    fz_var(annotsList);
+    fz_var(dibBmp);
+    fz_var(dibMap);
 
     const char* usage = "View";
     switch (args.target) {
@@ -1393,25 +1857,113 @@ RenderedBitmap* EnginePdf::RenderPage(RenderPageArgs& args) {
             break;
     }
 
+    // only the "View" usage can be replayed from the cached display list;
+    // printing still interprets the page directly
+    bool useDisplayList = str::Eq(usage, "View");
+
     fz_try(ctx) {
-        pix = fz_new_pixmap_with_bbox(ctx, colorspace, ibounds, nullptr, 1);
+        if (useDisplayList && !pageInfo->displayList) {
+            list = fz_new_display_list(ctx, fz_bound_page(ctx, page));
+            dev = fz_new_list_device(ctx, list);
+            pdf_run_page_contents(ctx, pdfpage, dev, fz_identity, fzcookie);
+            fz_close_device(ctx, dev);
+            fz_drop_device(ctx, dev);
+            dev = nullptr;
+            // an aborted run leaves a partial list, don't cache that
+            if (!fzcookie || !fzcookie->abort) {
+                pageInfo->displayList = list;
+                list = nullptr;
+            }
+        }
+        if (useDisplayList && !pageInfo->annotsList) {
+            // appearance streams are recorded separately from the contents
+            // so that an annotation edit only re-synthesizes appearances
+            // and never re-interprets the page (see DropAnnotAppearanceCache)
+            annotsList = fz_new_display_list(ctx, fz_bound_page(ctx, page));
+            dev = fz_new_list_device(ctx, annotsList);
+            pdf_run_page_annots(ctx, pdfpage, dev, fz_identity, fzcookie);
+            pdf_run_page_widgets(ctx, pdfpage, dev, fz_identity, fzcookie);
+            fz_close_device(ctx, dev);
+            fz_drop_device(ctx, dev);
+            dev = nullptr;
+            if (!fzcookie || !fzcookie->abort) {
+                pageInfo->annotsList = annotsList;
+                annotsList = nullptr;
+            }
+        }
+        fz_display_list* pageList = pageInfo->displayList ? pageInfo->displayList : list;
+        fz_display_list* pageAnnots = pageInfo->annotsList ? pageInfo->annotsList : annotsList;
+        // rasterize directly into the DIB section that ends up on screen;
+        // this avoids converting and copying the samples per rendered tile
+        pix = fz_new_pixmap_in_dib_section(ctx, ibounds, &dibBmp, &dibMap);
+        if (!pix) {
+            // e.g. on GDI resource exhaustion
+            pix = fz_new_pixmap_with_bbox(ctx, colorspace, ibounds, nullptr, 1);
+        }
         // initialize with white background
         fz_clear_pixmap_with_value(ctx, pix, 0xff);
-        // TODO: in printing different style. old code use pdf_run_page_with_usage(), with usage ="View"
-        // or "Print". "Export" is not used
-        dev = fz_new_draw_device(ctx, fz_identity, pix);
-        pdf_document* doc = pdf_document_from_fz_document(ctx, _doc);
-        pdf_run_page_with_usage(ctx, doc, pdfpage, dev, ctm, usage, fzcookie);
-        bitmap = new_rendered_fz_pixmap(ctx, pix);
-        fz_close_device(ctx, dev);
+        // a large render is fanned out over all cores in horizontal bands;
+        // RunDisplayListBanded declines small ones (and other corner cases),
+        // those rasterize single-threaded as before
+        if (useDisplayList && pageList) {
+            int banded = RunDisplayListBanded(ctx, pageList, pix, ctm, fzcookie, ctxAccess);
+            if (banded < 0) {
+                fz_throw(ctx, FZ_ERROR_GENERIC, "banded page render failed");
+            }
+            if (banded == 0) {
+                dev = fz_new_draw_device(ctx, fz_identity, pix);
+                fz_run_display_list(ctx, pageList, dev, ctm, cliprect, fzcookie);
+                fz_close_device(ctx, dev);
+                fz_drop_device(ctx, dev);
+                dev = nullptr;
+            }
+            // annotations composite on top of the contents; they cover
+            // little area, so they aren't worth banding
+            if (pageAnnots && !fz_display_list_is_empty(ctx, pageAnnots)) {
+                dev = fz_new_draw_device(ctx, fz_identity, pix);
+                fz_run_display_list(ctx, pageAnnots, dev, ctm, cliprect, fzcookie);
+                fz_close_device(ctx, dev);
+                fz_drop_device(ctx, dev);
+                dev = nullptr;
+            }
+        } else {
+            // TODO: in printing different style. old code use pdf_run_page_with_usage(), with usage ="View"
+            // or "Print". "Export" is not used
+            dev = fz_new_draw_device(ctx, fz_identity, pix);
+            pdf_document* doc = pdf_document_from_fz_document(ctx, _doc);
+            pdf_run_page_with_usage(ctx, doc, pdfpage, dev, ctm, usage, fzcookie);
+            fz_close_device(ctx, dev);
+            fz_drop_device(ctx, dev);
+            dev = nullptr;
+        }
+        if (dibBmp) {
+            bitmap = new RenderedBitmap(dibBmp, Size(pix->w, pix->h), dibMap);
+            // now owned by bitmap
+            dibBmp = nullptr;
+            dibMap = nullptr;
+        } else {
+            bitmap = new_rendered_fz_pixmap(ctx, pix);
+        }
     }
     fz_always(ctx) {
         if (dev) {
             fz_drop_device(ctx, dev);
         }
+        if (list) {
+            fz_drop_display_list(ctx, list);
+        }
+        if (annotsList) {
+            fz_drop_display_list(ctx, annotsList);
+        }
         fz_drop_pixmap(ctx, pix);
     }
     fz_catch(ctx) {
+        if (dibBmp && !DibPoolRelease(dibBmp)) {
+            DeleteObject(dibBmp);
+        }
+        if (dibMap) {
+            CloseHandle(dibMap);
+        }
         delete bitmap;
         return nullptr;
     }
@@ -1425,10 +1977,8 @@ IPageElement* EnginePdf::GetElementAtPos(int pageNo, PointF pt) {
 
 Vec<IPageElement*>* EnginePdf::GetElements(int pageNo) {
     auto pageInfo = GetFzPageInfoFast(pageNo);
-    auto res = new Vec<IPageElement*>();
-    FzGetElements(res, pageInfo);
-    if (res->IsEmpty()) {
-        delete res;
+    auto res = FzGetElements(pageInfo);
+    if (!res || res->IsEmpty()) {
         return nullptr;
     }
     return res;
@@ -1837,8 +2387,12 @@ const pdf_write_options pdf_default_write_options2 = {
 // this is used after the PDF was modified by the user (e.g. by adding / changing
 // annotations).
 // if filePath is not given, we save under the same name
+// by default we append an incremental update (just the changed objects and a
+// new xref section), so the cost is proportional to the edit, not to the size
+// of the document. compact forces a full rewrite with garbage collection, which
+// also sheds accumulated incremental updates
 // TODO: if the file is locked, this might fail.
-bool EnginePdfSaveUpdated(EngineBase* engine, std::string_view path) {
+bool EnginePdfSaveUpdated(EngineBase* engine, std::string_view path, bool compact) {
     CrashIf(!engine);
     if (!engine) {
         return false;
@@ -1853,15 +2407,45 @@ bool EnginePdfSaveUpdated(EngineBase* engine, std::string_view path) {
 
     pdf_write_options save_opts;
     save_opts = pdf_default_write_options2;
-    save_opts.do_incremental = 1;
     save_opts.do_compress = 1;
     save_opts.do_compress_images = 1;
     save_opts.do_compress_fonts = 1;
-    if (doc->redacted) {
-        save_opts.do_garbage = 1;
+
+    // mupdf refuses incremental writes for repaired documents and can't
+    // combine them with garbage collection (needed after redaction)
+    bool incremental = !compact && !doc->repair_attempted && !doc->redacted;
+    if (incremental && !str::EqI(path.data(), currPath.Get())) {
+        // an incremental write appends to the destination file, so when
+        // saving under a new name it has to start out as a copy of the
+        // original
+        AutoFreeWstr dstPath = strconv::Utf8ToWstr(path.data());
+        AutoFreeWstr srcPath = strconv::Utf8ToWstr(currPath.Get());
+        if (!CopyFileW(srcPath, dstPath, FALSE)) {
+            incremental = false;
+        }
     }
 
     bool ok = true;
+    if (incremental) {
+        save_opts.do_incremental = 1;
+        fz_try(ctx) {
+            pdf_save_document(ctx, doc, path.data(), &save_opts);
+        }
+        fz_catch(ctx) {
+            const char* errMsg = fz_caught_message(ctx);
+            logf("Incremental pdf save of '%s' failed with '%s', retrying with a full rewrite\n", path.data(), errMsg);
+            ok = false;
+        }
+        if (ok) {
+            return true;
+        }
+        save_opts.do_incremental = 0;
+        ok = true;
+    }
+
+    if (compact || doc->redacted) {
+        save_opts.do_garbage = 1;
+    }
     fz_try(ctx) {
         pdf_save_document(ctx, doc, path.data(), &save_opts);
     }
@@ -1874,6 +2458,42 @@ bool EnginePdfSaveUpdated(EngineBase* engine, std::string_view path) {
     return ok;
 }
 
+// full rewrite of the current pdf document tuned for the smallest output:
+// garbage-collects unused objects, de-duplicates identical objects (scanned
+// documents often embed the same image once per page), compresses all
+// uncompressed streams (incl. images and fonts) and drops the cruft a
+// sanitize pass finds. unlike EnginePdfSaveUpdated this is never incremental,
+// so it also sheds accumulated incremental updates
+bool EnginePdfSaveOptimized(EngineBase* engine, std::string_view path) {
+    CrashIf(!engine);
+    if (!engine || path.empty()) {
+        return false;
+    }
+    EnginePdf* enginePdf = (EnginePdf*)engine;
+    fz_context* ctx = enginePdf->ctx;
+    pdf_document* doc = pdf_document_from_fz_document(ctx, enginePdf->_doc);
+
+    pdf_write_options save_opts;
+    save_opts = pdf_default_write_options2;
+    save_opts.do_compress = 1;
+    save_opts.do_compress_images = 1;
+    save_opts.do_compress_fonts = 1;
+    // 3 = garbage collect, renumber and de-duplicate identical objects
+    save_opts.do_garbage = 3;
+    save_opts.do_clean = 1;
+
+    bool ok = true;
+    fz_try(ctx) {
+        pdf_save_document(ctx, doc, path.data(), &save_opts);
+    }
+    fz_catch(ctx) {
+        const char* errMsg = fz_caught_message(ctx);
+        logf("Optimized pdf save of '%s' failed with '%s'\n", path.data(), errMsg);
+        ok = false;
+    }
+    return ok;
+}
+
 // https://github.com/sumatrapdfreader/sumatrapdf/issues/1336
 #if 0
 bool EnginePdf::SaveEmbedded(LinkSaverUI& saveUI, int num) {
@@ -1924,8 +2544,8 @@ WCHAR* EnginePdf::GetPageLabel(int pageNo) const {
 
 int EnginePdf::GetPageByLabel(const WCHAR* label) const {
     int pageNo = 0;
-    if (_pageLabels) {
-        pageNo = _pageLabels->Find(label) + 1;
+    if (_pageLabelIndex && !_pageLabelIndex->Get(label, &pageNo)) {
+        pageNo = 0;
     }
 
     if (!pageNo) {
@@ -2057,6 +2677,31 @@ int EnginePdfGetAnnotations(EngineBase* engine, Vec<Annotation*>* annotsOut) {
     return epdf->GetAnnotations(annotsOut);
 }
 
+// drops the page's cached annotation appearance list so that the next
+// render re-synthesizes the appearances; pageNo <= 0 drops every page's.
+// The contents display list is deliberately left alone
+void EnginePdf::DropAnnotAppearanceCache(int pageNo) {
+    ScopedCritSec cs(ctxAccess);
+    for (auto& piRef : _pages) {
+        FzPageInfo* pi = &piRef;
+        if (pageNo > 0 && pi->pageNo != pageNo) {
+            continue;
+        }
+        if (pi->annotsList) {
+            fz_drop_display_list(ctx, pi->annotsList);
+            pi->annotsList = nullptr;
+        }
+    }
+}
+
+void EnginePdfDropAnnotAppearanceCache(EngineBase* engine, int pageNo) {
+    if (!engine || engine->kind != kindEnginePdf) {
+        return;
+    }
+    EnginePdf* epdf = (EnginePdf*)engine;
+    epdf->DropAnnotAppearanceCache(pageNo);
+}
+
 bool EnginePdfHasUnsavedAnnotations(EngineBase* engine) {
     if (!engine || engine->kind != kindEnginePdf) {
         return false;
@@ -10,5 +10,8 @@ const WCHAR* ParseEmbeddedStreamNumber(const WCHAR* path, int* streamNoOut);
 Annotation* EnginePdfCreateAnnotation(EngineBase* engine, AnnotationType type, int pageNo, PointF pos);
 int EnginePdfGetAnnotations(EngineBase*, Vec<Annotation*>*);
 bool EnginePdfHasUnsavedAnnotations(EngineBase* engine);
-bool EnginePdfSaveUpdated(EngineBase* engine, std::string_view path);
+bool EnginePdfSaveUpdated(EngineBase* engine, std::string_view path, bool compact = false);
+bool EnginePdfSaveOptimized(EngineBase* engine, std::string_view path);
 Annotation* EnginePdfGetAnnotationAtPos(EngineBase* engine, int pageNo, PointF pos, AnnotationType* allowedAnnots);
+// call after editing annotations; pageNo <= 0 means all pages
+void EnginePdfDropAnnotAppearanceCache(EngineBase* engine, int pageNo);
@@ -17,6 +17,12 @@
 #include "EnginePdf.h"
 #include "EnginePs.h"
 
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "FileHistory.h"
+#include "AppTools.h"
+#include "FileThumbnails.h"
+
 Kind kindEnginePostScript = "enginePostScript";
 
 static WCHAR* GetGhostscriptPath() {
@@ -109,6 +115,94 @@ class ScopedFile {
     }
 };
 
+/* Converting a large PostScript file through Ghostscript can take tens
+   of seconds, so the resulting PDF is cached next to the thumbnails,
+   keyed the same way and validated by the source file's modification
+   time and size. */
+
+#define PS_CONV_DIR_NAME L"sumatrapdfcache"
+
+#define PS_CONV_MAGIC 0x53505053 // 'SPPS'
+#define PS_CONV_VERSION 1
+
+struct PsConversionHeader {
+    u32 magic;
+    u32 version;
+    FILETIME psModified;
+    i64 psSize;
+    // the converted PDF data follows
+};
+
+static WCHAR* GetPsConversionPath(const WCHAR* filePath) {
+    u8 digest[16];
+    if (!GetDocumentCacheKey(filePath, digest)) {
+        return nullptr;
+    }
+    AutoFree fingerPrint(_MemToHex(&digest));
+
+    AutoFreeWstr cachePath(AppGenDataFilename(PS_CONV_DIR_NAME));
+    if (!cachePath) {
+        return nullptr;
+    }
+    AutoFreeWstr fname(strconv::FromAnsi(fingerPrint));
+
+    return str::Format(L"%s\\%s.psconv", cachePath.Get(), fname.Get());
+}
+
+static i64 GetPsFileSize(const WCHAR* path) {
+    AutoFree pathUtf8(strconv::WstrToUtf8(path));
+    return file::GetSize(pathUtf8.AsView());
+}
+
+static EngineBase* LoadCachedPsConversion(const WCHAR* psPath) {
+    AutoFreeWstr cachePath(GetPsConversionPath(psPath));
+    if (!cachePath) {
+        return nullptr;
+    }
+    AutoFree data(file::ReadFile(cachePath.Get()));
+    size_t len = data.size();
+    if (len <= sizeof(PsConversionHeader)) {
+        return nullptr;
+    }
+    PsConversionHeader* hdr = (PsConversionHeader*)data.Get();
+    if (hdr->magic != PS_CONV_MAGIC || hdr->version != PS_CONV_VERSION) {
+        return nullptr;
+    }
+    if (hdr->psSize != GetPsFileSize(psPath)) {
+        return nullptr;
+    }
+    FILETIME psModified = file::GetModificationTime(psPath);
+    if (0 != FileTimeDiffInSecs(psModified, hdr->psModified)) {
+        return nullptr;
+    }
+
+    std::span<u8> pdfData((u8*)data.Get() + sizeof(PsConversionHeader), len - sizeof(PsConversionHeader));
+    auto strm = CreateStreamFromData(pdfData);
+    ScopedComPtr<IStream> stream(strm);
+    if (!stream) {
+        return nullptr;
+    }
+    return CreateEnginePdfFromStream(stream);
+}
+
+static void SavePsConversionToCache(const WCHAR* psPath, std::span<u8> pdfData) {
+    AutoFreeWstr cachePath(GetPsConversionPath(psPath));
+    if (!cachePath) {
+        return;
+    }
+    AutoFreeWstr cacheDir(path::GetDir(cachePath));
+    if (!dir::Create(cacheDir)) {
+        return;
+    }
+
+    PsConversionHeader hdr{PS_CONV_MAGIC, PS_CONV_VERSION, file::GetModificationTime(psPath), GetPsFileSize(psPath)};
+
+    str::Str data;
+    data.Append((char*)&hdr, sizeof(hdr));
+    data.Append((char*)pdfData.data(), pdfData.size());
+    file::WriteFile(cachePath, data.AsSpan());
+}
+
 static Rect ExtractDSCPageSize(const WCHAR* path) {
     char header[1024] = {0};
     file::ReadN(path, header, sizeof(header) - 1);
@@ -132,7 +226,10 @@ static Rect ExtractDSCPageSize(const WCHAR* path) {
     return {};
 }
 
-static EngineBase* ps2pdf(const WCHAR* path) {
+// srcPath is the file the user opened; it differs from path when the
+// PostScript had to be ungzipped to a TEMP file first and is what the
+// cached conversion result is keyed by
+static EngineBase* ps2pdf(const WCHAR* path, const WCHAR* srcPath) {
     // TODO: read from gswin32c's stdout instead of using a TEMP file
     AutoFreeWstr shortPath(path::ShortPath(path));
     AutoFreeWstr tmpFile(path::GetTempPath(L"PsE"));
@@ -188,6 +285,8 @@ static EngineBase* ps2pdf(const WCHAR* path) {
         return nullptr;
     }
 
+    SavePsConversionToCache(srcPath, pdfData.AsSpan());
+
     auto strm = CreateStreamFromData(pdfData.AsSpan());
     ScopedComPtr<IStream> stream(strm);
     if (!stream) {
@@ -226,7 +325,7 @@ static EngineBase* psgz2pdf(const WCHAR* fileName) {
     fclose(outFile);
     gzclose(inFile);
 
-    return ps2pdf(tmpFile);
+    return ps2pdf(tmpFile, fileName);
 }
 
 // EnginePs is mostly a proxy for a PdfEngine that's fed whatever
@@ -338,10 +437,13 @@ class EnginePs : public EngineBase {
             return false;
         }
         SetFileName(fileName);
-        if (file::StartsWith(fileName, "\x1F\x8B")) {
-            pdfEngine = psgz2pdf(fileName);
-        } else {
-            pdfEngine = ps2pdf(fileName);
+        pdfEngine = LoadCachedPsConversion(fileName);
+        if (!pdfEngine) {
+            if (file::StartsWith(fileName, "\x1F\x8B")) {
+                pdfEngine = psgz2pdf(fileName);
+            } else {
+                pdfEngine = ps2pdf(fileName, fileName);
+            }
         }
 
         if (str::EndsWithI(FileName(), L".eps")) {
@@ -25,6 +25,7 @@ extern "C" {
 #include "Annotation.h"
 #include "EngineBase.h"
 #include "EngineFzUtil.h"
+#include "DibPool.h"
 #include "EngineXps.h"
 
 Kind kindEngineXps = "engineXps";
@@ -299,7 +300,7 @@ EngineXps::EngineXps() {
     fz_locks_ctx.user = this;
     fz_locks_ctx.lock = fz_lock_context_cs;
     fz_locks_ctx.unlock = fz_unlock_context_cs;
-    ctx = fz_new_context(nullptr, &fz_locks_ctx, FZ_STORE_DEFAULT);
+    ctx = fz_new_context(fz_memacct_alloc_ctx(), &fz_locks_ctx, FZ_STORE_DEFAULT);
     installFitzErrorCallbacks(ctx);
 }
 
@@ -314,6 +315,12 @@ EngineXps::~EngineXps() {
         if (pi->page) {
             fz_drop_page(ctx, pi->page);
         }
+        if (pi->displayList) {
+            fz_drop_display_list(ctx, pi->displayList);
+        }
+        DeleteVecMembers(pi->autoLinks);
+        DeleteVecMembers(pi->comments);
+        DeleteVecMembers(pi->elements);
     }
 
     DeleteVecMembers(_pages);
@@ -470,9 +477,12 @@ FzPageInfo* EngineXps::GetFzPageInfo(int pageNo, bool failIfBusy) {
     int pageIdx = pageNo - 1;
     FzPageInfo* pageInfo = _pages[pageIdx];
     // TODO: not sure what failIfBusy is supposed to do
-    if (pageInfo->page || failIfBusy) {
+    // the page itself was loaded in LoadFromStream, here we extract
+    // links / images once (even if extraction fails, to not retry)
+    if (pageInfo->fullyLoaded || failIfBusy || !pageInfo->page) {
         return pageInfo;
     }
+    pageInfo->fullyLoaded = true;
 
     ScopedCritSec ctxScope(ctxAccess);
 
@@ -512,18 +522,20 @@ FzPageInfo* EngineXps::GetFzPageInfo(int pageNo, bool failIfBusy) {
     }
     fz_always(ctx) {
         fz_drop_device(ctx, dev);
-        if (list) {
-            fz_drop_display_list(ctx, list);
-        }
         dev = NULL;
     }
     fz_catch(ctx) {
         fz_drop_display_list(ctx, list);
+        list = NULL;
         // fz_drop_separations(ctx, seps);
     }
     if (!list) {
         return pageInfo;
     }
+    // keep the display list around: RenderPage() replays it, which is
+    // much cheaper than re-interpreting the fixed-page XML per repaint
+    pageInfo->displayList = list;
+
     pageInfo->links = fz_load_links(ctx, page);
 
     fz_stext_page* stext = nullptr;
@@ -578,8 +590,13 @@ RectF EngineXps::PageContentBox(int pageNo, [[maybe_unused]] RenderTarget target
 
     fz_try(ctx) {
         dev = fz_new_bbox_device(ctx, &rect);
-        list = fz_new_display_list_from_page(ctx, pageInfo->page);
-        fz_run_display_list(ctx, list, dev, fz_identity, pagerect, &fzcookie);
+        // prefer the display list cached by GetFzPageInfo() above
+        if (pageInfo->displayList) {
+            fz_run_display_list(ctx, pageInfo->displayList, dev, fz_identity, pagerect, &fzcookie);
+        } else {
+            list = fz_new_display_list_from_page(ctx, pageInfo->page);
+            fz_run_display_list(ctx, list, dev, fz_identity, pagerect, &fzcookie);
+        }
         fz_close_device(ctx, dev);
     }
     fz_always(ctx) {
@@ -645,13 +662,22 @@ RenderedBitmap* EngineXps::RenderPage(RenderPageArgs& args) {
     fz_pixmap* pix = nullptr;
     fz_device* dev = nullptr;
     RenderedBitmap* bitmap = nullptr;
+    HBITMAP dibBmp = nullptr;
+    HANDLE dibMap = nullptr;
 
     fz_var(dev);
     fz_var(pix);
     fz_var(bitmap);
+    fz_var(dibBmp);
+    fz_var(dibMap);
 
     fz_try(ctx) {
-        pix = fz_new_pixmap_with_bbox(ctx, colorspace, ibounds, nullptr, 1);
+        // rasterize directly into the DIB section that ends up on screen
+        pix = fz_new_pixmap_in_dib_section(ctx, ibounds, &dibBmp, &dibMap);
+        if (!pix) {
+            // e.g. on GDI resource exhaustion
+            pix = fz_new_pixmap_with_bbox(ctx, colorspace, ibounds, nullptr, 1);
+        }
         // initialize with white background
         fz_clear_pixmap_with_value(ctx, pix, 0xff);
 
@@ -659,9 +685,25 @@ RenderedBitmap* EngineXps::RenderPage(RenderPageArgs& args) {
         // or "Print". "Export" is not used
         dev = fz_new_draw_device(ctx, fz_identity, pix);
         // TODO: use fz_infinite_rect instead of cliprect?
-        fz_run_page(ctx, page, dev, ctm, fzcookie);
-        bitmap = new_rendered_fz_pixmap(ctx, pix);
+        if (pageInfo->displayList) {
+            // replay the display list cached by GetFzPageInfo() instead of
+            // re-interpreting the fixed-page XML on every render
+            fz_run_display_list(ctx, pageInfo->displayList, dev, ctm, cliprect, fzcookie);
+        } else {
+            // the display list failed to build, interpret the page directly
+            fz_run_page(ctx, page, dev, ctm, fzcookie);
+        }
         fz_close_device(ctx, dev);
+        fz_drop_device(ctx, dev);
+        dev = nullptr;
+        if (dibBmp) {
+            bitmap = new RenderedBitmap(dibBmp, Size(pix->w, pix->h), dibMap);
+            // now owned by bitmap
+            dibBmp = nullptr;
+            dibMap = nullptr;
+        } else {
+            bitmap = new_rendered_fz_pixmap(ctx, pix);
+        }
     }
     fz_always(ctx) {
         if (dev) {
@@ -670,6 +712,12 @@ RenderedBitmap* EngineXps::RenderPage(RenderPageArgs& args) {
         fz_drop_pixmap(ctx, pix);
     }
     fz_catch(ctx) {
+        if (dibBmp && !DibPoolRelease(dibBmp)) {
+            DeleteObject(dibBmp);
+        }
+        if (dibMap) {
+            CloseHandle(dibMap);
+        }
         delete bitmap;
         return nullptr;
     }
@@ -787,26 +835,9 @@ void EngineXps::ResolveLinks(Vec<IPageElement*>* els, fz_link* link) {
 }
 
 Vec<IPageElement*>* EngineXps::GetElements(int pageNo) {
-    FzPageInfo* pageInfo = GetFzPageInfo(pageNo, true);
-    if (!pageInfo) {
-        return nullptr;
-    }
-    auto res = new Vec<IPageElement*>();
-
-#if 0
-    fz_link* links = pageInfo->links;
-    ResolveLinks(res, links);
-    // this is a hack: temporarily remove pageInfo->links so that FzGetElements()
-    // doesn't process it
-    pageInfo->links = nullptr;
-#endif
-
-    FzGetElements(res, pageInfo);
-#if 0
-    pageInfo->links = links;
-#endif
-    if (res->IsEmpty()) {
-        delete res;
+    FzPageInfo* pageInfo = GetFzPageInfo(pageNo, false);
+    auto res = FzGetElements(pageInfo);
+    if (!res || res->IsEmpty()) {
         return nullptr;
     }
     return res;
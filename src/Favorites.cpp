@@ -116,9 +116,43 @@ TreeItem* FavTreeModel::RootAt(int n) {
     return children[n];
 }
 
-Favorite* Favorites::GetByMenuId(int menuId, DisplayState** dsOut) {
+static int SortStatesByBaseFileName(const void* a, const void* b) {
+    const WCHAR* baseA = path::GetBaseNameNoFree((*(DisplayState**)a)->filePath);
+    const WCHAR* baseB = path::GetBaseNameNoFree((*(DisplayState**)b)->filePath);
+    return str::CmpNatural(baseA, baseB);
+}
+
+void Favorites::EnsureFavStates() {
+    if (favStatesValid) {
+        return;
+    }
+    favStates.Reset();
     DisplayState* ds;
     for (size_t i = 0; (ds = gFileHistory.Get(i)) != nullptr; i++) {
+        if (ds->favorites->size() > 0) {
+            favStates.Append(ds);
+        }
+    }
+    favStates.Sort(SortStatesByBaseFileName);
+    favStatesValid = true;
+}
+
+void Favorites::InvalidateCache() {
+    favStatesValid = false;
+    idxCache = (size_t)-1;
+}
+
+void Favorites::GetSortedStates(Vec<DisplayState*>& out) {
+    EnsureFavStates();
+    for (size_t i = 0; i < favStates.size(); i++) {
+        out.Append(favStates.at(i));
+    }
+}
+
+Favorite* Favorites::GetByMenuId(int menuId, DisplayState** dsOut) {
+    EnsureFavStates();
+    for (size_t i = 0; i < favStates.size(); i++) {
+        DisplayState* ds = favStates.at(i);
         for (size_t j = 0; j < ds->favorites->size(); j++) {
             if (menuId == ds->favorites->at(j)->menuId) {
                 if (dsOut) {
@@ -132,18 +166,19 @@ Favorite* Favorites::GetByMenuId(int menuId, DisplayState** dsOut) {
 }
 
 DisplayState* Favorites::GetByFavorite(Favorite* fn) {
-    DisplayState* ds;
-    for (size_t i = 0; (ds = gFileHistory.Get(i)) != nullptr; i++) {
-        if (ds->favorites->Contains(fn)) {
-            return ds;
+    EnsureFavStates();
+    for (size_t i = 0; i < favStates.size(); i++) {
+        if (favStates.at(i)->favorites->Contains(fn)) {
+            return favStates.at(i);
         }
     }
     return nullptr;
 }
 
 void Favorites::ResetMenuIds() {
-    DisplayState* ds;
-    for (size_t i = 0; (ds = gFileHistory.Get(i)) != nullptr; i++) {
+    EnsureFavStates();
+    for (size_t i = 0; i < favStates.size(); i++) {
+        DisplayState* ds = favStates.at(i);
         for (size_t j = 0; j < ds->favorites->size(); j++) {
             ds->favorites->at(j)->menuId = 0;
         }
@@ -220,6 +255,8 @@ void Favorites::AddOrReplace(const WCHAR* filePath, int pageNo, const WCHAR* nam
         fav->favorites->Append(fn);
         fav->favorites->Sort(SortByPageNo);
     }
+    // the file might not have had favorites before
+    favStatesValid = false;
 }
 
 void Favorites::Remove(const WCHAR* filePath, int pageNo) {
@@ -238,7 +275,9 @@ void Favorites::Remove(const WCHAR* filePath, int pageNo) {
     if (!gGlobalPrefs->rememberOpenedFiles && 0 == fav->favorites->size()) {
         gFileHistory.Remove(fav);
         DeleteDisplayState(fav);
+        idxCache = (size_t)-1;
     }
+    favStatesValid = false;
 }
 
 void Favorites::RemoveAllForFile(const WCHAR* filePath) {
@@ -255,7 +294,9 @@ void Favorites::RemoveAllForFile(const WCHAR* filePath) {
     if (!gGlobalPrefs->rememberOpenedFiles) {
         gFileHistory.Remove(fav);
         DeleteDisplayState(fav);
+        idxCache = (size_t)-1;
     }
+    favStatesValid = false;
 }
 
 // Note: those might be too big
@@ -270,13 +311,9 @@ MenuDef menuDefFavContext[] = {
 // clang-format on
 
 bool HasFavorites() {
-    DisplayState* ds;
-    for (size_t i = 0; (ds = gFileHistory.Get(i)) != nullptr; i++) {
-        if (ds->favorites->size() > 0) {
-            return true;
-        }
-    }
-    return false;
+    Vec<DisplayState*> states;
+    gFavorites.GetSortedStates(states);
+    return states.size() > 0;
 }
 
 // caller has to free() the result
@@ -322,24 +359,6 @@ static void AppendFavMenuItems(HMENU m, DisplayState* f, int& idx, bool combined
     }
 }
 
-static int SortByBaseFileName(const void* a, const void* b) {
-    const WCHAR* filePathA = *(const WCHAR**)a;
-    const WCHAR* filePathB = *(const WCHAR**)b;
-    const WCHAR* baseA = path::GetBaseNameNoFree(filePathA);
-    const WCHAR* baseB = path::GetBaseNameNoFree(filePathB);
-    return str::CmpNatural(baseA, baseB);
-}
-
-static void GetSortedFilePaths(Vec<const WCHAR*>& filePathsSortedOut, DisplayState* toIgnore = nullptr) {
-    DisplayState* ds;
-    for (size_t i = 0; (ds = gFileHistory.Get(i)) != nullptr; i++) {
-        if (ds->favorites->size() > 0 && ds != toIgnore) {
-            filePathsSortedOut.Append(ds->filePath);
-        }
-    }
-    filePathsSortedOut.Sort(SortByBaseFileName);
-}
-
 // For easy access, we try to show favorites in the menu, similar to a list of
 // recently opened files.
 // The first menu items are for currently opened file (up to MAX_FAV_MENUS), based
@@ -359,17 +378,20 @@ static void AppendFavMenus(HMENU m, const WCHAR* currFilePath) {
         currFileFav = gFavorites.GetFavByFilePath(currFilePath);
     }
 
-    // sort the files with favorites by base file name of file path
-    Vec<const WCHAR*> filePathsSorted;
+    // the files with favorites, sorted by base file name
+    Vec<DisplayState*> favStatesSorted;
     if (HasPermission(Perm_DiskAccess)) {
         // only show favorites for other files, if we're allowed to open them
-        GetSortedFilePaths(filePathsSorted, currFileFav);
+        gFavorites.GetSortedStates(favStatesSorted);
+        if (currFileFav) {
+            favStatesSorted.Remove(currFileFav);
+        }
     }
     if (currFileFav && currFileFav->favorites->size() > 0) {
-        filePathsSorted.InsertAt(0, currFileFav->filePath);
+        favStatesSorted.InsertAt(0, currFileFav);
     }
 
-    if (filePathsSorted.size() == 0) {
+    if (favStatesSorted.size() == 0) {
         return;
     }
 
@@ -378,18 +400,13 @@ static void AppendFavMenus(HMENU m, const WCHAR* currFilePath) {
     gFavorites.ResetMenuIds();
     int menuId = CmdFavoriteFirst;
 
-    size_t menusCount = filePathsSorted.size();
+    size_t menusCount = favStatesSorted.size();
     if (menusCount > MAX_FAV_MENUS) {
         menusCount = MAX_FAV_MENUS;
     }
 
     for (size_t i = 0; i < menusCount; i++) {
-        const WCHAR* filePath = filePathsSorted.at(i);
-        DisplayState* f = gFavorites.GetFavByFilePath(filePath);
-        CrashIf(!f);
-        if (!f) {
-            continue;
-        }
+        DisplayState* f = favStatesSorted.at(i);
         HMENU sub = m;
         bool combined = (f->favorites->size() == 1);
         if (!combined) {
@@ -401,7 +418,7 @@ static void AppendFavMenus(HMENU m, const WCHAR* currFilePath) {
                 AppendMenu(m, MF_POPUP | MF_STRING, (UINT_PTR)sub, _TR("Current file"));
             } else {
                 AutoFreeWstr tmp;
-                tmp.SetCopy(path::GetBaseNameNoFree(filePath));
+                tmp.SetCopy(path::GetBaseNameNoFree(f->filePath));
                 auto fileName = win::menu::ToSafeString(tmp);
                 AppendMenuW(m, MF_POPUP | MF_STRING, (UINT_PTR)sub, fileName);
             }
@@ -568,10 +585,10 @@ static void MakeFavSecondLevel(FavTreeItem* parent, DisplayState* f) {
 
 static FavTreeModel* BuildFavTreeModel(WindowInfo* win) {
     auto* res = new FavTreeModel();
-    Vec<const WCHAR*> filePathsSorted;
-    GetSortedFilePaths(filePathsSorted);
-    for (size_t i = 0; i < filePathsSorted.size(); i++) {
-        DisplayState* f = gFavorites.GetFavByFilePath(filePathsSorted.at(i));
+    Vec<DisplayState*> favStatesSorted;
+    gFavorites.GetSortedStates(favStatesSorted);
+    for (size_t i = 0; i < favStatesSorted.size(); i++) {
+        DisplayState* f = favStatesSorted.at(i);
         bool isExpanded = win->expandedFavorites.Contains(f);
         FavTreeItem* ti = MakeFavTopLevelItem(f, isExpanded);
         res->children.Append(ti);
@@ -653,7 +670,7 @@ void AddFavoriteWithLabelAndName(WindowInfo* win, int pageNo, const WCHAR* pageL
         win->expandedFavorites.Append(fav);
     }
     UpdateFavoritesTreeForAllWindows();
-    prefs::Save();
+    prefs::ScheduleSave();
 }
 
 void AddFavoriteForCurrentPage(WindowInfo* win, int pageNo) {
@@ -688,7 +705,7 @@ void DelFavorite(const WCHAR* filePath, int pageNo) {
     RememberFavTreeExpansionStateForAllWindows();
     gFavorites.Remove(filePath, pageNo);
     UpdateFavoritesTreeForAllWindows();
-    prefs::Save();
+    prefs::ScheduleSave();
 }
 
 void RememberFavTreeExpansionState(WindowInfo* win) {
@@ -780,7 +797,7 @@ static void FavTreeContextMenu(ContextMenuEvent* ev) {
             gFavorites.RemoveAllForFile(f->filePath);
         }
         UpdateFavoritesTreeForAllWindows();
-        prefs::Save();
+        prefs::ScheduleSave();
     }
 }
 
@@ -799,7 +816,7 @@ static LRESULT CALLBACK WndProcFavBox(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
     TreeCtrl* treeCtrl = win->favTreeCtrl;
     switch (msg) {
         case WM_SIZE:
-            LayoutTreeContainer(win->favLabelWithClose, nullptr, treeCtrl->hwnd);
+            LayoutTreeContainer(win->favLabelWithClose, nullptr, nullptr, treeCtrl->hwnd);
             break;
 
         case WM_COMMAND:
@@ -23,6 +23,15 @@ per-file basis in FileHistory.
 class Favorites {
     size_t idxCache = (size_t)-1;
 
+    // the files that have favorites, sorted by base file name. Built
+    // lazily so that lookups and menu building iterate a handful of
+    // files instead of scanning the whole (possibly multi-thousand
+    // entry) file history every time
+    Vec<DisplayState*> favStates;
+    bool favStatesValid = false;
+
+    void EnsureFavStates();
+
   public:
     Favorites() = default;
 
@@ -34,6 +43,12 @@ class Favorites {
     void AddOrReplace(const WCHAR* filePath, int pageNo, const WCHAR* name, const WCHAR* pageLabel = nullptr);
     void Remove(const WCHAR* filePath, int pageNo);
     void RemoveAllForFile(const WCHAR* filePath);
+
+    // appends the files that have favorites, sorted by base file name
+    void GetSortedStates(Vec<DisplayState*>& out);
+    // must be called when the file history changes behind this class'
+    // back (e.g. after the settings file was reloaded)
+    void InvalidateCache();
 };
 
 bool HasFavorites();
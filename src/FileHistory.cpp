@@ -2,6 +2,7 @@
 License: GPLv3 */
 
 #include "utils/BaseUtil.h"
+#include "utils/Dict.h"
 #include "utils/FileUtil.h"
 #include "utils/ScopedWin.h"
 
@@ -60,17 +61,59 @@ static int cmpOpenCount(const void* a, const void* b) {
     return dsA->index < dsB->index ? -1 : 1;
 }
 
+FileHistory::FileHistory() {
+    index = new dict::MapWStrToPtr();
+}
+
+FileHistory::~FileHistory() {
+    delete index;
+}
+
+// the history is searched case-insensitively, so the index is keyed
+// by the lower-cased path
+void FileHistory::AddToIndex(DisplayState* state) {
+    AutoFreeWstr key = str::ToLower(state->filePath);
+    // if the settings file was edited by hand and contains the same path
+    // twice, only the first entry is indexed (same as the old linear Find)
+    index->Insert(key, state, nullptr);
+}
+
+void FileHistory::RemoveFromIndex(DisplayState* state) {
+    AutoFreeWstr key = str::ToLower(state->filePath);
+    void* mapped = nullptr;
+    if (index->Get(key, &mapped) && mapped == state) {
+        index->Remove(key, nullptr);
+    }
+}
+
+void FileHistory::RebuildIndex() {
+    delete index;
+    index = new dict::MapWStrToPtr();
+    if (!states) {
+        return;
+    }
+    for (DisplayState* ds : *states) {
+        AddToIndex(ds);
+    }
+}
+
 void FileHistory::Append(DisplayState* state) {
     CrashIf(!state->filePath);
     states->Append(state);
+    AddToIndex(state);
+    version++;
 }
 
 void FileHistory::Remove(DisplayState* state) {
+    RemoveFromIndex(state);
     states->Remove(state);
+    version++;
 }
 
 void FileHistory::UpdateStatesSource(Vec<DisplayState*>* states) {
     this->states = states;
+    RebuildIndex();
+    version++;
 }
 
 void FileHistory::Clear(bool keepFavorites) {
@@ -87,6 +130,8 @@ void FileHistory::Clear(bool keepFavorites) {
         }
     }
     *states = keep;
+    RebuildIndex();
+    version++;
 }
 
 DisplayState* FileHistory::Get(size_t index) const {
@@ -97,15 +142,18 @@ DisplayState* FileHistory::Get(size_t index) const {
 }
 
 DisplayState* FileHistory::Find(const WCHAR* filePath, size_t* idxOut) const {
-    for (size_t i = 0; i < states->size(); i++) {
-        if (str::EqI(states->at(i)->filePath, filePath)) {
-            if (idxOut) {
-                *idxOut = i;
-            }
-            return states->at(i);
-        }
+    AutoFreeWstr key = str::ToLower(filePath);
+    void* mapped = nullptr;
+    if (!index->Get(key, &mapped)) {
+        return nullptr;
     }
-    return nullptr;
+    DisplayState* state = (DisplayState*)mapped;
+    if (idxOut) {
+        int idx = states->Find(state);
+        CrashIf(idx < 0);
+        *idxOut = (size_t)idx;
+    }
+    return state;
 }
 
 DisplayState* FileHistory::MarkFileLoaded(const WCHAR* filePath) {
@@ -117,12 +165,14 @@ DisplayState* FileHistory::MarkFileLoaded(const WCHAR* filePath) {
     if (!state) {
         state = NewDisplayState(filePath);
         state->useDefaultState = true;
+        AddToIndex(state);
     } else {
         states->Remove(state);
         state->isMissing = false;
     }
     states->InsertAt(0, state);
     state->openCount++;
+    version++;
     return state;
 }
 
@@ -153,9 +203,19 @@ bool FileHistory::MarkFileInexistent(const WCHAR* filePath, bool hide) {
     state->thumbnail = nullptr;
     state->openCount >>= 2;
     state->isMissing = hide;
+    version++;
     return true;
 }
 
+// changes the path of an entry in place, keeping its position in the list
+// (and thus its recency); used when a file is renamed or moved
+void FileHistory::UpdatePath(DisplayState* state, const WCHAR* newPath) {
+    RemoveFromIndex(state);
+    str::ReplacePtr(&state->filePath, newPath);
+    AddToIndex(state);
+    version++;
+}
+
 // returns a shallow copy of the file history list, sorted
 // by open count (which has a pre-multiplied recency factor)
 // and with all missing states filtered out
@@ -206,6 +266,8 @@ void FileHistory::Purge(bool alwaysUseDefaultState) {
         } else {
             continue;
         }
+        RemoveFromIndex(state);
         DeleteDisplayState(state);
     }
+    version++;
 }
@@ -10,12 +10,23 @@
 // Frequent Read list (space permitting)
 #define FILE_HISTORY_MAX_FREQUENT 10
 
+namespace dict {
+class MapWStrToPtr;
+}
+
 struct FileHistory {
     // owned by gGlobalPrefs->fileStates
     Vec<DisplayState*>* states = nullptr;
+    // maps lower-cased file paths to their state, so that Find doesn't
+    // have to do a linear scan with a string compare per entry (which
+    // made operations on a multi-thousand entry history quadratic)
+    dict::MapWStrToPtr* index = nullptr;
+    // bumped on every modification; lets the menu code skip rebuilding
+    // the recently-opened-files list when the history hasn't changed
+    int version = 1;
 
-    FileHistory() = default;
-    ~FileHistory() = default;
+    FileHistory();
+    ~FileHistory();
 
     void Clear(bool keepFavorites);
     void Append(DisplayState* state);
@@ -24,7 +35,12 @@ struct FileHistory {
     DisplayState* Find(const WCHAR* filePath, size_t* idxOut) const;
     DisplayState* MarkFileLoaded(const WCHAR* filePath);
     bool MarkFileInexistent(const WCHAR* filePath, bool hide = false);
+    void UpdatePath(DisplayState* state, const WCHAR* newPath);
     void GetFrequencyOrder(Vec<DisplayState*>& list) const;
     void Purge(bool alwaysUseDefaultState = false);
     void UpdateStatesSource(Vec<DisplayState*>* states);
+
+    void AddToIndex(DisplayState* state);
+    void RemoveFromIndex(DisplayState* state);
+    void RebuildIndex();
 };
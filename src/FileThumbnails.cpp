@@ -19,27 +19,35 @@
 #include "AppTools.h"
 #include "FileThumbnails.h"
 
-#define THUMBNAILS_DIR_NAME L"sumatrapdfcache"
-
-// TODO: create in TEMP directory instead?
-static WCHAR* GetThumbnailPath(const WCHAR* filePath) {
-    // create a fingerprint of a (normalized) path for the file name
-    // I'd have liked to also include the file's last modification time
-    // in the fingerprint (much quicker than hashing the entire file's
-    // content), but that's too expensive for files on slow drives
-    u8 digest[16];
+// fingerprint of a (normalized) path, used to identify a thumbnail
+// (and other per-document cache data, e.g. the ebook layout cache).
+// I'd have liked to also include the file's last modification time
+// in the fingerprint (much quicker than hashing the entire file's
+// content), but that's too expensive for files on slow drives
+bool GetDocumentCacheKey(const WCHAR* filePath, u8 key[16]) {
     // TODO: why is this happening? Seen in crash reports e.g. 35043
     if (!filePath) {
-        return nullptr;
+        return false;
     }
     AutoFree pathU(strconv::WstrToUtf8(filePath));
     if (!pathU.Get()) {
-        return nullptr;
+        return false;
     }
     if (path::HasVariableDriveLetter(filePath)) {
         pathU.Get()[0] = '?'; // ignore the drive letter, if it might change
     }
-    CalcMD5Digest((u8*)pathU.Get(), str::Len(pathU.Get()), digest);
+    CalcMD5Digest((u8*)pathU.Get(), str::Len(pathU.Get()), key);
+    return true;
+}
+
+// path of the legacy one-PNG-per-document layout, kept around so that
+// old thumbnails can be migrated into the pack file and cleaned up
+// TODO: create in TEMP directory instead?
+static WCHAR* GetThumbnailPath(const WCHAR* filePath) {
+    u8 digest[16];
+    if (!GetDocumentCacheKey(filePath, digest)) {
+        return nullptr;
+    }
     AutoFree fingerPrint(_MemToHex(&digest));
 
     AutoFreeWstr thumbsPath(AppGenDataFilename(THUMBNAILS_DIR_NAME));
@@ -51,6 +59,105 @@ static WCHAR* GetThumbnailPath(const WCHAR* filePath) {
     return str::Format(L"%s\\%s.png", thumbsPath.Get(), fname.Get());
 }
 
+// the pack format is declared in FileThumbnails.h
+
+static bool gPackLoaded = false;
+static Vec<ThumbnailPackEntry> gPackIndex;
+static str::Str gPackData;
+
+static WCHAR* GetThumbnailPackPath() {
+    AutoFreeWstr thumbsPath(AppGenDataFilename(THUMBNAILS_DIR_NAME));
+    if (!thumbsPath) {
+        return nullptr;
+    }
+    return path::Join(thumbsPath, THUMBNAIL_PACK_FILE_NAME);
+}
+
+static void LoadThumbnailPack() {
+    if (gPackLoaded) {
+        return;
+    }
+    gPackLoaded = true;
+
+    AutoFreeWstr path(GetThumbnailPackPath());
+    if (!path) {
+        return;
+    }
+    AutoFree data(file::ReadFile(path.Get()));
+    size_t len = data.size();
+    if (len < sizeof(ThumbnailPackHeader)) {
+        return;
+    }
+    ThumbnailPackHeader* hdr = (ThumbnailPackHeader*)data.Get();
+    if (hdr->magic != THUMBNAIL_PACK_MAGIC || hdr->version != THUMBNAIL_PACK_VERSION) {
+        return;
+    }
+    i32 nEntries = hdr->nEntries;
+    size_t dataOff = sizeof(ThumbnailPackHeader) + (size_t)nEntries * sizeof(ThumbnailPackEntry);
+    if (nEntries < 0 || dataOff > len) {
+        return;
+    }
+    size_t dataSize = len - dataOff;
+    ThumbnailPackEntry* entries = (ThumbnailPackEntry*)(data.Get() + sizeof(ThumbnailPackHeader));
+    for (i32 i = 0; i < nEntries; i++) {
+        if ((size_t)entries[i].offset + entries[i].size > dataSize) {
+            // corrupt, start over with an empty cache
+            gPackIndex.Reset();
+            return;
+        }
+        gPackIndex.Append(entries[i]);
+    }
+    gPackData.Append(data.Get() + dataOff, dataSize);
+}
+
+static bool SaveThumbnailPack() {
+    AutoFreeWstr path(GetThumbnailPackPath());
+    if (!path) {
+        return false;
+    }
+    AutoFreeWstr thumbsPath(path::GetDir(path));
+    if (!dir::Create(thumbsPath)) {
+        return false;
+    }
+    str::Str d;
+    ThumbnailPackHeader hdr{THUMBNAIL_PACK_MAGIC, THUMBNAIL_PACK_VERSION, (i32)gPackIndex.isize(), 0};
+    d.Append((char*)&hdr, sizeof(hdr));
+    d.Append((char*)gPackIndex.LendData(), gPackIndex.size() * sizeof(ThumbnailPackEntry));
+    d.Append(gPackData.Get(), gPackData.size());
+    return file::WriteFile(path.Get(), d.AsSpan());
+}
+
+static int FindPackEntry(const u8 key[16]) {
+    for (size_t i = 0; i < gPackIndex.size(); i++) {
+        if (memeq(gPackIndex.at(i).key, key, 16)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void AddPackEntry(const u8 key[16], std::span<u8> pngData, FILETIME createdAt) {
+    ThumbnailPackEntry e{};
+    memcpy(e.key, key, sizeof(e.key));
+    e.createdAt = createdAt;
+    e.offset = (u32)gPackData.size();
+    e.size = (u32)pngData.size();
+    gPackData.Append((char*)pngData.data(), pngData.size());
+    gPackIndex.Append(e);
+}
+
+static void RemovePackEntryAt(size_t idx) {
+    ThumbnailPackEntry removed = gPackIndex.at(idx);
+    gPackData.RemoveAt(removed.offset, removed.size);
+    gPackIndex.RemoveAt(idx);
+    // the data of the entries stored after the removed one moved down
+    for (size_t i = 0; i < gPackIndex.size(); i++) {
+        if (gPackIndex.at(i).offset > removed.offset) {
+            gPackIndex.at(i).offset -= removed.size;
+        }
+    }
+}
+
 // removes thumbnails that don't belong to any frequently used item in file history
 void CleanUpThumbnailCache(const FileHistory& fileHistory) {
     AutoFreeWstr thumbsPath(AppGenDataFilename(THUMBNAILS_DIR_NAME));
@@ -63,15 +170,18 @@ void CleanUpThumbnailCache(const FileHistory& fileHistory) {
     WIN32_FIND_DATA fdata;
 
     HANDLE hfind = FindFirstFile(pattern, &fdata);
-    if (INVALID_HANDLE_VALUE == hfind) {
-        return;
+    if (INVALID_HANDLE_VALUE != hfind) {
+        do {
+            if (!(fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                files.Append(str::Dup(fdata.cFileName));
+            }
+        } while (FindNextFile(hfind, &fdata));
+        FindClose(hfind);
     }
-    do {
-        if (!(fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-            files.Append(str::Dup(fdata.cFileName));
-        }
-    } while (FindNextFile(hfind, &fdata));
-    FindClose(hfind);
+
+    LoadThumbnailPack();
+    Vec<ThumbnailPackEntry> keepEntries;
+    str::Str keepData;
 
     Vec<DisplayState*> list;
     fileHistory.GetFrequencyOrder(list);
@@ -85,12 +195,32 @@ void CleanUpThumbnailCache(const FileHistory& fileHistory) {
             CrashIf(idx < 0 || files.size() <= (size_t)idx);
             free(files.PopAt(idx));
         }
+
+        u8 key[16];
+        if (!GetDocumentCacheKey(list.at(i)->filePath, key)) {
+            continue;
+        }
+        int entryIdx = FindPackEntry(key);
+        if (entryIdx != -1) {
+            ThumbnailPackEntry e = gPackIndex.at(entryIdx);
+            u32 offset = e.offset;
+            e.offset = (u32)keepData.size();
+            keepData.Append(gPackData.Get() + offset, e.size);
+            keepEntries.Append(e);
+        }
     }
 
     for (size_t i = 0; i < files.size(); i++) {
         AutoFreeWstr bmpPath(path::Join(thumbsPath, files.at(i)));
         file::Delete(bmpPath);
     }
+
+    if (keepEntries.size() != gPackIndex.size()) {
+        gPackIndex = keepEntries;
+        gPackData.Reset();
+        gPackData.Append(keepData.Get(), keepData.size());
+        SaveThumbnailPack();
+    }
 }
 
 // using namespace Gdiplus;
@@ -124,12 +254,8 @@ using Gdiplus::StringFormatFlagsDirectionRightToLeft;
 using Gdiplus::TextRenderingHintClearTypeGridFit;
 using Gdiplus::UnitPixel;
 
-static RenderedBitmap* LoadRenderedBitmap(const WCHAR* filePath) {
-    AutoFree data(file::ReadFile(filePath));
-    if (!data.data) {
-        return nullptr;
-    }
-    Gdiplus::Bitmap* bmp = BitmapFromData(data.AsSpan());
+static RenderedBitmap* RenderedBitmapFromData(std::span<u8> data) {
+    Gdiplus::Bitmap* bmp = BitmapFromData(data);
     if (!bmp) {
         return nullptr;
     }
@@ -144,16 +270,43 @@ static RenderedBitmap* LoadRenderedBitmap(const WCHAR* filePath) {
     return rendered;
 }
 
+// moves a thumbnail from the legacy one-PNG-per-document layout into the
+// pack file (the PNG's modification time becomes the creation time)
+static int MigrateLegacyThumbnail(const WCHAR* filePath, const u8 key[16]) {
+    AutoFreeWstr bmpPath(GetThumbnailPath(filePath));
+    if (!bmpPath) {
+        return -1;
+    }
+    AutoFree data(file::ReadFile(bmpPath.Get()));
+    if (!data.data || 0 == data.size()) {
+        return -1;
+    }
+    AddPackEntry(key, data.AsSpan(), file::GetModificationTime(bmpPath));
+    SaveThumbnailPack();
+    file::Delete(bmpPath);
+    return (int)gPackIndex.size() - 1;
+}
+
 bool LoadThumbnail(DisplayState& ds) {
     delete ds.thumbnail;
     ds.thumbnail = nullptr;
 
-    AutoFreeWstr bmpPath(GetThumbnailPath(ds.filePath));
-    if (!bmpPath) {
+    u8 key[16];
+    if (!GetDocumentCacheKey(ds.filePath, key)) {
+        return false;
+    }
+    LoadThumbnailPack();
+    int idx = FindPackEntry(key);
+    if (idx == -1) {
+        idx = MigrateLegacyThumbnail(ds.filePath, key);
+    }
+    if (idx == -1) {
         return false;
     }
 
-    RenderedBitmap* bmp = LoadRenderedBitmap(bmpPath);
+    ThumbnailPackEntry& e = gPackIndex.at(idx);
+    std::span<u8> pngData((u8*)gPackData.Get() + e.offset, e.size);
+    RenderedBitmap* bmp = RenderedBitmapFromData(pngData);
     if (!bmp || bmp->Size().IsEmpty()) {
         delete bmp;
         return false;
@@ -168,11 +321,15 @@ bool HasThumbnail(DisplayState& ds) {
         return false;
     }
 
-    AutoFreeWstr bmpPath(GetThumbnailPath(ds.filePath));
-    if (!bmpPath) {
+    u8 key[16];
+    if (!GetDocumentCacheKey(ds.filePath, key)) {
+        return true;
+    }
+    int idx = FindPackEntry(key);
+    if (idx == -1) {
         return true;
     }
-    FILETIME bmpTime = file::GetModificationTime(bmpPath);
+    FILETIME bmpTime = gPackIndex.at(idx).createdAt;
     FILETIME fileTime = file::GetModificationTime(ds.filePath);
     // delete the thumbnail if the file is newer than the thumbnail
     if (FileTimeDiffInSecs(fileTime, bmpTime) > 0) {
@@ -199,16 +356,40 @@ void SaveThumbnail(DisplayState& ds) {
         return;
     }
 
-    AutoFreeWstr bmpPath(GetThumbnailPath(ds.filePath));
-    if (!bmpPath) {
+    u8 key[16];
+    if (!GetDocumentCacheKey(ds.filePath, key)) {
+        return;
+    }
+
+    // encode the PNG into memory, it goes into the pack file
+    ScopedComPtr<IStream> stream;
+    if (FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &stream))) {
+        return;
+    }
+    Gdiplus::Bitmap bmp(ds.thumbnail->GetBitmap(), nullptr);
+    CLSID tmpClsid = GetEncoderClsid(L"image/png");
+    if (bmp.Save(stream, &tmpClsid, nullptr) != Gdiplus::Ok) {
+        return;
+    }
+    AutoFree pngData(GetDataFromStream(stream, nullptr));
+    if (!pngData.data || 0 == pngData.size()) {
         return;
     }
-    AutoFreeWstr thumbsPath(path::GetDir(bmpPath));
-    if (dir::Create(thumbsPath)) {
-        CrashIf(!str::EndsWithI(bmpPath, L".png"));
-        Gdiplus::Bitmap bmp(ds.thumbnail->GetBitmap(), nullptr);
-        CLSID tmpClsid = GetEncoderClsid(L"image/png");
-        bmp.Save(bmpPath.Get(), &tmpClsid, nullptr);
+
+    LoadThumbnailPack();
+    int idx = FindPackEntry(key);
+    if (idx != -1) {
+        RemovePackEntryAt(idx);
+    }
+    FILETIME createdAt;
+    GetSystemTimeAsFileTime(&createdAt);
+    AddPackEntry(key, pngData.AsSpan(), createdAt);
+    SaveThumbnailPack();
+
+    // remove a leftover from the legacy one-PNG-per-document layout
+    AutoFreeWstr bmpPath(GetThumbnailPath(ds.filePath));
+    if (bmpPath) {
+        file::Delete(bmpPath);
     }
 }
 
@@ -217,6 +398,15 @@ void RemoveThumbnail(DisplayState& ds) {
         return;
     }
 
+    u8 key[16];
+    if (GetDocumentCacheKey(ds.filePath, key)) {
+        LoadThumbnailPack();
+        int idx = FindPackEntry(key);
+        if (idx != -1) {
+            RemovePackEntryAt(idx);
+            SaveThumbnailPack();
+        }
+    }
     AutoFreeWstr bmpPath(GetThumbnailPath(ds.filePath));
     if (bmpPath) {
         file::Delete(bmpPath);
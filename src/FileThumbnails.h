@@ -5,8 +5,37 @@
 #define THUMBNAIL_DX 212
 #define THUMBNAIL_DY 150
 
+#define THUMBNAILS_DIR_NAME L"sumatrapdfcache"
+#define THUMBNAIL_PACK_FILE_NAME L"thumbnails.dat"
+
+/* All thumbnails live in a single packed file: a header, an index and the
+   concatenated PNG data. That way the start page gets all of them with one
+   sequential read instead of dozens of small file opens. The format is
+   also read by the preview DLL (see src/previewer/PdfPreview.cpp). */
+
+#define THUMBNAIL_PACK_MAGIC 0x43545053 // 'SPTC'
+#define THUMBNAIL_PACK_VERSION 1
+
+struct ThumbnailPackHeader {
+    u32 magic;
+    u32 version;
+    i32 nEntries;
+    u32 reserved;
+};
+
+struct ThumbnailPackEntry {
+    u8 key[16]; // MD5 of the normalized document path
+    FILETIME createdAt;
+    u32 offset; // of the PNG data, relative to the end of the index
+    u32 size;
+};
+
 void CleanUpThumbnailCache(const FileHistory& fileHistory);
 
+// MD5 fingerprint of the (normalized) document path, shared by all
+// per-document caches (thumbnails, ebook layout)
+bool GetDocumentCacheKey(const WCHAR* filePath, u8 key[16]);
+
 bool LoadThumbnail(DisplayState& ds);
 bool HasThumbnail(DisplayState& ds);
 // takes ownership of bmp
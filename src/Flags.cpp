@@ -47,9 +47,17 @@ static const char* argNames =
     "appdata\0"
     "plugin\0"
     "stress-test\0"
+    "stress-procs\0"
+    "stress-timeout\0"
+    "stress-report\0"
+    "stress-leak-check\0"
     "n\0"
     "render\0"
     "bench\0"
+    "bench-runs\0"
+    "bench-sample\0"
+    "bench-cold\0"
+    "bench-output\0"
     "lang\0"
     "bgcolor\0"
     "bg-color\0"
@@ -75,6 +83,7 @@ static const char* argNames =
     "ra-micro\0"
     "testapp\0"
     "new-window\0"
+    "preload\0"
     "log\0"
     "s\0"
     "silent\0";
@@ -112,9 +121,17 @@ enum {
     AppData,
     Plugin,
     StressTest,
+    StressProcs,
+    StressTimeout,
+    StressReport,
+    StressLeakCheck,
     ArgN,
     Render,
     Bench,
+    BenchRuns,
+    BenchSample,
+    BenchCold,
+    BenchOutput,
     Lang,
     BgColor,
     BgColor2,
@@ -140,6 +157,7 @@ enum {
     RaMicro2,
     TestApp,
     NewWindow,
+    Preload,
     Log,
     Silent2,
     Silent
@@ -156,6 +174,8 @@ Flags::~Flags() {
     free(stressTestPath);
     free(stressTestFilter);
     free(stressTestRanges);
+    free(stressReportPath);
+    free(benchOutputPath);
     free(lang);
 }
 
@@ -428,6 +448,12 @@ void ParseCommandLine(const WCHAR* cmdLine, Flags& i) {
                 i.stressTestCycles = num;
                 n++;
             }
+        } else if (is_arg_with_param(StressProcs)) {
+            handle_int_param(i.stressProcessCount);
+        } else if (is_arg_with_param(StressTimeout)) {
+            handle_int_param(i.stressFileTimeoutSecs);
+        } else if (is_arg_with_param(StressReport)) {
+            handle_string_param(i.stressReportPath);
         } else if (is_arg_with_param(ArgN)) {
             handle_int_param(i.stressParallelCount);
         } else if (is_arg_with_param(Render)) {
@@ -446,6 +472,8 @@ void ParseCommandLine(const WCHAR* cmdLine, Flags& i) {
             i.withPreview = true;
         } else if (Rand == arg) {
             i.stressRandomizeFiles = true;
+        } else if (StressLeakCheck == arg) {
+            i.stressLeakCheck = true;
         } else if (Regress == arg) {
             i.regress = true;
         } else if (AutoUpdate == arg) {
@@ -464,6 +492,8 @@ void ParseCommandLine(const WCHAR* cmdLine, Flags& i) {
             i.testApp = true;
         } else if (NewWindow == arg) {
             i.inNewWindow = true;
+        } else if (Preload == arg) {
+            i.preload = true;
         } else if (Log == arg) {
             i.log = true;
         } else if (is_arg_with_param(Bench)) {
@@ -476,6 +506,14 @@ void ParseCommandLine(const WCHAR* cmdLine, Flags& i) {
             }
             i.pathsToBenchmark.Append(s);
             i.exitImmediately = true;
+        } else if (is_arg_with_param(BenchRuns)) {
+            handle_int_param(i.benchRuns);
+        } else if (is_arg_with_param(BenchSample)) {
+            handle_int_param(i.benchSamplePages);
+        } else if (BenchCold == arg) {
+            i.benchCold = true;
+        } else if (is_arg_with_param(BenchOutput)) {
+            handle_string_param(i.benchOutputPath);
         } else if (CrashOnOpen == arg) {
             // to make testing of crash reporting system in pre-release/release
             // builds possible
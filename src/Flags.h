@@ -44,6 +44,19 @@ struct Flags {
     // -new-window, if true and we're using tabs, opens
     // the document in new window
     bool inNewWindow = false;
+    // -preload keeps a hidden instance resident so that later opens
+    // (handed off via DDE/WM_COPYDATA) skip the cold start
+    bool preload = false;
+
+    // benchmarking related (see BenchFileOrDir)
+    // how often each measured phase is repeated per document
+    int benchRuns = 1;
+    // if > 0, benchmark only a fixed-seed sample of this many pages
+    int benchSamplePages = 0;
+    // reload the document before every run instead of reusing it
+    bool benchCold = false;
+    // write machine-readable results here (.csv gets CSV, everything else JSON)
+    WCHAR* benchOutputPath = nullptr;
 
     // stress-testing related
     WCHAR* stressTestPath = nullptr;
@@ -53,6 +66,15 @@ struct Flags {
     int stressTestCycles = 1;
     int stressParallelCount = 1;
     bool stressRandomizeFiles = false;
+    // if > 1, shard the stress run across this many child processes,
+    // one file per process (see RunStressOrchestrator)
+    int stressProcessCount = 1;
+    // per-file timeout for orchestrated stress runs, in seconds
+    int stressFileTimeoutSecs = 60;
+    // write the orchestrator's per-file report here
+    WCHAR* stressReportPath = nullptr;
+    // snapshot memory counters around each file and report leaks
+    bool stressLeakCheck = false;
 
     // related to testing
     bool testRenderPage = false;
@@ -2,11 +2,13 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
 #include "utils/GdiPlusUtil.h"
 #include "utils/HtmlParserLookup.h"
 #include "utils/CssParser.h"
 #include "utils/HtmlPullParser.h"
 #include "utils/Log.h"
+#include "utils/ThreadUtil.h"
 #include "mui/Mui.h"
 #include "utils/Timer.h"
 
@@ -162,6 +164,7 @@ void StyleRule::Merge(StyleRule& source) {
 HtmlFormatter::HtmlFormatter(HtmlFormatterArgs* args)
     : pageDx(args->pageDx), pageDy(args->pageDy), textAllocator(args->textAllocator) {
     currReparseIdx = args->reparseIdx;
+    layoutStats = args->layoutStats;
     htmlParser = new HtmlPullParser((const char*)args->htmlStr.data(), args->htmlStr.size());
     htmlParser->SetCurrPosOff(currReparseIdx);
     CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser));
@@ -172,6 +175,9 @@ HtmlFormatter::HtmlFormatter(HtmlFormatterArgs* args)
     defaultFontSize = args->fontSize;
 
     DrawStyle style;
+    // the bold/italic variants are created up front so that the first
+    // emphasized run doesn't stall mid-layout on GDI+ font creation
+    mui::PrecreateFontVariants(defaultFontName, defaultFontSize);
     style.font = mui::GetCachedFont(defaultFontName, defaultFontSize, FontStyleRegular);
     style.align = AlignAttr::Justify;
     style.dirRtl = false;
@@ -350,7 +356,8 @@ void HtmlFormatter::LayoutLeftStartingAt(float offX) {
 // TODO: if elements are of different sizes (e.g. texts using different fonts)
 // we should align them according to the baseline (which we would first need to
 // record for each element)
-static void SetYPos(Vec<DrawInstr>& instr, float y) {
+template <size_t N>
+static void SetYPos(Vec<DrawInstr, N>& instr, float y) {
     for (DrawInstr& i : instr) {
         if (IsVisibleDrawInstr(i)) {
             i.bbox.y = y;
@@ -493,6 +500,11 @@ void HtmlFormatter::ForceNewPage() {
 
 // returns true if created a new page
 bool HtmlFormatter::FlushCurrLine(bool isParagraphBreak) {
+    LARGE_INTEGER timeStart{};
+    if (layoutStats) {
+        timeStart = TimeGet();
+    }
+    double pageSplitMs = 0;
     if (IsCurrLineEmpty()) {
         currX = NewLineX();
         currLineTopPadding = 0;
@@ -503,6 +515,9 @@ bool HtmlFormatter::FlushCurrLine(bool isParagraphBreak) {
                 currLineInstr.RemoveAt(k - 1);
             }
         }
+        if (layoutStats) {
+            layoutStats->lineMs += TimeSinceInMs(timeStart);
+        }
         return false;
     }
     AlignAttr align = CurrStyle()->align;
@@ -515,6 +530,10 @@ bool HtmlFormatter::FlushCurrLine(bool isParagraphBreak) {
     float totalLineDy = CurrLineDy() + currLineTopPadding;
     bool createdPage = false;
     if (currY + totalLineDy > pageDy) {
+        LARGE_INTEGER timeSplit{};
+        if (layoutStats) {
+            timeSplit = TimeGet();
+        }
         // current line too big to fit in current page,
         // so need to start another page
         UpdateLinkBboxes(currPage);
@@ -526,6 +545,10 @@ bool HtmlFormatter::FlushCurrLine(bool isParagraphBreak) {
         CrashIf(currLineReparseIdx > INT_MAX);
         currPage->reparseIdx = (int)currLineReparseIdx;
         createdPage = true;
+        if (layoutStats) {
+            pageSplitMs = TimeSinceInMs(timeSplit);
+            layoutStats->pageMs += pageSplitMs;
+        }
     }
     SetYPos(currLineInstr, currY + currLineTopPadding);
     currY += totalLineDy;
@@ -546,6 +569,10 @@ bool HtmlFormatter::FlushCurrLine(bool isParagraphBreak) {
         currLinkIdx = currLineInstr.size();
     }
     nextPageStyle = styleStack.Last();
+    if (layoutStats) {
+        // the page-split time was accounted for separately above
+        layoutStats->lineMs += TimeSinceInMs(timeStart) - pageSplitMs;
+    }
     return createdPage;
 }
 
@@ -667,7 +694,8 @@ bool HtmlFormatter::EnsureDx(float dx) {
 
 // don't emit multiple spaces and don't emit spaces
 // at the beginning of the line
-static bool CanEmitElasticSpace(float currX, float NewLineX, float maxCurrX, Vec<DrawInstr>& currLineInstr) {
+template <size_t N>
+static bool CanEmitElasticSpace(float currX, float NewLineX, float maxCurrX, Vec<DrawInstr, N>& currLineInstr) {
     if (NewLineX == currX || 0 == currLineInstr.size()) {
         return false;
     }
@@ -730,15 +758,28 @@ void HtmlFormatter::EmitTextRun(const char* s, const char* end) {
         if (0 == strLen) {
             break;
         }
+        LARGE_INTEGER timeMeasure{};
+        if (layoutStats) {
+            timeMeasure = TimeGet();
+        }
         textMeasure->SetFont(CurrFont());
         RectF bbox = textMeasure->Measure(buf, strLen);
+        if (layoutStats) {
+            layoutStats->measureMs += TimeSinceInMs(timeMeasure);
+        }
         if (bbox.dx <= pageDx - currX) {
             AppendInstr(DrawInstr::Str(s, end - s, bbox, dirRtl));
             currX += bbox.dx;
             break;
         }
+        if (layoutStats) {
+            timeMeasure = TimeGet();
+        }
         // get len That Fits the remaining space in the line
         size_t lenThatFits = StringLenForWidth(textMeasure, buf, strLen, pageDx - currX);
+        if (layoutStats) {
+            layoutStats->measureMs += TimeSinceInMs(timeMeasure);
+        }
         // try to prevent a break in the middle of a word
         if (lenThatFits > 0) {
             if (!CanBreakWordOnChar(buf[lenThatFits])) {
@@ -766,8 +807,14 @@ void HtmlFormatter::EmitTextRun(const char* s, const char* end) {
             continue;
         }
 
+        if (layoutStats) {
+            timeMeasure = TimeGet();
+        }
         textMeasure->SetFont(CurrFont());
         bbox = ToGdipRectF(textMeasure->Measure(buf, lenThatFits));
+        if (layoutStats) {
+            layoutStats->measureMs += TimeSinceInMs(timeMeasure);
+        }
         CrashIf(bbox.dx > pageDx);
         // s is UTF-8 and buf is UTF-16, so one
         // WCHAR doesn't always equal one char
@@ -986,41 +1033,73 @@ StyleRule* HtmlFormatter::FindStyleRule(HtmlTag tag, const char* clazz, size_t c
 }
 
 StyleRule HtmlFormatter::ComputeStyleRule(HtmlToken* t) {
-    StyleRule rule;
-    // get style rules ordered by specificity
-    StyleRule* prevRule = FindStyleRule(Tag_Body, nullptr, 0);
-    if (prevRule) {
-        rule.Merge(*prevRule);
-    }
-    prevRule = FindStyleRule(Tag_Any, nullptr, 0);
-    if (prevRule) {
-        rule.Merge(*prevRule);
-    }
-    prevRule = FindStyleRule(t->tag, nullptr, 0);
-    if (prevRule) {
-        rule.Merge(*prevRule);
+    LARGE_INTEGER timeStart{};
+    if (layoutStats) {
+        timeStart = TimeGet();
     }
     // TODO: support multiple class names
     AttrInfo* attr = t->GetAttrByName("class");
-    if (attr) {
-        prevRule = FindStyleRule(Tag_Any, attr->val, attr->valLen);
+    u32 classHash = attr ? MurmurHash2(attr->val, attr->valLen) : 0;
+
+    StyleRule rule;
+    bool found = false;
+    // documents repeat the same few (tag, class) pairs for almost all of
+    // their elements, so the merged result is worth memoizing; matching
+    // runs for every element on every (re)layout
+    for (size_t i = 0; i < styleRuleCache.size(); i++) {
+        StyleRule& cached = styleRuleCache.at(i);
+        if (t->tag == cached.tag && classHash == cached.classHash) {
+            rule = cached;
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        // merge the matching style rules ordered by specificity
+        StyleRule* prevRule = FindStyleRule(Tag_Body, nullptr, 0);
         if (prevRule) {
             rule.Merge(*prevRule);
         }
-        prevRule = FindStyleRule(t->tag, attr->val, attr->valLen);
+        prevRule = FindStyleRule(Tag_Any, nullptr, 0);
         if (prevRule) {
             rule.Merge(*prevRule);
         }
+        prevRule = FindStyleRule(t->tag, nullptr, 0);
+        if (prevRule) {
+            rule.Merge(*prevRule);
+        }
+        if (attr) {
+            prevRule = FindStyleRule(Tag_Any, attr->val, attr->valLen);
+            if (prevRule) {
+                rule.Merge(*prevRule);
+            }
+            prevRule = FindStyleRule(t->tag, attr->val, attr->valLen);
+            if (prevRule) {
+                rule.Merge(*prevRule);
+            }
+        }
+        rule.tag = t->tag;
+        rule.classHash = classHash;
+        styleRuleCache.Append(rule);
     }
+
     attr = t->GetAttrByName("style");
     if (attr) {
         StyleRule newRule = StyleRule::Parse(attr->val, attr->valLen);
         rule.Merge(newRule);
     }
+    if (layoutStats) {
+        layoutStats->cssMs += TimeSinceInMs(timeStart);
+    }
     return rule;
 }
 
 void HtmlFormatter::ParseStyleSheet(const char* data, size_t len) {
+    LARGE_INTEGER timeStart{};
+    if (layoutStats) {
+        timeStart = TimeGet();
+    }
     CssPullParser parser(data, len);
     while (parser.NextRule()) {
         StyleRule rule = StyleRule::Parse(&parser);
@@ -1039,6 +1118,11 @@ void HtmlFormatter::ParseStyleSheet(const char* data, size_t len) {
             }
         }
     }
+    // the memoized merge results are stale now
+    styleRuleCache.Reset();
+    if (layoutStats) {
+        layoutStats->cssMs += TimeSinceInMs(timeStart);
+    }
 }
 
 void HtmlFormatter::HandleTagStyle(HtmlToken* t) {
@@ -1392,12 +1476,151 @@ Vec<HtmlPage*>* HtmlFormatter::FormatAllPages(bool skipEmptyPages) {
     return pages;
 }
 
+/* Cache of decoded images for DrawHtmlPage's asynchronous path.
+   Decoding a large illustration with GDI+ takes tens of milliseconds,
+   so doing it during WM_PAINT stalls every page turn in image-heavy
+   ebooks. When a paint passes a repaint hwnd, images that aren't decoded
+   yet are skipped for now (the layout already reserved their box from
+   header-only size probing, see EmitImage) and queued on the shared
+   thread pool; the decoded bitmap pops in with the repaint the worker
+   requests. Only pages the user is looking at are painted, so decodes
+   run at interactive priority. The entries are keyed by the image bytes
+   owned by the document, so the cache must be emptied before the
+   document goes away (see DropDecodedHtmlImages). */
+struct DecodedHtmlImage {
+    const u8* data{nullptr};
+    size_t len{0};
+    // null while the decode is pending and for images GDI+ can't decode
+    Gdiplus::Bitmap* bmp{nullptr};
+    bool done{false};
+    TaskHandle* task{nullptr};
+    DWORD lastUse{0};
+};
+
+// a handful of illustrations around the reading position; a cache miss
+// only costs a re-decode
+#define MAX_DECODED_HTML_IMAGES 32
+
+static CRITICAL_SECTION gDecodedImagesLock;
+static Vec<DecodedHtmlImage*>* gDecodedImages = nullptr;
+static DWORD gDecodedImagesUseGen = 0;
+static struct DecodedImagesLockInit {
+    DecodedImagesLockInit() {
+        InitializeCriticalSection(&gDecodedImagesLock);
+    }
+} gDecodedImagesLockInit;
+
+static void FreeDecodedHtmlImage(DecodedHtmlImage* e) {
+    if (e->task) {
+        // a pending decode still reads the document's image bytes,
+        // don't let it outlive the caller's reason for dropping us
+        if (!e->task->Cancel()) {
+            e->task->Wait();
+        }
+        DropTaskHandle(e->task);
+    }
+    delete e->bmp;
+    delete e;
+}
+
+/* Returns the decoded bitmap for the image bytes or, on a cache miss,
+   queues a decode and returns nullptr; the caller paints nothing and
+   <repaintHwnd> is invalidated once the bitmap is ready. maxDx/maxDy
+   work like in BitmapFromData */
+static Gdiplus::Bitmap* GetDecodedHtmlImage(std::span<u8> img, int maxDx, int maxDy, HWND repaintHwnd) {
+    const u8* data = img.data();
+    size_t len = img.size();
+
+    ScopedCritSec scope(&gDecodedImagesLock);
+    if (!gDecodedImages) {
+        gDecodedImages = new Vec<DecodedHtmlImage*>();
+    }
+    for (DecodedHtmlImage* e : *gDecodedImages) {
+        if (e->data == data && e->len == len) {
+            e->lastUse = ++gDecodedImagesUseGen;
+            return e->bmp;
+        }
+    }
+
+    // make room: evict the least recently used finished decode (pending
+    // entries are owned by their task and will be used right away anyway)
+    while (gDecodedImages->isize() >= MAX_DECODED_HTML_IMAGES) {
+        int lru = -1;
+        for (int i = 0; i < gDecodedImages->isize(); i++) {
+            DecodedHtmlImage* e = gDecodedImages->at(i);
+            if (!e->done) {
+                continue;
+            }
+            if (lru < 0 || e->lastUse < gDecodedImages->at(lru)->lastUse) {
+                lru = i;
+            }
+        }
+        if (lru < 0) {
+            break;
+        }
+        FreeDecodedHtmlImage(gDecodedImages->at(lru));
+        gDecodedImages->RemoveAtFast(lru);
+    }
+
+    auto e = new DecodedHtmlImage();
+    e->data = data;
+    e->len = len;
+    e->lastUse = ++gDecodedImagesUseGen;
+    gDecodedImages->Append(e);
+
+    auto fn = [data, len, maxDx, maxDy, repaintHwnd] {
+        Gdiplus::Bitmap* bmp = BitmapFromData({(u8*)data, len}, maxDx, maxDy);
+        bool stored = false;
+        {
+            ScopedCritSec scope2(&gDecodedImagesLock);
+            if (gDecodedImages) {
+                for (DecodedHtmlImage* cached : *gDecodedImages) {
+                    if (cached->data == data && cached->len == len && !cached->done) {
+                        cached->bmp = bmp;
+                        cached->done = true;
+                        stored = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!stored) {
+            // the cache was dropped while we were decoding
+            delete bmp;
+            return;
+        }
+        InvalidateRect(repaintHwnd, nullptr, FALSE);
+    };
+    e->task = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
+    return nullptr;
+}
+
+// empties the decoded image cache, waiting out pending decodes; call
+// before deleting a document whose pages have been drawn asynchronously
+void DropDecodedHtmlImages() {
+    Vec<DecodedHtmlImage*>* entries;
+    {
+        ScopedCritSec scope(&gDecodedImagesLock);
+        entries = gDecodedImages;
+        gDecodedImages = nullptr;
+    }
+    if (!entries) {
+        return;
+    }
+    // waiting happens outside the lock, the decode tasks take it to
+    // store their result
+    for (DecodedHtmlImage* e : *entries) {
+        FreeDecodedHtmlImage(e);
+    }
+    delete entries;
+}
+
 // TODO: draw link in the appropriate format (blue text, underlined, should show hand cursor when
 // mouse is over a link. There's a slight complication here: we only get explicit information about
 // strings, not about the whitespace and we should underline the whitespace as well. Also the text
 // should be underlined at a baseline
 void DrawHtmlPage(Graphics* g, mui::ITextRender* textDraw, Vec<DrawInstr>* drawInstructions, float offX, float offY,
-                  bool showBbox, Color textColor, bool* abortCookie) {
+                  bool showBbox, Color textColor, bool* abortCookie, HWND asyncImagesHwnd) {
     Pen debugPen(Color(255, 0, 0), 1);
     // Pen linePen(Color(0, 0, 0), 2.f);
     Pen linePen(Color(0x5F, 0x4B, 0x32), 2.f);
@@ -1450,15 +1673,24 @@ void DrawHtmlPage(Graphics* g, mui::ITextRender* textDraw, Vec<DrawInstr>* drawI
             status = g->DrawLine(&linePen, p1, p2);
             CrashIf(status != Ok);
         } else if (DrawInstrType::Image == i.type) {
-            // TODO: cache the bitmap somewhere (?)
-            Bitmap* bmp = BitmapFromData(i.img.AsSpan());
+            // the image is drawn at bbox size, a JPEG can be decoded at reduced resolution
+            Bitmap* bmp;
+            if (asyncImagesHwnd) {
+                // a missing bitmap pops in with the repaint its decode requests
+                bmp = GetDecodedHtmlImage(i.img.AsSpan(), (int)ceilf(bbox.dx), (int)ceilf(bbox.dy), asyncImagesHwnd);
+            } else {
+                bmp = BitmapFromData(i.img.AsSpan(), (int)ceilf(bbox.dx), (int)ceilf(bbox.dy));
+            }
             if (bmp) {
                 status = g->DrawImage(bmp, ToGdipRectF(bbox), 0, 0, (float)bmp->GetWidth(), (float)bmp->GetHeight(),
                                       UnitPixel);
                 // GDI+ sometimes seems to succeed in loading an image because it lazily decodes it
                 CrashIf(status != Ok && status != Win32Error);
             }
-            delete bmp;
+            if (!asyncImagesHwnd) {
+                // cached bitmaps stay with the cache
+                delete bmp;
+            }
         } else if (DrawInstrType::LinkStart == i.type) {
             // TODO: set text color to blue
             float y = floorf(bbox.y + bbox.dy + 0.5f);
@@ -1486,7 +1718,9 @@ void DrawHtmlPage(Graphics* g, mui::ITextRender* textDraw, Vec<DrawInstr>* drawI
     }
 }
 
-static mui::TextRenderMethod gTextRenderMethod = mui::TextRenderMethodGdi;
+// CreateTextRender() silently falls back to Gdi when DirectWrite can't be loaded
+static mui::TextRenderMethod gTextRenderMethod = mui::TextRenderMethodDirectWrite;
+// static mui::TextRenderMethod gTextRenderMethod = mui::TextRenderMethodGdi;
 // static mui::TextRenderMethod gTextRenderMethod = mui::TextRenderMethodGdiplus;
 
 mui::TextRenderMethod GetTextRenderMethod() {
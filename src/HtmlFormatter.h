@@ -142,6 +142,17 @@ struct HtmlPage {
     int reparseIdx;
 };
 
+// accumulated wall time of the individual layout phases; set
+// HtmlFormatterArgs::layoutStats to collect them during formatting.
+// tokenizing and tag handling is whatever of the total layout time
+// is not attributed to one of these (see BenchEbookLayout)
+struct HtmlLayoutStats {
+    double cssMs{0};     // style sheet parsing and per-element rule resolution
+    double measureMs{0}; // text measurement
+    double lineMs{0};    // laying out and justifying finished lines
+    double pageMs{0};    // splitting finished lines into pages
+};
+
 // just to pack args to HtmlFormatter
 struct HtmlFormatterArgs {
     HtmlFormatterArgs() = default;
@@ -172,6 +183,9 @@ struct HtmlFormatterArgs {
     // we start parsing from htmlStr + reparseIdx
     int reparseIdx{0};
 
+    // if set, per-phase layout timings are accumulated here
+    HtmlLayoutStats* layoutStats{nullptr};
+
     AutoFreeWstr fontName;
 };
 
@@ -279,9 +293,14 @@ class HtmlFormatter {
     bool keepTagNesting{false};
     // set from CSS and to be checked by the individual tag handlers
     Vec<StyleRule> styleRules;
-
-    // isntructions for the current line
-    Vec<DrawInstr> currLineInstr;
+    // merged style rules per (tag, class hash) pair already seen, so
+    // repeated elements skip the selector matching in ComputeStyleRule;
+    // must be reset whenever styleRules changes
+    Vec<StyleRule> styleRuleCache;
+
+    // isntructions for the current line; reset after every line, and a
+    // justified line holds a few dozen instructions, so keep it inline
+    Vec<DrawInstr, 64> currLineInstr;
     // reparse point of the first instructions in a current line
     ptrdiff_t currLineReparseIdx{0};
     HtmlPage* currPage{nullptr};
@@ -302,6 +321,9 @@ class HtmlFormatter {
     // for detection of cover image duplicates in mobi formatting
     int pageCount{0};
 
+    // per-phase timings, copied from HtmlFormatterArgs (may be nullptr)
+    HtmlLayoutStats* layoutStats{nullptr};
+
     WCHAR buf[512]{};
 
   public:
@@ -314,8 +336,14 @@ class HtmlFormatter {
     Vec<HtmlPage*>* FormatAllPages(bool skipEmptyPages = true);
 };
 
+// with <asyncImagesHwnd>, images are decoded asynchronously on the shared
+// thread pool and pop in when the hwnd is repainted; without it images
+// decode synchronously (renderings must be complete in one pass)
 void DrawHtmlPage(Graphics* g, mui::ITextRender* textDraw, Vec<DrawInstr>* drawInstructions, float offX, float offY,
-                  bool showBbox, Color textColor, bool* abortCookie = nullptr);
+                  bool showBbox, Color textColor, bool* abortCookie = nullptr, HWND asyncImagesHwnd = nullptr);
+// empties the async decode cache; must be called before the document
+// owning the drawn images goes away
+void DropDecodedHtmlImages();
 
 mui::TextRenderMethod GetTextRenderMethod();
 void SetTextRenderMethod(mui::TextRenderMethod method);
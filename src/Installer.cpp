@@ -13,6 +13,7 @@
 #include "utils/LogDbg.h"
 #include "utils/Log.h"
 #include "utils/WinUtil.h"
+#include "utils/ThreadUtil.h"
 #include "utils/Timer.h"
 #include "utils/CmdLineParser.h"
 #include "utils/GdiPlusUtil.h"
@@ -107,38 +108,64 @@ static void CreateButtonExit(HWND hwndParent) {
     gButtonExit->onClicked = OnButtonExit;
 }
 
-bool ExtractFiles(lzma::SimpleArchive* archive, const WCHAR* destDir) {
-    lzma::FileInfo* fi;
-    u8* uncompressed;
+// decoded payload of one archive member, produced on a pool worker
+struct ExtractedFile {
+    u8* uncompressed = nullptr;
+    TaskHandle* task = nullptr;
+};
 
+bool ExtractFiles(lzma::SimpleArchive* archive, const WCHAR* destDir) {
     int nFiles = archive->filesCount;
 
+    // each member is compressed independently, so decode them all in
+    // parallel on the thread pool and write the results to disk in
+    // archive order as the decodes finish. GetFileDataByIdx is safe
+    // off-thread: it only reads the archive and ParseSimpleArchive has
+    // already initialized the lazily-built crc32 table
+    ExtractedFile* decoded = AllocArray<ExtractedFile>(nFiles);
+    for (int i = 0; i < nFiles; i++) {
+        ExtractedFile* ef = &decoded[i];
+        auto fn = [archive, i, ef] { ef->uncompressed = lzma::GetFileDataByIdx(archive, i, nullptr); };
+        ef->task = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
+    }
+
+    bool ok = true;
     for (int i = 0; i < nFiles; i++) {
-        fi = &archive->files[i];
-        uncompressed = lzma::GetFileDataByIdx(archive, i, nullptr);
+        decoded[i].task->Wait();
+        DropTaskHandle(decoded[i].task);
+        u8* uncompressed = decoded[i].uncompressed;
+        if (!ok) {
+            // already failed; just drain the remaining decodes
+            free(uncompressed);
+            continue;
+        }
 
         if (!uncompressed) {
             NotifyFailed(
                 _TR("The installer has been corrupted. Please download it again.\nSorry for the inconvenience!"));
-            return false;
+            ok = false;
+            continue;
         }
+        lzma::FileInfo* fi = &archive->files[i];
         AutoFreeWstr fileName = strconv::Utf8ToWstr(fi->name);
         AutoFreeWstr filePath = path::Join(destDir, fileName);
 
         std::span<u8> d = {uncompressed, fi->uncompressedSize};
-        bool ok = file::WriteFile(filePath, d);
+        bool wroteOk = file::WriteFile(filePath, d);
         free(uncompressed);
 
-        if (!ok) {
+        if (!wroteOk) {
             WCHAR* msg = str::Format(_TR("Couldn't write %s to disk"), filePath.data);
             NotifyFailed(msg);
             free(msg);
-            return false;
+            ok = false;
+            continue;
         }
         ProgressStep();
     }
+    free(decoded);
 
-    return true;
+    return ok;
 }
 
 static bool CreateInstallationDirectory() {
@@ -0,0 +1,92 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "GlobalPrefs.h"
+#include "MemoryPolicy.h"
+
+#pragma warning(disable : 28159) // silence /analyze: Consider using 'GetTickCount64' instead of 'GetTickCount'
+
+// once the OS signals pressure, stay in the low-memory profile for this
+// long: flip-flopping the budgets would evict and re-render in a loop
+#define LOW_MEMORY_LINGER_MS (60 * 1000)
+
+static HANDLE gLowMemNotification = nullptr;
+static DWORD gLastLowMemTick = 0;
+
+/* True while the system is low on available memory. Uses the kernel's
+   low-memory resource notification, which fires well before allocations
+   start failing; the result is latched for a while, as the signal clears
+   the moment our own evictions free memory up. */
+static bool IsSystemLowOnMemory() {
+    if (!gLowMemNotification) {
+        HANDLE h = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+        if (!h) {
+            return false;
+        }
+        if (InterlockedCompareExchangePointer(&gLowMemNotification, h, nullptr) != nullptr) {
+            // another thread won the race to create the notification
+            CloseHandle(h);
+        }
+    }
+    BOOL state = FALSE;
+    if (QueryMemoryResourceNotification(gLowMemNotification, &state) && state) {
+        gLastLowMemTick = GetTickCount();
+        return true;
+    }
+    return gLastLowMemTick != 0 && GetTickCount() - gLastLowMemTick < LOW_MEMORY_LINGER_MS;
+}
+
+// the budget for cached bitmaps outside the low-memory profile; the
+// pref value is in MB, 0 or negative means auto-size based on RAM
+static i64 NormalRenderCacheBudget() {
+    i64 sizeMB = gGlobalPrefs ? (i64)gGlobalPrefs->renderCacheSize : 0;
+    if (sizeMB <= 0) {
+        MEMORYSTATUSEX ms{};
+        ms.dwLength = sizeof(ms);
+        GlobalMemoryStatusEx(&ms);
+        // an eighth of physical RAM, but at least 64 MB and no more
+        // than 1 GB (GDI bitmaps are a limited resource)
+        i64 autoMB = (i64)(ms.ullTotalPhys / (8 * 1024 * 1024));
+        sizeMB = limitValue(autoMB, (i64)64, (i64)1024);
+    }
+    return sizeMB * 1024 * 1024;
+}
+
+MemoryPolicy GetMemoryPolicy() {
+    MemoryPolicy policy;
+
+    const char* mode = gGlobalPrefs ? gGlobalPrefs->lowMemoryMode : nullptr;
+    if (str::EqI(mode, "on")) {
+        policy.lowMemory = true;
+    } else if (!str::EqI(mode, "off")) {
+        // "auto" (and anything unrecognized) follows the OS
+        policy.lowMemory = IsSystemLowOnMemory();
+    }
+
+    i64 budget = NormalRenderCacheBudget();
+    if (!policy.lowMemory) {
+        policy.renderCacheBudget = budget;
+        // at the ratios rendered pages deflate to, giving the compressed
+        // tier as many bytes holds an order of magnitude more pages
+        policy.compressedCacheBudget = budget;
+        // at ~50 KB per dense page this keeps the text of several
+        // hundred pages around
+        policy.textCacheBudget = 32 * 1024 * 1024;
+        return policy;
+    }
+
+    // keep little more than the visible pages around as bitmaps and
+    // serve everything else from the compressed tier, which stores the
+    // same pages roughly ten times cheaper
+    policy.renderCacheBudget = limitValue(budget / 8, (i64)16 * 1024 * 1024, budget);
+    policy.compressedCacheBudget = budget / 2;
+    policy.allowPrefetch = false;
+    policy.allowDocumentWarming = false;
+    policy.allowEagerTextIndexing = false;
+    policy.textCacheBudget = 8 * 1024 * 1024;
+    return policy;
+}
@@ -0,0 +1,37 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+/* The memory policy bundles the knobs that decide how much memory the
+   caching and speculation subsystems may spend, so that they're tuned in
+   one place instead of through constants scattered over the code. Its
+   low-memory profile exists for machines where SumatraPDF shares scarce
+   RAM with many other processes (e.g. terminal-services hosts): it
+   shrinks the render cache to little more than the visible pages, leans
+   on the compressed tier instead, and turns off the speculative work
+   (prefetch, whole-document warming, eager text extraction) that trades
+   memory for latency. The profile is controlled by the LowMemoryMode
+   setting: "on"/"off" force it, "auto" (the default) follows the OS'
+   memory resource notification. */
+
+struct MemoryPolicy {
+    // the low-memory profile is in effect
+    bool lowMemory = false;
+    // byte budget for the uncompressed tier of the render cache
+    i64 renderCacheBudget = 0;
+    // byte budget for the compressed tier of the render cache
+    i64 compressedCacheBudget = 0;
+    // whether pages beyond the visible ones may be pre-rendered
+    bool allowPrefetch = true;
+    // whether idle render workers may warm the rest of the document
+    bool allowDocumentWarming = true;
+    // whether a document's text is extracted eagerly in the background
+    // (if not, pages are extracted on first use by search/selection)
+    bool allowEagerTextIndexing = true;
+    // byte budget for a document's extracted text and glyph coordinates;
+    // DocumentTextCache drops its least recently used pages beyond it
+    i64 textCacheBudget = 0;
+};
+
+// computes the policy from the current prefs and memory pressure; cheap
+// enough to call at every decision point instead of caching the result
+MemoryPolicy GetMemoryPolicy();
@@ -39,6 +39,7 @@
 #include "Favorites.h"
 #include "FileThumbnails.h"
 #include "Menu.h"
+#include "Print.h"
 #include "Selection.h"
 #include "SumatraAbout.h"
 #include "SumatraDialogs.h"
@@ -85,6 +86,10 @@ void MenuUpdateDisplayMode(WindowInfo* win) {
         bool mangaMode = win->AsFixed()->GetDisplayR2L();
         win::menu::SetChecked(win->menu, CmdViewMangaMode, mangaMode);
     }
+
+    if (win->currentTab) {
+        win::menu::SetChecked(win->menu, CmdViewReflowMode, win->currentTab->reflowView);
+    }
 }
 
 // clang-format off
@@ -93,9 +98,11 @@ static MenuDef menuDefFile[] = {
     { _TRN("New &window\tCtrl+N"),          CmdNewWindow,              MF_REQ_DISK_ACCESS },
     { _TRN("&Open...\tCtrl+O"),             CmdOpen,                   MF_REQ_DISK_ACCESS },
     { "Open Folder",                        CmdOpenFolder,             MF_REQ_DISK_ACCESS | MF_RAMICRO_ONLY },
+    { "Quick Open...\tCtrl+K",              CmdQuickOpen,              MF_REQ_DISK_ACCESS },
     { _TRN("&Close\tCtrl+W"),               CmdClose,                  MF_REQ_DISK_ACCESS },
     { _TRN("Show in &folder"),              CmdShowInFolder,           MF_REQ_DISK_ACCESS },
     { _TRN("&Save As...\tCtrl+S"),          CmdSaveAs,                 MF_REQ_DISK_ACCESS },
+    { _TRN("Save Optimi&zed As..."),        CmdSaveAsOptimized,        MF_REQ_DISK_ACCESS | MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
     { _TRN("Save Annotations"),             CmdSaveAnnotations,        MF_REQ_DISK_ACCESS },
  //[ ACCESSKEY_ALTERNATIVE // only one of these two will be shown
 #ifdef ENABLE_SAVE_SHORTCUT
@@ -134,6 +141,7 @@ static MenuDef menuDefView[] = {
     { _TRN("Show &Pages Continuously"),     CmdViewContinuous,        MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
     // TODO: "&Inverse Reading Direction" (since some Mangas might be read left-to-right)?
     { _TRN("Man&ga Mode"),                  CmdViewMangaMode,         MF_CBX_ONLY },
+    { _TRN("R&eflow Text"),                 CmdViewReflowMode,        MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
     { SEP_ITEM,                             0,                        MF_NOT_FOR_CHM },
     { _TRN("Rotate &Left\tCtrl+Shift+-"),   CmdViewRotateLeft,        MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
     { _TRN("Rotate &Right\tCtrl+Shift++"),  CmdViewRotateRight,       MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
@@ -142,6 +150,7 @@ static MenuDef menuDefView[] = {
     { _TRN("F&ullscreen\tF11"),             CmdViewFullScreen,        MF_REQ_FULLSCREEN },
     { SEP_ITEM,                             0,                        MF_REQ_FULLSCREEN },
     { _TRN("Show Book&marks\tF12"),         CmdViewBookmarks,         0 },
+    { _TRN("Show Thum&bnails"),             CmdViewShowHideThumbnails,MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
     { _TRN("Show &Toolbar\tF8"),            CmdViewShowHideToolbar,   MF_NOT_FOR_EBOOK_UI },
     { _TRN("Show Scr&ollbars"),             CmdViewShowHideScrollbars,MF_NOT_FOR_CHM | MF_NOT_FOR_EBOOK_UI },
     { SEP_ITEM,                             0,                        MF_REQ_ALLOW_COPY | MF_NOT_FOR_EBOOK_UI },
@@ -163,6 +172,7 @@ static MenuDef menuDefGoTo[] = {
     { _TRN("F&orward\tAlt+Right Arrow"),    CmdGoToNavForward,       0 },
     { SEP_ITEM,                             0,                       MF_NOT_FOR_EBOOK_UI },
     { _TRN("Fin&d...\tCtrl+F"),             CmdFindFirst,            MF_NOT_FOR_EBOOK_UI },
+    { _TRN("Search All Tabs...\tCtrl+Shift+F"), CmdSearchAllTabs,    MF_REQ_DISK_ACCESS },
     { 0, 0, 0 },
 };
 //] ACCESSKEY_GROUP GoTo Menu
@@ -237,6 +247,7 @@ static MenuDef menuDefDebug[] = {
     { "Download symbols",                   CmdDebugDownloadSymbols,  MF_NO_TRANSLATE },
     { "Test app",                           CmdDebugTestApp,          MF_NO_TRANSLATE },
     { "Show notification",                  CmdDebugShowNotif,        MF_NO_TRANSLATE },
+    { "Show memory usage",                  CmdDebugShowMemoryUsage,  MF_NO_TRANSLATE },
     { 0, 0, 0 },
 };
 //] ACCESSKEY_GROUP Debug Menu
@@ -546,7 +557,11 @@ static bool IsFileCloseMenuEnabled() {
     return false;
 }
 
-static void MenuUpdateStateForWindow(WindowInfo* win) {
+// updates the enabled/checked state of the items in menu; pass win->menu
+// to update the whole menu bar or a single (sub)menu that is about to be
+// shown to update just the items it contains (enabling an item that isn't
+// in the menu is a no-op)
+static void MenuUpdateStateForWindow(WindowInfo* win, HMENU menu) {
     // those menu items will be disabled if no document is opened, enabled otherwise
     static int menusToDisableIfNoDocument[] = {
         CmdViewRotateLeft, CmdViewRotateRight,      CmdGoToNextPage,     CmdGoToPrevPage,  CmdGoToFirstPage,
@@ -568,67 +583,83 @@ static void MenuUpdateStateForWindow(WindowInfo* win) {
 
     for (int i = 0; i < dimof(menusToDisableIfNoDocument); i++) {
         int id = menusToDisableIfNoDocument[i];
-        win::menu::SetEnabled(win->menu, id, win->IsDocLoaded());
+        win::menu::SetEnabled(menu, id, win->IsDocLoaded());
     }
 
     // TODO: happens with UseTabs = false with .pdf files
     SubmitCrashIf(IsFileCloseMenuEnabled() == win->IsAboutWindow());
-    win::menu::SetEnabled(win->menu, CmdClose, IsFileCloseMenuEnabled());
+    win::menu::SetEnabled(menu, CmdClose, IsFileCloseMenuEnabled());
 
-    MenuUpdatePrintItem(win, win->menu);
+    MenuUpdatePrintItem(win, menu);
 
     bool enabled = win->IsDocLoaded() && tab && tab->ctrl->HacToc();
-    win::menu::SetEnabled(win->menu, CmdViewBookmarks, enabled);
+    win::menu::SetEnabled(menu, CmdViewBookmarks, enabled);
 
     bool documentSpecific = win->IsDocLoaded();
     bool checked = documentSpecific ? win->tocVisible : gGlobalPrefs->showToc;
-    win::menu::SetChecked(win->menu, CmdViewBookmarks, checked);
+    win::menu::SetChecked(menu, CmdViewBookmarks, checked);
 
-    win::menu::SetChecked(win->menu, CmdFavoriteToggle, gGlobalPrefs->showFavorites);
-    win::menu::SetChecked(win->menu, CmdViewShowHideToolbar, gGlobalPrefs->showToolbar);
-    win::menu::SetChecked(win->menu, CmdViewShowHideScrollbars, !gGlobalPrefs->fixedPageUI.hideScrollbars);
+    win::menu::SetChecked(menu, CmdViewShowHideThumbnails, win->thumbsVisible);
+    win::menu::SetChecked(menu, CmdFavoriteToggle, gGlobalPrefs->showFavorites);
+    win::menu::SetChecked(menu, CmdViewShowHideToolbar, gGlobalPrefs->showToolbar);
+    win::menu::SetChecked(menu, CmdViewShowHideScrollbars, !gGlobalPrefs->fixedPageUI.hideScrollbars);
     MenuUpdateDisplayMode(win);
     MenuUpdateZoom(win);
 
     if (win->IsDocLoaded() && tab) {
-        win::menu::SetEnabled(win->menu, CmdGoToNavBack, tab->ctrl->CanNavigate(-1));
-        win::menu::SetEnabled(win->menu, CmdGoToNavForward, tab->ctrl->CanNavigate(1));
-    }
-
-    // TODO: is this check too expensive?
-    bool fileExists = tab && file::Exists(tab->filePath);
-
-    if (tab && tab->ctrl && !fileExists && dir::Exists(tab->filePath)) {
-        for (int i = 0; i < dimof(menusToDisableIfDirectory); i++) {
-            int id = menusToDisableIfDirectory[i];
-            win::menu::SetEnabled(win->menu, id, false);
-        }
-    } else if (fileExists && CouldBePDFDoc(tab)) {
-        for (int i = 0; i < dimof(menusToEnableIfBrokenPDF); i++) {
-            int id = menusToEnableIfBrokenPDF[i];
-            win::menu::SetEnabled(win->menu, id, true);
-        }
+        win::menu::SetEnabled(menu, CmdGoToNavBack, tab->ctrl->CanNavigate(-1));
+        win::menu::SetEnabled(menu, CmdGoToNavForward, tab->ctrl->CanNavigate(1));
     }
 
     DisplayModel* dm = tab ? tab->AsFixed() : nullptr;
     EngineBase* engine = dm ? dm->GetEngine() : nullptr;
     if (engine) {
-        win::menu::SetEnabled(win->menu, CmdFindFirst, !engine->IsImageCollection());
+        win::menu::SetEnabled(menu, CmdFindFirst, !engine->IsImageCollection());
     }
 
-    if (win->IsDocLoaded() && !fileExists) {
-        win::menu::SetEnabled(win->menu, CmdRenameFile, false);
+    // the checks below require disk access and only affect items that
+    // live in the File menu, so skip them when another menu is opening
+    bool updatesFileMenu = (menu == win->menu) || ((int)GetMenuItemID(menu, 0) == menuDefFile[0].id);
+    if (updatesFileMenu) {
+        bool fileExists = tab && file::Exists(tab->filePath);
+
+        if (tab && tab->ctrl && !fileExists && dir::Exists(tab->filePath)) {
+            for (int i = 0; i < dimof(menusToDisableIfDirectory); i++) {
+                int id = menusToDisableIfDirectory[i];
+                win::menu::SetEnabled(menu, id, false);
+            }
+        } else if (fileExists && CouldBePDFDoc(tab)) {
+            for (int i = 0; i < dimof(menusToEnableIfBrokenPDF); i++) {
+                int id = menusToEnableIfBrokenPDF[i];
+                win::menu::SetEnabled(menu, id, true);
+            }
+        }
+
+        if (win->IsDocLoaded() && !fileExists) {
+            win::menu::SetEnabled(menu, CmdRenameFile, false);
+        }
+
+        bool enableSaveAnnotations = false;
+        bool canDoAnnotations = gIsDebugBuild || gIsPreReleaseBuild || gIsDailyBuild;
+        if (canDoAnnotations) {
+            enableSaveAnnotations = EngineHasUnsavedAnnotations(tab ? tab->GetEngine() : nullptr);
+        }
+        win::menu::SetEnabled(menu, CmdSaveAnnotations, enableSaveAnnotations);
+
+        // an optimized rewrite is only implemented for pdf documents
+        bool enableSaveOptimized = tab && tab->GetEngineType() == kindEnginePdf;
+        win::menu::SetEnabled(menu, CmdSaveAsOptimized, enableSaveOptimized);
     }
 
 #if defined(ENABLE_THEME)
-    CheckMenuRadioItem(win->menu, IDM_CHANGE_THEME_FIRST, IDM_CHANGE_THEME_LAST,
+    CheckMenuRadioItem(menu, IDM_CHANGE_THEME_FIRST, IDM_CHANGE_THEME_LAST,
                        IDM_CHANGE_THEME_FIRST + GetCurrentThemeIndex(), MF_BYCOMMAND);
 #endif
 
-    win::menu::SetChecked(win->menu, CmdDebugShowLinks, gDebugShowLinks);
-    win::menu::SetChecked(win->menu, CmdDebugEbookUI, gGlobalPrefs->ebookUI.useFixedPageUI);
-    win::menu::SetChecked(win->menu, CmdDebugMui, mui::IsDebugPaint());
-    win::menu::SetEnabled(win->menu, CmdDebugAnnotations,
+    win::menu::SetChecked(menu, CmdDebugShowLinks, gDebugShowLinks);
+    win::menu::SetChecked(menu, CmdDebugEbookUI, gGlobalPrefs->ebookUI.useFixedPageUI);
+    win::menu::SetChecked(menu, CmdDebugMui, mui::IsDebugPaint());
+    win::menu::SetEnabled(menu, CmdDebugAnnotations,
                           tab && tab->selectionOnPage && win->showSelection && EngineSupportsAnnotations(engine));
 }
 
@@ -886,7 +917,10 @@ void OnWindowContextMenu(WindowInfo* win, int x, int y) {
         case CmdCreateAnnotSquare:
         case CmdCreateAnnotLine:
         case CmdCreateAnnotCircle: {
-            Annotation* annot = EnginePdfCreateAnnotation(engine, annotType, pageNo, ptOnPage);
+            if (!EnsureExclusiveEngine(tab)) {
+                break;
+            }
+            Annotation* annot = EnginePdfCreateAnnotation(dm->GetEngine(), annotType, pageNo, ptOnPage);
             WindowInfoRerender(win);
             StartEditAnnotations(win->currentTab, annot);
         } break;
@@ -921,8 +955,6 @@ void OnWindowContextMenu(WindowInfo* win, int x, int y) {
         { _TR_TODON("Polygon"), CmdCreateAnnotPolygon, 0 },
         { _TR_TODON("Poly Line"), CmdCreateAnnotPolyLine, 0 },
     */
-
-    delete pageEl;
 }
 
 /* Zoom document in window 'hwnd' to zoom level 'zoom'.
@@ -983,14 +1015,8 @@ static void RebuildFileMenu(TabInfo* tab, HMENU menu) {
         }
     }
 
-    DisplayModel* dm = tab ? tab->AsFixed() : nullptr;
-    EngineBase* engine = tab ? tab->GetEngine() : nullptr;
-    bool enableSaveAnnotations = false;
-    bool canDoAnnotations = gIsDebugBuild || gIsPreReleaseBuild || gIsDailyBuild;
-    if (canDoAnnotations) {
-        enableSaveAnnotations = EngineHasUnsavedAnnotations(engine);
-    }
-    win::menu::SetEnabled(menu, CmdSaveAnnotations, enableSaveAnnotations);
+    // CmdSaveAnnotations is enabled/disabled in MenuUpdateStateForWindow()
+    // as its state can change while the rebuilt menu is cached
 }
 
 // so that we can do free everything at exit
@@ -1278,8 +1304,15 @@ HMENU BuildMenu(WindowInfo* win) {
         filter |= MF_CBX_ONLY;
     }
 
-    HMENU m = CreateMenu();
-    RebuildFileMenu(tab, m);
+    // the recently opened files and the external viewers are appended by
+    // RebuildFileMenu() when the File menu is first opened; enumerating
+    // them here would delay showing the window
+    HMENU m = BuildMenuFromMenuDef(menuDefFile, CreateMenu(), filter);
+    if (gIsRaMicroBuild) {
+        win::menu::Remove(m, CmdOpenFolder);
+    }
+    win->menuFileHistoryVer = 0;
+    win->menuFilePath.Set(nullptr);
     AppendMenu(mainMenu, MF_POPUP | MF_STRING, (UINT_PTR)m, _TR("&File"));
     m = BuildMenuFromMenuDef(menuDefView, CreateMenu(), filter);
     AppendMenu(mainMenu, MF_POPUP | MF_STRING, (UINT_PTR)m, _TR("&View"));
@@ -1294,8 +1327,8 @@ HMENU BuildMenu(WindowInfo* win) {
     if (HasPermission(Perm_SavePreferences) && !win->AsEbook()) {
         // I think it makes sense to disable favorites in restricted mode
         // because they wouldn't be persisted, anyway
+        // (filled by RebuildFavMenu() when the menu is opened)
         m = BuildMenuFromMenuDef(menuDefFavorites, CreateMenu());
-        RebuildFavMenu(win, m);
         AppendMenu(mainMenu, MF_POPUP | MF_STRING, (UINT_PTR)m, _TR("F&avorites"));
     }
 
@@ -1355,14 +1388,33 @@ void UpdateAppMenu(WindowInfo* win, HMENU m) {
     }
     int id = (int)GetMenuItemID(m, 0);
     if (id == menuDefFile[0].id) {
-        RebuildFileMenu(win->currentTab, m);
+        // prime the spooler's printer enumeration while the user is still
+        // in the menu, so that the print dialog comes up without stalling
+        // on offline network print queues
+        PrewarmPrinterEnumeration();
+        // the menu content only depends on the file history and on the
+        // shown document; don't re-enumerate them when neither changed
+        // since the last time the menu was opened
+        const WCHAR* tabPath = win->currentTab ? win->currentTab->filePath.Get() : nullptr;
+        if (win->menuFileHistoryVer != gFileHistory.version || !str::Eq(win->menuFilePath, tabPath)) {
+            RebuildFileMenu(win->currentTab, m);
+            win->menuFileHistoryVer = gFileHistory.version;
+            win->menuFilePath.SetCopy(tabPath);
+        }
     } else if (id == menuDefFavorites[0].id) {
+        // always rebuilt: the menu ids assigned to favorites are shared
+        // between windows, so a cached copy could go stale when another
+        // window opens its Favorites menu (the rebuild is cheap since
+        // Favorites caches the sorted file list)
         win::menu::Empty(m);
         BuildMenuFromMenuDef(menuDefFavorites, m);
         RebuildFavMenu(win, m);
     }
-    MenuUpdateStateForWindow(win);
-    MarkMenuOwnerDraw(win->menu);
+    // only refresh the state of the menu that is opening; updating the
+    // whole menu bar made even the canvas context menu pay for every
+    // item in every submenu (plus a file system access)
+    MenuUpdateStateForWindow(win, m);
+    MarkMenuOwnerDraw(m);
 }
 
 // show/hide top-level menu bar. This doesn't persist across launches
@@ -859,9 +859,18 @@ bool MobiDoc::LoadDocRecordIntoBuffer(size_t recNo, str::Str& strOut) {
 bool MobiDoc::LoadDocument(PdbReader* pdbReader) {
     logToDebugger = true;
     this->pdbReader = pdbReader;
-    if (!ParseHeader()) {
-        return false;
+    return ParseHeader();
+}
+
+// decompress the text records into a single html string. Done lazily on
+// the first access to the text: documents are also opened just for their
+// metadata or cover image (e.g. to check whether a PDB file really is
+// PalmDOC) and those callers shouldn't pay for decompressing the whole book
+bool MobiDoc::LoadDocRecords() {
+    if (docLoaded) {
+        return doc != nullptr;
     }
+    docLoaded = true;
 
     CrashIf(doc != nullptr);
     doc = new str::Str(docUncompressedSize);
@@ -877,6 +886,8 @@ bool MobiDoc::LoadDocument(PdbReader* pdbReader) {
     // is detected.
     // Figure out if this is a bug in my decoding.
     if (nFailed > docRecCount / 2) {
+        delete doc;
+        doc = nullptr;
         return false;
     }
 
@@ -897,11 +908,11 @@ bool MobiDoc::LoadDocument(PdbReader* pdbReader) {
     return true;
 }
 
-std::span<u8> MobiDoc::GetHtmlData() const {
-    if (doc) {
-        return doc->AsSpan();
+std::span<u8> MobiDoc::GetHtmlData() {
+    if (!LoadDocRecords()) {
+        return {};
     }
-    return {};
+    return doc->AsSpan();
 }
 
 WCHAR* MobiDoc::GetProperty(DocumentProperty prop) {
@@ -914,6 +925,9 @@ WCHAR* MobiDoc::GetProperty(DocumentProperty prop) {
 }
 
 bool MobiDoc::HasToc() {
+    if (!LoadDocRecords()) {
+        return false;
+    }
     if (docTocIndex != kInvalidSize) {
         return docTocIndex < doc->size();
     }
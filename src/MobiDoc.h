@@ -31,6 +31,10 @@ class MobiDoc {
     };
     Vec<Metadata> props;
 
+    // set once the text records have been decompressed (even if that
+    // failed); see LoadDocRecords
+    bool docLoaded = false;
+
     explicit MobiDoc(const WCHAR* filePath);
 
     bool ParseHeader();
@@ -38,6 +42,7 @@ class MobiDoc {
     void LoadImages();
     bool LoadImage(size_t imageNo);
     bool LoadDocument(PdbReader* pdbReader);
+    bool LoadDocRecords();
     bool DecodeExthHeader(const u8* data, size_t dataLen);
 
   public:
@@ -47,9 +52,9 @@ class MobiDoc {
 
     ~MobiDoc();
 
-    std::span<u8> GetHtmlData() const;
-    size_t GetHtmlDataSize() const {
-        return doc->size();
+    std::span<u8> GetHtmlData();
+    size_t GetHtmlDataSize() {
+        return GetHtmlData().size();
     }
     ImageData* GetCoverImage();
     ImageData* GetImage(size_t imgRecIndex) const;
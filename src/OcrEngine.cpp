@@ -0,0 +1,18 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+
+#include "EngineBase.h"
+
+#include "OcrEngine.h"
+
+static OcrEngine* gOcrEngine = nullptr;
+
+void SetOcrEngine(OcrEngine* engine) {
+    gOcrEngine = engine;
+}
+
+OcrEngine* GetOcrEngine() {
+    return gOcrEngine;
+}
@@ -0,0 +1,38 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+class RenderedBitmap;
+
+// recognized text of one page, in the layout of PageText: one bounding
+// box per character, but in pixel coordinates of the bitmap that was
+// recognized (the OCR pass maps them back into page coordinates).
+// text and coords must be allocated with malloc; ownership passes to
+// the caller
+struct OcrPageResult {
+    WCHAR* text{nullptr};
+    Rect* coords{nullptr};
+    int len{0};
+};
+
+// interface of a pluggable OCR engine. We don't ship one; an embedder
+// (or a build with e.g. tesseract linked in) registers an implementation
+// via SetOcrEngine at startup and scanned documents become searchable:
+// pages whose text extraction comes up empty are rasterized and
+// recognized in the background (see the OCR pass in DisplayModel.cpp)
+class OcrEngine {
+  public:
+    virtual ~OcrEngine() {
+    }
+    // the resolution (in dots per inch) pages should be rasterized at
+    // for recognition (typically 300)
+    virtual int PreferredDpi() = 0;
+    // recognizes the text in a rendered page. Called from background
+    // threads, possibly several at a time; must be thread-safe.
+    // returns false if nothing was recognized
+    virtual bool RecognizePage(RenderedBitmap* bmp, OcrPageResult* result) = 0;
+};
+
+// engine remains owned by the caller and must stay valid until replaced
+// with nullptr; only call before documents are loaded or at shutdown
+void SetOcrEngine(OcrEngine* engine);
+OcrEngine* GetOcrEngine();
@@ -0,0 +1,405 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+/* A sidebar panel with one thumbnail per page, for visual navigation.
+
+   The list is virtualized: it never materializes a bitmap (or any per-page
+   state) for pages outside the visible rows, so a 10,000 page document
+   costs no more memory than a 10 page one. Rows have a uniform height
+   derived from the first page's aspect ratio, which makes the visible page
+   range and the scrollbar position O(1) to compute.
+
+   The bitmaps themselves live in RenderCache: painting asks Find() for a
+   whole-page rendering at the thumbnail zoom and, when there is none,
+   queues the page in the cache's low-priority thumbnail lane, which is
+   only drained when no user requested rendering is pending. Cached
+   thumbnails are subject to the normal byte budget, get evicted into the
+   compressed tier and come back from the disk tile cache on reopening. */
+
+#include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
+#include "utils/Dpi.h"
+#include "utils/WinUtil.h"
+
+#include "wingui/WinGui.h"
+#include "wingui/Layout.h"
+#include "wingui/Window.h"
+#include "wingui/LabelWithCloseWnd.h"
+#include "wingui/TreeModel.h"
+
+#include "Annotation.h"
+#include "EngineBase.h"
+
+#include "SettingsStructs.h"
+#include "Controller.h"
+#include "DisplayModel.h"
+#include "GlobalPrefs.h"
+#include "RenderCache.h"
+#include "SumatraPDF.h"
+#include "WindowInfo.h"
+#include "TabInfo.h"
+#include "resource.h"
+#include "Translations.h"
+#include "PageThumbnails.h"
+
+#define THUMBS_LIST_CLASS_NAME L"SUMATRA_PDF_THUMBS_LIST"
+
+// padding around the thumbnail cells and height of the page label drawn
+// below each one (scaled for DPI at use)
+constexpr int kThumbPadding = 6;
+constexpr int kThumbLabelDy = 16;
+
+// geometry of the thumbnail list, recomputed from the client rectangle
+// and the document on every use (cheap, and this way there's no cached
+// state to invalidate on resizes, tab switches or reloads)
+struct ThumbsLayout {
+    DisplayModel* dm = nullptr;
+    int pageCount = 0;
+    int padding = 0;
+    int labelDy = 0;
+    Rect rcClient;
+    // size of the page bitmap within a row
+    int thumbDx = 0;
+    int thumbDy = 0;
+    // total height of one row (thumbnail, label and padding)
+    int rowDy = 0;
+    // the zoom to render thumbnails at, chosen so that a page fills the row
+    float zoom = 0.f;
+};
+
+static bool GetThumbsLayout(WindowInfo* win, ThumbsLayout& l) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm || dm->PageCount() < 1) {
+        return false;
+    }
+
+    l.dm = dm;
+    l.pageCount = dm->PageCount();
+    l.padding = DpiScale(win->hwndThumbsList, kThumbPadding);
+    l.labelDy = DpiScale(win->hwndThumbsList, kThumbLabelDy);
+    l.rcClient = ClientRect(win->hwndThumbsList);
+
+    l.thumbDx = l.rcClient.dx - 2 * l.padding;
+    if (l.thumbDx < 16) {
+        return false;
+    }
+    // all rows use the first page's aspect ratio; pages with a different
+    // aspect are fit into the row (uniform rows keep the math O(1))
+    RectF page = dm->GetEngine()->PageMediabox(1);
+    if (page.dx <= 0 || page.dy <= 0) {
+        return false;
+    }
+    l.thumbDy = (int)(l.thumbDx * page.dy / page.dx);
+    // don't let extreme aspect ratios (e.g. banner pages) blow up the rows
+    l.thumbDy = limitValue(l.thumbDy, l.thumbDx / 4, 3 * l.thumbDx);
+    l.rowDy = l.thumbDy + l.labelDy + l.padding;
+    l.zoom = (float)l.thumbDx / (float)page.dx;
+    return true;
+}
+
+static int ClampThumbsScroll(const ThumbsLayout& l, int scrollY) {
+    int maxScroll = l.pageCount * l.rowDy + l.padding - l.rcClient.dy;
+    return limitValue(scrollY, 0, std::max(0, maxScroll));
+}
+
+static void UpdateThumbsScrollbar(WindowInfo* win) {
+    ThumbsLayout l;
+    SCROLLINFO si{};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+    if (GetThumbsLayout(win, l)) {
+        win->thumbsScrollY = ClampThumbsScroll(l, win->thumbsScrollY);
+        si.nMax = l.pageCount * l.rowDy + l.padding - 1;
+        si.nPage = l.rcClient.dy;
+        si.nPos = win->thumbsScrollY;
+    }
+    SetScrollInfo(win->hwndThumbsList, SB_VERT, &si, TRUE);
+}
+
+// the rectangle of a page's thumbnail bitmap, in client coordinates
+static Rect GetThumbRect(const ThumbsLayout& l, int scrollY, int pageNo) {
+    int y = l.padding + (pageNo - 1) * l.rowDy - scrollY;
+    return Rect(l.padding, y, l.thumbDx, l.thumbDy);
+}
+
+static void PaintThumbnails(WindowInfo* win, HDC hdc) {
+    RECT rBg = ToRECT(ClientRect(win->hwndThumbsList));
+    FillRect(hdc, &rBg, GetSysColorBrush(COLOR_BTNFACE));
+
+    ThumbsLayout l;
+    if (!GetThumbsLayout(win, l)) {
+        return;
+    }
+    int scrollY = win->thumbsScrollY;
+    int currPageNo = win->ctrl->CurrentPageNo();
+    int rotation = l.dm->GetRotation();
+    TilePosition tile(0, 0, 0);
+
+    int firstPage = scrollY / l.rowDy + 1;
+    int lastPage = (scrollY + l.rcClient.dy) / l.rowDy + 1;
+    lastPage = std::min(lastPage, l.pageCount);
+
+    SetStretchBltMode(hdc, HALFTONE);
+    SetBkMode(hdc, TRANSPARENT);
+    HGDIOBJ prevFont = SelectObject(hdc, GetDefaultGuiFont());
+
+    for (int pageNo = firstPage; pageNo <= lastPage; pageNo++) {
+        Rect thumb = GetThumbRect(l, scrollY, pageNo);
+
+        BitmapCacheEntry* entry = gRenderCache.Find(l.dm, pageNo, rotation, l.zoom, &tile);
+        if (entry && entry->bitmap) {
+            // keep the bitmap's aspect when it differs from the row's
+            Size bmpSize = entry->bitmap->Size();
+            Rect dest = thumb;
+            if (bmpSize.dx > 0 && bmpSize.dy > 0) {
+                int fitDy = std::min(thumb.dy, thumb.dx * bmpSize.dy / bmpSize.dx);
+                int fitDx = std::min(thumb.dx, thumb.dy * bmpSize.dx / bmpSize.dy);
+                dest = Rect(thumb.x + (thumb.dx - fitDx) / 2, thumb.y + (thumb.dy - fitDy) / 2, fitDx, fitDy);
+            }
+            entry->bitmap->StretchDIBits(hdc, dest);
+            RECT rFrame = ToRECT(dest);
+            FrameRect(hdc, &rFrame, GetStockBrush(GRAY_BRUSH));
+        } else {
+            // not rendered (yet): draw a placeholder and queue the page in
+            // the low-priority lane; UWM_THUMBNAIL_RENDERED repaints it
+            RECT r = ToRECT(thumb);
+            FillRect(hdc, &r, GetStockBrush(WHITE_BRUSH));
+            FrameRect(hdc, &r, GetStockBrush(GRAY_BRUSH));
+            gRenderCache.RequestThumbnailRendering(l.dm, pageNo, l.zoom, win->hwndThumbsList);
+        }
+        if (entry) {
+            gRenderCache.DropCacheEntry(entry);
+        }
+
+        if (pageNo == currPageNo) {
+            RECT r = ToRECT(Rect(thumb.x - 2, thumb.y - 2, thumb.dx + 4, thumb.dy + 4));
+            HBRUSH br = CreateSolidBrush(GetSysColor(COLOR_HIGHLIGHT));
+            FrameRect(hdc, &r, br);
+            r = ToRECT(Rect(thumb.x - 1, thumb.y - 1, thumb.dx + 2, thumb.dy + 2));
+            FrameRect(hdc, &r, br);
+            DeleteObject(br);
+        }
+
+        AutoFreeWstr label(win->ctrl->GetPageLabel(pageNo));
+        RECT rLabel = ToRECT(Rect(thumb.x, thumb.y + thumb.dy, thumb.dx, l.labelDy));
+        DrawTextW(hdc, label, -1, &rLabel, DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+    }
+
+    SelectObject(hdc, prevFont);
+}
+
+static void ScrollThumbnails(WindowInfo* win, int newScrollY) {
+    ThumbsLayout l;
+    if (!GetThumbsLayout(win, l)) {
+        return;
+    }
+    newScrollY = ClampThumbsScroll(l, newScrollY);
+    if (newScrollY == win->thumbsScrollY) {
+        return;
+    }
+    win->thumbsScrollY = newScrollY;
+    SetScrollPos(win->hwndThumbsList, SB_VERT, newScrollY, TRUE);
+    InvalidateRect(win->hwndThumbsList, nullptr, FALSE);
+}
+
+static void OnThumbsVScroll(WindowInfo* win, WPARAM wp) {
+    ThumbsLayout l;
+    if (!GetThumbsLayout(win, l)) {
+        return;
+    }
+    SCROLLINFO si{};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_ALL;
+    GetScrollInfo(win->hwndThumbsList, SB_VERT, &si);
+
+    int newY = win->thumbsScrollY;
+    switch (LOWORD(wp)) {
+        case SB_TOP:
+            newY = 0;
+            break;
+        case SB_BOTTOM:
+            newY = si.nMax;
+            break;
+        case SB_LINEUP:
+            newY -= l.rowDy / 4;
+            break;
+        case SB_LINEDOWN:
+            newY += l.rowDy / 4;
+            break;
+        case SB_PAGEUP:
+            newY -= l.rcClient.dy;
+            break;
+        case SB_PAGEDOWN:
+            newY += l.rcClient.dy;
+            break;
+        case SB_THUMBTRACK:
+        case SB_THUMBPOSITION:
+            newY = si.nTrackPos;
+            break;
+    }
+    ScrollThumbnails(win, newY);
+}
+
+static void OnThumbsClick(WindowInfo* win, int y) {
+    ThumbsLayout l;
+    if (!GetThumbsLayout(win, l)) {
+        return;
+    }
+    int pageNo = (win->thumbsScrollY + y - l.padding) / l.rowDy + 1;
+    if (!win->ctrl->ValidPageNo(pageNo)) {
+        return;
+    }
+    win->ctrl->GoToPage(pageNo, true);
+    InvalidateRect(win->hwndThumbsList, nullptr, FALSE);
+}
+
+// make sure the current page's row is visible
+static void ScrollThumbnailsToPage(WindowInfo* win, int pageNo) {
+    ThumbsLayout l;
+    if (!GetThumbsLayout(win, l)) {
+        return;
+    }
+    Rect thumb = GetThumbRect(l, win->thumbsScrollY, pageNo);
+    if (thumb.y >= 0 && thumb.y + l.rowDy <= l.rcClient.dy) {
+        return;
+    }
+    // center the row in the visible part of the list
+    int newY = l.padding + (pageNo - 1) * l.rowDy - (l.rcClient.dy - l.rowDy) / 2;
+    ScrollThumbnails(win, newY);
+}
+
+static LRESULT CALLBACK WndProcThumbsList(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
+    WindowInfo* win = FindWindowInfoByHwnd(hwnd);
+    if (!win) {
+        return DefWindowProc(hwnd, msg, wp, lp);
+    }
+
+    switch (msg) {
+        case WM_PAINT: {
+            PAINTSTRUCT ps;
+            HDC hdc = BeginPaint(hwnd, &ps);
+            PaintThumbnails(win, hdc);
+            EndPaint(hwnd, &ps);
+            return 0;
+        }
+
+        case WM_ERASEBKGND:
+            // PaintThumbnails fills the background
+            return TRUE;
+
+        case WM_SIZE:
+            UpdateThumbsScrollbar(win);
+            InvalidateRect(hwnd, nullptr, FALSE);
+            return 0;
+
+        case WM_VSCROLL:
+            OnThumbsVScroll(win, wp);
+            return 0;
+
+        case WM_MOUSEWHEEL: {
+            ThumbsLayout l;
+            if (GetThumbsLayout(win, l)) {
+                int delta = GET_WHEEL_DELTA_WPARAM(wp);
+                ScrollThumbnails(win, win->thumbsScrollY - delta * l.rowDy / (3 * WHEEL_DELTA));
+            }
+            return 0;
+        }
+
+        case WM_LBUTTONDOWN:
+            OnThumbsClick(win, GET_Y_LPARAM(lp));
+            return 0;
+
+        case UWM_THUMBNAIL_RENDERED: {
+            // only repaint the rendered page's row (if it's still visible)
+            ThumbsLayout l;
+            if (GetThumbsLayout(win, l)) {
+                Rect thumb = GetThumbRect(l, win->thumbsScrollY, (int)wp);
+                if (thumb.y + l.rowDy > 0 && thumb.y < l.rcClient.dy) {
+                    RECT r = ToRECT(Rect(0, thumb.y, l.rcClient.dx, l.rowDy));
+                    InvalidateRect(hwnd, &r, FALSE);
+                }
+            }
+            return 0;
+        }
+    }
+    return DefWindowProc(hwnd, msg, wp, lp);
+}
+
+static WNDPROC DefWndProcThumbsBox = nullptr;
+static LRESULT CALLBACK WndProcThumbsBox(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
+    WindowInfo* win = FindWindowInfoByHwnd(hwnd);
+    if (!win) {
+        return CallWindowProc(DefWndProcThumbsBox, hwnd, msg, wp, lp);
+    }
+
+    switch (msg) {
+        case WM_SIZE:
+            LayoutTreeContainer(win->thumbsLabelWithClose, nullptr, nullptr, win->hwndThumbsList);
+            break;
+
+        case WM_COMMAND:
+            if (LOWORD(wp) == IDC_THUMBS_LABEL_WITH_CLOSE) {
+                TogglePageThumbnails(win);
+            }
+            break;
+    }
+    return CallWindowProc(DefWndProcThumbsBox, hwnd, msg, wp, lp);
+}
+
+void CreatePageThumbnails(WindowInfo* win) {
+    HMODULE h = GetModuleHandleW(nullptr);
+    int dx = gGlobalPrefs->sidebarDx;
+    DWORD dwStyle = WS_CHILD | WS_CLIPCHILDREN;
+    win->hwndThumbsBox = CreateWindowW(WC_STATIC, L"", dwStyle, 0, 0, dx, 0, win->hwndFrame, (HMENU)0, h, nullptr);
+
+    auto* l = new LabelWithCloseWnd();
+    l->Create(win->hwndThumbsBox, IDC_THUMBS_LABEL_WITH_CLOSE);
+    win->thumbsLabelWithClose = l;
+    l->SetPaddingXY(2, 2);
+    l->SetFont(GetDefaultGuiFont(true, false));
+    // label is set in UpdateToolbarSidebarText()
+
+    WNDCLASSEX wcex;
+    if (!GetClassInfoEx(h, THUMBS_LIST_CLASS_NAME, &wcex)) {
+        FillWndClassEx(wcex, THUMBS_LIST_CLASS_NAME, WndProcThumbsList);
+        wcex.hCursor = LoadCursor(nullptr, IDC_ARROW);
+        RegisterClassEx(&wcex);
+    }
+    dwStyle = WS_CHILD | WS_CLIPCHILDREN | WS_VSCROLL;
+    win->hwndThumbsList = CreateWindowExW(WS_EX_STATICEDGE, THUMBS_LIST_CLASS_NAME, L"", dwStyle, 0, 0, dx, 0,
+                                          win->hwndThumbsBox, (HMENU)0, h, nullptr);
+    ShowWindow(win->hwndThumbsList, SW_SHOW);
+
+    if (nullptr == DefWndProcThumbsBox) {
+        DefWndProcThumbsBox = (WNDPROC)GetWindowLongPtr(win->hwndThumbsBox, GWLP_WNDPROC);
+    }
+    SetWindowLongPtr(win->hwndThumbsBox, GWLP_WNDPROC, (LONG_PTR)WndProcThumbsBox);
+}
+
+void TogglePageThumbnails(WindowInfo* win) {
+    win->thumbsVisible = !win->thumbsVisible;
+    SetSidebarVisibility(win, win->tocVisible, gGlobalPrefs->showFavorites);
+    if (win->thumbsVisible && win->IsDocLoaded()) {
+        ScrollThumbnailsToPage(win, win->ctrl->CurrentPageNo());
+    }
+}
+
+void UpdatePageThumbnails(WindowInfo* win) {
+    if (!win->hwndThumbsList) {
+        return;
+    }
+    win->thumbsScrollY = 0;
+    UpdateThumbsScrollbar(win);
+    if (win->thumbsVisible && win->IsDocLoaded()) {
+        ScrollThumbnailsToPage(win, win->ctrl->CurrentPageNo());
+    }
+    InvalidateRect(win->hwndThumbsList, nullptr, FALSE);
+}
+
+void PageThumbnailsOnPageChanged(WindowInfo* win) {
+    if (!win->thumbsVisible || !win->IsDocLoaded()) {
+        return;
+    }
+    ScrollThumbnailsToPage(win, win->ctrl->CurrentPageNo());
+    InvalidateRect(win->hwndThumbsList, nullptr, FALSE);
+}
@@ -0,0 +1,9 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+void CreatePageThumbnails(WindowInfo* win);
+void TogglePageThumbnails(WindowInfo* win);
+// reset the list after the displayed document changed (or was closed)
+void UpdatePageThumbnails(WindowInfo* win);
+// repaint the highlight of the current page after navigation
+void PageThumbnailsOnPageChanged(WindowInfo* win);
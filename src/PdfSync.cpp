@@ -5,6 +5,8 @@
 #include <synctex_parser.h>
 #include "utils/ScopedWin.h"
 #include "utils/FileUtil.h"
+#include "utils/FileWatcher.h"
+#include "utils/ThreadUtil.h"
 
 #include "wingui/TreeModel.h"
 
@@ -52,7 +54,7 @@ class Pdfsync : public Synchronizer {
     int SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT* page, Vec<Rect>& rects) override;
 
   private:
-    int RebuildIndex();
+    int RebuildIndex() override;
     UINT SourceToRecord(const WCHAR* srcfilename, UINT line, UINT col, Vec<size_t>& records);
 
     EngineBase* engine;              // needed for converting between coordinate systems
@@ -78,16 +80,58 @@ class SyncTex : public Synchronizer {
     int SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT* page, Vec<Rect>& rects) override;
 
   private:
-    int RebuildIndex();
+    int RebuildIndex() override;
 
     EngineBase* engine; // needed for converting between coordinate systems
     synctex_scanner_t scanner;
 };
 
-Synchronizer::Synchronizer(const WCHAR* syncfilepath) : indexDiscarded(true), syncfilepath(str::Dup(syncfilepath)) {
+Synchronizer::Synchronizer(const WCHAR* syncfilepath)
+    : indexDiscarded(true), indexTask(nullptr), watcher(nullptr), syncfilepath(str::Dup(syncfilepath)) {
+    InitializeCriticalSection(&indexAccess);
     _wstat(syncfilepath, &syncfileTimestamp);
 }
 
+Synchronizer::~Synchronizer() {
+    FileWatcherUnsubscribe(watcher);
+    if (indexTask) {
+        // the task captures this, so it must be over before we go away
+        indexTask->Wait();
+        DropTaskHandle(indexTask);
+    }
+    DeleteCriticalSection(&indexAccess);
+}
+
+void Synchronizer::StartBackgroundIndexing() {
+    CrashIf(watcher);
+    watcher = FileWatcherSubscribe(syncfilepath, [this] { ScheduleIndexRebuild(); });
+    ScheduleIndexRebuild();
+}
+
+// kicks off a parse of the synchronization file on the thread pool. Called at
+// creation time and whenever the file changes on disk, so that by the time the
+// editor asks for a forward search after a compilation the fresh index is
+// (mostly) built already instead of stalling that search for the whole parse
+void Synchronizer::ScheduleIndexRebuild() {
+    ScopedCritSec scope(&indexAccess);
+    if (indexTask && !indexTask->IsDone()) {
+        // a parse is already queued or under way; it (or the IsIndexDiscarded
+        // check of the next search) will pick up this change as well
+        return;
+    }
+    if (indexTask) {
+        DropTaskHandle(indexTask);
+    }
+    indexTask = GetThreadPool()->Submit(
+        [this] {
+            ScopedCritSec scope(&indexAccess);
+            if (IsIndexDiscarded()) {
+                RebuildIndex();
+            }
+        },
+        TaskPriority::Background);
+}
+
 bool Synchronizer::IsIndexDiscarded() const {
     // was the index manually discarded?
     if (indexDiscarded) {
@@ -136,7 +180,11 @@ int Synchronizer::Create(const WCHAR* pdffilename, EngineBase* engine, Synchroni
     AutoFreeWstr syncFile(str::Join(baseName, PDFSYNC_EXTENSION));
     if (file::Exists(syncFile)) {
         *sync = new Pdfsync(syncFile, engine);
-        return *sync ? PDFSYNCERR_SUCCESS : PDFSYNCERR_OUTOFMEMORY;
+        if (!*sync) {
+            return PDFSYNCERR_OUTOFMEMORY;
+        }
+        (*sync)->StartBackgroundIndexing();
+        return PDFSYNCERR_SUCCESS;
     }
 
     // check if SYNCTEX or compressed SYNCTEX file is present
@@ -147,7 +195,11 @@ int Synchronizer::Create(const WCHAR* pdffilename, EngineBase* engine, Synchroni
         // due to a bug with synctex_parser.c, this must always be
         // the path to the .synctex file (even if a .synctex.gz file is used instead)
         *sync = new SyncTex(texFile, engine);
-        return *sync ? PDFSYNCERR_SUCCESS : PDFSYNCERR_OUTOFMEMORY;
+        if (!*sync) {
+            return PDFSYNCERR_OUTOFMEMORY;
+        }
+        (*sync)->StartBackgroundIndexing();
+        return PDFSYNCERR_SUCCESS;
     }
 
     return PDFSYNCERR_SYNCFILE_NOTFOUND;
@@ -329,6 +381,7 @@ static int cmpLineRecords(const void* a, const void* b) {
 }
 
 int Pdfsync::DocToSource(UINT pageNo, Point pt, AutoFreeWstr& filename, UINT* line, UINT* col) {
+    ScopedCritSec scope(&indexAccess);
     if (IsIndexDiscarded()) {
         if (RebuildIndex() != PDFSYNCERR_SUCCESS) {
             return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
@@ -470,6 +523,7 @@ UINT Pdfsync::SourceToRecord(const WCHAR* srcfilename, UINT line, [[maybe_unused
 }
 
 int Pdfsync::SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT* page, Vec<Rect>& rects) {
+    ScopedCritSec scope(&indexAccess);
     if (IsIndexDiscarded()) {
         if (RebuildIndex() != PDFSYNCERR_SUCCESS) {
             return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
@@ -529,6 +583,7 @@ int SyncTex::RebuildIndex() {
 }
 
 int SyncTex::DocToSource(UINT pageNo, Point pt, AutoFreeWstr& filename, UINT* line, UINT* col) {
+    ScopedCritSec scope(&indexAccess);
     if (IsIndexDiscarded()) {
         if (RebuildIndex() != PDFSYNCERR_SUCCESS) {
             return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
@@ -580,6 +635,7 @@ TryAgainAnsi:
 }
 
 int SyncTex::SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT* page, Vec<Rect>& rects) {
+    ScopedCritSec scope(&indexAccess);
     if (IsIndexDiscarded()) {
         if (RebuildIndex() != PDFSYNCERR_SUCCESS) {
             return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
@@ -19,12 +19,18 @@ enum {
 };
 
 class EngineBase;
+struct TaskHandle;
+struct WatchedFile;
 
 class Synchronizer {
   public:
     explicit Synchronizer(const WCHAR* syncfilepath);
-    virtual ~Synchronizer() {
-    }
+    virtual ~Synchronizer();
+
+    // parses the synchronization file on the thread pool so that the first
+    // forward/inverse search doesn't have to, and re-parses it whenever the
+    // file is rewritten on disk (typically after each (pdf)latex run)
+    void StartBackgroundIndexing();
 
     // Inverse-search:
     //  - pageNo: page number in the PDF (starting from 1)
@@ -47,12 +53,20 @@ class Synchronizer {
                          // pdfsync file is detected)
     struct _stat syncfileTimestamp; // time stamp of sync file when index was last built
 
+    TaskHandle* indexTask; // pending background parse of the index (see StartBackgroundIndexing)
+    WatchedFile* watcher;  // notifies us when the synchronization file is rewritten
+
+    void ScheduleIndexRebuild();
+
   protected:
     bool IsIndexDiscarded() const;
-    int RebuildIndex();
+    virtual int RebuildIndex();
     WCHAR* PrependDir(const WCHAR* filename) const;
 
     AutoFreeWstr syncfilepath; // path to the synchronization file
+    // protects the index against concurrent background rebuilds; every
+    // DocToSource/SourceToDoc implementation holds it for its whole body
+    CRITICAL_SECTION indexAccess;
 
   public:
     static int Create(const WCHAR* pdffilename, EngineBase* engine, Synchronizer** sync);
@@ -4,6 +4,7 @@
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
 #include "utils/FileUtil.h"
+#include "utils/ThreadUtil.h"
 #include "utils/UITask.h"
 #include "utils/WinUtil.h"
 #include "utils/Log.h"
@@ -20,6 +21,7 @@
 #include "GlobalPrefs.h"
 #include "ChmModel.h"
 #include "DisplayModel.h"
+#include "RenderCache.h"
 #include "ProgressUpdateUI.h"
 #include "TextSelection.h"
 #include "TextSearch.h"
@@ -34,6 +36,8 @@
 #include "SumatraProperties.h"
 #include "Translations.h"
 
+#pragma warning(disable : 28159) // silence /analyze: Consider using 'GetTickCount64' instead of 'GetTickCount'
+
 struct PrintData {
     AutoFreeWstr printerName;
     ScopedMem<DEVMODEW> devMode;
@@ -111,6 +115,113 @@ static RectF BoundSelectionOnPage(const Vec<SelectionOnPage>& sel, int pageNo) {
     return bounds;
 }
 
+// position and scale of one document page on the physical paper
+struct PrintPageLayout {
+    float zoom = 1.0f;
+    int rotation = 0;
+    Point offset;
+    Rect full; // the whole page in (zoomed and rotated) device pixels
+};
+
+static PrintPageLayout ComputePrintPageLayout(EngineBase& engine, PrintScaleAdv scale, int pageNo, Size paperSize,
+                                              Rect printable, float dpiFactor, bool bPrintPortrait) {
+    PrintPageLayout pl;
+
+    SizeF pSize = engine.PageMediabox(pageNo).Size();
+    // Turn the document by 90 deg if it isn't in portrait mode
+    if (pSize.dx > pSize.dy) {
+        pl.rotation += 90;
+        std::swap(pSize.dx, pSize.dy);
+    }
+    // make sure not to print upside-down
+    pl.rotation = (pl.rotation % 180) == 0 ? 0 : 270;
+    // finally turn the page by (another) 90 deg in landscape mode
+    if (!bPrintPortrait) {
+        pl.rotation = (pl.rotation + 90) % 360;
+        std::swap(pSize.dx, pSize.dy);
+    }
+
+    // dpiFactor means no physical zoom
+    pl.zoom = dpiFactor;
+    // offset of the top-left corner of the page from the printable area
+    // (negative values move the page into the left/top margins, etc.);
+    // offset adjustments are needed because the GDI coordinate system
+    // starts at the corner of the printable area and we rather want to
+    // center the page on the physical paper (except for PrintScaleNone
+    // where the page starts at the very top left of the physical paper so
+    // that printing forms/labels of varying size remains reliably possible)
+    pl.offset = Point(-printable.x, -printable.y);
+
+    if (scale != PrintScaleAdv::None) {
+        // make sure to fit all content into the printable area when scaling
+        // and the whole document page on the physical paper
+        RectF rect = engine.PageContentBox(pageNo, RenderTarget::Print);
+        RectF cbox = engine.Transform(rect, pageNo, 1.0, pl.rotation);
+        pl.zoom = std::min((float)printable.dx / cbox.dx,
+                           std::min((float)printable.dy / cbox.dy,
+                                    std::min((float)paperSize.dx / pSize.dx, (float)paperSize.dy / pSize.dy)));
+        // use the correct zoom values, if the page fits otherwise
+        // and the user didn't ask for anything else (default setting)
+        if (PrintScaleAdv::Shrink == scale && dpiFactor < pl.zoom) {
+            pl.zoom = dpiFactor;
+        }
+        // center the page on the physical paper
+        pl.offset.x += (int)(paperSize.dx - pSize.dx * pl.zoom) / 2;
+        pl.offset.y += (int)(paperSize.dy - pSize.dy * pl.zoom) / 2;
+        // make sure that no content lies in the non-printable paper margins
+        RectF onPaper(printable.x + pl.offset.x + cbox.x * pl.zoom, printable.y + pl.offset.y + cbox.y * pl.zoom,
+                      cbox.dx * pl.zoom, cbox.dy * pl.zoom);
+        if (onPaper.x < printable.x) {
+            pl.offset.x += (int)(printable.x - onPaper.x);
+        } else if (onPaper.BR().x > printable.BR().x) {
+            pl.offset.x -= (int)(onPaper.BR().x - printable.BR().x);
+        }
+        if (onPaper.y < printable.y) {
+            pl.offset.y += (int)(printable.y - onPaper.y);
+        } else if (onPaper.BR().y > printable.BR().y) {
+            pl.offset.y -= (int)(onPaper.BR().y - printable.BR().y);
+        }
+    }
+
+    pl.full = engine.Transform(engine.PageMediabox(pageNo), pageNo, pl.zoom, pl.rotation).Round();
+    return pl;
+}
+
+// limit for one rendered band: a letter page at 600dpi is ~100MB as a
+// 24-bit bitmap, rendering it in horizontal bands keeps peak memory bounded
+#define PRINT_BAND_MAX_BYTES (16 * 1024 * 1024)
+
+static void GetPrintBands(const PrintPageLayout& pl, Vec<Rect>& bands) {
+    if (pl.full.IsEmpty()) {
+        // keep the invariant that every page yields at least one band
+        bands.Append(pl.full);
+        return;
+    }
+    int rowBytes = pl.full.dx * 3;
+    int bandDy = pl.full.dy;
+    if (rowBytes > 0 && bandDy > PRINT_BAND_MAX_BYTES / rowBytes) {
+        bandDy = std::max(PRINT_BAND_MAX_BYTES / rowBytes, 64);
+    }
+    for (int y = 0; y < pl.full.dy; y += bandDy) {
+        bands.Append(Rect(pl.full.x, pl.full.y + y, pl.full.dx, std::min(bandDy, pl.full.dy - y)));
+    }
+}
+
+static RenderedBitmap* RenderPrintBand(EngineBase& engine, int pageNo, const PrintPageLayout& pl, Rect band,
+                                       AbortCookieManager* abortCookie) {
+    // band is in device pixels, RenderPage clips in page coordinates
+    RectF clip = engine.Transform(ToRectFl(band), pageNo, pl.zoom, pl.rotation, true);
+    RenderPageArgs args(pageNo, pl.zoom, pl.rotation, &clip, RenderTarget::Print);
+    if (abortCookie) {
+        args.cookie_out = &abortCookie->cookie;
+    }
+    RenderedBitmap* bmp = engine.RenderPage(args);
+    if (abortCookie) {
+        abortCookie->Clear();
+    }
+    return bmp;
+}
+
 static bool PrintToDevice(const PrintData& pd, ProgressUpdateUI* progressUI = nullptr,
                           AbortCookieManager* abortCookie = nullptr) {
     CrashIf(!pd.engine);
@@ -261,6 +372,7 @@ static bool PrintToDevice(const PrintData& pd, ProgressUpdateUI* progressUI = nu
     }
 
     // print all the pages the user requested
+    Vec<int> pagesToPrint;
     for (size_t i = 0; i < pd.ranges.size(); i++) {
         int dir = pd.ranges.at(i).nFromPage > pd.ranges.at(i).nToPage ? -1 : 1;
         for (DWORD pageNo = pd.ranges.at(i).nFromPage; pageNo != pd.ranges.at(i).nToPage + dir; pageNo += dir) {
@@ -268,73 +380,148 @@ static bool PrintToDevice(const PrintData& pd, ProgressUpdateUI* progressUI = nu
                 (PrintRangeAdv::Odd == pd.advData.range && pageNo % 2 == 0)) {
                 continue;
             }
+            pagesToPrint.Append((int)pageNo);
+        }
+    }
+
+    // rasterize bands for multiple pages concurrently on the thread pool,
+    // each in-flight band drawing through its own engine clone (a single
+    // engine serializes rendering internally); the spooler below consumes
+    // the bands strictly in order, so in-flight memory stays bounded by
+    // maxInFlight * PRINT_BAND_MAX_BYTES. The prefetched renders aren't
+    // hooked up to the abort cookie (there's only one cookie slot), on
+    // cancellation we just wait them out - each is bounded by the band
+    // budget anyway
+    struct PrintBandJob {
+        int pageNo = 0;
+        size_t bandIdx = 0;   // the first band of a page starts it
+        size_t bandCount = 0; // the last band of a page ends it
+        PrintPageLayout pl;
+        Rect band;
+        RenderedBitmap* bmp = nullptr;
+        TaskHandle* task = nullptr;
+        size_t engineIdx = 0;
+    };
+
+    Vec<EngineBase*> renderEngines;
+    renderEngines.Append(&engine);
+    int maxInFlight = std::min(GetThreadPool()->threadCount, 4);
+    for (int i = 1; i < maxInFlight; i++) {
+        EngineBase* clone = engine.Clone();
+        if (!clone) {
+            // not all engines can be cloned, rendering just parallelizes less
+            break;
+        }
+        renderEngines.Append(clone);
+    }
+    maxInFlight = (int)renderEngines.size();
+
+    Vec<size_t> freeEngines;
+    for (size_t i = 0; i < renderEngines.size(); i++) {
+        freeEngines.Append(i);
+    }
+    Vec<PrintBandJob*> pendingJobs;
+
+    defer {
+        for (PrintBandJob* job : pendingJobs) {
+            job->task->Wait();
+            DropTaskHandle(job->task);
+            delete job->bmp;
+            delete job;
+        }
+        for (size_t i = 1; i < renderEngines.size(); i++) {
+            delete renderEngines.at(i);
+        }
+    };
+
+    // production cursor: the next band to hand to a renderer
+    size_t prodPageIdx = 0;
+    PrintPageLayout prodLayout;
+    Vec<Rect> prodBands;
+    size_t prodBandIdx = 0;
+    bool prodLayoutValid = false;
+
+    auto submitNextBand = [&] {
+        if (prodPageIdx >= pagesToPrint.size() || freeEngines.size() == 0) {
+            return;
+        }
+        if (!prodLayoutValid) {
+            prodLayout = ComputePrintPageLayout(engine, pd.advData.scale, pagesToPrint.at(prodPageIdx), paperSize,
+                                                printable, dpiFactor, bPrintPortrait);
+            prodBands.Reset();
+            GetPrintBands(prodLayout, prodBands);
+            prodBandIdx = 0;
+            prodLayoutValid = true;
+        }
+        PrintBandJob* job = new PrintBandJob();
+        job->pageNo = pagesToPrint.at(prodPageIdx);
+        job->bandIdx = prodBandIdx;
+        job->bandCount = prodBands.size();
+        job->pl = prodLayout;
+        job->band = prodBands.at(prodBandIdx);
+        job->engineIdx = freeEngines.Pop();
+        EngineBase* re = renderEngines.at(job->engineIdx);
+        auto fn = [re, job] { job->bmp = RenderPrintBand(*re, job->pageNo, job->pl, job->band, nullptr); };
+        job->task = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
+        pendingJobs.Append(job);
+        if (++prodBandIdx >= prodBands.size()) {
+            prodPageIdx++;
+            prodLayoutValid = false;
+        }
+    };
+    for (int i = 0; i < maxInFlight; i++) {
+        submitNextBand();
+    }
+
+    bool pageOk = true;
+    while (pendingJobs.size() > 0) {
+        PrintBandJob* job = pendingJobs.PopAt(0);
+        job->task->Wait();
+        DropTaskHandle(job->task);
+        freeEngines.Append(job->engineIdx);
+
+        if (progressUI && progressUI->WasCanceled()) {
+            delete job->bmp;
+            delete job;
+            AbortDoc(hdc);
+            return false;
+        }
+        // keep the pipeline filled while this band spools
+        submitNextBand();
+
+        if (0 == job->bandIdx) {
             if (progressUI) {
                 progressUI->UpdateProgress(current, total);
             }
-
             StartPage(hdc);
-
-            SizeF pSize = engine.PageMediabox(pageNo).Size();
-            int rotation = 0;
-            // Turn the document by 90 deg if it isn't in portrait mode
-            if (pSize.dx > pSize.dy) {
-                rotation += 90;
-                std::swap(pSize.dx, pSize.dy);
-            }
-            // make sure not to print upside-down
-            rotation = (rotation % 180) == 0 ? 0 : 270;
-            // finally turn the page by (another) 90 deg in landscape mode
-            if (!bPrintPortrait) {
-                rotation = (rotation + 90) % 360;
-                std::swap(pSize.dx, pSize.dy);
-            }
-
-            // dpiFactor means no physical zoom
-            float zoom = dpiFactor;
-            // offset of the top-left corner of the page from the printable area
-            // (negative values move the page into the left/top margins, etc.);
-            // offset adjustments are needed because the GDI coordinate system
-            // starts at the corner of the printable area and we rather want to
-            // center the page on the physical paper (except for PrintScaleNone
-            // where the page starts at the very top left of the physical paper so
-            // that printing forms/labels of varying size remains reliably possible)
-            Point offset(-printable.x, -printable.y);
-
-            if (pd.advData.scale != PrintScaleAdv::None) {
-                // make sure to fit all content into the printable area when scaling
-                // and the whole document page on the physical paper
-                RectF rect = engine.PageContentBox(pageNo, RenderTarget::Print);
-                RectF cbox = engine.Transform(rect, pageNo, 1.0, rotation);
-                zoom = std::min((float)printable.dx / cbox.dx,
-                                std::min((float)printable.dy / cbox.dy,
-                                         std::min((float)paperSize.dx / pSize.dx, (float)paperSize.dy / pSize.dy)));
-                // use the correct zoom values, if the page fits otherwise
-                // and the user didn't ask for anything else (default setting)
-                if (PrintScaleAdv::Shrink == pd.advData.scale && dpiFactor < zoom) {
-                    zoom = dpiFactor;
-                }
-                // center the page on the physical paper
-                offset.x += (int)(paperSize.dx - pSize.dx * zoom) / 2;
-                offset.y += (int)(paperSize.dy - pSize.dy * zoom) / 2;
-                // make sure that no content lies in the non-printable paper margins
-                RectF onPaper(printable.x + offset.x + cbox.x * zoom, printable.y + offset.y + cbox.y * zoom,
-                              cbox.dx * zoom, cbox.dy * zoom);
-                if (onPaper.x < printable.x) {
-                    offset.x += (int)(printable.x - onPaper.x);
-                } else if (onPaper.BR().x > printable.BR().x) {
-                    offset.x -= (int)(onPaper.BR().x - printable.BR().x);
-                }
-                if (onPaper.y < printable.y) {
-                    offset.y += (int)(printable.y - onPaper.y);
-                } else if (onPaper.BR().y > printable.BR().y) {
-                    offset.y -= (int)(onPaper.BR().y - printable.BR().y);
-                }
+            pageOk = true;
+        }
+        if (pageOk) {
+            if (job->bmp && job->bmp->GetBitmap()) {
+                const PrintPageLayout& pl = job->pl;
+                Rect rc(pl.offset.x + job->band.x - pl.full.x, pl.offset.y + job->band.y - pl.full.y, job->band.dx,
+                        job->band.dy);
+                pageOk = job->bmp->StretchDIBits(hdc, rc);
+            } else {
+                pageOk = false;
             }
+        }
+        bool lastBand = job->bandIdx + 1 == job->bandCount;
+        int pageNo = job->pageNo;
+        PrintPageLayout pl = job->pl;
+        delete job->bmp;
+        delete job;
+        if (!lastBand) {
+            continue;
+        }
 
+        if (!pageOk && !(progressUI && progressUI->WasCanceled())) {
+            // fall back to rendering the whole page at (progressively
+            // shrinking) resolutions the way it was always done
             bool ok = false;
             short shrink = 1;
             do {
-                RenderPageArgs args(pageNo, zoom / shrink, rotation, nullptr, RenderTarget::Print);
+                RenderPageArgs args(pageNo, pl.zoom / shrink, pl.rotation, nullptr, RenderTarget::Print);
                 if (abortCookie) {
                     args.cookie_out = &abortCookie->cookie;
                 }
@@ -344,20 +531,20 @@ static bool PrintToDevice(const PrintData& pd, ProgressUpdateUI* progressUI = nu
                 }
                 if (bmp && bmp->GetBitmap()) {
                     auto size = bmp->Size();
-                    Rect rc(offset.x, offset.y, size.dx * shrink, size.dy * shrink);
+                    Rect rc(pl.offset.x, pl.offset.y, size.dx * shrink, size.dy * shrink);
                     ok = bmp->StretchDIBits(hdc, rc);
                 }
                 delete bmp;
                 shrink *= 2;
             } while (!ok && shrink < 32 && !(progressUI && progressUI->WasCanceled()));
             // TODO: abort if !ok?
+        }
 
-            if (EndPage(hdc) <= 0 || (progressUI && progressUI->WasCanceled())) {
-                AbortDoc(hdc);
-                return false;
-            }
-            current++;
+        if (EndPage(hdc) <= 0 || (progressUI && progressUI->WasCanceled())) {
+            AbortDoc(hdc);
+            return false;
         }
+        current++;
     }
 
     EndDoc(hdc);
@@ -470,6 +657,227 @@ static HGLOBAL GlobalMemDup(const void* data, size_t len) {
     return hGlobal;
 }
 
+/* Data behind the preview pane in the print dialog's "Advanced" tab: the
+   paper geometry of the (default) printer and a bitmap of the previewed
+   page. The bitmap renders asynchronously through gRenderCache so that the
+   dialog opens instantly; the scaling options are applied at draw time by
+   placing the bitmap per ComputePrintPageLayout, so switching between them
+   updates the preview without a re-render. */
+struct PrintPreviewData {
+    DisplayModel* dm = nullptr;
+    int pageNo = 1;
+    // paper geometry in printer pixels (cf. PrintToDevice)
+    Size paperSize;
+    Rect printable;
+    float dpiFactor = 1.f;
+    bool printPortrait = true;
+    // the page at preview resolution, owned by us; nullptr until the
+    // asynchronous render delivers it
+    RenderedBitmap* bmp = nullptr;
+    HWND hwndPreview = nullptr;
+};
+
+// previews of print dialogs currently open; guards the render callback
+// against the dialog having been dismissed by the time the bitmap is
+// ready (only used on the UI thread)
+static Vec<PrintPreviewData*> gLivePrintPreviews;
+
+/* the spooler queries behind the print dialog (enumerating the printers,
+   resolving the default one) can stall for many seconds when network print
+   queues are offline. PrewarmPrinterEnumeration() runs them on the thread
+   pool when the File menu opens (see UpdateAppMenu), which primes the
+   spooler's connection caches so that a following Ctrl-P comes up without
+   the stall, and remembers the default printer's name so that the print
+   preview doesn't have to ask the spooler on the UI thread either */
+static Mutex gPrinterCacheLock;
+static WCHAR* gCachedDefaultPrinterName = nullptr;
+static bool gPrinterRefreshInFlight = false;
+static DWORD gPrinterRefreshTick = 0;
+
+// the user can change the default printer at any time, so don't trust
+// cached spooler answers older than this
+enum { PRINTER_CACHE_MAX_AGE_MS = 60 * 1000 };
+
+void PrewarmPrinterEnumeration() {
+    if (!HasPermission(Perm_PrinterAccess)) {
+        return;
+    }
+    gPrinterCacheLock.Lock();
+    bool fresh = gPrinterRefreshTick && GetTickCount() - gPrinterRefreshTick < PRINTER_CACHE_MAX_AGE_MS;
+    bool skip = gPrinterRefreshInFlight || fresh;
+    if (!skip) {
+        gPrinterRefreshInFlight = true;
+    }
+    gPrinterCacheLock.Unlock();
+    if (skip) {
+        return;
+    }
+    DropTaskHandle(GetThreadPool()->Submit(
+        [] {
+            // the returned list isn't used: the point is making the spooler
+            // talk to the (possibly offline) print queues off the UI thread
+            DWORD needed = 0;
+            DWORD nPrinters = 0;
+            DWORD flags = PRINTER_ENUM_LOCAL | PRINTER_ENUM_CONNECTIONS;
+            EnumPrintersW(flags, nullptr, 4, nullptr, 0, &needed, &nPrinters);
+            if (needed > 0) {
+                ScopedMem<BYTE> buf(AllocArray<BYTE>(needed));
+                EnumPrintersW(flags, nullptr, 4, buf.Get(), needed, &needed, &nPrinters);
+            }
+            WCHAR* name = GetDefaultPrinterName();
+            gPrinterCacheLock.Lock();
+            free(gCachedDefaultPrinterName);
+            gCachedDefaultPrinterName = name;
+            gPrinterRefreshTick = GetTickCount();
+            gPrinterRefreshInFlight = false;
+            gPrinterCacheLock.Unlock();
+        },
+        TaskPriority::Prefetch));
+}
+
+// returns the default printer's name without blocking on the spooler when
+// a recent PrewarmPrinterEnumeration() already resolved it
+static WCHAR* GetDefaultPrinterNameCached() {
+    WCHAR* name = nullptr;
+    gPrinterCacheLock.Lock();
+    if (gCachedDefaultPrinterName && GetTickCount() - gPrinterRefreshTick < PRINTER_CACHE_MAX_AGE_MS) {
+        name = str::Dup(gCachedDefaultPrinterName);
+    }
+    gPrinterCacheLock.Unlock();
+    if (name) {
+        return name;
+    }
+    name = GetDefaultPrinterName();
+    gPrinterCacheLock.Lock();
+    free(gCachedDefaultPrinterName);
+    gCachedDefaultPrinterName = str::Dup(name);
+    gPrinterRefreshTick = GetTickCount();
+    gPrinterCacheLock.Unlock();
+    return name;
+}
+
+class PrintPreviewRenderingTask : public RenderingCallback {
+    PrintPreviewData* preview;
+
+  public:
+    explicit PrintPreviewRenderingTask(PrintPreviewData* preview) : preview(preview) {
+    }
+
+    // called on a render worker thread
+    void Callback(RenderedBitmap* bmp) override {
+        PrintPreviewData* preview = this->preview;
+        uitask::Post([=] {
+            if (!gLivePrintPreviews.Contains(preview)) {
+                delete bmp;
+                return;
+            }
+            delete preview->bmp;
+            preview->bmp = bmp;
+            if (preview->hwndPreview) {
+                InvalidateRect(preview->hwndPreview, nullptr, TRUE);
+            }
+        });
+        delete this;
+    }
+};
+
+static PrintPreviewData* CreatePrintPreview(DisplayModel* dm, DEVMODEW* devMode) {
+    AutoFreeWstr printerName(GetDefaultPrinterNameCached());
+    if (!printerName) {
+        return nullptr;
+    }
+    // an information context suffices for querying the paper geometry
+    AutoDeleteDC hdc(CreateIC(nullptr, printerName, nullptr, devMode));
+    if (!hdc) {
+        return nullptr;
+    }
+
+    PrintPreviewData* preview = new PrintPreviewData();
+    preview->dm = dm;
+    preview->pageNo = dm->CurrentPageNo();
+    preview->paperSize = Size(GetDeviceCaps(hdc, PHYSICALWIDTH), GetDeviceCaps(hdc, PHYSICALHEIGHT));
+    preview->printable = Rect(GetDeviceCaps(hdc, PHYSICALOFFSETX), GetDeviceCaps(hdc, PHYSICALOFFSETY),
+                              GetDeviceCaps(hdc, HORZRES), GetDeviceCaps(hdc, VERTRES));
+    float px = (float)GetDeviceCaps(hdc, LOGPIXELSX);
+    float py = (float)GetDeviceCaps(hdc, LOGPIXELSY);
+    float fileDPI = dm->GetEngine()->GetFileDPI();
+    preview->dpiFactor = std::min(px / fileDPI, py / fileDPI);
+    preview->printPortrait = preview->paperSize.dx < preview->paperSize.dy;
+    if (devMode && (devMode->dmFields & DM_ORIENTATION)) {
+        preview->printPortrait = DMORIENT_PORTRAIT == devMode->dmOrientation;
+    }
+    if (preview->paperSize.IsEmpty() || preview->printable.IsEmpty()) {
+        delete preview;
+        return nullptr;
+    }
+
+    gLivePrintPreviews.Append(preview);
+    return preview;
+}
+
+static void DeletePrintPreview(PrintPreviewData* preview) {
+    if (!preview) {
+        return;
+    }
+    gLivePrintPreviews.Remove(preview);
+    delete preview->bmp;
+    delete preview;
+}
+
+void StartPrintPreviewRender(PrintPreviewData* preview, HWND hwndPreview) {
+    preview->hwndPreview = hwndPreview;
+    EngineBase* engine = preview->dm->GetEngine();
+    int pageNo = preview->pageNo;
+    // the page's rotation on paper doesn't depend on the scaling option
+    PrintPageLayout pl = ComputePrintPageLayout(*engine, PrintScaleAdv::None, pageNo, preview->paperSize,
+                                                preview->printable, preview->dpiFactor, preview->printPortrait);
+    // render at the size the page has in the pane when it covers the whole
+    // paper, so that no scaling option needs more pixels than we've got
+    Rect rc = ClientRect(hwndPreview);
+    RectF pageRect = engine->PageMediabox(pageNo);
+    SizeF pSize = engine->Transform(pageRect, pageNo, 1.0f, pl.rotation).Size();
+    if (pSize.IsEmpty() || rc.IsEmpty()) {
+        return;
+    }
+    float zoom = std::min((float)rc.dx / pSize.dx, (float)rc.dy / pSize.dy);
+    RenderingCallback* callback = new PrintPreviewRenderingTask(preview);
+    gRenderCache.Render(preview->dm, pageNo, pl.rotation, zoom, pageRect, *callback);
+}
+
+void DrawPrintPreview(PrintPreviewData* preview, HDC hdc, Rect rc, PrintScaleAdv scale) {
+    RECT rcFill = ToRECT(rc);
+    FillRect(hdc, &rcFill, GetSysColorBrush(COLOR_BTNSHADOW));
+
+    // fit the paper into the pane, centered
+    float s = std::min((float)rc.dx / preview->paperSize.dx, (float)rc.dy / preview->paperSize.dy);
+    Rect paper(0, 0, (int)(preview->paperSize.dx * s), (int)(preview->paperSize.dy * s));
+    paper.Offset(rc.x + (rc.dx - paper.dx) / 2, rc.y + (rc.dy - paper.dy) / 2);
+    RECT rcPaper = ToRECT(paper);
+    FillRect(hdc, &rcPaper, GetStockBrush(WHITE_BRUSH));
+    FrameRect(hdc, &rcPaper, GetStockBrush(BLACK_BRUSH));
+
+    if (!preview->bmp || !preview->bmp->GetBitmap()) {
+        // the asynchronous render hasn't delivered the bitmap yet; its
+        // callback invalidates the pane when it does
+        return;
+    }
+
+    PrintPageLayout pl = ComputePrintPageLayout(*preview->dm->GetEngine(), scale, preview->pageNo, preview->paperSize,
+                                                preview->printable, preview->dpiFactor, preview->printPortrait);
+    // position of the page on the physical paper, in printer pixels
+    Rect onPaper(preview->printable.x + pl.offset.x, preview->printable.y + pl.offset.y, pl.full.dx, pl.full.dy);
+    Rect target((int)(onPaper.x * s), (int)(onPaper.y * s), (int)(onPaper.dx * s), (int)(onPaper.dy * s));
+    target.Offset(paper.x, paper.y);
+
+    // "Use original page sizes" may hang the page over the paper's edges
+    SaveDC(hdc);
+    IntersectClipRect(hdc, rcPaper.left, rcPaper.top, rcPaper.right, rcPaper.bottom);
+    SetStretchBltMode(hdc, HALFTONE);
+    preview->bmp->StretchDIBits(hdc, target);
+    RestoreDC(hdc, -1);
+    FrameRect(hdc, &rcPaper, GetStockBrush(BLACK_BRUSH));
+}
+
 /* Show Print Dialog box to allow user to select the printer
 and the pages to print.
 
@@ -576,6 +984,7 @@ void OnMenuPrint(WindowInfo* win, bool waitForCompletion) {
     pd.nStartPage = START_PAGE_GENERAL;
 
     Print_Advanced_Data advanced(PrintRangeAdv::All, defaultScaleAdv);
+    advanced.preview = CreatePrintPreview(dm, defaultDevMode.Get());
     ScopedMem<DLGTEMPLATE> dlgTemplate; // needed for RTL languages
     HPROPSHEETPAGE hPsp = CreatePrintAdvancedPropSheet(&advanced, dlgTemplate);
     pd.lphPropertyPages = &hPsp;
@@ -671,6 +1080,7 @@ void OnMenuPrint(WindowInfo* win, bool waitForCompletion) {
     }
 
 Exit:
+    DeletePrintPreview(advanced.preview);
     free(ppr);
     GlobalFree(pd.hDevNames);
     GlobalFree(pd.hDevMode);
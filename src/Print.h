@@ -7,3 +7,4 @@ bool PrintFile(EngineBase* engine, WCHAR* printerName = nullptr, bool displayErr
                const WCHAR* settings = nullptr);
 void OnMenuPrint(WindowInfo* win, bool waitForCompletion = false);
 void AbortPrinting(WindowInfo* win);
+void PrewarmPrinterEnumeration();
@@ -0,0 +1,411 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+#include "utils/Dict.h"
+#include "utils/FileUtil.h"
+#include "utils/WinUtil.h"
+
+#include "wingui/WinGui.h"
+#include "wingui/TreeModel.h"
+#include "wingui/Layout.h"
+#include "wingui/Window.h"
+#include "wingui/ListBoxCtrl.h"
+#include "wingui/EditCtrl.h"
+
+#include "SumatraConfig.h"
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "Controller.h"
+#include "FileHistory.h"
+#include "ProgressUpdateUI.h"
+#include "Notifications.h"
+#include "SumatraPDF.h"
+#include "WindowInfo.h"
+#include "QuickOpen.h"
+
+using std::placeholders::_1;
+
+/* Quick open palette (Ctrl+K): type a few letters of a previously opened
+   document's path and pick it from a list instead of digging through the
+   File menu or the start page.
+
+   Matching runs against a prebuilt index of the file history: a case-folded
+   copy of every path plus a map from every trigram of those paths to the
+   entries containing it. For queries of 3+ characters only the entries on
+   the rarest trigram's posting list get the substring scan, so a keystroke
+   stays cheap even with thousands of history entries. Entries where the
+   query merely appears as a subsequence ("spdf" -> "SumatraPDF") rank after
+   the substring matches. Both the index postings and the results keep the
+   history's frequency order, so the documents opened most often come first. */
+
+struct QuickOpenEntry {
+    // owned copies; the history can change while the palette is open
+    WCHAR* path;
+    // case-folded path for matching
+    WCHAR* folded;
+};
+
+struct QuickOpenIndex {
+    // the FileHistory::version this index was built from; the index is
+    // rebuilt when they diverge, which keeps it in sync with history
+    // changes without hooking every mutation site
+    int historyVersion = 0;
+    // in frequency order (see FileHistory::GetFrequencyOrder)
+    Vec<QuickOpenEntry> entries;
+    // trigram -> Vec<int>* of indices into entries, ascending
+    dict::MapWStrToPtr* trigrams = nullptr;
+    // owns the posting lists (the map can't enumerate its values)
+    Vec<Vec<int>*> postings;
+
+    void Rebuild();
+    void Free();
+};
+
+static QuickOpenIndex gQuickOpenIndex;
+
+static WCHAR* FoldCase(const WCHAR* s) {
+    WCHAR* res = str::Dup(s);
+    CharLowerW(res);
+    return res;
+}
+
+void QuickOpenIndex::Free() {
+    for (QuickOpenEntry& e : entries) {
+        free(e.path);
+        free(e.folded);
+    }
+    entries.Reset();
+    DeleteVecMembers(postings);
+    postings.Reset();
+    delete trigrams;
+    trigrams = nullptr;
+}
+
+static void AddTrigram(QuickOpenIndex* idx, const WCHAR* tri, int entryNo) {
+    WCHAR key[4] = {tri[0], tri[1], tri[2], 0};
+    void* val = nullptr;
+    Vec<int>* list;
+    if (idx->trigrams->Get(key, &val)) {
+        list = (Vec<int>*)val;
+        if (list->Last() == entryNo) {
+            // the trigram repeats within this path
+            return;
+        }
+    } else {
+        list = new Vec<int>();
+        idx->postings.Append(list);
+        idx->trigrams->Insert(key, list, nullptr);
+    }
+    list->Append(entryNo);
+}
+
+void QuickOpenIndex::Rebuild() {
+    Free();
+    trigrams = new dict::MapWStrToPtr();
+    Vec<DisplayState*> list;
+    gFileHistory.GetFrequencyOrder(list);
+    for (DisplayState* ds : list) {
+        QuickOpenEntry e;
+        e.path = str::Dup(ds->filePath);
+        e.folded = FoldCase(e.path);
+        int entryNo = entries.isize();
+        size_t len = str::Len(e.folded);
+        for (size_t i = 0; i + 3 <= len; i++) {
+            AddTrigram(this, e.folded + i, entryNo);
+        }
+        entries.Append(e);
+    }
+    historyVersion = gFileHistory.version;
+}
+
+static void EnsureQuickOpenIndex() {
+    if (!gQuickOpenIndex.trigrams || gQuickOpenIndex.historyVersion != gFileHistory.version) {
+        gQuickOpenIndex.Rebuild();
+    }
+}
+
+// is query contained in s with possible gaps ("spdf" in "sumatrapdf")?
+static bool IsSubsequence(const WCHAR* s, const WCHAR* query) {
+    for (; *query; query++) {
+        s = str::FindChar(s, *query);
+        if (!s) {
+            return false;
+        }
+        s++;
+    }
+    return true;
+}
+
+// fills hits with indices into gQuickOpenIndex.entries: substring matches
+// first, subsequence matches after, both in frequency order
+static void FilterQuickOpen(const WCHAR* query, Vec<int>& hits) {
+    QuickOpenIndex* idx = &gQuickOpenIndex;
+    int nEntries = idx->entries.isize();
+    AutoFreeWstr folded(FoldCase(query));
+    size_t len = str::Len(folded);
+    if (0 == len) {
+        for (int i = 0; i < nEntries; i++) {
+            hits.Append(i);
+        }
+        return;
+    }
+
+    // marks entries already reported as substring matches so the
+    // subsequence pass doesn't report them again
+    Vec<bool> isHit;
+    isHit.AppendBlanks(nEntries);
+
+    if (len >= 3) {
+        // every substring match must be on the posting list of each of the
+        // query's trigrams; scanning only the shortest of those lists
+        Vec<int>* candidates = nullptr;
+        for (size_t i = 0; i + 3 <= len; i++) {
+            WCHAR key[4] = {folded[i], folded[i + 1], folded[i + 2], 0};
+            void* val = nullptr;
+            if (!idx->trigrams->Get(key, &val)) {
+                // no path contains this trigram => no substring match at all
+                candidates = nullptr;
+                break;
+            }
+            Vec<int>* list = (Vec<int>*)val;
+            if (!candidates || list->size() < candidates->size()) {
+                candidates = list;
+            }
+        }
+        if (candidates) {
+            for (int i : *candidates) {
+                if (str::Find(idx->entries.at(i).folded, folded)) {
+                    hits.Append(i);
+                    isHit.at(i) = true;
+                }
+            }
+        }
+    } else {
+        // too short for a trigram; the linear scan is still cheap
+        for (int i = 0; i < nEntries; i++) {
+            if (str::Find(idx->entries.at(i).folded, folded)) {
+                hits.Append(i);
+                isHit.at(i) = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < nEntries; i++) {
+        if (!isHit.at(i) && IsSubsequence(idx->entries.at(i).folded, folded)) {
+            hits.Append(i);
+        }
+    }
+}
+
+struct QuickOpenListModel : ListBoxModel {
+    // indices into gQuickOpenIndex.entries
+    Vec<int> hits;
+    str::Str buf;
+
+    ~QuickOpenListModel() override = default;
+    int ItemsCount() override;
+    Size Draw(bool measure) override;
+    std::string_view Item(int) override;
+};
+
+int QuickOpenListModel::ItemsCount() {
+    return hits.isize();
+}
+
+Size QuickOpenListModel::Draw([[maybe_unused]] bool measure) {
+    CrashIf(true);
+    return Size{};
+}
+
+std::string_view QuickOpenListModel::Item(int itemNo) {
+    QuickOpenEntry& e = gQuickOpenIndex.entries.at(hits.at(itemNo));
+    AutoFree path = strconv::WstrToUtf8(e.path);
+    buf.Reset();
+    buf.Append(path.Get(), path.size());
+    return buf.AsView();
+}
+
+struct QuickOpenWindow {
+    // the window the picked document is loaded into
+    WindowInfo* win = nullptr;
+    Window* mainWindow = nullptr;
+    LayoutBase* mainLayout = nullptr;
+
+    EditCtrl* editQuery = nullptr;
+    ListBoxCtrl* listBox = nullptr;
+    QuickOpenListModel* lbModel = nullptr;
+
+    ~QuickOpenWindow();
+};
+
+static QuickOpenWindow* gQuickOpenWindow = nullptr;
+
+QuickOpenWindow::~QuickOpenWindow() {
+    delete mainWindow;
+    delete mainLayout;
+    delete lbModel;
+}
+
+static void WndCloseHandler(QuickOpenWindow* win, WindowCloseEvent* ev) {
+    CrashIf(win->mainWindow != ev->w);
+    gQuickOpenWindow = nullptr;
+    delete win;
+}
+
+static void WndSizeHandler(QuickOpenWindow* win, SizeEvent* ev) {
+    int dx = ev->dx;
+    int dy = ev->dy;
+    HWND hwnd = ev->hwnd;
+    if (dx == 0 || dy == 0) {
+        return;
+    }
+    ev->didHandle = true;
+    InvalidateRect(hwnd, nullptr, false);
+    LayoutToSize(win->mainLayout, {dx, dy});
+}
+
+static void UpdateQuickOpenResults(QuickOpenWindow* win, const WCHAR* query) {
+    win->lbModel->hits.Reset();
+    FilterQuickOpen(query, win->lbModel->hits);
+    win->listBox->UpdateItemsCount();
+    if (win->lbModel->ItemsCount() > 0) {
+        win->listBox->SetCurrentSelection(0);
+    }
+}
+
+static void QueryTextChanged(QuickOpenWindow* win, EditTextChangedEvent* ev) {
+    ev->didHandle = true;
+    AutoFreeWstr query(strconv::Utf8ToWstr(ev->text));
+    UpdateQuickOpenResults(win, query);
+}
+
+static void OpenSelectedDocument(QuickOpenWindow* win) {
+    int sel = win->listBox->GetCurrentSelection();
+    if (sel < 0 || sel >= win->lbModel->ItemsCount()) {
+        return;
+    }
+    // closing the palette deletes win (and a history change could rebuild
+    // the index), so copy everything needed for the load first
+    AutoFreeWstr path(str::Dup(gQuickOpenIndex.entries.at(win->lbModel->hits.at(sel)).path));
+    WindowInfo* target = win->win;
+    win->mainWindow->Close();
+    LoadArgs args(path.Get(), target);
+    LoadDocument(args);
+}
+
+static void QueryKeyHandler(QuickOpenWindow* win, KeyEvent* ev) {
+    if (!ev->isDown) {
+        return;
+    }
+    int dir = 0;
+    switch (ev->keyVirtCode) {
+        case VK_ESCAPE:
+            ev->didHandle = true;
+            win->mainWindow->Close();
+            return;
+        case VK_RETURN:
+            ev->didHandle = true;
+            OpenSelectedDocument(win);
+            return;
+        case VK_DOWN:
+            dir = 1;
+            break;
+        case VK_UP:
+            dir = -1;
+            break;
+        default:
+            return;
+    }
+    ev->didHandle = true;
+    int n = win->lbModel->ItemsCount();
+    if (0 == n) {
+        return;
+    }
+    int sel = limitValue(win->listBox->GetCurrentSelection() + dir, 0, n - 1);
+    win->listBox->SetCurrentSelection(sel);
+}
+
+static void QueryCharHandler([[maybe_unused]] QuickOpenWindow* win, CharEvent* ev) {
+    // already handled in QueryKeyHandler; without this the edit control beeps
+    if (ev->keyCode == VK_RETURN || ev->keyCode == VK_ESCAPE) {
+        ev->didHandle = true;
+    }
+}
+
+static void CreateMainLayout(QuickOpenWindow* win) {
+    HWND parent = win->mainWindow->hwnd;
+    auto vbox = new VBox();
+    vbox->alignMain = MainAxisAlign::MainStart;
+    vbox->alignCross = CrossAxisAlign::Stretch;
+
+    {
+        auto w = new EditCtrl(parent);
+        w->SetCueText("Type a file name");
+        bool ok = w->Create();
+        CrashIf(!ok);
+        w->onTextChanged = std::bind(QueryTextChanged, win, _1);
+        w->onKeyDownUp = std::bind(QueryKeyHandler, win, _1);
+        w->onChar = std::bind(QueryCharHandler, win, _1);
+        win->editQuery = w;
+        vbox->AddChild(w);
+    }
+
+    {
+        auto w = new ListBoxCtrl(parent);
+        w->idealSizeLines = 12;
+        w->SetInsetsPt(4, 0);
+        // owner-data so that a 5000 entry history doesn't copy a string
+        // per path into the control on every keystroke
+        w->isVirtual = true;
+        bool ok = w->Create();
+        CrashIf(!ok);
+        win->lbModel = new QuickOpenListModel();
+        w->SetModel(win->lbModel);
+        win->listBox = w;
+        vbox->AddChild(w);
+    }
+
+    auto padding = new Padding(vbox, DpiScaledInsets(parent, 4, 8));
+    win->mainLayout = padding;
+}
+
+void ShowQuickOpen(WindowInfo* win) {
+    if (!HasPermission(Perm_DiskAccess)) {
+        return;
+    }
+    EnsureQuickOpenIndex();
+    if (gQuickOpenWindow) {
+        gQuickOpenWindow->win = win;
+        BringWindowToTop(gQuickOpenWindow->mainWindow->hwnd);
+        SetFocus(gQuickOpenWindow->editQuery->hwnd);
+        return;
+    }
+
+    auto* qw = new QuickOpenWindow();
+    qw->win = win;
+    auto mainWindow = new Window();
+    HMODULE h = GetModuleHandleW(nullptr);
+    WCHAR* iconName = MAKEINTRESOURCEW(GetAppIconID());
+    mainWindow->hIcon = LoadIconW(h, iconName);
+    mainWindow->backgroundColor = MkRgb((u8)0xee, (u8)0xee, (u8)0xee);
+    mainWindow->SetText(L"Quick Open");
+    bool ok = mainWindow->Create();
+    CrashIf(!ok);
+    mainWindow->onClose = std::bind(WndCloseHandler, qw, _1);
+    mainWindow->onSize = std::bind(WndSizeHandler, qw, _1);
+
+    qw->mainWindow = mainWindow;
+    CreateMainLayout(qw);
+    // show the full history, most frequently opened first
+    UpdateQuickOpenResults(qw, L"");
+
+    LayoutAndSizeToContent(qw->mainLayout, 480, 0, mainWindow->hwnd);
+    CenterDialog(mainWindow->hwnd, win->hwndFrame);
+
+    gQuickOpenWindow = qw;
+    // important to call this after hooking up onSize to ensure
+    // first layout is triggered
+    mainWindow->SetIsVisible(true);
+    SetFocus(qw->editQuery->hwnd);
+}
@@ -0,0 +1,4 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+void ShowQuickOpen(WindowInfo* win);
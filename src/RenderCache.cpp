@@ -4,20 +4,28 @@
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
 #include "utils/WinUtil.h"
+#include "utils/ThreadUtil.h"
 #include "utils/Timer.h"
+#include "utils/EtwTrace.h"
+#include "utils/MemAccounting.h"
+
+#include <zlib.h>
 
 #include "wingui/TreeModel.h"
 
 #include "Annotation.h"
 #include "EngineBase.h"
 #include "EngineCreate.h"
+#include "DibPool.h"
 #include "DisplayMode.h"
 #include "SettingsStructs.h"
 #include "Controller.h"
 #include "DisplayModel.h"
 #include "GlobalPrefs.h"
+#include "MemoryPolicy.h"
 #include "RenderCache.h"
 #include "TextSelection.h"
+#include "TileDiskCache.h"
 
 #include "utils/Log.h"
 #define NO_LOG
@@ -44,18 +52,40 @@ RenderCache::RenderCache() : maxTileSize({GetSystemMetrics(SM_CXSCREEN), GetSyst
     InitializeCriticalSection(&cacheAccess);
     InitializeCriticalSection(&requestAccess);
 
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    // leave one core for the UI thread; rendering more pages at once
+    // than there are cores only adds contention
+    threadCount = limitValue((int)si.dwNumberOfProcessors - 1, 1, MAX_RENDER_THREADS);
+    if (isRemoteSession) {
+        // painting is the bottleneck over RDP, don't waste threads
+        threadCount = 1;
+    }
+
     startRendering = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    renderThread = CreateThread(nullptr, 0, RenderCacheThread, this, 0, 0);
-    CrashIf(nullptr == renderThread);
+    for (int i = 0; i < threadCount; i++) {
+        RenderWorker* w = &workers[i];
+        w->cache = this;
+        w->no = i;
+        w->thread = CreateThread(nullptr, 0, RenderCacheWorkerThread, w, 0, 0);
+        CrashIf(nullptr == w->thread);
+    }
 }
 
 RenderCache::~RenderCache() {
     EnterCriticalSection(&requestAccess);
     EnterCriticalSection(&cacheAccess);
 
-    CloseHandle(renderThread);
+    for (int i = 0; i < threadCount; i++) {
+        CloseHandle(workers[i].thread);
+        CrashIf(curReqs[i]);
+    }
     CloseHandle(startRendering);
-    CrashIf(curReq || 0 != requestCount || 0 != cacheCount);
+    CrashIf(0 != requestCount || 0 != cache.isize());
+    // normally drained by FreeCompressed when the documents closed
+    for (int i = compressed.isize() - 1; i >= 0; i--) {
+        DropCompressedAt(i);
+    }
 
     LeaveCriticalSection(&cacheAccess);
     DeleteCriticalSection(&cacheAccess);
@@ -69,11 +99,12 @@ RenderCache::~RenderCache() {
 BitmapCacheEntry* RenderCache::Find(DisplayModel* dm, int pageNo, int rotation, float zoom, TilePosition* tile) {
     ScopedCritSec scope(&cacheAccess);
     rotation = NormalizeRotation(rotation);
-    for (int i = 0; i < cacheCount; i++) {
-        BitmapCacheEntry* e = cache[i];
+    for (int i = 0; i < cache.isize(); i++) {
+        BitmapCacheEntry* e = cache.at(i);
         if ((dm == e->dm) && (pageNo == e->pageNo) && (rotation == e->rotation) &&
             (INVALID_ZOOM == zoom || zoom == e->zoom) && (!tile || e->tile == *tile)) {
             e->refs++;
+            e->lastUseTimestamp = GetTickCount();
             CrashIf(i != e->cacheIdx);
             return e;
         }
@@ -81,6 +112,77 @@ BitmapCacheEntry* RenderCache::Find(DisplayModel* dm, int pageNo, int rotation,
     return nullptr;
 }
 
+/* Among all cached bitmaps for the tile, find the one whose zoom level is
+   closest to <zoom> - call DropCacheEntry when you no longer need it.
+   Used for scaling a stand-in on screen while the exact zoom level is
+   still rendering (see PaintTile). */
+BitmapCacheEntry* RenderCache::FindNearestZoom(DisplayModel* dm, int pageNo, int rotation, float zoom,
+                                               TilePosition* tile) {
+    ScopedCritSec scope(&cacheAccess);
+    rotation = NormalizeRotation(rotation);
+    BitmapCacheEntry* best = nullptr;
+    float bestFactor = 0;
+    for (int i = 0; i < cache.isize(); i++) {
+        BitmapCacheEntry* e = cache.at(i);
+        if ((dm != e->dm) || (pageNo != e->pageNo) || (rotation != e->rotation) || (tile && !(e->tile == *tile))) {
+            continue;
+        }
+        float factor;
+        if (e->zoom == INVALID_ZOOM) {
+            // entries marked out-of-date by Invalidate et al. still beat
+            // painting nothing, but any real zoom level beats them
+            // (ZOOM_MAX is larger than any real scaling factor)
+            factor = ZOOM_MAX;
+        } else if (e->zoom >= zoom) {
+            // scaling down loses less detail than scaling up, so slightly
+            // prefer a larger rendering over an equally distant smaller one
+            factor = (e->zoom / zoom) * 0.95f;
+        } else {
+            factor = zoom / e->zoom;
+        }
+        if (!best || factor < bestFactor) {
+            best = e;
+            bestFactor = factor;
+        }
+    }
+    if (best) {
+        best->refs++;
+        best->lastUseTimestamp = GetTickCount();
+    }
+    return best;
+}
+
+/* Paints the best cached whole-page bitmap for the page into bounds without
+   ever requesting a render (used by the scrollbar hover preview, which must
+   stay cheap while scrubbing). Returns false if the cache has nothing usable;
+   the caller then paints a placeholder. */
+bool RenderCache::PaintCachedPreview(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo) {
+    BitmapCacheEntry* best = nullptr;
+    {
+        ScopedCritSec scope(&cacheAccess);
+        for (int i = 0; i < cache.isize(); i++) {
+            BitmapCacheEntry* e = cache.at(i);
+            if ((dm != e->dm) || (pageNo != e->pageNo) || !e->bitmap || (0 != e->tile.res)) {
+                continue;
+            }
+            // the smallest bitmap downscales the fastest and any cached
+            // rendering is plenty for a thumbnail-sized popup
+            if (!best || e->sizeInBytes < best->sizeInBytes) {
+                best = e;
+            }
+        }
+        if (!best) {
+            return false;
+        }
+        best->refs++;
+        best->lastUseTimestamp = GetTickCount();
+    }
+    SetStretchBltMode(hdc, HALFTONE);
+    bool ok = best->bitmap->StretchDIBits(hdc, bounds);
+    DropCacheEntry(best);
+    return ok;
+}
+
 bool RenderCache::Exists(DisplayModel* dm, int pageNo, int rotation, float zoom, TilePosition* tile) {
     BitmapCacheEntry* entry = Find(dm, pageNo, rotation, zoom, tile);
     if (entry) {
@@ -97,8 +199,8 @@ bool RenderCache::DropCacheEntry(BitmapCacheEntry* entry) {
     }
     int idx = entry->cacheIdx;
     CrashIf(idx < 0);
-    CrashIf(idx >= cacheCount);
-    if ((idx < 0) || (idx >= cacheCount)) {
+    CrashIf(idx >= cache.isize());
+    if ((idx < 0) || (idx >= cache.isize())) {
         return false;
     }
     CrashIf(entry->refs <= 0);
@@ -107,80 +209,359 @@ bool RenderCache::DropCacheEntry(BitmapCacheEntry* entry) {
         return false;
     }
     CrashIf(entry->refs != 0);
-    CrashIf(cache[idx] != entry);
+    CrashIf(cache.at(idx) != entry);
     dbglogf("RenderCache::DropCacheEntry: pageNo: %d, rotation: %d, zoom: %.2f\n", entry->pageNo, entry->rotation,
             entry->zoom);
 
+    cacheSizeInBytes -= entry->sizeInBytes;
+    CrashIf(cacheSizeInBytes < 0);
+    memacct::Add(memacct::SubsysRenderCache, -entry->sizeInBytes);
     delete entry;
 
     // fast removal by replacing freed item with the item at the end
-    cache[idx] = nullptr;
-    int lastIdx = cacheCount - 1;
-    if ((lastIdx >= 0) && (idx != lastIdx)) {
-        cache[idx] = cache[lastIdx];
-        cache[idx]->cacheIdx = idx;
-        cache[lastIdx] = nullptr;
-    }
-    cacheCount--;
-    CrashIf(cacheCount < 0);
+    cache.RemoveAtFast((size_t)idx);
+    if (idx < cache.isize()) {
+        cache.at(idx)->cacheIdx = idx;
+    }
     return true;
 }
 
-static bool FreeIfFull(RenderCache* rc, const PageRenderRequest& req) {
-    int n = rc->cacheCount;
-    if (n < MAX_BITMAPS_CACHED) {
-        return true;
+// the byte budgets of both cache tiers come from the central memory
+// policy, which also dials them down while the system is low on memory
+static i64 GetMaxCacheSizeInBytes() {
+    return GetMemoryPolicy().renderCacheBudget;
+}
+
+static i64 GetMaxCompressedCacheSizeInBytes() {
+    return GetMemoryPolicy().compressedCacheBudget;
+}
+
+// rendered bitmaps are 32-bit DIBs
+static i64 BitmapSizeInBytes(RenderedBitmap* bmp) {
+    if (!bmp) {
+        return 0;
     }
+    Size s = bmp->Size();
+    return (i64)s.dx * s.dy * 4;
+}
 
-    DisplayModel* dm = req.dm;
-    // free an invisible page of the same DisplayModel ...
-    for (int i = 0; i < n; i++) {
-        auto entry = rc->cache[i];
-        if (entry->dm == dm && !dm->PageVisibleNearby(entry->pageNo)) {
-            bool didDrop = rc->DropCacheEntry(entry);
-            if (didDrop) {
-                return true;
-            }
-        }
+static int cmpCacheEntryLastUse(const void* a, const void* b) {
+    const BitmapCacheEntry* ea = *(BitmapCacheEntry**)a;
+    const BitmapCacheEntry* eb = *(BitmapCacheEntry**)b;
+    if (ea->lastUseTimestamp == eb->lastUseTimestamp) {
+        return 0;
+    }
+    return ea->lastUseTimestamp < eb->lastUseTimestamp ? -1 : 1;
+}
+
+/* Make room for another <bmpBytes> bytes by evicting the least recently
+   used entries. Pages visible (or nearby) in req's DisplayModel are never
+   evicted as that leads to flicker. The pixels of everything evicted are
+   snapshotted into <evicted> so that the caller can compress them into
+   the second tier once cacheAccess has been released. */
+static void FreeToFitBudget(RenderCache* rc, const PageRenderRequest& req, i64 bmpBytes,
+                            Vec<CompressedCacheEntry*>& evicted) {
+    i64 maxBytes = GetMaxCacheSizeInBytes();
+    if (rc->cacheSizeInBytes + bmpBytes <= maxBytes) {
+        return;
     }
 
-    // ... or just the oldest cached page
-    for (int i = 0; i < n; i++) {
-        auto entry = rc->cache[i];
-        if (entry->dm == dm) {
-            // don't free pages from the document we're currently displaying
-            // as it leads to flicker
-            // TODO: it can still flicker if the dm is from a visible tab
+    DisplayModel* dm = req.dm;
+    Vec<BitmapCacheEntry*> candidates;
+    for (int i = 0; i < rc->cache.isize(); i++) {
+        auto entry = rc->cache.at(i);
+        if (entry->dm == dm && dm->PageVisibleNearby(entry->pageNo)) {
+            // don't free pages near the visible ones of the document
+            // we're rendering for as that leads to flicker
+            // TODO: it can still flicker if another dm is from a visible tab
             // in a different window, but it's harder to detect
             continue;
         }
-        bool didDrop = rc->DropCacheEntry(entry);
-        if (didDrop) {
-            return true;
+        candidates.Append(entry);
+    }
+    candidates.Sort(cmpCacheEntryLastUse);
+
+    for (int i = 0; i < candidates.isize(); i++) {
+        if (rc->cacheSizeInBytes + bmpBytes <= maxBytes) {
+            return;
         }
+        CompressedCacheEntry* snapshot = rc->SnapshotForCompression(candidates.at(i));
+        if (snapshot) {
+            evicted.Append(snapshot);
+        }
+        // DropCacheEntry only frees the entry once no painter references it
+        rc->DropCacheEntry(candidates.at(i));
     }
-    return false;
 }
 
 void RenderCache::Add(PageRenderRequest& req, RenderedBitmap* bmp) {
+    Vec<CompressedCacheEntry*> evicted;
+    {
+        ScopedCritSec scope(&cacheAccess);
+        CrashIf(!req.dm);
+
+        req.rotation = NormalizeRotation(req.rotation);
+
+        /* It's possible there still are cached bitmaps with different zoom/rotation;
+           keep the most recently used zoom levels around as scaling stand-ins */
+        TrimZoomLevels(req.dm, req.pageNo, req.tile, req.zoom, req.rotation);
+
+        i64 bmpBytes = BitmapSizeInBytes(bmp);
+        FreeToFitBudget(this, req, bmpBytes, evicted);
+
+        // Copy the PageRenderRequest as it will be reused
+        auto entry = new BitmapCacheEntry(req.dm, req.pageNo, req.rotation, req.zoom, req.tile, bmp);
+        entry->sizeInBytes = bmpBytes;
+        entry->lastUseTimestamp = GetTickCount();
+        entry->reducedQuality = req.reducedQuality;
+        entry->cacheIdx = cache.isize();
+        cache.Append(entry);
+        cacheSizeInBytes += bmpBytes;
+        memacct::Add(memacct::SubsysRenderCache, bmpBytes);
+    }
+    // deflating the evicted bitmaps happens after cacheAccess has been
+    // released, so that painting isn't blocked while they compress
+    CompressAndStore(evicted);
+}
+
+/* Copies the pixels of an entry's bitmap before it's evicted; deflating
+   them happens outside cacheAccess (see CompressAndStore), only the copy
+   is cheap enough to do under the lock. Out-of-date and reduced quality
+   renderings aren't worth keeping around (the latter would come back
+   posing as full-quality ones). */
+CompressedCacheEntry* RenderCache::SnapshotForCompression(BitmapCacheEntry* entry) {
+    RenderedBitmap* bmp = entry->bitmap;
+    if (!bmp || entry->outOfDate || entry->reducedQuality || entry->zoom == INVALID_ZOOM) {
+        return nullptr;
+    }
+    Size s = bmp->Size();
+    i64 len = (i64)s.dx * s.dy * 4;
+    if (len <= 0) {
+        return nullptr;
+    }
+    u8* data = AllocArray<u8>((size_t)len);
+    if (!data) {
+        return nullptr;
+    }
+    BITMAPINFO bmi = {0};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = s.dx;
+    bmi.bmiHeader.biHeight = s.dy;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    HDC hdc = CreateCompatibleDC(nullptr);
+    int ok = GetDIBits(hdc, bmp->GetBitmap(), 0, s.dy, data, &bmi, DIB_RGB_COLORS);
+    DeleteDC(hdc);
+    if (!ok) {
+        free(data);
+        return nullptr;
+    }
+
+    auto res = new CompressedCacheEntry();
+    res->dm = entry->dm;
+    res->pageNo = entry->pageNo;
+    res->rotation = entry->rotation;
+    res->zoom = entry->zoom;
+    res->tile = entry->tile;
+    res->size = s;
+    // still the raw pixels at this point
+    res->data = data;
+    res->dataLen = len;
+    res->lastUseTimestamp = entry->lastUseTimestamp;
+    return res;
+}
+
+// must be called while holding cacheAccess
+void RenderCache::DropCompressedAt(int idx) {
+    CompressedCacheEntry* entry = compressed.at(idx);
+    compressedSizeInBytes -= entry->dataLen;
+    CrashIf(compressedSizeInBytes < 0);
+    memacct::Add(memacct::SubsysRenderCache, -entry->dataLen);
+    free(entry->data);
+    delete entry;
+    compressed.RemoveAtFast((size_t)idx);
+}
+
+/* Deflates the snapshots taken while evicting and files them into the
+   compressed tier. */
+void RenderCache::CompressAndStore(Vec<CompressedCacheEntry*>& pending) {
+    for (CompressedCacheEntry* entry : pending) {
+        uLongf destLen = compressBound((uLong)entry->dataLen);
+        u8* dest = AllocArray<u8>(destLen);
+        if (!dest) {
+            free(entry->data);
+            delete entry;
+            continue;
+        }
+        // Z_BEST_SPEED: the point is dodging a re-render, not the ratio
+        int res = compress2(dest, &destLen, entry->data, (uLong)entry->dataLen, Z_BEST_SPEED);
+        free(entry->data);
+        if (res != Z_OK) {
+            free(dest);
+            delete entry;
+            continue;
+        }
+        entry->data = dest;
+        entry->dataLen = (i64)destLen;
+        StoreCompressed(entry);
+    }
+    pending.Reset();
+}
+
+/* Files a ready-deflated entry into the compressed tier, replacing older
+   renderings of the same tile and evicting the least recently used
+   entries past the tier's budget. Takes ownership of the entry. */
+void RenderCache::StoreCompressed(CompressedCacheEntry* entry) {
+    i64 maxBytes = GetMaxCompressedCacheSizeInBytes();
+    if (entry->dataLen > maxBytes) {
+        free(entry->data);
+        delete entry;
+        return;
+    }
+
     ScopedCritSec scope(&cacheAccess);
-    CrashIf(!req.dm);
+    // an older rendering of the same tile is now useless
+    for (int i = compressed.isize() - 1; i >= 0; i--) {
+        CompressedCacheEntry* e = compressed.at(i);
+        if (e->dm == entry->dm && e->pageNo == entry->pageNo && e->rotation == entry->rotation &&
+            e->zoom == entry->zoom && e->tile == entry->tile) {
+            DropCompressedAt(i);
+        }
+    }
+    while (compressedSizeInBytes + entry->dataLen > maxBytes && compressed.isize() > 0) {
+        // evict the least recently used entry (DropCompressedAt
+        // reorders the Vec, so a one-time sort wouldn't survive)
+        int oldest = 0;
+        for (int i = 1; i < compressed.isize(); i++) {
+            if (compressed.at(i)->lastUseTimestamp < compressed.at(oldest)->lastUseTimestamp) {
+                oldest = i;
+            }
+        }
+        DropCompressedAt(oldest);
+    }
+    compressed.Append(entry);
+    compressedSizeInBytes += entry->dataLen;
+    memacct::Add(memacct::SubsysRenderCache, entry->dataLen);
+}
+
+/* Takes a matching entry out of the compressed tier and inflates it back
+   into a bitmap; returns nullptr if there is none. The entry is consumed:
+   the bitmap re-enters the first tier and gets compressed again on its
+   next eviction. */
+RenderedBitmap* RenderCache::ReloadCompressed(PageRenderRequest& req) {
+    CompressedCacheEntry* found = nullptr;
+    {
+        ScopedCritSec scope(&cacheAccess);
+        int rotation = NormalizeRotation(req.rotation);
+        for (int i = 0; i < compressed.isize(); i++) {
+            CompressedCacheEntry* e = compressed.at(i);
+            if (e->dm == req.dm && e->pageNo == req.pageNo && e->rotation == rotation && e->zoom == req.zoom &&
+                e->tile == req.tile) {
+                found = e;
+                compressed.RemoveAtFast((size_t)i);
+                compressedSizeInBytes -= e->dataLen;
+                memacct::Add(memacct::SubsysRenderCache, -e->dataLen);
+                break;
+            }
+        }
+    }
+    if (!found) {
+        return nullptr;
+    }
 
-    req.rotation = NormalizeRotation(req.rotation);
-    CrashIf(cacheCount > MAX_BITMAPS_CACHED);
+    // inflate directly into a DIB section, outside of cacheAccess
+    Size s = found->size;
+    BITMAPINFO bmi = {0};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = s.dx;
+    bmi.bmiHeader.biHeight = s.dy;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HBITMAP hbmp = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!hbmp) {
+        free(found->data);
+        delete found;
+        return nullptr;
+    }
+    uLongf pixelLen = (uLongf)((i64)s.dx * s.dy * 4);
+    uLongf destLen = pixelLen;
+    int res = uncompress((Bytef*)bits, &destLen, found->data, (uLong)found->dataLen);
+    free(found->data);
+    delete found;
+    if (res != Z_OK || destLen != pixelLen) {
+        DeleteObject(hbmp);
+        return nullptr;
+    }
+    return new RenderedBitmap(hbmp, s);
+}
 
-    /* It's possible there still is a cached bitmap with different zoom/rotation */
-    FreePage(req.dm, req.pageNo, &req.tile);
+/* Drops compressed entries the same way FreePage drops bitmaps; called
+   when a document closes or a page's content changes. */
+void RenderCache::FreeCompressed(DisplayModel* dm, int pageNo) {
+    ScopedCritSec scope(&cacheAccess);
+    for (int i = compressed.isize() - 1; i >= 0; i--) {
+        CompressedCacheEntry* e = compressed.at(i);
+        if (e->dm == dm && (pageNo == INVALID_PAGE_NO || e->pageNo == pageNo)) {
+            DropCompressedAt(i);
+        }
+    }
+}
 
-    bool hasSpace = FreeIfFull(this, req);
-    CrashIf(!hasSpace); // TODO: FreeIfFull() might actually fail to free
-    CrashIf(cacheCount > MAX_BITMAPS_CACHED);
+/* Merges the on-disk tile cache for dm's document into the compressed
+   tier before the first of dm's pages renders. Runs on the render
+   threads (see RenderCacheWorkerThread) so the file read doesn't block
+   painting. */
+void RenderCache::EnsureDiskTilesLoaded(DisplayModel* dm) {
+    if (!gGlobalPrefs->enableTileDiskCache) {
+        return;
+    }
+    {
+        ScopedCritSec scope(&cacheAccess);
+        if (diskTilesLoaded.Contains(dm)) {
+            return;
+        }
+        diskTilesLoaded.Append(dm);
+    }
+    Vec<CompressedCacheEntry*> entries;
+    LoadTileDiskCache(dm->GetEngine()->FileName(), dm, entries);
+    for (CompressedCacheEntry* entry : entries) {
+        StoreCompressed(entry);
+    }
+}
 
-    // Copy the PageRenderRequest as it will be reused
-    auto entry = new BitmapCacheEntry(req.dm, req.pageNo, req.rotation, req.zoom, req.tile, bmp);
-    entry->cacheIdx = cacheCount;
-    cache[cacheCount] = entry;
-    cacheCount++;
+/* Persists dm's compressed tiles for the next session; called when the
+   document closes, before FreeCompressed would throw them away. The
+   entries are detached under cacheAccess and written afterwards so the
+   file write doesn't block painting of other documents. */
+void RenderCache::SaveDiskTiles(DisplayModel* dm) {
+    if (!gGlobalPrefs->enableTileDiskCache) {
+        return;
+    }
+    Vec<CompressedCacheEntry*> entries;
+    {
+        ScopedCritSec scope(&cacheAccess);
+        diskTilesLoaded.Remove(dm);
+        for (int i = compressed.isize() - 1; i >= 0; i--) {
+            CompressedCacheEntry* e = compressed.at(i);
+            if (e->dm != dm) {
+                continue;
+            }
+            entries.Append(e);
+            compressedSizeInBytes -= e->dataLen;
+            memacct::Add(memacct::SubsysRenderCache, -e->dataLen);
+            compressed.RemoveAtFast((size_t)i);
+        }
+    }
+    if (entries.isize() > 0) {
+        SaveTileDiskCache(dm->GetEngine()->FileName(), entries);
+    }
+    for (CompressedCacheEntry* e : entries) {
+        free(e->data);
+        delete e;
+    }
 }
 
 static RectF GetTileRect(RectF pagerect, TilePosition tile) {
@@ -244,8 +625,8 @@ void RenderCache::FreePage(DisplayModel* dm, int pageNo, TilePosition* tile) {
     ScopedCritSec scope(&cacheAccess);
 
     // must go from end becaues freeing changes the cache
-    for (int i = cacheCount - 1; i >= 0; i--) {
-        BitmapCacheEntry* entry = cache[i];
+    for (int i = cache.isize() - 1; i >= 0; i--) {
+        BitmapCacheEntry* entry = cache.at(i);
         bool shouldFree;
         if (dm && pageNo != INVALID_PAGE_NO) {
             // a specific page
@@ -274,24 +655,83 @@ void RenderCache::FreePage(DisplayModel* dm, int pageNo, TilePosition* tile) {
     }
 }
 
+/* Drop all cached bitmaps for the tile that are of no more use once a
+   rendering at <newZoom>/<newRotation> has been added: the level being
+   replaced, out-of-date content and differently rotated renderings.
+   Of the remaining zoom levels only the most recently used survive, so
+   that every tile keeps a small mip pyramid for PaintTile to scale
+   during a zoom change, without hogging the cache budget. */
+void RenderCache::TrimZoomLevels(DisplayModel* dm, int pageNo, TilePosition tile, float newZoom, int newRotation) {
+    ScopedCritSec scope(&cacheAccess);
+
+    Vec<BitmapCacheEntry*> levels;
+    // must go from end because freeing changes the cache
+    for (int i = cache.isize() - 1; i >= 0; i--) {
+        BitmapCacheEntry* entry = cache.at(i);
+        if (entry->dm != dm || entry->pageNo != pageNo || !(entry->tile == tile)) {
+            continue;
+        }
+        bool stale = entry->zoom == newZoom || entry->zoom == INVALID_ZOOM || entry->rotation != newRotation ||
+                     entry->outOfDate;
+        if (stale) {
+            DropCacheEntry(entry);
+        } else {
+            levels.Append(entry);
+        }
+    }
+    if (levels.isize() < MAX_ZOOM_LEVELS_PER_TILE) {
+        return;
+    }
+    // drop the least recently used levels, leaving room for the
+    // rendering that's about to be added
+    levels.Sort(cmpCacheEntryLastUse);
+    for (int i = 0; i < levels.isize() - (MAX_ZOOM_LEVELS_PER_TILE - 1); i++) {
+        DropCacheEntry(levels.at(i));
+    }
+}
+
 void RenderCache::FreeForDisplayModel(DisplayModel* dm) {
     FreePage(dm);
+    // persist the compressed tier for the next session before dropping
+    // whatever SaveDiskTiles didn't detach
+    SaveDiskTiles(dm);
+    FreeCompressed(dm);
 }
 
 void RenderCache::FreeNotVisible() {
     FreePage();
 }
 
-// keep the cached bitmaps for visible pages to avoid flickering during a reload.
-// mark invisible pages as out-of-date to prevent inconsistencies
+// keep the cached bitmaps for visible pages to avoid flickering during a
+// reload, and for pages that look unchanged in the new engine (same page
+// still exists with the same mediabox), so that scrolling right after an
+// auto-reload doesn't re-render the whole document. everything kept is
+// marked out-of-date so it's re-rendered eventually; entries for changed
+// pages stay with oldDm and are freed when it's deleted
 void RenderCache::KeepForDisplayModel(DisplayModel* oldDm, DisplayModel* newDm) {
     ScopedCritSec scope(&cacheAccess);
-    for (int i = 0; i < cacheCount; i++) {
-        BitmapCacheEntry* entry = cache[i];
+    // compressed entries can't be marked out-of-date, so don't carry
+    // them over to the new engine (their disk copy is invalidated by
+    // the changed file modification time)
+    FreeCompressed(oldDm);
+    diskTilesLoaded.Remove(oldDm);
+    EngineBase* oldEngine = oldDm->GetEngine();
+    EngineBase* newEngine = newDm->GetEngine();
+    int newPageCount = newEngine->PageCount();
+    for (int i = 0; i < cache.isize(); i++) {
+        BitmapCacheEntry* entry = cache.at(i);
         if (entry->dm != oldDm) {
             continue;
         }
-        if (oldDm->PageVisible(entry->pageNo)) {
+        int pageNo = entry->pageNo;
+        bool pageUnchanged = false;
+        if (oldDm != newDm && pageNo <= newPageCount) {
+            // the mediabox is the best per-page change signal the engines
+            // expose; a false positive only means the stale bitmap shows
+            // until the out-of-date re-render replaces it
+            pageUnchanged = oldEngine->PageMediabox(pageNo) == newEngine->PageMediabox(pageNo);
+        }
+        if (pageUnchanged || oldDm->PageVisible(pageNo)) {
             entry->dm = newDm;
         }
         // make sure that the page is rerendered eventually
@@ -305,20 +745,145 @@ void RenderCache::Invalidate(DisplayModel* dm, int pageNo, RectF rect) {
     ScopedCritSec scopeReq(&requestAccess);
 
     ClearQueueForDisplayModel(dm, pageNo);
-    if (curReq && curReq->dm == dm && curReq->pageNo == pageNo) {
-        AbortCurrentRequest();
-    }
+    AbortInFlightRequests(dm, pageNo);
 
     ScopedCritSec scopeCache(&cacheAccess);
 
     RectF mediabox = dm->GetEngine()->PageMediabox(pageNo);
-    for (int i = 0; i < cacheCount; i++) {
-        auto e = cache[i];
+    for (int i = 0; i < cache.isize(); i++) {
+        auto e = cache.at(i);
         if (e->dm == dm && e->pageNo == pageNo && !GetTileRect(mediabox, e->tile).Intersect(rect).IsEmpty()) {
             e->zoom = INVALID_ZOOM;
             e->outOfDate = true;
         }
     }
+    // compressed copies of the page predate the change as well
+    FreeCompressed(dm, pageNo);
+}
+
+// patches all cached bitmaps from the previous theme colors to the current
+// textColor/backgroundColor in place, so that a theme or dark-mode switch
+// repaints instantly from the cache instead of a multi-second white-out;
+// the caller re-requests exact renders which trickle in behind
+void RenderCache::RecolorAll(COLORREF fromText, COLORREF fromBg) {
+    ScopedCritSec scope(&cacheAccess);
+    for (int i = 0; i < cache.isize(); i++) {
+        BitmapCacheEntry* entry = cache.at(i);
+        // images are rendered in their original colors (cf. RenderCacheWorkerThread)
+        if (!entry->bitmap || entry->dm->GetEngine()->IsImageCollection()) {
+            continue;
+        }
+        RemapBitmapColors(entry->bitmap->GetBitmap(), fromText, fromBg, textColor, backgroundColor);
+    }
+    // the compressed tier stores deflated pixels; patching those would mean
+    // inflating and re-deflating everything, so drop them and let the
+    // re-renders refill the tier
+    while (compressed.isize() > 0) {
+        DropCompressedAt(0);
+    }
+}
+
+/* Rotates a 32-bit rendering by <quarters> * 90 degrees clockwise into a
+   fresh DIB section from the pool. The copy runs in 64x64 pixel blocks so
+   that both the row-major reads and the column-major writes of a block
+   stay within cached lines (a naive loop misses on every write for large
+   bitmaps); the inner loops are simple enough for the compiler to
+   vectorize. Returns nullptr if the bitmap's bits aren't accessible (not
+   a 32-bit DIB section) or the pool is out of GDI handles. */
+static RenderedBitmap* RotateBitmapQuarters(RenderedBitmap* bmp, int quarters) {
+    CrashIf(quarters < 1 || quarters > 3);
+    DIBSECTION info{};
+    int ret = GetObject(bmp->GetBitmap(), sizeof(info), &info);
+    if (ret < (int)sizeof(info) || !info.dsBm.bmBits || 32 != info.dsBm.bmBitsPixel ||
+        info.dsBm.bmWidth * 4 != info.dsBm.bmWidthBytes) {
+        return nullptr;
+    }
+    int dx = info.dsBm.bmWidth;
+    int dy = info.dsBm.bmHeight;
+    // pool sections are top-down, bitmaps from other sources may not be
+    bool topDown = info.dsBmih.biHeight < 0;
+    int ddx = (2 == quarters) ? dx : dy;
+    int ddy = (2 == quarters) ? dy : dx;
+    void* destData = nullptr;
+    HBITMAP destBmp = DibPoolAcquire(ddx, ddy, &destData);
+    if (!destBmp) {
+        return nullptr;
+    }
+    const u32* src = (const u32*)info.dsBm.bmBits;
+    u32* dst = (u32*)destData;
+    constexpr int kBlockDim = 64; // two 64 * 64 * 4 byte blocks fit in L1
+    for (int by = 0; by < dy; by += kBlockDim) {
+        int yMax = std::min(by + kBlockDim, dy);
+        for (int bx = 0; bx < dx; bx += kBlockDim) {
+            int xMax = std::min(bx + kBlockDim, dx);
+            for (int y = by; y < yMax; y++) {
+                const u32* srcRow = src + (size_t)(topDown ? y : dy - 1 - y) * dx;
+                if (1 == quarters) {
+                    // clockwise: (x, y) -> (row x, column dy-1-y)
+                    u32* dstCol = dst + (size_t)(dy - 1 - y);
+                    for (int x = bx; x < xMax; x++) {
+                        dstCol[(size_t)x * ddx] = srcRow[x];
+                    }
+                } else if (2 == quarters) {
+                    u32* dstRow = dst + (size_t)(dy - 1 - y) * ddx;
+                    for (int x = bx; x < xMax; x++) {
+                        dstRow[dx - 1 - x] = srcRow[x];
+                    }
+                } else {
+                    // counter-clockwise: (x, y) -> (row dx-1-x, column y)
+                    u32* dstCol = dst + (size_t)y;
+                    for (int x = bx; x < xMax; x++) {
+                        dstCol[(size_t)(dx - 1 - x) * ddx] = srcRow[x];
+                    }
+                }
+            }
+        }
+    }
+    // the pool keeps the section's mapping handle, same as for rendered pages
+    return new RenderedBitmap(destBmp, Size(ddx, ddy));
+}
+
+/* Re-tags all cached bitmaps of <dm> for <newRotation>, rotating their
+   pixels along, so that rotating the view repaints instantly from the
+   cache instead of blanking every page until its re-render arrives (for
+   scanned documents fixing the orientation is a routine operation).
+   Everything rotated is marked out-of-date, so the exact renderings
+   trickle in behind, same as after a theme switch (see RecolorAll).
+   Tiled renderings are dropped instead of rotated: the tile grid changes
+   its orientation along with the page. */
+void RenderCache::RotateForDisplayModel(DisplayModel* dm, int newRotation) {
+    newRotation = NormalizeRotation(newRotation);
+    ScopedCritSec scope(&cacheAccess);
+    // must go from end because dropping changes the cache
+    for (int i = cache.isize() - 1; i >= 0; i--) {
+        BitmapCacheEntry* entry = cache.at(i);
+        if (entry->dm != dm) {
+            continue;
+        }
+        int quarters = NormalizeRotation(newRotation - entry->rotation) / 90;
+        if (0 == quarters) {
+            // e.g. a rendering that finished after the rotation
+            continue;
+        }
+        RenderedBitmap* rotated = nullptr;
+        if (0 == entry->tile.res && entry->bitmap) {
+            rotated = RotateBitmapQuarters(entry->bitmap, quarters);
+        }
+        if (!rotated) {
+            DropCacheEntry(entry);
+            continue;
+        }
+        delete entry->bitmap;
+        entry->bitmap = rotated;
+        entry->rotation = newRotation;
+        // same pixel count, so sizeInBytes stays accurate
+        // make sure that the page is rerendered eventually
+        entry->zoom = INVALID_ZOOM;
+        entry->outOfDate = true;
+    }
+    // the compressed tier keeps its rotation tags: those entries only pay
+    // off again if the user rotates back (checking a sideways page and
+    // returning is common) and age out of their budget otherwise
 }
 
 // determine the count of tiles required for a page at a given zoom level
@@ -358,8 +923,8 @@ USHORT RenderCache::GetTileRes(DisplayModel* dm, int pageNo) {
 USHORT RenderCache::GetMaxTileRes(DisplayModel* dm, int pageNo, int rotation) {
     ScopedCritSec scope(&cacheAccess);
     USHORT maxRes = 0;
-    for (int i = 0; i < cacheCount; i++) {
-        auto e = cache[i];
+    for (int i = 0; i < cache.isize(); i++) {
+        auto e = cache.at(i);
         if (e->dm == dm && e->pageNo == pageNo && e->rotation == rotation) {
             maxRes = std::max(e->tile.res, maxRes);
         }
@@ -384,18 +949,27 @@ bool RenderCache::ReduceTileSize() {
     }
 
     // invalidate all rendered bitmaps and all requests
-    while (cacheCount > 0) {
-        FreeForDisplayModel(cache[0]->dm);
+    while (cache.size() > 0) {
+        FreeForDisplayModel(cache.at(0)->dm);
     }
     while (requestCount > 0) {
         ClearQueueForDisplayModel(requests[0].dm);
     }
-    AbortCurrentRequest();
+    AbortInFlightRequests();
 
     return true;
 }
 
 void RenderCache::RequestRendering(DisplayModel* dm, int pageNo) {
+    {
+        // every user request re-arms whole-document warming for this
+        // document: once the queue runs dry the workers fill the cache
+        // with the remaining pages (see GetNextWarmingRequest)
+        ScopedCritSec scope(&requestAccess);
+        warmingDm = dm;
+        warmingNextPage = 1;
+    }
+
     TilePosition tile(GetTileRes(dm, pageNo), 0, 0);
     // only honor the request if there's a good chance that the
     // rendered tile will actually be used
@@ -415,6 +989,7 @@ void RenderCache::RequestRendering(DisplayModel* dm, int pageNo) {
 /* Render a bitmap for page <pageNo> in <dm>. */
 void RenderCache::RequestRendering(DisplayModel* dm, int pageNo, TilePosition tile, bool clearQueueForPage) {
     dbglogf("RenderCache::RequestRendering(): pageNo %d\n", pageNo);
+    ScopedTraceEvent trc("render-request", pageNo);
     ScopedCritSec scope(&requestAccess);
     CrashIf(!dm);
     if (!dm || dm->dontRenderFlag) {
@@ -424,14 +999,19 @@ void RenderCache::RequestRendering(DisplayModel* dm, int pageNo, TilePosition ti
     int rotation = NormalizeRotation(dm->GetRotation());
     float zoom = dm->GetZoomReal(pageNo);
 
-    if (curReq && (curReq->pageNo == pageNo) && (curReq->dm == dm) && (curReq->tile == tile)) {
+    for (int i = 0; i < threadCount; i++) {
+        PageRenderRequest* curReq = curReqs[i];
+        if (!curReq || (curReq->pageNo != pageNo) || (curReq->dm != dm) || !(curReq->tile == tile)) {
+            continue;
+        }
         if ((curReq->zoom == zoom) && (curReq->rotation == rotation)) {
-            /* we're already rendering exactly the same page */
+            /* a worker is already rendering exactly the same page */
             return;
         }
         /* Currently rendered page is for the same page but with different zoom
         or rotation, so abort it */
-        AbortCurrentRequest();
+        AbortInFlightRequests(dm, pageNo);
+        break;
     }
 
     // clear requests for tiles of different resolution and invisible tiles
@@ -521,10 +1101,27 @@ bool RenderCache::Render(DisplayModel* dm, int pageNo, int rotation, float zoom,
     } else {
         CrashMe();
     }
+    // requests with an explicit pageRect/callback (thumbnails, printing)
+    // use a caller-chosen zoom, so they never go stale with the layout
+    newRequest->generation = renderCb ? 0 : InterlockedAdd(&dm->renderGeneration, 0);
     newRequest->abort = false;
     newRequest->abortCookie = nullptr;
+    newRequest->background = false;
     newRequest->timestamp = GetTickCount();
     newRequest->renderCb = renderCb;
+    newRequest->notifyHwnd = nullptr;
+    newRequest->reducedQuality = false;
+
+    // user requests preempt in-flight warming renders
+    for (int i = 0; i < threadCount; i++) {
+        PageRenderRequest* curReq = curReqs[i];
+        if (curReq && curReq->background) {
+            if (curReq->abortCookie) {
+                curReq->abortCookie->Abort();
+            }
+            curReq->abort = true;
+        }
+    }
 
     SetEvent(startRendering);
 
@@ -534,8 +1131,11 @@ bool RenderCache::Render(DisplayModel* dm, int pageNo, int rotation, float zoom,
 int RenderCache::GetRenderDelay(DisplayModel* dm, int pageNo, TilePosition tile) {
     ScopedCritSec scope(&requestAccess);
 
-    if (curReq && curReq->pageNo == pageNo && curReq->dm == dm && curReq->tile == tile) {
-        return GetTickCount() - curReq->timestamp;
+    for (int i = 0; i < threadCount; i++) {
+        PageRenderRequest* curReq = curReqs[i];
+        if (curReq && curReq->pageNo == pageNo && curReq->dm == dm && curReq->tile == tile) {
+            return GetTickCount() - curReq->timestamp;
+        }
     }
 
     for (int i = 0; i < requestCount; i++) {
@@ -547,30 +1147,334 @@ int RenderCache::GetRenderDelay(DisplayModel* dm, int pageNo, TilePosition tile)
     return RENDER_DELAY_UNDEFINED;
 }
 
-bool RenderCache::GetNextRequest(PageRenderRequest* req) {
+bool RenderCache::GetNextRequest(int workerNo, PageRenderRequest* req) {
     ScopedCritSec scope(&requestAccess);
 
-    if (requestCount == 0) {
-        return false;
-    }
+    for (;;) {
+        if (requestCount == 0) {
+            return false;
+        }
 
-    CrashIf(requestCount < 0);
-    CrashIf(requestCount > MAX_PAGE_REQUESTS);
-    requestCount--;
-    *req = requests[requestCount];
-    curReq = req;
-    CrashIf(requestCount < 0);
+        CrashIf(requestCount < 0);
+        CrashIf(requestCount > MAX_PAGE_REQUESTS);
+        requestCount--;
+        *req = requests[requestCount];
+        CrashIf(requestCount < 0);
+        if (0 == req->generation || req->generation == InterlockedAdd(&req->dm->renderGeneration, 0)) {
+            break;
+        }
+        /* the layout changed since this request was queued (e.g. an
+           intermediate level of a rapid Ctrl+wheel zoom); rendering it
+           would only delay the request for the final level */
+    }
+    curReqs[workerNo] = req;
     CrashIf(req->abort);
 
     return true;
 }
 
-bool RenderCache::ClearCurrentRequest() {
+/* Called when the request queue is empty: synthesize a request for the next
+   page of the warming document that isn't cached yet. This is the lowest
+   priority lane by construction: a worker only gets here when no user
+   requested work is queued and the render is aborted as soon as some is.
+   Warming stops (until the next RequestRendering re-arms it) once the page
+   wouldn't fit the cache's byte budget without evicting other entries. */
+bool RenderCache::GetNextWarmingRequest(int workerNo, PageRenderRequest* req) {
+    ScopedCritSec scope(&requestAccess);
+
+    DisplayModel* dm = warmingDm;
+    if (!dm || dm->dontRenderFlag) {
+        return false;
+    }
+
+    if (!GetMemoryPolicy().allowDocumentWarming) {
+        // pre-rendering the whole document is the opposite of what a
+        // memory-squeezed machine needs
+        warmingDm = nullptr;
+        return false;
+    }
+
+    if (IsPowerSavingActive()) {
+        // ditto for a machine on battery; the next user request re-arms
+        // warming, so it resumes once back on AC
+        warmingDm = nullptr;
+        return false;
+    }
+
+    int rotation = NormalizeRotation(dm->GetRotation());
+    int pageCount = dm->PageCount();
+    while (warmingNextPage <= pageCount) {
+        int pageNo = warmingNextPage++;
+        if (GetTileRes(dm, pageNo) != 0) {
+            // zoomed in far enough that pages are split into tiles;
+            // warming whole pages would blow the budget for little benefit
+            warmingDm = nullptr;
+            return false;
+        }
+        float zoom = dm->GetZoomReal(pageNo);
+        TilePosition tile(0, 0, 0);
+        if (Exists(dm, pageNo, rotation, zoom, &tile)) {
+            continue;
+        }
+
+        // skip pages that are already queued or being rendered
+        bool busy = false;
+        for (int i = 0; i < requestCount && !busy; i++) {
+            busy = requests[i].dm == dm && requests[i].pageNo == pageNo;
+        }
+        for (int i = 0; i < threadCount && !busy; i++) {
+            busy = curReqs[i] && curReqs[i]->dm == dm && curReqs[i]->pageNo == pageNo;
+        }
+        if (busy) {
+            continue;
+        }
+
+        // cacheSizeInBytes is read without cacheAccess; an estimate is
+        // good enough for deciding when to stop filling the cache
+        Rect pixels = GetTileRectDevice(dm->GetEngine(), pageNo, rotation, zoom, tile);
+        i64 bmpBytes = (i64)pixels.dx * pixels.dy * 4;
+        if (cacheSizeInBytes + bmpBytes > GetMaxCacheSizeInBytes()) {
+            warmingDm = nullptr;
+            return false;
+        }
+
+        req->dm = dm;
+        req->pageNo = pageNo;
+        req->rotation = rotation;
+        req->zoom = zoom;
+        req->tile = tile;
+        req->pageRect = GetTileRectUser(dm->GetEngine(), pageNo, rotation, zoom, tile);
+        req->abort = false;
+        req->abortCookie = nullptr;
+        req->background = true;
+        req->timestamp = GetTickCount();
+        req->renderCb = nullptr;
+        req->notifyHwnd = nullptr;
+        req->reducedQuality = false;
+        curReqs[workerNo] = req;
+        return true;
+    }
+
+    // every page is cached (or was at least attempted)
+    warmingDm = nullptr;
+    return false;
+}
+
+bool RenderCache::HasWarmingWork() {
+    ScopedCritSec scope(&requestAccess);
+    return warmingDm != nullptr;
+}
+
+/* Adaptive render quality: true when the queued renders are estimated to
+   take longer than the latency budget (fast scrolling through a heavy
+   document on a slow machine). The worker then renders at a fraction of
+   the requested zoom instead of falling further behind: PaintTile
+   stretches the bitmap to the requested size, so the page shows up
+   blurry but immediately rather than staying white, and the entry gets
+   re-rendered at full quality once the queue runs dry (see
+   GetNextRefinementRequest). */
+bool RenderCache::ShouldReduceQuality(PageRenderRequest& req) {
+    // callback renders go to callers expecting the exact pixels asked
+    // for (printing, thumbnails) and the idle lanes aren't latency
+    // sensitive to begin with
+    if (req.renderCb || req.notifyHwnd || req.background) {
+        return false;
+    }
+    // over RDP every StretchBlt hurts, don't add more of them
+    if (isRemoteSession) {
+        return false;
+    }
+    ScopedCritSec scope(&requestAccess);
+    // avgRenderDurMs is written by the workers without locking; a rough
+    // value is good enough for a heuristic
+    int estWaitMs = requestCount * avgRenderDurMs / threadCount;
+    return estWaitMs > ADAPTIVE_LATENCY_BUDGET_MS;
+}
+
+/* Called when the request queue is empty: pick a reduced quality entry
+   that is still current and synthesize the full-quality render that was
+   skipped while the queue was backed up. The blurry bitmap keeps serving
+   paints until Add() replaces it (TrimZoomLevels drops the old entry as
+   the level being replaced). Like warming, these renders are aborted as
+   soon as a user request comes in; an aborted entry stays marked and is
+   picked up again on the next idle stretch. */
+bool RenderCache::GetNextRefinementRequest(int workerNo, PageRenderRequest* req) {
+    ScopedCritSec scope1(&requestAccess);
+    ScopedCritSec scope2(&cacheAccess);
+
+    for (int i = 0; i < cache.isize(); i++) {
+        BitmapCacheEntry* e = cache.at(i);
+        if (!e->reducedQuality) {
+            continue;
+        }
+        DisplayModel* dm = e->dm;
+        // an entry whose zoom or rotation is no longer current isn't
+        // worth sharpening; the normal eviction paths will get it
+        if (dm->dontRenderFlag || e->zoom != dm->GetZoomReal(e->pageNo) ||
+            e->rotation != NormalizeRotation(dm->GetRotation())) {
+            e->reducedQuality = false;
+            continue;
+        }
+        // skip entries that another worker is already re-rendering
+        bool busy = false;
+        for (int j = 0; j < threadCount && !busy; j++) {
+            PageRenderRequest* curReq = curReqs[j];
+            busy = curReq && curReq->dm == dm && curReq->pageNo == e->pageNo && curReq->tile == e->tile;
+        }
+        if (busy) {
+            continue;
+        }
+
+        req->dm = dm;
+        req->pageNo = e->pageNo;
+        req->rotation = e->rotation;
+        req->zoom = e->zoom;
+        req->tile = e->tile;
+        req->pageRect = GetTileRectUser(dm->GetEngine(), e->pageNo, e->rotation, e->zoom, e->tile);
+        req->abort = false;
+        req->abortCookie = nullptr;
+        req->background = true;
+        req->timestamp = GetTickCount();
+        req->renderCb = nullptr;
+        req->notifyHwnd = nullptr;
+        req->reducedQuality = false;
+        curReqs[workerNo] = req;
+        return true;
+    }
+
+    return false;
+}
+
+bool RenderCache::HasRefinementWork() {
+    ScopedCritSec scope1(&requestAccess);
+    ScopedCritSec scope2(&cacheAccess);
+    for (int i = 0; i < cache.isize(); i++) {
+        BitmapCacheEntry* e = cache.at(i);
+        if (!e->reducedQuality) {
+            continue;
+        }
+        // an entry that's being re-rendered right now doesn't count as
+        // pending work, or an idle worker would spin instead of sleeping
+        bool busy = false;
+        for (int j = 0; j < threadCount && !busy; j++) {
+            PageRenderRequest* curReq = curReqs[j];
+            busy = curReq && curReq->dm == e->dm && curReq->pageNo == e->pageNo && curReq->tile == e->tile;
+        }
+        if (!busy) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the sidebar re-requests on every paint, so the queue only needs to
+// cover the visible rows plus some scrolling ahead
+#define MAX_THUMBNAIL_REQUESTS 32
+
+/* Queue a page for the thumbnails sidebar. The request only gets picked up
+   once no user requested work is pending (see GetNextThumbnailRequest);
+   notifyHwnd is posted UWM_THUMBNAIL_RENDERED when the bitmap can be
+   painted via Find() at the given zoom. */
+void RenderCache::RequestThumbnailRendering(DisplayModel* dm, int pageNo, float zoom, HWND notifyHwnd) {
+    CrashIf(!dm);
+    if (!dm || dm->dontRenderFlag) {
+        return;
+    }
+
+    ScopedCritSec scope(&requestAccess);
+
+    for (auto&& req : thumbRequests) {
+        if (req.dm == dm && req.pageNo == pageNo && req.zoom == zoom) {
+            return;
+        }
+    }
+    // skip pages that a worker is already rendering at this zoom
+    for (int i = 0; i < threadCount; i++) {
+        PageRenderRequest* curReq = curReqs[i];
+        if (curReq && curReq->dm == dm && curReq->pageNo == pageNo && curReq->zoom == zoom) {
+            return;
+        }
+    }
+    if (thumbRequests.isize() >= MAX_THUMBNAIL_REQUESTS) {
+        // drop the oldest request: it's for a row that got scrolled
+        // furthest out of view
+        thumbRequests.RemoveAt(0);
+    }
+
+    ThumbnailRenderRequest req;
+    req.dm = dm;
+    req.pageNo = pageNo;
+    req.zoom = zoom;
+    req.notifyHwnd = notifyHwnd;
+    thumbRequests.Append(req);
+
+    SetEvent(startRendering);
+}
+
+/* Called when the request queue is empty: dequeue the oldest pending
+   thumbnail. Like warming, this lane never competes with user requests
+   and its renders are aborted as soon as one comes in. */
+bool RenderCache::GetNextThumbnailRequest(int workerNo, PageRenderRequest* req) {
     ScopedCritSec scope(&requestAccess);
+
+    while (thumbRequests.size() > 0) {
+        ThumbnailRenderRequest thumbReq = thumbRequests.PopAt(0);
+        DisplayModel* dm = thumbReq.dm;
+        if (dm->dontRenderFlag) {
+            continue;
+        }
+
+        int rotation = NormalizeRotation(dm->GetRotation());
+        TilePosition tile(0, 0, 0);
+        if (Exists(dm, thumbReq.pageNo, rotation, thumbReq.zoom, &tile)) {
+            // rendered while the request was queued; the notification may
+            // be redundant, but the sidebar paints from the cache anyway
+            PostMessageW(thumbReq.notifyHwnd, UWM_THUMBNAIL_RENDERED, (WPARAM)thumbReq.pageNo, 0);
+            continue;
+        }
+
+        req->dm = dm;
+        req->pageNo = thumbReq.pageNo;
+        req->rotation = rotation;
+        req->zoom = thumbReq.zoom;
+        req->tile = tile;
+        req->pageRect = GetTileRectUser(dm->GetEngine(), thumbReq.pageNo, rotation, thumbReq.zoom, tile);
+        req->generation = 0;
+        req->abort = false;
+        req->abortCookie = nullptr;
+        req->background = true;
+        req->timestamp = GetTickCount();
+        req->renderCb = nullptr;
+        req->notifyHwnd = thumbReq.notifyHwnd;
+        req->reducedQuality = false;
+        curReqs[workerNo] = req;
+        return true;
+    }
+
+    return false;
+}
+
+bool RenderCache::HasThumbnailWork() {
+    ScopedCritSec scope(&requestAccess);
+    return thumbRequests.size() > 0;
+}
+
+void RenderCache::ClearThumbnailQueue(DisplayModel* dm) {
+    ScopedCritSec scope(&requestAccess);
+    for (int i = thumbRequests.isize() - 1; i >= 0; i--) {
+        if (!dm || thumbRequests.at(i).dm == dm) {
+            thumbRequests.RemoveAt(i);
+        }
+    }
+}
+
+bool RenderCache::ClearCurrentRequest(int workerNo) {
+    ScopedCritSec scope(&requestAccess);
+    PageRenderRequest* curReq = curReqs[workerNo];
     if (curReq) {
         delete curReq->abortCookie;
     }
-    curReq = nullptr;
+    curReqs[workerNo] = nullptr;
 
     bool isQueueEmpty = requestCount == 0;
     return isQueueEmpty;
@@ -580,18 +1484,35 @@ bool RenderCache::ClearCurrentRequest() {
 /* TODO: this might take some time, would be good to show a dialog to let the
    user know he has to wait until we finish */
 void RenderCache::CancelRendering(DisplayModel* dm) {
+    {
+        ScopedCritSec scope(&requestAccess);
+        if (warmingDm == dm) {
+            warmingDm = nullptr;
+        }
+    }
+    ClearThumbnailQueue(dm);
     ClearQueueForDisplayModel(dm);
 
     for (;;) {
         EnterCriticalSection(&requestAccess);
-        if (!curReq || (curReq->dm != dm)) {
+        bool inFlight = false;
+        for (int i = 0; i < threadCount; i++) {
+            if (curReqs[i] && curReqs[i]->dm == dm) {
+                inFlight = true;
+                break;
+            }
+        }
+        if (!inFlight) {
             // to be on the safe side
             ClearQueueForDisplayModel(dm);
             LeaveCriticalSection(&requestAccess);
+            // nothing references dm's engine anymore, the workers'
+            // clones of it can go as well
+            DropWorkerClones(dm);
             return;
         }
 
-        AbortCurrentRequest();
+        AbortInFlightRequests(dm);
         LeaveCriticalSection(&requestAccess);
 
         /* TODO: busy loop is not good, but I don't have a better idea */
@@ -621,24 +1542,89 @@ void RenderCache::ClearQueueForDisplayModel(DisplayModel* dm, int pageNo, TilePo
     }
 }
 
-void RenderCache::AbortCurrentRequest() {
+void RenderCache::AbortInFlightRequests(DisplayModel* dm, int pageNo) {
     ScopedCritSec scope(&requestAccess);
-    if (!curReq) {
-        return;
+    for (int i = 0; i < threadCount; i++) {
+        PageRenderRequest* req = curReqs[i];
+        if (!req) {
+            continue;
+        }
+        if (dm && req->dm != dm) {
+            continue;
+        }
+        if (pageNo != INVALID_PAGE_NO && req->pageNo != pageNo) {
+            continue;
+        }
+        if (req->abortCookie) {
+            req->abortCookie->Abort();
+        }
+        req->abort = true;
+    }
+}
+
+/* Get the engine to render dm's pages with on worker's thread. With more
+   than one worker we prefer a per-worker clone of the engine, so that
+   concurrent renders don't serialize on the engine's internal lock; if
+   cloning fails we fall back to the shared (internally locked) engine. */
+EngineBase* RenderCache::GetEngineForWorker(RenderWorker* worker, DisplayModel* dm) {
+    if (threadCount == 1) {
+        return dm->GetEngine();
     }
-    if (curReq->abortCookie) {
-        curReq->abortCookie->Abort();
+
+    EnterCriticalSection(&requestAccess);
+    if (worker->engineDm == dm) {
+        EngineBase* engine = worker->engine;
+        LeaveCriticalSection(&requestAccess);
+        return engine ? engine : dm->GetEngine();
+    }
+    EngineBase* prevClone = worker->engine;
+    worker->engine = nullptr;
+    worker->engineDm = nullptr;
+    LeaveCriticalSection(&requestAccess);
+
+    delete prevClone;
+    // cloning effectively re-opens the document, don't hold
+    // requestAccess while that's happening
+    EngineBase* clone = dm->GetEngine()->Clone();
+
+    EnterCriticalSection(&requestAccess);
+    worker->engine = clone;
+    worker->engineDm = dm;
+    LeaveCriticalSection(&requestAccess);
+    return clone ? clone : dm->GetEngine();
+}
+
+/* Free the engine clones the workers keep for dm. Only call this when no
+   request for dm is queued or in flight (a worker only uses its clone
+   while it has an in-flight request for the matching DisplayModel). */
+void RenderCache::DropWorkerClones(DisplayModel* dm) {
+    ScopedCritSec scope(&requestAccess);
+    for (int i = 0; i < threadCount; i++) {
+        RenderWorker* w = &workers[i];
+        if (w->engineDm != dm) {
+            continue;
+        }
+        CrashIf(curReqs[i] && curReqs[i]->dm == dm);
+        delete w->engine;
+        w->engine = nullptr;
+        w->engineDm = nullptr;
     }
-    curReq->abort = true;
 }
 
-DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data) {
-    RenderCache* cache = (RenderCache*)data;
+DWORD WINAPI RenderCache::RenderCacheWorkerThread(LPVOID data) {
+    RenderWorker* worker = (RenderWorker*)data;
+    RenderCache* cache = worker->cache;
     PageRenderRequest req;
     RenderedBitmap* bmp;
 
     for (;;) {
-        if (cache->ClearCurrentRequest()) {
+        bool isQueueEmpty = cache->ClearCurrentRequest(worker->no);
+        // on battery only the first worker serves the idle lanes; the
+        // others sleep until a user request wakes them
+        bool idleLanesOpen = worker->no == 0 || !IsPowerSavingActive();
+        bool hasIdleWork =
+            idleLanesOpen && (cache->HasThumbnailWork() || cache->HasRefinementWork() || cache->HasWarmingWork());
+        if (isQueueEmpty && !hasIdleWork) {
             DWORD waitResult = WaitForSingleObject(cache->startRendering, INFINITE);
             // Is it not a page render request?
             if (WAIT_OBJECT_0 != waitResult) {
@@ -646,11 +1632,21 @@ DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data) {
             }
         }
 
-        if (!cache->GetNextRequest(&req)) {
-            continue;
+        if (!cache->GetNextRequest(worker->no, &req)) {
+            // the queue ran dry: serve the thumbnails sidebar and then
+            // render the next not-yet-cached page of the current document
+            // while the system is idle
+            if (!idleLanesOpen) {
+                continue;
+            }
+            if (!cache->GetNextThumbnailRequest(worker->no, &req) &&
+                !cache->GetNextRefinementRequest(worker->no, &req) &&
+                !cache->GetNextWarmingRequest(worker->no, &req)) {
+                continue;
+            }
         }
 
-        if (!req.dm->PageVisibleNearby(req.pageNo) && !req.renderCb) {
+        if (!req.dm->PageVisibleNearby(req.pageNo) && !req.renderCb && !req.background) {
             continue;
         }
 
@@ -661,6 +1657,27 @@ DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data) {
             continue;
         }
 
+        // a compressed copy of an evicted rendering may still be around,
+        // possibly left on disk by a previous session; inflating it is far
+        // cheaper than rendering the page again (the colors were already
+        // replaced before it was first cached)
+        cache->EnsureDiskTilesLoaded(req.dm);
+        bmp = cache->ReloadCompressed(req);
+        if (bmp) {
+            if (req.renderCb) {
+                // the callback must free the RenderedBitmap
+                req.renderCb->Callback(bmp);
+                req.renderCb = (RenderingCallback*)1;
+            } else {
+                cache->Add(req, bmp);
+                req.dm->RepaintDisplay();
+                if (req.notifyHwnd) {
+                    PostMessageW(req.notifyHwnd, UWM_THUMBNAIL_RENDERED, (WPARAM)req.pageNo, 0);
+                }
+            }
+            continue;
+        }
+
         // make sure that we have extracted page text for
         // all rendered pages to allow text selection and
         // searching without any further delays
@@ -668,15 +1685,39 @@ DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data) {
             req.dm->textCache->GetTextForPage(req.pageNo);
         }
 
+        // the cache entry is keyed at the requested zoom either way, so a
+        // reduced quality rendering gets stretched by PaintTile without
+        // anyone else having to know
+        float renderZoom = req.zoom;
+        if (cache->ShouldReduceQuality(req)) {
+            renderZoom = req.zoom * REDUCED_QUALITY_FACTOR;
+            req.reducedQuality = true;
+        }
+
         CrashIf(req.abortCookie != nullptr);
-        EngineBase* engine = req.dm->GetEngine();
-        RenderPageArgs args(req.pageNo, req.zoom, req.rotation, &req.pageRect, RenderTarget::View, &req.abortCookie);
+        EngineBase* engine = cache->GetEngineForWorker(worker, req.dm);
+        RenderPageArgs args(req.pageNo, renderZoom, req.rotation, &req.pageRect, RenderTarget::View, &req.abortCookie);
+        auto timeStart = TimeGet();
         bmp = engine->RenderPage(args);
+        double durMs = TimeSinceInMs(timeStart);
+        trace::LogScope("render", durMs, req.pageNo);
+        // written without locking; only read by the perf HUD
+        cache->lastRenderDurMs = (int)durMs;
+        if (!req.reducedQuality && !req.notifyHwnd) {
+            // moving average of full-quality page renders for the adaptive
+            // quality heuristic (thumbnails render at the sidebar's tiny
+            // zoom and would drag the average down)
+            cache->avgRenderDurMs = (3 * cache->avgRenderDurMs + (int)durMs) / 4;
+        }
         if (req.abort) {
             delete bmp;
             if (req.renderCb) {
                 req.renderCb->Callback(nullptr);
             }
+            if (req.notifyHwnd) {
+                // the sidebar re-requests the page on its next paint
+                PostMessageW(req.notifyHwnd, UWM_THUMBNAIL_RENDERED, (WPARAM)req.pageNo, 0);
+            }
             continue;
         }
 
@@ -691,6 +1732,9 @@ DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data) {
             }
             cache->Add(req, bmp);
             req.dm->RepaintDisplay();
+            if (req.notifyHwnd) {
+                PostMessageW(req.notifyHwnd, UWM_THUMBNAIL_RENDERED, (WPARAM)req.pageNo, 0);
+            }
         }
     }
 }
@@ -708,7 +1752,7 @@ int RenderCache::PaintTile(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, T
             if (renderedReplacement) {
                 *renderedReplacement = true;
             }
-            entry = Find(dm, pageNo, dm->GetRotation(), INVALID_ZOOM, &tile);
+            entry = FindNearestZoom(dm, pageNo, dm->GetRotation(), zoom, &tile);
         }
         renderDelay = GetRenderDelay(dm, pageNo, tile);
         if (renderMissing && RENDER_DELAY_UNDEFINED == renderDelay && !IsRenderQueueFull()) {
@@ -783,6 +1827,7 @@ static int cmpTilePosition(const void* a, const void* b) {
 int RenderCache::Paint(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, PageInfo* pageInfo,
                        bool* renderOutOfDateCue) {
     CrashIf(!pageInfo->shown || 0.0 == pageInfo->visibleRatio);
+    ScopedTraceEvent trc("paint", pageNo);
 
 #if 0
     auto timeStart = TimeGet();
@@ -818,6 +1863,23 @@ int RenderCache::Paint(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, PageI
         maxRes = targetRes;
     }
 
+    // progressive rendering: when zooming deep into a page there may be
+    // nothing cached to show at all while the full-res tiles render.
+    // Immediately queue a cheap whole-page render at a zoom low enough to
+    // fit a single tile; the paint loop below stretches whatever bitmap
+    // exists for tile res 0, so this shows up as an instant blurry
+    // preview that's replaced as the sharp tiles complete.
+    if (targetRes > 0) {
+        TilePosition tileZero(0, 0, 0);
+        BitmapCacheEntry* entry = Find(dm, pageNo, rotation, INVALID_ZOOM, &tileZero);
+        if (entry) {
+            DropCacheEntry(entry);
+        } else if (RENDER_DELAY_UNDEFINED == GetRenderDelay(dm, pageNo, tileZero) && !IsRenderQueueFull()) {
+            float quickZoom = zoom / (float)(1 << targetRes);
+            Render(dm, pageNo, rotation, quickZoom, &tileZero);
+        }
+    }
+
     Vec<TilePosition> queue;
     queue.Append(TilePosition(0, 0, 0));
     int renderDelayMin = RENDER_DELAY_UNDEFINED;
@@ -7,11 +7,29 @@ constexpr int RENDER_DELAY_UNDEFINED = std::numeric_limits<int>::max() - 2;
 #define INVALID_TILE_RES ((USHORT)-1)
 
 #define MAX_PAGE_REQUESTS 8
-// keep this value reasonably low, else we'll run out of
-// GDI resources/memory when caching many larger bitmaps
-// TODO: this should be based on amount of memory taken by rendered pages
-// i.e. one big page can use as much memory as lots of small pages
-#define MAX_BITMAPS_CACHED 64
+
+/* number of zoom levels of a tile that are kept cached at the same time.
+   The levels besides the current one form a small mip pyramid that
+   PaintTile scales on screen while a zoom change waits for its exact
+   rendering (without them a zoom change flashes white) */
+#define MAX_ZOOM_LEVELS_PER_TILE 3
+
+// upper limit for the number of render worker threads; the actual
+// number is derived from the CPU count in the RenderCache constructor
+#define MAX_RENDER_THREADS 8
+
+/* Adaptive render quality: when the estimated time to drain the request
+   queue exceeds this budget, pages render at REDUCED_QUALITY_FACTOR of
+   the requested zoom and are upscaled on screen, to be re-rendered at
+   full quality once the queue runs dry (see ShouldReduceQuality and
+   GetNextRefinementRequest) */
+#define ADAPTIVE_LATENCY_BUDGET_MS 200
+#define REDUCED_QUALITY_FACTOR 0.5f
+
+// posted to the hwnd registered with RequestThumbnailRendering once the
+// page's bitmap is in the cache (or the render was aborted); wParam is
+// the page number
+#define UWM_THUMBNAIL_RENDERED (WM_APP + 1)
 
 class RenderingCallback {
   public:
@@ -51,7 +69,15 @@ struct BitmapCacheEntry {
 
     // owned by the BitmapCacheEntry
     RenderedBitmap* bitmap = nullptr;
+    // approximate memory used by bitmap, counted against the cache's byte budget
+    i64 sizeInBytes = 0;
+    // tick of the most recent cache hit, used for LRU eviction
+    DWORD lastUseTimestamp = 0;
     bool outOfDate = false;
+    // rendered at a fraction of zoom and upscaled on screen (see
+    // ShouldReduceQuality); replaced by a full-quality rendering once
+    // the queue is idle (see GetNextRefinementRequest)
+    bool reducedQuality = false;
     int refs = 1;
 
     BitmapCacheEntry(DisplayModel* dm, int pageNo, int rotation, float zoom, TilePosition tile,
@@ -68,6 +94,25 @@ struct BitmapCacheEntry {
     }
 };
 
+/* Second-tier cache entry: the deflated pixels of a bitmap that the byte
+   budget evicted. Inflating one is an order of magnitude cheaper than
+   re-rendering the page, so pages pushed out by the budget come back
+   quickly (see CompressAndStore / ReloadCompressed). */
+struct CompressedCacheEntry {
+    DisplayModel* dm = nullptr;
+    int pageNo = 0;
+    int rotation = 0;
+    float zoom = 0.f;
+    TilePosition tile;
+
+    Size size;
+    // deflated 32-bit pixel rows (raw pixels between SnapshotForCompression
+    // and CompressAndStore)
+    u8* data = nullptr;
+    i64 dataLen = 0;
+    DWORD lastUseTimestamp = 0;
+};
+
 /* Even though this looks a lot like a BitmapCacheEntry, we keep it
    separate for clarity in the code (PageRenderRequests are reused,
    while BitmapCacheEntries are ref-counted) */
@@ -79,27 +124,89 @@ struct PageRenderRequest {
     TilePosition tile;
 
     RectF pageRect; // calculated from TilePosition
+    // dm->renderGeneration at the time the request was queued; a request
+    // whose generation is stale by the time a worker would pick it up is
+    // dropped (0 for explicit-zoom requests, which are never dropped)
+    LONG generation = 0;
     bool abort = false;
     AbortCookie* abortCookie = nullptr;
+    // a whole-document warming render (see GetNextWarmingRequest):
+    // rendered even though the page isn't visible and aborted as soon
+    // as a user request comes in
+    bool background = false;
     DWORD timestamp = 0;
     // owned by the PageRenderRequest (use it before reusing the request)
     // on rendering success, the callback gets handed the RenderedBitmap
     RenderingCallback* renderCb = nullptr;
+    // for thumbnail requests: gets posted UWM_THUMBNAIL_RENDERED once the
+    // bitmap is cached (or the render was aborted and should be re-requested)
+    HWND notifyHwnd = nullptr;
+    // set by the worker when it renders this request at reduced zoom
+    // (see ShouldReduceQuality); copied to the cache entry by Add()
+    bool reducedQuality = false;
+};
+
+/* A queued request from the page thumbnails sidebar. Kept in a separate
+   list that the workers only drain when no user request is pending, so
+   scrolling the sidebar of a 10,000 page document never delays rendering
+   the page the user is reading. */
+struct ThumbnailRenderRequest {
+    DisplayModel* dm = nullptr;
+    int pageNo = 0;
+    float zoom = 0.f;
+    HWND notifyHwnd = nullptr;
+};
+
+class RenderCache;
+
+/* Per-thread state of a render worker. Each worker caches an engine
+   clone for the DisplayModel it rendered for last, so that workers
+   rendering pages of the same document in parallel don't serialize
+   on the engine's internal lock. */
+struct RenderWorker {
+    RenderCache* cache = nullptr;
+    int no = 0;
+    HANDLE thread = nullptr;
+    // clone of engineDm's engine (nullptr if cloning failed or wasn't tried);
+    // the pointers are only swapped while holding RenderCache::requestAccess
+    EngineBase* engine = nullptr;
+    DisplayModel* engineDm = nullptr;
 };
 
 class RenderCache {
   public:
-    BitmapCacheEntry* cache[MAX_BITMAPS_CACHED]{};
-    int cacheCount = 0;
+    Vec<BitmapCacheEntry*> cache;
+    // total memory used by cached bitmaps; eviction keeps this below
+    // the byte budget (see GlobalPrefs.renderCacheSize)
+    i64 cacheSizeInBytes = 0;
+    // second tier of the cache: compressed pixels of entries evicted by
+    // the byte budget, with their own budget and the same memory
+    // accounting subsystem; guarded by cacheAccess
+    Vec<CompressedCacheEntry*> compressed;
+    i64 compressedSizeInBytes = 0;
+    // documents whose on-disk tile cache has been merged into the
+    // compressed tier already (see EnsureDiskTilesLoaded); guarded by
+    // cacheAccess
+    Vec<DisplayModel*> diskTilesLoaded;
     // make sure to never ask for requestAccess in a cacheAccess
     // protected critical section in order to avoid deadlocks
     CRITICAL_SECTION cacheAccess;
 
     PageRenderRequest requests[MAX_PAGE_REQUESTS]{};
     int requestCount = 0;
-    PageRenderRequest* curReq = nullptr;
+    // in-flight requests, one slot per worker; each points into the
+    // stack of the worker's thread while it's rendering
+    PageRenderRequest* curReqs[MAX_RENDER_THREADS]{};
     CRITICAL_SECTION requestAccess;
-    HANDLE renderThread = nullptr;
+    RenderWorker workers[MAX_RENDER_THREADS];
+    int threadCount = 1;
+    // duration of the most recently finished page render; written by the
+    // worker threads without locking, only meant for the perf HUD
+    int lastRenderDurMs = 0;
+    // moving average of recent full-quality page render durations, written
+    // with the same (lack of) locking; it only steers the adaptive quality
+    // heuristic in ShouldReduceQuality
+    int avgRenderDurMs = 0;
 
     Size maxTileSize{};
     bool isRemoteSession = false;
@@ -122,13 +229,45 @@ class RenderCache {
     void FreeForDisplayModel(DisplayModel* dm);
     void KeepForDisplayModel(DisplayModel* oldDm, DisplayModel* newDm);
     void Invalidate(DisplayModel* dm, int pageNo, RectF rect);
+    void RecolorAll(COLORREF fromText, COLORREF fromBg);
+    // rotates dm's cached bitmaps in place when the view rotation changes
+    // (see RotateDocBy in SumatraPDF.cpp)
+    void RotateForDisplayModel(DisplayModel* dm, int newRotation);
     // returns how much time in ms has past since the most recent rendering
     // request for the visible part of the page if nothing at all could be
     // painted, 0 if something has been painted and RENDER_DELAY_FAILED on failure
     int Paint(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, PageInfo* pageInfo, bool* renderOutOfDateCue);
+    // paints the page from already cached bitmaps only, never rendering
+    // (see the scrollbar hover preview in Canvas.cpp)
+    bool PaintCachedPreview(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo);
+
+    // whole-document warming: when the request queue runs dry, the workers
+    // keep rendering the remaining pages of the most recently used document
+    // at the current zoom until the byte budget is full, so that every
+    // subsequent page turn is served from the cache. Re-armed by every
+    // RequestRendering(dm, pageNo) call; guarded by requestAccess
+    DisplayModel* warmingDm = nullptr;
+    int warmingNextPage = 1;
+
+    // low-priority lane for the page thumbnails sidebar: drained after the
+    // request queue but before warming. Thumbnails are cached like any other
+    // whole-page rendering (at the sidebar's zoom level), so the byte budget,
+    // the compressed tier and the disk tile cache all apply to them; guarded
+    // by requestAccess
+    Vec<ThumbnailRenderRequest> thumbRequests;
 
-    bool ClearCurrentRequest();
-    bool GetNextRequest(PageRenderRequest* req);
+    void RequestThumbnailRendering(DisplayModel* dm, int pageNo, float zoom, HWND notifyHwnd);
+    bool GetNextThumbnailRequest(int workerNo, PageRenderRequest* req);
+    bool HasThumbnailWork();
+    void ClearThumbnailQueue(DisplayModel* dm);
+
+    bool ClearCurrentRequest(int workerNo);
+    bool GetNextRequest(int workerNo, PageRenderRequest* req);
+    bool GetNextWarmingRequest(int workerNo, PageRenderRequest* req);
+    bool HasWarmingWork();
+    bool ShouldReduceQuality(PageRenderRequest& req);
+    bool GetNextRefinementRequest(int workerNo, PageRenderRequest* req);
+    bool HasRefinementWork();
     void Add(PageRenderRequest& req, RenderedBitmap* bmp);
 
     USHORT GetTileRes(DisplayModel* dm, int pageNo);
@@ -143,14 +282,30 @@ class RenderCache {
     bool Render(DisplayModel* dm, int pageNo, int rotation, float zoom, TilePosition* tile = nullptr,
                 RectF* pageRect = nullptr, RenderingCallback* renderCb = nullptr);
     void ClearQueueForDisplayModel(DisplayModel* dm, int pageNo = INVALID_PAGE_NO, TilePosition* tile = nullptr);
-    void AbortCurrentRequest();
+    // abort in-flight requests matching dm (all of them if dm is nullptr)
+    // and optionally only those for pageNo
+    void AbortInFlightRequests(DisplayModel* dm = nullptr, int pageNo = INVALID_PAGE_NO);
+
+    EngineBase* GetEngineForWorker(RenderWorker* worker, DisplayModel* dm);
+    void DropWorkerClones(DisplayModel* dm);
+
+    static DWORD WINAPI RenderCacheWorkerThread(LPVOID data);
 
-    static DWORD WINAPI RenderCacheThread(LPVOID data);
+    CompressedCacheEntry* SnapshotForCompression(BitmapCacheEntry* entry);
+    void CompressAndStore(Vec<CompressedCacheEntry*>& pending);
+    void StoreCompressed(CompressedCacheEntry* entry);
+    RenderedBitmap* ReloadCompressed(PageRenderRequest& req);
+    void DropCompressedAt(int idx);
+    void FreeCompressed(DisplayModel* dm, int pageNo = INVALID_PAGE_NO);
+    void EnsureDiskTilesLoaded(DisplayModel* dm);
+    void SaveDiskTiles(DisplayModel* dm);
 
     BitmapCacheEntry* Find(DisplayModel* dm, int pageNo, int rotation, float zoom = INVALID_ZOOM,
                            TilePosition* tile = nullptr);
+    BitmapCacheEntry* FindNearestZoom(DisplayModel* dm, int pageNo, int rotation, float zoom, TilePosition* tile);
     bool DropCacheEntry(BitmapCacheEntry* entry);
     void FreePage(DisplayModel* dm = nullptr, int pageNo = -1, TilePosition* tile = nullptr);
+    void TrimZoomLevels(DisplayModel* dm, int pageNo, TilePosition tile, float newZoom, int newRotation);
     void FreeNotVisible();
 
     int PaintTile(HDC hdc, Rect bounds, DisplayModel* dm, int pageNo, TilePosition tile, Rect tileOnScreen,
@@ -23,6 +23,8 @@ extern "C" {
 #include "Annotation.h"
 #include "EngineBase.h"
 #include "EngineCreate.h"
+#include "EngineFzUtil.h"
+#include "ProgressUpdateUI.h"
 
 #include "SaveAsPdf.h"
 
@@ -67,12 +69,16 @@ struct PdfMerger {
     pdf_document* doc_des = nullptr;
     pdf_document* doc_src = nullptr;
     VecStr filePaths;
+    ProgressUpdateUI* progress = nullptr;
+    int nPagesTotal = 0;
+    int nPagesMerged = 0;
 
     PdfMerger() = default;
     ~PdfMerger();
     bool MergeAndSave(TocItem*, char* dstPath);
     bool MergePdfFile(std::string_view);
     void MergePdfPage(int page_from, int page_to, pdf_graft_map* graft_map);
+    int CountPdfPages(std::string_view);
 };
 
 PdfMerger::~PdfMerger() {
@@ -118,6 +124,25 @@ void PdfMerger::MergePdfPage(int page_from, int page_to, pdf_graft_map* graft_ma
     }
 }
 
+// opening just to count the pages only reads the xref and the page
+// tree, so this is cheap compared to the merge itself
+int PdfMerger::CountPdfPages(std::string_view path) {
+    int nPages = 0;
+    pdf_document* doc = nullptr;
+    fz_var(doc);
+    fz_try(ctx) {
+        doc = pdf_open_document(ctx, path.data());
+        nPages = pdf_count_pages(ctx, doc);
+    }
+    fz_always(ctx) {
+        pdf_drop_document(ctx, doc);
+    }
+    fz_catch(ctx) {
+        nPages = 0;
+    }
+    return nPages;
+}
+
 bool PdfMerger::MergePdfFile(std::string_view path) {
     doc_src = pdf_open_document(ctx, path.data());
     if (!doc_src) {
@@ -125,13 +150,22 @@ bool PdfMerger::MergePdfFile(std::string_view path) {
     }
 
     int nPages = 0;
+    bool canceled = false;
     pdf_graft_map* graft_map = nullptr;
 
     fz_try(ctx) {
         nPages = pdf_count_pages(ctx, doc_src);
         graft_map = pdf_new_graft_map(ctx, doc_des);
         for (int i = 1; i <= nPages; i++) {
+            if (progress && progress->WasCanceled()) {
+                canceled = true;
+                break;
+            }
             MergePdfPage(i, -1, graft_map);
+            nPagesMerged++;
+            if (progress) {
+                progress->UpdateProgress(nPagesMerged, nPagesTotal);
+            }
         }
     }
     fz_always(ctx) {
@@ -142,7 +176,7 @@ bool PdfMerger::MergePdfFile(std::string_view path) {
         // TODO: show error message
         return false;
     }
-    return true;
+    return !canceled;
 }
 
 bool PdfMerger::MergeAndSave(TocItem* root, char* dstPath) {
@@ -161,7 +195,9 @@ bool PdfMerger::MergeAndSave(TocItem* root, char* dstPath) {
         return false;
     }
 
-    ctx = fz_new_context(nullptr, nullptr, FZ_STORE_UNLIMITED);
+    // a bounded store keeps the working set in check when merging many
+    // large files: decompressed streams get evicted instead of piling up
+    ctx = fz_new_context(fz_memacct_alloc_ctx(), nullptr, FZ_STORE_DEFAULT);
 
     // TODO: install warnigngs redirect
     fz_try(ctx) {
@@ -174,6 +210,10 @@ bool PdfMerger::MergeAndSave(TocItem* root, char* dstPath) {
         return false;
     }
 
+    for (int i = 0; i < nFiles; i++) {
+        nPagesTotal += CountPdfPages(filePaths.at(i));
+    }
+
     bool ok;
     for (int i = 0; i < nFiles; i++) {
         std::string_view path = filePaths.at(i);
@@ -200,8 +240,9 @@ bool PdfMerger::MergeAndSave(TocItem* root, char* dstPath) {
     return true;
 }
 
-bool SaveVirtualAsPdf(TocItem* root, char* dstPath) {
+bool SaveVirtualAsPdf(TocItem* root, char* dstPath, ProgressUpdateUI* progress) {
     PdfMerger* merger = new PdfMerger();
+    merger->progress = progress;
 
     bool ok = merger->MergeAndSave(root, dstPath);
     delete merger;
@@ -1,4 +1,6 @@
 /* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
    License: Simplified BSD (see COPYING.BSD) */
 
-bool SaveVirtualAsPdf(TocItem* root, char* dstPath);
+struct ProgressUpdateUI;
+
+bool SaveVirtualAsPdf(TocItem* root, char* dstPath, ProgressUpdateUI* progress = nullptr);
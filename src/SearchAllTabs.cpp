@@ -0,0 +1,354 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
+#include "utils/FileUtil.h"
+#include "utils/WinUtil.h"
+#include "utils/Dpi.h"
+#include "utils/ThreadUtil.h"
+#include "utils/UITask.h"
+
+#include "wingui/WinGui.h"
+#include "wingui/TreeModel.h"
+#include "wingui/Layout.h"
+#include "wingui/Window.h"
+#include "wingui/StaticCtrl.h"
+#include "wingui/ButtonCtrl.h"
+#include "wingui/EditCtrl.h"
+#include "wingui/ListBoxCtrl.h"
+
+#include "Annotation.h"
+#include "EngineBase.h"
+#include "EngineCreate.h"
+
+#include "SumatraConfig.h"
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "Controller.h"
+#include "DisplayModel.h"
+#include "ProgressUpdateUI.h"
+#include "TextSelection.h"
+#include "TextSearch.h"
+#include "Notifications.h"
+#include "SumatraPDF.h"
+#include "WindowInfo.h"
+#include "TabInfo.h"
+#include "Translations.h"
+#include "SearchAllTabs.h"
+
+using std::placeholders::_1;
+
+// one page worth of search hits in one of the searched documents
+struct SearchAllTabsResult {
+    AutoFreeWstr filePath;
+    int pageNo = 0;
+    int nMatches = 0;
+};
+
+struct SearchAllTabsWindow {
+    Window* mainWindow = nullptr;
+    LayoutBase* mainLayout = nullptr;
+
+    EditCtrl* editTerm = nullptr;
+    ButtonCtrl* buttonSearch = nullptr;
+    StaticCtrl* staticStatus = nullptr;
+    ListBoxCtrl* listBox = nullptr;
+    ListBoxModel* lbModel = nullptr;
+
+    // one entry per list box line
+    Vec<SearchAllTabsResult*> results;
+    // documents still being searched by worker threads
+    int docsPending = 0;
+    int nMatches = 0;
+
+    ~SearchAllTabsWindow();
+};
+
+static SearchAllTabsWindow* gSearchAllTabsWindow = nullptr;
+
+// incremented on every new search and when the window closes; in-flight
+// workers compare the id they were started with against it, so bumping
+// it cancels them
+static LONG gCurrSearchId = 0;
+
+// describes one document to search; owned by the worker task
+struct SearchDocTask {
+    LONG searchId = 0;
+    AutoFreeWstr filePath;
+    AutoFreeWstr term;
+};
+
+// cancellation-only tracker handed to TextSearch, which checks it between pages
+struct SearchDocTracker : ProgressUpdateUI {
+    LONG searchId = 0;
+
+    explicit SearchDocTracker(LONG searchId) {
+        this->searchId = searchId;
+    }
+    void UpdateProgress(int, int) override {
+    }
+    bool WasCanceled() override {
+        return searchId != gCurrSearchId;
+    }
+};
+
+static void UpdateStatus(SearchAllTabsWindow* win) {
+    str::Str s;
+    if (win->docsPending > 0) {
+        s.AppendFmt("%d matches so far, still searching %d documents...", win->nMatches, win->docsPending);
+    } else if (win->nMatches == 0) {
+        s.Append("No matches found");
+    } else {
+        s.AppendFmt("%d matches on %d pages", win->nMatches, win->results.isize());
+    }
+    win->staticStatus->SetText(s.AsView());
+}
+
+static void RebuildResults(SearchAllTabsWindow* win) {
+    auto model = new ListBoxModelStrings();
+    str::Str s;
+    for (auto res : win->results) {
+        s.Reset();
+        AutoFree name(strconv::WstrToUtf8(path::GetBaseNameNoFree(res->filePath)));
+        s.AppendFmt("%s, page %d", name.Get(), res->pageNo);
+        if (res->nMatches > 1) {
+            s.AppendFmt(" (%d matches)", res->nMatches);
+        }
+        model->strings.Append(s.AsView());
+    }
+
+    win->listBox->SetModel(model);
+    delete win->lbModel;
+    win->lbModel = model;
+    UpdateStatus(win);
+}
+
+// runs on the UI thread; takes ownership of task and found
+static void SearchDocFinished(SearchDocTask* task, Vec<SearchAllTabsResult*>* found) {
+    SearchAllTabsWindow* win = gSearchAllTabsWindow;
+    if (!win || task->searchId != gCurrSearchId) {
+        // the search was canceled or superseded while this document
+        // was being searched
+        DeleteVecMembers(*found);
+        delete found;
+        delete task;
+        return;
+    }
+
+    for (auto res : *found) {
+        win->nMatches += res->nMatches;
+        win->results.Append(res);
+    }
+    delete found;
+    delete task;
+
+    win->docsPending--;
+    RebuildResults(win);
+}
+
+static void SearchDocOnWorker(SearchDocTask* task) {
+    auto found = new Vec<SearchAllTabsResult*>();
+    SearchDocTracker tracker(task->searchId);
+
+    if (!tracker.WasCanceled()) {
+        // open a private engine instance so that searching neither contends
+        // with nor outlives the engine owned by the tab
+        EngineBase* engine = CreateEngine(task->filePath);
+        if (engine) {
+            {
+                DocumentTextCache textCache(engine);
+                TextSearch search(engine, &textCache);
+                TextSel* sel = search.FindFirst(1, task->term, &tracker);
+                while (sel) {
+                    // aggregate per page: FindNext walks the document in order
+                    int pageNo = search.GetSearchHitStartPageNo();
+                    if (found->size() > 0 && found->Last()->pageNo == pageNo) {
+                        found->Last()->nMatches++;
+                    } else {
+                        auto res = new SearchAllTabsResult();
+                        res->filePath.SetCopy(task->filePath);
+                        res->pageNo = pageNo;
+                        res->nMatches = 1;
+                        found->Append(res);
+                    }
+                    sel = search.FindNext(&tracker);
+                }
+            }
+            delete engine;
+        }
+    }
+
+    uitask::Post([task, found] { SearchDocFinished(task, found); });
+}
+
+static void ButtonSearchHandler(SearchAllTabsWindow* win) {
+    AutoFreeWstr term(strconv::Utf8ToWstr(win->editTerm->GetText()));
+    if (str::IsEmpty(term.Get())) {
+        return;
+    }
+
+    // cancels whatever the previous search hasn't finished yet
+    LONG searchId = InterlockedIncrement(&gCurrSearchId);
+
+    DeleteVecMembers(win->results);
+    win->results.Reset();
+    win->nMatches = 0;
+    win->docsPending = 0;
+
+    // search each document on its own worker thread; results stream
+    // back per document via SearchDocFinished
+    for (WindowInfo* w : gWindows) {
+        for (TabInfo* tab : w->tabs) {
+            if (!tab->AsFixed()) {
+                // text search requires one of the fixed-layout engines
+                continue;
+            }
+            auto task = new SearchDocTask();
+            task->searchId = searchId;
+            task->filePath.SetCopy(tab->filePath);
+            task->term.SetCopy(term);
+            win->docsPending++;
+            auto fn = std::bind(SearchDocOnWorker, task);
+            DropTaskHandle(GetThreadPool()->Submit(fn, TaskPriority::Interactive));
+        }
+    }
+
+    RebuildResults(win);
+}
+
+static void ListBoxSelectionChanged(SearchAllTabsWindow* win, ListBoxSelectionChangedEvent* ev) {
+    int idx = ev->idx;
+    if (idx < 0 || idx >= win->results.isize()) {
+        return;
+    }
+    SearchAllTabsResult* res = win->results.at(idx);
+    // focuses the window and selects the tab the document is open in
+    WindowInfo* docWin = FindWindowInfoByFile(res->filePath, true);
+    if (!docWin) {
+        return;
+    }
+    int pageNo = res->pageNo;
+    uitask::Post([=] {
+        if (!WindowInfoStillValid(docWin) || !docWin->IsDocLoaded()) {
+            return;
+        }
+        docWin->ctrl->GoToPage(pageNo, true);
+    });
+}
+
+static void WndCloseHandler(SearchAllTabsWindow* win, WindowCloseEvent* ev) {
+    CrashIf(win->mainWindow != ev->w);
+    CrashIf(gSearchAllTabsWindow != win);
+    gSearchAllTabsWindow = nullptr;
+    delete win;
+}
+
+static void WndSizeHandler(SearchAllTabsWindow* win, SizeEvent* ev) {
+    int dx = ev->dx;
+    int dy = ev->dy;
+    HWND hwnd = ev->hwnd;
+    if (dx == 0 || dy == 0) {
+        return;
+    }
+    ev->didHandle = true;
+    InvalidateRect(hwnd, nullptr, false);
+    LayoutToSize(win->mainLayout, {dx, dy});
+}
+
+SearchAllTabsWindow::~SearchAllTabsWindow() {
+    // cancel in-flight workers; their results get dropped in SearchDocFinished
+    InterlockedIncrement(&gCurrSearchId);
+    delete mainWindow;
+    delete mainLayout;
+    delete lbModel;
+    DeleteVecMembers(results);
+}
+
+static void CreateMainLayout(SearchAllTabsWindow* win) {
+    HWND parent = win->mainWindow->hwnd;
+    auto vbox = new VBox();
+    vbox->alignMain = MainAxisAlign::MainStart;
+    vbox->alignCross = CrossAxisAlign::Stretch;
+
+    {
+        auto w = new EditCtrl(parent);
+        bool ok = w->Create();
+        CrashIf(!ok);
+        w->SetCueText("Search term");
+        win->editTerm = w;
+        vbox->AddChild(w);
+    }
+
+    {
+        auto w = new ButtonCtrl(parent);
+        w->SetInsetsPt(4, 0, 0, 0);
+        w->SetText("Search all tabs");
+        // with isDialog set, Enter in the edit field triggers this button
+        w->isDefault = true;
+        bool ok = w->Create();
+        CrashIf(!ok);
+        w->onClicked = std::bind(&ButtonSearchHandler, win);
+        win->buttonSearch = w;
+        vbox->AddChild(w);
+    }
+
+    {
+        auto w = new StaticCtrl(parent);
+        bool ok = w->Create();
+        CrashIf(!ok);
+        w->SetText("Searches every document open in a tab");
+        w->SetInsetsPt(8, 0, 0, 0);
+        win->staticStatus = w;
+        vbox->AddChild(w);
+    }
+
+    {
+        auto w = new ListBoxCtrl(parent);
+        w->idealSizeLines = 14;
+        w->SetInsetsPt(4, 0);
+        bool ok = w->Create();
+        CrashIf(!ok);
+        win->lbModel = new ListBoxModelStrings();
+        w->SetModel(win->lbModel);
+        w->onSelectionChanged = std::bind(ListBoxSelectionChanged, win, _1);
+        win->listBox = w;
+        vbox->AddChild(w, 1);
+    }
+
+    auto padding = new Padding(vbox, DpiScaledInsets(parent, 4, 8));
+    win->mainLayout = padding;
+}
+
+void StartSearchAllTabs(WindowInfo* win) {
+    if (gSearchAllTabsWindow) {
+        BringWindowToTop(gSearchAllTabsWindow->mainWindow->hwnd);
+        return;
+    }
+
+    auto saWin = new SearchAllTabsWindow();
+    auto mainWindow = new Window();
+    HMODULE h = GetModuleHandleW(nullptr);
+    WCHAR* iconName = MAKEINTRESOURCEW(GetAppIconID());
+    mainWindow->hIcon = LoadIconW(h, iconName);
+
+    mainWindow->isDialog = true;
+    mainWindow->backgroundColor = MkRgb((u8)0xee, (u8)0xee, (u8)0xee);
+    mainWindow->SetText(_TR("Search All Tabs"));
+    bool ok = mainWindow->Create();
+    CrashIf(!ok);
+    mainWindow->onClose = std::bind(WndCloseHandler, saWin, _1);
+    mainWindow->onSize = std::bind(WndSizeHandler, saWin, _1);
+
+    saWin->mainWindow = mainWindow;
+    CreateMainLayout(saWin);
+    gSearchAllTabsWindow = saWin;
+
+    LayoutAndSizeToContent(saWin->mainLayout, 520, 480, mainWindow->hwnd);
+    HwndPositionToTheRightOf(mainWindow->hwnd, win->hwndFrame);
+
+    // important to call this after hooking up onSize to ensure
+    // first layout is triggered
+    mainWindow->SetIsVisible(true);
+    saWin->editTerm->SetFocus();
+}
@@ -0,0 +1,6 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+struct SearchAllTabsWindow;
+
+void StartSearchAllTabs(WindowInfo*);
@@ -194,6 +194,10 @@ static void ShowSearchResult(WindowInfo* win, TextSel* result, bool addNavPt) {
 }
 
 void ClearSearchResult(WindowInfo* win) {
+    if (win->currentTab) {
+        delete win->currentTab->searchMatches;
+        win->currentTab->searchMatches = nullptr;
+    }
     DeleteOldSelectionInfo(win, true);
     RepaintAsync(win, 0);
 }
@@ -214,11 +218,15 @@ struct FindThreadData : public ProgressUpdateUI {
     WindowInfo* win;
     TextSearchDirection direction;
     bool wasModified;
+    bool matchCase;
     AutoFreeWstr text;
     // owned by win->notifications, as FindThreadData
     // can be deleted before the notification times out
     NotificationWnd* wnd;
     HANDLE thread;
+    // all matches of text, collected on the find thread when
+    // highlightSearchMatches is set; handed to the tab in FindEndTask
+    SearchMatches* matches;
 
     FindThreadData(WindowInfo* win, TextSearchDirection direction, HWND findBox)
         : win(win),
@@ -226,10 +234,14 @@ struct FindThreadData : public ProgressUpdateUI {
           text(win::GetText(findBox)),
           wasModified(Edit_GetModify(findBox)),
           wnd(nullptr),
-          thread(nullptr) {
+          thread(nullptr),
+          matches(nullptr) {
+        WORD state = (WORD)SendMessageW(win->hwndToolbar, TB_GETSTATE, CmdFindMatch, 0);
+        matchCase = (state & TBSTATE_CHECKED) != 0;
     }
     ~FindThreadData() {
         CloseHandle(thread);
+        delete matches;
     }
 
     void ShowUI(bool showProgress) {
@@ -303,6 +315,12 @@ static void FindEndTask(WindowInfo* win, FindThreadData* ftd, TextSel* textSel,
     if (!win->IsDocLoaded()) {
         // the UI has already been disabled and hidden
     } else if (textSel) {
+        if (ftd->matches) {
+            win->currentTab->searchMemo.Add(ftd->text, ftd->matchCase, ftd->matches);
+            delete win->currentTab->searchMatches;
+            win->currentTab->searchMatches = ftd->matches;
+            ftd->matches = nullptr;
+        }
         ShowSearchResult(win, textSel, wasModifiedCanceled);
         ftd->HideUI(true, loopedAround);
     } else {
@@ -314,6 +332,31 @@ static void FindEndTask(WindowInfo* win, FindThreadData* ftd, TextSel* textSel,
     delete ftd;
 }
 
+// collects every match of text in the document into per-page rectangle
+// lists (in page coordinates). runs on the find thread with its own
+// TextSearch, so that the position of the current match in dm->textSearch
+// survives; the page text comes out of dm->textCache, which the background
+// text index has usually filled completely by the time a search starts
+static SearchMatches* MarkAllMatches(DisplayModel* dm, const WCHAR* text, bool matchCase, ProgressUpdateUI* tracker) {
+    TextSearch search(dm->GetEngine(), dm->textCache);
+    search.SetSensitive(matchCase);
+
+    auto matches = new SearchMatches();
+    matches->nPages = dm->PageCount();
+    matches->pageRects = new Vec<RectF>[matches->nPages];
+
+    for (TextSel* sel = search.FindFirst(1, text, tracker); sel && !tracker->WasCanceled();
+         sel = search.FindNext(tracker)) {
+        for (int i = 0; i < sel->len; i++) {
+            int pageNo = sel->pages[i];
+            if (pageNo >= 1 && pageNo <= matches->nPages) {
+                matches->pageRects[pageNo - 1].Append(ToRectFl(sel->rects[i]));
+            }
+        }
+    }
+    return matches;
+}
+
 static DWORD WINAPI FindThread(LPVOID data) {
     FindThreadData* ftd = (FindThreadData*)data;
     CrashIf(!(ftd && ftd->win && ftd->win->ctrl && ftd->win->ctrl->AsFixed()));
@@ -339,6 +382,18 @@ static DWORD WINAPI FindThread(LPVOID data) {
         }
     }
 
+    if (rect && !win->findCanceled && gGlobalPrefs->highlightSearchMatches && !ftd->matches) {
+        // collect the other matches for the highlight overlay unless the
+        // memo already provided them; in the worst case (nothing in the
+        // text cache yet) this costs one more pass over the document's text
+        ftd->matches = MarkAllMatches(dm, ftd->text, ftd->matchCase, ftd);
+        if (win->findCanceled) {
+            // don't let a partial list end up in the tab's memo
+            delete ftd->matches;
+            ftd->matches = nullptr;
+        }
+    }
+
     // wait for FindTextOnThread to return so that
     // FindEndTask closes the correct handle to
     // the current find thread
@@ -378,14 +433,23 @@ void FindTextOnThread(WindowInfo* win, TextSearchDirection direction, bool showP
         return;
     }
 
+    if (gGlobalPrefs->highlightSearchMatches && win->currentTab) {
+        // on a memo hit the find thread skips the match collecting pass
+        // and only has to locate the next match to select
+        SearchMatches* memoized = win->currentTab->searchMemo.Find(ftd->text, ftd->matchCase);
+        if (memoized) {
+            ftd->matches = memoized->Clone();
+        }
+    }
+
     ftd->ShowUI(showProgress);
     win->findThread = nullptr;
     win->findThread = CreateThread(nullptr, 0, FindThread, ftd, 0, 0);
     ftd->thread = win->findThread; // safe because only accesssed on ui thread
 }
 
-void PaintForwardSearchMark(WindowInfo* win, HDC hdc) {
-    CrashIf(!win->AsFixed());
+// the rectangles highlighting the forward search results, in client coordinates
+static void GetForwardSearchMarkRects(WindowInfo* win, Vec<Rect>& rects) {
     DisplayModel* dm = win->AsFixed();
     int pageNo = win->fwdSearchMark.page;
     PageInfo* pageInfo = dm->GetPageInfo(pageNo);
@@ -396,8 +460,6 @@ void PaintForwardSearchMark(WindowInfo* win, HDC hdc) {
     int hiLiWidth = gGlobalPrefs->forwardSearch.highlightWidth;
     int hiLiOff = gGlobalPrefs->forwardSearch.highlightOffset;
 
-    // Draw the rectangles highlighting the forward search results
-    Vec<Rect> rects;
     for (size_t i = 0; i < win->fwdSearchMark.rects.size(); i++) {
         Rect rect = win->fwdSearchMark.rects.at(i);
         rect = dm->CvtToScreen(pageNo, ToRectFl(rect));
@@ -410,11 +472,71 @@ void PaintForwardSearchMark(WindowInfo* win, HDC hdc) {
         }
         rects.Append(rect);
     }
+}
+
+// bounding box of what PaintForwardSearchMark draws, in client coordinates;
+// empty if the marked page isn't visible. used to repaint only the mark's
+// part of the canvas when it fades out
+Rect ForwardSearchMarkScreenRect(WindowInfo* win) {
+    Rect r;
+    if (!win->AsFixed()) {
+        return r;
+    }
+    Vec<Rect> rects;
+    GetForwardSearchMarkRects(win, rects);
+    for (Rect& rect : rects) {
+        r = r.Union(rect);
+    }
+    if (!r.IsEmpty()) {
+        r.Inflate(1, 1);
+    }
+    return r;
+}
+
+void PaintForwardSearchMark(WindowInfo* win, HDC hdc) {
+    CrashIf(!win->AsFixed());
+
+    Vec<Rect> rects;
+    GetForwardSearchMarkRects(win, rects);
+    if (rects.size() == 0) {
+        return;
+    }
 
     BYTE alpha = (BYTE)(0x5f * 1.0f * (HIDE_FWDSRCHMARK_STEPS - win->fwdSearchMark.hideStep) / HIDE_FWDSRCHMARK_STEPS);
     PaintTransparentRectangles(hdc, win->canvasRc, rects, gGlobalPrefs->forwardSearch.highlightColor, alpha, 0);
 }
 
+// composites the cached rectangles of all search matches over the visible
+// pages. the geometry was computed once on the find thread, so this only
+// converts page to screen coordinates and never re-runs the search
+void PaintSearchMatches(WindowInfo* win, HDC hdc) {
+    DisplayModel* dm = win->AsFixed();
+    CrashIf(!dm);
+    SearchMatches* matches = win->currentTab->searchMatches;
+    if (!matches) {
+        return;
+    }
+
+    Vec<Rect> rects;
+    for (int pageNo = 1; pageNo <= matches->nPages; pageNo++) {
+        PageInfo* pageInfo = dm->GetPageInfo(pageNo);
+        if (!pageInfo || 0.0 == pageInfo->visibleRatio) {
+            continue;
+        }
+        Vec<RectF>& pageRects = matches->pageRects[pageNo - 1];
+        for (size_t i = 0; i < pageRects.size(); i++) {
+            rects.Append(dm->CvtToScreen(pageNo, pageRects.at(i)));
+        }
+    }
+    if (rects.size() == 0) {
+        return;
+    }
+
+    // lighter than the selection, so that the current match (which the
+    // selection is set to) still stands out among the highlights
+    PaintTransparentRectangles(hdc, win->canvasRc, rects, gGlobalPrefs->fixedPageUI.selectionColor, 0x2f, 0);
+}
+
 // returns true if the double-click was handled and false if it wasn't
 bool OnInverseSearch(WindowInfo* win, int x, int y) {
     if (!HasPermission(Perm_DiskAccess) || gPluginMode) {
@@ -704,6 +826,12 @@ static const WCHAR* HandleOpenCmd(const WCHAR* cmd, DDEACK& ack) {
     }
 
     ack.fAck = 1;
+    // a resident preloader window (-preload) stays hidden until the first
+    // document is handed to it
+    if (!IsWindowVisible(win->hwndFrame)) {
+        ShowWindow(win->hwndFrame, SW_SHOW);
+        win::ToForeground(win->hwndFrame);
+    }
     if (forceRefresh) {
         ReloadDocument(win, true);
     }
@@ -870,6 +998,56 @@ static void HandleDdeCmds(HWND hwnd, const WCHAR* cmd, DDEACK& ack) {
     }
 }
 
+/* DDE transactions are queued and executed from a uitask: the sending
+   editor gets its ACK right away instead of blocking on document
+   operations (LoadDocument, forward search etc.), and rapid
+   ForwardSearch sequences coalesce to the final target. */
+
+static WStrVec gDdeCmdQueue;
+static bool gDdeDrainQueued = false;
+
+// splits a transaction like "[Open(...)][GotoPage(...)]" into single
+// bracketed commands, relying on the same assumption as the parsers
+// above: a command ends at the first ']'
+static size_t SplitDdeCmds(const WCHAR* cmd, WStrVec& out) {
+    size_t n = 0;
+    while (!str::IsEmpty(cmd)) {
+        const WCHAR* start = str::FindChar(cmd, '[');
+        if (!start) {
+            break;
+        }
+        const WCHAR* end = str::FindChar(start, ']');
+        if (!end) {
+            break;
+        }
+        out.Append(str::DupN(start, end - start + 1));
+        n++;
+        cmd = end + 1;
+    }
+    return n;
+}
+
+static void DrainDdeCmdQueue(HWND hwnd) {
+    gDdeDrainQueued = false;
+    // take commands one by one: executing a command can pump messages
+    // and append new commands to the queue behind our back
+    while (gDdeCmdQueue.size() > 0) {
+        AutoFreeWstr cmd(gDdeCmdQueue.PopAt(0));
+        if (str::StartsWith(cmd.Get(), L"[ForwardSearch(")) {
+            // a newer forward search target makes this one obsolete
+            bool hasNewer = false;
+            for (size_t i = 0; !hasNewer && i < gDdeCmdQueue.size(); i++) {
+                hasNewer = str::StartsWith(gDdeCmdQueue.at(i), L"[ForwardSearch(");
+            }
+            if (hasNewer) {
+                continue;
+            }
+        }
+        DDEACK ack = {0};
+        HandleDdeCmds(hwnd, cmd, ack);
+    }
+}
+
 LRESULT OnDDExecute(HWND hwnd, WPARAM wp, LPARAM lp) {
     UINT_PTR lo = 0, hi = 0;
     if (!UnpackDDElParam(WM_DDE_EXECUTE, lp, &lo, &hi)) {
@@ -888,9 +1066,19 @@ LRESULT OnDDExecute(HWND hwnd, WPARAM wp, LPARAM lp) {
     } else {
         cmd = strconv::FromAnsi((const char*)command);
     }
-    HandleDdeCmds(hwnd, cmd, ack);
     GlobalUnlock((HGLOBAL)hi);
 
+    // ack receipt of the transaction; it's executed from a uitask so
+    // that the editor's DDE conversation doesn't stall on us
+    size_t nQueued = SplitDdeCmds(cmd, gDdeCmdQueue);
+    if (nQueued > 0) {
+        ack.fAck = 1;
+        if (!gDdeDrainQueued) {
+            gDdeDrainQueued = true;
+            uitask::Post([hwnd] { DrainDdeCmdQueue(hwnd); });
+        }
+    }
+
     lp = ReuseDDElParam(lp, WM_DDE_EXECUTE, WM_DDE_ACK, *(WORD*)&ack, hi);
     PostMessageW((HWND)wp, WM_DDE_ACK, (WPARAM)hwnd, lp);
     return 0;
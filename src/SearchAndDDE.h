@@ -20,6 +20,8 @@ bool OnInverseSearch(WindowInfo* win, int x, int y);
 void ShowForwardSearchResult(WindowInfo* win, const WCHAR* fileName, uint line, uint col, uint ret, uint page,
                              Vec<Rect>& rects);
 void PaintForwardSearchMark(WindowInfo* win, HDC hdc);
+void PaintSearchMatches(WindowInfo* win, HDC hdc);
+Rect ForwardSearchMarkScreenRect(WindowInfo* win);
 void OnMenuFindPrev(WindowInfo* win);
 void OnMenuFindNext(WindowInfo* win);
 void OnMenuFind(WindowInfo* win);
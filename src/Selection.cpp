@@ -288,10 +288,101 @@ WCHAR* GetSelectedText(WindowInfo* win, const WCHAR* lineSep, bool& isTextOnlySe
     return s;
 }
 
+/* Delayed clipboard rendering: for a text selection spanning many pages,
+extracting all the text at copy time can stall the UI for seconds and
+allocates a string nobody might ever paste. Instead CopySelectionToClipboard()
+announces CF_UNICODETEXT with a null handle and keeps a snapshot of the
+selected range; Windows asks the frame window to provide the data via
+WM_RENDERFORMAT when something actually pastes. The snapshot reads from the
+source document's text cache, so it must be rendered eagerly before that
+document is deleted (ClipboardFlushDeferred). */
+
+// below this many selected pages copying is fast enough to do eagerly
+constexpr int kMinDeferredCopyPages = 10;
+
+static TextSelection* gDeferredClipboardSel = nullptr;
+static DisplayModel* gDeferredClipboardDm = nullptr;
+static HWND gDeferredClipboardHwnd = nullptr;
+
+static void ForgetDeferredClipboard() {
+    delete gDeferredClipboardSel;
+    gDeferredClipboardSel = nullptr;
+    gDeferredClipboardDm = nullptr;
+    gDeferredClipboardHwnd = nullptr;
+}
+
+// extracts the deferred selection and puts it on the (already open) clipboard
+static void RenderDeferredClipboardText() {
+    if (!gDeferredClipboardSel) {
+        return;
+    }
+    AutoFreeWstr text(gDeferredClipboardSel->ExtractText(L"\r\n"));
+    if (str::IsEmpty(text.Get())) {
+        return;
+    }
+    size_t n = str::Len(text) + 1;
+    HGLOBAL handle = GlobalAlloc(GMEM_MOVEABLE, n * sizeof(WCHAR));
+    if (!handle) {
+        return;
+    }
+    WCHAR* globalText = (WCHAR*)GlobalLock(handle);
+    if (globalText) {
+        str::BufSet(globalText, n, text);
+    }
+    GlobalUnlock(handle);
+    SetClipboardData(CF_UNICODETEXT, handle);
+}
+
+// WM_RENDERFORMAT: somebody pasted; the clipboard is already open
+void OnClipboardRenderFormat(uint format) {
+    if (CF_UNICODETEXT == format) {
+        RenderDeferredClipboardText();
+    }
+    // once rendered the data lives in the clipboard, the snapshot is done
+    ForgetDeferredClipboard();
+}
+
+// WM_RENDERALLFORMATS: the owner window is being destroyed
+void OnClipboardRenderAllFormats(HWND hwnd) {
+    if (!gDeferredClipboardSel) {
+        return;
+    }
+    if (OpenClipboard(hwnd)) {
+        if (GetClipboardOwner() == hwnd) {
+            RenderDeferredClipboardText();
+        }
+        CloseClipboard();
+    }
+    ForgetDeferredClipboard();
+}
+
+// WM_DESTROYCLIPBOARD: another program (or a new copy) took ownership
+void OnClipboardDestroy() {
+    ForgetDeferredClipboard();
+}
+
+// called before <closing> is deleted: if it's the source of the deferred
+// selection, render the text while its text cache is still alive
+void ClipboardFlushDeferred(Controller* closing) {
+    if (!gDeferredClipboardSel || !closing || closing->AsFixed() != gDeferredClipboardDm) {
+        return;
+    }
+    HWND hwnd = gDeferredClipboardHwnd;
+    if (OpenClipboard(hwnd)) {
+        if (GetClipboardOwner() == hwnd) {
+            RenderDeferredClipboardText();
+        }
+        CloseClipboard();
+    }
+    ForgetDeferredClipboard();
+}
+
 void CopySelectionToClipboard(WindowInfo* win) {
     CrashIf(win->currentTab->selectionOnPage->size() == 0 && win->mouseAction != MouseAction::SelectingText);
 
-    if (!OpenClipboard(nullptr)) {
+    // open with the frame as owner so that it gets WM_RENDERFORMAT for
+    // delayed rendering
+    if (!OpenClipboard(win->hwndFrame)) {
         return;
     }
     EmptyClipboard();
@@ -299,9 +390,33 @@ void CopySelectionToClipboard(WindowInfo* win) {
         CloseClipboard();
     };
 
+    DisplayModel* dm = win->AsFixed();
+    bool copyAllowed = gDisableDocumentRestrictions || dm->GetEngine()->AllowsCopyingText();
+
+    if (copyAllowed && dm->textSelection->result.len > 0) {
+        int fromPage, fromGlyph, toPage, toGlyph;
+        dm->textSelection->GetGlyphRange(&fromPage, &fromGlyph, &toPage, &toGlyph);
+        if (toPage - fromPage + 1 >= kMinDeferredCopyPages) {
+            ForgetDeferredClipboard();
+            // snapshot just the glyph range; the result rects aren't needed
+            // for ExtractText, so don't rebuild them via CopySelection()
+            auto* sel = new TextSelection(dm->GetEngine(), dm->textCache);
+            sel->startPage = fromPage;
+            sel->startGlyph = fromGlyph;
+            sel->endPage = toPage;
+            sel->endGlyph = toGlyph;
+            gDeferredClipboardSel = sel;
+            gDeferredClipboardDm = dm;
+            gDeferredClipboardHwnd = win->hwndFrame;
+            SetClipboardData(CF_UNICODETEXT, nullptr);
+            // like for an eager text selection, don't also copy an image
+            return;
+        }
+    }
+
     WCHAR* selText = nullptr;
     bool isTextOnlySelectionOut = false;
-    if (!gDisableDocumentRestrictions && !win->AsFixed()->GetEngine()->AllowsCopyingText()) {
+    if (!copyAllowed) {
         win->ShowNotification(_TR("Copying text was denied (copying as image only)"));
     } else {
         selText = GetSelectedText(win, L"\r\n", isTextOnlySelectionOut);
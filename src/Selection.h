@@ -26,6 +26,11 @@ void PaintSelection(WindowInfo* win, HDC hdc);
 void UpdateTextSelection(WindowInfo* win, bool select = true);
 void ZoomToSelection(WindowInfo* win, float factor, bool scrollToFit = true, bool relative = false);
 void CopySelectionToClipboard(WindowInfo* win);
+// delayed clipboard rendering (see Selection.cpp)
+void OnClipboardRenderFormat(uint format);
+void OnClipboardRenderAllFormats(HWND hwnd);
+void OnClipboardDestroy();
+void ClipboardFlushDeferred(Controller* closing);
 void OnSelectAll(WindowInfo* win, bool textOnly = false);
 bool NeedsSelectionEdgeAutoscroll(WindowInfo* win, int x, int y);
 void OnSelectionEdgeAutoscroll(WindowInfo* win, int x, int y);
@@ -304,6 +304,31 @@ struct GlobalPrefs {
     // actual resolution of the main screen in DPI (if this value isn't
     // positive, the system's UI setting is used)
     int customScreenDPI;
+    // maximum size in MB of the cache of rendered page bitmaps (if this
+    // value isn't positive, the limit is derived from installed RAM)
+    int renderCacheSize;
+    // if true, extracted page text is cached on disk (next to the
+    // thumbnail cache) so that search in large documents is instant
+    // across sessions
+    bool enableTextIndexCache;
+    // if true, compressed tiles evicted from the render cache are also
+    // saved to disk (next to the thumbnail cache) and reused when the
+    // same document is reopened
+    bool enableTileDiskCache;
+    // if true, mouse wheel scrolling coasts with inertia instead of
+    // jumping line by line
+    bool smoothScroll;
+    // if true, a successful search highlights all matches on the
+    // visible pages, not just the current one
+    bool highlightSearchMatches;
+    // controls the low-memory profile, which shrinks the render cache
+    // and disables speculative rendering and text extraction: "on" and
+    // "off" force it, "auto" follows the OS' memory pressure signal
+    char* lowMemoryMode;
+    // a background tab whose document hasn't been viewed for this many
+    // minutes is unloaded to save memory and transparently reloaded on
+    // its next activation (0 disables tab hibernation)
+    int tabHibernateAfterMin;
     // if true, we store display settings for each document separately
     // (i.e. everything after UseDefaultState in FileStates)
     bool rememberStatePerDocument;
@@ -601,6 +626,13 @@ static const FieldInfo gGlobalPrefsFields[] = {
     {offsetof(GlobalPrefs, annotationDefaults), SettingType::Prerelease, (intptr_t)&gAnnotationDefaultsInfo},
     {offsetof(GlobalPrefs, defaultPasswords), SettingType::StringArray, 0},
     {offsetof(GlobalPrefs, customScreenDPI), SettingType::Int, 0},
+    {offsetof(GlobalPrefs, renderCacheSize), SettingType::Int, 0},
+    {offsetof(GlobalPrefs, enableTextIndexCache), SettingType::Bool, false},
+    {offsetof(GlobalPrefs, enableTileDiskCache), SettingType::Bool, false},
+    {offsetof(GlobalPrefs, smoothScroll), SettingType::Bool, true},
+    {offsetof(GlobalPrefs, highlightSearchMatches), SettingType::Bool, true},
+    {offsetof(GlobalPrefs, lowMemoryMode), SettingType::Utf8String, (intptr_t) "auto"},
+    {offsetof(GlobalPrefs, tabHibernateAfterMin), SettingType::Int, 120},
     {(size_t)-1, SettingType::Comment, 0},
     {offsetof(GlobalPrefs, rememberStatePerDocument), SettingType::Bool, true},
     {offsetof(GlobalPrefs, uiLanguage), SettingType::Utf8String, 0},
@@ -634,10 +666,10 @@ static const FieldInfo gGlobalPrefsFields[] = {
      (intptr_t) "Settings after this line have not been recognized by the current version"},
 };
 static const StructInfo gGlobalPrefsInfo = {
-    sizeof(GlobalPrefs), 55, gGlobalPrefsFields,
+    sizeof(GlobalPrefs), 62, gGlobalPrefsFields,
     "\0\0MainWindowBackground\0EscToExit\0ReuseInstance\0UseSysColors\0RestoreSession\0TabWidth\0\0FixedPageUI\0EbookUI"
     "\0ComicBookUI\0ChmUI\0ExternalViewers\0ShowMenubar\0ReloadModifiedDocuments\0FullPathInTitle\0ZoomLevels\0ZoomIncr"
-    "ement\0\0PrinterDefaults\0ForwardSearch\0AnnotationDefaults\0DefaultPasswords\0CustomScreenDPI\0\0RememberStatePer"
+    "ement\0\0PrinterDefaults\0ForwardSearch\0AnnotationDefaults\0DefaultPasswords\0CustomScreenDPI\0RenderCacheSize\0EnableTextIndexCache\0EnableTileDiskCache\0SmoothScroll\0HighlightSearchMatches\0LowMemoryMode\0TabHibernateAfterMin\0\0RememberStatePer"
     "Document\0UiLanguage\0ShowToolbar\0ShowFavorites\0AssociatedExtensions\0AssociateSilently\0CheckForUpdates\0Versio"
     "nToSkip\0RememberOpenedFiles\0InverseSearchCmdLine\0EnableTeXEnhancements\0DefaultDisplayMode\0DefaultZoom\0Window"
     "State\0WindowPos\0ShowToc\0SidebarDx\0TocDy\0TreeFontSize\0ShowStartPage\0UseTabs\0\0FileStates\0SessionData\0Reop"
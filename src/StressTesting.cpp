@@ -11,6 +11,7 @@
 #include "utils/HtmlWindow.h"
 #include "mui/Mui.h"
 #include "utils/Log.h"
+#include "utils/MemAccounting.h"
 #include "utils/Timer.h"
 #include "utils/WinUtil.h"
 
@@ -63,36 +64,120 @@ static bool IsInRange(Vec<PageRange>& ranges, int pageNo) {
     return false;
 }
 
-static void BenchLoadRender(EngineBase* engine, int pagenum) {
+/* The -bench harness: repeats page load (parsing and building the page's
+   display list), rasterization and text extraction -bench-runs times over
+   either all pages, the pages given on the command line or a fixed-seed
+   sample (-bench-sample N), optionally reloading the document before every
+   run (-bench-cold). Per-phase percentiles go to the log and, with
+   -bench-output, to a JSON or CSV file so that results can be compared
+   across releases. */
+
+struct BenchPhase {
+    const char* name;
+    Vec<double> timesMs;
+};
+
+struct BenchDocResult {
+    AutoFreeWstr path;
+    int pageCount = 0;
+    BenchPhase load{"load"};
+    BenchPhase pageLoad{"pageload"};
+    BenchPhase render{"render"};
+    BenchPhase extractText{"textextract"};
+    // ebook documents are laid out rather than rendered, so they get
+    // these phases instead (see BenchEbookLayout)
+    BenchPhase layout{"layout"};
+    BenchPhase layoutParse{"parse"};
+    BenchPhase layoutCss{"css"};
+    BenchPhase layoutMeasure{"measure"};
+    BenchPhase layoutLine{"linebreak"};
+    BenchPhase layoutPage{"pagesplit"};
+};
+
+static int cmpDouble(const void* a, const void* b) {
+    double diff = *(const double*)a - *(const double*)b;
+    return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+// assumes the samples have been sorted; pct is in [0, 100]
+static double Percentile(Vec<double>& sorted, double pct) {
+    size_t n = sorted.size();
+    if (0 == n) {
+        return 0;
+    }
+    size_t idx = (size_t)(pct / 100.0 * (double)(n - 1) + 0.5);
+    if (idx >= n) {
+        idx = n - 1;
+    }
+    return sorted.at(idx);
+}
+
+static int cmpInt(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+// picks sampleSize out of pageCount pages with a fixed seed, so that runs
+// on different builds measure exactly the same pages
+static void SamplePages(int pageCount, int sampleSize, Vec<int>& pages) {
+    for (int i = 1; i <= pageCount; i++) {
+        pages.Append(i);
+    }
+    if (sampleSize <= 0 || sampleSize >= pageCount) {
+        return;
+    }
+    u32 seed = 0x5EED5EED;
+    for (int i = 0; i < sampleSize; i++) {
+        // plain LCG, deterministic across platforms
+        seed = seed * 1664525 + 1013904223;
+        int j = i + (int)(seed % (u32)(pageCount - i));
+        std::swap(pages.at(i), pages.at(j));
+    }
+    pages.RemoveAt(sampleSize, pages.size() - sampleSize);
+    pages.Sort(cmpInt);
+}
+
+static void BenchPage(EngineBase* engine, int pagenum, BenchDocResult& res) {
     auto t = TimeGet();
     bool ok = engine->BenchLoadPage(pagenum);
-
     if (!ok) {
         logf(L"Error: failed to load page %d", pagenum);
         return;
     }
-    double timeMs = TimeSinceInMs(t);
-    logf(L"pageload   %3d: %.2f ms", pagenum, timeMs);
+    res.pageLoad.timesMs.Append(TimeSinceInMs(t));
 
     t = TimeGet();
     RenderPageArgs args(pagenum, 1.0, 0);
     RenderedBitmap* rendered = engine->RenderPage(args);
-
     if (!rendered) {
         logf(L"Error: failed to render page %d", pagenum);
         return;
     }
     delete rendered;
-    timeMs = TimeSinceInMs(t);
-    logf(L"pagerender %3d: %.2f ms", pagenum, timeMs);
+    res.render.timesMs.Append(TimeSinceInMs(t));
+
+    t = TimeGet();
+    PageText text = engine->ExtractPageText(pagenum);
+    res.extractText.timesMs.Append(TimeSinceInMs(t));
+    FreePageText(&text);
 }
 
-static int FormatWholeDoc(Doc& doc) {
+static void LogPhaseStats(BenchPhase& phase) {
+    Vec<double>& t = phase.timesMs;
+    if (0 == t.size()) {
+        return;
+    }
+    t.Sort(cmpDouble);
+    logf(L"%-11S: %4d samples, min %7.2f ms, median %7.2f ms, p90 %7.2f ms, max %7.2f ms", phase.name, (int)t.size(),
+         Percentile(t, 0), Percentile(t, 50), Percentile(t, 90), Percentile(t, 100));
+}
+
+static int FormatWholeDoc(Doc& doc, HtmlLayoutStats* stats) {
     int PAGE_DX = 640;
     int PAGE_DY = 520;
 
     PoolAllocator textAllocator;
     HtmlFormatterArgs* formatterArgs = CreateFormatterArgsDoc(doc, PAGE_DX, PAGE_DY, &textAllocator);
+    formatterArgs->layoutStats = stats;
 
     HtmlFormatter* formatter = doc.CreateFormatter(formatterArgs);
     int nPages = 0;
@@ -105,48 +190,75 @@ static int FormatWholeDoc(Doc& doc) {
     return nPages;
 }
 
-static int TimeOneMethod(Doc& doc, TextRenderMethod method, const WCHAR* methodName) {
-    SetTextRenderMethod(method);
-    auto t = TimeGet();
-    int nPages = FormatWholeDoc(doc);
-    double timesms = TimeSinceInMs(t);
-    logf(L"%s: %.2f ms", methodName, timesms);
-    return nPages;
-}
-
-// this is to compare the time it takes to layout a whole ebook file
-// using different text measurement method (since the time is mostly
-// dominated by text measure)
-void BenchEbookLayout(const WCHAR* filePath) {
-    gLogBuf->Reset();
+/* For ebooks the cost is laying the whole book out, not rasterization, so
+   they get layout phases instead of the per-page ones: the formatter
+   attributes its time to CSS resolution, text measurement, line breaking
+   and page splitting (see HtmlLayoutStats), and whatever of the total is
+   left over is tokenizing and tag handling, reported as "parse". */
+static void BenchEbookLayout(const WCHAR* filePath, const Flags& flags, Vec<BenchDocResult*>& results) {
+    auto total = TimeGet();
     logf(L"Starting: %s", filePath);
-    if (!file::Exists(filePath)) {
-        logf(L"Error: file doesn't exist");
-        return;
+
+    BenchDocResult* res = new BenchDocResult();
+    res->path.SetCopy(filePath);
+
+    int runs = std::max(flags.benchRuns, 1);
+    Doc doc;
+    bool loaded = false;
+    for (int run = 0; run < runs; run++) {
+        if (!loaded) {
+            auto t = TimeGet();
+            doc = Doc::CreateFromFile(filePath);
+            if (doc.LoadingFailed()) {
+                logf(L"Error: failed to load %s", filePath);
+                doc.Delete();
+                delete res;
+                return;
+            }
+            res->load.timesMs.Append(TimeSinceInMs(t));
+            loaded = true;
+        }
+
+        HtmlLayoutStats stats;
+        auto t = TimeGet();
+        int nPages = FormatWholeDoc(doc, &stats);
+        double totalMs = TimeSinceInMs(t);
+        res->pageCount = nPages;
+        if (0 == run) {
+            logf(L"page count: %d", nPages);
+        }
+
+        double parseMs = totalMs - stats.cssMs - stats.measureMs - stats.lineMs - stats.pageMs;
+        if (parseMs < 0) {
+            parseMs = 0;
+        }
+        res->layout.timesMs.Append(totalMs);
+        res->layoutParse.timesMs.Append(parseMs);
+        res->layoutCss.timesMs.Append(stats.cssMs);
+        res->layoutMeasure.timesMs.Append(stats.measureMs);
+        res->layoutLine.timesMs.Append(stats.lineMs);
+        res->layoutPage.timesMs.Append(stats.pageMs);
+
+        if (flags.benchCold) {
+            // throw the document away so that the next run starts cold again
+            doc.Delete();
+            loaded = false;
+        }
     }
-    auto t = TimeGet();
-    Doc doc = Doc::CreateFromFile(filePath);
-    if (doc.LoadingFailed()) {
-        logf(L"Error: failed to load the file as doc");
+    if (loaded) {
         doc.Delete();
-        return;
     }
-    double timeMs = TimeSinceInMs(t);
-    logf(L"load: %.2f ms", timeMs);
 
-    int nPages = TimeOneMethod(doc, TextRenderMethodGdi, L"gdi       ");
-    TimeOneMethod(doc, TextRenderMethodGdiplus, L"gdi+      ");
-    TimeOneMethod(doc, TextRenderMethodGdiplusQuick, L"gdi+ quick");
-
-    // do it twice because the first run is very unfair to the first version that runs
-    // (probably because of font caching)
-    TimeOneMethod(doc, TextRenderMethodGdi, L"gdi       ");
-    TimeOneMethod(doc, TextRenderMethodGdiplus, L"gdi+      ");
-    TimeOneMethod(doc, TextRenderMethodGdiplusQuick, L"gdi+ quick");
-
-    doc.Delete();
+    LogPhaseStats(res->load);
+    LogPhaseStats(res->layout);
+    LogPhaseStats(res->layoutParse);
+    LogPhaseStats(res->layoutCss);
+    LogPhaseStats(res->layoutMeasure);
+    LogPhaseStats(res->layoutLine);
+    LogPhaseStats(res->layoutPage);
+    logf(L"Finished (in %.2f ms): %s", TimeSinceInMs(total), filePath);
 
-    logf(L"pages: %d", nPages);
+    results.Append(res);
 }
 
 static void BenchChmLoadOnly(const WCHAR* filePath) {
@@ -168,21 +280,18 @@ static void BenchChmLoadOnly(const WCHAR* filePath) {
     logf(L"Finished (in %.2f ms): %s", TimeSinceInMs(total), filePath);
 }
 
-static void BenchFile(const WCHAR* filePath, const WCHAR* pagesSpec) {
+static void BenchFile(const WCHAR* filePath, const WCHAR* pagesSpec, const Flags& flags,
+                      Vec<BenchDocResult*>& results) {
     if (!file::Exists(filePath)) {
         return;
     }
 
-    // ad-hoc: if enabled times layout instead of rendering and does layout
-    // using all text rendering methods, so that we can compare and find
-    // docs that take a long time to load
-
     Kind kind = GuessFileType(filePath, true);
     if (!kind) {
         return;
     }
     if (Doc::IsSupportedFileType(kind) && !gGlobalPrefs->ebookUI.useFixedPageUI) {
-        BenchEbookLayout(filePath);
+        BenchEbookLayout(filePath, flags, results);
         return;
     }
 
@@ -194,39 +303,63 @@ static void BenchFile(const WCHAR* filePath, const WCHAR* pagesSpec) {
     auto total = TimeGet();
     logf(L"Starting: %s", filePath);
 
-    auto t = TimeGet();
-    EngineBase* engine = CreateEngine(filePath);
-    if (!engine) {
-        logf(L"Error: failed to load %s", filePath);
-        return;
-    }
-
-    double timeMs = TimeSinceInMs(t);
-    logf(L"load: %.2f ms", timeMs);
-    int pages = engine->PageCount();
-    logf(L"page count: %d", pages);
-
-    if (nullptr == pagesSpec) {
-        for (int i = 1; i <= pages; i++) {
-            BenchLoadRender(engine, i);
+    BenchDocResult* res = new BenchDocResult();
+    res->path.SetCopy(filePath);
+
+    int runs = std::max(flags.benchRuns, 1);
+    EngineBase* engine = nullptr;
+    for (int run = 0; run < runs; run++) {
+        if (!engine) {
+            auto t = TimeGet();
+            engine = CreateEngine(filePath);
+            if (!engine) {
+                logf(L"Error: failed to load %s", filePath);
+                delete res;
+                return;
+            }
+            res->load.timesMs.Append(TimeSinceInMs(t));
+        }
+        int pages = engine->PageCount();
+        res->pageCount = pages;
+        if (0 == run) {
+            logf(L"page count: %d", pages);
         }
-    }
 
-    CrashIf(pagesSpec && !IsBenchPagesInfo(pagesSpec));
-    Vec<PageRange> ranges;
-    if (ParsePageRanges(pagesSpec, ranges)) {
-        for (size_t i = 0; i < ranges.size(); i++) {
-            for (int j = ranges.at(i).start; j <= ranges.at(i).end; j++) {
-                if (1 <= j && j <= pages) {
-                    BenchLoadRender(engine, j);
+        Vec<int> pagesToBench;
+        if (pagesSpec) {
+            CrashIf(!IsBenchPagesInfo(pagesSpec));
+            Vec<PageRange> ranges;
+            if (ParsePageRanges(pagesSpec, ranges)) {
+                for (size_t i = 0; i < ranges.size(); i++) {
+                    for (int j = ranges.at(i).start; j <= ranges.at(i).end && j <= pages; j++) {
+                        if (j >= 1) {
+                            pagesToBench.Append(j);
+                        }
+                    }
                 }
             }
+        } else {
+            SamplePages(pages, flags.benchSamplePages, pagesToBench);
+        }
+        for (int pageNo : pagesToBench) {
+            BenchPage(engine, pageNo, *res);
         }
-    }
 
+        if (flags.benchCold) {
+            // throw the document away so that the next run starts cold again
+            delete engine;
+            engine = nullptr;
+        }
+    }
     delete engine;
 
+    LogPhaseStats(res->load);
+    LogPhaseStats(res->pageLoad);
+    LogPhaseStats(res->render);
+    LogPhaseStats(res->extractText);
     logf(L"Finished (in %.2f ms): %s", TimeSinceInMs(total), filePath);
+
+    results.Append(res);
 }
 
 static bool IsFileToBench(const WCHAR* path) {
@@ -241,36 +374,123 @@ static bool IsFileToBench(const WCHAR* path) {
 }
 
 static void CollectFilesToBench(WCHAR* dir, WStrVec& files) {
-    DirIter di(dir, true /* recursive */);
-    for (const WCHAR* filePath = di.First(); filePath; filePath = di.Next()) {
+    WStrVec all;
+    CollectFilesParallel(dir, all);
+    for (const WCHAR* filePath : all) {
         if (IsFileToBench(filePath)) {
             files.Append(str::Dup(filePath));
         }
     }
 }
 
-static void BenchDir(WCHAR* dir) {
+static void BenchDir(WCHAR* dir, const Flags& flags, Vec<BenchDocResult*>& results) {
     WStrVec files;
     CollectFilesToBench(dir, files);
     for (size_t i = 0; i < files.size(); i++) {
-        BenchFile(files.at(i), nullptr);
+        BenchFile(files.at(i), nullptr, flags, results);
+    }
+}
+
+static void AppendJsonEscaped(str::Str& out, const WCHAR* s) {
+    AutoFree utf8(strconv::WstrToUtf8(s));
+    for (const char* c = utf8.Get(); c && *c; c++) {
+        if ('"' == *c || '\\' == *c) {
+            out.AppendChar('\\');
+            out.AppendChar(*c);
+        } else if ((u8)*c < 0x20) {
+            out.AppendFmt("\\u%04x", *c);
+        } else {
+            out.AppendChar(*c);
+        }
+    }
+}
+
+static void AppendPhaseStats(str::Str& out, BenchPhase& phase, bool csv) {
+    Vec<double>& t = phase.timesMs;
+    t.Sort(cmpDouble);
+    if (csv) {
+        out.AppendFmt("%s,%d,%.3f,%.3f,%.3f,%.3f\r\n", phase.name, (int)t.size(), Percentile(t, 0), Percentile(t, 50),
+                      Percentile(t, 90), Percentile(t, 100));
+    } else {
+        out.AppendFmt("\"%s\": {\"samples\": %d, \"minMs\": %.3f, \"medianMs\": %.3f, \"p90Ms\": %.3f, "
+                      "\"maxMs\": %.3f}",
+                      phase.name, (int)t.size(), Percentile(t, 0), Percentile(t, 50), Percentile(t, 90),
+                      Percentile(t, 100));
+    }
+}
+
+static void WriteBenchResults(const WCHAR* outPath, const Flags& flags, Vec<BenchDocResult*>& results) {
+    str::Str out;
+    bool csv = str::EndsWithI(outPath, L".csv");
+    if (csv) {
+        out.Append("file,pages,phase,samples,min_ms,median_ms,p90_ms,max_ms\r\n");
+    } else {
+        out.AppendFmt("{\n  \"mode\": \"%s\",\n  \"runs\": %d,\n  \"results\": [\n", flags.benchCold ? "cold" : "warm",
+                      std::max(flags.benchRuns, 1));
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        BenchDocResult* res = results.at(i);
+        BenchPhase* allPhases[] = {&res->load,   &res->pageLoad,    &res->render,    &res->extractText,
+                                   &res->layout, &res->layoutParse, &res->layoutCss, &res->layoutMeasure,
+                                   &res->layoutLine, &res->layoutPage};
+        // an ebook result has no samples for the page phases and vice versa
+        Vec<BenchPhase*> phases;
+        for (BenchPhase* phase : allPhases) {
+            if (phase->timesMs.size() > 0) {
+                phases.Append(phase);
+            }
+        }
+        if (csv) {
+            for (BenchPhase* phase : phases) {
+                AutoFree pathU(strconv::WstrToUtf8(res->path));
+                out.AppendFmt("\"%s\",%d,", pathU.Get(), res->pageCount);
+                AppendPhaseStats(out, *phase, true);
+            }
+        } else {
+            out.Append("    {\"file\": \"");
+            AppendJsonEscaped(out, res->path);
+            out.AppendFmt("\", \"pages\": %d, \"phases\": {", res->pageCount);
+            for (size_t p = 0; p < phases.size(); p++) {
+                AppendPhaseStats(out, *phases.at(p), false);
+                if (p + 1 < phases.size()) {
+                    out.Append(", ");
+                }
+            }
+            out.Append(i + 1 < results.size() ? "}},\n" : "}}\n");
+        }
+    }
+    if (!csv) {
+        out.Append("  ]\n}\n");
+    }
+    bool ok = file::WriteFile(outPath, out.AsSpan());
+    if (!ok) {
+        logf(L"Error: failed to write benchmark results to %s", outPath);
+    } else {
+        logf(L"Wrote benchmark results to %s", outPath);
     }
 }
 
-void BenchFileOrDir(WStrVec& pathsToBench) {
+void BenchFileOrDir(Flags& flags) {
     logToStderr = true;
 
+    Vec<BenchDocResult*> results;
+    WStrVec& pathsToBench = flags.pathsToBenchmark;
     size_t n = pathsToBench.size() / 2;
     for (size_t i = 0; i < n; i++) {
         WCHAR* path = pathsToBench.at(2 * i);
         if (file::Exists(path)) {
-            BenchFile(path, pathsToBench.at(2 * i + 1));
+            BenchFile(path, pathsToBench.at(2 * i + 1), flags, results);
         } else if (dir::Exists(path)) {
-            BenchDir(path);
+            BenchDir(path, flags, results);
         } else {
             logf(L"Error: file or dir %s doesn't exist", path);
         }
     }
+
+    if (flags.benchOutputPath && results.size() > 0) {
+        WriteBenchResults(flags.benchOutputPath, flags, results);
+    }
+    DeleteVecMembers(results);
 }
 
 static bool IsStressTestSupportedFile(const WCHAR* filePath, const WCHAR* filter) {
@@ -497,6 +717,38 @@ static size_t GetAllMatchingFiles(const WCHAR* dir, const WCHAR* filter, WStrVec
 a human advancing one page at a time. This is mostly to run through a large number
 of PDFs before a release to make sure we're crash proof. */
 
+// -stress-leak-check tracks the memacct subsystem counters plus, in the
+// last slot, the process' private bytes
+#define LEAK_COUNTER_COUNT (memacct::SubsysCount + 1)
+// flag a counter once it grew over this many consecutive files
+#define LEAK_STREAK_THRESHOLD 5
+// how many of the worst-growing files the leak report lists
+#define LEAK_REPORT_TOP_FILES 10
+
+// how much each counter grew while a file was open/rendered/replaced
+struct LeakFileRecord {
+    WCHAR* filePath{nullptr};
+    i64 growth[LEAK_COUNTER_COUNT]{};
+
+    ~LeakFileRecord() {
+        free(filePath);
+    }
+};
+
+static i64 ReadLeakCounter(int i) {
+    if (i < memacct::SubsysCount) {
+        return memacct::GetCurrent((memacct::Subsystem)i);
+    }
+    return memacct::GetProcessPrivateBytes();
+}
+
+static const char* LeakCounterName(int i) {
+    if (i < memacct::SubsysCount) {
+        return memacct::SubsysName((memacct::Subsystem)i);
+    }
+    return "private bytes";
+}
+
 struct StressTest {
     WindowInfo* win{nullptr};
     LARGE_INTEGER currPageRenderTime{0};
@@ -516,11 +768,23 @@ struct StressTest {
     // owned by StressTest
     TestFileProvider* fileProvider{nullptr};
 
+    // -stress-leak-check state: the counter snapshot taken when the
+    // current file was opened, which file it belongs to, per-counter
+    // runs of consecutive files with growth and the per-file records
+    bool leakCheck{false};
+    i64 memAtOpen[LEAK_COUNTER_COUNT]{};
+    WCHAR* leakCheckFile{nullptr};
+    int leakGrowthStreak[LEAK_COUNTER_COUNT]{};
+    Vec<LeakFileRecord*> leakRecords;
+
     bool OpenFile(const WCHAR* fileName);
 
     bool GoToNextPage();
     bool GoToNextFile();
 
+    void LeakCheckSnapshot(const WCHAR* nextFile);
+    void EmitLeakReport();
+
     void TickTimer();
     void Finished(bool success);
 
@@ -529,6 +793,8 @@ struct StressTest {
     }
     ~StressTest() {
         delete fileProvider;
+        free(leakCheckFile);
+        DeleteVecMembers(leakRecords);
     }
 
     void Start(const WCHAR* path, const WCHAR* filter, const WCHAR* ranges, int cycles);
@@ -571,9 +837,94 @@ void StressTest::Start(const WCHAR* path, const WCHAR* filter, const WCHAR* rang
     }
 }
 
+// called right before nextFile is loaded (and once more, with nullptr,
+// when the test ends). At that point the previous document is still
+// open, but since loading the next file releases its memory, growth that
+// persists from one snapshot to the next is attributed to the file that
+// was rendered in between
+void StressTest::LeakCheckSnapshot(const WCHAR* nextFile) {
+    if (!leakCheck) {
+        return;
+    }
+    i64 now[LEAK_COUNTER_COUNT];
+    for (int i = 0; i < LEAK_COUNTER_COUNT; i++) {
+        now[i] = ReadLeakCounter(i);
+    }
+    if (leakCheckFile) {
+        LeakFileRecord* rec = new LeakFileRecord();
+        rec->filePath = leakCheckFile;
+        leakCheckFile = nullptr;
+        for (int i = 0; i < LEAK_COUNTER_COUNT; i++) {
+            rec->growth[i] = now[i] - memAtOpen[i];
+            if (rec->growth[i] > 0) {
+                if (++leakGrowthStreak[i] == LEAK_STREAK_THRESHOLD) {
+                    logf("stress leak check: '%s' grew over %d consecutive files\n", LeakCounterName(i),
+                         LEAK_STREAK_THRESHOLD);
+                }
+            } else {
+                leakGrowthStreak[i] = 0;
+            }
+        }
+        leakRecords.Append(rec);
+    }
+    for (int i = 0; i < LEAK_COUNTER_COUNT; i++) {
+        memAtOpen[i] = now[i];
+    }
+    leakCheckFile = str::Dup(nextFile);
+}
+
+// ranks files by how much the process' private bytes grew while they
+// were being rendered; the per-subsystem columns show where in the
+// process that growth went
+static int cmpLeakRecords(const void* a, const void* b) {
+    LeakFileRecord* recA = *(LeakFileRecord**)a;
+    LeakFileRecord* recB = *(LeakFileRecord**)b;
+    i64 growthA = recA->growth[LEAK_COUNTER_COUNT - 1];
+    i64 growthB = recB->growth[LEAK_COUNTER_COUNT - 1];
+    if (growthA != growthB) {
+        return growthA < growthB ? 1 : -1;
+    }
+    return 0;
+}
+
+void StressTest::EmitLeakReport() {
+    if (!leakCheck || leakRecords.size() == 0) {
+        return;
+    }
+    leakRecords.Sort(cmpLeakRecords);
+
+    str::Str report;
+    report.Append("Stress leak report, files ranked by private bytes growth:\n");
+    int nFiles = (int)leakRecords.size();
+    for (int i = 0; i < nFiles && i < LEAK_REPORT_TOP_FILES; i++) {
+        LeakFileRecord* rec = leakRecords.at(i);
+        AutoFree path = strconv::WstrToUtf8(rec->filePath);
+        report.AppendFmt("%8d KB  %s\n", (int)(rec->growth[LEAK_COUNTER_COUNT - 1] / 1024), path.Get());
+        for (int j = 0; j < memacct::SubsysCount; j++) {
+            if (rec->growth[j] != 0) {
+                report.AppendFmt("              %-12s %+d KB\n", LeakCounterName(j), (int)(rec->growth[j] / 1024));
+            }
+        }
+    }
+    for (int i = 0; i < LEAK_COUNTER_COUNT; i++) {
+        if (leakGrowthStreak[i] >= LEAK_STREAK_THRESHOLD) {
+            report.AppendFmt("'%s' still growing after the last %d files - likely leak\n", LeakCounterName(i),
+                             leakGrowthStreak[i]);
+        }
+    }
+    log(report.AsView());
+    wprintf(L"%hs", report.Get());
+    fflush(stdout);
+}
+
 void StressTest::Finished(bool success) {
     win->stressTest = nullptr; // make sure we're not double-deleted
 
+    // close out the last file's measurement and report before the window
+    // (and with it this object) goes away
+    LeakCheckSnapshot(nullptr);
+    EmitLeakReport();
+
     if (success) {
         int secs = SecsSinceSystemTime(stressStartTime);
         AutoFreeWstr tm(FormatTime(secs));
@@ -608,6 +959,8 @@ bool StressTest::OpenFile(const WCHAR* fileName) {
     wprintf(L"%s\n", fileName);
     fflush(stdout);
 
+    LeakCheckSnapshot(fileName);
+
     LoadArgs args(fileName, nullptr);
     args.forceReuse = rand() % 3 != 1;
     WindowInfo* w = LoadDocument(args);
@@ -865,6 +1218,194 @@ static void RandomizeFiles(WStrVec& files, int maxPerType) {
     }
 }
 
+/* Multi-process stress orchestration. Instead of crawling the whole
+   directory in-process, each file is tested by its own child SumatraPDF
+   process (reusing the -stress-test plumbing), so a crash or hang only
+   costs that one file. Children run up to stressProcessCount at a time,
+   are killed after stressFileTimeoutSecs and the per-file results are
+   collected into a report. */
+
+struct StressChildResult {
+    AutoFreeWstr path;
+    double durMs = 0;
+    DWORD exitCode = 0;
+    bool timedOut = false;
+};
+
+struct StressChildProc {
+    HANDLE process = nullptr;
+    LARGE_INTEGER timeStart{};
+    DWORD deadlineTick = 0;
+    StressChildResult* res = nullptr;
+};
+
+static HANDLE StartStressChild(const WCHAR* filePath, const Flags& flags) {
+    AutoFreeWstr exePath(GetExePath());
+    str::WStr cmd;
+    cmd.AppendFmt(L"\"%s\" -stress-test \"%s\"", exePath.Get(), filePath);
+    if (flags.stressTestRanges) {
+        cmd.AppendFmt(L" %s", flags.stressTestRanges);
+    }
+    if (flags.stressTestCycles > 1) {
+        cmd.AppendFmt(L" %dx", flags.stressTestCycles);
+    }
+    cmd.Append(L" -exit-when-done");
+    return LaunchProcess(cmd.Get());
+}
+
+static void PrintStressChildResult(StressChildResult* res) {
+    if (res->timedOut) {
+        wprintf(L"hang (killed after %.0f ms): %s\n", res->durMs, res->path.Get());
+    } else if (res->exitCode != 0) {
+        wprintf(L"fail (exit code 0x%08X): %s\n", res->exitCode, res->path.Get());
+    } else {
+        wprintf(L"ok (%.0f ms): %s\n", res->durMs, res->path.Get());
+    }
+    fflush(stdout);
+}
+
+static void WriteStressReport(const WCHAR* reportPath, Vec<StressChildResult*>& results, int totalSecs) {
+    int nOk = 0, nFailed = 0, nHung = 0;
+    for (auto res : results) {
+        if (res->timedOut) {
+            nHung++;
+        } else if (res->exitCode != 0) {
+            nFailed++;
+        } else {
+            nOk++;
+        }
+    }
+
+    str::Str report;
+    report.AppendFmt("%d files: %d ok, %d failed, %d hung\n", (int)results.size(), nOk, nFailed, nHung);
+    FormatTime(totalSecs, &report);
+    report.Append("\n\n");
+    for (auto res : results) {
+        AutoFree pathA(strconv::WstrToUtf8(res->path.Get()));
+        if (res->timedOut) {
+            report.AppendFmt("hang            %8.0f ms %s\n", res->durMs, pathA.Get());
+        } else if (res->exitCode != 0) {
+            report.AppendFmt("fail 0x%08X %8.0f ms %s\n", res->exitCode, res->durMs, pathA.Get());
+        } else {
+            report.AppendFmt("ok              %8.0f ms %s\n", res->durMs, pathA.Get());
+        }
+    }
+    bool ok = file::WriteFile(reportPath, report.AsSpan());
+    if (!ok) {
+        wprintf(L"Error: failed to write report to %s\n", reportPath);
+    }
+}
+
+void RunStressOrchestrator(Flags& flags) {
+    WStrVec files;
+    if (dir::Exists(flags.stressTestPath)) {
+        wprintf(L"Scanning for files in directory %s\n", flags.stressTestPath);
+        fflush(stdout);
+        GetAllMatchingFiles(flags.stressTestPath, flags.stressTestFilter, files, true);
+    } else if (file::Exists(flags.stressTestPath)) {
+        files.Append(str::Dup(flags.stressTestPath));
+    }
+    if (0 == files.size()) {
+        wprintf(L"Didn't find any files matching filter '%s'\n", flags.stressTestFilter);
+        return;
+    }
+    if (flags.stressRandomizeFiles) {
+        RandomizeFiles(files, 100);
+    }
+
+    // WaitForMultipleObjects limits how many children we can watch at once
+    int nProcs = limitValue(flags.stressProcessCount, 2, (int)MAXIMUM_WAIT_OBJECTS);
+    DWORD timeoutMs = (DWORD)limitValue(flags.stressFileTimeoutSecs, 1, 24 * 60 * 60) * 1000;
+    wprintf(L"Testing %d files in %d processes, %d s timeout per file\n", (int)files.size(), nProcs,
+            flags.stressFileTimeoutSecs);
+    fflush(stdout);
+
+    SYSTEMTIME startTime;
+    GetSystemTime(&startTime);
+
+    Vec<StressChildResult*> results;
+    Vec<StressChildProc> running;
+    size_t nextFile = 0;
+
+    while (nextFile < files.size() || running.size() > 0) {
+        while (running.isize() < nProcs && nextFile < files.size()) {
+            const WCHAR* path = files.at(nextFile++);
+            auto res = new StressChildResult();
+            res->path.SetCopy(path);
+            StressChildProc proc;
+            proc.timeStart = TimeGet();
+            proc.process = StartStressChild(path, flags);
+            proc.res = res;
+            if (!proc.process) {
+                res->exitCode = (DWORD)-1;
+                PrintStressChildResult(res);
+                results.Append(res);
+                continue;
+            }
+            proc.deadlineTick = GetTickCount() + timeoutMs;
+            running.Append(proc);
+        }
+        if (0 == running.size()) {
+            continue;
+        }
+
+        HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+        DWORD count = (DWORD)running.size();
+        for (DWORD i = 0; i < count; i++) {
+            handles[i] = running.at(i).process;
+        }
+        // wake up at least once a second to check the deadlines below
+        DWORD waitRes = WaitForMultipleObjects(count, handles, FALSE, 1000);
+        if (waitRes >= WAIT_OBJECT_0 && waitRes < WAIT_OBJECT_0 + count) {
+            size_t idx = waitRes - WAIT_OBJECT_0;
+            StressChildProc proc = running.at(idx);
+            proc.res->durMs = TimeSinceInMs(proc.timeStart);
+            GetExitCodeProcess(proc.process, &proc.res->exitCode);
+            CloseHandle(proc.process);
+            PrintStressChildResult(proc.res);
+            results.Append(proc.res);
+            running.RemoveAtFast(idx);
+        }
+
+        DWORD now = GetTickCount();
+        for (size_t i = 0; i < running.size();) {
+            StressChildProc& proc = running.at(i);
+            if ((int)(now - proc.deadlineTick) < 0) {
+                i++;
+                continue;
+            }
+            TerminateProcess(proc.process, 1);
+            WaitForSingleObject(proc.process, 10 * 1000);
+            CloseHandle(proc.process);
+            proc.res->durMs = TimeSinceInMs(proc.timeStart);
+            proc.res->timedOut = true;
+            PrintStressChildResult(proc.res);
+            results.Append(proc.res);
+            running.RemoveAtFast(i);
+        }
+    }
+
+    int secs = SecsSinceSystemTime(startTime);
+    int nOk = 0, nFailed = 0, nHung = 0;
+    for (auto res : results) {
+        if (res->timedOut) {
+            nHung++;
+        } else if (res->exitCode != 0) {
+            nFailed++;
+        } else {
+            nOk++;
+        }
+    }
+    AutoFreeWstr tm(FormatTime(secs));
+    wprintf(L"Done in %s: %d ok, %d failed, %d hung\n", tm.Get(), nOk, nFailed, nHung);
+    fflush(stdout);
+
+    if (flags.stressReportPath) {
+        WriteStressReport(flags.stressReportPath, results, secs);
+    }
+    DeleteVecMembers(results);
+}
+
 void StartStressTest(Flags* i, WindowInfo* win) {
     gIsStressTesting = true;
     // TODO: for now stress testing only supports the non-ebook ui
@@ -913,6 +1454,7 @@ void StartStressTest(Flags* i, WindowInfo* win) {
             // dst will be deleted when the stress ends
             win = windows[j];
             StressTest* dst = new StressTest(win, i->exitWhenDone);
+            dst->leakCheck = i->stressLeakCheck;
             win->stressTest = dst;
             // divide filesToTest among each window
             FilesProvider* filesProvider = new FilesProvider(filesToTest, n, j);
@@ -923,6 +1465,7 @@ void StartStressTest(Flags* i, WindowInfo* win) {
     } else {
         // dst will be deleted when the stress ends
         StressTest* dst = new StressTest(win, i->exitWhenDone);
+        dst->leakCheck = i->stressLeakCheck;
         win->stressTest = dst;
         dst->Start(i->stressTestPath, i->stressTestFilter, i->stressTestRanges, i->stressTestCycles);
     }
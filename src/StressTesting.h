@@ -1,16 +1,17 @@
 /* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
    License: GPLv3 */
 
+struct Flags;
+struct WindowInfo;
+
 bool IsValidPageRange(const WCHAR* ranges);
 bool IsBenchPagesInfo(const WCHAR* s);
-void BenchFileOrDir(WStrVec& pathsToBench);
+void BenchFileOrDir(Flags& flags);
 bool IsStressTesting();
-void BenchEbookLayout(WCHAR* filePath);
-
-struct Flags;
-struct WindowInfo;
 
 void StartStressTest(Flags* i, WindowInfo* win);
+// shards the stress run across child processes, see StressTesting.cpp
+void RunStressOrchestrator(Flags& flags);
 
 void OnStressTestTimer(WindowInfo* win, int timerId);
 void FinishStressTest(WindowInfo* win);
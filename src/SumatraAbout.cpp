@@ -642,7 +642,107 @@ void DrawAboutPage(WindowInfo* win, HDC hdc) {
 #define DOCLIST_MAX_THUMBNAILS_X 5
 #define DOCLIST_BOTTOM_BOX_DY DpiScale(win->hwndFrame, 50)
 
-void DrawStartPage(WindowInfo* win, HDC hdc, FileHistory& fileHistory, COLORREF textColor, COLORREF backgroundColor) {
+/* Caches for the start page, which gets a full WM_PAINT on every resize
+   step and mouse-over. Re-rendering from scratch means re-coloring every
+   thumbnail bitmap and asking the shell for every file's icon, which
+   visibly lags with a page of history entries; re-colored thumbnails and
+   icon indices are cached across paints and a fully unchanged page is a
+   single blit from a retained buffer (see DrawStartPage). */
+
+// a thumbnail adjusted to the current theme colors; the source pointer
+// is only ever compared, the bitmap it points to may be gone
+struct RecoloredThumbnail {
+    RenderedBitmap* src{nullptr};
+    COLORREF textColor{0};
+    COLORREF backgroundColor{0};
+    RenderedBitmap* bmp{nullptr};
+    bool used{false};
+};
+static Vec<RecoloredThumbnail*> gRecoloredThumbnails;
+
+// SHGetFileInfo hits the disk and the registry; the system image list
+// and the icon index for a path are stable for the session
+struct CachedFileIcon {
+    WCHAR* filePath{nullptr};
+    HIMAGELIST himl{nullptr};
+    int iconIdx{0};
+    bool used{false};
+};
+static Vec<CachedFileIcon*> gFileIcons;
+
+static RenderedBitmap* GetRecoloredThumbnail(RenderedBitmap* src, COLORREF textColor, COLORREF backgroundColor) {
+    for (RecoloredThumbnail* e : gRecoloredThumbnails) {
+        if (e->src == src && e->textColor == textColor && e->backgroundColor == backgroundColor) {
+            e->used = true;
+            return e->bmp;
+        }
+    }
+    RenderedBitmap* clone = src->Clone();
+    if (!clone) {
+        return nullptr;
+    }
+    UpdateBitmapColors(clone->GetBitmap(), textColor, backgroundColor);
+    auto e = new RecoloredThumbnail();
+    e->src = src;
+    e->textColor = textColor;
+    e->backgroundColor = backgroundColor;
+    e->bmp = clone;
+    e->used = true;
+    gRecoloredThumbnails.Append(e);
+    return clone;
+}
+
+static HIMAGELIST GetFileIcon(const WCHAR* filePath, int* iconIdxOut) {
+    for (CachedFileIcon* e : gFileIcons) {
+        if (str::EqI(e->filePath, filePath)) {
+            e->used = true;
+            *iconIdxOut = e->iconIdx;
+            return e->himl;
+        }
+    }
+    // note: this crashes asan build in windows code
+    // see https://codeeval.dev/gist/bc761bb1ef1cce04e6a1d65e9d30201b
+    SHFILEINFO sfi = {0};
+    uint flags = SHGFI_SYSICONINDEX | SHGFI_SMALLICON | SHGFI_USEFILEATTRIBUTES;
+    HIMAGELIST himl = (HIMAGELIST)SHGetFileInfoW(filePath, 0, &sfi, sizeof(sfi), flags);
+    auto e = new CachedFileIcon();
+    e->filePath = str::Dup(filePath);
+    e->himl = himl;
+    e->iconIdx = sfi.iIcon;
+    e->used = true;
+    gFileIcons.Append(e);
+    *iconIdxOut = sfi.iIcon;
+    return himl;
+}
+
+// drops cache entries that the rendering didn't touch (files no longer
+// in the frequency list, thumbnails that have been replaced, colors
+// from the previous theme) and re-arms the usage flags
+static void SweepStartPageCaches() {
+    for (int i = gRecoloredThumbnails.isize() - 1; i >= 0; i--) {
+        RecoloredThumbnail* e = gRecoloredThumbnails.at(i);
+        if (!e->used) {
+            delete e->bmp;
+            delete e;
+            gRecoloredThumbnails.RemoveAtFast(i);
+        } else {
+            e->used = false;
+        }
+    }
+    for (int i = gFileIcons.isize() - 1; i >= 0; i--) {
+        CachedFileIcon* e = gFileIcons.at(i);
+        if (!e->used) {
+            free(e->filePath);
+            delete e;
+            gFileIcons.RemoveAtFast(i);
+        } else {
+            e->used = false;
+        }
+    }
+}
+
+static void DrawStartPageContent(WindowInfo* win, HDC hdc, FileHistory& fileHistory, COLORREF textColor,
+                                 COLORREF backgroundColor) {
     auto col = GetAppColor(AppColor::MainWindowText);
     AutoDeletePen penBorder(CreatePen(PS_SOLID, DOCLIST_SEPARATOR_DY, col));
     AutoDeletePen penThumbBorder(CreatePen(PS_SOLID, DOCLIST_THUMBNAIL_BORDER_W, col));
@@ -751,11 +851,9 @@ void DrawStartPage(WindowInfo* win, HDC hdc, FileHistory& fileHistory, COLORREF
                 }
                 HRGN clip = CreateRoundRectRgn(page.x, page.y, page.x + page.dx, page.y + page.dy, 10, 10);
                 SelectClipRgn(hdc, clip);
-                RenderedBitmap* clone = state->thumbnail->Clone();
-                if (clone) {
-                    UpdateBitmapColors(clone->GetBitmap(), textColor, backgroundColor);
-                    clone->StretchDIBits(hdc, page);
-                    delete clone;
+                RenderedBitmap* recolored = GetRecoloredThumbnail(state->thumbnail, textColor, backgroundColor);
+                if (recolored) {
+                    recolored->StretchDIBits(hdc, page);
                 } else {
                     state->thumbnail->StretchDIBits(hdc, page);
                 }
@@ -773,13 +871,10 @@ void DrawStartPage(WindowInfo* win, HDC hdc, FileHistory& fileHistory, COLORREF
             DrawText(hdc, path::GetBaseNameNoFree(state->filePath), -1, &rTmp,
                      DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX | (isRtl ? DT_RIGHT : DT_LEFT));
 
-            // note: this crashes asan build in windows code
-            // see https://codeeval.dev/gist/bc761bb1ef1cce04e6a1d65e9d30201b
-            SHFILEINFO sfi = {0};
-            uint flags = SHGFI_SYSICONINDEX | SHGFI_SMALLICON | SHGFI_USEFILEATTRIBUTES;
-            HIMAGELIST himl = (HIMAGELIST)SHGetFileInfoW(state->filePath, 0, &sfi, sizeof(sfi), flags);
+            int iconIdx = 0;
+            HIMAGELIST himl = GetFileIcon(state->filePath, &iconIdx);
             x = isRtl ? page.x + page.dx - DpiScale(win->hwndFrame, 16) : page.x;
-            ImageList_Draw(himl, sfi.iIcon, hdc, x, rect.y, ILD_TRANSPARENT);
+            ImageList_Draw(himl, iconIdx, hdc, x, rect.y, ILD_TRANSPARENT);
             win->staticLinks.Append(StaticLinkInfo(rect.Union(page), state->filePath, state->filePath));
         }
     }
@@ -823,4 +918,85 @@ void DrawStartPage(WindowInfo* win, HDC hdc, FileHistory& fileHistory, COLORREF
         rect = DrawSupportLink(win->hwndCanvas, hdc, _TR("Support SumatraPDF"));
         win->staticLinks.Append(StaticLinkInfo(rect, URL_SUPPORT_SUMATRA));
     }
+
+    SweepStartPageCaches();
+}
+
+/* The retained rendering of a window's start page: as long as nothing on
+   the page changed, a paint is a single blit from here. Kept per window
+   (each can show the start page at its own size and theme). */
+struct StartPageBuffer {
+    WindowInfo* win{nullptr};
+    DoubleBuffer* buffer{nullptr};
+    u32 signature{0};
+    // the links computed during the buffered rendering; restored on
+    // every blit since e.g. the About page overwrites win->staticLinks
+    Vec<StaticLinkInfo> links;
+};
+static Vec<StartPageBuffer*> gStartPageBuffers;
+
+// a cheap fingerprint of everything DrawStartPageContent's output depends
+// on; pointers are only mixed in, never followed (replacing a thumbnail
+// or history entry changes the respective pointer)
+static u32 StartPageSignature(WindowInfo* win, FileHistory& fileHistory, COLORREF textColor,
+                              COLORREF backgroundColor) {
+    u32 sig = 0;
+    auto mix = [&sig](u64 v) { sig = sig * 31 + (u32)v + (u32)(v >> 32); };
+    mix(textColor);
+    mix(backgroundColor);
+    mix(IsUIRightToLeft());
+    mix(DpiScale(win->hwndFrame, 100));
+    // translation tables swap the string pointers
+    mix((uintptr_t)_TR("Frequently Read"));
+    Vec<DisplayState*> list;
+    fileHistory.GetFrequencyOrder(list);
+    for (DisplayState* state : list) {
+        mix((uintptr_t)state);
+        mix((uintptr_t)state->filePath);
+        mix((uintptr_t)state->thumbnail);
+    }
+    return sig;
+}
+
+void DrawStartPage(WindowInfo* win, HDC hdc, FileHistory& fileHistory, COLORREF textColor, COLORREF backgroundColor) {
+    StartPageBuffer* buf = nullptr;
+    for (StartPageBuffer* e : gStartPageBuffers) {
+        if (e->win == win) {
+            buf = e;
+            break;
+        }
+    }
+    if (!buf) {
+        buf = new StartPageBuffer();
+        buf->win = win;
+        gStartPageBuffers.Append(buf);
+    }
+
+    Rect rc = ClientRect(win->hwndCanvas);
+    u32 sig = StartPageSignature(win, fileHistory, textColor, backgroundColor);
+    if (!buf->buffer || !(buf->buffer->rect == rc) || buf->signature != sig) {
+        delete buf->buffer;
+        buf->buffer = new DoubleBuffer(win->hwndCanvas, rc);
+        DrawStartPageContent(win, buf->buffer->GetDC(), fileHistory, textColor, backgroundColor);
+        // rendering loads missing thumbnails, take the fingerprint after
+        // it so the next paint doesn't re-render a second time
+        buf->signature = StartPageSignature(win, fileHistory, textColor, backgroundColor);
+        buf->links = win->staticLinks;
+    } else {
+        win->staticLinks = buf->links;
+    }
+    buf->buffer->Flush(hdc);
+}
+
+void DeleteStartPageBuffer(WindowInfo* win) {
+    for (int i = 0; i < gStartPageBuffers.isize(); i++) {
+        StartPageBuffer* e = gStartPageBuffers.at(i);
+        if (e->win != win) {
+            continue;
+        }
+        delete e->buffer;
+        delete e;
+        gStartPageBuffers.RemoveAtFast(i);
+        return;
+    }
 }
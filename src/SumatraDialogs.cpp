@@ -846,9 +846,35 @@ static INT_PTR CALLBACK Sheet_Print_Advanced_Proc(HWND hDlg, UINT msg, WPARAM wp
                     ? IDC_PRINT_SCALE_FIT
                     : data->scale == PrintScaleAdv::Shrink ? IDC_PRINT_SCALE_SHRINK : IDC_PRINT_SCALE_NONE);
 
+            if (data->preview) {
+                // kicks off the asynchronous render; the preview pane is
+                // repainted once the bitmap is ready
+                StartPrintPreviewRender(data->preview, GetDlgItem(hDlg, IDC_PRINT_PREVIEW));
+            }
+
             return FALSE;
             //] ACCESSKEY_GROUP Advanced Print Tab
 
+        case WM_DRAWITEM:
+            if (IDC_PRINT_PREVIEW == wp) {
+                data = (Print_Advanced_Data*)GetWindowLongPtr(hDlg, GWLP_USERDATA);
+                DRAWITEMSTRUCT* dis = (DRAWITEMSTRUCT*)lp;
+                if (data && data->preview) {
+                    PrintScaleAdv scale = PrintScaleAdv::None;
+                    if (IsDlgButtonChecked(hDlg, IDC_PRINT_SCALE_FIT)) {
+                        scale = PrintScaleAdv::Fit;
+                    } else if (IsDlgButtonChecked(hDlg, IDC_PRINT_SCALE_SHRINK)) {
+                        scale = PrintScaleAdv::Shrink;
+                    }
+                    DrawPrintPreview(data->preview, dis->hDC, Rect::FromRECT(dis->rcItem), scale);
+                } else {
+                    // no printer to preview for
+                    FillRect(dis->hDC, &dis->rcItem, GetSysColorBrush(COLOR_BTNFACE));
+                }
+                return TRUE;
+            }
+            break;
+
         case WM_NOTIFY:
             if (((LPNMHDR)lp)->code == PSN_APPLY) {
                 data = (Print_Advanced_Data*)GetWindowLongPtr(hDlg, GWLP_USERDATA);
@@ -872,12 +898,16 @@ static INT_PTR CALLBACK Sheet_Print_Advanced_Proc(HWND hDlg, UINT msg, WPARAM wp
 
         case WM_COMMAND:
             switch (LOWORD(wp)) {
-                case IDC_PRINT_RANGE_ALL:
-                case IDC_PRINT_RANGE_EVEN:
-                case IDC_PRINT_RANGE_ODD:
                 case IDC_PRINT_SCALE_SHRINK:
                 case IDC_PRINT_SCALE_FIT:
-                case IDC_PRINT_SCALE_NONE: {
+                case IDC_PRINT_SCALE_NONE:
+                    // the scaling option changes where the page lands on
+                    // the paper, reflect it in the preview
+                    InvalidateRect(GetDlgItem(hDlg, IDC_PRINT_PREVIEW), nullptr, TRUE);
+                    // (also enables the Apply button below)
+                case IDC_PRINT_RANGE_ALL:
+                case IDC_PRINT_RANGE_EVEN:
+                case IDC_PRINT_RANGE_ODD: {
                     HWND hApplyButton = GetDlgItem(GetParent(hDlg), ID_APPLY_NOW);
                     EnableWindow(hApplyButton, TRUE);
                 } break;
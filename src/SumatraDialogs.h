@@ -18,10 +18,15 @@ enum class PrintRangeAdv { All = 0, Even, Odd };
 enum class PrintScaleAdv { None = 0, Shrink, Fit };
 enum class PrintRotationAdv { Auto = 0, Portrait, Landscape };
 
+struct PrintPreviewData;
+
 struct Print_Advanced_Data {
     PrintRangeAdv range;
     PrintScaleAdv scale;
     PrintRotationAdv rotation;
+    // backs the preview pane of the dialog (nullptr when there's no
+    // printer); owned by OnMenuPrint, which outlives the dialog
+    PrintPreviewData* preview = nullptr;
 
     explicit Print_Advanced_Data(PrintRangeAdv range = PrintRangeAdv::All, PrintScaleAdv scale = PrintScaleAdv::Shrink,
                                  PrintRotationAdv rotation = PrintRotationAdv::Auto)
@@ -30,3 +35,8 @@ struct Print_Advanced_Data {
 };
 
 HPROPSHEETPAGE CreatePrintAdvancedPropSheet(Print_Advanced_Data* data, ScopedMem<DLGTEMPLATE>& dlgTemplate);
+
+// the preview pane of the advanced print tab, implemented in Print.cpp
+// (that's where the page scaling logic it previews lives)
+void StartPrintPreviewRender(PrintPreviewData* preview, HWND hwndPreview);
+void DrawPrintPreview(PrintPreviewData* preview, HDC hdc, Rect rc, PrintScaleAdv scale);
@@ -14,6 +14,7 @@
 #include "utils/HttpUtil.h"
 #include "utils/SquareTreeParser.h"
 #include "utils/ThreadUtil.h"
+#include "utils/MemAccounting.h"
 #include "utils/UITask.h"
 #include "utils/WinUtil.h"
 #include "utils/LogDbg.h"
@@ -36,6 +37,7 @@
 #include "EngineBase.h"
 #include "EnginePs.h"
 #include "EngineCreate.h"
+#include "EngineEbook.h"
 #include "EngineMulti.h"
 #include "EngineImages.h"
 #include "EnginePdf.h"
@@ -46,6 +48,7 @@
 #include "Controller.h"
 #include "GlobalPrefs.h"
 #include "ChmModel.h"
+#include "DibPool.h"
 #include "DisplayModel.h"
 #include "EbookController.h"
 #include "FileHistory.h"
@@ -73,7 +76,10 @@
 #include "Favorites.h"
 #include "FileThumbnails.h"
 #include "Menu.h"
+#include "PageThumbnails.h"
 #include "Print.h"
+#include "QuickOpen.h"
+#include "SearchAllTabs.h"
 #include "SearchAndDDE.h"
 #include "Selection.h"
 #include "StressTesting.h"
@@ -89,6 +95,8 @@
 #include "SumatraConfig.h"
 #include "EditAnnotations.h"
 
+#pragma warning(disable : 28159) // silence /analyze: Consider using 'GetTickCount64' instead of 'GetTickCount'
+
 // the default is for pre-release version.
 // for release we override BuildConfig.h and set to
 // clang-format off
@@ -159,6 +167,10 @@ bool gSuppressAltKey = false;
 
 bool gCrashOnOpen = false;
 
+// launched with -preload: stay resident as a hidden, warmed-up instance
+// instead of quitting with the last window (see SumatraStartup.cpp)
+bool gIsPreloadedInstance = false;
+
 // in restricted mode, some features can be disabled (such as
 // opening files, printing, following URLs), so that SumatraPDF
 // can be used as a PDF reader on locked down systems
@@ -176,6 +188,7 @@ static void CloseDocumentInTab(WindowInfo*, bool keepUIEnabled = false, bool del
 static void UpdatePageInfoHelper(WindowInfo*, NotificationWnd* wnd = nullptr, int pageNo = -1);
 static void OnSidebarSplitterMove(SplitterMoveEvent*);
 static void OnFavSplitterMove(SplitterMoveEvent*);
+static void OnThumbsSplitterMove(SplitterMoveEvent*);
 static void DownloadDebugSymbols();
 
 void SetCurrentLang(const char* langCode) {
@@ -359,6 +372,10 @@ static bool IsWindowInfoHwnd(WindowInfo* win, HWND hwnd, HWND parent) {
     if (parent == win->hwndFavBox) {
         return true;
     }
+    // page thumbnails list, title, and close button
+    if (parent == win->hwndThumbsBox) {
+        return true;
+    }
     // tab bar
     if (parent == win->tabsCtrl->hwnd) {
         return true;
@@ -705,6 +722,7 @@ struct ControllerCallbackHandler : ControllerCallback {
     void PageNoChanged(Controller* ctrl, int pageNo) override;
     void UpdateScrollbars(Size canvas) override;
     void RequestRendering(int pageNo) override;
+    void CancelQueuedRendering() override;
     void CleanUp(DisplayModel* dm) override;
     void RenderThumbnail(DisplayModel* dm, Size size, const onBitmapRenderedCb&) override;
     void GotoLink(PageDestination* dest) override {
@@ -788,6 +806,14 @@ void ControllerCallbackHandler::RequestRendering(int pageNo) {
     }
 }
 
+void ControllerCallbackHandler::CancelQueuedRendering() {
+    DisplayModel* dm = win->AsFixed();
+    if (dm) {
+        // doesn't abort in-flight renders, those are still likely to be useful
+        gRenderCache.ClearQueueForDisplayModel(dm);
+    }
+}
+
 void ControllerCallbackHandler::CleanUp(DisplayModel* dm) {
     gRenderCache.CancelRendering(dm);
     gRenderCache.FreeForDisplayModel(dm);
@@ -894,6 +920,7 @@ void ControllerCallbackHandler::PageNoChanged(Controller* ctrl, int pageNo) {
 
     UpdateTocSelection(win, pageNo);
     win->currPageNo = pageNo;
+    PageThumbnailsOnPageChanged(win);
 
     NotificationWnd* wnd = win->notifications->GetForGroup(NG_PAGE_INFO_HELPER);
     if (wnd) {
@@ -903,13 +930,13 @@ void ControllerCallbackHandler::PageNoChanged(Controller* ctrl, int pageNo) {
 }
 
 static Controller* CreateControllerForEngine(EngineBase* engine, const WCHAR* filePath, PasswordUI* pwdUI,
-                                             WindowInfo* win) {
+                                             WindowInfo* win, DocumentTextCache* sharedTextCache = nullptr) {
     logf(L"CreateControllerForEngine: '%s'\n", filePath);
     if (!win->cbHandler) {
         win->cbHandler = new ControllerCallbackHandler(win);
     }
     Controller* ctrl = nullptr;
-    ctrl = new DisplayModel(engine, win->cbHandler);
+    ctrl = new DisplayModel(engine, win->cbHandler, sharedTextCache);
     CrashIf(!ctrl || !ctrl->AsFixed() || ctrl->AsChm() || ctrl->AsEbook());
     return ctrl;
 }
@@ -969,7 +996,8 @@ static Controller* CreateForChm(const WCHAR* path, PasswordUI* pwdUI, WindowInfo
     return ctrl;
 }
 
-static Controller* CreateControllerForFile(const WCHAR* path, PasswordUI* pwdUI, WindowInfo* win) {
+static Controller* CreateControllerForFile(const WCHAR* path, PasswordUI* pwdUI, WindowInfo* win,
+                                           bool reflow = false) {
     logf(L"CreateControllerForFile: '%s'\n", path);
     if (!win->cbHandler) {
         win->cbHandler = new ControllerCallbackHandler(win);
@@ -983,6 +1011,14 @@ static Controller* CreateControllerForFile(const WCHAR* path, PasswordUI* pwdUI,
     // TODO: sniff file content only once
     EngineBase* engine = CreateEngine(path, pwdUI, chmInFixedUI, ebookInFixedUI);
 
+    if (engine && reflow) {
+        // on failure (e.g. no extractable text) keep showing the fixed layout
+        EngineBase* reflowed = CreateReflowEngineFromEngine(engine);
+        if (reflowed) {
+            engine = reflowed;
+        }
+    }
+
     if (engine) {
         ctrl = new DisplayModel(engine, win->cbHandler);
         CrashIf(!ctrl || !ctrl->AsFixed() || ctrl->AsChm() || ctrl->AsEbook());
@@ -1137,6 +1173,9 @@ static void LoadDocIntoCurrentTab(const LoadArgs& args, Controller* ctrl, Displa
 
     AbortFinding(args.win, false);
 
+    // memoized search results describe the previous document's text
+    tab->searchMemo.Clear();
+
     Controller* prevCtrl = win->ctrl;
     tab->ctrl = ctrl;
     win->ctrl = tab->ctrl;
@@ -1258,6 +1297,7 @@ static void LoadDocIntoCurrentTab(const LoadArgs& args, Controller* ctrl, Displa
     // CrashIf(win->IsDocLoaded() && args.showWin && win->canvasRc.IsEmpty() && !win->AsChm());
 
     SetSidebarVisibility(win, showToc, gGlobalPrefs->showFavorites);
+    UpdatePageThumbnails(win);
     // restore scroll state after the canvas size has been restored
     if ((args.showWin || ss.page != 1) && win->AsFixed()) {
         win->AsFixed()->SetScrollState(ss);
@@ -1286,29 +1326,10 @@ static void LoadDocIntoCurrentTab(const LoadArgs& args, Controller* ctrl, Displa
     }
 }
 
-void ReloadDocument(WindowInfo* win, bool autoRefresh) {
-    // TODO: must disable reload for EngineMulti representing a directory
-    TabInfo* tab = win->currentTab;
-
-    // we can't reload while having annotations window open because
-    // that invalidates the mupdf objects that we hold in editAnnotsWindow
-    // TODO: a better approach would be to have a callback that editAnnotsWindow
-    // would register for and re-do its state
-    if (!tab || tab->editAnnotsWindow) {
-        return;
-    }
-    if (!win->IsDocLoaded()) {
-        if (!autoRefresh) {
-            LoadArgs args(tab->filePath, win);
-            args.forceReuse = true;
-            args.noSavePrefs = true;
-            LoadDocument(args);
-        }
-        return;
-    }
-
-    HwndPasswordUI pwdUI(win->hwndFrame);
-    Controller* ctrl = CreateControllerForFile(tab->filePath, &pwdUI, win);
+// the part of ReloadDocument() that swaps the new controller in; runs on
+// the UI thread once the controller exists (created either synchronously
+// or on the worker thread of an automatic reload)
+static void FinishReloadDocument(WindowInfo* win, TabInfo* tab, Controller* ctrl, bool autoRefresh) {
     // We don't allow PDF-repair if it is an autorefresh because
     // a refresh event can occur before the file is finished being written,
     // in which case the repair could fail. Instead, if the file is broken,
@@ -1373,6 +1394,111 @@ void ReloadDocument(WindowInfo* win, bool autoRefresh) {
     DeleteDisplayState(ds);
 }
 
+// state handed between the threads of an automatic reload whose engine
+// is created on a worker thread (see ReloadDocument())
+struct PendingReload {
+    WindowInfo* win = nullptr;
+    TabInfo* tab = nullptr;
+    AutoFreeWstr filePath;
+    HwndPasswordUI pwdUI;
+    EngineBase* engine = nullptr;
+
+    explicit PendingReload(HWND hwndFrame) : pwdUI(hwndFrame) {
+    }
+};
+
+static void FinishAutoReload(PendingReload* state) {
+    WindowInfo* win = state->win;
+    TabInfo* tab = state->tab;
+    if (!WindowInfoStillValid(win) || !win->tabs.Contains(tab)) {
+        // the tab or the window was closed while the engine was loading
+        delete state->engine;
+        delete state;
+        return;
+    }
+
+    tab->reloadPending = false;
+    if (win->currentTab != tab) {
+        // the user switched to another tab in the meantime; reload once
+        // they come back instead of yanking the tab into the foreground
+        delete state->engine;
+        tab->reloadOnFocus = true;
+        delete state;
+        return;
+    }
+    if (!tab->ctrl || tab->editAnnotsWindow) {
+        // the document was unloaded or an annotations window opened
+        // while the engine was loading
+        delete state->engine;
+        delete state;
+        return;
+    }
+
+    Controller* ctrl = nullptr;
+    if (state->engine) {
+        ctrl = new DisplayModel(state->engine, win->cbHandler);
+        VerifyController(ctrl, state->filePath);
+    }
+    FinishReloadDocument(win, tab, ctrl, true);
+    delete state;
+}
+
+void ReloadDocument(WindowInfo* win, bool autoRefresh) {
+    // TODO: must disable reload for EngineMulti representing a directory
+    TabInfo* tab = win->currentTab;
+
+    // we can't reload while having annotations window open because
+    // that invalidates the mupdf objects that we hold in editAnnotsWindow
+    // TODO: a better approach would be to have a callback that editAnnotsWindow
+    // would register for and re-do its state
+    if (!tab || tab->editAnnotsWindow) {
+        return;
+    }
+    if (!win->IsDocLoaded()) {
+        if (!autoRefresh) {
+            LoadArgs args(tab->filePath, win);
+            args.forceReuse = true;
+            args.noSavePrefs = true;
+            LoadDocument(args);
+        }
+        return;
+    }
+
+    if (autoRefresh && tab->AsFixed() && !tab->reflowView) {
+        // (reflow view tabs take the synchronous path below, as the
+        // asynchronously created engine wouldn't be reflowed)
+        // create the new engine on a worker thread so that a document
+        // being rebuilt behind our back (e.g. pdflatex re-writing the
+        // file we show) doesn't hang the UI while it's re-parsed;
+        // LoadDocIntoCurrentTab() then keeps the cached bitmaps of
+        // pages that didn't change
+        if (tab->reloadPending) {
+            // an earlier change notification is still being processed
+            return;
+        }
+        tab->reloadPending = true;
+
+        auto* state = new PendingReload(win->hwndFrame);
+        state->win = win;
+        state->tab = tab;
+        state->filePath.SetCopy(tab->filePath);
+
+        bool chmInFixedUI = gGlobalPrefs->chmUI.useFixedPageUI;
+        bool ebookInFixedUI = gGlobalPrefs->ebookUI.useFixedPageUI;
+        RunAsync([state, chmInFixedUI, ebookInFixedUI] {
+            // engine creation re-parses the whole file and is where the
+            // time goes; the swap happens back on the UI thread
+            state->engine = CreateEngine(state->filePath, &state->pwdUI, chmInFixedUI, ebookInFixedUI);
+            uitask::Post([state] { FinishAutoReload(state); });
+        });
+        return;
+    }
+
+    HwndPasswordUI pwdUI(win->hwndFrame);
+    Controller* ctrl = CreateControllerForFile(tab->filePath, &pwdUI, win, tab->reflowView);
+    FinishReloadDocument(win, tab, ctrl, autoRefresh);
+}
+
 static void CreateSidebar(WindowInfo* win) {
     win->sidebarSplitter = new SplitterCtrl(win->hwndFrame);
     win->sidebarSplitter->type = SplitterType::Vert;
@@ -1390,6 +1516,14 @@ static void CreateSidebar(WindowInfo* win) {
 
     CreateFavorites(win);
 
+    win->thumbsSplitter = new SplitterCtrl(win->hwndFrame);
+    win->thumbsSplitter->type = SplitterType::Horiz;
+    win->thumbsSplitter->onSplitterMove = OnThumbsSplitterMove;
+    ok = win->thumbsSplitter->Create();
+    CrashIf(!ok);
+
+    CreatePageThumbnails(win);
+
     if (win->tocVisible) {
         RepaintNow(win->hwndTocBox);
     }
@@ -1406,6 +1540,7 @@ static void UpdateToolbarSidebarText(WindowInfo* win) {
 
     win->tocLabelWithClose->SetLabel(_TR("Bookmarks"));
     win->favLabelWithClose->SetLabel(_TR("Favorites"));
+    win->thumbsLabelWithClose->SetLabel(_TR("Thumbnails"));
 }
 
 static WindowInfo* CreateWindowInfo() {
@@ -1489,6 +1624,10 @@ static WindowInfo* CreateWindowInfo() {
 
     SetTabsInTitlebar(win, gGlobalPrefs->useTabs);
 
+    // the timer is cheap even while hibernation is disabled, and having
+    // it always armed lets the setting take effect without a restart
+    SetTimer(hwndFrame, TAB_HIBERNATE_TIMER_ID, TAB_HIBERNATE_TIMER_DELAY_IN_MS, nullptr);
+
     return win;
 }
 
@@ -1559,7 +1698,7 @@ static void RenameFileInHistory(const WCHAR* oldPath, const WCHAR* newPath) {
     }
     ds = gFileHistory.Find(oldPath, nullptr);
     if (ds) {
-        str::ReplacePtr(&ds->filePath, newPath);
+        gFileHistory.UpdatePath(ds, newPath);
         // merge Frequently Read data, so that a file
         // doesn't accidentally vanish from there
         ds->isPinned = ds->isPinned || oldIsPinned;
@@ -1576,6 +1715,12 @@ bool DocumentPathExists(const WCHAR* path) {
     if (file::Exists(path) || dir::Exists(path)) {
         return true;
     }
+    if (path::IsUrl(path)) {
+        // remote documents are opened via HTTP range requests
+        // (see fz_open_url); whether the url resolves is only
+        // known once the engine connects to the server
+        return true;
+    }
     if (str::FindChar(path + 2, ':')) {
         // remove information needed for pointing at embedded documents
         // (e.g. "C:\path\file.pdf:3:0") to check at least whether the
@@ -1618,21 +1763,11 @@ void scheduleReloadTab(TabInfo* tab) {
     });
 }
 
-// TODO: eventually I would like to move all loading to be async. To achieve that
-// we need clear separatation of loading process into 2 phases: loading the
-// file (and showing progress/load failures in topmost window) and placing
-// the loaded document in the window (either by replacing document in existing
-// window or creating a new window for the document)
-WindowInfo* LoadDocument(LoadArgs& args) {
-    CrashAlwaysIf(gCrashOnOpen);
-
-    int threadID = (int)GetCurrentThreadId();
-    AutoFreeWstr fullPath(path::Normalize(args.fileName));
+// shared by the sync and async load paths: resolves the path, handles
+// inexistent files and picks (or creates) the window the document will
+// load into. returns nullptr if loading can't proceed.
+static WindowInfo* ResolveWindowForLoad(LoadArgs& args, AutoFreeWstr& fullPath, bool* openNewTabOut) {
     WindowInfo* win = args.win;
-    {
-        AutoFree path = strconv::WstrToUtf8(fullPath);
-        logf("LoadDocument: '%s', tid=%d\n", path.Get(), threadID);
-    }
 
     bool failEarly = win && !args.forceReuse && !DocumentPathExists(fullPath);
     // try to find inexistent files with history data
@@ -1651,13 +1786,13 @@ WindowInfo* LoadDocument(LoadArgs& args) {
     if (failEarly) {
         AutoFreeWstr msg(str::Format(_TR("File %s not found"), fullPath.Get()));
         win->ShowNotification(msg, NOS_HIGHLIGHT);
-        // display the notification ASAP (prefs::Save() can introduce a notable delay)
+        // display the notification ASAP
         win->RedrawAll(true);
 
         if (gFileHistory.MarkFileInexistent(fullPath)) {
             // TODO: handle this better. see https://github.com/sumatrapdfreader/sumatrapdf/issues/1674
             if (!args.noSavePrefs) {
-                prefs::Save();
+                prefs::ScheduleSave();
             }
             // update the Frequently Read list
             if (1 == gWindows.size() && gWindows.at(0)->IsAboutWindow()) {
@@ -1695,37 +1830,38 @@ WindowInfo* LoadDocument(LoadArgs& args) {
         }
     }
 
-    HwndPasswordUI pwdUI(win->hwndFrame);
-    Controller* ctrl = nullptr;
-    if (args.engine != nullptr) {
-        ctrl = CreateControllerForEngine(args.engine, fullPath, &pwdUI, win);
-    } else {
-        ctrl = CreateControllerForFile(fullPath, &pwdUI, win);
-    }
+    *openNewTabOut = openNewTab;
+    return win;
+}
 
-    if (!ctrl) {
-        // TODO: same message as in Canvas.cpp to not introduce
-        // new translation. Find a better message e.g. why failed.
-        WCHAR* msg = str::Format(_TR("Error loading %s"), fullPath.Get());
-        win->ShowNotification(msg, NOS_HIGHLIGHT);
-        str::Free(msg);
-        ShowWindow(win->hwndFrame, SW_SHOW);
+// shared by the sync and async load paths: tell the user the load failed
+// and drop the file from history if it no longer exists
+static void ShowLoadFailedNotification(WindowInfo* win, const WCHAR* fullPath, bool noSavePrefs) {
+    // TODO: same message as in Canvas.cpp to not introduce
+    // new translation. Find a better message e.g. why failed.
+    WCHAR* msg = str::Format(_TR("Error loading %s"), fullPath);
+    win->ShowNotification(msg, NOS_HIGHLIGHT);
+    str::Free(msg);
+    ShowWindow(win->hwndFrame, SW_SHOW);
 
-        // display the notification ASAP (prefs::Save() can introduce a notable delay)
-        win->RedrawAll(true);
+    // display the notification ASAP
+    win->RedrawAll(true);
 
-        if (gFileHistory.MarkFileInexistent(fullPath)) {
-            // TODO: handle this better. see https://github.com/sumatrapdfreader/sumatrapdf/issues/1674
-            if (!args.noSavePrefs) {
-                prefs::Save();
-            }
-            // update the Frequently Read list
-            if (1 == gWindows.size() && gWindows.at(0)->IsAboutWindow()) {
-                gWindows.at(0)->RedrawAll(true);
-            }
+    if (gFileHistory.MarkFileInexistent(fullPath)) {
+        // TODO: handle this better. see https://github.com/sumatrapdfreader/sumatrapdf/issues/1674
+        if (!noSavePrefs) {
+            prefs::ScheduleSave();
+        }
+        // update the Frequently Read list
+        if (1 == gWindows.size() && gWindows.at(0)->IsAboutWindow()) {
+            gWindows.at(0)->RedrawAll(true);
         }
-        return win;
     }
+}
+
+// shared by the sync and async load paths: closes the previous document
+// and creates (or reuses) the tab the new document will live in
+static TabInfo* PrepareTabForLoad(LoadArgs& args, WindowInfo* win, bool openNewTab, const WCHAR* fullPath) {
     CrashIf(openNewTab && args.forceReuse);
     if (win->IsAboutWindow()) {
         // invalidate the links on the Frequently Read page
@@ -1752,16 +1888,16 @@ WindowInfo* LoadDocument(LoadArgs& args) {
         AutoFree path = strconv::WstrToUtf8(fullPath);
         logf("LoadDocument: forceReuse, set win->currentTab (0x%p) filePath to '%s'\n", win->currentTab, path.Get());
     }
+    return win->currentTab;
+}
 
-    args.fileName = fullPath;
-    // TODO: stop remembering/restoring window positions when using tabs?
-    args.placeWindow = !gGlobalPrefs->useTabs;
-    LoadDocIntoCurrentTab(args, ctrl, nullptr);
-
+// shared by the sync and async load paths: everything that happens after
+// LoadDocIntoCurrentTab() put the document on screen
+static void AfterDocumentLoaded(LoadArgs& args, WindowInfo* win, const WCHAR* fullPath) {
     if (gPluginMode) {
         // hide the menu for embedded documents opened from the plugin
         SetMenu(win->hwndFrame, nullptr);
-        return win;
+        return;
     }
 
     auto currTab = win->currentTab;
@@ -1787,7 +1923,7 @@ WindowInfo* LoadDocument(LoadArgs& args) {
         // TODO: this seems to save the state of file that we just opened
         // add a way to skip saving currTab?
         if (!args.noSavePrefs) {
-            prefs::Save();
+            prefs::ScheduleSave();
         }
     }
 
@@ -1796,11 +1932,348 @@ WindowInfo* LoadDocument(LoadArgs& args) {
     if (HasPermission(Perm_DiskAccess) && !gPluginMode && !IsStressTesting()) {
         SHAddToRecentDocs(SHARD_PATH, fullPath);
     }
+}
+
+// if the document is already open in another tab or window, its engine
+// (and extracted text) can be lent to the new view instead of parsing
+// the file a second time, the same way Open In New Window shares them
+// (see OnDuplicateInNewWindow). skips views whose in-memory state no
+// longer matches the file on disk. exceptTab is the tab being (re)loaded
+// into, which must not lend its engine to itself.
+static DisplayModel* FindSharedEngineSourceTab(const WCHAR* fullPath, TabInfo* exceptTab) {
+    for (WindowInfo* win : gWindows) {
+        for (TabInfo* tab : win->tabs) {
+            // a reflow view's engine shows different content than the file
+            if (tab == exceptTab || !tab->AsFixed() || tab->reflowView) {
+                continue;
+            }
+            if (tab->reloadOnFocus || tab->reloadPending) {
+                // the file changed on disk, a fresh load should parse the new version
+                continue;
+            }
+            if (!path::IsSame(tab->filePath, fullPath)) {
+                continue;
+            }
+            DisplayModel* dm = tab->AsFixed();
+            if (EngineHasUnsavedAnnotations(dm->GetEngine())) {
+                // a fresh open should show the document as saved on disk,
+                // not another view's pending edits
+                continue;
+            }
+            return dm;
+        }
+    }
+    return nullptr;
+}
+
+// TODO: eventually I would like to move all loading to be async. To achieve that
+// we need clear separatation of loading process into 2 phases: loading the
+// file (and showing progress/load failures in topmost window) and placing
+// the loaded document in the window (either by replacing document in existing
+// window or creating a new window for the document)
+WindowInfo* LoadDocument(LoadArgs& args) {
+    CrashAlwaysIf(gCrashOnOpen);
+
+    int threadID = (int)GetCurrentThreadId();
+    AutoFreeWstr fullPath(path::Normalize(args.fileName));
+    {
+        AutoFree path = strconv::WstrToUtf8(fullPath);
+        logf("LoadDocument: '%s', tid=%d\n", path.Get(), threadID);
+    }
+
+    bool openNewTab = false;
+    WindowInfo* win = ResolveWindowForLoad(args, fullPath, &openNewTab);
+    if (!win) {
+        return nullptr;
+    }
 
+    if (nullptr == args.engine) {
+        TabInfo* exceptTab = args.forceReuse ? win->currentTab : nullptr;
+        DisplayModel* srcDm = FindSharedEngineSourceTab(fullPath, exceptTab);
+        if (srcDm) {
+            args.engine = srcDm->GetEngine()->AddRef();
+            args.sharedTextCache = srcDm->textCache;
+        }
+    }
+
+    HwndPasswordUI pwdUI(win->hwndFrame);
+    Controller* ctrl = nullptr;
+    if (args.engine != nullptr) {
+        ctrl = CreateControllerForEngine(args.engine, fullPath, &pwdUI, win, args.sharedTextCache);
+    } else {
+        ctrl = CreateControllerForFile(fullPath, &pwdUI, win);
+    }
+
+    if (!ctrl) {
+        ShowLoadFailedNotification(win, fullPath, args.noSavePrefs);
+        return win;
+    }
+
+    PrepareTabForLoad(args, win, openNewTab, fullPath);
+
+    args.fileName = fullPath;
+    // TODO: stop remembering/restoring window positions when using tabs?
+    args.placeWindow = !gGlobalPrefs->useTabs;
+    LoadDocIntoCurrentTab(args, ctrl, nullptr);
+
+    AfterDocumentLoaded(args, win, fullPath);
     return win;
 }
 
+// state handed from the UI thread that starts an async load to the worker
+// thread that creates the engine and on to the uitask that attaches the
+// document to its (so far empty) tab
+struct AsyncDocLoad {
+    WindowInfo* win = nullptr;
+    TabInfo* tab = nullptr;
+    AutoFreeWstr fullPath;
+    HwndPasswordUI pwdUI;
+    EngineBase* engine = nullptr;
+
+    bool showWin = true;
+    bool noPlaceWindow = false;
+    bool isNewWindow = false;
+    bool noSavePrefs = false;
+
+    explicit AsyncDocLoad(HWND hwndFrame) : pwdUI(hwndFrame) {
+    }
+};
+
+static void FinishAsyncDocLoad(AsyncDocLoad* state) {
+    WindowInfo* win = state->win;
+    if (!WindowInfoStillValid(win) || !win->tabs.Contains(state->tab)) {
+        // the user closed the window or the placeholder tab while we were loading
+        delete state->engine;
+        delete state;
+        return;
+    }
+
+    if (win->currentTab != state->tab) {
+        // the user switched to another tab in the meantime; bring the
+        // document's tab back so that LoadDocIntoCurrentTab() targets it
+        SaveCurrentTabInfo(win);
+        CloseDocumentInTab(win, true);
+        win->currentTab = state->tab;
+        win->tabsCtrl->SetSelectedTabByIndex(win->tabs.Find(state->tab));
+    }
+
+    Controller* ctrl = nullptr;
+    if (state->engine) {
+        ctrl = new DisplayModel(state->engine, win->cbHandler);
+        VerifyController(ctrl, state->fullPath);
+    } else {
+        // CHM and ebook formats don't go through CreateEngine() and are
+        // cheap to open, handle them here like CreateControllerForFile() does
+        if (!gGlobalPrefs->chmUI.useFixedPageUI) {
+            ctrl = CreateForChm(state->fullPath, &state->pwdUI, win);
+        }
+        if (!ctrl && !gGlobalPrefs->ebookUI.useFixedPageUI) {
+            Doc doc = Doc::CreateFromFile(state->fullPath);
+            if (doc.IsDocLoaded()) {
+                ctrl = EbookController::Create(doc, win->hwndCanvas, win->cbHandler, win->frameRateWnd);
+            }
+        }
+        if (ctrl) {
+            VerifyController(ctrl, state->fullPath);
+        }
+    }
+
+    if (!ctrl) {
+        ShowLoadFailedNotification(win, state->fullPath, state->noSavePrefs);
+        delete state;
+        return;
+    }
+
+    LoadArgs args(state->fullPath.Get(), win);
+    args.showWin = state->showWin;
+    args.noPlaceWindow = state->noPlaceWindow;
+    args.isNewWindow = state->isNewWindow;
+    args.noSavePrefs = state->noSavePrefs;
+    // TODO: stop remembering/restoring window positions when using tabs?
+    args.placeWindow = !gGlobalPrefs->useTabs;
+    LoadDocIntoCurrentTab(args, ctrl, nullptr);
+
+    AfterDocumentLoaded(args, win, state->fullPath);
+    delete state;
+}
+
+// Like LoadDocument() but doesn't block the UI thread on parsing the file:
+// the tab is created right away and acts as a placeholder, engine creation
+// runs on a worker thread and the document is attached via uitask once it's
+// ready. Unlike LoadDocument() the caller doesn't learn whether the load
+// succeeded, so this is only for user-initiated opens (menu, drag&drop).
+void LoadDocumentAsync(LoadArgs& args) {
+    CrashAlwaysIf(gCrashOnOpen);
+
+    AutoFreeWstr fullPath(path::Normalize(args.fileName));
+    {
+        AutoFree path = strconv::WstrToUtf8(fullPath);
+        logf("LoadDocumentAsync: '%s'\n", path.Get());
+    }
+
+    // the sharing lookup must happen here on the UI thread (engine refs
+    // aren't thread-safe); a borrowed engine makes the load instant
+    if (nullptr == args.engine) {
+        TabInfo* exceptTab = (args.forceReuse && args.win) ? args.win->currentTab : nullptr;
+        DisplayModel* srcDm = FindSharedEngineSourceTab(fullPath, exceptTab);
+        if (srcDm) {
+            args.engine = srcDm->GetEngine()->AddRef();
+            args.sharedTextCache = srcDm->textCache;
+        }
+    }
+
+    // an engine the caller already created doesn't need a worker thread
+    if (args.engine != nullptr) {
+        LoadDocument(args);
+        return;
+    }
+
+    bool openNewTab = false;
+    WindowInfo* win = ResolveWindowForLoad(args, fullPath, &openNewTab);
+    if (!win) {
+        return;
+    }
+    if (!win->cbHandler) {
+        win->cbHandler = new ControllerCallbackHandler(win);
+    }
+
+    // show the empty tab immediately so that the UI (tab switching,
+    // scrolling other documents) stays responsive during the load
+    TabInfo* tab = PrepareTabForLoad(args, win, openNewTab, fullPath);
+    if (args.isNewWindow) {
+        ShowWindow(win->hwndFrame, SW_SHOW);
+    }
+    win->RedrawAll();
+
+    auto* state = new AsyncDocLoad(win->hwndFrame);
+    state->win = win;
+    state->tab = tab;
+    state->fullPath.Set(fullPath.StealData());
+    state->showWin = args.showWin;
+    state->noPlaceWindow = args.noPlaceWindow;
+    state->isNewWindow = args.isNewWindow;
+    state->noSavePrefs = args.noSavePrefs;
+
+    bool chmInFixedUI = gGlobalPrefs->chmUI.useFixedPageUI;
+    bool ebookInFixedUI = gGlobalPrefs->ebookUI.useFixedPageUI;
+    RunAsync([state, chmInFixedUI, ebookInFixedUI] {
+        // the controllers must be created on the UI thread, but engine
+        // creation is where nearly all of the loading time goes
+        state->engine = CreateEngine(state->fullPath, &state->pwdUI, chmInFixedUI, ebookInFixedUI);
+        uitask::Post([state] { FinishAsyncDocLoad(state); });
+    });
+}
+
 // Loads document data into the WindowInfo.
+// finishes loading a tab that session restore created as a placeholder:
+// loads the document into the (now current) tab and applies the view
+// state remembered from the previous session
+static void RestorePendingTab(WindowInfo* win, TabInfo* tab) {
+    PendingRestore* pending = tab->pendingRestore;
+    tab->pendingRestore = nullptr;
+
+    LoadArgs args(tab->filePath.Get(), win);
+    args.forceReuse = true;
+    args.noSavePrefs = true;
+    if (!LoadDocument(args) || !tab->ctrl) {
+        delete pending;
+        return;
+    }
+
+    tab->tocState = pending->tocState;
+    SetSidebarVisibility(win, pending->showToc, gGlobalPrefs->showFavorites);
+
+    if (pending->displayMode != DisplayMode::Automatic) {
+        SwitchToDisplayMode(win, pending->displayMode);
+    }
+    // TODO: make EbookController::GoToPage not crash
+    if (!tab->AsEbook()) {
+        tab->ctrl->GoToPage(pending->pageNo, true);
+    }
+    if (pending->zoom != INVALID_ZOOM) {
+        if (tab->AsFixed()) {
+            tab->AsFixed()->Relayout(pending->zoom, pending->rotation);
+        } else {
+            tab->ctrl->SetZoomVirtual(pending->zoom, nullptr);
+        }
+    }
+    if (tab->AsFixed()) {
+        tab->AsFixed()->SetScrollState(ScrollState(pending->pageNo, pending->scrollPos.x, pending->scrollPos.y));
+    }
+    delete pending;
+}
+
+// turns a loaded background tab back into a placeholder: the view state
+// is remembered like for a lazily restored session tab, the last canvas
+// snapshot stays around for an instant visual switch, and the controller
+// (with its engine, text cache and page structures) is released
+static void HibernateTab(TabInfo* tab) {
+    DisplayModel* dm = tab->AsFixed();
+    CrashIf(!dm || tab == tab->win->currentTab);
+
+    // persist the view state so that it survives even a crash
+    UpdateTabFileDisplayStateForTab(tab);
+
+    auto pending = new PendingRestore();
+    pending->tocState = tab->tocState;
+    pending->showToc = tab->showToc;
+    pending->displayMode = tab->ctrl->GetDisplayMode();
+    ScrollState ss = dm->GetScrollState();
+    pending->pageNo = ss.page;
+    pending->scrollPos = Point((int)ss.x, (int)ss.y);
+    pending->zoom = tab->ctrl->GetZoomVirtual();
+    pending->rotation = dm->GetRotation();
+    tab->pendingRestore = pending;
+
+    // the TOC tree (and everything derived from it) is owned by the
+    // controller and rebuilt when the document is loaded again
+    tab->currToc = nullptr;
+    delete tab->tocSorted;
+    tab->tocSorted = nullptr;
+    tab->tocFilterItems.Reset();
+    tab->tocFilterTitles.Reset();
+    tab->tocFilterMatches.Reset();
+
+    // deleting the DisplayModel also evicts its pages from the render
+    // cache; a pending delayed clipboard copy reads from its text cache
+    ClipboardFlushDeferred(tab->ctrl);
+    delete tab->ctrl;
+    tab->ctrl = nullptr;
+    // the file watcher stays subscribed: a change to a hibernated file
+    // merely sets reloadOnFocus, which the rehydrating load satisfies
+}
+
+/* Called once a minute per window: unloads the document of every tab that
+   hasn't been looked at for TabHibernateAfterMin minutes, so that memory
+   use scales with the tabs actually in use and not with all tabs that
+   accumulated over days. The tab rehydrates through RestorePendingTab on
+   its next activation. */
+static void HibernateIdleTabs(WindowInfo* win) {
+    int afterMin = gGlobalPrefs->tabHibernateAfterMin;
+    if (afterMin <= 0) {
+        return;
+    }
+    DWORD now = GetTickCount();
+    for (TabInfo* tab : win->tabs) {
+        if (tab == win->currentTab || !tab->AsFixed()) {
+            // only DisplayModel tabs are hibernated; ebook and CHM models
+            // are entangled with their UI and hold far less memory
+            continue;
+        }
+        if (tab->reloadPending || tab->editAnnotsWindow) {
+            continue;
+        }
+        if (EngineHasUnsavedAnnotations(tab->GetEngine())) {
+            // unloading would silently discard the user's annotations
+            continue;
+        }
+        if (now - tab->lastActiveTick < (DWORD)afterMin * 60 * 1000) {
+            continue;
+        }
+        HibernateTab(tab);
+    }
+}
+
 void LoadModelIntoTab(TabInfo* tab) {
     if (!tab) {
         return;
@@ -1810,6 +2283,13 @@ void LoadModelIntoTab(TabInfo* tab) {
 
     win->currentTab = tab;
     win->ctrl = tab->ctrl;
+    tab->lastActiveTick = GetTickCount();
+
+    if (!tab->ctrl && tab->pendingRestore) {
+        // first activation of a lazily restored tab
+        RestorePendingTab(win, tab);
+        return;
+    }
 
     if (win->AsChm()) {
         win->AsChm()->SetParentHwnd(win->hwndCanvas);
@@ -1828,6 +2308,7 @@ void LoadModelIntoTab(TabInfo* tab) {
     } else {
         SetSidebarVisibility(win, tab->showToc, gGlobalPrefs->showFavorites);
     }
+    UpdatePageThumbnails(win);
 
     if (win->AsFixed()) {
         if (tab->canvasRc != win->canvasRc) {
@@ -2144,6 +2625,29 @@ void WindowInfoRerender(WindowInfo* win, bool includeNonClientArea) {
     }
 }
 
+// re-render a single page of the document displayed in this window, e.g. after
+// an annotation on it was edited. the stale bitmap keeps being painted until
+// the new render is done, so unlike WindowInfoRerender this doesn't block the
+// repaint on re-rendering and doesn't throw away the other pages' bitmaps
+void WindowInfoRerenderPage(WindowInfo* win, int pageNo) {
+    DisplayModel* dm = win->AsFixed();
+    if (!dm) {
+        return;
+    }
+    // this is only called after annotation edits, so make sure the engine
+    // re-synthesizes the edited appearance streams (a no-op for engines
+    // that don't cache them)
+    if (pageNo < 1 || pageNo > dm->PageCount()) {
+        EnginePdfDropAnnotAppearanceCache(dm->GetEngine(), 0);
+        WindowInfoRerender(win);
+        return;
+    }
+    EnginePdfDropAnnotAppearanceCache(dm->GetEngine(), pageNo);
+    RectF mediabox = dm->GetEngine()->PageMediabox(pageNo);
+    gRenderCache.Invalidate(dm, pageNo, mediabox);
+    win->RedrawAll(true);
+}
+
 static void RerenderEverything() {
     for (auto* win : gWindows) {
         WindowInfoRerender(win);
@@ -2174,8 +2678,14 @@ void UpdateDocumentColors() {
         return; // colors didn't change
     }
 
+    COLORREF prevText = gRenderCache.textColor;
+    COLORREF prevBg = gRenderCache.backgroundColor;
     gRenderCache.textColor = text;
     gRenderCache.backgroundColor = bg;
+    // patch the cached renders to the new colors in place, so that the
+    // switch shows instantly; RerenderEverything marks them out-of-date
+    // and the exact re-renders trickle in behind
+    gRenderCache.RecolorAll(prevText, prevBg);
     RerenderEverything();
 }
 
@@ -2205,6 +2715,9 @@ static void OnMenuExit() {
         return;
     }
 
+    // an explicit Exit ends a resident -preload instance for real
+    gIsPreloadedInstance = false;
+
     for (WindowInfo* win : gWindows) {
         if (!MayCloseWindow(win)) {
             return;
@@ -2231,7 +2744,6 @@ static void CloseDocumentInTab(WindowInfo* win, bool keepUIEnabled, bool deleteM
     ClearTocBox(win);
     AbortFinding(win, true);
 
-    delete win->linkOnLastButtonDown;
     win->linkOnLastButtonDown = nullptr;
     delete win->annotationOnLastButtonDown;
     win->annotationOnLastButtonDown = nullptr;
@@ -2243,6 +2755,7 @@ static void CloseDocumentInTab(WindowInfo* win, bool keepUIEnabled, bool deleteM
     win->ctrl = nullptr;
     auto currentTab = win->currentTab;
     if (deleteModel) {
+        ClipboardFlushDeferred(currentTab->ctrl);
         delete currentTab->ctrl;
         currentTab->ctrl = nullptr;
         FileWatcherUnsubscribe(win->currentTab->watcher);
@@ -2361,7 +2874,7 @@ void CloseTab(WindowInfo* win, bool quitIfLast) {
         TabsOnCloseDoc(win);
     }
     if (!didSavePrefs) {
-        prefs::Save();
+        prefs::ScheduleSave();
     }
 }
 
@@ -2420,6 +2933,12 @@ void CloseWindow(WindowInfo* win, bool quitIfLast, bool forceClose) {
     }
 
     bool lastWindow = (1 == gWindows.size());
+    // a resident preloader keeps the process warm: closing the last
+    // document returns the window to its hidden state instead of quitting
+    bool hideToPreload = gIsPreloadedInstance && lastWindow && !forceClose;
+    if (hideToPreload) {
+        quitIfLast = false;
+    }
     // RememberDefaultWindowPosition becomes a no-op once the window is hidden
     RememberDefaultWindowPosition(win);
     // hide the window before saving prefs (closing seems slightly faster that way)
@@ -2437,6 +2956,9 @@ void CloseWindow(WindowInfo* win, bool quitIfLast, bool forceClose) {
         CloseDocumentInTab(win);
         SetFocus(win->hwndFrame);
         CrashIf(!gWindows.Contains(win));
+        if (hideToPreload) {
+            ShowWindow(win->hwndFrame, SW_HIDE);
+        }
     } else {
         FreeMenuOwnerDrawInfoData(win->menu);
         HWND hwndToDestroy = win->hwndFrame;
@@ -2698,6 +3220,52 @@ static void OnMenuSaveAs(WindowInfo* win) {
     }
 }
 
+// saves the current pdf document through a full mupdf rewrite that
+// garbage-collects unused objects, de-duplicates identical ones and
+// compresses all streams (see EnginePdfSaveOptimized), which can shrink
+// bloated files (e.g. scanner output) severalfold
+static void OnMenuSaveAsOptimized(WindowInfo* win) {
+    if (!HasPermission(Perm_DiskAccess)) {
+        return;
+    }
+    TabInfo* tab = win->currentTab;
+    if (!tab || tab->GetEngineType() != kindEnginePdf) {
+        return;
+    }
+
+    WCHAR dstFileName[MAX_PATH + 1] = {0};
+
+    OPENFILENAME ofn = {0};
+    str::WStr fileFilter(256);
+    fileFilter.Append(_TR("PDF documents"));
+    fileFilter.Append(L"\1*.pdf\1");
+    fileFilter.Append(L"\1*.*\1");
+    str::TransChars(fileFilter.Get(), L"\1", L"\0");
+
+    EngineBase* engine = tab->AsFixed()->GetEngine();
+    const WCHAR* name = engine->FileName();
+    str::BufSet(dstFileName, dimof(dstFileName), name);
+
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = win->hwndFrame;
+    ofn.lpstrFile = dstFileName;
+    ofn.nMaxFile = dimof(dstFileName);
+    ofn.lpstrFilter = fileFilter.Get();
+    ofn.nFilterIndex = 1;
+    ofn.lpstrDefExt = L".pdf";
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST | OFN_HIDEREADONLY;
+
+    bool ok = GetSaveFileNameW(&ofn);
+    if (!ok) {
+        return;
+    }
+    AutoFreeStr dstFilePath = strconv::WstrToUtf8(dstFileName);
+    ok = EnginePdfSaveOptimized(engine, dstFilePath.AsView());
+    if (!ok) {
+        MessageBoxWarning(win->hwndFrame, _TR("Failed to save a file"));
+    }
+}
+
 static void OnMenuShowInFolder(WindowInfo* win) {
     if (!HasPermission(Perm_DiskAccess)) {
         return;
@@ -2922,6 +3490,15 @@ static void OnDuplicateInNewWindow(WindowInfo* win) {
     // TODO: should copy the display state from current file
     LoadArgs args(path, newWin);
     args.fileName = tab->filePath;
+    DisplayModel* dm = tab->AsFixed();
+    if (dm) {
+        // share the already loaded engine and its text cache with the
+        // new view instead of parsing the document a second time; engine
+        // access is serialized internally and the render cache is global,
+        // so viewing two positions costs roughly no extra memory
+        args.engine = dm->GetEngine()->AddRef();
+        args.sharedTextCache = dm->textCache;
+    }
     args.showWin = true;
     args.noPlaceWindow = true;
     LoadDocument(args);
@@ -3061,7 +3638,7 @@ static void OnMenuOpen(WindowInfo* win) {
     if (*(fileName - 1)) {
         // special case: single filename without nullptr separator
         LoadArgs args(ofn.lpstrFile, win);
-        LoadDocument(args);
+        LoadDocumentAsync(args);
         return;
     }
 
@@ -3069,7 +3646,7 @@ static void OnMenuOpen(WindowInfo* win) {
         AutoFreeWstr filePath = path::Join(ofn.lpstrFile, fileName);
         if (filePath) {
             LoadArgs args(filePath, win);
-            LoadDocument(args);
+            LoadDocumentAsync(args);
         }
         fileName += str::Len(fileName) + 1;
     }
@@ -3190,10 +3767,11 @@ static void RelayoutFrame(WindowInfo* win, bool updateToolbars = true, int sideb
         rc.dy -= rcRebar.dy;
     }
 
-    // ToC and Favorites sidebars at the left
+    // ToC, Favorites and Thumbnails sidebars at the left
     bool showFavorites = gGlobalPrefs->showFavorites && !gPluginMode && HasPermission(Perm_DiskAccess);
     bool tocVisible = win->tocVisible;
-    if (tocVisible || showFavorites) {
+    bool showThumbs = win->thumbsVisible && win->AsFixed();
+    if (tocVisible || showFavorites || showThumbs) {
         Size toc = ClientRect(win->hwndTocBox).Size();
         if (sidebarDx > 0) {
             toc = Size(sidebarDx, rc.y);
@@ -3207,22 +3785,37 @@ static void RelayoutFrame(WindowInfo* win, bool updateToolbars = true, int sideb
         //       wide (cf. OnFrameGetMinMaxInfo)
         toc.dx = limitValue(toc.dx, SIDEBAR_MIN_WIDTH, rc.dx / 2);
 
+        // the thumbnails panel is carved off the bottom of the sidebar,
+        // ToC and Favorites share what remains above it
+        int sideDy = rc.dy;
+        int thumbsDy = 0;
+        if (showThumbs) {
+            if (tocVisible || showFavorites) {
+                thumbsDy = win->thumbsDy > 0 ? win->thumbsDy : rc.dy / 3;
+                thumbsDy = limitValue(thumbsDy, TOC_MIN_DY, rc.dy - TOC_MIN_DY);
+                sideDy = rc.dy - thumbsDy - SPLITTER_DY;
+            } else {
+                thumbsDy = rc.dy;
+                sideDy = 0;
+            }
+        }
+
         toc.dy = 0;
         if (tocVisible) {
             if (!showFavorites) {
-                toc.dy = rc.dy;
+                toc.dy = sideDy;
             } else {
                 toc.dy = gGlobalPrefs->tocDy;
                 if (toc.dy > 0) {
-                    toc.dy = limitValue<int>(gGlobalPrefs->tocDy, 0, rc.dy);
+                    toc.dy = limitValue<int>(gGlobalPrefs->tocDy, 0, sideDy);
                 } else {
-                    toc.dy = rc.dy / 2; // default value
+                    toc.dy = sideDy / 2; // default value
                 }
             }
         }
 
         if (tocVisible && showFavorites) {
-            toc.dy = limitValue(toc.dy, TOC_MIN_DY, rc.dy - TOC_MIN_DY);
+            toc.dy = limitValue(toc.dy, TOC_MIN_DY, sideDy - TOC_MIN_DY);
         }
 
         if (tocVisible) {
@@ -3235,9 +3828,20 @@ static void RelayoutFrame(WindowInfo* win, bool updateToolbars = true, int sideb
             }
         }
         if (showFavorites) {
-            Rect rFav(rc.x, rc.y + toc.dy, toc.dx, rc.dy - toc.dy);
+            Rect rFav(rc.x, rc.y + toc.dy, toc.dx, sideDy - toc.dy);
             dh.MoveWindow(win->hwndFavBox, rFav);
         }
+        if (showThumbs) {
+            if (tocVisible || showFavorites) {
+                Rect rSplitT(rc.x, rc.y + sideDy, toc.dx, SPLITTER_DY);
+                dh.MoveWindow(win->thumbsSplitter->hwnd, rSplitT);
+                Rect rThumbs(rc.x, rc.y + sideDy + SPLITTER_DY, toc.dx, thumbsDy);
+                dh.MoveWindow(win->hwndThumbsBox, rThumbs);
+            } else {
+                Rect rThumbs(rc.x, rc.y, toc.dx, thumbsDy);
+                dh.MoveWindow(win->hwndThumbsBox, rThumbs);
+            }
+        }
         Rect rSplitH(rc.x + toc.dx, rc.y, SPLITTER_DX, rc.dy);
         dh.MoveWindow(win->sidebarSplitter->hwnd, rSplitH);
 
@@ -3296,7 +3900,7 @@ void SetCurrentLanguageAndRefreshUI(const char* langCode) {
         }
     }
 
-    prefs::Save();
+    prefs::ScheduleSave();
 }
 
 static void OnMenuChangeLanguage(HWND hwnd) {
@@ -3392,6 +3996,19 @@ static void OnMenuViewMangaMode(WindowInfo* win) {
     dm->SetScrollState(state);
 }
 
+static void OnMenuViewReflowMode(WindowInfo* win) {
+    TabInfo* tab = win->currentTab;
+    if (!tab || !tab->AsFixed()) {
+        return;
+    }
+    if (!tab->reflowView && tab->GetEngine()->IsImageCollection()) {
+        // no text to reflow
+        return;
+    }
+    tab->reflowView = !tab->reflowView;
+    ReloadDocument(win, false);
+}
+
 static void ChangeZoomLevel(WindowInfo* win, float newZoom, bool pagesContinuously) {
     if (!win->IsDocLoaded()) {
         return;
@@ -3645,6 +4262,14 @@ void AdvanceFocus(WindowInfo* win) {
     SetFocus(tabOrder[i]);
 }
 
+// rotates the cached renderings along with the view (see
+// RenderCache::RotateForDisplayModel), so that the relayout repaints
+// rotated stand-ins right away while the exact re-renders are in flight
+void RotateDocBy(DisplayModel* dm, int delta) {
+    gRenderCache.RotateForDisplayModel(dm, dm->GetRotation() + delta);
+    dm->RotateBy(delta);
+}
+
 // allow to distinguish a '/' caused by VK_DIVIDE (rotates a document)
 // from one typed on the main keyboard (focuses the find textbox)
 static bool gIsDivideKeyDown = false;
@@ -3787,9 +4412,9 @@ bool FrameOnKeydown(WindowInfo* win, WPARAM key, LPARAM lp, bool inTextfield) {
             SendMessageW(win->hwndCanvas, WM_VSCROLL, SB_BOTTOM, 0);
         }
     } else if (VK_MULTIPLY == key && dm) {
-        dm->RotateBy(90);
+        RotateDocBy(dm, 90);
     } else if (VK_DIVIDE == key && dm) {
-        dm->RotateBy(-90);
+        RotateDocBy(dm, -90);
         gIsDivideKeyDown = true;
 #ifdef DEBUG
     } else if (VK_F1 == key && win->AsEbook()) {
@@ -3879,6 +4504,24 @@ static void OnFrameKeyB(WindowInfo* win) {
     }
 }
 
+// annotations modify the engine's in-memory document; when the engine is
+// shared with other views of the same file (see FindSharedEngineSourceTab)
+// this view first gets its own private copy, so that the edits don't show
+// up in (and don't prompt saving from) the other views. returns false if
+// a private copy couldn't be created.
+bool EnsureExclusiveEngine(TabInfo* tab) {
+    DisplayModel* dm = tab ? tab->AsFixed() : nullptr;
+    if (!dm) {
+        return false;
+    }
+    if (dm->GetEngine()->refs == 1) {
+        return true;
+    }
+    // the find thread reads through the text cache being replaced
+    AbortFinding(tab->win, true);
+    return dm->UnshareEngine();
+}
+
 bool MakeAnnotationFromSelection(TabInfo* tab, AnnotationType annotType) {
     bool annotsEnabled = gIsDebugBuild || gIsPreReleaseBuild;
     if (!annotsEnabled) {
@@ -3919,6 +4562,11 @@ bool MakeAnnotationFromSelection(TabInfo* tab, AnnotationType annotType) {
         // TODO: show an error message
         return false;
     }
+    if (!EnsureExclusiveEngine(tab)) {
+        return false;
+    }
+    // the selection is in page coordinates, it survives the engine swap
+    engine = dm->GetEngine();
     Annotation* annot = EnginePdfCreateAnnotation(engine, annotType, pageNo, PointF{});
     annot->SetQuadPointsAsRect(rects);
 
@@ -4025,12 +4673,12 @@ static void FrameOnChar(WindowInfo* win, WPARAM key, LPARAM info = 0) {
             break;
         case '[':
             if (dm) {
-                dm->RotateBy(-90);
+                RotateDocBy(dm, -90);
             }
             break;
         case ']':
             if (dm) {
-                dm->RotateBy(90);
+                RotateDocBy(dm, 90);
             }
             break;
         case 'f':
@@ -4160,6 +4808,32 @@ static void OnFavSplitterMove(SplitterMoveEvent* ev) {
     }
 }
 
+static void OnThumbsSplitterMove(SplitterMoveEvent* ev) {
+    SplitterCtrl* splitter = ev->w;
+    HWND hwnd = splitter->hwnd;
+    WindowInfo* win = FindWindowInfoByHwnd(hwnd);
+    bool done = ev->done;
+
+    Point pcur;
+    GetCursorPosInHwnd(win->hwndFrame, pcur);
+    Rect rFrame = ClientRect(win->hwndFrame);
+    // the thumbnails panel is anchored to the bottom of the sidebar
+    int thumbsDy = rFrame.dy - pcur.y; // without splitter
+
+    // make sure to keep this in sync with the calculations in RelayoutFrame
+    Rect rThumbs = ClientRect(win->hwndThumbsBox);
+    int minDy = std::min(TOC_MIN_DY, rThumbs.dy);
+    int maxDy = std::max(rFrame.dy - TOC_MIN_DY, rThumbs.dy);
+    if (thumbsDy < minDy || thumbsDy > maxDy) {
+        ev->resizeAllowed = false;
+        return;
+    }
+    win->thumbsDy = thumbsDy;
+    if (done || !win->AsEbook()) {
+        RelayoutFrame(win, false, rThumbs.dx);
+    }
+}
+
 void SetSidebarVisibility(WindowInfo* win, bool tocVisible, bool showFavorites) {
     if (gPluginMode || !HasPermission(Perm_DiskAccess)) {
         showFavorites = false;
@@ -4169,9 +4843,12 @@ void SetSidebarVisibility(WindowInfo* win, bool tocVisible, bool showFavorites)
         tocVisible = false;
     }
 
+    bool showThumbs = win->thumbsVisible && win->AsFixed();
+
     if (PM_BLACK_SCREEN == win->presentation || PM_WHITE_SCREEN == win->presentation) {
         tocVisible = false;
         showFavorites = false;
+        showThumbs = false;
     }
 
     if (tocVisible) {
@@ -4199,7 +4876,7 @@ void SetSidebarVisibility(WindowInfo* win, bool tocVisible, bool showFavorites)
         SetFocus(win->hwndFrame);
     }
 
-    win::SetVisibility(win->sidebarSplitter->hwnd, tocVisible || showFavorites);
+    win::SetVisibility(win->sidebarSplitter->hwnd, tocVisible || showFavorites || showThumbs);
     win::SetVisibility(win->hwndTocBox, tocVisible);
     win->sidebarSplitter->isLive = !win->AsEbook();
 
@@ -4207,6 +4884,10 @@ void SetSidebarVisibility(WindowInfo* win, bool tocVisible, bool showFavorites)
     win::SetVisibility(win->hwndFavBox, showFavorites);
     win->favSplitter->isLive = !win->AsEbook();
 
+    win::SetVisibility(win->thumbsSplitter->hwnd, showThumbs && (tocVisible || showFavorites));
+    win::SetVisibility(win->hwndThumbsBox, showThumbs);
+    win->thumbsSplitter->isLive = !win->AsEbook();
+
     RelayoutFrame(win, false);
 }
 
@@ -4315,8 +4996,8 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
         RedrawWindow(win->hwndFrame, nullptr, nullptr,
                      RDW_ERASE | RDW_INVALIDATE | RDW_UPDATENOW | RDW_ALLCHILDREN); // paint new theme
         UpdateDocumentColors();        // doing this a second time ensures the frequently read documents are updated
-        UpdateAppMenu(win, (HMENU)wp); // update the radio buttons
-        prefs::Save();                 // save new preferences
+        UpdateAppMenu(win, win->menu); // update the radio buttons
+        prefs::ScheduleSave();         // save new preferences
     }
 #endif
 
@@ -4351,11 +5032,18 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
         case CmdOpenFolder:
             OnMenuOpenFolder(win);
             break;
+        case CmdQuickOpen:
+            ShowQuickOpen(win);
+            break;
 
         case CmdSaveAs:
             OnMenuSaveAs(win);
             break;
 
+        case CmdSaveAsOptimized:
+            OnMenuSaveAsOptimized(win);
+            break;
+
         case CmdRenameFile:
             OnMenuRenameFile(win);
             break;
@@ -4447,6 +5135,10 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
             OnMenuViewMangaMode(win);
             break;
 
+        case CmdViewReflowMode:
+            OnMenuViewReflowMode(win);
+            break;
+
         case CmdViewShowHideToolbar:
             OnMenuViewShowHideToolbar();
             break;
@@ -4455,6 +5147,10 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
             OnMenuViewShowHideScrollbars();
             break;
 
+        case CmdViewShowHideThumbnails:
+            TogglePageThumbnails(win);
+            break;
+
         case CmdSaveAnnotations:
             SaveAnnotationsAndCloseEditAnnowtationsWindow(win->currentTab);
             break;
@@ -4519,13 +5215,13 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
 
         case CmdViewRotateLeft:
             if (win->AsFixed()) {
-                win->AsFixed()->RotateBy(-90);
+                RotateDocBy(win->AsFixed(), -90);
             }
             break;
 
         case CmdViewRotateRight:
             if (win->AsFixed()) {
-                win->AsFixed()->RotateBy(90);
+                RotateDocBy(win->AsFixed(), 90);
             }
             break;
 
@@ -4553,6 +5249,12 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
             OnMenuFindSel(win, TextSearchDirection::Backward);
             break;
 
+        case CmdSearchAllTabs:
+            if (HasPermission(Perm_DiskAccess)) {
+                StartSearchAllTabs(win);
+            }
+            break;
+
         case CmdHelpVisitWebsite:
             SumatraLaunchBrowser(WEBSITE_MAIN_URL);
             break;
@@ -4677,6 +5379,14 @@ static LRESULT FrameOnCommand(WindowInfo* win, HWND hwnd, UINT msg, WPARAM wp, L
             // win->ShowNotification(L"This is a second notification\nMy friend.");
         } break;
 
+        case CmdDebugShowMemoryUsage: {
+            str::Str report;
+            memacct::FmtReport(report);
+            DibPoolFmtStats(report);
+            AutoFreeWstr msg = strconv::Utf8ToWstr(report.Get());
+            MessageBoxW(win->hwndFrame, msg, L"Memory usage", MB_ICONINFORMATION | MB_OK);
+        } break;
+
         case CmdDebugCrashMe:
             CrashMe();
             break;
@@ -4901,6 +5611,20 @@ LRESULT CALLBACK WndProcFrame(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             }
         } break;
 
+        // delayed clipboard rendering for large text selections
+        // (see CopySelectionToClipboard)
+        case WM_RENDERFORMAT:
+            OnClipboardRenderFormat((uint)wp);
+            return 0;
+
+        case WM_RENDERALLFORMATS:
+            OnClipboardRenderAllFormats(hwnd);
+            return 0;
+
+        case WM_DESTROYCLIPBOARD:
+            OnClipboardDestroy();
+            return 0;
+
         case WM_ENDSESSION:
             // TODO: check for unfinished print jobs in WM_QUERYENDSESSION?
             if (wp == TRUE) {
@@ -4924,7 +5648,9 @@ LRESULT CALLBACK WndProcFrame(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             return OnCopyData(hwnd, wp, lp);
 
         case WM_TIMER:
-            if (win && win->stressTest) {
+            if (win && TAB_HIBERNATE_TIMER_ID == wp) {
+                HibernateIdleTabs(win);
+            } else if (win && win->stressTest) {
                 OnStressTestTimer(win, (int)wp);
             }
             break;
@@ -5057,4 +5783,5 @@ void ShutdownCleanup() {
     gAllowedLinkProtocols.Reset();
     extern void WindowCleanup();
     WindowCleanup();
+    DibPoolFreeAll();
 }
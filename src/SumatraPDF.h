@@ -26,8 +26,25 @@
 #define AUTO_RELOAD_TIMER_ID 5
 #define AUTO_RELOAD_DELAY_IN_MS 100
 
+// an animated zoom advances every ZOOM_ANIM_DELAY_IN_MS until it reaches
+// its target after ZOOM_ANIM_DURATION_IN_MS (see StartZoomAnimation)
+#define ZOOM_ANIM_TIMER_ID 6
+#define ZOOM_ANIM_DURATION_IN_MS 150
+#define ZOOM_ANIM_DELAY_IN_MS 15
+
 #define EBOOK_LAYOUT_TIMER_ID 7
 
+// an inertial wheel scroll advances every frame while the velocity decays
+// (see StartInertialScroll in Canvas.cpp); the timer timeouts come from a
+// FrameTimeoutCalculator, so there's no fixed delay
+#define SCROLL_ANIM_TIMER_ID 8
+
+// periodically unloads the documents of long-idle background tabs
+// (see HibernateIdleTabs); a minute is precise enough for a timeout
+// that's measured in hours
+#define TAB_HIBERNATE_TIMER_ID 9
+#define TAB_HIBERNATE_TIMER_DELAY_IN_MS (60 * 1000)
+
 // permissions that can be revoked through sumatrapdfrestrict.ini or the -restrict command line flag
 enum {
     // enables Update checks, crash report submitting and hyperlinks
@@ -74,6 +91,7 @@ enum MenuToolbarFlags {
 #define RIGHT_TXT_FONT_SIZE 12
 
 struct Controller;
+struct DisplayModel;
 class Favorites;
 struct FileHistory;
 struct WindowInfo;
@@ -83,6 +101,7 @@ struct TabInfo;
 struct LabelWithCloseWnd;
 struct SessionData;
 struct DropDownCtrl;
+struct EditCtrl;
 
 // all defined in SumatraPDF.cpp
 extern bool gDebugShowLinks;
@@ -99,6 +118,7 @@ extern bool gSuppressAltKey;
 extern HBITMAP gBitmapReloadingCue;
 extern HCURSOR gCursorDrag;
 extern bool gCrashOnOpen;
+extern bool gIsPreloadedInstance;
 
 #define gPluginMode (gPluginURL != nullptr)
 
@@ -114,7 +134,7 @@ bool MayCloseWindow(WindowInfo* win);
 void CloseWindow(WindowInfo* win, bool quitIfLast, bool forceClose = false);
 void SetSidebarVisibility(WindowInfo* win, bool tocVisible, bool showFavorites);
 void RememberFavTreeExpansionState(WindowInfo* win);
-void LayoutTreeContainer(LabelWithCloseWnd* l, DropDownCtrl*, HWND hwndTree);
+void LayoutTreeContainer(LabelWithCloseWnd* l, DropDownCtrl*, EditCtrl* filter, HWND hwndTree);
 void AdvanceFocus(WindowInfo* win);
 bool WindowInfoStillValid(WindowInfo* win);
 void SetCurrentLanguageAndRefreshUI(const char* langCode);
@@ -123,6 +143,11 @@ void UpdateFixedPageScrollbarsVisibility();
 void UpdateTabFileDisplayStateForTab(TabInfo* tab);
 bool FrameOnKeydown(WindowInfo* win, WPARAM key, LPARAM lp, bool inTextfield = false);
 void ReloadDocument(WindowInfo* win, bool autoRefresh);
+// call before modifying annotations; gives the tab a private copy of an
+// engine shared with other views of the same document (copy-on-write)
+bool EnsureExclusiveEngine(TabInfo* tab);
+// rotate the view together with its cached renderings (delta in degrees)
+void RotateDocBy(DisplayModel* dm, int delta);
 void OnMenuViewFullscreen(WindowInfo* win, bool presentation = false);
 void RelayoutWindow(WindowInfo* win);
 
@@ -133,6 +158,7 @@ WindowInfo* FindWindowInfoBySyncFile(const WCHAR* file, bool focusTab);
 WindowInfo* FindWindowInfoByController(Controller* ctrl);
 
 class EngineBase;
+struct DocumentTextCache;
 
 // LoadDocument carries a lot of state, this holds them in
 // one place
@@ -154,6 +180,9 @@ struct LoadArgs {
 
     // we don't own those values
     EngineBase* engine{nullptr};
+    // when engine is shared with an already loaded view, its text cache
+    // can be shared too (the new DisplayModel adds a ref)
+    DocumentTextCache* sharedTextCache{nullptr};
     const WCHAR* fileName{nullptr};
     WindowInfo* win{nullptr};
 
@@ -174,6 +203,8 @@ struct LoadArgs {
 };
 
 WindowInfo* LoadDocument(LoadArgs& args);
+// doesn't block the UI thread on parsing the document; for user-initiated opens
+void LoadDocumentAsync(LoadArgs& args);
 WindowInfo* CreateAndShowWindowInfo(SessionData* data = nullptr);
 
 uint MbRtlReadingMaybe();
@@ -190,6 +221,7 @@ void UpdateCheckAsync(WindowInfo* win, bool autoCheck);
 void DeleteWindowInfo(WindowInfo* win);
 void SwitchToDisplayMode(WindowInfo* win, DisplayMode displayMode, bool keepContinuous = false);
 void WindowInfoRerender(WindowInfo* win, bool includeNonClientArea = false);
+void WindowInfoRerenderPage(WindowInfo* win, int pageNo);
 
 LRESULT CALLBACK WndProcFrame(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp);
 
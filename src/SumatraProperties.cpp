@@ -4,6 +4,7 @@
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
 #include "utils/FileUtil.h"
+#include "utils/UITask.h"
 #include "utils/WinUtil.h"
 
 #include "wingui/TreeModel.h"
@@ -84,6 +85,38 @@ class PropertiesLayout : public Vec<PropertyEl*> {
 
 static Vec<PropertiesLayout*> gPropertiesWindows;
 
+#if defined(DEBUG) || defined(ENABLE_EXTENDED_PROPERTIES)
+// cache of extracted font lists, keyed by document path. Extraction
+// walks every page's resources, which can take seconds on large
+// documents, so the result is kept for re-opens of the dialog
+struct CachedFontList {
+    WCHAR* filePath;
+    WCHAR* fontList;
+};
+static Vec<CachedFontList> gFontListCache;
+
+// caller needs to free the result
+static WCHAR* GetCachedFontList(const WCHAR* filePath) {
+    for (CachedFontList& e : gFontListCache) {
+        if (str::Eq(e.filePath, filePath)) {
+            return str::Dup(e.fontList);
+        }
+    }
+    return nullptr;
+}
+
+static void SetCachedFontList(const WCHAR* filePath, const WCHAR* fontList) {
+    for (CachedFontList& e : gFontListCache) {
+        if (str::Eq(e.filePath, filePath)) {
+            str::ReplacePtr(&e.fontList, fontList);
+            return;
+        }
+    }
+    CachedFontList e = {str::Dup(filePath), str::Dup(fontList)};
+    gFontListCache.Append(e);
+}
+#endif
+
 static PropertiesLayout* FindPropertyWindowByParent(HWND hwndParent) {
     for (size_t i = 0; i < gPropertiesWindows.size(); i++) {
         PropertiesLayout* pl = gPropertiesWindows.at(i);
@@ -425,6 +458,98 @@ static void UpdatePropertiesLayout(PropertiesLayout* layoutData, HDC hdc, Rect*
     SelectObject(hdc, origFont);
 }
 
+/* Resize the window to just match the layout's dimensions (as long as
+   they fit into the current monitor's work area). */
+static void FitWindowToLayout(PropertiesLayout* layoutData) {
+    HWND hwnd = layoutData->hwnd;
+    Rect rc;
+    HDC hdc = GetDC(hwnd);
+    UpdatePropertiesLayout(layoutData, hdc, &rc);
+    ReleaseDC(hwnd, hdc);
+
+    Rect wRc = WindowRect(hwnd);
+    Rect cRc = ClientRect(hwnd);
+    Rect work = GetWorkAreaRect(WindowRect(layoutData->hwndParent));
+    wRc.dx = std::min(rc.dx + wRc.dx - cRc.dx, work.dx);
+    wRc.dy = std::min(rc.dy + wRc.dy - cRc.dy, work.dy);
+    MoveWindow(hwnd, wRc.x, wRc.y, wRc.dx, wRc.dy, TRUE);
+}
+
+#if defined(DEBUG) || defined(ENABLE_EXTENDED_PROPERTIES)
+// replaces the "..." placeholder once the background extraction is done
+static void UpdateFontsProperty(HWND hwndParent, const WCHAR* fontList) {
+    PropertiesLayout* layoutData = FindPropertyWindowByParent(hwndParent);
+    if (!layoutData) {
+        // the dialog was closed in the meantime; the cached result
+        // still serves the next one
+        return;
+    }
+    for (size_t i = 0; i < layoutData->size(); i++) {
+        PropertyEl* el = layoutData->at(i);
+        if (str::Eq(el->leftTxt, _TR("Fonts:"))) {
+            el->rightTxt.Set(str::Dup(fontList ? fontList : L"-"));
+        }
+    }
+    FitWindowToLayout(layoutData);
+    InvalidateRect(layoutData->hwnd, nullptr, TRUE);
+}
+
+/* Font list extraction walks every page's resources, which can freeze
+   the UI for seconds on big documents; it therefore runs on its own
+   thread against a clone of the engine (so that closing the document
+   doesn't pull the engine from under it) and fills the already visible
+   dialog when done. */
+struct FontListThreadData {
+    EngineBase* engine = nullptr; // clone owned by the thread
+    WCHAR* filePath = nullptr;
+    HWND hwndParent = nullptr;
+
+    ~FontListThreadData() {
+        delete engine;
+        free(filePath);
+    }
+};
+
+static DWORD WINAPI FontListThread(LPVOID data) {
+    FontListThreadData* td = (FontListThreadData*)data;
+    WCHAR* fontList = td->engine->GetProperty(DocumentProperty::FontList);
+    uitask::Post([=] {
+        if (fontList) {
+            SetCachedFontList(td->filePath, fontList);
+        }
+        UpdateFontsProperty(td->hwndParent, fontList);
+        free(fontList);
+        delete td;
+    });
+    return 0;
+}
+
+static void StartFontListExtraction(DisplayModel* dm, HWND hwndParent) {
+    EngineBase* engine = dm->GetEngine()->Clone();
+    if (!engine) {
+        // cloning can fail e.g. for documents opened from a stream;
+        // fall back to blocking extraction
+        WCHAR* fontList = dm->GetEngine()->GetProperty(DocumentProperty::FontList);
+        if (fontList) {
+            SetCachedFontList(dm->GetEngine()->FileName(), fontList);
+        }
+        UpdateFontsProperty(hwndParent, fontList);
+        free(fontList);
+        return;
+    }
+    auto td = new FontListThreadData();
+    td->engine = engine;
+    td->filePath = str::Dup(dm->GetEngine()->FileName());
+    td->hwndParent = hwndParent;
+    HANDLE thread = CreateThread(nullptr, 0, FontListThread, td, 0, nullptr);
+    if (!thread) {
+        delete td;
+        return;
+    }
+    CloseHandle(thread);
+}
+#endif
+
 static bool CreatePropertiesWindow(HWND hParent, PropertiesLayout* layoutData) {
     CrashIf(layoutData->hwnd);
     HWND hwnd = CreateWindow(PROPERTIES_CLASS_NAME, PROPERTIES_WIN_TITLE, WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU,
@@ -439,20 +564,8 @@ static bool CreatePropertiesWindow(HWND hParent, PropertiesLayout* layoutData) {
     SetRtl(hwnd, IsUIRightToLeft());
 
     // get the dimensions required for the about box's content
-    Rect rc;
-    PAINTSTRUCT ps;
-    HDC hdc = BeginPaint(hwnd, &ps);
-    UpdatePropertiesLayout(layoutData, hdc, &rc);
-    EndPaint(hwnd, &ps);
-
-    // resize the new window to just match these dimensions
-    // (as long as they fit into the current monitor's work area)
-    Rect wRc = WindowRect(hwnd);
-    Rect cRc = ClientRect(hwnd);
-    Rect work = GetWorkAreaRect(WindowRect(hParent));
-    wRc.dx = std::min(rc.dx + wRc.dx - cRc.dx, work.dx);
-    wRc.dy = std::min(rc.dy + wRc.dy - cRc.dy, work.dy);
-    MoveWindow(hwnd, wRc.x, wRc.y, wRc.dx, wRc.dy, FALSE);
+    // and resize the new window to just match them
+    FitWindowToLayout(layoutData);
     CenterDialog(hwnd, hParent);
 
     ShowWindow(hwnd, SW_SHOW);
@@ -543,8 +656,14 @@ static void GetProps(Controller* ctrl, PropertiesLayout* layoutData, [[maybe_unu
 
 #if defined(DEBUG) || defined(ENABLE_EXTENDED_PROPERTIES)
     if (extended) {
-        // TODO: FontList extraction can take a while
-        str = ctrl->GetProperty(DocumentProperty::FontList);
+        str = GetCachedFontList(ctrl->FilePath());
+        if (!str && dm) {
+            // the dialog shows right away; the placeholder is replaced
+            // once the background extraction is done (see FontListThread)
+            str = str::Dup(L"...");
+        } else if (!str) {
+            str = ctrl->GetProperty(DocumentProperty::FontList);
+        }
         if (str) {
             // add a space between basic and extended file properties
             layoutData->AddProperty(L" ", str::Dup(L" "));
@@ -570,7 +689,17 @@ static void ShowProperties(HWND parent, Controller* ctrl, bool extended = false)
 
     if (!CreatePropertiesWindow(parent, layoutData)) {
         delete layoutData;
+        return;
+    }
+
+#if defined(DEBUG) || defined(ENABLE_EXTENDED_PROPERTIES)
+    if (extended && ctrl->AsFixed()) {
+        AutoFreeWstr cached(GetCachedFontList(ctrl->FilePath()));
+        if (!cached) {
+            StartFontListExtraction(ctrl->AsFixed(), parent);
+        }
     }
+#endif
 }
 
 void OnMenuProperties(WindowInfo* win) {
@@ -7,13 +7,16 @@
 #include "utils/CmdLineParser.h"
 #include "utils/DbgHelpDyn.h"
 #include "utils/Dpi.h"
+#include "utils/EtwTrace.h"
 #include "utils/FileUtil.h"
+#include "utils/MemAccounting.h"
 #include "utils/FileWatcher.h"
 #include "utils/HtmlParserLookup.h"
 #include "utils/GdiPlusUtil.h"
 #include "mui/Mui.h"
 #include "utils/SquareTreeParser.h"
 #include "utils/ThreadUtil.h"
+#include "utils/IdleTask.h"
 #include "utils/UITask.h"
 #include "utils/WinUtil.h"
 #include "utils/Archive.h"
@@ -299,6 +302,51 @@ static WindowInfo* LoadOnStartup(const WCHAR* filePath, const Flags& i, bool isF
     return win;
 }
 
+// reads the file once at background priority so that the OS file cache is
+// warm by the time a lazily restored tab gets loaded on first activation;
+// doesn't compete with the active document, which loads first
+static void WarmUpFileAsync(const WCHAR* filePathIn) {
+    WCHAR* filePath = str::Dup(filePathIn);
+    auto fn = [filePath] {
+        HANDLE h = CreateFileW(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (h != INVALID_HANDLE_VALUE) {
+            char buf[64 * 1024];
+            DWORD nRead;
+            while (ReadFile(h, buf, sizeof(buf), &nRead, nullptr) && nRead > 0) {
+                // discard; we only want the bytes in the cache
+            }
+            CloseHandle(h);
+        }
+        str::Free(filePath);
+    };
+    DropTaskHandle(GetThreadPool()->Submit(fn, TaskPriority::Background));
+}
+
+// creates a tab for the document without loading it; the load happens on
+// first activation (see RestorePendingTab), so that startup time depends
+// only on the document in the active tab
+static void RestoreTabOnStartupLazy(WindowInfo* win, TabState* state) {
+    AutoFreeWstr filePath(strconv::Utf8ToWstr(state->filePath));
+    TabInfo* tab = CreateNewTab(win, filePath);
+    if (!tab) {
+        return;
+    }
+    PendingRestore* pending = new PendingRestore();
+    pending->tocState = *state->tocState;
+    pending->showToc = state->showToc;
+    pending->displayMode = DisplayModeFromString(state->displayMode, DisplayMode::Automatic);
+    pending->pageNo = state->pageNo;
+    pending->zoom = ZoomFromString(state->zoom, INVALID_ZOOM);
+    pending->rotation = state->rotation;
+    pending->scrollPos = state->scrollPos;
+    tab->pendingRestore = pending;
+    // keep win's idea of the current tab in sync with the tab control
+    win->currentTab = tab;
+    win->ctrl = nullptr;
+    WarmUpFileAsync(filePath);
+}
+
 static void RestoreTabOnStartup(WindowInfo* win, TabState* state) {
     LoadArgs args(state->filePath, win);
     args.noSavePrefs = true;
@@ -495,12 +543,82 @@ static bool RegisterForPdfExtentions(HWND hwnd) {
     return true;
 }
 
+static WindowInfo* gDeferredStartupWin = nullptr;
+static bool gDeferredShowStartPage = false;
+
+// initialization that the first window doesn't need in order to show and
+// paint; registered as an idle task so that it runs once the message
+// queue first goes empty, i.e. after the window became visible
+static bool DeferredStartupTasks() {
+    // enumerating the known external viewers reads the registry and
+    // probes the file system; the File menus are filled lazily, so
+    // invalidate their cache in case one was already opened
+    DetectExternalViewers();
+    for (WindowInfo* w : gWindows) {
+        w->menuFileHistoryVer = 0;
+    }
+
+    // get the symbols for this build into the local cache so that a
+    // crash doesn't have to download them while handling the crash
+    CrashHandlerDownloadSymbolsAsync();
+
+    WindowInfo* win = gDeferredStartupWin;
+    gDeferredStartupWin = nullptr;
+    if (!WindowInfoStillValid(win)) {
+        return false;
+    }
+
+    // Make sure that we're still registered as default,
+    // if the user has explicitly told us to be
+    if (gGlobalPrefs->associatedExtensions) {
+        RegisterForPdfExtentions(win->hwndFrame);
+    }
+
+    if (gGlobalPrefs->checkForUpdates) {
+        UpdateCheckAsync(win, true);
+    }
+
+    // only hide newly missing files when showing the start page on startup
+    if (gDeferredShowStartPage && gFileHistory.Get(0)) {
+        gFileExistenceChecker = new FileExistenceChecker();
+        gFileExistenceChecker->Start();
+    }
+
+    // call this once it's clear whether Perm_SavePreferences has been granted
+    prefs::RegisterForFileChanges();
+    return false;
+}
+
+static void ScheduleDeferredStartupTasks(WindowInfo* win, bool showStartPage) {
+    gDeferredStartupWin = win;
+    gDeferredShowStartPage = showStartPage;
+    idletask::Register("deferred startup", idletask::Priority::Normal, DeferredStartupTasks);
+}
+
+// how long registered idle tasks may run before the queue is checked
+// for new input again
+#define IDLE_SLICE_BUDGET_MS 10
+
 static int RunMessageLoop() {
     HACCEL accTable = CreateSumatraAcceleratorTable();
 
     MSG msg{0};
 
-    while (GetMessage(&msg, nullptr, 0, 0)) {
+    for (;;) {
+        if (!PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            // the queue is empty; this is where registered idle tasks get
+            // their time slices. When none are pending, block the way
+            // GetMessage() would
+            if (idletask::RunSlice(IDLE_SLICE_BUDGET_MS)) {
+                continue;
+            }
+            WaitMessage();
+            continue;
+        }
+        if (WM_QUIT == msg.message) {
+            return (int)msg.wParam;
+        }
+
         // dispatch the accelerator to the correct window
         HWND accHwnd = msg.hwnd;
         WindowInfo* win = FindWindowInfoByHwnd(msg.hwnd);
@@ -519,13 +637,12 @@ static int RunMessageLoop() {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
-
-    return (int)msg.wParam;
 }
 
 static void ShutdownCommon() {
     mui::Destroy();
     uitask::Destroy();
+    idletask::Destroy();
     UninstallCrashHandler();
     dbghelp::FreeCallstackLogs();
     // output leaks after all destructors of static objects have run
@@ -824,6 +941,8 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
     ScopedGdiPlus gdiPlus(true);
     mui::Initialize();
     uitask::Initialize();
+    trace::Register();
+    memacct::StartSampler();
 
     // logToFile("C:\\Users\\kjk\\Downloads\\sumlog.txt");
 
@@ -932,21 +1051,13 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
         return 0;
     }
 
-    DetectExternalViewers();
+    // DetectExternalViewers() runs in DeferredStartupTasks() so that its
+    // registry and file system probing doesn't delay the first window
 
     prefs::Load();
     UpdateGlobalPrefs(i);
     SetCurrentLang(i.lang ? i.lang : gGlobalPrefs->uiLanguage);
 
-    // This allows ad-hoc comparison of gdi, gdi+ and gdi+ quick when used
-    // in layout
-#if 0
-    RedirectIOToConsole();
-    BenchEbookLayout(L"C:\\kjk\\downloads\\pg12.mobi");
-    system("pause");
-    goto Exit;
-#endif
-
     if (i.showConsole) {
         RedirectIOToConsole();
         // TODO(port)
@@ -958,12 +1069,20 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
     }
 
     if (i.pathsToBenchmark.size() > 0) {
-        BenchFileOrDir(i.pathsToBenchmark);
+        BenchFileOrDir(i);
         if (i.showConsole) {
             system("pause");
         }
     }
 
+    if (i.stressTestPath && i.stressProcessCount > 1) {
+        RunStressOrchestrator(i);
+        if (i.showConsole) {
+            system("pause");
+        }
+        goto Exit;
+    }
+
     if (i.exitImmediately) {
         goto Exit;
     }
@@ -1005,7 +1124,9 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
         // TODO: pass print request through to previous instance?
     } else if (i.reuseDdeInstance) {
         hPrevWnd = FindWindow(FRAME_CLASS_NAME, nullptr);
-    } else if (gGlobalPrefs->reuseInstance || gGlobalPrefs->useTabs) {
+    } else if (gGlobalPrefs->reuseInstance || gGlobalPrefs->useTabs || i.preload) {
+        // a -preload instance always takes (or defers to) the single-instance
+        // mutex so that later Explorer opens find the warm process
         hPrevWnd = FindPrevInstWindow(&hMutex);
     }
     if (hPrevWnd) {
@@ -1022,7 +1143,8 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
         for (size_t n = 0; n < nFiles; n++) {
             OpenUsingDde(hPrevWnd, i.fileNames.at(n), i, 0 == n);
         }
-        if (0 == nFiles) {
+        if (0 == nFiles && !i.preload) {
+            // another instance is already resident, nothing to preload
             win::ToForeground(hPrevWnd);
         }
         goto Exit;
@@ -1055,15 +1177,27 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
     if (restoreSession) {
         for (SessionData* data : *gGlobalPrefs->sessionData) {
             win = CreateAndShowWindowInfo(data);
-            for (TabState* state : *data->tabStates) {
+            int nTabs = data->tabStates->isize();
+            int activeIdx = data->tabIndex - 1;
+            if (activeIdx < 0 || activeIdx >= nTabs) {
+                activeIdx = 0;
+            }
+            for (int tabIdx = 0; tabIdx < nTabs; tabIdx++) {
+                TabState* state = data->tabStates->at(tabIdx);
                 // TODO: if prefs::Save() is called, it deletes gGlobalPrefs->sessionData
                 // we're currently iterating (happened e.g. if the file is deleted)
                 // the current fix is to not call prefs::Save() below but maybe there's a better way
                 // maybe make a copy of TabState so that it isn't invalidated
                 // https://github.com/sumatrapdfreader/sumatrapdf/issues/1674
-                RestoreTabOnStartup(win, state);
+                if (tabIdx == activeIdx) {
+                    // only the active tab's document is loaded during startup ...
+                    RestoreTabOnStartup(win, state);
+                } else {
+                    // ... the rest are placeholders, hydrated on first activation
+                    RestoreTabOnStartupLazy(win, state);
+                }
             }
-            TabsSelect(win, data->tabIndex - 1);
+            TabsSelect(win, activeIdx);
         }
     }
     ResetSessionState(gGlobalPrefs->sessionData);
@@ -1117,12 +1251,6 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
         }
     }
 
-    // Make sure that we're still registered as default,
-    // if the user has explicitly told us to be
-    if (gGlobalPrefs->associatedExtensions) {
-        RegisterForPdfExtentions(win->hwndFrame);
-    }
-
     if (i.stressTestPath) {
         // don't save file history and preference changes
         RestrictPolicies(Perm_SavePreferences);
@@ -1131,17 +1259,11 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
         fastExit = true;
     }
 
-    if (gGlobalPrefs->checkForUpdates) {
-        UpdateCheckAsync(win, true);
-    }
-
-    // only hide newly missing files when showing the start page on startup
-    if (showStartPage && gFileHistory.Get(0)) {
-        gFileExistenceChecker = new FileExistenceChecker();
-        gFileExistenceChecker->Start();
-    }
-    // call this once it's clear whether Perm_SavePreferences has been granted
-    prefs::RegisterForFileChanges();
+    // everything else the window doesn't need in order to become visible
+    // (external viewer detection, file association and update checks,
+    // the file existence checker, the settings file watcher) runs once
+    // the message queue goes idle, i.e. after the first paint
+    ScheduleDeferredStartupTasks(win, showStartPage);
 
     // Change current directory for 2 reasons:
     // * prevent dll hijacking (LoadLibrary first loads from current directory
@@ -1156,7 +1278,17 @@ int APIENTRY WinMain(HINSTANCE hInstance, [[maybe_unused]] HINSTANCE hPrevInstan
     //  c:\windows\system32 is a good directory to use
     ChangeCurrDirToSystem32();
 
-    BringWindowToTop(win->hwndFrame);
+    if (i.preload) {
+        gIsPreloadedInstance = true;
+    }
+    if (gIsPreloadedInstance && win->IsAboutWindow()) {
+        // stay resident but out of sight; DDE/WM_COPYDATA opens from later
+        // double-clicks show the window again (see HandleOpenCmd), paying
+        // only document load instead of full process startup
+        ShowWindow(win->hwndFrame, SW_HIDE);
+    } else {
+        BringWindowToTop(win->hwndFrame);
+    }
 
     retCode = RunMessageLoop();
     SafeCloseHandle(&hMutex);
@@ -1194,6 +1326,8 @@ Exit:
     mui::Destroy();
     uitask::Destroy();
     trans::Destroy();
+    trace::Unregister();
+    memacct::StopSampler();
 
     FileWatcherWaitForShutdown();
 
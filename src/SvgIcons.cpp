@@ -7,6 +7,7 @@ extern "C" {
 }
 
 #include "utils/BaseUtil.h"
+#include "utils/FileUtil.h"
 #include "utils/WinUtil.h"
 #include "utils/ScopedWin.h"
 
@@ -16,6 +17,8 @@ extern "C" {
 #include "EngineBase.h"
 #include "EngineFzUtil.h"
 
+#include "AppTools.h"
+
 // https://github.com/tabler/tabler-icons/blob/master/icons/folder.svg
 static const char* gIconFileOpen =
     R"(<svg xmlns="http://www.w3.org/2000/svg" class="icon icon-tabler icon-tabler-folder" width="24" height="24" viewBox="0 0 24 24" stroke-width="2" stroke="currentColor" fill="none" stroke-linecap="round" stroke-linejoin="round">
@@ -268,11 +271,8 @@ fz_pixmap* BuildIconsPixmap(MupdfContext* muctx, int dx, int dy) {
     return dstPixmap;
 }
 
-HBITMAP CreateBitmapFromPixmap(fz_pixmap* pixmap) {
-    int w = pixmap->w;
-    int h = pixmap->h;
-    int n = pixmap->n;
-    int imgSize = pixmap->stride * h;
+static HBITMAP CreateBitmapFromSamples(int w, int h, int n, int stride, const u8* samples) {
+    int imgSize = stride * h;
     int bitsCount = n * 8;
 
     ScopedMem<BITMAPINFO> bmi((BITMAPINFO*)calloc(1, sizeof(BITMAPINFO) + 255 * sizeof(RGBQUAD)));
@@ -292,35 +292,92 @@ HBITMAP CreateBitmapFromPixmap(fz_pixmap* pixmap) {
     uint usage = DIB_RGB_COLORS;
     HBITMAP hbmp = CreateDIBSection(nullptr, bmi, usage, &data, hMap, 0);
     if (data) {
-        u8* samples = pixmap->samples;
         memcpy(data, samples, imgSize);
     }
     return hbmp;
 }
 
+HBITMAP CreateBitmapFromPixmap(fz_pixmap* pixmap) {
+    return CreateBitmapFromSamples(pixmap->w, pixmap->h, pixmap->n, pixmap->stride, pixmap->samples);
+}
+
+// rasterizing the svg icons through mupdf takes long enough to be felt
+// at startup and on per-monitor dpi changes, so the rendered strip is
+// cached on disk, keyed by icon set version and strip geometry. The
+// icons are drawn black-on-white and masked when added to the image
+// list, so theme colors are not part of the key.
+// bump when any of the svgs in gAllIcons change
+constexpr u32 kIconsCacheVersion = 1;
+
+struct IconsCacheHeader {
+    u32 version = 0;
+    i32 w = 0;
+    i32 h = 0;
+    i32 n = 0;
+    i32 stride = 0;
+};
+
+static WCHAR* GetIconsCachePath(int dx, int dy) {
+    AutoFreeWstr dir(AppGenDataFilename(L"iconscache"));
+    if (!dir) {
+        return nullptr;
+    }
+    dir::Create(dir);
+    return str::Format(L"%s\\icons-%u-%dx%d.dat", dir.Get(), kIconsCacheVersion, dx, dy);
+}
+
+static HBITMAP LoadIconsBitmapFromCache(int dx, int dy) {
+    AutoFreeWstr path(GetIconsCachePath(dx, dy));
+    if (!path) {
+        return nullptr;
+    }
+    AutoFree data = file::ReadFile(path.Get());
+    if (data.size() < sizeof(IconsCacheHeader)) {
+        return nullptr;
+    }
+    IconsCacheHeader* hdr = (IconsCacheHeader*)data.Get();
+    int nIcons = (int)dimof(gAllIcons);
+    if (hdr->version != kIconsCacheVersion || hdr->w != dx * nIcons || hdr->h != dy) {
+        return nullptr;
+    }
+    size_t imgSize = (size_t)hdr->stride * hdr->h;
+    if (data.size() != sizeof(IconsCacheHeader) + imgSize) {
+        return nullptr;
+    }
+    const u8* samples = (const u8*)data.Get() + sizeof(IconsCacheHeader);
+    return CreateBitmapFromSamples(hdr->w, hdr->h, hdr->n, hdr->stride, samples);
+}
+
+static void SaveIconsBitmapToCache(fz_pixmap* pixmap, int dx, int dy) {
+    AutoFreeWstr path(GetIconsCachePath(dx, dy));
+    if (!path) {
+        return;
+    }
+    IconsCacheHeader hdr;
+    hdr.version = kIconsCacheVersion;
+    hdr.w = pixmap->w;
+    hdr.h = pixmap->h;
+    hdr.n = pixmap->n;
+    hdr.stride = pixmap->stride;
+    size_t imgSize = (size_t)pixmap->stride * pixmap->h;
+    str::Str d(sizeof(hdr) + imgSize);
+    d.Append((const char*)&hdr, sizeof(hdr));
+    d.Append((const char*)pixmap->samples, imgSize);
+    // failure is not a problem, the strip will be re-rendered next time
+    file::WriteFile(path.Get(), d.AsSpan());
+}
+
 HBITMAP BuildIconsBitmap(int dx, int dy) {
+    HBITMAP cached = LoadIconsBitmapFromCache(dx, dy);
+    if (cached) {
+        return cached;
+    }
+
     MupdfContext* muctx = new MupdfContext();
     fz_pixmap* pixmap = BuildIconsPixmap(muctx, dx, dy);
-    // ClearPixmap(pixmap);
-#if 1
-#if 0
-    RenderedBitmap* rbmp = new_rendered_fz_pixmap(muctx->ctx, pixmap);
-    HBITMAP bmp = rbmp->hbmp;
-#else
     HBITMAP bmp = CreateBitmapFromPixmap(pixmap);
-#endif
+    SaveIconsBitmapToCache(pixmap, dx, dy);
     fz_drop_pixmap(muctx->ctx, pixmap);
     delete muctx;
     return bmp;
-#else
-    int nIcons = dimof(gAllIcons);
-    int bmpDx = dx * nIcons;
-    int bmpDy = dy;
-    u8* bits = pixmap->samples;
-    HBITMAP res = CreateBitmap(bmpDx, bmpDy, 1, 24, bits);
-    fz_drop_pixmap(muctx->ctx, pixmap);
-    delete muctx;
-
-    return res;
-#endif
 }
@@ -29,9 +29,53 @@
 #include "ParseBKM.h"
 #include "EditAnnotations.h"
 
+#pragma warning(disable : 28159) // silence /analyze: Consider using 'GetTickCount64' instead of 'GetTickCount'
+
+SearchMatches* SearchMatchesMemo::Find(const WCHAR* text, bool matchCase) {
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry e = entries.at(i);
+        if (e.matchCase != matchCase || !str::Eq(e.text, text)) {
+            continue;
+        }
+        // move the hit to the end so that eviction drops the least
+        // recently used term first
+        entries.RemoveAt(i);
+        entries.Append(e);
+        return e.matches;
+    }
+    return nullptr;
+}
+
+void SearchMatchesMemo::Add(const WCHAR* text, bool matchCase, const SearchMatches* matches) {
+    if (Find(text, matchCase)) {
+        return;
+    }
+    if (entries.size() >= MAX_ENTRIES) {
+        Entry& evict = entries.at(0);
+        free(evict.text);
+        delete evict.matches;
+        entries.RemoveAt(0);
+    }
+    Entry e = {str::Dup(text), matchCase, matches->Clone()};
+    entries.Append(e);
+}
+
+void SearchMatchesMemo::Clear() {
+    for (Entry& e : entries) {
+        free(e.text);
+        delete e.matches;
+    }
+    entries.Reset();
+}
+
+SearchMatchesMemo::~SearchMatchesMemo() {
+    Clear();
+}
+
 TabInfo::TabInfo(WindowInfo* win, const WCHAR* filePath) {
     this->win = win;
     this->filePath.SetCopy(filePath);
+    this->lastActiveTick = GetTickCount();
 }
 
 TabInfo::~TabInfo() {
@@ -41,9 +85,14 @@ TabInfo::~TabInfo() {
     }
     DeleteVecMembers(altBookmarks);
     delete selectionOnPage;
+    delete searchMatches;
+    // a pending delayed clipboard copy reads from this model's text cache
+    ClipboardFlushDeferred(ctrl);
     delete ctrl;
     delete tocSorted;
     CloseAndDeleteEditAnnotationsWindow(editAnnotsWindow);
+    DeleteObject(canvasSnapshot);
+    delete pendingRestore;
 }
 
 bool TabInfo::IsDocLoaded() const {
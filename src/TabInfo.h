@@ -12,6 +12,62 @@ enum class TocSort { None, TagSmallFirst, TagBigFirst, Color };
 /* Data related to a single document loaded into a tab/window */
 /* (none of these depend on WindowInfo, so that a TabInfo could
    be moved between windows once this is supported) */
+// remembered view state for a tab that session restore created as a
+// placeholder; applied (and deleted) when the document is actually
+// loaded on first activation (see RestorePendingTab)
+struct PendingRestore {
+    Vec<int> tocState;
+    bool showToc = false;
+    DisplayMode displayMode{DisplayMode::Automatic};
+    int pageNo = 1;
+    float zoom = INVALID_ZOOM;
+    int rotation = 0;
+    Point scrollPos;
+};
+
+// every match of the current search, split by page (in page coordinates),
+// so that the painting code only has to convert the rectangles on visible
+// pages; filled on the find thread (see MarkAllMatches in SearchAndDDE.cpp)
+struct SearchMatches {
+    int nPages = 0;
+    // pageRects[pageNo - 1] holds the matches on pageNo
+    Vec<RectF>* pageRects = nullptr;
+
+    SearchMatches* Clone() const {
+        auto res = new SearchMatches();
+        res->nPages = nPages;
+        res->pageRects = new Vec<RectF>[nPages];
+        for (int i = 0; i < nPages; i++) {
+            res->pageRects[i] = pageRects[i];
+        }
+        return res;
+    }
+
+    ~SearchMatches() {
+        delete[] pageRects;
+    }
+};
+
+// remembers the match lists of recent search terms so that coming back to
+// an earlier term ("pump" -> "pump station" -> "pump") reuses them instead
+// of re-scanning the whole document. Only ever touched on the UI thread;
+// (re)loading a document into the tab drops it (see LoadDocIntoCurrentTab)
+struct SearchMatchesMemo {
+    enum { MAX_ENTRIES = 8 };
+    struct Entry {
+        WCHAR* text;
+        bool matchCase;
+        SearchMatches* matches;
+    };
+    Vec<Entry> entries;
+
+    // the returned matches stay owned by the memo
+    SearchMatches* Find(const WCHAR* text, bool matchCase);
+    void Add(const WCHAR* text, bool matchCase, const SearchMatches* matches);
+    void Clear();
+    ~SearchMatchesMemo();
+};
+
 struct TabInfo {
     AutoFreeWstr filePath;
     WindowInfo* win = nullptr;
@@ -27,11 +83,22 @@ struct TabInfo {
     Rect canvasRc;
     // whether to auto-reload the document when the tab is selected
     bool reloadOnFocus = 0;
+    // an automatic reload is creating the new engine on a worker thread
+    bool reloadPending = false;
+    // show the document as reflowed text instead of its fixed layout;
+    // applied by reloading the document with the engine wrapped in a
+    // reflow engine (see CreateReflowEngineFromEngine)
+    bool reflowView = false;
     // FileWatcher token for unsubscribing
     WatchedFile* watcher = nullptr;
     // list of rectangles of the last rectangular, text or image selection
     // (split by page, in user coordinates)
     Vec<SelectionOnPage>* selectionOnPage = nullptr;
+    // all matches of the last search when highlightSearchMatches is set,
+    // composited over the document in Canvas.cpp (see PaintSearchMatches)
+    SearchMatches* searchMatches = nullptr;
+    // match lists of recent search terms (see FindTextOnThread)
+    SearchMatchesMemo searchMemo;
     // previous View settings, needed when unchecking the Fit Width/Page toolbar buttons
     float prevZoomVirtual = INVALID_ZOOM;
     DisplayMode prevDisplayMode{DisplayMode::Automatic};
@@ -40,7 +107,29 @@ struct TabInfo {
     TocTree* currToc = nullptr; // not owned by us
     // if sortTag is != SortTag::None, this is a sorted toc tree to be displayed
     TocTree* tocSorted = nullptr;
+    // all items of currToc together with case-folded copies of their
+    // titles, prebuilt so that the sidebar filter box only has to do
+    // substring scans per keystroke (see UpdateTocFilter)
+    Vec<TocItem*> tocFilterItems;
+    WStrVec tocFilterTitles;
+    // indices into tocFilterItems matching tocFilterText; extending the
+    // filter rescans these instead of the whole index
+    Vec<int> tocFilterMatches;
+    AutoFreeWstr tocFilterText;
     EditAnnotationsWindow* editAnnotsWindow = nullptr;
+    // set when the tab is a not-yet-loaded placeholder from session
+    // restore or when its document was unloaded after a long idle time
+    // (see HibernateIdleTabs); either way the document is loaded on the
+    // tab's next activation
+    PendingRestore* pendingRestore = nullptr;
+    // when the tab was last selected (or deselected); long-idle
+    // background tabs get their document unloaded to save memory
+    DWORD lastActiveTick = 0;
+    // composite of the canvas as painted when the tab was last deactivated;
+    // blitted on re-activation until RenderCache has fresh renders, so that
+    // switching tabs doesn't flash a blank canvas (see DrawDocument)
+    HBITMAP canvasSnapshot = nullptr;
+    Size canvasSnapshotSize;
 
     TabInfo(WindowInfo* win, const WCHAR* filePath = nullptr);
     ~TabInfo();
@@ -18,6 +18,7 @@
 #include "wingui/TreeModel.h"
 #include "wingui/TreeCtrl.h"
 #include "wingui/DropDownCtrl.h"
+#include "wingui/EditCtrl.h"
 
 #include "utils/GdiPlusUtil.h"
 
@@ -227,6 +228,8 @@ void ClearTocBox(WindowInfo* win) {
     }
 
     win->tocTreeCtrl->Clear();
+    delete win->tocFilteredTree;
+    win->tocFilteredTree = nullptr;
 
     win->currPageNo = 0;
     win->tocLoaded = false;
@@ -818,6 +821,111 @@ static bool ShouldCustomDraw(WindowInfo* win) {
 
 void OnTocCustomDraw(TreeItemCustomDrawEvent*);
 
+/* Collects every item of the unfiltered ToC together with a case-folded
+   copy of its title. Prebuilt once per document so that the filter box
+   only has to do substring scans per keystroke, not a tree walk with
+   per-node case conversion. */
+static void BuildTocFilterIndex(TabInfo* tab) {
+    tab->tocFilterItems.Reset();
+    tab->tocFilterTitles.Reset();
+    tab->tocFilterMatches.Reset();
+    tab->tocFilterText.Set(nullptr);
+    if (!tab->currToc || !tab->currToc->root) {
+        return;
+    }
+    VisitTocTree(tab->currToc->root, [tab](TocItem* ti) {
+        if (!str::IsEmpty(ti->title)) {
+            tab->tocFilterItems.Append(ti);
+            WCHAR* folded = str::Dup(ti->title);
+            CharLowerW(folded);
+            tab->tocFilterTitles.Append(folded);
+        }
+        return true;
+    });
+}
+
+/* Applies the filter box's text to the ToC: the matching items are shown
+   as a flat list in document order, clearing the filter restores the
+   full tree. Extending the filter only rescans the previous matches, so
+   each keystroke narrows within a frame even for huge outlines. */
+static void UpdateTocFilter(WindowInfo* win, const WCHAR* filter) {
+    TabInfo* tab = win->currentTab;
+    if (!tab || !tab->currToc) {
+        return;
+    }
+    TreeCtrl* treeCtrl = win->tocTreeCtrl;
+
+    AutoFreeWstr folded(str::Dup(filter));
+    CharLowerW(folded.Get());
+
+    if (str::IsEmpty(folded.Get())) {
+        tab->tocFilterMatches.Reset();
+        tab->tocFilterText.Set(nullptr);
+        if (win->tocFilteredTree) {
+            TocTree* toShow = tab->tocSorted ? tab->tocSorted : tab->currToc;
+            treeCtrl->SetTreeModel(toShow);
+            delete win->tocFilteredTree;
+            win->tocFilteredTree = nullptr;
+        }
+        return;
+    }
+
+    // extending the filter can only shrink the match set, so rescan the
+    // previous matches instead of the whole index
+    bool narrows = !str::IsEmpty(tab->tocFilterText.Get()) && str::StartsWith(folded.Get(), tab->tocFilterText.Get());
+    Vec<int> matches;
+    if (narrows) {
+        for (int idx : tab->tocFilterMatches) {
+            if (str::Find(tab->tocFilterTitles.at(idx), folded)) {
+                matches.Append(idx);
+            }
+        }
+    } else {
+        int n = tab->tocFilterItems.isize();
+        for (int i = 0; i < n; i++) {
+            if (str::Find(tab->tocFilterTitles.at(i), folded)) {
+                matches.Append(i);
+            }
+        }
+    }
+    tab->tocFilterMatches.Reset();
+    for (int idx : matches) {
+        tab->tocFilterMatches.Append(idx);
+    }
+    tab->tocFilterText.SetCopy(folded);
+
+    // shallow copies suffice: navigation only needs title, page number
+    // and destination
+    TocItem* root = nullptr;
+    TocItem* last = nullptr;
+    for (int idx : matches) {
+        TocItem* src = tab->tocFilterItems.at(idx);
+        auto* it = new TocItem(nullptr, src->title, src->pageNo);
+        it->dest = clonePageDestination(src->dest);
+        it->id = src->id;
+        if (!root) {
+            root = it;
+        } else {
+            last->next = it;
+        }
+        last = it;
+    }
+    auto* filtered = new TocTree();
+    filtered->root = root;
+    treeCtrl->SetTreeModel(filtered);
+    delete win->tocFilteredTree;
+    win->tocFilteredTree = filtered;
+}
+
+static void TocFilterTextChanged(EditTextChangedEvent* ev) {
+    WindowInfo* win = FindWindowInfoByHwnd(ev->hwnd);
+    if (!win) {
+        return;
+    }
+    AutoFreeWstr filter(strconv::Utf8ToWstr(ev->text));
+    UpdateTocFilter(win, filter);
+}
+
 static void dropDownSelectionChanged(DropDownSelectionChangedEvent* ev) {
     WindowInfo* win = FindWindowInfoByHwnd(ev->hwnd);
     TabInfo* tab = win->currentTab;
@@ -839,12 +947,40 @@ void LoadTocTree(WindowInfo* win) {
 
     win->tocLoaded = true;
 
+    DisplayModel* dm = tab->AsFixed();
+    if (dm && !dm->IsTocReady()) {
+        // walking a huge outline can take a second or more, so build the
+        // TOC tree on the thread pool and fill the sidebar once it's done;
+        // the document paints and responds in the meantime
+        if (!dm->tocBuildTask) {
+            dm->BuildTocAsync([win, tab] {
+                if (!WindowInfoStillValid(win) || !win->tabs.Contains(tab)) {
+                    // the window or the tab was closed while we were building
+                    return;
+                }
+                if (win->currentTab != tab || !win->tocLoaded) {
+                    // the user switched tabs; switching back runs
+                    // LoadTocTree again and finds the tree ready
+                    return;
+                }
+                win->tocLoaded = false;
+                LoadTocTree(win);
+            });
+        }
+        // else: a build with a pending sidebar fill is already under way
+        return;
+    }
+
     auto* tocTree = tab->ctrl->GetToc();
     if (!tocTree || !tocTree->root) {
         return;
     }
 
     tab->currToc = tocTree;
+    BuildTocFilterIndex(tab);
+    delete win->tocFilteredTree;
+    win->tocFilteredTree = nullptr;
+    win->tocFilterEdit->SetText(L"");
 
     DeleteVecMembers(tab->altBookmarks);
 
@@ -887,13 +1023,16 @@ void LoadTocTree(WindowInfo* win) {
     SetInitialExpandState(tocTree->root, tab->tocState);
     tocTree->root->OpenSingleNode();
 
+    // MaterializeTreeItem() in TreeCtrl navigates via Parent(), which
+    // not all engines fill out
+    SetTocTreeParents(tocTree->root);
     treeCtrl->SetTreeModel(tocTree);
 
     treeCtrl->onTreeItemCustomDraw = nullptr;
     if (ShouldCustomDraw(win)) {
         treeCtrl->onTreeItemCustomDraw = OnTocCustomDraw;
     }
-    LayoutTreeContainer(win->tocLabelWithClose, win->altBookmarks, win->tocTreeCtrl->hwnd);
+    LayoutTreeContainer(win->tocLabelWithClose, win->altBookmarks, win->tocFilterEdit, win->tocTreeCtrl->hwnd);
     // uint fl = RDW_ERASE | RDW_FRAME | RDW_INVALIDATE | RDW_ALLCHILDREN;
     // RedrawWindow(hwnd, nullptr, nullptr, fl);
 }
@@ -1023,7 +1162,7 @@ static void TocTreeMsgFilter([[maybe_unused]] WndEvent* ev) {
 
 // Position label with close button and tree window within their parent.
 // Used for toc and favorites.
-void LayoutTreeContainer(LabelWithCloseWnd* l, DropDownCtrl* altBookmarks, HWND hwndTree) {
+void LayoutTreeContainer(LabelWithCloseWnd* l, DropDownCtrl* altBookmarks, EditCtrl* filter, HWND hwndTree) {
     HWND hwndContainer = GetParent(hwndTree);
     Size labelSize = l->GetIdealSize();
     Rect rc = WindowRect (hwndContainer);
@@ -1042,6 +1181,15 @@ void LayoutTreeContainer(LabelWithCloseWnd* l, DropDownCtrl* altBookmarks, HWND
         dy -= elDy;
         y += elDy;
     }
+    if (filter) {
+        Size fs = filter->GetIdealSize();
+        int elDy = fs.dy;
+        RECT r{0, y, rc.dx, y + elDy};
+        filter->SetBounds(r);
+        elDy += 2;
+        dy -= elDy;
+        y += elDy;
+    }
     MoveWindow(hwndTree, 0, y, rc.dx, dy, TRUE);
 }
 
@@ -1064,7 +1212,7 @@ static LRESULT CALLBACK WndProcTocBox(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp,
 
     switch (msg) {
         case WM_SIZE:
-            LayoutTreeContainer(win->tocLabelWithClose, win->altBookmarks, win->tocTreeCtrl->hwnd);
+            LayoutTreeContainer(win->tocLabelWithClose, win->altBookmarks, win->tocFilterEdit, win->tocTreeCtrl->hwnd);
             break;
 
         case WM_COMMAND:
@@ -1147,8 +1295,18 @@ void CreateToc(WindowInfo* win) {
     win->altBookmarks = new DropDownCtrl(win->hwndTocBox);
     win->altBookmarks->Create();
 
+    // filter-as-you-type over the ToC item titles (see UpdateTocFilter)
+    auto* filterEdit = new EditCtrl(win->hwndTocBox);
+    filterEdit->Create();
+    filterEdit->SetCueText("Filter");
+    filterEdit->onTextChanged = TocFilterTextChanged;
+    win->tocFilterEdit = filterEdit;
+
     auto* treeCtrl = new TreeCtrl(win->hwndTocBox);
     treeCtrl->dwExStyle = WS_EX_STATICEDGE;
+    // insert tree view items for collapsed parts of huge outlines
+    // on first expand, so that opening the document stays fast
+    treeCtrl->deferChildren = true;
     treeCtrl->onGetTooltip = TocCustomizeTooltip;
     treeCtrl->onContextMenu = TocContextMenu;
     treeCtrl->onChar = TocTreeCharHandler;
@@ -41,6 +41,8 @@
 #include "utils/Log.h"
 #include "utils/LogDbg.h"
 
+#pragma warning(disable : 28159) // silence /analyze: Consider using 'GetTickCount64' instead of 'GetTickCount'
+
 using Gdiplus::ARGB;
 using Gdiplus::Bitmap;
 using Gdiplus::Brush;
@@ -673,6 +675,37 @@ static NO_INLINE void VerifyTabInfo(WindowInfo* win, TabInfo* tdata) {
     SubmitCrashIf(tdata->canvasRc != win->canvasRc);
 }
 
+// keeps a copy of the canvas as currently painted (from the double
+// buffer of the last paint) so that switching back to this tab can show
+// it instantly while RenderCache re-renders behind it
+static void CaptureCanvasSnapshot(WindowInfo* win, TabInfo* tab) {
+    if (tab->canvasSnapshot) {
+        DeleteObject(tab->canvasSnapshot);
+        tab->canvasSnapshot = nullptr;
+    }
+    if (!tab->AsFixed() || !win->buffer) {
+        return;
+    }
+    Rect rect = win->buffer->rect;
+    if (rect.IsEmpty()) {
+        return;
+    }
+    HDC hdc = GetDC(win->hwndCanvas);
+    HDC bmpDC = CreateCompatibleDC(hdc);
+    HBITMAP bmp = CreateCompatibleBitmap(hdc, rect.dx, rect.dy);
+    if (bmpDC && bmp) {
+        HGDIOBJ prevBmp = SelectObject(bmpDC, bmp);
+        BitBlt(bmpDC, 0, 0, rect.dx, rect.dy, win->buffer->GetDC(), 0, 0, SRCCOPY);
+        SelectObject(bmpDC, prevBmp);
+        tab->canvasSnapshot = bmp;
+        tab->canvasSnapshotSize = Size(rect.dx, rect.dy);
+    } else {
+        DeleteObject(bmp);
+    }
+    DeleteDC(bmpDC);
+    ReleaseDC(win->hwndCanvas, hdc);
+}
+
 // Must be called when the active tab is losing selection.
 // This happens when a new document is loaded or when another tab is selected.
 void SaveCurrentTabInfo(WindowInfo* win) {
@@ -687,12 +720,21 @@ void SaveCurrentTabInfo(WindowInfo* win) {
     CrashIf(win->currentTab != win->tabs.at(current));
 
     TabInfo* tab = win->currentTab;
+    if (!tab->ctrl && tab->pendingRestore) {
+        // a lazily restored tab that was never loaded has no state to save
+        return;
+    }
     if (win->tocLoaded) {
         TocTree* tocTree = tab->ctrl->GetToc();
         UpdateTocExpansionState(tab->tocState, win->tocTreeCtrl, tocTree);
     }
     VerifyTabInfo(win, tab);
 
+    CaptureCanvasSnapshot(win, tab);
+
+    // the tab's idle time (after which it may be hibernated) starts now
+    tab->lastActiveTick = GetTickCount();
+
     // update the selection history
     win->tabSelectionHistory->Remove(tab);
     win->tabSelectionHistory->Append(tab);
@@ -0,0 +1,258 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
+#include "utils/CryptoUtil.h"
+#include "utils/FileUtil.h"
+
+#include "wingui/TreeModel.h"
+
+#include "Annotation.h"
+#include "EngineBase.h"
+#include "TextSelection.h"
+
+#include "AppTools.h"
+#include "TextIndexCache.h"
+
+// the index files live next to the thumbnails
+#define TEXT_INDEX_DIR_NAME L"sumatrapdfcache"
+
+// bump this whenever the serialization format changes
+#define TEXT_INDEX_VERSION 2
+constexpr u32 TEXT_INDEX_MAGIC = 0x49545053; // 'SPTI'
+
+#define CONTENT_BOX_VERSION 2
+constexpr u32 CONTENT_BOX_MAGIC = 0x42435053; // 'SPCB'
+
+/* An index file is a TextIndexHeader followed by nPages of:
+     i32 len, len WCHARs of page text, len Rects of glyph coordinates
+   fileSize and fileMtime identify the document version the index was
+   built from; a stale index is simply ignored (and overwritten). When
+   only the mtime changed (the file was re-downloaded or copied), the
+   sampled content fingerprint rescues the index. */
+struct TextIndexHeader {
+    u32 magic;
+    u32 version;
+    i64 fileSize;
+    FILETIME fileMtime;
+    u8 contentFingerprint[16];
+    i32 nPages;
+};
+
+// same (normalized) path fingerprint scheme as GetThumbnailPath in
+// FileThumbnails.cpp, with a different extension
+static WCHAR* GetIndexCachePath(const WCHAR* filePath, const WCHAR* ext) {
+    u8 digest[16];
+    if (!filePath) {
+        return nullptr;
+    }
+    AutoFree pathU(strconv::WstrToUtf8(filePath));
+    if (!pathU.Get()) {
+        return nullptr;
+    }
+    if (path::HasVariableDriveLetter(filePath)) {
+        pathU.Get()[0] = '?'; // ignore the drive letter, if it might change
+    }
+    CalcMD5Digest((u8*)pathU.Get(), str::Len(pathU.Get()), digest);
+    AutoFree fingerPrint(_MemToHex(&digest));
+
+    AutoFreeWstr indexPath(AppGenDataFilename(TEXT_INDEX_DIR_NAME));
+    if (!indexPath) {
+        return nullptr;
+    }
+    AutoFreeWstr fname(strconv::FromAnsi(fingerPrint));
+
+    return str::Format(L"%s\\%s.%s", indexPath.Get(), fname.Get(), ext);
+}
+
+static i64 GetDocumentFileSize(const WCHAR* filePath) {
+    AutoFree pathA(strconv::WstrToUtf8(filePath));
+    if (!pathA.Get()) {
+        return -1;
+    }
+    return file::GetSize(std::string_view(pathA.Get()));
+}
+
+// a differing mtime alone doesn't make the cache stale: the sampled
+// content fingerprint (cheap even for huge files) tells a rewritten
+// timestamp from an actually changed document
+static bool IsDocumentUnchanged(const WCHAR* filePath, const TextIndexHeader* hdr) {
+    if (hdr->fileSize != GetDocumentFileSize(filePath)) {
+        return false;
+    }
+    FILETIME mtime = file::GetModificationTime(filePath);
+    if (FileTimeDiffInSecs(mtime, hdr->fileMtime) == 0) {
+        return true;
+    }
+    u8 fingerprint[16];
+    if (!CalcSampledFileFingerprint(filePath, fingerprint)) {
+        return false;
+    }
+    return memeq(fingerprint, hdr->contentFingerprint, sizeof(fingerprint));
+}
+
+/* Restore extracted page text from a previous session. Returns false (and
+   leaves the cache untouched) if there's no index for the document or the
+   document changed since the index was written. */
+bool LoadTextIndexCache(const WCHAR* filePath, DocumentTextCache* textCache) {
+    AutoFreeWstr tixPath(GetIndexCachePath(filePath, L"tix"));
+    if (!tixPath) {
+        return false;
+    }
+    AutoFree data(file::ReadFile(tixPath.Get()));
+    if (!data.data) {
+        return false;
+    }
+
+    const char* cur = data.data;
+    size_t left = data.size();
+    if (left < sizeof(TextIndexHeader)) {
+        return false;
+    }
+    TextIndexHeader hdr;
+    memcpy(&hdr, cur, sizeof(hdr));
+    cur += sizeof(hdr);
+    left -= sizeof(hdr);
+
+    if (hdr.magic != TEXT_INDEX_MAGIC || hdr.version != TEXT_INDEX_VERSION) {
+        return false;
+    }
+    if (hdr.nPages != textCache->nPages) {
+        return false;
+    }
+    if (!IsDocumentUnchanged(filePath, &hdr)) {
+        return false;
+    }
+
+    for (int pageNo = 1; pageNo <= hdr.nPages; pageNo++) {
+        if (left < sizeof(i32)) {
+            return false;
+        }
+        i32 len;
+        memcpy(&len, cur, sizeof(len));
+        cur += sizeof(len);
+        left -= sizeof(len);
+        size_t need = (size_t)len * (sizeof(WCHAR) + sizeof(Rect));
+        if (len < 0 || left < need) {
+            return false;
+        }
+
+        PageText pt;
+        pt.len = len;
+        pt.text = AllocArray<WCHAR>((size_t)len + 1);
+        memcpy(pt.text, cur, (size_t)len * sizeof(WCHAR));
+        cur += (size_t)len * sizeof(WCHAR);
+        pt.coords = (Rect*)memdup((void*)cur, (size_t)len * sizeof(Rect));
+        cur += (size_t)len * sizeof(Rect);
+        left -= need;
+
+        textCache->SetTextForPage(pageNo, pt);
+    }
+    return true;
+}
+
+/* Serialize the fully extracted text cache so that the next time the
+   document is opened, search doesn't have to re-extract every page.
+   Only complete caches are written (a partial index would silently make
+   search miss pages). */
+bool SaveTextIndexCache(const WCHAR* filePath, DocumentTextCache* textCache) {
+    AutoFreeWstr tixPath(GetIndexCachePath(filePath, L"tix"));
+    if (!tixPath) {
+        return false;
+    }
+
+    TextIndexHeader hdr{};
+    hdr.magic = TEXT_INDEX_MAGIC;
+    hdr.version = TEXT_INDEX_VERSION;
+    hdr.fileSize = GetDocumentFileSize(filePath);
+    hdr.fileMtime = file::GetModificationTime(filePath);
+    CalcSampledFileFingerprint(filePath, hdr.contentFingerprint);
+    hdr.nPages = textCache->nPages;
+
+    str::Str d;
+    d.Append((const char*)&hdr, sizeof(hdr));
+
+    ScopedCritSec scope(&textCache->access);
+    for (int i = 0; i < textCache->nPages; i++) {
+        PageText* pt = &textCache->pagesText[i];
+        if (!pt->text) {
+            return false;
+        }
+        i32 len = pt->len;
+        d.Append((const char*)&len, sizeof(len));
+        d.Append((const char*)pt->text, (size_t)len * sizeof(WCHAR));
+        d.Append((const char*)pt->coords, (size_t)len * sizeof(Rect));
+    }
+
+    AutoFreeWstr dirPath(path::GetDir(tixPath));
+    if (!dir::Create(dirPath)) {
+        return false;
+    }
+    return file::WriteFile(tixPath.Get(), d.AsSpan());
+}
+
+/* Restore the per-page content boxes computed by a previous session's
+   sweep (see DisplayModel::StartContentBoxSweep). Returns false if there's
+   no cache for the document or the document changed since it was written. */
+bool LoadContentBoxCache(const WCHAR* filePath, int nPages, RectF* boxes) {
+    AutoFreeWstr cbxPath(GetIndexCachePath(filePath, L"cbx"));
+    if (!cbxPath) {
+        return false;
+    }
+    AutoFree data(file::ReadFile(cbxPath.Get()));
+    if (!data.data) {
+        return false;
+    }
+
+    const char* cur = data.data;
+    size_t left = data.size();
+    if (left < sizeof(TextIndexHeader)) {
+        return false;
+    }
+    TextIndexHeader hdr;
+    memcpy(&hdr, cur, sizeof(hdr));
+    cur += sizeof(hdr);
+    left -= sizeof(hdr);
+
+    if (hdr.magic != CONTENT_BOX_MAGIC || hdr.version != CONTENT_BOX_VERSION) {
+        return false;
+    }
+    if (hdr.nPages != nPages) {
+        return false;
+    }
+    if (!IsDocumentUnchanged(filePath, &hdr)) {
+        return false;
+    }
+
+    if (left != (size_t)nPages * sizeof(RectF)) {
+        return false;
+    }
+    memcpy(boxes, cur, left);
+    return true;
+}
+
+bool SaveContentBoxCache(const WCHAR* filePath, int nPages, const RectF* boxes) {
+    AutoFreeWstr cbxPath(GetIndexCachePath(filePath, L"cbx"));
+    if (!cbxPath) {
+        return false;
+    }
+
+    TextIndexHeader hdr{};
+    hdr.magic = CONTENT_BOX_MAGIC;
+    hdr.version = CONTENT_BOX_VERSION;
+    hdr.fileSize = GetDocumentFileSize(filePath);
+    hdr.fileMtime = file::GetModificationTime(filePath);
+    CalcSampledFileFingerprint(filePath, hdr.contentFingerprint);
+    hdr.nPages = nPages;
+
+    str::Str d;
+    d.Append((const char*)&hdr, sizeof(hdr));
+    d.Append((const char*)boxes, (size_t)nPages * sizeof(RectF));
+
+    AutoFreeWstr dirPath(path::GetDir(cbxPath));
+    if (!dir::Create(dirPath)) {
+        return false;
+    }
+    return file::WriteFile(cbxPath.Get(), d.AsSpan());
+}
@@ -0,0 +1,10 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+struct DocumentTextCache;
+
+bool LoadTextIndexCache(const WCHAR* filePath, DocumentTextCache* textCache);
+bool SaveTextIndexCache(const WCHAR* filePath, DocumentTextCache* textCache);
+
+bool LoadContentBoxCache(const WCHAR* filePath, int nPages, RectF* boxes);
+bool SaveContentBoxCache(const WCHAR* filePath, int nPages, const RectF* boxes);
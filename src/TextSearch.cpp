@@ -3,6 +3,7 @@
 
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
+#include "utils/EtwTrace.h"
 
 #include "wingui/TreeModel.h"
 
@@ -38,6 +39,8 @@ void TextSearch::Reset() {
 }
 
 void TextSearch::SetText(const WCHAR* text) {
+    bool prevMatchWordStart = this->matchWordStart;
+
     // search text starting with a single space enables the 'Match word start'
     // and search text ending in a single space enables the 'Match word end' option
     // (that behavior already "kind of" exists without special treatment, but
@@ -54,6 +57,16 @@ void TextSearch::SetText(const WCHAR* text) {
         return;
     }
 
+    // find-as-you-type extends the term one character at a time; a page
+    // that had no match for the old term can't match an extension of it,
+    // so the pagesToSkip results carry over. That doesn't hold when a
+    // word-start restriction gets dropped, as that re-admits matches
+    // inside of words that the previous search skipped over
+    bool extendsLast = !str::IsEmpty(this->lastText) &&
+                       (caseSensitive ? str::StartsWith(text, this->lastText)
+                                      : str::StartsWithI(text, this->lastText)) &&
+                       (!prevMatchWordStart || this->matchWordStart);
+
     this->Clear();
     this->lastText = str::Dup(text);
     this->findText = str::Dup(text);
@@ -82,7 +95,9 @@ void TextSearch::SetText(const WCHAR* text) {
         this->findText[str::Len(this->findText) - 1] = '\0';
     }
 
-    markAllPagesNonSkip(pagesToSkip);
+    if (!extendsLast) {
+        markAllPagesNonSkip(pagesToSkip);
+    }
 }
 
 void TextSearch::SetSensitive(bool sensitive) {
@@ -227,6 +242,40 @@ TextSearch::PageAndOffset TextSearch::MatchEnd(const WCHAR* start) const {
     return {currentPage, off};
 }
 
+// this duplicates the folding of shlwapi's ChrCmpI, which StrStrI uses
+static bool ChrEqI(WCHAR c1, WCHAR c2) {
+    if (c1 == c2) {
+        return true;
+    }
+    WCHAR u1 = (WCHAR)(uintptr_t)CharUpperW((LPWSTR)(uintptr_t)c1);
+    WCHAR u2 = (WCHAR)(uintptr_t)CharUpperW((LPWSTR)(uintptr_t)c2);
+    return u1 == u2;
+}
+
+// matches what StrStrI(s, anchor) finds, but instead of case-folding
+// every character of the page text it scans for the two case variants
+// of the anchor's first character with the vectorized str::FindChar2
+// and only verifies the candidates
+static const WCHAR* FindAnchorNoCase(const WCHAR* s, const WCHAR* anchor) {
+    WCHAR lo = (WCHAR)(uintptr_t)CharLowerW((LPWSTR)(uintptr_t)*anchor);
+    WCHAR up = (WCHAR)(uintptr_t)CharUpperW((LPWSTR)(uintptr_t)*anchor);
+    for (;;) {
+        s = str::FindChar2(s, lo, up);
+        if (!s) {
+            return nullptr;
+        }
+        const WCHAR *c = s, *match = anchor;
+        while (*match && ChrEqI(*c, *match)) {
+            c++;
+            match++;
+        }
+        if (!*match) {
+            return s;
+        }
+        s++;
+    }
+}
+
 static const WCHAR* GetNextIndex(const WCHAR* base, int offset, bool forward) {
     const WCHAR* c = base + offset + (forward ? 0 : -1);
     if (c < base || !*c) {
@@ -246,6 +295,10 @@ bool TextSearch::FindTextInPage(int pageNo, TextSearch::PageAndOffset* finalGlyp
     // get here with pageNo != 0 the findText has already been set so I didn't add
     // a findText = textCache->GetData(findPage) here.
     findPage = pageNo;
+    // re-fetch the page's text: arbitrarily long can pass between two
+    // FindNext() calls and the cache may have evicted (and will now
+    // re-extract) the page in the meantime; only findIndex carries over
+    pageText = textCache->GetTextForPage(findPage);
 
     const WCHAR* found;
     PageAndOffset fg;
@@ -257,7 +310,7 @@ bool TextSearch::FindTextInPage(int pageNo, TextSearch::PageAndOffset* finalGlyp
             if (caseSensitive) {
                 found = StrStr(s, anchor);
             } else {
-                found = StrStrI(s, anchor);
+                found = FindAnchorNoCase(s, anchor);
             }
         } else {
             found = StrRStrI(pageText, pageText + findIndex, anchor);
@@ -290,6 +343,7 @@ bool TextSearch::FindStartingAtPage(int pageNo, ProgressUpdateUI* tracker) {
     if (str::IsEmpty(findText)) {
         return false;
     }
+    ScopedTraceEvent trc("text-search", pageNo);
 
     int next = forward ? 1 : -1;
     while (1 <= pageNo && pageNo <= nPages && (!tracker || !tracker->WasCanceled())) {
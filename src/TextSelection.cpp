@@ -3,11 +3,13 @@
 
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
+#include "utils/MemAccounting.h"
 
 #include "wingui/TreeModel.h"
 
 #include "Annotation.h"
 #include "EngineBase.h"
+#include "MemoryPolicy.h"
 #include "TextSelection.h"
 
 uint distSq(int x, int y) {
@@ -21,25 +23,114 @@ bool isWordChar(WCHAR c) {
 DocumentTextCache::DocumentTextCache(EngineBase* engine) : engine(engine) {
     nPages = engine->PageCount();
     pagesText = AllocArray<PageText>(nPages);
-    debugSize = nPages * (sizeof(Rect*) + sizeof(WCHAR*) + sizeof(int));
+    pagesIndex = AllocArray<PageTextIndex>(nPages);
+    pagesLastUse = AllocArray<u32>(nPages);
+    debugSize = nPages * (sizeof(Rect*) + sizeof(WCHAR*) + sizeof(int) + sizeof(PageTextIndex) + sizeof(u32));
+    memacct::Add(memacct::SubsysTextCache, debugSize);
 
     InitializeCriticalSection(&access);
 }
 
 DocumentTextCache::~DocumentTextCache() {
     EnterCriticalSection(&access);
-
-    int nPages = engine->PageCount();
+    memacct::Add(memacct::SubsysTextCache, -debugSize);
     for (int i = 0; i < nPages; i++) {
-        PageText* pageText = &pagesText[i];
-        free(pageText->coords);
-        free(pageText->text);
+        free(pagesText[i].text);
+        free(pagesText[i].coords);
+        free(pagesIndex[i].runs);
     }
+    free(pagesLastUse);
+    free(pagesIndex);
     free(pagesText);
     LeaveCriticalSection(&access);
     DeleteCriticalSection(&access);
 }
 
+DocumentTextCache* DocumentTextCache::AddRef() {
+    CrashIf(refs < 1);
+    refs++;
+    return this;
+}
+
+void DocumentTextCache::DropRef() {
+    CrashIf(refs < 1);
+    refs--;
+    if (refs == 0) {
+        delete this;
+    }
+}
+
+// move extraction results into cache-owned heap blocks and free the
+// originals (the extraction buffers are oversized)
+static PageText StorePageText(PageText* extracted) {
+    PageText res;
+    res.len = extracted->len;
+    if (extracted->text) {
+        size_t cb = ((size_t)extracted->len + 1) * sizeof(WCHAR);
+        res.text = (WCHAR*)Allocator::MemDup(nullptr, extracted->text, cb);
+    } else {
+        res.text = str::Dup(L"");
+        res.len = 0;
+    }
+    if (extracted->coords) {
+        res.coords = (Rect*)Allocator::MemDup(nullptr, extracted->coords, (size_t)extracted->len * sizeof(Rect));
+    }
+    FreePageText(extracted);
+    return res;
+}
+
+void DocumentTextCache::DropPage(int pageNo) {
+    CrashIf(pageNo < 1 || pageNo > nPages);
+    PageText* pageText = &pagesText[pageNo - 1];
+    i64 cb = ((i64)pageText->len + 1) * (int)(sizeof(WCHAR) + sizeof(Rect));
+    free(pageText->text);
+    free(pageText->coords);
+    *pageText = {};
+    PageTextIndex* index = &pagesIndex[pageNo - 1];
+    if (index->runs) {
+        cb += (i64)index->nRuns * sizeof(PageLineRun);
+        free(index->runs);
+    }
+    *index = {};
+    cachedBytes -= cb;
+    debugSize -= (int)cb;
+    memacct::Add(memacct::SubsysTextCache, -cb);
+}
+
+// pages this close to the most recent access are never evicted: callers
+// briefly use the returned pointers after <access> is released, so a
+// page can only go away under them if other threads extract this many
+// other pages (milliseconds of engine work) within that window
+#define EVICT_KEEP_RECENT 64
+
+void DocumentTextCache::EvictOverBudget() {
+    i64 budget = GetMemoryPolicy().textCacheBudget;
+    while (cachedBytes > budget) {
+        int lru = -1;
+        u32 lruDist = 0;
+        for (int i = 0; i < nPages; i++) {
+            if (!pagesText[i].text) {
+                continue;
+            }
+            // unsigned distance also orders correctly across wrap-around
+            u32 dist = useGen - pagesLastUse[i];
+            if (dist < EVICT_KEEP_RECENT) {
+                continue;
+            }
+            if (dist > lruDist) {
+                lruDist = dist;
+                lru = i;
+            }
+        }
+        if (lru == -1) {
+            // everything left was recently used; overshooting the budget
+            // beats freeing text someone may still hold a pointer into
+            return;
+        }
+        DropPage(lru + 1);
+    }
+}
+
 bool DocumentTextCache::HasTextForPage(int pageNo) {
     CrashIf(pageNo < 1 || pageNo > nPages);
     PageText* pageText = &pagesText[pageNo - 1];
@@ -51,14 +142,16 @@ const WCHAR* DocumentTextCache::GetTextForPage(int pageNo, int* lenOut, Rect** c
 
     ScopedCritSec scope(&access);
     PageText* pageText = &pagesText[pageNo - 1];
+    pagesLastUse[pageNo - 1] = ++useGen;
 
     if (!pageText->text) {
-        *pageText = engine->ExtractPageText(pageNo);
-        if (!pageText->text) {
-            pageText->text = str::Dup(L"");
-            pageText->len = 0;
-        }
-        debugSize += (pageText->len + 1) * (int)(sizeof(WCHAR) + sizeof(Rect));
+        PageText extracted = engine->ExtractPageText(pageNo);
+        *pageText = StorePageText(&extracted);
+        int cb = (pageText->len + 1) * (int)(sizeof(WCHAR) + sizeof(Rect));
+        debugSize += cb;
+        cachedBytes += cb;
+        memacct::Add(memacct::SubsysTextCache, cb);
+        EvictOverBudget();
     }
 
     if (lenOut) {
@@ -70,6 +163,105 @@ const WCHAR* DocumentTextCache::GetTextForPage(int pageNo, int* lenOut, Rect** c
     return pageText->text;
 }
 
+void DocumentTextCache::SetTextForPage(int pageNo, PageText pageText) {
+    CrashIf(pageNo < 1 || pageNo > nPages);
+
+    ScopedCritSec scope(&access);
+    PageText* cached = &pagesText[pageNo - 1];
+    if (cached->text) {
+        // another thread extracted this page first
+        FreePageText(&pageText);
+        return;
+    }
+
+    // a page stored by a background worker wasn't requested by anyone
+    // yet; stamp it old enough to evict so that an indexing sweep of a
+    // long document can't age out the pages the user actually touched
+    pagesLastUse[pageNo - 1] = useGen - EVICT_KEEP_RECENT;
+    *cached = StorePageText(&pageText);
+    int cb = (cached->len + 1) * (int)(sizeof(WCHAR) + sizeof(Rect));
+    debugSize += cb;
+    cachedBytes += cb;
+    memacct::Add(memacct::SubsysTextCache, cb);
+    EvictOverBudget();
+}
+
+void DocumentTextCache::ReplaceEmptyTextForPage(int pageNo, PageText pageText) {
+    CrashIf(pageNo < 1 || pageNo > nPages);
+
+    ScopedCritSec scope(&access);
+    PageText* cached = &pagesText[pageNo - 1];
+    if (cached->text && cached->len > 0) {
+        // the page turned out to have text after all
+        FreePageText(&pageText);
+        return;
+    }
+
+    // drop the empty entry and any index built from it; if it was handed
+    // out just now a reader may still look at the (single WCHAR) string,
+    // in which case it's intentionally leaked instead of freed
+    if (cached->text) {
+        if (useGen - pagesLastUse[pageNo - 1] < EVICT_KEEP_RECENT) {
+            cached->text = nullptr;
+        }
+        DropPage(pageNo);
+    }
+    pagesLastUse[pageNo - 1] = useGen - EVICT_KEEP_RECENT;
+    *cached = StorePageText(&pageText);
+    int cb = (cached->len + 1) * (int)(sizeof(WCHAR) + sizeof(Rect));
+    debugSize += cb;
+    cachedBytes += cb;
+    memacct::Add(memacct::SubsysTextCache, cb);
+    EvictOverBudget();
+}
+
+// line run index of a page, built on first use from the glyph coords
+const PageTextIndex* DocumentTextCache::GetIndexForPage(int pageNo) {
+    CrashIf(pageNo < 1 || pageNo > nPages);
+
+    ScopedCritSec scope(&access);
+    PageTextIndex* index = &pagesIndex[pageNo - 1];
+    if (index->built) {
+        pagesLastUse[pageNo - 1] = ++useGen;
+        return index;
+    }
+
+    int len;
+    Rect* coords;
+    GetTextForPage(pageNo, &len, &coords);
+
+    Vec<PageLineRun> runs;
+    int i = 0;
+    while (i < len) {
+        // line break glyphs have no extent and separate the runs
+        for (; i < len && !coords[i].x && !coords[i].dx; i++) {
+            // no-op
+        }
+        if (i == len) {
+            break;
+        }
+
+        PageLineRun run;
+        run.startGlyph = i;
+        for (; i < len && (coords[i].x || coords[i].dx); i++) {
+            run.bbox = run.bbox.Union(coords[i]);
+        }
+        run.endGlyph = i;
+        runs.Append(run);
+    }
+
+    index->nRuns = runs.isize();
+    if (index->nRuns > 0) {
+        size_t cb = (size_t)index->nRuns * sizeof(PageLineRun);
+        index->runs = (PageLineRun*)Allocator::MemDup(nullptr, runs.LendData(), cb);
+        debugSize += (int)cb;
+        cachedBytes += (i64)cb;
+        memacct::Add(memacct::SubsysTextCache, (int)cb);
+    }
+    index->built = true;
+    return index;
+}
+
 TextSelection::TextSelection(EngineBase* engine, DocumentTextCache* textCache) : engine(engine), textCache(textCache) {
 }
 
@@ -86,6 +278,23 @@ void TextSelection::Reset() {
     result.rects = nullptr;
 }
 
+// squared distance from a point to a rectangle (0 if the point is inside);
+// a lower bound for the distance to anything within the rectangle
+static uint distSqToRect(int x, int y, Rect r) {
+    int dx = 0, dy = 0;
+    if (x < r.x) {
+        dx = r.x - x;
+    } else if (x > r.x + r.dx) {
+        dx = x - (r.x + r.dx);
+    }
+    if (y < r.y) {
+        dy = r.y - y;
+    } else if (y > r.y + r.dy) {
+        dy = y - (r.y + r.dy);
+    }
+    return distSq(dx, dy);
+}
+
 // returns the index of the glyph closest to the right of the given coordinates
 // (i.e. when over the right half of a glyph, the returned index will be for the
 // glyph following it, which will be the first glyph (not) to be selected)
@@ -93,6 +302,7 @@ static int FindClosestGlyph(TextSelection* ts, int pageNo, double x, double y) {
     int textLen;
     Rect* coords;
     ts->textCache->GetTextForPage(pageNo, &textLen, &coords);
+    const PageTextIndex* index = ts->textCache->GetIndexForPage(pageNo);
     PointF pt = PointF(x, y);
 
     unsigned int maxDist = UINT_MAX;
@@ -100,25 +310,40 @@ static int FindClosestGlyph(TextSelection* ts, int pageNo, double x, double y) {
     bool overGlyph = false;
     int result = -1;
 
-    for (int i = 0; i < textLen; i++) {
-        Rect& coord = coords[i];
-        if (!coord.x && !coord.dx) {
-            continue;
-        }
-        if (overGlyph && !coord.Contains(pti)) {
-            continue;
+    // instead of scanning every glyph rect, scan per line run and skip
+    // runs that can't improve on the best glyph found so far: a run's
+    // bbox is the union of its glyphs' rects, so the distance to the
+    // bbox bounds the distance to any glyph center within and a glyph
+    // can only contain the cursor if its run's bbox does
+    for (int r = 0; r < index->nRuns; r++) {
+        const PageLineRun* run = &index->runs[r];
+        bool overRun = run->bbox.Contains(pti);
+        if (!overRun) {
+            if (overGlyph) {
+                continue;
+            }
+            if (distSqToRect((int)x, (int)y, run->bbox) >= maxDist) {
+                continue;
+            }
         }
 
-        uint dist = distSq((int)x - coord.x - coord.dx / 2, (int)y - coord.y - coord.dy / 2);
-        if (dist < maxDist) {
-            result = i;
-            maxDist = dist;
-        }
-        // prefer glyphs the cursor is actually over
-        if (!overGlyph && coord.Contains(pti)) {
-            overGlyph = true;
-            result = i;
-            maxDist = dist;
+        for (int i = run->startGlyph; i < run->endGlyph; i++) {
+            Rect& coord = coords[i];
+            if (overGlyph && !coord.Contains(pti)) {
+                continue;
+            }
+
+            uint dist = distSq((int)x - coord.x - coord.dx / 2, (int)y - coord.y - coord.dy / 2);
+            if (dist < maxDist) {
+                result = i;
+                maxDist = dist;
+            }
+            // prefer glyphs the cursor is actually over
+            if (!overGlyph && coord.Contains(pti)) {
+                overGlyph = true;
+                result = i;
+                maxDist = dist;
+            }
         }
     }
 
@@ -142,7 +367,8 @@ static int FindClosestGlyph(TextSelection* ts, int pageNo, double x, double y) {
     return result;
 }
 
-static void FillResultRects(TextSelection* ts, int pageNo, int glyph, int length, WStrVec* lines = nullptr) {
+static void FillResultRects(TextSelection* ts, int pageNo, int glyph, int length, str::WStr* dst = nullptr,
+                            const WCHAR* lineSep = nullptr) {
     int len;
     Rect* coords;
     const WCHAR* text = ts->textCache->GetTextForPage(pageNo, &len, &coords);
@@ -165,8 +391,12 @@ static void FillResultRects(TextSelection* ts, int pageNo, int glyph, int length
             continue;
         }
 
-        if (lines) {
-            lines->Append(str::DupN(text + (c0 - coords), c - c0));
+        if (dst) {
+            // append in place; a separator goes between lines, not after each
+            if (dst->size() > 0) {
+                dst->Append(lineSep);
+            }
+            dst->Append(text + (c0 - coords), c - c0);
             continue;
         }
 
@@ -294,22 +524,36 @@ void TextSelection::CopySelection(TextSelection* orig) {
 }
 
 WCHAR* TextSelection::ExtractText(const WCHAR* lineSep) {
-    WStrVec lines;
-
     int fromPage, fromGlyph, toPage, toGlyph;
     GetGlyphRange(&fromPage, &fromGlyph, &toPage, &toGlyph);
 
+    // size the buffer to the sum of the pages' glyph counts so that a
+    // selection spanning hundreds of pages doesn't repeatedly reallocate
+    // a multi-megabyte buffer. The estimate is close but not exact (line
+    // break glyphs are replaced with lineSep); appending grows as needed
+    size_t cap = 0;
+    for (int page = fromPage; page <= toPage; page++) {
+        int textLen;
+        textCache->GetTextForPage(page, &textLen);
+        int glyph = page == fromPage ? fromGlyph : 0;
+        int length = (page == toPage ? toGlyph : textLen) - glyph;
+        if (length > 0) {
+            cap += (size_t)length + str::Len(lineSep);
+        }
+    }
+
+    str::WStr res(cap);
     for (int page = fromPage; page <= toPage; page++) {
         int textLen;
         textCache->GetTextForPage(page, &textLen);
         int glyph = page == fromPage ? fromGlyph : 0;
         int length = (page == toPage ? toGlyph : textLen) - glyph;
         if (length > 0) {
-            FillResultRects(this, page, glyph, length, &lines);
+            FillResultRects(this, page, glyph, length, &res, lineSep);
         }
     }
 
-    return lines.Join(lineSep);
+    return res.StealData();
 }
 
 void TextSelection::GetGlyphRange(int* fromPage, int* fromGlyph, int* toPage, int* toGlyph) const {
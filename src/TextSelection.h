@@ -1,19 +1,71 @@
 /* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
    License: GPLv3 */
 
+// one run of consecutive glyphs forming a line on a page, with the
+// union of the glyphs' bounding boxes. Line break glyphs (no extent)
+// separate runs and belong to none
+struct PageLineRun {
+    int startGlyph{0};
+    int endGlyph{0}; // first glyph past the run
+    Rect bbox;
+};
+
+// per-page list of line runs, in text order; lets glyph hit testing
+// skip whole lines instead of scanning every glyph rect on the page
+// (see FindClosestGlyph)
+struct PageTextIndex {
+    PageLineRun* runs{nullptr};
+    int nRuns{0};
+    bool built{false};
+};
+
 struct DocumentTextCache {
     EngineBase* engine{nullptr};
     int nPages{0};
+    // a page's text, coords and line runs are each one heap block, so
+    // that EvictOverBudget can free single pages (an earlier arena
+    // couldn't); still coarse enough to not churn the process heap
     PageText* pagesText{nullptr};
+    PageTextIndex* pagesIndex{nullptr};
     int debugSize{0};
 
+    // eviction bookkeeping: every access stamps the page with ++useGen,
+    // so the pages untouched for the longest go first when cachedBytes
+    // exceeds the MemoryPolicy budget (see EvictOverBudget)
+    u32* pagesLastUse{nullptr};
+    u32 useGen{0};
+    i64 cachedBytes{0};
+
     CRITICAL_SECTION access;
 
+    // number of owners: the cache can be shared between DisplayModels
+    // showing the same document (all access goes through `access`);
+    // only add/drop refs from the UI thread
+    int refs{1};
+
     explicit DocumentTextCache(EngineBase* engine);
     ~DocumentTextCache();
 
+    DocumentTextCache* AddRef();
+    // deletes the cache when the last owner lets go
+    void DropRef();
+
     bool HasTextForPage(int pageNo);
     const WCHAR* GetTextForPage(int pageNo, int* lenOut = nullptr, Rect** coordsOut = nullptr);
+    const PageTextIndex* GetIndexForPage(int pageNo);
+    // store text extracted outside of the cache (e.g. by an indexing
+    // worker using an engine clone); takes ownership of pageText
+    void SetTextForPage(int pageNo, PageText pageText);
+    // replaces a page's cached text if the regular extraction found none
+    // (scanned pages recognized by the background OCR pass); no-op once
+    // the page has real text. Takes ownership of pageText
+    void ReplaceEmptyTextForPage(int pageNo, PageText pageText);
+
+    // the following must be called with <access> held
+    // frees a page's text, coords and line runs
+    void DropPage(int pageNo);
+    // drops least recently used pages until within the byte budget
+    void EvictOverBudget();
 };
 
 // TODO: replace with Vec<TextSel>
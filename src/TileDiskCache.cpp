@@ -0,0 +1,240 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
+#include "utils/CryptoUtil.h"
+#include "utils/FileUtil.h"
+
+#include "wingui/TreeModel.h"
+
+#include "Annotation.h"
+#include "EngineBase.h"
+#include "EngineCreate.h"
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "Controller.h"
+#include "DisplayModel.h"
+#include "RenderCache.h"
+
+#include "AppTools.h"
+#include "TileDiskCache.h"
+
+// the tile files live next to the thumbnails
+#define TILE_CACHE_DIR_NAME L"sumatrapdfcache"
+
+// bump this whenever the serialization format changes
+#define TILE_CACHE_VERSION 2
+constexpr u32 TILE_CACHE_MAGIC = 0x44545053; // 'SPTD'
+
+/* upper limit for a single document's tile file; the most recently used
+   tiles are written first, so hitting the limit drops the oldest ones */
+#define TILE_CACHE_MAX_FILE_BYTES (32 * 1024 * 1024)
+
+/* A tile file is a TileDiskHeader followed by nEntries of
+   TileDiskEntry + dataLen bytes of deflated pixels. fileSize and
+   fileMtime identify the document version the tiles were rendered from;
+   a stale file is simply ignored (and overwritten). When only the mtime
+   changed (the file was re-downloaded or copied), the sampled content
+   fingerprint rescues the tiles. */
+struct TileDiskHeader {
+    u32 magic;
+    u32 version;
+    i64 fileSize;
+    FILETIME fileMtime;
+    u8 contentFingerprint[16];
+    i32 nEntries;
+};
+
+struct TileDiskEntry {
+    i32 pageNo;
+    i32 rotation;
+    float zoom;
+    u16 tileRes, tileRow, tileCol;
+    u16 reserved;
+    i32 dx, dy;
+    i64 dataLen;
+};
+
+// same (normalized) path fingerprint scheme as GetThumbnailPath in
+// FileThumbnails.cpp, with a different extension
+static WCHAR* GetTileCachePath(const WCHAR* filePath) {
+    u8 digest[16];
+    if (!filePath) {
+        return nullptr;
+    }
+    AutoFree pathU(strconv::WstrToUtf8(filePath));
+    if (!pathU.Get()) {
+        return nullptr;
+    }
+    if (path::HasVariableDriveLetter(filePath)) {
+        pathU.Get()[0] = '?'; // ignore the drive letter, if it might change
+    }
+    CalcMD5Digest((u8*)pathU.Get(), str::Len(pathU.Get()), digest);
+    AutoFree fingerPrint(_MemToHex(&digest));
+
+    AutoFreeWstr cachePath(AppGenDataFilename(TILE_CACHE_DIR_NAME));
+    if (!cachePath) {
+        return nullptr;
+    }
+    AutoFreeWstr fname(strconv::FromAnsi(fingerPrint));
+
+    return str::Format(L"%s\\%s.tdc", cachePath.Get(), fname.Get());
+}
+
+static i64 GetDocumentFileSize(const WCHAR* filePath) {
+    AutoFree pathA(strconv::WstrToUtf8(filePath));
+    if (!pathA.Get()) {
+        return -1;
+    }
+    return file::GetSize(std::string_view(pathA.Get()));
+}
+
+// a differing mtime alone doesn't make the cache stale: the sampled
+// content fingerprint (cheap even for huge files) tells a rewritten
+// timestamp from an actually changed document
+static bool IsDocumentUnchanged(const WCHAR* filePath, const TileDiskHeader* hdr) {
+    if (hdr->fileSize != GetDocumentFileSize(filePath)) {
+        return false;
+    }
+    FILETIME mtime = file::GetModificationTime(filePath);
+    if (FileTimeDiffInSecs(mtime, hdr->fileMtime) == 0) {
+        return true;
+    }
+    u8 fingerprint[16];
+    if (!CalcSampledFileFingerprint(filePath, fingerprint)) {
+        return false;
+    }
+    return memeq(fingerprint, hdr->contentFingerprint, sizeof(fingerprint));
+}
+
+/* Restore the compressed tiles a previous session wrote for the document.
+   The parsed entries are tagged with <dm> and appended to <entries> (the
+   caller owns them); returns false if there's no tile file for the
+   document or the document changed since it was written. */
+bool LoadTileDiskCache(const WCHAR* filePath, DisplayModel* dm, Vec<CompressedCacheEntry*>& entries) {
+    AutoFreeWstr tdcPath(GetTileCachePath(filePath));
+    if (!tdcPath) {
+        return false;
+    }
+    AutoFree data(file::ReadFile(tdcPath.Get()));
+    if (!data.data) {
+        return false;
+    }
+
+    const char* cur = data.data;
+    size_t left = data.size();
+    if (left < sizeof(TileDiskHeader)) {
+        return false;
+    }
+    TileDiskHeader hdr;
+    memcpy(&hdr, cur, sizeof(hdr));
+    cur += sizeof(hdr);
+    left -= sizeof(hdr);
+
+    if (hdr.magic != TILE_CACHE_MAGIC || hdr.version != TILE_CACHE_VERSION) {
+        return false;
+    }
+    if (!IsDocumentUnchanged(filePath, &hdr)) {
+        return false;
+    }
+
+    DWORD now = GetTickCount();
+    for (i32 i = 0; i < hdr.nEntries; i++) {
+        if (left < sizeof(TileDiskEntry)) {
+            return false;
+        }
+        TileDiskEntry te;
+        memcpy(&te, cur, sizeof(te));
+        cur += sizeof(te);
+        left -= sizeof(te);
+        if (te.dataLen <= 0 || left < (size_t)te.dataLen || te.dx <= 0 || te.dy <= 0) {
+            return false;
+        }
+
+        auto e = new CompressedCacheEntry();
+        e->dm = dm;
+        e->pageNo = te.pageNo;
+        e->rotation = te.rotation;
+        e->zoom = te.zoom;
+        e->tile = TilePosition(te.tileRes, te.tileRow, te.tileCol);
+        e->size = Size(te.dx, te.dy);
+        e->data = (u8*)memdup((void*)cur, (size_t)te.dataLen);
+        e->dataLen = te.dataLen;
+        e->lastUseTimestamp = now;
+        cur += (size_t)te.dataLen;
+        left -= (size_t)te.dataLen;
+
+        entries.Append(e);
+    }
+    return true;
+}
+
+// most recently used first, so that the file size cap drops the oldest tiles
+static int cmpTileLastUseDesc(const void* a, const void* b) {
+    const CompressedCacheEntry* ea = *(CompressedCacheEntry**)a;
+    const CompressedCacheEntry* eb = *(CompressedCacheEntry**)b;
+    if (ea->lastUseTimestamp == eb->lastUseTimestamp) {
+        return 0;
+    }
+    return ea->lastUseTimestamp > eb->lastUseTimestamp ? -1 : 1;
+}
+
+/* Serialize the compressed tiles of a closing document so that reopening
+   it scrolls from disk instead of re-rendering every page. The entries
+   stay owned by the caller. */
+bool SaveTileDiskCache(const WCHAR* filePath, Vec<CompressedCacheEntry*>& entries) {
+    AutoFreeWstr tdcPath(GetTileCachePath(filePath));
+    if (!tdcPath) {
+        return false;
+    }
+
+    Vec<CompressedCacheEntry*> sorted;
+    for (CompressedCacheEntry* e : entries) {
+        sorted.Append(e);
+    }
+    sorted.Sort(cmpTileLastUseDesc);
+
+    i64 totalBytes = 0;
+    i32 nEntries = 0;
+    for (CompressedCacheEntry* e : sorted) {
+        if (totalBytes + e->dataLen > TILE_CACHE_MAX_FILE_BYTES) {
+            break;
+        }
+        totalBytes += e->dataLen;
+        nEntries++;
+    }
+
+    TileDiskHeader hdr{};
+    hdr.magic = TILE_CACHE_MAGIC;
+    hdr.version = TILE_CACHE_VERSION;
+    hdr.fileSize = GetDocumentFileSize(filePath);
+    hdr.fileMtime = file::GetModificationTime(filePath);
+    CalcSampledFileFingerprint(filePath, hdr.contentFingerprint);
+    hdr.nEntries = nEntries;
+
+    str::Str d;
+    d.Append((const char*)&hdr, sizeof(hdr));
+
+    for (i32 i = 0; i < nEntries; i++) {
+        CompressedCacheEntry* e = sorted.at(i);
+        TileDiskEntry te{};
+        te.pageNo = e->pageNo;
+        te.rotation = e->rotation;
+        te.zoom = e->zoom;
+        te.tileRes = e->tile.res;
+        te.tileRow = e->tile.row;
+        te.tileCol = e->tile.col;
+        te.dx = e->size.dx;
+        te.dy = e->size.dy;
+        te.dataLen = e->dataLen;
+        d.Append((const char*)&te, sizeof(te));
+        d.Append((const char*)e->data, (size_t)e->dataLen);
+    }
+
+    AutoFreeWstr dirPath(path::GetDir(tdcPath));
+    if (!dir::Create(dirPath)) {
+        return false;
+    }
+    return file::WriteFile(tdcPath.Get(), d.AsSpan());
+}
@@ -0,0 +1,8 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+class DisplayModel;
+struct CompressedCacheEntry;
+
+bool LoadTileDiskCache(const WCHAR* filePath, DisplayModel* dm, Vec<CompressedCacheEntry*>& entries);
+bool SaveTileDiskCache(const WCHAR* filePath, Vec<CompressedCacheEntry*>& entries);
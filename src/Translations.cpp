@@ -2,6 +2,7 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "utils/BaseUtil.h"
+#include "utils/Dict.h"
 #include "utils/Log.h"
 #include "Translations.h"
 
@@ -31,8 +32,15 @@ static int gCurrLangIdx = 0;
 // hence foo[] => *foo here
 // const char *gCurrLangStrings[STRINGS_COUNT];
 const char** gCurrLangStrings = nullptr;
+// const char **gLangStrings[LANGS_COUNT]; each entry is built on first
+// use, so that switching back to a language is just a pointer swap
+static const char*** gLangStrings = nullptr;
 // WCHAR ** gLangsTransCache[LANGS_COUNT];
 WCHAR*** gLangsTransCache = nullptr;
+// maps each original (English) string to its index, so that a
+// GetTranslation() call doesn't compare its argument against every
+// known string
+static dict::MapStrToInt* gStringsIndex = nullptr;
 
 const char* GetTranslationsForLang(int langIdx);
 
@@ -111,43 +119,54 @@ static void FreeTransCache() {
             free(transCache[i]);
         }
         free(transCache);
+        free(gLangStrings[langIdx]);
     }
     free(gLangsTransCache);
-    free(gCurrLangStrings);
+    free(gLangStrings);
+    delete gStringsIndex;
+    gStringsIndex = nullptr;
 }
 
-static void BuildStringsIndexForLang(int langIdx) {
+static const char** GetStringsForLang(int langIdx) {
 #ifdef ADD_EN_RTL_TEST_LANGUAGE
-    if (0 == gCurrLangIdx || EN_RTL_IDX == gCurrLangIdx) {
-#else
-    if (0 == gCurrLangIdx) {
+    if (EN_RTL_IDX == langIdx) {
+        // the test language re-uses the original (English) strings
+        langIdx = 0;
+    }
 #endif
-        const char** origStrings = GetOriginalStrings();
-        for (int idx = 0; idx < gStringsCount; idx++) {
-            gCurrLangStrings[idx] = origStrings[idx];
-            CrashIf(!gCurrLangStrings[idx]);
-        }
-        return;
+    if (gLangStrings[langIdx]) {
+        return gLangStrings[langIdx];
     }
 
-    const char* s = GetTranslationsForLang(langIdx);
-    for (int i = 0; i < gStringsCount; i++) {
-        if (0 == *s) {
-            gCurrLangStrings[i] = nullptr;
-        } else {
-            gCurrLangStrings[i] = s;
+    const char** strings = AllocArray<const char*>(gStringsCount);
+    if (0 == langIdx) {
+        const char** origStrings = GetOriginalStrings();
+        for (int idx = 0; idx < gStringsCount; idx++) {
+            strings[idx] = origStrings[idx];
+            CrashIf(!strings[idx]);
         }
-        // advance to the next string
-        while (*s) {
+    } else {
+        const char* s = GetTranslationsForLang(langIdx);
+        for (int i = 0; i < gStringsCount; i++) {
+            if (0 == *s) {
+                strings[i] = nullptr;
+            } else {
+                strings[i] = s;
+            }
+            // advance to the next string
+            while (*s) {
+                ++s;
+            }
             ++s;
         }
-        ++s;
     }
+    gLangStrings[langIdx] = strings;
+    return strings;
 }
 
 void SetCurrentLangByCode(const char* langCode) {
-    if (!gCurrLangStrings) {
-        gCurrLangStrings = AllocArray<const char*>(gStringsCount);
+    if (!gLangStrings) {
+        gLangStrings = AllocArray<const char**>(gLangsCount);
         gLangsTransCache = AllocArray<WCHAR**>(gLangsCount);
     }
 
@@ -169,7 +188,7 @@ void SetCurrentLangByCode(const char* langCode) {
     CrashIf(-1 == idx);
     gCurrLangIdx = idx;
     gCurrLangCode = GetLangCodeByIdx(idx);
-    BuildStringsIndexForLang(gCurrLangIdx);
+    gCurrLangStrings = GetStringsForLang(gCurrLangIdx);
 }
 
 const char* ValidateLangCode(const char* langCode) {
@@ -232,13 +251,17 @@ const char* DetectUserLang() {
 }
 
 static int GetEnglishStringIndex(const char* txt) {
-    const char** origStrings = GetOriginalStrings();
-    for (int idx = 0; idx < gStringsCount; idx++) {
-        const char* s = origStrings[idx];
-        if (str::Eq(s, txt)) {
-            return idx;
+    if (!gStringsIndex) {
+        gStringsIndex = new dict::MapStrToInt((size_t)gStringsCount * 2);
+        const char** origStrings = GetOriginalStrings();
+        for (int idx = 0; idx < gStringsCount; idx++) {
+            gStringsIndex->Insert(origStrings[idx], idx);
         }
     }
+    int idx;
+    if (gStringsIndex->Get(txt, &idx)) {
+        return idx;
+    }
     return -1;
 }
 
@@ -6,6 +6,7 @@
 #include <UIAutomationCoreApi.h>
 #include "utils/ScopedWin.h"
 #include "utils/FileUtil.h"
+#include "utils/FrameTimeoutCalculator.h"
 #include "utils/WinUtil.h"
 
 #include "wingui/WinGui.h"
@@ -14,6 +15,7 @@
 #include "wingui/TreeModel.h"
 #include "wingui/TreeCtrl.h"
 #include "wingui/DropDownCtrl.h"
+#include "wingui/EditCtrl.h"
 #include "wingui/TooltipCtrl.h"
 #include "wingui/TabsCtrl.h"
 #include "wingui/LabelWithCloseWnd.h"
@@ -45,6 +47,7 @@
 #include "Caption.h"
 #include "Selection.h"
 #include "StressTesting.h"
+#include "SumatraAbout.h"
 #include "Translations.h"
 #include "uia/Provider.h"
 
@@ -92,6 +95,7 @@ WindowInfo::~WindowInfo() {
     }
 
     delete linkHandler;
+    DeleteStartPageBuffer(this);
     delete buffer;
     delete notifications;
     delete tabSelectionHistory;
@@ -105,6 +109,8 @@ WindowInfo::~WindowInfo() {
     delete frameRateWnd;
     delete infotip;
     delete altBookmarks;
+    delete tocFilterEdit;
+    delete tocFilteredTree;
     delete tocTreeCtrl;
     if (favTreeCtrl) {
         delete favTreeCtrl->treeModel;
@@ -113,12 +119,14 @@ WindowInfo::~WindowInfo() {
 
     delete sidebarSplitter;
     delete favSplitter;
+    delete thumbsSplitter;
     delete tocLabelWithClose;
     delete favLabelWithClose;
+    delete thumbsLabelWithClose;
+    delete scrollAnimFtc;
 }
 
 void ClearMouseState(WindowInfo* win) {
-    delete win->linkOnLastButtonDown;
     win->linkOnLastButtonDown = nullptr;
     delete win->annotationOnLastButtonDown;
     win->annotationOnLastButtonDown = nullptr;
@@ -604,6 +612,12 @@ void UpdateTreeCtrlColors(WindowInfo* win) {
         SetWindowPos(favTreeCtrl->hwnd, nullptr, 0, 0, 0, 0, flags);
     }
 
+    if (win->thumbsLabelWithClose) {
+        win->thumbsLabelWithClose->SetBgCol(labelBgCol);
+        win->thumbsLabelWithClose->SetTextCol(labelTxtCol);
+        win->thumbsSplitter->SetBackgroundColor(splitterCol);
+    }
+
     // TODO: more work needed to to ensure consistent look of the ebook window:
     // - tab bar should match the colort
     // - change the tree item text color
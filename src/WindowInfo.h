@@ -25,6 +25,10 @@ struct TabInfo;
 struct TreeCtrl;
 struct TooltipCtrl;
 struct DropDownCtrl;
+struct EditCtrl;
+struct TocTree;
+
+class FrameTimeoutCalculator;
 
 /* Describes actions which can be performed by mouse */
 // clang-format off
@@ -108,6 +112,11 @@ struct WindowInfo {
     // state related to table of contents (PDF bookmarks etc.)
     HWND hwndTocBox{nullptr};
     DropDownCtrl* altBookmarks{nullptr};
+    // filter-as-you-type box above the ToC tree
+    EditCtrl* tocFilterEdit{nullptr};
+    // flat tree of the matching items, shown instead of the full ToC
+    // while the filter box has text (see UpdateTocFilter)
+    TocTree* tocFilteredTree{nullptr};
 
     LabelWithCloseWnd* tocLabelWithClose{nullptr};
     TreeCtrl* tocTreeCtrl{nullptr};
@@ -126,12 +135,27 @@ struct WindowInfo {
     TreeCtrl* favTreeCtrl{nullptr};
     Vec<DisplayState*> expandedFavorites;
 
+    // state related to the page thumbnails panel (see PageThumbnails.cpp)
+    HWND hwndThumbsBox{nullptr};
+    LabelWithCloseWnd* thumbsLabelWithClose{nullptr};
+    // the virtualized thumbnail list inside hwndThumbsBox
+    HWND hwndThumbsList{nullptr};
+    // whether the thumbnails panel is currently visible
+    bool thumbsVisible{false};
+    // height of the thumbnails panel within the sidebar (0 for the default)
+    int thumbsDy{0};
+    // scroll position of the thumbnail list in pixels
+    int thumbsScrollY{0};
+
     // vertical splitter for resizing left side panel
     SplitterCtrl* sidebarSplitter{nullptr};
 
     // horizontal splitter for resizing favorites and bookmars parts
     SplitterCtrl* favSplitter{nullptr};
 
+    // horizontal splitter above the page thumbnails panel
+    SplitterCtrl* thumbsSplitter{nullptr};
+
     TabsCtrl2* tabsCtrl{nullptr};
     bool tabsVisible{false};
     bool tabsInTitlebar{false};
@@ -147,9 +171,22 @@ struct WindowInfo {
 
     HMENU menu{nullptr};
     bool isMenuHidden{false}; // not persisted at shutdown
+    // cache key of the last RebuildFileMenu() call; opening the File
+    // menu skips re-enumerating the file history and external viewers
+    // when neither the history nor the shown document has changed
+    int menuFileHistoryVer{0};
+    AutoFreeWstr menuFilePath;
 
     DoubleBuffer* buffer{nullptr};
 
+    /* state of the canvas buffer after the last document paint; lets a
+       scroll-only repaint shift the buffer's pixels instead of re-blitting
+       every visible tile (see DrawScrolledDocument) */
+    DoubleBuffer* lastPaintBuffer{nullptr};
+    DisplayModel* lastPaintDm{nullptr};
+    Point lastPaintScrollPos;
+    int lastPaintRepaintRev{-1};
+
     MouseAction mouseAction = MouseAction::Idle;
     bool dragRightClick{false}; // if true, drag was initiated with right mouse click
     bool dragStartPending{false};
@@ -189,6 +226,29 @@ struct WindowInfo {
 
     int wheelAccumDelta{0};
     UINT_PTR delayedRepaintTimer{0};
+    // dirty part of the canvas accumulated by RepaintAsync(win, delay, rect)
+    // until the repaint timer fires; only valid if !pendingRepaintAll
+    Rect pendingRepaintRect;
+    // a full repaint was requested; trumps pendingRepaintRect
+    bool pendingRepaintAll{false};
+
+    /* state of an in-flight animated zoom (see StartZoomAnimation in
+       Canvas.cpp). zoomAnimTarget is 0 while no animation is running;
+       zoomAnimDm is only ever compared, never dereferenced */
+    DisplayModel* zoomAnimDm{nullptr};
+    float zoomAnimStart{0};
+    float zoomAnimTarget{0};
+    DWORD zoomAnimStartTime{0};
+    Point zoomAnimFixPt;
+
+    /* state of an in-flight inertial wheel scroll (see StartInertialScroll
+       in Canvas.cpp). scrollAnimVelocity is 0 while no scroll is coasting;
+       scrollAnimDm is only ever compared, never dereferenced */
+    DisplayModel* scrollAnimDm{nullptr};
+    float scrollAnimVelocity{0}; // pixels per second, positive scrolls down
+    float scrollAnimError{0};    // sub-pixel remainder carried between frames
+    float scrollAnimDt{0};       // frame duration in seconds (longer on battery)
+    FrameTimeoutCalculator* scrollAnimFtc{nullptr};
 
     Notifications* notifications{nullptr}; // only access from UI thread
 
@@ -199,6 +259,8 @@ struct WindowInfo {
     bool findCanceled{false};
 
     LinkHandler* linkHandler{nullptr};
+    // owned by the engine, must be cleared (not deleted) before the
+    // engine goes away
     IPageElement* linkOnLastButtonDown{nullptr};
     const WCHAR* urlOnLastButtonDown{nullptr};
     Annotation* annotationOnLastButtonDown{nullptr};
@@ -264,6 +326,7 @@ struct LinkHandler {
 
 void UpdateTreeCtrlColors(WindowInfo*);
 void RepaintAsync(WindowInfo*, int delay);
+void RepaintAsync(WindowInfo*, int delay, Rect dirtyRect);
 void ClearFindBox(WindowInfo*);
 void CreateMovePatternLazy(WindowInfo*);
 void ClearMouseState(WindowInfo*);
@@ -26,6 +26,7 @@ VOID CEpubFilter::CleanUp() {
         m_epubDoc = nullptr;
     }
     m_state = STATE_EPUB_END;
+    m_spineIdx = 0;
 }
 
 HRESULT CEpubFilter::OnInit() {
@@ -47,12 +48,16 @@ HRESULT CEpubFilter::OnInit() {
         return E_FAIL;
     }
 
-    m_epubDoc = EpubDoc::CreateFromStream(stream);
+    // lazy-spine mode: chapters are extracted and stripped one at a
+    // time in GetNextChunkValue so that indexing a book only ever
+    // keeps a single decompressed chapter in memory
+    m_epubDoc = EpubDoc::CreateFromStream(stream, true);
     if (!m_epubDoc) {
         return E_FAIL;
     }
 
     m_state = STATE_EPUB_START;
+    m_spineIdx = 0;
     return S_OK;
 }
 
@@ -68,12 +73,11 @@ static bool IsoDateParse(const WCHAR* isoDate, SYSTEMTIME* timeOut) {
     // don't bother about the day of week, we won't display it anyway
 }
 
-static WCHAR* ExtractHtmlText(EpubDoc* doc) {
-    auto d = doc->GetHtmlData();
-    size_t len = d.size();
+static WCHAR* ExtractHtmlText(const char* html) {
+    size_t len = str::Len(html);
 
     str::Str text(len / 2);
-    HtmlPullParser p(d);
+    HtmlPullParser p(html, len);
     HtmlToken* t;
     Vec<HtmlTag> tagNesting;
     while ((t = p.Next()) != nullptr && !t->IsError()) {
@@ -166,12 +170,21 @@ HRESULT CEpubFilter::GetNextChunkValue(CChunkValue& chunkValue) {
             // fall through
 
         case STATE_EPUB_CONTENT:
-            m_state = STATE_EPUB_END;
-            str.Set(ExtractHtmlText(m_epubDoc));
-            if (!str::IsEmpty(str.Get())) {
-                chunkValue.SetTextValue(PKEY_Search_Contents, str, CHUNK_TEXT);
-                return S_OK;
+            // emit one chunk per spine item, so that chunks reach the
+            // indexer as soon as each chapter has been extracted and
+            // only one decompressed chapter is held in memory at a time
+            while (m_spineIdx < m_epubDoc->SpineCount()) {
+                AutoFree html(m_epubDoc->GetSpineItemHtml(m_spineIdx++));
+                if (!html.data) {
+                    continue;
+                }
+                str.Set(ExtractHtmlText(html.data));
+                if (!str::IsEmpty(str.Get())) {
+                    chunkValue.SetTextValue(PKEY_Search_Contents, str, CHUNK_TEXT);
+                    return S_OK;
+                }
             }
+            m_state = STATE_EPUB_END;
             // fall through
 
         case STATE_EPUB_END:
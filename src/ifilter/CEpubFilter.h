@@ -9,7 +9,7 @@ class CEpubFilter : public CFilterBase
 {
 public:
     CEpubFilter(long *plRefCount) : CFilterBase(plRefCount),
-        m_state(STATE_EPUB_END), m_epubDoc(nullptr) { }
+        m_state(STATE_EPUB_END), m_epubDoc(nullptr), m_spineIdx(0) { }
     ~CEpubFilter()  override { CleanUp(); }
 
     HRESULT OnInit() override;
@@ -25,4 +25,6 @@ public:
 private:
     EPUB_FILTER_STATE m_state;
     EpubDoc *m_epubDoc;
+    // next spine item to emit in STATE_EPUB_CONTENT
+    int m_spineIdx;
 };
@@ -3,6 +3,7 @@
 
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
+#include "utils/ThreadUtil.h"
 #include "utils/WinUtil.h"
 
 #include "wingui/TreeModel.h"
@@ -15,7 +16,109 @@
 #include "PdfFilter.h"
 #include "CPdfFilter.h"
 
+// how many extracted pages may pile up before the extraction thread
+// waits for the indexer to drain the queue
+#define MAX_QUEUED_PAGE_TEXTS 16
+
+/* Extracts page text on a worker thread, a bounded number of pages ahead
+   of the indexer's GetChunk calls, so that the filter streams text at
+   engine speed while GetChunk just pops finished text off a queue.
+   Sharing the engine with the property queries on the GetChunk thread is
+   fine, the engine serializes access internally. */
+class PdfExtractThread : public ThreadBase {
+    EngineBase* engine;
+
+    Mutex queueAccess;
+    // extracted page texts in page order (pages without text are skipped)
+    WStrVec queue;
+    bool allExtracted = false;
+    // signaled whenever the extraction thread added text or finished
+    HANDLE progressEvent;
+    // signaled whenever the indexer took text out of the queue
+    HANDLE drainEvent;
+
+  public:
+    explicit PdfExtractThread(EngineBase* engine) : ThreadBase("PdfExtractThread"), engine(engine) {
+        progressEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        drainEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    }
+
+    ~PdfExtractThread() override {
+        CloseHandle(progressEvent);
+        CloseHandle(drainEvent);
+    }
+
+    void Run() override {
+        int pageCount = engine->PageCount();
+        bool stop = false;
+        for (int pageNo = 1; pageNo <= pageCount && !stop; pageNo++) {
+            PageText pageText = engine->ExtractPageText(pageNo);
+            if (str::IsEmpty(pageText.text)) {
+                FreePageText(&pageText);
+                continue;
+            }
+            // Windows Search expects CRLF line endings
+            WCHAR* text = str::Replace(pageText.text, L"\n", L"\r\n");
+            FreePageText(&pageText);
+            for (;;) {
+                if (WasCancelRequested()) {
+                    str::Free(text);
+                    stop = true;
+                    break;
+                }
+                queueAccess.Lock();
+                bool hasRoom = queue.size() < MAX_QUEUED_PAGE_TEXTS;
+                if (hasRoom) {
+                    queue.Append(text);
+                }
+                queueAccess.Unlock();
+                if (hasRoom) {
+                    SetEvent(progressEvent);
+                    break;
+                }
+                WaitForSingleObject(drainEvent, INFINITE);
+            }
+        }
+        queueAccess.Lock();
+        allExtracted = true;
+        queueAccess.Unlock();
+        SetEvent(progressEvent);
+    }
+
+    // blocks until the text of the next non-empty page is available;
+    // returns nullptr once all pages have been handed out
+    // (caller frees the result)
+    WCHAR* NextPageText() {
+        for (;;) {
+            queueAccess.Lock();
+            WCHAR* text = queue.size() > 0 ? queue.PopAt(0) : nullptr;
+            bool done = allExtracted;
+            queueAccess.Unlock();
+            if (text) {
+                SetEvent(drainEvent);
+                return text;
+            }
+            if (done) {
+                return nullptr;
+            }
+            WaitForSingleObject(progressEvent, INFINITE);
+        }
+    }
+
+    void RequestStop() {
+        RequestCancel();
+        // wake the thread if it's waiting for the queue to drain
+        SetEvent(drainEvent);
+    }
+};
+
 VOID CPdfFilter::CleanUp() {
+    if (m_extractThread) {
+        m_extractThread->RequestStop();
+        m_extractThread->Join();
+        delete m_extractThread;
+        m_extractThread = nullptr;
+    }
     if (m_pdfEngine) {
         delete m_pdfEngine;
         m_pdfEngine = nullptr;
@@ -47,8 +150,11 @@ HRESULT CPdfFilter::OnInit() {
         return E_FAIL;
     }
 
+    // start extracting page text ahead of the GetChunk calls
+    m_extractThread = new PdfExtractThread(m_pdfEngine);
+    m_extractThread->Start();
+
     m_state = STATE_PDF_START;
-    m_iPageNo = 0;
     return S_OK;
 }
 
@@ -114,16 +220,9 @@ HRESULT CPdfFilter::GetNextChunkValue(CChunkValue& chunkValue) {
             // fall through
 
         case STATE_PDF_CONTENT:
-            while (++m_iPageNo <= m_pdfEngine->PageCount()) {
-                PageText pageText = m_pdfEngine->ExtractPageText(m_iPageNo);
-                if (str::IsEmpty(pageText.text)) {
-                    FreePageText(&pageText);
-                    continue;
-                }
-                str.Set(pageText.text);
-                AutoFreeWstr str2 = str::Replace(str.Get(), L"\n", L"\r\n");
-                chunkValue.SetTextValue(PKEY_Search_Contents, str2.Get(), CHUNK_TEXT);
-                FreePageText(&pageText);
+            str.Set(m_extractThread->NextPageText());
+            if (str) {
+                chunkValue.SetTextValue(PKEY_Search_Contents, str.Get(), CHUNK_TEXT);
                 return S_OK;
             }
             m_state = STATE_PDF_END;
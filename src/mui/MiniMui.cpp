@@ -4,6 +4,7 @@
 // as little of mui as necessary to make ../EngineDump.cpp compile
 
 #include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
 #include "MiniMui.h"
 #include "utils/WinUtil.h"
 
@@ -15,6 +16,8 @@ using Gdiplus::Brush;
 using Gdiplus::Color;
 using Gdiplus::Font;
 using Gdiplus::FontStyle;
+using Gdiplus::FontStyleBold;
+using Gdiplus::FontStyleItalic;
 using Gdiplus::FontStyleRegular;
 using Gdiplus::FontStyleUnderline;
 using Gdiplus::Graphics;
@@ -74,13 +77,24 @@ class CachedFontItem : public CachedFont {
     }
 };
 
-static CachedFontItem* gFontCache = nullptr;
+// the same process-wide, thread-safe cache as in MuiBase.cpp: items live
+// until Destroy and are atomically prepended once fully constructed, so
+// lookups don't need a lock even when engines render on worker threads
+static CachedFontItem* volatile gFontCache = nullptr;
+static CRITICAL_SECTION gFontCacheCs;
 
 CachedFont* GetCachedFont(const WCHAR* name, float size, FontStyle style) {
-    CachedFontItem** item = &gFontCache;
-    for (; *item; item = &(*item)->_next) {
-        if ((*item)->SameAs(name, size, style)) {
-            return *item;
+    for (CachedFontItem* item = gFontCache; item; item = item->_next) {
+        if (item->SameAs(name, size, style)) {
+            return item;
+        }
+    }
+
+    ScopedCritSec cs(&gFontCacheCs);
+    // re-check: another thread might have inserted the font meanwhile
+    for (CachedFontItem* item = gFontCache; item; item = item->_next) {
+        if (item->SameAs(name, size, style)) {
+            return item;
         }
     }
 
@@ -96,7 +110,18 @@ CachedFont* GetCachedFont(const WCHAR* name, float size, FontStyle style) {
         }
     }
 
-    return (*item = new CachedFontItem(name, size, style, font));
+    CachedFontItem* item = new CachedFontItem(name, size, style, font);
+    item->_next = gFontCache;
+    // publish only after the item is fully constructed (see gFontCache)
+    InterlockedExchangePointer((void* volatile*)&gFontCache, item);
+    return item;
+}
+
+void PrecreateFontVariants(const WCHAR* name, float sizePt) {
+    GetCachedFont(name, sizePt, FontStyleRegular);
+    GetCachedFont(name, sizePt, FontStyleBold);
+    GetCachedFont(name, sizePt, FontStyleItalic);
+    GetCachedFont(name, sizePt, (FontStyle)(FontStyleBold | FontStyleItalic));
 }
 
 // set consistent mode for our graphics objects so that we get
@@ -137,7 +162,9 @@ void FreeGraphicsForMeasureText([[maybe_unused]] Graphics* g) {
 static LONG gMiniMuiRefCount = 0;
 
 void Initialize() {
-    InterlockedIncrement(&gMiniMuiRefCount);
+    if (InterlockedIncrement(&gMiniMuiRefCount) == 1) {
+        InitializeCriticalSection(&gFontCacheCs);
+    }
 }
 
 void Destroy() {
@@ -145,6 +172,7 @@ void Destroy() {
         return;
     }
 
+    DeleteCriticalSection(&gFontCacheCs);
     delete gFontCache;
     gFontCache = nullptr;
     delete gGraphicsHack;
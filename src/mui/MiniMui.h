@@ -35,6 +35,7 @@ struct CachedFont {
 };
 
 CachedFont* GetCachedFont(const WCHAR* name, float sizePt, Gdiplus::FontStyle style);
+void PrecreateFontVariants(const WCHAR* name, float sizePt);
 
 void InitGraphicsMode(Gdiplus::Graphics* g);
 Gdiplus::Graphics* AllocGraphicsForMeasureText();
@@ -4,6 +4,12 @@
 struct FrameRateWnd;
 struct TxtNode;
 
+// for TextRenderDirectWrite; must be declared outside of the mui namespace
+struct ID2D1DCRenderTarget;
+struct ID2D1SolidColorBrush;
+struct IDWriteTextFormat;
+struct IDWriteTextLayout;
+
 namespace mui {
 
 // using namespace Gdiplus;
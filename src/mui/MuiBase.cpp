@@ -42,8 +42,12 @@ class FontListItem {
     FontListItem* next;
 };
 
-// Global, thread-safe font cache. Font objects live forever.
-static FontListItem* gFontsCache = nullptr;
+// Global, thread-safe font cache. Font objects live forever: DrawInstrs
+// and controls hold bare CachedFont pointers without any release point,
+// which is also what makes the lock-free lookup below safe. The list only
+// grows by atomically prepending fully constructed items, so readers
+// never see a partially initialized entry.
+static FontListItem* volatile gFontsCache = nullptr;
 
 // Graphics objects cannot be used across threads. We have a per-thread
 // cache so that it's easy to grab Graphics object to be used for
@@ -152,8 +156,18 @@ HFONT CachedFont::GetHFont() {
 // properties.
 // Caller should not delete the font - it's cached for performance and deleted at exit
 CachedFont* GetCachedFont(const WCHAR* name, float sizePt, FontStyle style) {
+    // lock-free fast path: ebook layout runs on one thread per tab and
+    // looks fonts up for every style change, so cache hits (the common
+    // case by far) must not serialize all those threads on the mui lock
+    for (FontListItem* item = gFontsCache; item; item = item->next) {
+        if (item->cf.SameAs(name, sizePt, style) && item->cf.font != nullptr) {
+            return &item->cf;
+        }
+    }
+
     ScopedMuiCritSec muiCs;
 
+    // re-check: another thread might have inserted the font meanwhile
     for (FontListItem* item = gFontsCache; item; item = item->next) {
         if (item->cf.SameAs(name, sizePt, style) && item->cf.font != nullptr) {
             return &item->cf;
@@ -175,10 +189,22 @@ CachedFont* GetCachedFont(const WCHAR* name, float sizePt, FontStyle style) {
     }
 
     FontListItem* item = new FontListItem(name, sizePt, style, font, nullptr);
-    ListInsert(&gFontsCache, item);
+    item->next = gFontsCache;
+    // publish only after the item is fully constructed (see gFontsCache)
+    InterlockedExchangePointer((void* volatile*)&gFontsCache, item);
     return &item->cf;
 }
 
+// precreates the style variants that ebook layout flips between all the
+// time, so that the first bold or italic run of a document doesn't pay
+// for GDI+ font creation in the middle of laying out a page
+void PrecreateFontVariants(const WCHAR* name, float sizePt) {
+    GetCachedFont(name, sizePt, FontStyleRegular);
+    GetCachedFont(name, sizePt, FontStyleBold);
+    GetCachedFont(name, sizePt, FontStyleItalic);
+    GetCachedFont(name, sizePt, (FontStyle)(FontStyleBold | FontStyleItalic));
+}
+
 Graphics* AllocGraphicsForMeasureText() {
     ScopedMuiCritSec muiCs;
 
@@ -42,6 +42,7 @@ struct CachedFont {
 
 void InitGraphicsMode(Graphics* g);
 CachedFont* GetCachedFont(const WCHAR* name, float sizePt, FontStyle style);
+void PrecreateFontVariants(const WCHAR* name, float sizePt);
 
 Graphics* AllocGraphicsForMeasureText();
 void FreeGraphicsForMeasureText(Graphics* gfx);
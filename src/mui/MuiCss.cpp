@@ -114,6 +114,9 @@ struct StyleCacheEntry {
 // their elements (we can't move the memory)
 static VecSegmented<Prop>* gAllProps = nullptr;
 static VecSegmented<StyleCacheEntry>* gStyleCache = nullptr;
+// resolving a null style yields gStyleDefault's values; there's no Style
+// object to remember that entry, so it gets a dedicated slot
+static StyleCacheEntry* gNullStyleCacheEntry = nullptr;
 
 void Initialize() {
     CrashIf(gAllProps);
@@ -178,6 +181,7 @@ void Destroy() {
         delete e->style;
     }
     delete gStyleCache;
+    gNullStyleCacheEntry = nullptr;
 }
 
 bool IsWidthProp(PropType type) {
@@ -604,16 +608,15 @@ CachedStyle* CacheStyle(Style* style, bool* changedOut) {
     *changedOut = false;
 
     ScopedMuiCritSec muiCs;
-    StyleCacheEntry* e = nullptr;
 
-    for (StyleCacheEntry* e2 : *gStyleCache) {
-        if (e2->style == style) {
-            if (e2->styleId == GetStyleId(style)) {
-                return &e2->cachedStyle;
-            }
-            e = e2;
-            break;
-        }
+    // each style remembers its own cache entry (gStyleCache is a
+    // VecSegmented, so the pointer stays valid), which makes re-resolving
+    // an unchanged style - the common case, e.g. buttons flipping between
+    // their default and mouse-over styles - a mere generation compare
+    // instead of a cache scan and a walk of the property vectors
+    StyleCacheEntry* e = style ? style->cacheEntry : gNullStyleCacheEntry;
+    if (e && e->styleId == GetStyleId(style)) {
+        return &e->cachedStyle;
     }
 
     *changedOut = true;
@@ -656,6 +659,11 @@ CachedStyle* CacheStyle(Style* style, bool* changedOut) {
 
     StyleCacheEntry newEntry = {style, GetStyleId(style), s};
     e = gStyleCache->Append(newEntry);
+    if (style) {
+        style->cacheEntry = e;
+    } else {
+        gNullStyleCacheEntry = e;
+    }
     return &e->cachedStyle;
 }
 
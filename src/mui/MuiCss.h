@@ -187,6 +187,8 @@ struct Prop {
     static Prop* AllocWidth(PropType type, float width);
 };
 
+struct StyleCacheEntry;
+
 class Style {
     // if property is not found here, we'll search the
     // inheritance chain
@@ -199,6 +201,10 @@ class Style {
         gen = 1; // so that we can use 0 for nullptr
     }
 
+    // the fully resolved properties of this style, memoized on first
+    // resolution; managed by CacheStyle(), don't touch
+    StyleCacheEntry* cacheEntry = nullptr;
+
     void SetName(const char* n);
 
     Vec<Prop*> props;
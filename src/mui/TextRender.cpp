@@ -2,6 +2,8 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "utils/BaseUtil.h"
+#include "utils/ScopedWin.h"
+#include "utils/WinDynCalls.h"
 #include "utils/WinUtil.h"
 #include "utils/GdiPlusUtil.h"
 #include "utils/HtmlParserLookup.h"
@@ -29,6 +31,47 @@ be in mui to avoid circular dependency */
 
 namespace mui {
 
+TextMeasureCache::~TextMeasureCache() {
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        free(entries[i].s);
+    }
+}
+
+bool TextMeasureCache::Get(CachedFont* font, const WCHAR* s, size_t sLen, RectF& bbOut) {
+    u32 hash = MurmurHash2(s, sLen * sizeof(WCHAR));
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        Entry& e = entries[i];
+        if (e.font != font || e.hash != hash || e.sLen != sLen) {
+            continue;
+        }
+        if (!str::EqN(e.s, s, sLen)) {
+            continue;
+        }
+        e.lastUsed = ++useCounter;
+        bbOut = e.bb;
+        return true;
+    }
+    return false;
+}
+
+void TextMeasureCache::Add(CachedFont* font, const WCHAR* s, size_t sLen, RectF bb) {
+    // replace the least recently used entry (or an unused one, whose
+    // lastUsed of 0 is older than anything ever touched)
+    Entry* evict = &entries[0];
+    for (int i = 1; i < MAX_ENTRIES; i++) {
+        if (entries[i].lastUsed < evict->lastUsed) {
+            evict = &entries[i];
+        }
+    }
+    free(evict->s);
+    evict->font = font;
+    evict->hash = MurmurHash2(s, sLen * sizeof(WCHAR));
+    evict->lastUsed = ++useCounter;
+    evict->s = str::DupN(s, sLen);
+    evict->sLen = sLen;
+    evict->bb = bb;
+}
+
 TextRenderGdi* TextRenderGdi::Create(Graphics* gfx) {
     TextRenderGdi* res = new TextRenderGdi();
     res->gfx = gfx;
@@ -111,9 +154,14 @@ float TextRenderGdi::GetCurrFontLineSpacing() {
 }
 
 RectF TextRenderGdi::Measure(const WCHAR* s, size_t sLen) {
+    RectF res;
+    if (measureCache.Get(currFont, s, sLen, res)) {
+        return res;
+    }
     SIZE txtSize;
     GetTextExtentPoint32W(hdcForTextMeasure, s, (int)sLen, &txtSize);
-    RectF res(0.0f, 0.0f, (float)txtSize.cx, (float)txtSize.cy);
+    res = RectF(0.0f, 0.0f, (float)txtSize.cx, (float)txtSize.cy);
+    measureCache.Add(currFont, s, sLen, res);
     return res;
 }
 
@@ -305,13 +353,19 @@ float TextRenderGdiplus::GetCurrFontLineSpacing() {
 
 RectF TextRenderGdiplus::Measure(const WCHAR* s, size_t sLen) {
     CrashIf(!currFont);
-    return MeasureText(gfx, currFont->font, s, sLen, measureAlgo);
+    RectF res;
+    if (measureCache.Get(currFont, s, sLen, res)) {
+        return res;
+    }
+    res = MeasureText(gfx, currFont->font, s, sLen, measureAlgo);
+    measureCache.Add(currFont, s, sLen, res);
+    return res;
 }
 
 RectF TextRenderGdiplus::Measure(const char* s, size_t sLen) {
     CrashIf(!currFont);
     size_t strLen = strconv::Utf8ToWcharBuf(s, sLen, txtConvBuf, dimof(txtConvBuf));
-    return MeasureText(gfx, currFont->font, txtConvBuf, strLen, measureAlgo);
+    return Measure(txtConvBuf, strLen);
 }
 
 TextRenderGdiplus::~TextRenderGdiplus() {
@@ -429,10 +483,15 @@ RectF TextRenderHdc::Measure(const char* s, size_t sLen) {
 }
 
 RectF TextRenderHdc::Measure(const WCHAR* s, size_t sLen) {
-    SIZE txtSize;
     CrashIf(!hdc);
+    RectF res;
+    if (measureCache.Get(currFont, s, sLen, res)) {
+        return res;
+    }
+    SIZE txtSize;
     GetTextExtentPoint32W(hdc, s, (int)sLen, &txtSize);
-    RectF res(0.0f, 0.0f, (float)txtSize.cx, (float)txtSize.cy);
+    res = RectF(0.0f, 0.0f, (float)txtSize.cx, (float)txtSize.cy);
+    measureCache.Add(currFont, s, sLen, res);
     return res;
 }
 
@@ -460,8 +519,306 @@ TextRenderHdc::~TextRenderHdc() {
     DeleteDC(hdc);
 }
 
+static ID2D1Factory* gD2DFactory = nullptr;
+static IDWriteFactory* gDWriteFactory = nullptr;
+static CRITICAL_SECTION gDirectWriteFactoriesLock;
+
+static struct DirectWriteFactoriesLockInit {
+    DirectWriteFactoriesLockInit() {
+        InitializeCriticalSection(&gDirectWriteFactoriesLock);
+    }
+} gDirectWriteFactoriesLockInit;
+
+// the d2d factory is created multi-threaded because ebook pages are also
+// laid out and rendered from background threads
+static bool CreateDirectWriteFactories() {
+    ScopedCritSec scope(&gDirectWriteFactoriesLock);
+    static bool triedToCreate = false;
+    if (triedToCreate) {
+        return gD2DFactory && gDWriteFactory;
+    }
+    triedToCreate = true;
+    // both dlls are loaded dynamically (see WinDynCalls.h) so that we keep
+    // running on systems that don't have them
+    if (!DynD2D1CreateFactory || !DynDWriteCreateFactory) {
+        return false;
+    }
+    D2D1_FACTORY_OPTIONS opts{};
+    HRESULT hr = DynD2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, __uuidof(ID2D1Factory), &opts,
+                                      (void**)&gD2DFactory);
+    if (FAILED(hr)) {
+        gD2DFactory = nullptr;
+        return false;
+    }
+    hr = DynDWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), (IUnknown**)&gDWriteFactory);
+    if (FAILED(hr)) {
+        gD2DFactory->Release();
+        gD2DFactory = nullptr;
+        gDWriteFactory = nullptr;
+        return false;
+    }
+    return true;
+}
+
+static D2D1_COLOR_F ToD2DColor(Gdiplus::Color col) {
+    D2D1_COLOR_F res;
+    res.r = (float)col.GetR() * (1.0f / 255.0f);
+    res.g = (float)col.GetG() * (1.0f / 255.0f);
+    res.b = (float)col.GetB() * (1.0f / 255.0f);
+    res.a = (float)col.GetA() * (1.0f / 255.0f);
+    return res;
+}
+
+TextRenderDirectWrite* TextRenderDirectWrite::Create(Graphics* gfx) {
+    if (!CreateDirectWriteFactories()) {
+        return nullptr;
+    }
+    TextRenderDirectWrite* res = new TextRenderDirectWrite();
+    res->gfx = gfx;
+    // default to red to make mistakes stand out
+    res->textColor = Color(0xff, 0xff, 0x0, 0x0);
+    if (!res->RecreateRenderTarget()) {
+        delete res;
+        return nullptr;
+    }
+    return res;
+}
+
+bool TextRenderDirectWrite::RecreateRenderTarget() {
+    if (brush) {
+        brush->Release();
+        brush = nullptr;
+    }
+    if (rt) {
+        rt->Release();
+        rt = nullptr;
+    }
+    D2D1_RENDER_TARGET_PROPERTIES props{};
+    props.type = D2D1_RENDER_TARGET_TYPE_DEFAULT;
+    props.pixelFormat.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    // we draw into opaque GDI surfaces
+    props.pixelFormat.alphaMode = D2D1_ALPHA_MODE_IGNORE;
+    HRESULT hr = gD2DFactory->CreateDCRenderTarget(&props, &rt);
+    if (FAILED(hr)) {
+        rt = nullptr;
+        return false;
+    }
+    D2D1_COLOR_F c = ToD2DColor(textColor);
+    hr = rt->CreateSolidColorBrush(&c, nullptr, &brush);
+    if (FAILED(hr)) {
+        brush = nullptr;
+        rt->Release();
+        rt = nullptr;
+        return false;
+    }
+    return true;
+}
+
+TextRenderDirectWrite::~TextRenderDirectWrite() {
+    CrashIf(hdcGfxLocked); // hasn't been Unlock()ed
+    for (int i = 0; i < MAX_CACHED_LAYOUTS; i++) {
+        free(layoutCache[i].s);
+        if (layoutCache[i].layout) {
+            layoutCache[i].layout->Release();
+        }
+    }
+    for (FontFormatEntry& e : textFormats) {
+        e.format->Release();
+    }
+    if (brush) {
+        brush->Release();
+    }
+    if (rt) {
+        rt->Release();
+    }
+}
+
+IDWriteTextFormat* TextRenderDirectWrite::GetTextFormat(CachedFont* font) {
+    for (FontFormatEntry& e : textFormats) {
+        if (e.font == font) {
+            return e.format;
+        }
+    }
+    DWRITE_FONT_WEIGHT weight = (font->style & FontStyleBold) ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL;
+    DWRITE_FONT_STYLE style = (font->style & FontStyleItalic) ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL;
+    // CachedFont sizes are in points, DirectWrite wants DIPs (1/96 inch)
+    float sizeDip = font->sizePt * 96.0f / 72.0f;
+    IDWriteTextFormat* format = nullptr;
+    HRESULT hr = gDWriteFactory->CreateTextFormat(font->name, nullptr, weight, style, DWRITE_FONT_STRETCH_NORMAL,
+                                                  sizeDip, L"", &format);
+    if (FAILED(hr)) {
+        return nullptr;
+    }
+    // strings come pre-broken into words, the layout must never wrap them
+    format->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP);
+    textFormats.Append(FontFormatEntry{font, format});
+    return format;
+}
+
+// a cache hit returns the already shaped glyph runs, so re-painting a page
+// only pays for rasterization. The returned layout is owned by the cache
+IDWriteTextLayout* TextRenderDirectWrite::GetCachedLayout(const WCHAR* s, size_t sLen) {
+    u32 hash = MurmurHash2(s, sLen * sizeof(WCHAR));
+    LayoutCacheEntry* evict = &layoutCache[0];
+    for (int i = 0; i < MAX_CACHED_LAYOUTS; i++) {
+        LayoutCacheEntry& e = layoutCache[i];
+        if (e.font == currFont && e.hash == hash && e.sLen == sLen && str::EqN(e.s, s, sLen)) {
+            e.lastUsed = ++layoutUseCounter;
+            return e.layout;
+        }
+        if (e.lastUsed < evict->lastUsed) {
+            evict = &e;
+        }
+    }
+    if (!currTextFormat) {
+        return nullptr;
+    }
+    IDWriteTextLayout* layout = nullptr;
+    // the size only matters for wrapping and alignment and we do neither
+    // (see GetTextFormat)
+    HRESULT hr = gDWriteFactory->CreateTextLayout(s, (UINT32)sLen, currTextFormat, 16384.0f, 16384.0f, &layout);
+    if (FAILED(hr)) {
+        return nullptr;
+    }
+    DWRITE_TEXT_RANGE all = {0, (UINT32)sLen};
+    if (currFont->style & FontStyleUnderline) {
+        layout->SetUnderline(TRUE, all);
+    }
+    if (currFont->style & FontStyleStrikeout) {
+        layout->SetStrikethrough(TRUE, all);
+    }
+    // replace the least recently used entry, same as TextMeasureCache
+    free(evict->s);
+    if (evict->layout) {
+        evict->layout->Release();
+    }
+    evict->font = currFont;
+    evict->hash = hash;
+    evict->lastUsed = ++layoutUseCounter;
+    evict->s = str::DupN(s, sLen);
+    evict->sLen = sLen;
+    evict->layout = layout;
+    return layout;
+}
+
+void TextRenderDirectWrite::SetFont(CachedFont* font) {
+    if (currFont == font) {
+        return;
+    }
+    currFont = font;
+    currTextFormat = GetTextFormat(font);
+}
+
+void TextRenderDirectWrite::SetTextColor(Gdiplus::Color col) {
+    if (textColor.GetValue() == col.GetValue()) {
+        return;
+    }
+    textColor = col;
+    D2D1_COLOR_F c = ToD2DColor(col);
+    brush->SetColor(&c);
+}
+
+float TextRenderDirectWrite::GetCurrFontLineSpacing() {
+    return currFont->font->GetHeight(gfx);
+}
+
+RectF TextRenderDirectWrite::Measure(const WCHAR* s, size_t sLen) {
+    CrashIf(!currFont);
+    RectF res;
+    if (measureCache.Get(currFont, s, sLen, res)) {
+        return res;
+    }
+    IDWriteTextLayout* layout = GetCachedLayout(s, sLen);
+    if (!layout) {
+        return res;
+    }
+    DWRITE_TEXT_METRICS tm{};
+    layout->GetMetrics(&tm);
+    res = RectF(0.0f, 0.0f, tm.widthIncludingTrailingWhitespace, tm.height);
+    measureCache.Add(currFont, s, sLen, res);
+    return res;
+}
+
+RectF TextRenderDirectWrite::Measure(const char* s, size_t sLen) {
+    size_t strLen = strconv::Utf8ToWcharBuf(s, sLen, txtConvBuf, dimof(txtConvBuf));
+    return Measure(txtConvBuf, strLen);
+}
+
+void TextRenderDirectWrite::Lock() {
+    CrashIf(hdcGfxLocked);
+    Region r;
+    Status st = gfx->GetClip(&r); // must call before GetHDC(), which locks gfx
+    CrashIf(st != Ok);
+    HRGN hrgn = r.GetHRGN(gfx);
+
+    hdcGfxLocked = gfx->GetHDC();
+    // EndDraw() copies to the dc with GDI, which respects the clip region
+    SelectClipRgn(hdcGfxLocked, hrgn);
+    DeleteObject(hrgn);
+
+    RECT rc{};
+    GetClipBox(hdcGfxLocked, &rc);
+    // bind from the dc origin so that Draw() coordinates stay in dc space
+    rc.left = 0;
+    rc.top = 0;
+    HRESULT hr = rt->BindDC(hdcGfxLocked, &rc);
+    CrashIf(FAILED(hr));
+    rt->BeginDraw();
+}
+
+void TextRenderDirectWrite::Unlock() {
+    CrashIf(!hdcGfxLocked);
+    HRESULT hr = rt->EndDraw();
+    gfx->ReleaseHDC(hdcGfxLocked);
+    hdcGfxLocked = nullptr;
+    if (D2DERR_RECREATE_TARGET == hr) {
+        // this paint is lost but the caller repaints soon enough and the
+        // fresh target picks it up
+        RecreateRenderTarget();
+    }
+}
+
+void TextRenderDirectWrite::Draw(const WCHAR* s, size_t sLen, const RectF bb, bool isRtl) {
+    CrashIf(!hdcGfxLocked); // hasn't been Lock()ed
+    D2D1_POINT_2F pos{bb.x, bb.y};
+    if (!isRtl) {
+        IDWriteTextLayout* layout = GetCachedLayout(s, sLen);
+        if (layout) {
+            rt->DrawTextLayout(pos, layout, brush, D2D1_DRAW_TEXT_OPTIONS_NONE);
+        }
+        return;
+    }
+    // reading direction is a layout-wide property, so rtl runs get a
+    // transient layout aligned to the right edge of bb instead of a second
+    // cached variant of the same string
+    if (!currTextFormat) {
+        return;
+    }
+    IDWriteTextLayout* layout = nullptr;
+    HRESULT hr = gDWriteFactory->CreateTextLayout(s, (UINT32)sLen, currTextFormat, bb.dx, bb.dy, &layout);
+    if (FAILED(hr)) {
+        return;
+    }
+    layout->SetReadingDirection(DWRITE_READING_DIRECTION_RIGHT_TO_LEFT);
+    rt->DrawTextLayout(pos, layout, brush, D2D1_DRAW_TEXT_OPTIONS_NONE);
+    layout->Release();
+}
+
+void TextRenderDirectWrite::Draw(const char* s, size_t sLen, const RectF bb, bool isRtl) {
+    size_t strLen = strconv::Utf8ToWcharBuf(s, sLen, txtConvBuf, dimof(txtConvBuf));
+    Draw(txtConvBuf, strLen, bb, isRtl);
+}
+
 ITextRender* CreateTextRender(TextRenderMethod method, Graphics* gfx, int dx, int dy) {
     ITextRender* res = nullptr;
+    if (TextRenderMethodDirectWrite == method) {
+        res = TextRenderDirectWrite::Create(gfx);
+        if (!res) {
+            // DirectWrite/Direct2D aren't available; GDI is the closest
+            // match in speed and rendering style
+            method = TextRenderMethodGdi;
+        }
+    }
     if (TextRenderMethodGdiplus == method) {
         res = TextRenderGdiplus::Create(gfx);
     }
@@ -6,8 +6,35 @@ enum TextRenderMethod {
     TextRenderMethodGdiplusQuick, // uses MeasureTextQuick
     TextRenderMethodGdi,
     TextRenderMethodHdc,
-    // TODO: implement TextRenderDirectDraw
-    // TextRenderDirectDraw
+    // DirectWrite rasterization through a Direct2D render target bound to
+    // the Graphics HDC; CreateTextRender() falls back to Gdi when
+    // d2d1.dll/dwrite.dll can't be loaded
+    TextRenderMethodDirectWrite,
+};
+
+/* Measuring text through GDI/GDI+ is expensive and ebook pages measure the
+same short strings (words, mostly) over and over, both during layout and
+when re-painting while scrolling. This caches the bounding box per
+(font, string) with LRU eviction; ~256 entries of short strings keep the
+memory cost at a few KB per text renderer */
+class TextMeasureCache {
+    enum { MAX_ENTRIES = 256 };
+    struct Entry {
+        CachedFont* font;
+        u32 hash;
+        // for LRU eviction; taken from useCounter on each hit
+        u32 lastUsed;
+        WCHAR* s;
+        size_t sLen;
+        RectF bb;
+    };
+    Entry entries[MAX_ENTRIES]{};
+    u32 useCounter = 0;
+
+  public:
+    bool Get(CachedFont* font, const WCHAR* s, size_t sLen, RectF& bbOut);
+    void Add(CachedFont* font, const WCHAR* s, size_t sLen, RectF bb);
+    ~TextMeasureCache();
 };
 
 class ITextRender {
@@ -51,6 +78,7 @@ class TextRenderGdi : public ITextRender {
     Gdiplus::Color textColor;
     Gdiplus::Color textBgColor;
     WCHAR txtConvBuf[512] = {0};
+    TextMeasureCache measureCache;
 
     HDC memHdc = nullptr;
     HGDIOBJ memHdcPrevFont = nullptr;
@@ -104,6 +132,7 @@ class TextRenderGdiplus : public ITextRender {
     Gdiplus::Color textColor{};
     Gdiplus::Brush* textColorBrush = nullptr;
     WCHAR txtConvBuf[512]{};
+    TextMeasureCache measureCache;
 
     TextRenderGdiplus() = default;
 
@@ -146,6 +175,7 @@ class TextRenderHdc : public ITextRender {
     Gdiplus::Color textColor{};
     Gdiplus::Color textBgColor{};
     WCHAR txtConvBuf[512]{};
+    TextMeasureCache measureCache;
 
     TextRenderHdc() = default;
 
@@ -170,6 +200,74 @@ class TextRenderHdc : public ITextRender {
     ~TextRenderHdc() override;
 };
 
+/* Renders text with DirectWrite through a Direct2D render target that gets
+bound to the Graphics HDC between Lock()/Unlock(). Shaped text
+(IDWriteTextLayout, i.e. the glyph runs) is cached per (font, string), so
+re-painting a page skips the expensive analysis/shaping pass and only
+rasterizes, which DirectWrite does noticeably faster than GDI+.
+Create() returns nullptr when d2d1.dll/dwrite.dll can't be loaded. */
+class TextRenderDirectWrite : public ITextRender {
+    enum { MAX_CACHED_LAYOUTS = 256 };
+    struct LayoutCacheEntry {
+        CachedFont* font;
+        u32 hash;
+        // for LRU eviction; taken from layoutUseCounter on each hit
+        u32 lastUsed;
+        WCHAR* s;
+        size_t sLen;
+        IDWriteTextLayout* layout;
+    };
+    struct FontFormatEntry {
+        CachedFont* font;
+        IDWriteTextFormat* format;
+    };
+
+    ID2D1DCRenderTarget* rt = nullptr;
+    ID2D1SolidColorBrush* brush = nullptr;
+    HDC hdcGfxLocked = nullptr;
+
+    // We don't own gfx and currFont
+    Gdiplus::Graphics* gfx = nullptr;
+    CachedFont* currFont = nullptr;
+    // owned by textFormats
+    IDWriteTextFormat* currTextFormat = nullptr;
+    Gdiplus::Color textColor{};
+    WCHAR txtConvBuf[512]{};
+    TextMeasureCache measureCache;
+
+    LayoutCacheEntry layoutCache[MAX_CACHED_LAYOUTS]{};
+    u32 layoutUseCounter = 0;
+    Vec<FontFormatEntry> textFormats;
+
+    TextRenderDirectWrite() = default;
+
+    IDWriteTextFormat* GetTextFormat(CachedFont* font);
+    IDWriteTextLayout* GetCachedLayout(const WCHAR* s, size_t sLen);
+    bool RecreateRenderTarget();
+
+  public:
+    static TextRenderDirectWrite* Create(Gdiplus::Graphics* gfx);
+
+    void SetFont(CachedFont* font) override;
+    void SetTextColor(Gdiplus::Color col) override;
+    // Draw() composes over whatever is under the text, same as GDI+
+    void SetTextBgColor([[maybe_unused]] Gdiplus::Color col) override {
+    }
+
+    float GetCurrFontLineSpacing() override;
+
+    RectF Measure(const char* s, size_t sLen) override;
+    RectF Measure(const WCHAR* s, size_t sLen) override;
+
+    void Lock() override;
+    void Unlock() override;
+
+    void Draw(const char* s, size_t sLen, const RectF bb, bool isRtl) override;
+    void Draw(const WCHAR* s, size_t sLen, const RectF bb, bool isRtl) override;
+
+    ~TextRenderDirectWrite() override;
+};
+
 ITextRender* CreateTextRender(TextRenderMethod method, Graphics* gfx, int dx, int dy);
 
 size_t StringLenForWidth(ITextRender* textRender, const WCHAR* s, size_t len, float dx);
@@ -3,6 +3,10 @@
 
 #include "utils/BaseUtil.h"
 #include "utils/ScopedWin.h"
+#include "utils/CryptoUtil.h"
+#include "utils/FileUtil.h"
+#include "utils/GdiPlusUtil.h"
+#include "utils/ThreadUtil.h"
 #include "utils/WinUtil.h"
 #include "utils/LogDbg.h"
 
@@ -10,22 +14,231 @@
 
 #include "Annotation.h"
 #include "EngineBase.h"
+#include "DisplayMode.h"
+#include "SettingsStructs.h"
+#include "FileHistory.h"
 #include "EnginePdf.h"
 #include "EngineXps.h"
 #include "mui/MiniMui.h"
 #include "EngineEbook.h"
 #include "EngineImages.h"
+#include "FileThumbnails.h"
+#include "SumatraConfig.h"
 #include "PdfPreview.h"
 #include "PdfPreviewBase.h"
 
+/* Explorer asks for the same previews over and over while the user hovers
+   through a folder, so keep a small LRU of recently rendered previews.
+   The cache is keyed by file identity (path or stream name plus last
+   modification time) and lives for as long as the hosting process does. */
+
+#define MAX_CACHED_PREVIEWS 8
+
+struct CachedPreview {
+    WCHAR* fileId = nullptr; // empty slot if nullptr
+    FILETIME modTime = {0};
+    uint cx = 0;
+    HBITMAP hbmp = nullptr;
+    DWORD lastUsed = 0;
+};
+
+static CachedPreview gPreviewCache[MAX_CACHED_PREVIEWS];
+static DWORD gPreviewCacheCounter = 0;
+static Mutex gPreviewCacheLock;
+
+// returns a copy owned by the caller
+static HBITMAP GetCachedPreview(const WCHAR* fileId, FILETIME modTime, uint cx) {
+    ScopedCritSec scope(&gPreviewCacheLock.cs);
+    for (CachedPreview& e : gPreviewCache) {
+        if (!e.fileId || e.cx != cx || !str::EqI(e.fileId, fileId)) {
+            continue;
+        }
+        if (0 != FileTimeDiffInSecs(e.modTime, modTime)) {
+            // the file has changed, drop the stale preview
+            str::Free(e.fileId);
+            e.fileId = nullptr;
+            DeleteObject(e.hbmp);
+            e.hbmp = nullptr;
+            return nullptr;
+        }
+        e.lastUsed = ++gPreviewCacheCounter;
+        return (HBITMAP)CopyImage(e.hbmp, IMAGE_BITMAP, 0, 0, 0);
+    }
+    return nullptr;
+}
+
+// keeps a copy of hbmp, evicting the least recently used preview
+static void CachePreview(const WCHAR* fileId, FILETIME modTime, uint cx, HBITMAP hbmp) {
+    HBITMAP copy = (HBITMAP)CopyImage(hbmp, IMAGE_BITMAP, 0, 0, 0);
+    if (!copy) {
+        return;
+    }
+    ScopedCritSec scope(&gPreviewCacheLock.cs);
+    CachedPreview* slot = nullptr;
+    for (CachedPreview& e : gPreviewCache) {
+        if (e.fileId && e.cx == cx && str::EqI(e.fileId, fileId)) {
+            slot = &e;
+            break;
+        }
+    }
+    if (!slot) {
+        slot = &gPreviewCache[0];
+        for (CachedPreview& e : gPreviewCache) {
+            if (!e.fileId) {
+                slot = &e;
+                break;
+            }
+            if (e.lastUsed < slot->lastUsed) {
+                slot = &e;
+            }
+        }
+    }
+    str::Free(slot->fileId);
+    if (slot->hbmp) {
+        DeleteObject(slot->hbmp);
+    }
+    slot->fileId = str::Dup(fileId);
+    slot->modTime = modTime;
+    slot->cx = cx;
+    slot->hbmp = copy;
+    slot->lastUsed = ++gPreviewCacheCounter;
+}
+
+void CleanupPreviewCache() {
+    ScopedCritSec scope(&gPreviewCacheLock.cs);
+    for (CachedPreview& e : gPreviewCache) {
+        str::Free(e.fileId);
+        e.fileId = nullptr;
+        if (e.hbmp) {
+            DeleteObject(e.hbmp);
+            e.hbmp = nullptr;
+        }
+    }
+}
+
+// the thumbnail pack written by SumatraPDF (see src/FileThumbnails.cpp);
+// best effort: for portable installs the pack lives next to the binary
+// and won't be found here
+static WCHAR* GetThumbnailPackPath() {
+    AutoFreeWstr dir(GetSpecialFolder(CSIDL_LOCAL_APPDATA, false));
+    if (!dir) {
+        return nullptr;
+    }
+    return str::Format(L"%s\\%s\\%s\\%s", dir.Get(), GetAppName(), THUMBNAILS_DIR_NAME, THUMBNAIL_PACK_FILE_NAME);
+}
+
+// must stay in sync with GetDocumentCacheKey in src/FileThumbnails.cpp
+// (which the preview DLL can't link without most of the main app)
+static bool GetPackedThumbnailKey(const WCHAR* filePath, u8 key[16]) {
+    AutoFree pathU(strconv::WstrToUtf8(filePath));
+    if (!pathU.Get()) {
+        return false;
+    }
+    if (path::HasVariableDriveLetter(filePath)) {
+        pathU.Get()[0] = '?'; // ignore the drive letter, if it might change
+    }
+    CalcMD5Digest((u8*)pathU.Get(), str::Len(pathU.Get()), key);
+    return true;
+}
+
+// reuses the thumbnail SumatraPDF has rendered for this document, if it's
+// still current and not smaller than the requested size
+static HBITMAP LoadPackedThumbnail(const WCHAR* filePath, FILETIME modTime, uint cx) {
+    u8 key[16];
+    if (!GetPackedThumbnailKey(filePath, key)) {
+        return nullptr;
+    }
+    AutoFreeWstr path(GetThumbnailPackPath());
+    if (!path) {
+        return nullptr;
+    }
+    AutoFree data(file::ReadFile(path.Get()));
+    size_t len = data.size();
+    if (len < sizeof(ThumbnailPackHeader)) {
+        return nullptr;
+    }
+    ThumbnailPackHeader* hdr = (ThumbnailPackHeader*)data.Get();
+    if (hdr->magic != THUMBNAIL_PACK_MAGIC || hdr->version != THUMBNAIL_PACK_VERSION) {
+        return nullptr;
+    }
+    i32 nEntries = hdr->nEntries;
+    size_t dataOff = sizeof(ThumbnailPackHeader) + (size_t)nEntries * sizeof(ThumbnailPackEntry);
+    if (nEntries < 0 || dataOff > len) {
+        return nullptr;
+    }
+    ThumbnailPackEntry* entries = (ThumbnailPackEntry*)(data.Get() + sizeof(ThumbnailPackHeader));
+    for (i32 i = 0; i < nEntries; i++) {
+        ThumbnailPackEntry& e = entries[i];
+        if (!memeq(e.key, key, sizeof(key))) {
+            continue;
+        }
+        if ((size_t)e.offset + e.size > len - dataOff) {
+            return nullptr;
+        }
+        if (FileTimeDiffInSecs(modTime, e.createdAt) > 0) {
+            // the document is newer than the thumbnail
+            return nullptr;
+        }
+        Gdiplus::Bitmap* bmp = BitmapFromData({(u8*)data.Get() + dataOff + e.offset, e.size});
+        if (!bmp) {
+            return nullptr;
+        }
+        HBITMAP hbmp = nullptr;
+        bool bigEnough = (uint)bmp->GetWidth() >= cx || (uint)bmp->GetHeight() >= cx;
+        if (bigEnough && bmp->GetHBITMAP((Gdiplus::ARGB)Gdiplus::Color::White, &hbmp) != Gdiplus::Ok) {
+            hbmp = nullptr;
+        }
+        delete bmp;
+        return hbmp;
+    }
+    return nullptr;
+}
+
+// the file's path if known (only on the IPersistFile code path), otherwise
+// whatever name the host gave the stream - good enough as a cache key
+static WCHAR* GetFileIdentity(const WCHAR* filePath, IStream* stream, FILETIME* modTimeOut) {
+    if (filePath) {
+        return str::Dup(filePath);
+    }
+    if (!stream) {
+        return nullptr;
+    }
+    STATSTG stg{};
+    if (FAILED(stream->Stat(&stg, STATFLAG_DEFAULT)) || !stg.pwcsName) {
+        return nullptr;
+    }
+    WCHAR* name = str::Dup(stg.pwcsName);
+    CoTaskMemFree(stg.pwcsName);
+    *modTimeOut = stg.mtime;
+    return name;
+}
+
 IFACEMETHODIMP PreviewBase::GetThumbnail(uint cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha) {
+    dbglogf("PdfPreview: PreviewBase::GetThumbnail(cx=%d)\n", (int)cx);
+
+    FILETIME modTime = m_dateStamp;
+    AutoFreeWstr fileId(GetFileIdentity(m_filePath, m_pStream, &modTime));
+    if (fileId) {
+        HBITMAP cached = GetCachedPreview(fileId, modTime, cx);
+        // the pack only stores thumbnails by full path
+        if (!cached && path::IsAbsolute(fileId)) {
+            cached = LoadPackedThumbnail(fileId, modTime, cx);
+        }
+        if (cached) {
+            dbglog("PdfPreview: PreviewBase::GetThumbnail() served from cache\n");
+            *phbmp = cached;
+            if (pdwAlpha) {
+                *pdwAlpha = WTSAT_RGB;
+            }
+            return S_OK;
+        }
+    }
+
     EngineBase* engine = GetEngine();
     if (!engine) {
         return E_FAIL;
     }
 
-    dbglogf("PdfPreview: PreviewBase::GetThumbnail(cx=%d)\n", (int)cx);
-
     RectF page = engine->Transform(engine->PageMediabox(1), 1, 1.0, 0);
     float zoom = std::min(cx / (float)page.dx, cx / (float)page.dy) - 0.001f;
     Rect thumb = RectF(0, 0, page.dx * zoom, page.dy * zoom).Round();
@@ -67,6 +280,10 @@ IFACEMETHODIMP PreviewBase::GetThumbnail(uint cx, HBITMAP* phbmp, WTS_ALPHATYPE*
     ReleaseDC(nullptr, hdc);
     delete bmp;
 
+    if (hthumb && fileId) {
+        CachePreview(fileId, modTime, cx, hthumb);
+    }
+
     return hthumb ? S_OK : E_NOTIMPL;
 }
 
@@ -82,6 +299,9 @@ class PageRenderer {
     RenderedBitmap* currBmp;
     // due to rounding differences, currBmp->Size() and currSize can differ slightly
     Size currSize;
+    // currBmp is a low-resolution first pass that is yet to be
+    // replaced by a full-quality render (see RenderThread)
+    bool currIsPreview;
     int reqPage;
     float reqZoom;
     Size reqSize;
@@ -104,6 +324,7 @@ class PageRenderer {
           hwnd(hwnd),
           currPage(0),
           currBmp(nullptr),
+          currIsPreview(false),
           reqPage(0),
           reqZoom(0),
           reqAbort(false),
@@ -113,6 +334,9 @@ class PageRenderer {
         InitializeCriticalSection(&currAccess);
     }
     ~PageRenderer() {
+        // don't wait out a render nobody will see (the user has
+        // already arrow-keyed on to another file)
+        Abort();
         if (thread) {
             WaitForSingleObject(thread, INFINITE);
         }
@@ -120,6 +344,15 @@ class PageRenderer {
         DeleteCriticalSection(&currAccess);
     }
 
+    // aborts the in-flight render; called when the preview is unloaded
+    void Abort() {
+        ScopedCritSec scope(&currAccess);
+        reqAbort = true;
+        if (abortCookie) {
+            abortCookie->Abort();
+        }
+    }
+
     RectF GetPageRect(int pageNo) {
         if (preventRecursion) {
             return RectF();
@@ -137,9 +370,16 @@ class PageRenderer {
         dbglog("PdfPreview: PageRenderer::Render()\n");
 
         ScopedCritSec scope(&currAccess);
-        if (currBmp && currPage == pageNo && currSize == target.Size()) {
+        bool haveCurr = currBmp && currPage == pageNo && currSize == target.Size();
+        if (haveCurr) {
             currBmp->StretchDIBits(hdc, target);
-        } else if (!thread) {
+            if (!currIsPreview) {
+                return;
+            }
+            // the low-resolution pass is on screen; if no render is in
+            // flight anymore (e.g. the full pass was aborted), request it
+        }
+        if (!thread) {
             reqPage = pageNo;
             reqZoom = zoom;
             reqSize = target.Size();
@@ -154,26 +394,43 @@ class PageRenderer {
     }
 
   protected:
+    // renders the requested page at the given zoom and publishes the
+    // result; the abort cookie only lives for the duration of one pass
+    void RenderPass(float zoom, bool isPreview) {
+        RenderPageArgs args(reqPage, zoom, 0, nullptr, RenderTarget::View, &abortCookie);
+        RenderedBitmap* bmp = engine->RenderPage(args);
+
+        ScopedCritSec scope(&currAccess);
+        if (!reqAbort) {
+            delete currBmp;
+            currBmp = bmp;
+            currPage = reqPage;
+            currSize = reqSize;
+            currIsPreview = isPreview;
+            PostMessageW(hwnd, UWM_PAINT_AGAIN, 0, 0);
+        } else {
+            delete bmp;
+        }
+        delete abortCookie;
+        abortCookie = nullptr;
+    }
+
     static DWORD WINAPI RenderThread(LPVOID data) {
         ScopedCom comScope; // because the engine reads data from a COM IStream
 
         PageRenderer* pr = (PageRenderer*)data;
-        RenderPageArgs args(pr->reqPage, pr->reqZoom, 0, nullptr, RenderTarget::View, &pr->abortCookie);
-        RenderedBitmap* bmp = pr->engine->RenderPage(args);
-
-        ScopedCritSec scope(&pr->currAccess);
-
+        // for larger targets render a quarter-resolution pass first;
+        // StretchDIBits in Render scales it to the target rect, so when
+        // rapidly arrow-keying through a folder each page shows up
+        // immediately while the full-quality render is still underway
+        if (pr->reqSize.dx > 400 || pr->reqSize.dy > 400) {
+            pr->RenderPass(pr->reqZoom / 4, true);
+        }
         if (!pr->reqAbort) {
-            delete pr->currBmp;
-            pr->currBmp = bmp;
-            pr->currPage = pr->reqPage;
-            pr->currSize = pr->reqSize;
-        } else {
-            delete bmp;
+            pr->RenderPass(pr->reqZoom, false);
         }
-        delete pr->abortCookie;
-        pr->abortCookie = nullptr;
 
+        ScopedCritSec scope(&pr->currAccess);
         HANDLE th = pr->thread;
         pr->thread = nullptr;
         PostMessageW(pr->hwnd, UWM_PAINT_AGAIN, 0, 0);
@@ -171,6 +171,8 @@ class PreviewBase : public IThumbnailProvider,
         strconv::StackWstrToUtf8 fileName = pszFileName;
         dbglogf("PdfPreview: PreviewBase::Load('%s')\n", fileName.Get());
 
+        m_filePath.SetCopy(pszFileName);
+
         HANDLE hFile = CreateFile(pszFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
                                   FILE_ATTRIBUTE_NORMAL, nullptr);
         if (hFile == INVALID_HANDLE_VALUE) {
@@ -267,6 +269,8 @@ class PreviewBase : public IThumbnailProvider,
     const WCHAR* m_clsid{nullptr};
     uint m_extractCx{0};
     FILETIME m_dateStamp{0};
+    // only set on the IPersistFile code path (see GetFileIdentity)
+    AutoFreeWstr m_filePath;
 
     virtual EngineBase* LoadEngine(IStream* stream) = 0;
 };
@@ -345,3 +349,6 @@ class CTgaPreview : public PreviewBase {
   protected:
     EngineBase* LoadEngine(IStream* stream) override;
 };
+
+// frees the previews cached across PreviewBase instances (see PdfPreview.cpp)
+void CleanupPreviewCache();
@@ -164,6 +164,8 @@ static const char* GetReason(DWORD dwReason) {
 STDAPI_(BOOL) DllMain(HINSTANCE hInstance, DWORD dwReason, [[maybe_unused]] LPVOID lpReserved) {
     if (dwReason == DLL_PROCESS_ATTACH) {
         CrashIf(hInstance != GetInstance());
+    } else if (dwReason == DLL_PROCESS_DETACH) {
+        CleanupPreviewCache();
     }
     dbglogf("PdfPreview: DllMain %s\n", GetReason(dwReason));
     return TRUE;
@@ -16,6 +16,7 @@ To write new regression test:
 */
 
 #include "utils/BaseUtil.h"
+#include <intrin.h> // SSE2 intrinsics
 #include "utils/ScopedWin.h"
 #include "utils/WinDynCalls.h"
 #include "utils/Archive.h"
@@ -42,6 +43,8 @@ To write new regression test:
 #include "ProgressUpdateUI.h"
 #include "TextSelection.h"
 #include "TextSearch.h"
+// For Regress04 (Visual-diff rendering)
+#include "utils/Timer.h"
 
 static const WCHAR* gTestFilesDir;
 
@@ -167,12 +170,14 @@ static void UninstallCrashHandler() {
 
 #include "Regress00.cpp"
 #include "Regress03.cpp"
+#include "Regress04.cpp"
 
 static void RunTests() {
     Regress00();
     Regress01();
     Regress02();
     Regress03();
+    Regress04();
 }
 
 int RegressMain() {
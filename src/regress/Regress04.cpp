@@ -0,0 +1,175 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+// must be #included from Regress.cpp
+
+/* Visual-diff rendering regression harness.
+
+   Renders every document in ${TestFilesDir}\render-corpus at a few fixed
+   zoom levels through its engine and compares the resulting bitmaps
+   against baselines stored in render-corpus\baselines. A missing
+   baseline is created from the current render (so the first run over a
+   new corpus records the reference), subsequent runs fail when a page
+   differs perceptually from its baseline.
+
+   Bitmaps rarely stay bit-identical across e.g. font rasterizer or
+   rounding changes, so an exact compare (fast path) is followed by a
+   perceptual one: a pixel channel may drift by up to
+   PERCEPTUAL_CHANNEL_TOLERANCE and up to MAX_DIFF_CHANNEL_PERMILLE out
+   of 1000 channels may drift further before a page counts as changed.
+
+   Per-page render times are stored next to the baselines; the harness
+   reports the delta against the baseline time for every page so that a
+   rendering-pipeline change can be checked for speed regressions in the
+   same run, but only pixel differences fail the test. */
+
+#define RENDER_CORPUS_DIR L"render-corpus"
+#define RENDER_BASELINE_DIR L"baselines"
+
+// per-channel drift that's considered visually equal (anti-aliasing,
+// color rounding)
+#define PERCEPTUAL_CHANNEL_TOLERANCE 8
+// how many out of 1000 channels may drift beyond the tolerance
+#define MAX_DIFF_CHANNEL_PERMILLE 2
+
+static const float gRegressRenderZooms[] = {0.5f, 1.0f, 2.0f};
+
+// counts bytes whose values differ by more than tolerance, 16 at a time
+// (the byte streams are the BGR channels of the two bitmaps)
+static i64 CountBytesOverTolerance(const u8* a, const u8* b, size_t n, u8 tolerance) {
+    i64 count = 0;
+    size_t i = 0;
+    __m128i vtol = _mm_set1_epi8((char)tolerance);
+    __m128i vone = _mm_set1_epi8(1);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        // absolute difference of unsigned bytes
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        // within tolerance saturates to zero
+        __m128i over = _mm_subs_epu8(diff, vtol);
+        // 0x01 for every byte over tolerance, summed up sideways
+        __m128i ones = _mm_andnot_si128(_mm_cmpeq_epi8(over, zero), vone);
+        __m128i sums = _mm_sad_epu8(ones, zero);
+        count += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+    }
+    for (; i < n; i++) {
+        int d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (d > tolerance) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// both spans are .bmp file data as produced by SerializeBitmap; the
+// pixel payload starts at bfOffBits
+static bool GetBmpPixels(std::span<u8> bmp, const u8** pixelsOut, size_t* nOut) {
+    if (bmp.size() < sizeof(BITMAPFILEHEADER)) {
+        return false;
+    }
+    BITMAPFILEHEADER* bmpfh = (BITMAPFILEHEADER*)bmp.data();
+    if (bmpfh->bfType != MAKEWORD('B', 'M') || bmpfh->bfOffBits > bmp.size()) {
+        return false;
+    }
+    *pixelsOut = bmp.data() + bmpfh->bfOffBits;
+    *nOut = bmp.size() - bmpfh->bfOffBits;
+    return true;
+}
+
+// baseline path for page pageNo of filePath at zoom, e.g.
+// "...\render-corpus\baselines\file.pdf-z200-p003.bmp"
+static WCHAR* RenderBaselinePath(const WCHAR* filePath, float zoom, int pageNo, const WCHAR* ext) {
+    AutoFreeWstr dir = path::GetDir(filePath);
+    AutoFreeWstr baseDir = path::Join(dir, RENDER_BASELINE_DIR);
+    dir::CreateAll(baseDir);
+    const WCHAR* name = path::GetBaseNameNoFree(filePath);
+    AutoFreeWstr entry = str::Format(L"%s-z%03d-p%03d%s", name, (int)(zoom * 100.f), pageNo, ext);
+    return path::Join(baseDir, entry);
+}
+
+static void RegressRenderPage(EngineBase* engine, const WCHAR* filePath, float zoom, int pageNo) {
+    RenderPageArgs args(pageNo, zoom, 0);
+    auto timeStart = TimeGet();
+    RenderedBitmap* bmp = engine->RenderPage(args);
+    double renderMs = TimeSinceInMs(timeStart);
+    if (!bmp) {
+        wprintf(L"Failed to render %s page %d at zoom %.2f\n", filePath, pageNo, zoom);
+        CrashAlwaysIf(true);
+    }
+    AutoFree rendered(SerializeBitmap(bmp->GetBitmap()));
+    delete bmp;
+    CrashAlwaysIf(rendered.empty());
+
+    AutoFreeWstr bmpPath = RenderBaselinePath(filePath, zoom, pageNo, L".bmp");
+    AutoFreeWstr msPath = RenderBaselinePath(filePath, zoom, pageNo, L".ms");
+
+    AutoFree baseline(file::ReadFile(bmpPath.Get()));
+    if (baseline.empty()) {
+        // no baseline yet, this render becomes it
+        bool ok = file::WriteFile(bmpPath.Get(), rendered.AsSpan());
+        CrashAlwaysIf(!ok);
+        AutoFree ms(str::Format("%d", (int)renderMs));
+        file::WriteFile(msPath.Get(), ms.AsSpan());
+        wprintf(L"Baseline created for %s page %d at zoom %.2f\n", filePath, pageNo, zoom);
+        return;
+    }
+
+    // render-time delta is informational only; timings are too noisy to
+    // fail the test on
+    AutoFree msData(file::ReadFile(msPath.Get()));
+    if (!msData.empty()) {
+        int baselineMs = atoi(msData.Get());
+        wprintf(L"%s page %d zoom %.2f: %d ms, baseline %d ms (%+d ms)\n", filePath, pageNo, zoom, (int)renderMs,
+                baselineMs, (int)renderMs - baselineMs);
+    }
+
+    if (baseline.size() == rendered.size() && memeq(baseline.Get(), rendered.Get(), rendered.size())) {
+        return;
+    }
+
+    const u8* basePixels;
+    const u8* currPixels;
+    size_t baseN, currN;
+    bool ok = GetBmpPixels(baseline.AsSpan(), &basePixels, &baseN) && GetBmpPixels(rendered.AsSpan(), &currPixels, &currN);
+    if (!ok || baseN != currN) {
+        wprintf(L"Bitmap dimensions of %s page %d at zoom %.2f differ from the baseline\n", filePath, pageNo, zoom);
+        CrashAlwaysIf(true);
+    }
+
+    i64 nOver = CountBytesOverTolerance(basePixels, currPixels, currN, PERCEPTUAL_CHANNEL_TOLERANCE);
+    i64 permille = nOver * 1000 / (i64)currN;
+    if (permille > MAX_DIFF_CHANNEL_PERMILLE) {
+        wprintf(L"%s page %d at zoom %.2f differs from the baseline: %d of 1000 channels beyond tolerance\n",
+                filePath, pageNo, zoom, (int)permille);
+        CrashAlwaysIf(true);
+    }
+}
+
+static void RegressRenderFile(const WCHAR* filePath) {
+    EngineBase* engine = CreateEngine(filePath, nullptr);
+    if (!engine) {
+        // not a renderable document (e.g. a stray text file in the corpus)
+        return;
+    }
+    int nPages = engine->PageCount();
+    for (size_t i = 0; i < dimof(gRegressRenderZooms); i++) {
+        for (int pageNo = 1; pageNo <= nPages; pageNo++) {
+            RegressRenderPage(engine, filePath, gRegressRenderZooms[i], pageNo);
+        }
+    }
+    delete engine;
+}
+
+static void Regress04() {
+    AutoFreeWstr corpusDir = path::Join(TestFilesDir(), RENDER_CORPUS_DIR);
+    if (!dir::Exists(corpusDir)) {
+        wprintf(L"Skipping render regression, no corpus at %s\n", corpusDir.Get());
+        return;
+    }
+    DirIter di(corpusDir, false);
+    for (const WCHAR* path = di.First(); path; path = di.Next()) {
+        RegressRenderFile(path);
+    }
+}
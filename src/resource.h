@@ -64,8 +64,10 @@
 #define IDC_PRINT_SCALE_FIT             1062
 #define IDC_PRINT_SCALE_NONE            1063
 #define IDC_SECTION_PRINT_COMPATIBILITY 1070
+#define IDC_PRINT_PREVIEW               1080
 #define IDC_TOC_LABEL_WITH_CLOSE        1101
 #define IDC_FAV_LABEL_WITH_CLOSE        1106
+#define IDC_THUMBS_LABEL_WITH_CLOSE     1107
 #define IDC_TABBAR                      1110
 #define IDB_RELOADING_CUE               2010
 
@@ -28,6 +28,7 @@ extern void SimpleLogTest();
 extern void SquareTreeTest();
 extern void StrFormatTest();
 extern void StrTest();
+extern void ThreadUtilTest();
 extern void TrivialHtmlParser_UnitTests();
 // extern void VarintGobTest();
 extern void VecTest();
@@ -51,6 +52,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     SimpleLogTest();
     SquareTreeTest();
     StrTest();
+    ThreadUtilTest();
     TrivialHtmlParser_UnitTests();
     // VarintGobTest();
     VecTest();
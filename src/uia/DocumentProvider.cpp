@@ -22,6 +22,7 @@
 #include "uia/PageProvider.h"
 #include "uia/Provider.h"
 #include "uia/TextRange.h"
+#include "TextSelection.h"
 
 SumatraUIAutomationDocumentProvider::SumatraUIAutomationDocumentProvider(HWND canvasHwnd,
                                                                          SumatraUIAutomationProvider* root)
@@ -31,7 +32,9 @@ SumatraUIAutomationDocumentProvider::SumatraUIAutomationDocumentProvider(HWND ca
       released(true),
       child_first(nullptr),
       child_last(nullptr),
-      dm(nullptr) {
+      dm(nullptr),
+      pageTexts(nullptr),
+      pageCount(0) {
     // root->AddRef(); Don't add refs to our parent & owner.
 }
 
@@ -60,6 +63,9 @@ void SumatraUIAutomationDocumentProvider::LoadDocument(DisplayModel* newDm) {
     }
     child_last = prevPage;
 
+    pageCount = newDm->PageCount();
+    pageTexts = AllocArray<UiaPageText>(pageCount);
+
     dm = newDm;
     released = false;
 }
@@ -73,6 +79,15 @@ void SumatraUIAutomationDocumentProvider::FreeDocument() {
     released = true;
     dm = nullptr;
 
+    // the joined text and glyph maps are ours to free
+    for (int i = 0; i < pageCount; i++) {
+        free(pageTexts[i].text);
+        free(pageTexts[i].glyphToChar);
+    }
+    free(pageTexts);
+    pageTexts = nullptr;
+    pageCount = 0;
+
     SumatraUIAutomationPageProvider* it = child_first;
     while (it) {
         SumatraUIAutomationPageProvider* current = it;
@@ -108,6 +123,112 @@ SumatraUIAutomationPageProvider* SumatraUIAutomationDocumentProvider::GetLastPag
     return child_last;
 }
 
+const WCHAR* SumatraUIAutomationDocumentProvider::GetPageText(int pageNum, int* lenOut) {
+    CrashIf(!IsDocumentLoaded());
+    CrashIf(pageNum < 1 || pageNum > pageCount);
+
+    // always go through the cache: it evicts pages under memory pressure,
+    // so a pointer kept here could go stale; fetching a cached page is
+    // just a critical section round-trip
+    return dm->textCache->GetTextForPage(pageNum, lenOut);
+}
+
+int SumatraUIAutomationDocumentProvider::GetPageGlyphCount(int pageNum) {
+    int len;
+    GetPageText(pageNum, &len);
+    return len;
+}
+
+int SumatraUIAutomationDocumentProvider::GetPageCount() const {
+    CrashIf(!IsDocumentLoaded());
+    return pageCount;
+}
+
+// builds (on first use) the ITextProvider view of a page's text: the
+// lines joined with "\r\n" plus a map from glyph index to character
+// offset in the joined string. Mirrors what FillResultRects does for
+// TextSelection::ExtractText, including dropping lines that lie
+// completely outside the page's mediabox
+SumatraUIAutomationDocumentProvider::UiaPageText* SumatraUIAutomationDocumentProvider::GetUiaPageText(int pageNum) {
+    CrashIf(!IsDocumentLoaded());
+    CrashIf(pageNum < 1 || pageNum > pageCount);
+
+    UiaPageText* cached = &pageTexts[pageNum - 1];
+    if (cached->glyphToChar) {
+        return cached;
+    }
+
+    int len;
+    Rect* coords;
+    const WCHAR* text = dm->textCache->GetTextForPage(pageNum, &len, &coords);
+    Rect mediabox = dm->GetEngine()->PageMediabox(pageNum).Round();
+
+    str::WStr buf(len);
+    int* glyphToChar = AllocArray<int>(len + 1);
+
+    int i = 0;
+    while (i < len) {
+        // line break glyphs have no extent and separate lines; they map
+        // to the end of the preceding line, just before the "\r\n"
+        for (; i < len && !coords[i].x && !coords[i].dx; i++) {
+            glyphToChar[i] = (int)buf.size();
+        }
+
+        int first = i;
+        Rect bbox;
+        for (; i < len && (coords[i].x || coords[i].dx); i++) {
+            bbox = bbox.Union(coords[i]);
+        }
+        // skip lines that are completely outside the page's mediabox
+        if (bbox.Intersect(mediabox).IsEmpty()) {
+            for (int j = first; j < i; j++) {
+                glyphToChar[j] = (int)buf.size();
+            }
+            continue;
+        }
+
+        if (buf.size() > 0) {
+            buf.Append(L"\r\n");
+        }
+        for (int j = first; j < i; j++) {
+            glyphToChar[j] = (int)buf.size();
+            buf.AppendChar(text[j]);
+        }
+    }
+    glyphToChar[len] = (int)buf.size();
+
+    cached->glyphCount = len;
+    cached->textLen = (int)buf.size();
+    cached->text = buf.StealData();
+    cached->glyphToChar = glyphToChar;
+    return cached;
+}
+
+WCHAR* SumatraUIAutomationDocumentProvider::ExtractRangeText(int fromPage, int fromGlyph, int toPage, int toGlyph) {
+    CrashIf(!IsDocumentLoaded());
+
+    str::WStr result;
+    for (int page = fromPage; page <= toPage; page++) {
+        UiaPageText* pt = GetUiaPageText(page);
+        int from = (page == fromPage) ? pt->glyphToChar[limitValue(fromGlyph, 0, pt->glyphCount)] : 0;
+        int to = (page == toPage) ? pt->glyphToChar[limitValue(toGlyph, 0, pt->glyphCount)] : pt->textLen;
+        // an endpoint on a line break glyph maps to just before the
+        // "\r\n" separator; a range only contains the separators between
+        // the lines it covers
+        while (from < to && (pt->text[from] == '\r' || pt->text[from] == '\n')) {
+            from++;
+        }
+        if (from >= to) {
+            continue;
+        }
+        if (result.size() > 0) {
+            result.Append(L"\r\n");
+        }
+        result.Append(pt->text + from, (size_t)(to - from));
+    }
+    return result.StealData();
+}
+
 HRESULT STDMETHODCALLTYPE SumatraUIAutomationDocumentProvider::QueryInterface(REFIID riid, void** ppv) {
     static const QITAB qit[] = {QITABENT(SumatraUIAutomationDocumentProvider, IRawElementProviderSimple),
                                 QITABENT(SumatraUIAutomationDocumentProvider, IRawElementProviderFragment),
@@ -20,6 +20,25 @@ class SumatraUIAutomationDocumentProvider : public IRawElementProviderFragment,
 
     DisplayModel* dm;
 
+    // lazily built per-page view of the document's text for the text
+    // ranges handed out to UIA clients. Screen readers issue hundreds of
+    // ITextRangeProvider calls while the user scrolls and rebuilding the
+    // same answers from the glyph coordinate arrays on every call is
+    // measurably slow (the raw extraction itself is already cached by
+    // DocumentTextCache). Freed in FreeDocument.
+    // raw page text pointers are deliberately not kept here: they point
+    // into dm->textCache, which may evict (and later re-extract) a page
+    struct UiaPageText {
+        int glyphCount;   // the page's glyph count
+        WCHAR* text;      // lines joined with "\r\n" (see ExtractRangeText)
+        int textLen;
+        int* glyphToChar; // glyphCount+1 monotonic offsets into text
+    };
+    UiaPageText* pageTexts;
+    int pageCount;
+
+    UiaPageText* GetUiaPageText(int pageNum);
+
   public:
     SumatraUIAutomationDocumentProvider(HWND canvasHwnd, SumatraUIAutomationProvider* root);
     ~SumatraUIAutomationDocumentProvider();
@@ -35,6 +54,16 @@ class SumatraUIAutomationDocumentProvider : public IRawElementProviderFragment,
     SumatraUIAutomationPageProvider* GetFirstPage();
     SumatraUIAutomationPageProvider* GetLastPage();
 
+    // cached accessors for SumatraUIAutomationTextRange; all of them
+    // require IsDocumentLoaded()
+    const WCHAR* GetPageText(int pageNum, int* lenOut);
+    int GetPageGlyphCount(int pageNum);
+    int GetPageCount() const;
+    // text of a glyph range in ITextProvider format (lines joined with
+    // "\r\n"), equivalent to TextSelection::ExtractText for the same
+    // range; caller frees
+    WCHAR* ExtractRangeText(int fromPage, int fromGlyph, int toPage, int toGlyph);
+
     // IUnknown
     HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
     ULONG STDMETHODCALLTYPE AddRef();
@@ -95,15 +95,13 @@ int SumatraUIAutomationTextRange::GetPageGlyphCount(int pageNum) {
     CrashIf(!document->IsDocumentLoaded());
     CrashIf(pageNum <= 0);
 
-    int pageLen;
-    document->GetDM()->textCache->GetTextForPage(pageNum, &pageLen);
-    return pageLen;
+    return document->GetPageGlyphCount(pageNum);
 }
 
 int SumatraUIAutomationTextRange::GetPageCount() {
     CrashIf(!document->IsDocumentLoaded());
 
-    return document->GetDM()->PageCount();
+    return document->GetPageCount();
 }
 
 void SumatraUIAutomationTextRange::ValidateStartEndpoint() {
@@ -125,8 +123,7 @@ void SumatraUIAutomationTextRange::ValidateEndEndpoint() {
 int SumatraUIAutomationTextRange::FindPreviousWordEndpoint(int pageno, int idx, bool dontReturnInitial) {
     // based on TextSelection::SelectWordAt
     int textLen;
-    auto cache = document->GetDM()->textCache;
-    const WCHAR* pageText = cache->GetTextForPage(pageno, &textLen);
+    const WCHAR* pageText = document->GetPageText(pageno, &textLen);
 
     if (dontReturnInitial) {
         for (; idx > 0; idx--) {
@@ -146,8 +143,7 @@ int SumatraUIAutomationTextRange::FindPreviousWordEndpoint(int pageno, int idx,
 
 int SumatraUIAutomationTextRange::FindNextWordEndpoint(int pageno, int idx, bool dontReturnInitial) {
     int textLen;
-    auto cache = document->GetDM()->textCache;
-    const WCHAR* pageText = cache->GetTextForPage(pageno, &textLen);
+    const WCHAR* pageText = document->GetPageText(pageno, &textLen);
 
     if (dontReturnInitial) {
         for (; idx < textLen; idx++) {
@@ -167,8 +163,7 @@ int SumatraUIAutomationTextRange::FindNextWordEndpoint(int pageno, int idx, bool
 
 int SumatraUIAutomationTextRange::FindPreviousLineEndpoint(int pageno, int idx, bool dontReturnInitial) {
     int textLen;
-    auto cache = document->GetDM()->textCache;
-    const WCHAR* pageText = cache->GetTextForPage(pageno, &textLen);
+    const WCHAR* pageText = document->GetPageText(pageno, &textLen);
 
     if (dontReturnInitial) {
         for (; idx > 0; idx--) {
@@ -188,8 +183,7 @@ int SumatraUIAutomationTextRange::FindPreviousLineEndpoint(int pageno, int idx,
 
 int SumatraUIAutomationTextRange::FindNextLineEndpoint(int pageno, int idx, bool dontReturnInitial) {
     int textLen;
-    auto cache = document->GetDM()->textCache;
-    const WCHAR* pageText = cache->GetTextForPage(pageno, &textLen);
+    const WCHAR* pageText = document->GetPageText(pageno, &textLen);
 
     if (dontReturnInitial) {
         for (; idx < textLen; idx++) {
@@ -454,11 +448,15 @@ HRESULT STDMETHODCALLTYPE SumatraUIAutomationTextRange::GetText(int maxLength, B
         return S_OK;
     }
 
-    TextSelection selection(document->GetDM()->GetEngine(), document->GetDM()->textCache);
-    selection.StartAt(startPage, startGlyph);
-    selection.SelectUpTo(endPage, endGlyph);
+    // normalize the endpoint order like TextSelection::GetGlyphRange does
+    int fromPage = startPage, fromGlyph = startGlyph;
+    int toPage = endPage, toGlyph = endGlyph;
+    if (fromPage > toPage || (fromPage == toPage && fromGlyph > toGlyph)) {
+        std::swap(fromPage, toPage);
+        std::swap(fromGlyph, toGlyph);
+    }
 
-    AutoFreeWstr selected_text(selection.ExtractText(L"\r\n"));
+    AutoFreeWstr selected_text(document->ExtractRangeText(fromPage, fromGlyph, toPage, toGlyph));
     size_t selected_text_length = str::Len(selected_text);
 
     // -1 and [0, inf) are allowed
@@ -18,6 +18,13 @@ extern "C" {
 // 3 is for absolute worst case of WCHAR* where last char was partially written
 #define ZERO_PADDING_COUNT 3
 
+// total bytes of decoded entries kept around for re-use; enough for a
+// handful of comic book pages, small next to the rendered page cache
+#define ENTRY_CACHE_MAX_BYTES (16 * 1024 * 1024)
+
+// defined next to the other unrar.dll glue at the end of this file
+static void CloseUnrarHandle(void* hArc);
+
 #if OS_WIN
 FILETIME MultiFormatArchive::FileInfo::GetWinFileTime() const {
     FILETIME ft = {(DWORD)-1, (DWORD)-1};
@@ -71,6 +78,10 @@ bool MultiFormatArchive::Open(ar_stream* data, const char* archivePath) {
 }
 
 MultiFormatArchive::~MultiFormatArchive() {
+    for (auto& entry : entryCache_) {
+        free(entry.data);
+    }
+    CloseUnrarHandle(unrarHandle_);
     ar_close_archive(ar_);
     ar_close(data_);
 }
@@ -104,14 +115,66 @@ std::span<u8> MultiFormatArchive::GetFileDataByName(const char* fileName) {
     return GetFileDataById(fileId);
 }
 
+// returns a copy of a cached entry's data or an empty span on a miss
+std::span<u8> MultiFormatArchive::GetFromEntryCache(size_t fileId) {
+    for (size_t i = 0; i < entryCache_.size(); i++) {
+        CachedEntry entry = entryCache_.at(i);
+        if (entry.fileId != fileId) {
+            continue;
+        }
+        // move to the end, eviction is oldest-first
+        entryCache_.RemoveAt(i);
+        entryCache_.Append(entry);
+        u8* data = AllocArray<u8>(entry.size + ZERO_PADDING_COUNT);
+        if (!data) {
+            return {};
+        }
+        memcpy(data, entry.data, entry.size);
+        return {data, entry.size};
+    }
+    return {};
+}
+
+void MultiFormatArchive::AddToEntryCache(size_t fileId, const u8* data, size_t size) {
+    if (format != Format::Rar && format != Format::SevenZip) {
+        // only rar and 7z archives can be solid; decoding a zip or tar
+        // entry again is cheap, don't spend memory on those
+        return;
+    }
+    if (0 == size || size > ENTRY_CACHE_MAX_BYTES) {
+        return;
+    }
+    while (entryCacheBytes_ + size > ENTRY_CACHE_MAX_BYTES && entryCache_.size() > 0) {
+        CachedEntry entry = entryCache_.at(0);
+        entryCache_.RemoveAt(0);
+        entryCacheBytes_ -= entry.size;
+        free(entry.data);
+    }
+    u8* copy = (u8*)Allocator::MemDup(nullptr, data, size);
+    if (!copy) {
+        return;
+    }
+    entryCache_.Append({fileId, size, copy});
+    entryCacheBytes_ += size;
+}
+
 std::span<u8> MultiFormatArchive::GetFileDataById(size_t fileId) {
     if (fileId == (size_t)-1) {
         return {};
     }
     CrashIf(fileId >= fileInfos_.size());
 
+    std::span<u8> res = GetFromEntryCache(fileId);
+    if (!res.empty()) {
+        return res;
+    }
+
     if (LoadedUsingUnrarDll()) {
-        return GetFileDataByIdUnarrDll(fileId);
+        res = GetFileDataByIdUnarrDll(fileId);
+        if (!res.empty()) {
+            AddToEntryCache(fileId, res.data(), res.size());
+        }
+        return res;
     }
 
     if (!ar_) {
@@ -137,6 +200,7 @@ std::span<u8> MultiFormatArchive::GetFileDataById(size_t fileId) {
         return {};
     }
 
+    AddToEntryCache(fileId, data, size);
     return {data, size};
 }
 
@@ -289,50 +353,61 @@ static int CALLBACK unrarCallback(UINT msg, LPARAM userData, LPARAM rarBuffer, L
     return 1;
 }
 
-static bool FindFile(HANDLE hArc, RARHeaderDataEx* rarHeader, const WCHAR* fileName) {
-    int res;
-    for (;;) {
-        res = RARReadHeaderEx(hArc, rarHeader);
-        if (0 != res) {
-            return false;
-        }
-        str::TransChars(rarHeader->FileNameW, L"\\", L"/");
-        if (str::EqI(rarHeader->FileNameW, fileName)) {
-            // don't support files whose uncompressed size is greater than 4GB
-            return rarHeader->UnpSizeHigh == 0;
-        }
-        RARProcessFile(hArc, RAR_SKIP, nullptr, nullptr);
+static void CloseUnrarHandle(void* hArc) {
+    if (hArc) {
+        RARCloseArchive(hArc);
     }
 }
 
 std::span<u8> MultiFormatArchive::GetFileDataByIdUnarrDll(size_t fileId) {
     CrashIf(!rarFilePath_);
 
-    AutoFreeWstr rarPath = strconv::Utf8ToWstr(rarFilePath_);
-
-    str::Slice uncompressedBuf;
-
-    RAROpenArchiveDataEx arcData = {0};
-    arcData.ArcNameW = rarPath.Get();
-    arcData.OpenMode = RAR_OM_EXTRACT;
-    arcData.Callback = unrarCallback;
-    arcData.UserData = (LPARAM)&uncompressedBuf;
-
-    HANDLE hArc = RAROpenArchiveEx(&arcData);
-    if (!hArc || arcData.OpenResult != 0) {
-        return {};
+    // in a solid archive, extracting an entry implicitly decompresses all
+    // entries before it. the handle is kept open between calls, so forward
+    // access only pays for the distance from the last extracted entry;
+    // going backwards still has to restart from the beginning
+    if (unrarHandle_ && unrarPos_ > fileId) {
+        CloseUnrarHandle(unrarHandle_);
+        unrarHandle_ = nullptr;
+    }
+    if (!unrarHandle_) {
+        AutoFreeWstr rarPath = strconv::Utf8ToWstr(rarFilePath_);
+        RAROpenArchiveDataEx arcData = {0};
+        arcData.ArcNameW = rarPath.Get();
+        arcData.OpenMode = RAR_OM_EXTRACT;
+        HANDLE hArc = RAROpenArchiveEx(&arcData);
+        if (!hArc || arcData.OpenResult != 0) {
+            return {};
+        }
+        unrarHandle_ = hArc;
+        unrarPos_ = 0;
     }
 
     auto* fileInfo = fileInfos_[fileId];
     CrashIf(fileInfo->fileId != fileId);
 
+    str::Slice uncompressedBuf;
+    RARSetCallback(unrarHandle_, unrarCallback, (LPARAM)&uncompressedBuf);
+
     char* data = nullptr;
     size_t size = 0;
-    AutoFreeWstr fileName = strconv::Utf8ToWstr(fileInfo->name.data());
     RARHeaderDataEx rarHeader = {0};
-    int res;
-    bool ok = FindFile(hArc, &rarHeader, fileName.Get());
-    if (!ok) {
+    int res = 0;
+    bool ok = true;
+    // entries were enumerated in archive order in OpenUnrarFallback, so
+    // the target is fileId - unrarPos_ entries ahead
+    while (unrarPos_ < fileId) {
+        res = RARReadHeaderEx(unrarHandle_, &rarHeader);
+        if (res != 0 || RARProcessFile(unrarHandle_, RAR_SKIP, nullptr, nullptr) != 0) {
+            ok = false;
+            goto Exit;
+        }
+        unrarPos_++;
+    }
+    res = RARReadHeaderEx(unrarHandle_, &rarHeader);
+    // don't support files whose uncompressed size is greater than 4GB
+    if (res != 0 || rarHeader.UnpSizeHigh != 0) {
+        ok = false;
         goto Exit;
     }
     size = fileInfo->fileSizeUncompressed;
@@ -348,12 +423,16 @@ std::span<u8> MultiFormatArchive::GetFileDataByIdUnarrDll(size_t fileId) {
         goto Exit;
     }
     uncompressedBuf.Set(data, size);
-    res = RARProcessFile(hArc, RAR_TEST, nullptr, nullptr);
+    res = RARProcessFile(unrarHandle_, RAR_TEST, nullptr, nullptr);
     ok = (res == 0) && (uncompressedBuf.Left() == 0);
+    unrarPos_ = fileId + 1;
 
 Exit:
-    RARCloseArchive(hArc);
     if (!ok) {
+        // the decoder's position is unknown after a failure, reopen the
+        // archive on the next call
+        CloseUnrarHandle(unrarHandle_);
+        unrarHandle_ = nullptr;
         free(data);
         return {};
     }
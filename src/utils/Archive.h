@@ -57,6 +57,26 @@ class MultiFormatArchive {
     // only set when we loaded file infos using unrar.dll fallback
     const char* rarFilePath_ = nullptr;
 
+    // most recently decoded entries; in solid archives an entry can't be
+    // decoded without decompressing all entries before it, so repeats
+    // (e.g. backwards page turns in a comic book) are served from memory
+    struct CachedEntry {
+        size_t fileId;
+        size_t size;
+        u8* data;
+    };
+    Vec<CachedEntry> entryCache_;
+    size_t entryCacheBytes_ = 0;
+
+    // unrar.dll archive handle kept open between calls, so that forward
+    // access only decompresses from the last extracted entry onwards
+    void* unrarHandle_ = nullptr;
+    // index of the entry the open handle is positioned at
+    size_t unrarPos_ = 0;
+
+    std::span<u8> GetFromEntryCache(size_t fileId);
+    void AddToEntryCache(size_t fileId, const u8* data, size_t size);
+
     bool OpenUnrarFallback(const char* rarPathUtf);
     std::span<u8> GetFileDataByIdUnarrDll(size_t fileId);
     bool LoadedUsingUnrarDll() const {
@@ -181,6 +181,93 @@ void CalcSha2DigestWin(const void* data, size_t byteCount, u8 digest[32]) {
     CryptReleaseContext(hProv, 0);
 }
 
+// files up to this size are hashed in full; sampling only pays off once
+// reading the whole file gets noticeably slow
+#define FULL_FINGERPRINT_MAX_SIZE (16 * 1024 * 1024)
+// size of the head, tail and each strided sample block
+#define FINGERPRINT_BLOCK_SIZE (64 * 1024)
+// number of evenly strided blocks hashed between head and tail
+#define FINGERPRINT_STRIDE_BLOCKS 14
+
+static bool HashFileRange(HCRYPTHASH hHash, HANDLE hFile, i64 offset, i64 size, u8* buf) {
+    LARGE_INTEGER off;
+    off.QuadPart = offset;
+    if (!SetFilePointerEx(hFile, off, nullptr, FILE_BEGIN)) {
+        return false;
+    }
+    while (size > 0) {
+        DWORD toRead = FINGERPRINT_BLOCK_SIZE;
+        if (size < (i64)toRead) {
+            toRead = (DWORD)size;
+        }
+        DWORD nRead = 0;
+        if (!ReadFile(hFile, buf, toRead, &nRead, nullptr) || 0 == nRead) {
+            return false;
+        }
+        if (!CryptHashData(hHash, buf, nRead, 0)) {
+            return false;
+        }
+        size -= nRead;
+    }
+    return true;
+}
+
+// MD5 over the file size and sampled blocks of the contents. Uses the
+// CryptoAPI so that the hashing is dispatched to whatever hardware
+// acceleration the platform provides.
+bool CalcSampledFileFingerprint(const WCHAR* filePath, u8 digest[16]) {
+    DWORD access = GENERIC_READ;
+    DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE hFile = CreateFileW(filePath, access, share, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (INVALID_HANDLE_VALUE == hFile) {
+        return false;
+    }
+    LARGE_INTEGER li;
+    if (!GetFileSizeEx(hFile, &li)) {
+        CloseHandle(hFile);
+        return false;
+    }
+    i64 fileSize = li.QuadPart;
+
+    HCRYPTPROV hProv = 0;
+    HCRYPTHASH hHash = 0;
+    BOOL ok = CryptAcquireContext(&hProv, nullptr, MS_DEF_PROV, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
+    if (!ok) {
+        ok = CryptAcquireContext(&hProv, nullptr, MS_ENH_RSA_AES_PROV_XP, PROV_RSA_AES, CRYPT_VERIFYCONTEXT);
+    }
+    ok = ok && CryptCreateHash(hProv, CALG_MD5, 0, 0, &hHash);
+    // two files that share every sampled block but differ in length
+    // still get distinct fingerprints
+    ok = ok && CryptHashData(hHash, (const BYTE*)&fileSize, sizeof(fileSize), 0);
+
+    u8* buf = AllocArray<u8>(FINGERPRINT_BLOCK_SIZE);
+    if (fileSize <= FULL_FINGERPRINT_MAX_SIZE) {
+        ok = ok && HashFileRange(hHash, hFile, 0, fileSize, buf);
+    } else {
+        ok = ok && HashFileRange(hHash, hFile, 0, FINGERPRINT_BLOCK_SIZE, buf);
+        // the strides are derived from the file size alone, so the same
+        // file always produces the same fingerprint
+        i64 stride = (fileSize - 2 * (i64)FINGERPRINT_BLOCK_SIZE) / (FINGERPRINT_STRIDE_BLOCKS + 1);
+        for (int i = 1; i <= FINGERPRINT_STRIDE_BLOCKS && ok; i++) {
+            ok = HashFileRange(hHash, hFile, FINGERPRINT_BLOCK_SIZE + stride * i, FINGERPRINT_BLOCK_SIZE, buf);
+        }
+        ok = ok && HashFileRange(hHash, hFile, fileSize - FINGERPRINT_BLOCK_SIZE, FINGERPRINT_BLOCK_SIZE, buf);
+    }
+    free(buf);
+    CloseHandle(hFile);
+
+    DWORD hashLen = 16;
+    ok = ok && CryptGetHashParam(hHash, HP_HASHVAL, digest, &hashLen, 0);
+    ok = ok && (16 == hashLen);
+    if (hHash) {
+        CryptDestroyHash(hHash);
+    }
+    if (hProv) {
+        CryptReleaseContext(hProv, 0);
+    }
+    return !!ok;
+}
+
 static bool ExtractSignature(const char* hexSignature, const void* data, size_t& dataLen, ScopedMem<BYTE>& signature,
                              size_t& signatureLen) {
     // verify hexSignature format - must be either
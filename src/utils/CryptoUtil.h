@@ -5,6 +5,12 @@ void CalcMD5Digest(const u8* data, size_t byteCount, u8 digest[16]);
 void CalcSHA1Digest(const u8* data, size_t byteCount, u8 digest[20]);
 void CalcSHA2Digest(const u8* data, size_t byteCount, u8 digest[32]);
 
+// cheap content identity for (potentially huge) files: hashes the file
+// size plus head, tail and evenly strided sample blocks instead of the
+// full contents; files up to 16 MB are hashed in full. Returns false if
+// the file couldn't be read.
+bool CalcSampledFileFingerprint(const WCHAR* filePath, u8 digest[16]);
+
 void CalcMD5DigestWin(const void* data, size_t byteCount, u8 digest[16]);
 void CalcSha1DigestWin(const void* data, size_t byteCount, u8 digest[20]);
 void CalcSha2DigestWin(const void* data, size_t byteCount, u8 digest[32]);
@@ -15,10 +15,16 @@ hash table. The actual dict class is a wrapper that provides
 a type-safe API and handles policy decisions like allocations
 (if they are necessary).
 
-Our hash table uses the same parameters as the one in redis
-(but without complexity of incremental hashing):
-- we use chaining on collisions
+Our hash table uses open addressing with linear probing:
+- entries are stored inline in a single flat array, so a lookup
+  touches consecutive cache lines instead of chasing per-node
+  heap pointers (the previous version used collision chaining)
 - size of the hash table is power of two
+- each entry caches the hash of its key, so probing mostly
+  compares integers and resizing doesn't re-hash the keys
+- removal leaves a tombstone to keep probe chains intact
+The string keys themselves are interned into the dict's
+PoolAllocator, packed back to back in allocation order.
 
 TODO:
 - add iterator for keys/values
@@ -66,19 +72,24 @@ class WStrKeyHasherComparator : public HasherComparator {
 static StrKeyHasherComparator gStrKeyHasherComparator;
 static WStrKeyHasherComparator gWStrKeyHasherComparator;
 
+// key uses two sentinel values. Real keys are pointers, which are
+// never 0 or -1
+#define EMPTY_KEY ((uintptr_t)0)
+#define DELETED_KEY ((uintptr_t)-1)
+
 struct HashTableEntry {
     uintptr_t key;
     uintptr_t val;
-    struct HashTableEntry* next;
+    size_t hash; // cached so that probing and resizing don't re-hash the key
 };
 
 // not a class so that it can be allocated with an allocator
 struct HashTable {
-    HashTableEntry** entries;
-    HashTableEntry* freeList;
+    HashTableEntry* entries; // open addressing: entries are stored inline
 
     size_t nEntries;
-    size_t nUsed; // total number of inserted entries
+    size_t nUsed;    // total number of inserted entries
+    size_t nDeleted; // tombstones left by RemoveEntry()
 
     // for debugging
     size_t nResizes;
@@ -92,7 +103,7 @@ static HashTable* NewHashTable(size_t size, Allocator* allocator) {
     size = RoundToPowerOf2(size);
     // entries are not allocated with allocator since those are large blocks
     // and we don't want to waste their memory after
-    h->entries = AllocArray<HashTableEntry*>(size);
+    h->entries = AllocArray<HashTableEntry>(size);
     h->nEntries = size;
     return h;
 }
@@ -102,40 +113,42 @@ static void DeleteHashTable(HashTable* h) {
     // the rest is freed by allocator
 }
 
-static void HashTableResize(HashTable* h, HasherComparator* hc) {
+static void HashTableResize(HashTable* h) {
     size_t newSize = RoundToPowerOf2(h->nEntries + 1);
     CrashIf(newSize <= h->nEntries);
-    HashTableEntry** newEntries = AllocArray<HashTableEntry*>(newSize);
-    HashTableEntry *e, *next;
-    size_t hash, pos;
+    HashTableEntry* newEntries = AllocArray<HashTableEntry>(newSize);
+    size_t mask = newSize - 1;
     for (size_t i = 0; i < h->nEntries; i++) {
-        e = h->entries[i];
-        while (e) {
-            next = e->next;
-            hash = hc->Hash(e->key);
-            pos = hash % newSize;
-            e->next = newEntries[pos];
-            newEntries[pos] = e;
-            e = next;
+        HashTableEntry* e = &h->entries[i];
+        if (EMPTY_KEY == e->key || DELETED_KEY == e->key) {
+            continue;
+        }
+        // the cached hash saves us from re-hashing all the keys
+        size_t pos = e->hash & mask;
+        while (EMPTY_KEY != newEntries[pos].key) {
+            pos = (pos + 1) & mask;
         }
+        newEntries[pos] = *e;
     }
     free(h->entries);
     h->entries = newEntries;
     h->nEntries = newSize;
+    h->nDeleted = 0; // tombstones are dropped during a resize
     h->nResizes += 1;
 
-    CrashIf(h->nUsed >= (h->nEntries * 3) / 2);
+    CrashIf(h->nUsed * 10 >= h->nEntries * 7);
 }
 
 // micro optimization: this is called often, so we want this check inlined. Resizing logic
 // is called rarely, so doesn't need to be inlined
-static inline void HashTableResizeIfNeeded(HashTable* h, HasherComparator* hc) {
-    // per http://stackoverflow.com/questions/1603712/when-should-i-do-rehashing-of-entire-hash-table/1604428#1604428
-    // when using collision chaining, load factor can be 150%
-    if (h->nUsed < (h->nEntries * 3) / 2) {
+static inline void HashTableResizeIfNeeded(HashTable* h) {
+    // open addressing degrades sharply as the table fills up, so unlike
+    // with chaining we resize at 70% load. Tombstones count as well since
+    // they lengthen probe chains just like live entries
+    if ((h->nUsed + h->nDeleted) * 10 < h->nEntries * 7) {
         return;
     }
-    HashTableResize(h, hc);
+    HashTableResize(h);
 }
 
 // note: allocator must be nullptr for get, non-nullptr for create
@@ -143,70 +156,75 @@ static HashTableEntry* GetOrCreateEntry(HashTable* h, HasherComparator* hc, uint
                                         bool& newEntry) {
     bool shouldCreate = (allocator != nullptr);
     size_t hash = hc->Hash(key);
-    size_t pos = hash % h->nEntries;
-    HashTableEntry* e = h->entries[pos];
+    size_t mask = h->nEntries - 1;
+    size_t pos = hash & mask;
+    HashTableEntry* e;
+    HashTableEntry* firstDeleted = nullptr;
     newEntry = false;
-    while (e) {
-        if (hc->Equal(key, e->key)) {
+    // the load factor stays below 100%, so there's always an empty
+    // slot that terminates the probe
+    for (;;) {
+        e = &h->entries[pos];
+        if (EMPTY_KEY == e->key) {
+            break;
+        }
+        if (DELETED_KEY == e->key) {
+            // remember the first tombstone so that we can recycle it
+            if (!firstDeleted) {
+                firstDeleted = e;
+            }
+        } else if (e->hash == hash && hc->Equal(key, e->key)) {
             return e;
         }
-        e = e->next;
+        pos = (pos + 1) & mask;
     }
     if (!shouldCreate) {
         return nullptr;
     }
 
-    if (h->freeList) {
-        e = h->freeList;
-        h->freeList = h->freeList->next;
-    } else {
-        e = (HashTableEntry*)Allocator::AllocZero(allocator, sizeof(HashTableEntry));
+    if (firstDeleted) {
+        e = firstDeleted;
+        h->nDeleted--;
     }
-    e->next = h->entries[pos];
-    h->entries[pos] = e;
-    h->nUsed++;
-    if (e->next != nullptr) {
+    if (pos != (hash & mask)) {
         h->nCollisions++;
     }
+    // the callers that intern keys overwrite this with their own copy
+    e->key = key;
+    e->val = 0;
+    e->hash = hash;
+    h->nUsed++;
     newEntry = true;
     return e;
 }
 
 static bool RemoveEntry(HashTable* h, HasherComparator* hc, uintptr_t key, uintptr_t* removedValOut) {
     size_t hash = hc->Hash(key);
-    size_t pos = hash % h->nEntries;
-    HashTableEntry* e = h->entries[pos];
-    while (e) {
-        if (hc->Equal(key, e->key)) {
-            break;
+    size_t mask = h->nEntries - 1;
+    size_t pos = hash & mask;
+    for (;;) {
+        HashTableEntry* e = &h->entries[pos];
+        if (EMPTY_KEY == e->key) {
+            return false;
         }
-        e = e->next;
-    }
-    if (!e) {
-        return false;
-    }
-
-    // remove the the entry from the list
-    HashTableEntry* e2 = h->entries[pos];
-    if (e2 == e) {
-        h->entries[pos] = e->next;
-    } else {
-        while (e2->next != e) {
-            e2 = e2->next;
+        if (DELETED_KEY != e->key && e->hash == hash && hc->Equal(key, e->key)) {
+            *removedValOut = e->val;
+            // a tombstone (and not EMPTY_KEY) so that probe chains running
+            // through this slot stay intact. The interned copy of the key
+            // stays in the pool - it can't be freed individually anyway
+            e->key = DELETED_KEY;
+            e->val = 0;
+            CrashIf(0 == h->nUsed);
+            h->nUsed -= 1;
+            h->nDeleted += 1;
+            return true;
         }
-        e2->next = e->next;
+        pos = (pos + 1) & mask;
     }
-    e->next = h->freeList;
-    h->freeList = e;
-    *removedValOut = e->val;
-    CrashIf(0 == h->nUsed);
-    h->nUsed -= 1;
-    return true;
 }
 
 MapStrToInt::MapStrToInt(size_t initialSize) {
-    // we use PoolAllocator to allocate HashTableEntry entries
-    // and copies of string keys
+    // we use PoolAllocator to intern copies of the string keys
     allocator.allocAlign = 4;
     h = NewHashTable(initialSize, &allocator);
 }
@@ -246,7 +264,7 @@ bool MapStrToInt::Insert(const char* key, int val, int* existingValOut, const ch
         *existingKeyOut = (const char*)e->key;
     }
 
-    HashTableResizeIfNeeded(h, &gStrKeyHasherComparator);
+    HashTableResizeIfNeeded(h);
     return true;
 }
 
@@ -271,8 +289,7 @@ bool MapStrToInt::Get(const char* key, int* valOut) {
 }
 
 MapWStrToInt::MapWStrToInt(size_t initialSize) {
-    // we use PoolAllocator to allocate HashTableEntry entries
-    // and copies of string keys
+    // we use PoolAllocator to intern copies of the string keys
     h = NewHashTable(initialSize, &allocator);
 }
 
@@ -296,13 +313,13 @@ bool MapWStrToInt::Insert(const WCHAR* key, int val, int* prevVal) {
     e->key = (intptr_t)Allocator::StrDup(&allocator, key);
     e->val = (intptr_t)val;
 
-    HashTableResizeIfNeeded(h, &gWStrKeyHasherComparator);
+    HashTableResizeIfNeeded(h);
     return true;
 }
 
 bool MapWStrToInt::Remove(const WCHAR* key, int* removedValOut) {
     uintptr_t removedVal;
-    bool removed = RemoveEntry(h, &gStrKeyHasherComparator, (uintptr_t)key, &removedVal);
+    bool removed = RemoveEntry(h, &gWStrKeyHasherComparator, (uintptr_t)key, &removedVal);
     if (removed && removedValOut) {
         *removedValOut = (int)removedVal;
     }
@@ -320,6 +337,55 @@ bool MapWStrToInt::Get(const WCHAR* key, int* valOut) {
     return true;
 }
 
+MapWStrToPtr::MapWStrToPtr(size_t initialSize) {
+    // we use PoolAllocator to intern copies of the string keys
+    h = NewHashTable(initialSize, &allocator);
+}
+
+MapWStrToPtr::~MapWStrToPtr() {
+    DeleteHashTable(h);
+}
+
+size_t MapWStrToPtr::Count() const {
+    return h->nUsed;
+}
+
+bool MapWStrToPtr::Insert(const WCHAR* key, void* val, void** prevValOut) {
+    bool newEntry;
+    HashTableEntry* e = GetOrCreateEntry(h, &gWStrKeyHasherComparator, (uintptr_t)key, &allocator, newEntry);
+    if (!newEntry) {
+        if (prevValOut) {
+            *prevValOut = (void*)e->val;
+        }
+        return false;
+    }
+    e->key = (intptr_t)Allocator::StrDup(&allocator, key);
+    e->val = (uintptr_t)val;
+
+    HashTableResizeIfNeeded(h);
+    return true;
+}
+
+bool MapWStrToPtr::Remove(const WCHAR* key, void** removedValOut) {
+    uintptr_t removedVal;
+    bool removed = RemoveEntry(h, &gWStrKeyHasherComparator, (uintptr_t)key, &removedVal);
+    if (removed && removedValOut) {
+        *removedValOut = (void*)removedVal;
+    }
+    return removed;
+}
+
+bool MapWStrToPtr::Get(const WCHAR* key, void** valOut) {
+    WStrKeyHasherComparator hc;
+    bool newEntry;
+    HashTableEntry* e = GetOrCreateEntry(h, &hc, (uintptr_t)key, nullptr, newEntry);
+    if (!e) {
+        return false;
+    }
+    *valOut = (void*)e->val;
+    return true;
+}
+
 } // namespace dict
 
 int StringInterner::Intern(const char* s, bool* alreadyPresent) {
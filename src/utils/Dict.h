@@ -7,9 +7,10 @@ struct HashTable;
 
 // we are very generous with default initial size. It's a trade-off
 // between memory used by hash table and how often we need to resize it.
-// We allocate size*sizeof(ptr) which is 64k on 32-bit for 16k entries.
-// 64k is very little on today's machines, especially for short-lived
-// hash tables.
+// Entries are stored inline (open addressing), so we allocate
+// size*sizeof(entry) which is ~200k on 32-bit for 16k entries.
+// That's still very little on today's machines, especially for
+// short-lived hash tables.
 // Should use smaller values for long-lived hash tables, especially
 // if there are many of them.
 enum { DEFAULT_HASH_TABLE_INITIAL_SIZE = 16 * 1024 };
@@ -49,6 +50,25 @@ class MapWStrToInt {
     bool Get(const WCHAR* key, int* valOut);
 };
 
+// a dictionary whose keys are WCHAR * strings and the values are pointers
+// (the dict doesn't own what they point to)
+class MapWStrToPtr {
+  public:
+    PoolAllocator allocator;
+    HashTable* h = nullptr;
+
+    explicit MapWStrToPtr(size_t initialSize = DEFAULT_HASH_TABLE_INITIAL_SIZE);
+    ~MapWStrToPtr();
+
+    size_t Count() const;
+
+    // if a key doesn't exist, inserts a key with a given value and return true
+    // if a key exists, returns false and sets prevValOut to existing value
+    bool Insert(const WCHAR* key, void* val, void** prevValOut);
+    bool Remove(const WCHAR* key, void** removedValOut);
+    bool Get(const WCHAR* key, void** valOut);
+};
+
 } // namespace dict
 
 class StringInterner {
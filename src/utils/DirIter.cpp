@@ -4,6 +4,7 @@
 #include "utils/BaseUtil.h"
 #include "utils/DirIter.h"
 #include "utils/FileUtil.h"
+#include "utils/ThreadUtil.h"
 
 // Start directory traversal in a given dir
 bool DirIter::StartDirIter(const WCHAR* dir) {
@@ -99,6 +100,85 @@ const WCHAR* DirIter::Next() {
     return currPath;
 }
 
+// each directory of a parallel traversal gets its own node; a node is
+// only ever written by the task enumerating that directory, so the
+// tree needs no locking
+struct DirTraverseNode {
+    AutoFreeWstr dir;
+    WStrVec files; // files directly in this dir, in enumeration order
+    Vec<DirTraverseNode*> subdirs;
+};
+
+struct DirTraverseCtx {
+    LONG pendingDirs;
+    HANDLE doneEvent;
+};
+
+static void TraverseDirTask(DirTraverseCtx* ctx, DirTraverseNode* node) {
+    AutoFreeWstr pattern(path::Join(node->dir, L"*"));
+    WIN32_FIND_DATA fdata{};
+    HANDLE hfind = FindFirstFile(pattern, &fdata);
+    // it's ok if we fail, this might be an auth problem, we keep going
+    if (INVALID_HANDLE_VALUE != hfind) {
+        do {
+            if ((fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                if (!IsSpecialDir(fdata.cFileName)) {
+                    auto* sub = new DirTraverseNode;
+                    sub->dir.Set(path::Join(node->dir, fdata.cFileName));
+                    node->subdirs.Append(sub);
+                }
+            } else if (IsRegularFile(fdata.dwFileAttributes)) {
+                node->files.Append(path::Join(node->dir, fdata.cFileName));
+            }
+        } while (FindNextFile(hfind, &fdata));
+        FindClose(hfind);
+    }
+    // sub-directories become their own tasks so that enumeration
+    // scales with the disk's queue depth
+    for (DirTraverseNode* sub : node->subdirs) {
+        InterlockedIncrement(&ctx->pendingDirs);
+        TaskHandle* t = GetThreadPool()->Submit([ctx, sub] { TraverseDirTask(ctx, sub); }, TaskPriority::Background);
+        DropTaskHandle(t);
+    }
+    if (0 == InterlockedDecrement(&ctx->pendingDirs)) {
+        SetEvent(ctx->doneEvent);
+    }
+}
+
+// moves the collected paths out of the tree in a stable order:
+// a directory's files first, then its sub-directories, depth first
+static void CollectDirTraverseResults(DirTraverseNode* node, WStrVec& paths) {
+    for (WCHAR* f : node->files) {
+        paths.Append(f); // transfers ownership
+    }
+    node->files.Reset();
+    for (DirTraverseNode* sub : node->subdirs) {
+        CollectDirTraverseResults(sub, paths);
+        delete sub;
+    }
+}
+
+// recursively collects all files under dir, enumerating each
+// sub-directory as a separate thread-pool task. The resulting order
+// doesn't depend on task scheduling, only on enumeration order
+bool CollectFilesParallel(const WCHAR* dir, WStrVec& paths) {
+    DirTraverseCtx ctx;
+    ctx.pendingDirs = 1; // the root
+    ctx.doneEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    auto* root = new DirTraverseNode;
+    root->dir.SetCopy(dir);
+    DirTraverseCtx* ctxPtr = &ctx;
+    TaskHandle* t = GetThreadPool()->Submit([ctxPtr, root] { TraverseDirTask(ctxPtr, root); }, TaskPriority::Background);
+    DropTaskHandle(t);
+    WaitForSingleObject(ctx.doneEvent, INFINITE);
+    CloseHandle(ctx.doneEvent);
+
+    size_t nBefore = paths.size();
+    CollectDirTraverseResults(root, paths);
+    delete root;
+    return paths.size() > nBefore;
+}
+
 bool CollectPathsFromDirectory(const WCHAR* pattern, WStrVec& paths, bool dirsInsteadOfFiles) {
     AutoFreeWstr dirPath = path::GetDir(pattern);
 
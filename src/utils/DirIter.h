@@ -37,6 +37,10 @@ class DirIter {
     const WCHAR* Next();
 };
 
+// like a recursive DirIter but enumerates each sub-directory on the
+// thread pool; the order of the collected paths is stable
+bool CollectFilesParallel(const WCHAR* dir, WStrVec& paths);
+
 bool CollectPathsFromDirectory(const WCHAR* pattern, WStrVec& paths, bool dirsInsteadOfFiles = false);
 // std::vector<std::wstring> CollectDirsFromDirectory(const WCHAR*);
 
@@ -0,0 +1,51 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "utils/BaseUtil.h"
+#include "utils/Timer.h"
+
+#include <TraceLoggingProvider.h>
+
+#include "utils/EtwTrace.h"
+
+// provider guid: {6618b83b-6f2c-49a5-842f-9c934a1f7be1}
+TRACELOGGING_DEFINE_PROVIDER(gTraceProvider, "SumatraPDF",
+                             (0x6618b83b, 0x6f2c, 0x49a5, 0x84, 0x2f, 0x9c, 0x93, 0x4a, 0x1f, 0x7b, 0xe1));
+
+static bool gProviderRegistered = false;
+
+void trace::Register() {
+    if (gProviderRegistered) {
+        return;
+    }
+    TraceLoggingRegister(gTraceProvider);
+    gProviderRegistered = true;
+}
+
+void trace::Unregister() {
+    if (!gProviderRegistered) {
+        return;
+    }
+    TraceLoggingUnregister(gTraceProvider);
+    gProviderRegistered = false;
+}
+
+void trace::LogScope(const char* name, double durMs, int arg) {
+    // TraceLoggingWrite checks this itself but the early out keeps the
+    // disabled case down to a couple of instructions
+    if (!TraceLoggingProviderEnabled(gTraceProvider, 0, 0)) {
+        return;
+    }
+    TraceLoggingWrite(gTraceProvider, "PerfScope", TraceLoggingString(name, "name"),
+                      TraceLoggingFloat64(durMs, "durMs"), TraceLoggingInt32(arg, "arg"));
+}
+
+ScopedTraceEvent::ScopedTraceEvent(const char* name, int arg) {
+    this->name = name;
+    this->arg = arg;
+    timeStart = TimeGet();
+}
+
+ScopedTraceEvent::~ScopedTraceEvent() {
+    trace::LogScope(name, TimeSinceInMs(timeStart), arg);
+}
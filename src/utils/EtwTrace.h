@@ -0,0 +1,36 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+/* Manifest-free ETW instrumentation (TraceLogging) for finding out where
+   time goes on user machines, without shipping a debug build. Scoped
+   timers emit a "PerfScope" event with the name of the instrumented
+   code path, the wall time spent in it and an optional event-specific
+   argument (e.g. a page number).
+
+   Events are only written when an ETW session listens to the
+   "SumatraPDF" provider, e.g.:
+     wpr -start GeneralProfile -start SumatraPDF.wprp && wpr -stop trace.etl
+   or via tracelog/xperf; otherwise the cost is one QueryPerformanceCounter
+   pair per scope. */
+
+namespace trace {
+
+// must be called once before events are emitted (and Unregister on exit);
+// LogScope is safe to call either way, it just won't emit anything
+void Register();
+void Unregister();
+
+void LogScope(const char* name, double durMs, int arg);
+
+} // namespace trace
+
+// emits a trace::LogScope event with the time spent between construction
+// and destruction. name must outlive the scope (use a string literal)
+struct ScopedTraceEvent {
+    const char* name = nullptr;
+    int arg = 0;
+    LARGE_INTEGER timeStart;
+
+    explicit ScopedTraceEvent(const char* name, int arg = 0);
+    ~ScopedTraceEvent();
+};
@@ -6,6 +6,7 @@
 
 #if OS_WIN
 #include "utils/ScopedWin.h"
+#include "utils/Dict.h"
 #include "utils/WinUtil.h"
 #endif
 
@@ -209,6 +210,10 @@ WCHAR* Join(const WCHAR* path, const WCHAR* fileName, const WCHAR* fileName2) {
 //    "c:\foo\bar.pdf" becomes "c:\foo\Bar.Pdf"
 //    "C:\foo\BAR.PDF" becomes "C:\foo\Bar.Pdf"
 WCHAR* Normalize(const WCHAR* path) {
+    // file path canonicalization would mangle urls
+    if (IsUrl(path)) {
+        return str::Dup(path);
+    }
     // convert to absolute path, change slashes into backslashes
     DWORD cch = GetFullPathName(path, 0, nullptr, nullptr);
     if (!cch) {
@@ -261,6 +266,42 @@ WCHAR* ShortPath(const WCHAR* path) {
     return shortpath;
 }
 
+/* Process-wide table of interned path strings. Subsystems that keep many
+   long-lived copies of the same path can share a single allocation and,
+   since the same path (compared case-insensitively) always interns to the
+   same pointer, compare paths with a pointer compare. */
+struct InternedPaths {
+    CRITICAL_SECTION cs;
+    // maps the lower-cased path to the canonical copy, which keeps the
+    // casing of the first Intern call
+    dict::MapWStrToPtr map;
+
+    InternedPaths() : map(256) {
+        InitializeCriticalSection(&cs);
+    }
+};
+
+const WCHAR* Intern(const WCHAR* path) {
+    if (!path) {
+        return nullptr;
+    }
+    // deliberately never freed: interned paths must stay valid until
+    // process exit
+    static InternedPaths* paths = new InternedPaths();
+
+    AutoFreeWstr key(str::Dup(path));
+    str::ToLowerInPlace(key.Get());
+
+    ScopedCritSec scope(&paths->cs);
+    void* existing = nullptr;
+    if (paths->map.Get(key, &existing)) {
+        return (const WCHAR*)existing;
+    }
+    WCHAR* canonical = str::Dup(path);
+    paths->map.Insert(key, canonical, nullptr);
+    return canonical;
+}
+
 static bool IsSameFileHandleInformation(BY_HANDLE_FILE_INFORMATION& fi1, BY_HANDLE_FILE_INFORMATION fi2) {
     if (fi1.dwVolumeSerialNumber != fi2.dwVolumeSerialNumber) {
         return false;
@@ -406,6 +447,12 @@ bool IsAbsolute(const WCHAR* path) {
     return !PathIsRelative(path);
 }
 
+// an http(s) url posing as a document path; such documents are read
+// via HTTP range requests (see fz_open_url in EngineFzUtil.cpp)
+bool IsUrl(const WCHAR* path) {
+    return str::StartsWithI(path, L"http://") || str::StartsWithI(path, L"https://");
+}
+
 // returns the path to either the %TEMP% directory or a
 // non-existing file inside whose name starts with filePrefix
 WCHAR* GetTempPath(const WCHAR* filePrefix) {
@@ -458,10 +505,9 @@ FILE* OpenFILE(const char* path) {
 }
 
 std::span<u8> ReadFileWithAllocator(const char* filePath, Allocator* allocator) {
-#if 0 // OS_WIN
-    WCHAR buf[512];
-    strconv::Utf8ToWcharBuf(filePath, str::Len(filePath), buf, dimof(buf));
-    return ReadFileWithAllocator(buf, fileSizeOut, allocator);
+#if OS_WIN
+    AutoFreeWstr pathW = strconv::Utf8ToWstr(filePath);
+    return ReadFileWithAllocator(pathW.Get(), allocator);
 #else
     char* d = nullptr;
     int res;
@@ -584,9 +630,152 @@ i64 GetSize(std::string_view filePath) {
     return size.QuadPart;
 }
 
+// size of one overlapped read request and the number of them in flight.
+// With a single request the next one is only issued once the previous
+// response arrived, so reading from a network share pays a full round
+// trip per buffer; several outstanding requests keep the pipe busy
+// (local disks barely notice the difference, SMB gets several times
+// faster for large files)
+#define ASYNC_READ_CHUNK (1 << 20)
+#define ASYNC_READ_DEPTH 4
+
+struct AsyncReadSlot {
+    OVERLAPPED ov{};
+    u8* dest{nullptr};
+    DWORD len{0};
+};
+
+static bool IssueAsyncRead(HANDLE h, AsyncReadSlot* slot, u8* dest, i64 offset, i64 size) {
+    DWORD len = ASYNC_READ_CHUNK;
+    if (offset + len > size) {
+        len = (DWORD)(size - offset);
+    }
+    // keep the event across the reset, it's reused for every request
+    HANDLE event = slot->ov.hEvent;
+    slot->ov = {};
+    slot->ov.hEvent = event;
+    slot->ov.Offset = (DWORD)offset;
+    slot->ov.OffsetHigh = (DWORD)(offset >> 32);
+    slot->dest = dest;
+    slot->len = len;
+    BOOL ok = ::ReadFile(h, dest, len, nullptr, &slot->ov);
+    return ok || ERROR_IO_PENDING == GetLastError();
+}
+
+/* Reads <size> bytes from a FILE_FLAG_OVERLAPPED handle with up to
+   ASYNC_READ_DEPTH requests in flight. The chunks go into <fullBuf> at
+   their file offsets if given, into per-slot scratch buffers otherwise;
+   <cb> (optional) gets each chunk in file order and can abort the read
+   by returning false. */
+static bool ReadWithRequestsInFlight(HANDLE h, i64 size, u8* fullBuf, ReadFileChunkCb cb, void* ctx) {
+    i64 nChunks = (size + ASYNC_READ_CHUNK - 1) / ASYNC_READ_CHUNK;
+    int depth = ASYNC_READ_DEPTH;
+    if (nChunks < depth) {
+        depth = (int)nChunks;
+    }
+    if (0 == depth) {
+        // empty file
+        return true;
+    }
+
+    u8* scratch = nullptr;
+    if (!fullBuf) {
+        scratch = AllocArray<u8>((size_t)depth * ASYNC_READ_CHUNK);
+        if (!scratch) {
+            return false;
+        }
+    }
+    AsyncReadSlot slots[ASYNC_READ_DEPTH];
+    bool ok = true;
+    for (int i = 0; i < depth; i++) {
+        slots[i].ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        ok = ok && slots[i].ov.hEvent != nullptr;
+    }
+
+    // prime the pipeline ...
+    i64 offset = 0;
+    for (int i = 0; ok && i < depth; i++) {
+        u8* dest = fullBuf ? fullBuf + offset : scratch + (size_t)i * ASYNC_READ_CHUNK;
+        ok = IssueAsyncRead(h, &slots[i], dest, offset, size);
+        offset += ASYNC_READ_CHUNK;
+    }
+    // ... then hand on the oldest chunk and reuse its slot for the next
+    // one, so that <depth> requests stay outstanding until the file ends
+    i64 issued = depth;
+    for (i64 c = 0; ok && c < nChunks; c++) {
+        AsyncReadSlot* slot = &slots[c % depth];
+        DWORD nRead = 0;
+        ok = GetOverlappedResult(h, &slot->ov, &nRead, TRUE) && nRead == slot->len;
+        if (ok && cb) {
+            ok = cb(ctx, slot->dest, slot->len);
+        }
+        if (ok && issued < nChunks) {
+            u8* dest = fullBuf ? fullBuf + offset : slot->dest;
+            ok = IssueAsyncRead(h, slot, dest, offset, size);
+            offset += ASYNC_READ_CHUNK;
+            issued++;
+        }
+    }
+
+    if (!ok) {
+        // the kernel still writes into the buffers of outstanding requests,
+        // wait for them to settle before the buffers are freed
+        CancelIo(h);
+        for (int i = 0; i < depth; i++) {
+            DWORD nRead;
+            if (slots[i].ov.hEvent) {
+                GetOverlappedResult(h, &slots[i].ov, &nRead, TRUE);
+            }
+        }
+    }
+    for (int i = 0; i < depth; i++) {
+        if (slots[i].ov.hEvent) {
+            CloseHandle(slots[i].ov.hEvent);
+        }
+    }
+    free(scratch);
+    return ok;
+}
+
+static HANDLE OpenForSequentialRead(const WCHAR* path) {
+    return CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_OVERLAPPED, nullptr);
+}
+
 std::span<u8> ReadFileWithAllocator(const WCHAR* path, Allocator* allocator) {
-    AutoFree pathUtf8 = strconv::WstrToUtf8(path);
-    return ReadFileWithAllocator(pathUtf8.data, allocator);
+    AutoCloseHandle h(OpenForSequentialRead(path));
+    if (!h.IsValid()) {
+        return {};
+    }
+    LARGE_INTEGER li{};
+    if (!GetFileSizeEx(h, &li) || li.QuadPart < 0) {
+        return {};
+    }
+    size_t size = (size_t)li.QuadPart;
+    if (addOverflows<size_t>(size, ZERO_PADDING_COUNT)) {
+        return {};
+    }
+    u8* d = (u8*)Allocator::AllocZero(allocator, size + ZERO_PADDING_COUNT);
+    if (!d) {
+        return {};
+    }
+    if (!ReadWithRequestsInFlight(h, (i64)size, d, nullptr, nullptr)) {
+        Allocator::Free(allocator, d);
+        return {};
+    }
+    return {d, size};
+}
+
+bool ReadFileChunked(const WCHAR* path, ReadFileChunkCb cb, void* ctx) {
+    AutoCloseHandle h(OpenForSequentialRead(path));
+    if (!h.IsValid()) {
+        return false;
+    }
+    LARGE_INTEGER li{};
+    if (!GetFileSizeEx(h, &li) || li.QuadPart < 0) {
+        return false;
+    }
+    return ReadWithRequestsInFlight(h, li.QuadPart, nullptr, cb, ctx);
 }
 
 // buf must be at least toRead in size (note: it won't be zero-terminated)
@@ -23,11 +23,16 @@ const WCHAR* GetExtNoFree(const WCHAR* path);
 
 WCHAR* Normalize(const WCHAR* path);
 WCHAR* ShortPath(const WCHAR* path);
+// the returned string lives until process exit and the same path (compared
+// case-insensitively) always returns the same pointer, so interned paths
+// can be compared with == and must not be freed
+const WCHAR* Intern(const WCHAR* path);
 bool IsSame(const WCHAR* path1, const WCHAR* path2);
 bool HasVariableDriveLetter(const WCHAR* path);
 bool IsOnFixedDrive(const WCHAR* path);
 bool Match(const WCHAR* path, const WCHAR* filter);
 bool IsAbsolute(const WCHAR* path);
+bool IsUrl(const WCHAR* path);
 
 WCHAR* GetDir(const WCHAR* path);
 WCHAR* Join(const WCHAR* path, const WCHAR* fileName, const WCHAR* fileName2 = nullptr);
@@ -63,6 +68,14 @@ bool SetModificationTime(const WCHAR* path, FILETIME lastMod);
 bool StartsWithN(const WCHAR* path, const char* magicNumber, size_t len);
 bool StartsWith(const WCHAR* path, const char* magicNumber);
 
+// gets consecutive chunks of a file in file order;
+// return false to stop reading
+typedef bool (*ReadFileChunkCb)(void* ctx, const u8* data, size_t len);
+// streams a file through <cb> while further overlapped reads are in
+// flight, so that parsing overlaps the I/O latency (mostly relevant
+// for large files on network shares, see ReadWithRequestsInFlight)
+bool ReadFileChunked(const WCHAR* path, ReadFileChunkCb cb, void* ctx);
+
 int GetZoneIdentifier(const WCHAR* path);
 bool SetZoneIdentifier(const WCHAR* path, int zoneId = URLZONE_INTERNET);
 bool DeleteZoneIdentifier(const WCHAR* path);
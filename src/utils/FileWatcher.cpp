@@ -52,6 +52,15 @@ TODO:
 // there's a balance between responsiveness to changes and efficiency
 #define FILEWATCH_DELAY_IN_MS 1000
 
+// a tool that rebuilds a file (e.g. pdflatex) can touch it dozens of
+// times within a second; we only fire the callback once no further
+// change notification arrived for this long
+#define FILEWATCH_SETTLE_DELAY_IN_MS 100
+
+// number of bytes hashed at the start and at the end of a file to detect
+// writes that didn't actually change the content
+#define FILEWATCH_HASH_BYTES (4 * 1024)
+
 // Some people use overlapped.hEvent to store data but I'm playing it safe.
 struct OverlappedEx {
     OVERLAPPED overlapped{};
@@ -66,6 +75,7 @@ struct FileState {
 
 struct WatchedDir {
     WatchedDir* next{nullptr};
+    // interned with path::Intern, so not owned
     const WCHAR* dirPath{nullptr};
     HANDLE hDir{nullptr};
     bool startMonitoring{true};
@@ -76,6 +86,7 @@ struct WatchedDir {
 struct WatchedFile {
     WatchedFile* next;
     WatchedDir* watchedDir;
+    // interned with path::Intern, so not owned
     const WCHAR* filePath;
     std::function<void()> onFileChangedCb;
 
@@ -84,6 +95,16 @@ struct WatchedFile {
     // file state for changes
     bool isManualCheck;
     FileState fileState;
+
+    // tick count of the most recent change notification; the callback
+    // fires once FILEWATCH_SETTLE_DELAY_IN_MS passed without another
+    // one (0 if no notification is pending)
+    DWORD pendingSince;
+    // size and quick content hash at the time the callback last fired
+    // (or the file was subscribed); used to drop notifications for
+    // writes that didn't change the content
+    i64 firedSize;
+    u32 firedHash;
 };
 
 static HANDLE g_threadHandle = 0;
@@ -117,6 +138,43 @@ static void GetFileState(const WCHAR* filePath, FileState* fs) {
     fs->size = file::GetSize(path.AsView());
 }
 
+// hashes the first and the last FILEWATCH_HASH_BYTES of the file; for
+// same-size rewrites the tail is the better signal (e.g. a PDF's xref
+// offsets change on every rebuild)
+static u32 GetContentQuickHash(const WCHAR* filePath, i64 size) {
+    HANDLE h = file::OpenReadOnly(filePath);
+    if (INVALID_HANDLE_VALUE == h) {
+        return 0;
+    }
+
+    char buf[FILEWATCH_HASH_BYTES];
+    DWORD nRead = 0;
+    u32 hash = 0;
+    BOOL ok = ReadFile(h, buf, sizeof(buf), &nRead, nullptr);
+    if (ok && nRead > 0) {
+        hash = MurmurHash2(buf, nRead);
+    }
+    if (size > (i64)sizeof(buf)) {
+        LARGE_INTEGER off;
+        off.QuadPart = -(i64)sizeof(buf);
+        if (SetFilePointerEx(h, off, nullptr, FILE_END)) {
+            ok = ReadFile(h, buf, sizeof(buf), &nRead, nullptr);
+            if (ok && nRead > 0) {
+                hash ^= MurmurHash2(buf, nRead);
+            }
+        }
+    }
+    CloseHandle(h);
+    return hash;
+}
+
+static void CaptureFiredState(WatchedFile* wf) {
+    FileState fs;
+    GetFileState(wf->filePath, &fs);
+    wf->firedSize = fs.size;
+    wf->firedHash = GetContentQuickHash(wf->filePath, fs.size);
+}
+
 static bool FileStateEq(FileState* fs1, FileState* fs2) {
     if (0 != CompareFileTime(&fs1->time, &fs2->time)) {
         return false;
@@ -142,11 +200,16 @@ static bool FileStateChanged(const WCHAR* filePath, FileState* fs) {
 // TODO: per internet, fileName could be short, 8.3 dos-style name
 // and we don't handle that. On the other hand, I've only seen references
 // to it wrt. to rename/delete operation, which we don't get notified about
-//
-// TODO: to collapse multiple notifications for the same file, could put it on a
-// queue, restart the thread with a timeout, restart the process if we
-// get notified again before timeout expires, call OnFileChanges() when
-// timeout expires
+static void MarkPendingNotification(WatchedFile* wf) {
+    // every notification restarts the settle window, so a burst of
+    // writes (e.g. a LaTeX rebuild) results in a single callback
+    wf->pendingSince = GetTickCount();
+    if (0 == wf->pendingSince) {
+        // 0 means "no notification pending"
+        wf->pendingSince = 1;
+    }
+}
+
 static void NotifyAboutFile(WatchedDir* d, const WCHAR* fileName) {
     // logf(L"NotifyAboutFile(): %s", fileName);
 
@@ -164,12 +227,38 @@ static void NotifyAboutFile(WatchedDir* d, const WCHAR* fileName) {
         // because the time granularity is so big that this can cause genuine
         // file notifications to be ignored. (This happens for instance for
         // PDF files produced by pdftex from small.tex document)
+        // FirePendingNotifications() compares size and content hash instead
+        MarkPendingNotification(wf);
+    }
+}
+
+// fires the callbacks whose settle window has passed, unless the write
+// turned out to not change the content (same size and quick hash, e.g.
+// a tool re-saving an identical file or only touching the timestamp)
+static void FirePendingNotifications() {
+    ScopedCritSec cs(&g_threadCritSec);
+
+    DWORD now = GetTickCount();
+    for (WatchedFile* wf = g_watchedFiles; wf; wf = wf->next) {
+        if (!wf->pendingSince || (now - wf->pendingSince) < FILEWATCH_SETTLE_DELAY_IN_MS) {
+            continue;
+        }
+        wf->pendingSince = 0;
+
+        FileState fs;
+        GetFileState(wf->filePath, &fs);
+        u32 hash = GetContentQuickHash(wf->filePath, fs.size);
+        if (fs.size == wf->firedSize && hash == wf->firedHash) {
+            // logf(L"FirePendingNotifications() content of %s unchanged\n", wf->filePath);
+            continue;
+        }
+        wf->firedSize = fs.size;
+        wf->firedHash = hash;
         wf->onFileChangedCb();
     }
 }
 
 static void DeleteWatchedDir(WatchedDir* wd) {
-    str::Free(wd->dirPath);
     free(wd);
 }
 
@@ -264,12 +353,17 @@ static void StartMonitoringDirForChanges(WatchedDir* wd) {
 
 static DWORD GetTimeoutInMs() {
     ScopedCritSec cs(&g_threadCritSec);
+    DWORD timeout = INFINITE;
     for (WatchedFile* wf = g_watchedFiles; wf; wf = wf->next) {
+        if (wf->pendingSince) {
+            // wake up soon to fire the debounced notification
+            return FILEWATCH_SETTLE_DELAY_IN_MS / 2;
+        }
         if (wf->isManualCheck) {
-            return FILEWATCH_DELAY_IN_MS;
+            timeout = FILEWATCH_DELAY_IN_MS;
         }
     }
-    return INFINITE;
+    return timeout;
 }
 
 static void RunManualChecks() {
@@ -281,7 +375,7 @@ static void RunManualChecks() {
         }
         if (FileStateChanged(wf->filePath, &wf->fileState)) {
             // logf(L"RunManualCheck() %s changed\n", wf->filePath);
-            wf->onFileChangedCb();
+            MarkPendingNotification(wf);
         }
     }
 }
@@ -297,6 +391,7 @@ static DWORD WINAPI FileWatcherThread([[maybe_unused]] void* param) {
         DWORD obj = WaitForMultipleObjectsEx(1, handles, FALSE, timeout, alertable);
         if (WAIT_TIMEOUT == obj) {
             RunManualChecks();
+            FirePendingNotifications();
             continue;
         }
 
@@ -333,8 +428,9 @@ static void StartThreadIfNecessary() {
 
 static WatchedDir* FindExistingWatchedDir(const WCHAR* dirPath) {
     for (WatchedDir* wd = g_watchedDirs; wd; wd = wd->next) {
-        // TODO: normalize dirPath?
-        if (str::EqI(dirPath, wd->dirPath)) {
+        // dirPath and wd->dirPath are both interned, so a case-insensitive
+        // match is a pointer match
+        if (dirPath == wd->dirPath) {
             return wd;
         }
     }
@@ -368,7 +464,7 @@ static WatchedDir* NewWatchedDir(const WCHAR* dirPath) {
 
     WatchedDir* wd = AllocStruct<WatchedDir>();
     wd->hDir = hDir;
-    wd->dirPath = str::Dup(dirPath);
+    wd->dirPath = path::Intern(dirPath);
 
     ListInsert(&g_watchedDirs, wd);
     return wd;
@@ -376,7 +472,8 @@ static WatchedDir* NewWatchedDir(const WCHAR* dirPath) {
 
 static WatchedFile* NewWatchedFile(const WCHAR* filePath, const std::function<void()>& onFileChangedCb) {
     bool isManualCheck = PathIsNetworkPath(filePath);
-    AutoFreeWstr dirPath(path::GetDir(filePath));
+    AutoFreeWstr dirPathTmp(path::GetDir(filePath));
+    const WCHAR* dirPath = path::Intern(dirPathTmp);
     WatchedDir* wd = nullptr;
     bool newDir = false;
     if (!isManualCheck) {
@@ -392,13 +489,14 @@ static WatchedFile* NewWatchedFile(const WCHAR* filePath, const std::function<vo
     }
 
     WatchedFile* wf = AllocStruct<WatchedFile>();
-    wf->filePath = str::Dup(filePath);
+    wf->filePath = path::Intern(filePath);
     wf->onFileChangedCb = onFileChangedCb;
     wf->watchedDir = wd;
     wf->isManualCheck = isManualCheck;
 
     ListInsert(&g_watchedFiles, wf);
 
+    CaptureFiredState(wf);
     if (wf->isManualCheck) {
         GetFileState(filePath, &wf->fileState);
         AwakeWatcherThread();
@@ -412,7 +510,6 @@ static WatchedFile* NewWatchedFile(const WCHAR* filePath, const std::function<vo
 }
 
 static void DeleteWatchedFile(WatchedFile* wf) {
-    str::Free(wf->filePath);
     free(wf);
 }
 
@@ -20,26 +20,43 @@ extern "C" {
 
 namespace fitz {
 
-static Gdiplus::Bitmap* ImageFromJpegData(fz_context* ctx, const u8* data, int len) {
+static Gdiplus::Bitmap* ImageFromJpegData(fz_context* ctx, const u8* data, int len, int maxDx, int maxDy) {
     int w = 0, h = 0, xres = 0, yres = 0;
     fz_colorspace* cs = nullptr;
     fz_stream* stm = nullptr;
     uint8_t orient = 0;
+    int l2factor = 0;
 
     fz_var(cs);
     fz_var(stm);
     fz_var(orient);
+    fz_var(l2factor);
 
     fz_try(ctx) {
         fz_load_jpeg_info(ctx, data, len, &w, &h, &xres, &yres, &cs, &orient);
+        // if the result only needs to be maxDx x maxDy big, have the DCT
+        // decoder produce a 1/2, 1/4 or 1/8 size image directly, which
+        // skips most of the decoding work
+        if (maxDx > 0 && maxDy > 0) {
+            while (l2factor < 3 && (w >> (l2factor + 1)) >= maxDx && (h >> (l2factor + 1)) >= maxDy) {
+                l2factor++;
+            }
+        }
         stm = fz_open_memory(ctx, data, len);
-        stm = fz_open_dctd(ctx, stm, -1, 0, nullptr);
+        stm = fz_open_dctd(ctx, stm, -1, l2factor, nullptr);
     }
     fz_catch(ctx) {
         fz_drop_colorspace(ctx, cs);
         cs = nullptr;
     }
 
+    if (l2factor > 0) {
+        // the DCT decoder rounds scaled dimensions up
+        int s = 1 << l2factor;
+        w = (w + s - 1) / s;
+        h = (h + s - 1) / s;
+    }
+
     Gdiplus::PixelFormat fmt = fz_device_rgb(ctx) == cs
                                    ? PixelFormat24bppRGB
                                    : fz_device_gray(ctx) == cs
@@ -189,7 +206,7 @@ static Gdiplus::Bitmap* ImageFromJp2Data(fz_context* ctx, const u8* data, int le
     return bmp.Clone(0, 0, w, h, pixelFormat);
 }
 
-Gdiplus::Bitmap* ImageFromData(std::span<u8> d) {
+Gdiplus::Bitmap* ImageFromData(std::span<u8> d, int maxDx, int maxDy) {
     const u8* data = (const u8*)d.data();
     size_t len = d.size();
     if (len > INT_MAX || len < 12) {
@@ -203,7 +220,7 @@ Gdiplus::Bitmap* ImageFromData(std::span<u8> d) {
 
     Gdiplus::Bitmap* result = nullptr;
     if (str::StartsWith(data, "\xFF\xD8")) {
-        result = ImageFromJpegData(ctx, data, (int)len);
+        result = ImageFromJpegData(ctx, data, (int)len, maxDx, maxDy);
     } else if (memeq(data, "\0\0\0\x0CjP  \x0D\x0A\x87\x0A", 12)) {
         result = ImageFromJp2Data(ctx, data, (int)len);
     }
@@ -218,7 +235,7 @@ Gdiplus::Bitmap* ImageFromData(std::span<u8> d) {
 #else
 
 namespace fitz {
-Gdiplus::Bitmap* ImageFromData(std::span<u8>) {
+Gdiplus::Bitmap* ImageFromData(std::span<u8>, int, int) {
     return nullptr;
 }
 } // namespace fitz
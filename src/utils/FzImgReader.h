@@ -3,5 +3,7 @@
 
 namespace fitz {
 
-Gdiplus::Bitmap* ImageFromData(std::span<u8>);
+// maxDx/maxDy give the size the caller will scale the image down to;
+// JPEGs can then be decoded at a fraction of their full resolution
+Gdiplus::Bitmap* ImageFromData(std::span<u8>, int maxDx = 0, int maxDy = 0);
 }
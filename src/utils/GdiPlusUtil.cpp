@@ -420,19 +420,30 @@ bool IsGdiPlusNativeFormat(std::span<u8> d) {
 }
 
 // see http://stackoverflow.com/questions/4598872/creating-hbitmap-from-memory-buffer/4616394#4616394
-Bitmap* BitmapFromData(std::span<u8> bmpData) {
+Bitmap* BitmapFromData(std::span<u8> bmpData, int maxDx, int maxDy) {
     ImgFormat format = GfxFormatFromData(bmpData);
     if (ImgFormat::TGA == format) {
         return tga::ImageFromData(bmpData);
     }
     if (ImgFormat::WebP == format) {
-        return webp::ImageFromData(bmpData);
+        return webp::ImageFromData(bmpData, maxDx, maxDy);
     }
     if (ImgFormat::JP2 == format) {
         return fitz::ImageFromData(bmpData);
     }
     if (ImgFormat::JPEG == format && JpegUsesArithmeticCoding(bmpData)) {
-        return fitz::ImageFromData(bmpData);
+        return fitz::ImageFromData(bmpData, maxDx, maxDy);
+    }
+    if (ImgFormat::JPEG == format && maxDx > 0 && maxDy > 0) {
+        Size size = BitmapSizeFromData(bmpData);
+        if (size.dx / 2 >= maxDx && size.dy / 2 >= maxDy) {
+            // the DCT decoder can produce a downscaled image directly,
+            // much faster than decoding at full size and scaling in GDI+
+            Bitmap* scaled = fitz::ImageFromData(bmpData, maxDx, maxDy);
+            if (scaled) {
+                return scaled;
+            }
+        }
     }
     if (ImgFormat::PNG == format && PngRequiresPresetDict(bmpData)) {
         return nullptr;
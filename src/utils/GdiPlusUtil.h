@@ -34,7 +34,9 @@ void GetBaseTransform(Gdiplus::Matrix& m, Gdiplus::RectF pageRect, float zoom, i
 
 const WCHAR* GfxFileExtFromData(std::span<u8>);
 bool IsGdiPlusNativeFormat(std::span<u8>);
-Gdiplus::Bitmap* BitmapFromData(std::span<u8>);
+// maxDx/maxDy give the size the image will be scaled down to (if known);
+// they allow JPEGs to be decoded at reduced resolution
+Gdiplus::Bitmap* BitmapFromData(std::span<u8>, int maxDx = 0, int maxDy = 0);
 Size BitmapSizeFromData(std::span<u8>);
 CLSID GetEncoderClsid(const WCHAR* format);
 
@@ -274,16 +274,10 @@ Kind GuessFileTypeFromContent(std::span<u8> d) {
     return nullptr;
 }
 
-static bool IsEpubFile(const WCHAR* path) {
-    AutoDelete<MultiFormatArchive> archive = OpenZipArchive(path, true);
-    if (!archive.Get()) {
-        return false;
-    }
-
+static bool IsEpubArchive(MultiFormatArchive* archive) {
     // assume that if this file exists, this is a epub file
     // https://github.com/sumatrapdfreader/sumatrapdf/issues/1801
-    AutoFree container(archive->GetFileDataByName("META-INF/container.xml"));
-    if (container.data) {
+    if (archive->GetFileId("META-INF/container.xml") != (size_t)-1) {
         return true;
     }
 
@@ -314,20 +308,17 @@ static bool IsEpubFile(const WCHAR* path) {
 
 // check if a given file is a likely a .zip archive containing XPS
 // document
-static bool IsXpsArchive(const WCHAR* path) {
-    MultiFormatArchive* archive = OpenZipArchive(path, true);
-    if (!archive) {
-        return false;
-    }
-
-    bool res = archive->GetFileId("_rels/.rels") != (size_t)-1 ||
-               archive->GetFileId("_rels/.rels/[0].piece") != (size_t)-1 ||
-               archive->GetFileId("_rels/.rels/[0].last.piece") != (size_t)-1;
-    delete archive;
-    return res;
+static bool IsXpsArchive(MultiFormatArchive* archive) {
+    return archive->GetFileId("_rels/.rels") != (size_t)-1 ||
+           archive->GetFileId("_rels/.rels/[0].piece") != (size_t)-1 ||
+           archive->GetFileId("_rels/.rels/[0].last.piece") != (size_t)-1;
 }
 
 // detect file type based on file content
+// reads at most the first 2KB plus, for zip containers, the central
+// directory (at the end of the file) and a single small entry; never
+// the whole file, which matters when scanning directories on slow
+// network shares
 Kind GuessFileTypeFromContent(const WCHAR* path) {
     CrashIf(!path);
 
@@ -348,11 +339,17 @@ Kind GuessFileTypeFromContent(const WCHAR* path) {
     }
     auto res = GuessFileTypeFromContent({(u8*)buf, (size_t)n});
     if (res == kindFileZip) {
-        if (IsXpsArchive(path)) {
-            res = kindFileXps;
-        }
-        if (IsEpubFile(path)) {
-            res = kindFileEpub;
+        // a zip file can be a container for other formats; open the
+        // archive once and decide from its file table, rather than
+        // opening it anew per format checked
+        AutoDelete<MultiFormatArchive> archive = OpenZipArchive(path, true);
+        if (archive.Get()) {
+            if (IsXpsArchive(archive.Get())) {
+                res = kindFileXps;
+            }
+            if (IsEpubArchive(archive.Get())) {
+                res = kindFileEpub;
+            }
         }
     }
     return res;
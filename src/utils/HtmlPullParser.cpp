@@ -2,6 +2,7 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "BaseUtil.h"
+#include <intrin.h> // SSE2 intrinsics
 #include "HtmlParserLookup.h"
 #include "HtmlPullParser.h"
 
@@ -31,7 +32,23 @@ int HtmlEntityNameToRune(const WCHAR* name, size_t nameLen) {
     return FindHtmlEntityRune(asciiName, nameLen);
 }
 
+// this is the parser's inner loop: it scans over whole text runs (to the
+// next '<'), comment bodies and quoted attribute values, so it's worth
+// checking 16 bytes per step. Unaligned loads are fine since the loop
+// never reads past end
 bool SkipUntil(const char*& s, const char* end, char c) {
+    __m128i vc = _mm_set1_epi8(c);
+    while (s + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)s);
+        u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vc));
+        if (mask) {
+            DWORD idx;
+            _BitScanForward(&idx, mask);
+            s += idx;
+            return true;
+        }
+        s += 16;
+    }
     while ((s < end) && (*s != c)) {
         ++s;
     }
@@ -40,10 +57,17 @@ bool SkipUntil(const char*& s, const char* end, char c) {
 
 bool SkipUntil(const char*& s, const char* end, const char* term) {
     size_t len = str::Len(term);
-    for (; s < end; s++) {
+    CrashIf(0 == len);
+    // hop between occurrences of the first character instead of testing
+    // every position
+    while (s < end) {
+        if (!SkipUntil(s, end, *term) || s >= end) {
+            return false;
+        }
         if (s + len <= end && str::StartsWith(s, term)) {
             return true;
         }
+        ++s;
     }
     return false;
 }
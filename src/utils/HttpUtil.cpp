@@ -84,6 +84,125 @@ Error:
     goto Exit;
 }
 
+// downloads the count bytes starting at offset via an HTTP range request
+// returns false if the download failed or the server ignored the Range
+// header and replied with the whole resource (status 200 instead of 206)
+bool HttpGetRange(const WCHAR* url, i64 offset, i64 count, HttpRsp* rspOut) {
+    HINTERNET hReq = nullptr;
+    DWORD infoLevel;
+    DWORD headerBuffSize = sizeof(DWORD);
+    DWORD flags = INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD;
+    AutoFreeWstr hdr(str::Format(L"Range: bytes=%I64d-%I64d\r\n", offset, offset + count - 1));
+
+    rspOut->error = ERROR_SUCCESS;
+    HINTERNET hInet = InternetOpen(USER_AGENT, INTERNET_OPEN_TYPE_PRECONFIG, nullptr, nullptr, 0);
+    if (!hInet) {
+        logf("HttpGetRange: InternetOpen failed\n");
+        LogLastError();
+        goto Error;
+    }
+
+    hReq = InternetOpenUrl(hInet, url, hdr, (DWORD)-1L, flags, 0);
+    if (!hReq) {
+        logf("HttpGetRange: InternetOpenUrl failed\n");
+        LogLastError();
+        goto Error;
+    }
+
+    infoLevel = HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER;
+    if (!HttpQueryInfoW(hReq, infoLevel, &rspOut->httpStatusCode, &headerBuffSize, nullptr)) {
+        logf("HttpGetRange: HttpQueryInfoW failed\n");
+        LogLastError();
+        goto Error;
+    }
+
+    for (;;) {
+        char buf[1024];
+        DWORD dwRead = 0;
+        if (!InternetReadFile(hReq, buf, sizeof(buf), &dwRead)) {
+            logf("HttpGetRange: InternetReadFile failed\n");
+            LogLastError();
+            goto Error;
+        }
+        if (0 == dwRead) {
+            break;
+        }
+        gAllowAllocFailure++;
+        bool ok = rspOut->data.Append(buf, dwRead);
+        gAllowAllocFailure--;
+        if (!ok) {
+            logf("HttpGetRange: data.Append failed\n");
+            goto Error;
+        }
+    }
+
+Exit:
+    if (hReq) {
+        InternetCloseHandle(hReq);
+    }
+    if (hInet) {
+        InternetCloseHandle(hInet);
+    }
+    return (rspOut->error == ERROR_SUCCESS) && (rspOut->httpStatusCode == 206);
+
+Error:
+    rspOut->error = GetLastError();
+    if (0 == rspOut->error) {
+        rspOut->error = ERROR_GEN_FAILURE;
+    }
+    goto Exit;
+}
+
+// determines the size of the resource at url by requesting its first byte
+// and parsing the Content-Range reply ("bytes 0-0/12345")
+// returns -1 if that failed, incl. when the server doesn't support range requests
+i64 HttpGetContentSize(const WCHAR* url) {
+    i64 size = -1;
+    HINTERNET hReq = nullptr;
+    DWORD flags = INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD;
+    DWORD statusCode = 0;
+    DWORD headerBuffSize = sizeof(DWORD);
+    WCHAR buf[256];
+    DWORD bufSize = sizeof(buf);
+    const WCHAR* slash = nullptr;
+    const WCHAR* hdr = L"Range: bytes=0-0\r\n";
+
+    HINTERNET hInet = InternetOpen(USER_AGENT, INTERNET_OPEN_TYPE_PRECONFIG, nullptr, nullptr, 0);
+    if (!hInet) {
+        goto Exit;
+    }
+
+    hReq = InternetOpenUrl(hInet, url, hdr, (DWORD)-1L, flags, 0);
+    if (!hReq) {
+        goto Exit;
+    }
+
+    if (!HttpQueryInfoW(hReq, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &statusCode, &headerBuffSize, nullptr)) {
+        goto Exit;
+    }
+    if (statusCode != 206) {
+        // the server ignored the Range header
+        goto Exit;
+    }
+
+    if (!HttpQueryInfoW(hReq, HTTP_QUERY_CONTENT_RANGE, buf, &bufSize, nullptr)) {
+        goto Exit;
+    }
+    slash = str::FindChar(buf, '/');
+    if (slash) {
+        size = _wtoi64(slash + 1);
+    }
+
+Exit:
+    if (hReq) {
+        InternetCloseHandle(hReq);
+    }
+    if (hInet) {
+        InternetCloseHandle(hInet);
+    }
+    return size;
+}
+
 // Download content of a url to a file
 bool HttpGetToFile(const WCHAR* url, const WCHAR* destFilePath) {
     logf(L"HttpGetToFile: url: '%s', file: '%s'\n", url, destFilePath);
@@ -153,6 +272,103 @@ Exit:
     return ok;
 }
 
+/* downloads url into destFilePath using HTTP range requests, so that an
+   interrupted multi-MB download continues where it left off instead of
+   starting over. The data arrives in 256 KB chunks, up to nConnections of
+   them in flight on the thread pool at a time, and is appended to
+   destFilePath + ".part" strictly in order - that way the partial file's
+   size is exactly the resume offset and no extra bookkeeping file is
+   needed. Only a completed download is moved to destFilePath.
+
+   With trickle set the chunks are requested at background priority with
+   pauses in between, for pre-downloading large files without hogging a
+   slow link. Falls back to HttpGetToFile() when the server doesn't
+   support range requests. Blocks until done; don't call from a thread
+   pool worker */
+bool HttpGetToFileResumable(const WCHAR* url, const WCHAR* destFilePath, int nConnections, bool trickle) {
+    i64 size = HttpGetContentSize(url);
+    if (size < 0) {
+        logf(L"HttpGetToFileResumable: no range support for url: '%s'\n", url);
+        return HttpGetToFile(url, destFilePath);
+    }
+
+    AutoFreeWstr partPath(str::Join(destFilePath, L".part"));
+    i64 done = 0;
+    WIN32_FILE_ATTRIBUTE_DATA fa;
+    if (GetFileAttributesExW(partPath, GetFileExInfoStandard, &fa)) {
+        done = ((i64)fa.nFileSizeHigh << 32) | fa.nFileSizeLow;
+    }
+    if (done > size) {
+        // stale leftover of a different file; start over
+        file::Delete(partPath.Get());
+        done = 0;
+    }
+    logf(L"HttpGetToFileResumable: url: '%s', file: '%s', %I64d of %I64d bytes already here\n", url, destFilePath,
+         done, size);
+
+    HANDLE hf = CreateFileW(partPath, FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+    if (INVALID_HANDLE_VALUE == hf) {
+        LogLastError();
+        return false;
+    }
+
+    const i64 kChunkSize = 256 * 1024;
+    ThreadPool* pool = GetThreadPool();
+    nConnections = limitValue(nConnections, 1, std::min(pool->threadCount, MAX_POOL_THREADS));
+    TaskPriority prio = trickle ? TaskPriority::Background : TaskPriority::Interactive;
+
+    bool ok = true;
+    while (ok && done < size) {
+        // fetch a round of chunks in parallel, then append them in order
+        i64 offs[MAX_POOL_THREADS];
+        i64 lens[MAX_POOL_THREADS];
+        HttpRsp rsps[MAX_POOL_THREADS];
+        bool fetched[MAX_POOL_THREADS] = {};
+        TaskHandle* tasks[MAX_POOL_THREADS] = {};
+        int n = 0;
+        i64 off = done;
+        while (n < nConnections && off < size) {
+            offs[n] = off;
+            lens[n] = std::min(kChunkSize, size - off);
+            off += lens[n];
+            n++;
+        }
+        for (int i = 0; i < n; i++) {
+            HttpRsp* rsp = &rsps[i];
+            bool* fetchedPtr = &fetched[i];
+            i64 chunkOff = offs[i];
+            i64 chunkLen = lens[i];
+            tasks[i] = pool->Submit([=] { *fetchedPtr = HttpGetRange(url, chunkOff, chunkLen, rsp); }, prio);
+        }
+        for (int i = 0; i < n; i++) {
+            tasks[i]->Wait();
+            DropTaskHandle(tasks[i]);
+        }
+        for (int i = 0; ok && i < n; i++) {
+            ok = fetched[i] && (i64)rsps[i].data.size() == lens[i];
+            if (ok) {
+                DWORD written = 0;
+                ok = WriteFile(hf, rsps[i].data.Get(), (DWORD)lens[i], &written, nullptr) && written == (DWORD)lens[i];
+            }
+            if (ok) {
+                done += lens[i];
+            }
+        }
+        if (ok && trickle && done < size) {
+            Sleep(500);
+        }
+    }
+    CloseHandle(hf);
+
+    if (!ok) {
+        // keep the .part file: the next attempt picks up at its size
+        logf(L"HttpGetToFileResumable: failed at %I64d of %I64d bytes\n", done, size);
+        return false;
+    }
+    return MoveFileExW(partPath, destFilePath, MOVEFILE_REPLACE_EXISTING);
+}
+
 bool HttpPost(const WCHAR* server, int port, const WCHAR* url, str::Str* headers, str::Str* data) {
     str::Str resp(2048);
     bool ok = false;
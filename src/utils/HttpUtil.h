@@ -16,6 +16,9 @@ bool HttpRspOk(const HttpRsp*);
 
 bool HttpPost(const WCHAR* server, int port, const WCHAR* url, str::Str* headers, str::Str* data);
 bool HttpGet(const WCHAR* url, HttpRsp* rspOut);
+bool HttpGetRange(const WCHAR* url, i64 offset, i64 count, HttpRsp* rspOut);
+i64 HttpGetContentSize(const WCHAR* url);
 bool HttpGetToFile(const WCHAR* url, const WCHAR* destFilePath);
+bool HttpGetToFileResumable(const WCHAR* url, const WCHAR* destFilePath, int nConnections = 3, bool trickle = false);
 // void  HttpGetAsync(const char *url, const std::function<void(HttpRsp *)> &);
 void HttpGetAsync(const WCHAR* url, const std::function<void(HttpRsp*)>&);
@@ -0,0 +1,132 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "utils/BaseUtil.h"
+#include "utils/ThreadUtil.h"
+#include "utils/Timer.h"
+#include "utils/IdleTask.h"
+
+namespace idletask {
+
+/* A cooperative scheduler for deferred work on the UI thread. Subsystems
+   used to invent their own one-shot timers and wake-up messages for work
+   that just has to happen "later, when the user isn't looking" (deferred
+   startup init, cache warm-up, index builds). An idle task instead runs
+   from the message loop once the queue is empty, in priority order and
+   under a time budget, so input is never delayed by more than one
+   increment. */
+
+struct IdleTask {
+    const char* name = nullptr;
+    Priority prio = Priority::Normal;
+    // empty once the task has finished; kept for FmtReport()
+    std::function<bool()> fn;
+
+    int runs = 0;
+    double totalMs = 0;
+};
+
+// all tasks ever registered, in registration order; finished ones stay
+// so that their accumulated timing remains reportable
+static Vec<IdleTask*> gTasks;
+// Register() may be called from any thread; everything else is UI-thread
+static Mutex gTasksLock;
+
+static const char* gLastRunName = nullptr;
+static double gLastRunMs = 0;
+
+void Register(const char* name, Priority prio, const std::function<bool()>& fn) {
+    CrashIf(!name || !fn);
+    auto* task = new IdleTask();
+    task->name = name;
+    task->prio = prio;
+    task->fn = fn;
+    gTasksLock.Lock();
+    gTasks.Append(task);
+    gTasksLock.Unlock();
+}
+
+bool HasPendingTasks() {
+    ScopedCritSec cs(&gTasksLock.cs);
+    for (IdleTask* task : gTasks) {
+        if (task->fn) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the pending task with the highest priority; among equals the one that
+// has run the least recently (NextTask rotates the ties, see RunSlice)
+static IdleTask* NextTask() {
+    IdleTask* best = nullptr;
+    for (IdleTask* task : gTasks) {
+        if (!task->fn) {
+            continue;
+        }
+        if (!best || task->prio < best->prio) {
+            best = task;
+        }
+    }
+    return best;
+}
+
+bool RunSlice(int budgetMs) {
+    auto sliceStart = TimeGet();
+    for (;;) {
+        gTasksLock.Lock();
+        IdleTask* task = NextTask();
+        if (task) {
+            // move to the end so that equal-priority tasks round-robin
+            gTasks.Remove(task);
+            gTasks.Append(task);
+        }
+        gTasksLock.Unlock();
+        if (!task) {
+            return false;
+        }
+
+        auto t = TimeGet();
+        bool again = task->fn();
+        double durMs = TimeSinceInMs(t);
+        task->runs++;
+        task->totalMs += durMs;
+        gLastRunName = task->name;
+        gLastRunMs = durMs;
+        if (!again) {
+            task->fn = {};
+        }
+
+        if (TimeSinceInMs(sliceStart) >= (double)budgetMs) {
+            return HasPendingTasks();
+        }
+        // yield to freshly arrived input even if budget remains
+        if (GetQueueStatus(QS_ALLINPUT) != 0) {
+            return HasPendingTasks();
+        }
+    }
+}
+
+const char* LastRunTaskName() {
+    return gLastRunName;
+}
+
+double LastRunTaskMs() {
+    return gLastRunMs;
+}
+
+void FmtReport(str::Str& s) {
+    ScopedCritSec cs(&gTasksLock.cs);
+    s.Append("Idle tasks:\n");
+    for (IdleTask* task : gTasks) {
+        s.AppendFmt("  %-24s %4d runs %8.2f ms total%s\n", task->name, task->runs, task->totalMs,
+                    task->fn ? " (pending)" : "");
+    }
+}
+
+void Destroy() {
+    ScopedCritSec cs(&gTasksLock.cs);
+    DeleteVecMembers(gTasks);
+}
+
+} // namespace idletask
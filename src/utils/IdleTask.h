@@ -0,0 +1,31 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+namespace idletask {
+
+// tasks of a higher priority always run before lower ones
+enum class Priority { High = 0, Normal, Low };
+
+// registers fn to run on the UI thread once the message loop goes idle.
+// fn returns true to be scheduled again for a later slice (so that long
+// work can be split into budget-sized increments) and false when done.
+// name must outlive the task (usually a literal); it shows up in the
+// perf HUD and in FmtReport()
+void Register(const char* name, Priority prio, const std::function<bool()>& fn);
+
+bool HasPendingTasks();
+
+// runs pending tasks for at most budgetMs, yielding as soon as input
+// arrives; returns true if tasks remain. Only the message loop calls this
+bool RunSlice(int budgetMs);
+
+// name / duration of the most recently run increment, for the perf HUD
+const char* LastRunTaskName();
+double LastRunTaskMs();
+
+// appends a line of accumulated timing per task, including finished ones
+void FmtReport(str::Str& s);
+
+void Destroy();
+
+} // namespace idletask
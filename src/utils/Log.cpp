@@ -16,9 +16,17 @@ bool logToDebugger = false;
 
 static char* logFilePath;
 
+// how much of gLogBuf has already been written to logFilePath
+static size_t gLogBufFlushed = 0;
+static HANDLE gFlushLogEvent = nullptr;
+
 // 1 MB - 128 to stay under 1 MB even after appending (an estimate)
 constexpr int kMaxLogBuf = 1024 * 1024 - 128;
 
+// the flusher thread writes at least this often, sooner when a lot is pending
+constexpr DWORD kFlushLogEveryMs = 500;
+constexpr size_t kFlushLogThresholdBytes = 16 * 1024;
+
 static bool shouldLog() {
     gLogMutex.Lock();
     bool bufFull = gLogBuf && gLogBuf->isize() > kMaxLogBuf;
@@ -48,13 +56,9 @@ void log(std::string_view s) {
         fflush(stderr);
     }
 
-    if (logFilePath) {
-        auto f = fopen(logFilePath, "a");
-        if (f != nullptr) {
-            fwrite(s.data(), 1, s.size(), f);
-            fflush(f);
-            fclose(f);
-        }
+    if (logFilePath && gLogBuf->size() - gLogBufFlushed >= kFlushLogThresholdBytes) {
+        // wake the flusher early, a lot has accumulated
+        SetEvent(gFlushLogEvent);
     }
     if (logToDebugger) {
         OutputDebugStringA(s.data());
@@ -78,9 +82,52 @@ void logf(const char* fmt, ...) {
     va_end(args);
 }
 
+// appends what accumulated in gLogBuf since the last flush to the log
+// file. File i/o happens on the flusher thread (plus once more at exit
+// and after a crash) so that log calls in hot paths don't pay for it
+void FlushLogToFile() {
+    gLogMutex.Lock();
+    defer {
+        gLogMutex.Unlock();
+    };
+    if (!logFilePath || !gLogBuf) {
+        return;
+    }
+    size_t n = gLogBuf->size();
+    if (n <= gLogBufFlushed) {
+        return;
+    }
+    auto f = fopen(logFilePath, "a");
+    if (f != nullptr) {
+        fwrite(gLogBuf->Get() + gLogBufFlushed, 1, n - gLogBufFlushed, f);
+        fflush(f);
+        fclose(f);
+        gLogBufFlushed = n;
+    }
+}
+
+static DWORD WINAPI LogFlusherThread([[maybe_unused]] LPVOID data) {
+    SetThreadName(GetCurrentThreadId(), "LogFlusher");
+    for (;;) {
+        WaitForSingleObject(gFlushLogEvent, kFlushLogEveryMs);
+        FlushLogToFile();
+    }
+}
+
 void StartLogToFile(const char* path) {
-    logFilePath = str::Dup(path);
+    gFlushLogEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
     remove(path);
+    // only log calls made from here on end up in the file
+    gLogMutex.Lock();
+    gLogBufFlushed = gLogBuf ? gLogBuf->size() : 0;
+    logFilePath = str::Dup(path);
+    gLogMutex.Unlock();
+    HANDLE h = CreateThread(nullptr, 0, LogFlusherThread, nullptr, 0, nullptr);
+    if (h != nullptr) {
+        CloseHandle(h);
+    }
+    // make sure the tail makes it to disk on a clean exit
+    atexit(FlushLogToFile);
 }
 
 #if OS_WIN
@@ -6,6 +6,7 @@ extern str::Str* gLogBuf;
 extern bool logToStderr;
 extern bool logToDebugger;
 void StartLogToFile(const char* path);
+void FlushLogToFile();
 
 /*
 If you do:
@@ -0,0 +1,190 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "utils/BaseUtil.h"
+
+#include <psapi.h>
+
+#include "utils/MemAccounting.h"
+
+namespace memacct {
+
+static const char* gSubsysNames[SubsysCount] = {
+    "render cache",
+    "mupdf",
+    "text cache",
+    "dib pool",
+};
+
+static volatile LONG64 gCurrent[SubsysCount]{};
+static volatile LONG64 gPeak[SubsysCount]{};
+
+void Add(Subsystem subsys, i64 bytes) {
+    CrashIf(subsys < 0 || subsys >= SubsysCount);
+    // InterlockedAdd64 isn't available on x86, InterlockedExchangeAdd64 is
+    LONG64 curr = InterlockedExchangeAdd64(&gCurrent[subsys], bytes) + bytes;
+    for (;;) {
+        LONG64 peak = gPeak[subsys];
+        if (curr <= peak) {
+            return;
+        }
+        if (InterlockedCompareExchange64(&gPeak[subsys], curr, peak) == peak) {
+            return;
+        }
+    }
+}
+
+i64 GetCurrent(Subsystem subsys) {
+    CrashIf(subsys < 0 || subsys >= SubsysCount);
+    return gCurrent[subsys];
+}
+
+i64 GetPeak(Subsystem subsys) {
+    CrashIf(subsys < 0 || subsys >= SubsysCount);
+    return gPeak[subsys];
+}
+
+const char* SubsysName(Subsystem subsys) {
+    CrashIf(subsys < 0 || subsys >= SubsysCount);
+    return gSubsysNames[subsys];
+}
+
+i64 GetProcessPrivateBytes() {
+    PROCESS_MEMORY_COUNTERS_EX pmc{};
+    pmc.cb = sizeof(pmc);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
+        return 0;
+    }
+    return (i64)pmc.PrivateUsage;
+}
+
+struct MemSample {
+    DWORD tick = 0;
+    u64 workingSetKB = 0;
+    u64 privateKB = 0;
+};
+
+#define MEM_SAMPLE_COUNT 16
+#define MEM_SAMPLE_INTERVAL_MS (10 * 1000)
+
+// ring buffer of the most recent samples; only the sampler thread (and,
+// once it's gone, the reporting code) writes to it
+static MemSample gSamples[MEM_SAMPLE_COUNT];
+static int gSampleIdx = 0;
+static int gSampleCount = 0;
+
+static HANDLE gSamplerThread = nullptr;
+static HANDLE gSamplerQuitEvent = nullptr;
+
+static void TakeSample() {
+    PROCESS_MEMORY_COUNTERS_EX pmc{};
+    pmc.cb = sizeof(pmc);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
+        return;
+    }
+    MemSample* s = &gSamples[gSampleIdx];
+    s->tick = GetTickCount();
+    s->workingSetKB = pmc.WorkingSetSize / 1024;
+    s->privateKB = pmc.PrivateUsage / 1024;
+    gSampleIdx = (gSampleIdx + 1) % MEM_SAMPLE_COUNT;
+    if (gSampleCount < MEM_SAMPLE_COUNT) {
+        gSampleCount++;
+    }
+}
+
+static DWORD WINAPI SamplerThread([[maybe_unused]] LPVOID data) {
+    for (;;) {
+        TakeSample();
+        DWORD res = WaitForSingleObject(gSamplerQuitEvent, MEM_SAMPLE_INTERVAL_MS);
+        if (WAIT_TIMEOUT != res) {
+            return 0;
+        }
+    }
+}
+
+void StartSampler() {
+    if (gSamplerThread) {
+        return;
+    }
+    gSamplerQuitEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    gSamplerThread = CreateThread(nullptr, 0, SamplerThread, nullptr, 0, nullptr);
+}
+
+void StopSampler() {
+    if (!gSamplerThread) {
+        return;
+    }
+    SetEvent(gSamplerQuitEvent);
+    WaitForSingleObject(gSamplerThread, 1000);
+    CloseHandle(gSamplerThread);
+    gSamplerThread = nullptr;
+    CloseHandle(gSamplerQuitEvent);
+    gSamplerQuitEvent = nullptr;
+}
+
+void FmtReport(str::Str& s) {
+    s.Append("Mem usage:\n");
+    for (int i = 0; i < SubsysCount; i++) {
+        i64 currKB = gCurrent[i] / 1024;
+        i64 peakKB = gPeak[i] / 1024;
+        s.AppendFmt("  %-12s %8d KB (peak %d KB)\n", gSubsysNames[i], (int)currKB, (int)peakKB);
+    }
+    // record the state right now as the newest sample
+    TakeSample();
+    DWORD now = GetTickCount();
+    int idx = (gSampleIdx - gSampleCount + MEM_SAMPLE_COUNT) % MEM_SAMPLE_COUNT;
+    for (int i = 0; i < gSampleCount; i++) {
+        MemSample* sample = &gSamples[idx];
+        DWORD agoSecs = (now - sample->tick) / 1000;
+        s.AppendFmt("  %3d s ago: working set %d KB, private %d KB\n", (int)agoSecs, (int)sample->workingSetKB,
+                    (int)sample->privateKB);
+        idx = (idx + 1) % MEM_SAMPLE_COUNT;
+    }
+}
+
+} // namespace memacct
+
+// header stored in front of each allocation; 16 bytes keep the returned
+// pointer as aligned as malloc() would
+struct CountingAllocHeader {
+    size_t size;
+    size_t unused;
+};
+
+CountingAllocator::CountingAllocator(memacct::Subsystem subsys) {
+    this->subsys = subsys;
+}
+
+void* CountingAllocator::Alloc(size_t size) {
+    auto h = (CountingAllocHeader*)malloc(sizeof(CountingAllocHeader) + size);
+    if (!h) {
+        return nullptr;
+    }
+    h->size = size;
+    memacct::Add(subsys, (i64)size);
+    return h + 1;
+}
+
+void* CountingAllocator::Realloc(void* mem, size_t size) {
+    if (!mem) {
+        return Alloc(size);
+    }
+    auto h = (CountingAllocHeader*)mem - 1;
+    i64 oldSize = (i64)h->size;
+    h = (CountingAllocHeader*)realloc(h, sizeof(CountingAllocHeader) + size);
+    if (!h) {
+        return nullptr;
+    }
+    h->size = size;
+    memacct::Add(subsys, (i64)size - oldSize);
+    return h + 1;
+}
+
+void CountingAllocator::Free(const void* mem) {
+    if (!mem) {
+        return;
+    }
+    auto h = (CountingAllocHeader*)mem - 1;
+    memacct::Add(subsys, -(i64)h->size);
+    free(h);
+}
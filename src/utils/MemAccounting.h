@@ -0,0 +1,53 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+/* Live-byte accounting for the subsystems that dominate memory use, so
+   that an OOM crash report can say whether rendered bitmaps, mupdf
+   objects or extracted text are responsible. Subsystems call
+   memacct::Add() with a positive size when they allocate and a negative
+   one when they free; code that already goes through the Allocator
+   abstraction can use CountingAllocator instead. */
+
+namespace memacct {
+
+enum Subsystem {
+    SubsysRenderCache = 0, // rendered bitmaps kept by RenderCache
+    SubsysMupdf,           // everything allocated through a fz_context
+    SubsysTextCache,       // extracted page text (DocumentTextCache)
+    SubsysDibPool,         // idle DIB sections kept for reuse (DibPool)
+    SubsysCount
+};
+
+// bytes < 0 records a free; thread-safe
+void Add(Subsystem subsys, i64 bytes);
+i64 GetCurrent(Subsystem subsys);
+i64 GetPeak(Subsystem subsys);
+const char* SubsysName(Subsystem subsys);
+
+// the process' current private bytes (what would leak to the pagefile),
+// 0 if the query fails
+i64 GetProcessPrivateBytes();
+
+// samples the process working set / private bytes every few seconds on
+// a background thread, so that a report shows the recent trend and not
+// just the state at crash time
+void StartSampler();
+void StopSampler();
+
+// appends the per-subsystem breakdown and the recent process samples;
+// must stay safe to call from the crash handler
+void FmtReport(str::Str& s);
+
+} // namespace memacct
+
+// an Allocator that counts live bytes against a subsystem; allocations
+// carry a small header so that Realloc()/Free() know their size
+struct CountingAllocator : Allocator {
+    memacct::Subsystem subsys;
+
+    explicit CountingAllocator(memacct::Subsystem subsys);
+
+    void* Alloc(size_t size) override;
+    void* Realloc(void* mem, size_t size) override;
+    void Free(const void* mem) override;
+};
@@ -237,23 +237,26 @@ void Fmt::serializeInst(int n) {
     if (!isOk) {
         return;
     }
+    // numbers and short strings are serialized via stack buffers,
+    // AppendFmt() / WstrToUtf8() would allocate a temporary string per arg
+    char buf[128];
     switch (tArg) {
         case Type::Char:
             res.AppendChar(arg.c);
             break;
         case Type::Int:
-            // TODO: using AppendFmt is cheating
-            res.AppendFmt("%d", arg.i);
+            str::BufFmt(buf, dimof(buf), "%d", arg.i);
+            res.Append(buf);
             break;
         case Type::Float:
-            // TODO: using AppendFmt is cheating
             // Note: %G, unlike %f, avoid trailing '0'
-            res.AppendFmt("%G", arg.f);
+            str::BufFmt(buf, dimof(buf), "%G", arg.f);
+            res.Append(buf);
             break;
         case Type::Double:
-            // TODO: using AppendFmt is cheating
             // Note: %G, unlike %f, avoid trailing '0'
-            res.AppendFmt("%G", arg.d);
+            str::BufFmt(buf, dimof(buf), "%G", arg.d);
+            res.Append(buf);
             break;
         case Type::FormatStr:
             CrashIf(arg.len == 0);
@@ -263,8 +266,14 @@ void Fmt::serializeInst(int n) {
             res.Append(arg.s);
             break;
         case Type::WStr:
-            auto sUtf8 = strconv::WstrToUtf8(arg.ws);
-            res.AppendAndFree(sUtf8.data());
+            // worst case: 3 UTF-8 bytes per UTF-16 code unit
+            if (str::Len(arg.ws) * 3 < dimof(buf)) {
+                strconv::WcharToUtf8Buf(arg.ws, buf, dimof(buf));
+                res.Append(buf);
+            } else {
+                auto sUtf8 = strconv::WstrToUtf8(arg.ws);
+                res.AppendAndFree(sUtf8.data());
+            }
             break;
     };
 }
@@ -286,17 +295,56 @@ char* Fmt::GetDup() {
     return str::Dup(Get());
 }
 
-std::string_view Format([[maybe_unused]] const char* s, [[maybe_unused]] Arg& a1) {
-    return {};
+static void addArg(Fmt& fmt, const Arg& arg) {
+    switch (arg.t) {
+        case Type::Char:
+            fmt.c(arg.c);
+            break;
+        case Type::Int:
+            fmt.i(arg.i);
+            break;
+        case Type::Float:
+            fmt.f(arg.f);
+            break;
+        case Type::Double:
+            fmt.f(arg.d);
+            break;
+        case Type::Str:
+            fmt.s(arg.s);
+            break;
+        case Type::WStr:
+            fmt.s(arg.ws);
+            break;
+        default:
+            CrashIf(true);
+    }
+}
+
+// Fmt lives on the stack and parsing only fills its inline arrays, so
+// the only allocation is the returned copy (and growing Fmt::res past
+// its inline buffer for long results). The result must be free()d.
+std::string_view Format(const char* s, const Arg& a1) {
+    Fmt fmt(s);
+    addArg(fmt, a1);
+    char* res = fmt.GetDup();
+    return {res, str::Len(res)};
 }
 
-std::string_view Format([[maybe_unused]] const char* s, [[maybe_unused]] Arg& a1, [[maybe_unused]] Arg& a2) {
-    return {};
+std::string_view Format(const char* s, const Arg& a1, const Arg& a2) {
+    Fmt fmt(s);
+    addArg(fmt, a1);
+    addArg(fmt, a2);
+    char* res = fmt.GetDup();
+    return {res, str::Len(res)};
 }
 
-std::string_view Format([[maybe_unused]] const char* s, [[maybe_unused]] Arg& a1, [[maybe_unused]] Arg& a2,
-                        [[maybe_unused]] Arg& a3) {
-    return {};
+std::string_view Format(const char* s, const Arg& a1, const Arg& a2, const Arg& a3) {
+    Fmt fmt(s);
+    addArg(fmt, a1);
+    addArg(fmt, a2);
+    addArg(fmt, a3);
+    char* res = fmt.GetDup();
+    return {res, str::Len(res)};
 }
 
 } // namespace fmt
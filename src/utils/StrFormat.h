@@ -90,6 +90,18 @@ struct Arg {
         t = Type::WStr;
         ws = arg;
     }
+    Arg(char arg) {
+        t = Type::Char;
+        c = arg;
+    }
+    Arg(float arg) {
+        t = Type::Float;
+        f = arg;
+    }
+    Arg(double arg) {
+        t = Type::Double;
+        d = arg;
+    }
 };
 
 class Fmt {
@@ -130,7 +142,8 @@ class Fmt {
     str::Str res;
 };
 
-std::string_view Format(const char* s, Arg& a1);
-std::string_view Format(const char* s, Arg& a1, Arg& a2);
-std::string_view Format(const char* s, Arg& a1, Arg& a2, Arg& a3);
+// one-shot formatting for up to 3 args; the returned string must be free()d
+std::string_view Format(const char* s, const Arg& a1);
+std::string_view Format(const char* s, const Arg& a1, const Arg& a2);
+std::string_view Format(const char* s, const Arg& a1, const Arg& a2, const Arg& a3);
 } // namespace fmt
@@ -497,6 +497,14 @@ bool BufFmtV(char* buf, size_t bufCchSize, const char* fmt, va_list args) {
     return false;
 }
 
+bool BufFmt(char* buf, size_t bufCchSize, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    bool ok = BufFmtV(buf, bufCchSize, fmt, args);
+    va_end(args);
+    return ok;
+}
+
 // TODO: need to finish StrFormat and use it instead.
 char* FmtV(const char* fmt, va_list args) {
     char message[256] = {0};
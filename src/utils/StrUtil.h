@@ -92,6 +92,7 @@ const char* FindI(const char* str, const char* find);
 bool Contains(std::string_view s, const char* txt);
 
 bool BufFmtV(char* buf, size_t bufCchSize, const char* fmt, va_list args);
+bool BufFmt(char* buf, size_t bufCchSize, const char* fmt, ...);
 char* FmtV(const char* fmt, va_list args);
 char* Format(const char* fmt, ...);
 
@@ -100,6 +101,8 @@ const WCHAR* FindChar(const WCHAR* str, WCHAR c);
 WCHAR* FindChar(WCHAR* str, WCHAR c);
 const WCHAR* FindCharLast(const WCHAR* str, WCHAR c);
 WCHAR* FindCharLast(WCHAR* str, WCHAR c);
+// vectorized (SSE2/AVX2) scan for the first occurrence of c1 or c2
+const WCHAR* FindChar2(const WCHAR* str, WCHAR c1, WCHAR c2);
 const WCHAR* Find(const WCHAR* str, const WCHAR* find);
 
 const WCHAR* FindI(const WCHAR* str, const WCHAR* find);
@@ -149,6 +152,7 @@ WCHAR* FormatNumWithThousandSep(size_t num, LCID locale = LOCALE_USER_DEFAULT);
 WCHAR* FormatRomanNumeral(int number);
 
 int CmpNatural(const WCHAR*, const WCHAR*);
+void SortNatural(WCHAR** strings, size_t n);
 
 const WCHAR* Parse(const WCHAR* str, const WCHAR* format, ...);
 bool IsStringEmptyOrWhiteSpaceOnly(std::string_view sv);
@@ -2,6 +2,12 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "BaseUtil.h"
+#include "ThreadUtil.h"
+
+#if IS_INTEL_32 || IS_INTEL_64
+#include <intrin.h>    // __cpuid, _xgetbv
+#include <immintrin.h> // SSE2 / AVX2 intrinsics
+#endif
 
 namespace str {
 
@@ -165,6 +171,138 @@ WCHAR* FindCharLast(WCHAR* str, const WCHAR c) {
     return wcsrchr(str, c);
 }
 
+#if (IS_INTEL_32 || IS_INTEL_64) && !defined(__SANITIZE_ADDRESS__)
+
+// AVX2 needs support from both the CPU and the OS (the OS must
+// save the ymm registers on context switches)
+static bool DetectAvx2() {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+    // xmm and ymm state must both be enabled in XCR0
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+static const bool gHasAvx2 = DetectAvx2();
+
+// the vector loops below only do aligned loads, so that they can't
+// cross a page boundary even when they read past the terminating 0
+
+static const WCHAR* FindChar2Sse2(const WCHAR* s, WCHAR c1, WCHAR c2) {
+    while (((uintptr_t)s & 15) != 0) {
+        WCHAR c = *s;
+        if (0 == c) {
+            return nullptr;
+        }
+        if (c == c1 || c == c2) {
+            return s;
+        }
+        s++;
+    }
+    __m128i v1 = _mm_set1_epi16((short)c1);
+    __m128i v2 = _mm_set1_epi16((short)c2);
+    __m128i vz = _mm_setzero_si128();
+    for (;;) {
+        __m128i chunk = _mm_load_si128((const __m128i*)s);
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi16(chunk, v1), _mm_cmpeq_epi16(chunk, v2));
+        u32 hitsMask = (u32)_mm_movemask_epi8(hits);
+        u32 endMask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi16(chunk, vz));
+        if (endMask) {
+            // ignore hits past the terminating 0
+            hitsMask &= endMask - 1;
+        }
+        if (hitsMask) {
+            DWORD idx;
+            _BitScanForward(&idx, hitsMask);
+            return s + (idx / 2); // the mask has 2 bits per WCHAR
+        }
+        if (endMask) {
+            return nullptr;
+        }
+        s += 8;
+    }
+}
+
+static const WCHAR* FindChar2Avx2(const WCHAR* s, WCHAR c1, WCHAR c2) {
+    while (((uintptr_t)s & 31) != 0) {
+        WCHAR c = *s;
+        if (0 == c) {
+            return nullptr;
+        }
+        if (c == c1 || c == c2) {
+            return s;
+        }
+        s++;
+    }
+    __m256i v1 = _mm256_set1_epi16((short)c1);
+    __m256i v2 = _mm256_set1_epi16((short)c2);
+    __m256i vz = _mm256_setzero_si256();
+    for (;;) {
+        __m256i chunk = _mm256_load_si256((const __m256i*)s);
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi16(chunk, v1), _mm256_cmpeq_epi16(chunk, v2));
+        u32 hitsMask = (u32)_mm256_movemask_epi8(hits);
+        u32 endMask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi16(chunk, vz));
+        if (endMask) {
+            // ignore hits past the terminating 0
+            hitsMask &= endMask - 1;
+        }
+        if (hitsMask) {
+            DWORD idx;
+            _BitScanForward(&idx, hitsMask);
+            return s + (idx / 2); // the mask has 2 bits per WCHAR
+        }
+        if (endMask) {
+            return nullptr;
+        }
+        s += 16;
+    }
+}
+
+#endif // (IS_INTEL_32 || IS_INTEL_64) && !defined(__SANITIZE_ADDRESS__)
+
+// returns the first occurrence of either c1 or c2 in str (which must
+// both be non-0). This is the vectorized scanning kernel behind FindI
+// and TextSearch: comparing whole registers of characters at a time
+// beats folding and comparing them one by one
+const WCHAR* FindChar2(const WCHAR* str, WCHAR c1, WCHAR c2) {
+    CrashIf(!c1 || !c2);
+#if defined(__SANITIZE_ADDRESS__)
+    // the vector kernels read (aligned, hence page-safe) past the end of
+    // the string, which ASan would report for heap allocations
+    for (; *str; str++) {
+        if (*str == c1 || *str == c2) {
+            return str;
+        }
+    }
+    return nullptr;
+#elif IS_INTEL_32 || IS_INTEL_64
+    if (gHasAvx2) {
+        return FindChar2Avx2(str, c1, c2);
+    }
+    // SSE2 is part of the x64 baseline and we require it on x86
+    return FindChar2Sse2(str, c1, c2);
+#else
+    for (; *str; str++) {
+        if (*str == c1 || *str == c2) {
+            return str;
+        }
+    }
+    return nullptr;
+#endif
+}
+
 const WCHAR* Find(const WCHAR* str, const WCHAR* find) {
     return wcsstr(str, find);
 }
@@ -178,6 +316,22 @@ const WCHAR* FindI(const WCHAR* s, const WCHAR* toFind) {
     if (!first) {
         return s;
     }
+    if (first < 0x80) {
+        // scan for the two case variants of the first character with the
+        // vectorized kernel, then verify candidates. For ASCII these two
+        // are the only characters towlower() folds onto <first>
+        WCHAR up = towupper(first);
+        for (;;) {
+            s = FindChar2(s, first, up);
+            if (!s) {
+                return nullptr;
+            }
+            if (str::StartsWithI(s, toFind)) {
+                return s;
+            }
+            s++;
+        }
+    }
     while (*s) {
         WCHAR c = towlower(*s);
         if (c == first) {
@@ -552,6 +706,161 @@ int CmpNatural(const WCHAR* a, const WCHAR* b) {
     return diff;
 }
 
+/* builds a collation key for CmpNatural(): every character becomes a category
+   (whitespace/special < digit run < letter) followed by a value, with a digit
+   run encoded as its magnitude followed by the digits (leading zeroes
+   stripped), so that wcscmp() on two keys gives the same order as
+   CmpNatural() on the strings. Naturally equal strings get equal keys; the
+   caller breaks those ties with wcscmp() on the originals, same as
+   CmpNatural(). Returns nullptr for the rare string the encoding can't
+   represent (whitespace other than plain spaces, absurdly long digit runs);
+   those fall back to CmpNatural() */
+static WCHAR* NaturalSortKey(const WCHAR* s) {
+    size_t len = Len(s);
+    // worst case is a lone digit: three key characters per character
+    WCHAR* key = AllocArray<WCHAR>(3 * len + 1);
+    WCHAR* dst = key;
+    const WCHAR* c = s;
+    // leading whitespace is ignored
+    for (; ' ' == *c; c++) {
+        // do nothing
+    }
+    while (*c) {
+        WCHAR ch = *c;
+        if (' ' == ch) {
+            // a whitespace run compares equal to any other whitespace run
+            for (; ' ' == *c; c++) {
+                // do nothing
+            }
+            if (!*c) {
+                // trailing whitespace is ignored
+                break;
+            }
+            *dst++ = 1;
+            *dst++ = ' ';
+            continue;
+        }
+        if (IsWs(ch)) {
+            // only space runs collapse losslessly into the key
+            free(key);
+            return nullptr;
+        }
+        if (IsDigit(ch)) {
+            // ignore leading zeroes
+            for (; '0' == *c; c++) {
+                // do nothing
+            }
+            const WCHAR* digits = c;
+            for (; IsDigit(*c); c++) {
+                // do nothing
+            }
+            size_t n = c - digits;
+            if (n > 0xff00) {
+                free(key);
+                return nullptr;
+            }
+            *dst++ = 2;
+            *dst++ = (WCHAR)(n + 1);
+            memcpy(dst, digits, n * sizeof(WCHAR));
+            dst += n;
+            continue;
+        }
+        if (iswalnum(ch)) {
+            *dst++ = 3;
+            *dst++ = (WCHAR)towlower(ch);
+        } else {
+            *dst++ = 1;
+            *dst++ = ch;
+        }
+        c++;
+    }
+    *dst = 0;
+    return key;
+}
+
+/* sorts strings in CmpNatural() order. CmpNatural() re-parses digit runs on
+   every call, which makes qsort() with it take seconds for the ~20000 file
+   names of a big image directory; instead a collation key is built once per
+   string so that comparisons are a plain wcscmp(), and both the key building
+   and the sorting of chunks is spread over the shared thread pool. The
+   sorted chunks are merged on the calling thread */
+void SortNatural(WCHAR** strings, size_t n) {
+    if (n < 2) {
+        return;
+    }
+
+    struct KeyedStr {
+        WCHAR* s;
+        WCHAR* key;
+    };
+    auto cmpLess = [](const KeyedStr& x, const KeyedStr& y) {
+        int diff;
+        if (x.key && y.key) {
+            diff = wcscmp(x.key, y.key);
+            if (0 == diff) {
+                // equal keys mean naturally equal; stable order like CmpNatural()
+                diff = wcscmp(x.s, y.s);
+            }
+        } else {
+            diff = CmpNatural(x.s, y.s);
+        }
+        return diff < 0;
+    };
+
+    KeyedStr* items = AllocArray<KeyedStr>(n);
+    for (size_t i = 0; i < n; i++) {
+        items[i].s = strings[i];
+    }
+
+    auto keyAndSortChunk = [items, cmpLess](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            items[i].key = NaturalSortKey(items[i].s);
+        }
+        std::sort(items + lo, items + hi, cmpLess);
+    };
+
+    // below a few thousand entries the keys pay off but farming chunks out
+    // doesn't, so only go parallel for directory-sized inputs
+    size_t chunkSize = n;
+    int nChunks = 1;
+    ThreadPool* pool = GetThreadPool();
+    if (n >= 4096 && pool->threadCount > 1) {
+        nChunks = std::min(pool->threadCount, (int)(n / 1024));
+        chunkSize = (n + nChunks - 1) / nChunks;
+    }
+
+    if (1 == nChunks) {
+        keyAndSortChunk(0, n);
+    } else {
+        TaskHandle* tasks[MAX_POOL_THREADS] = {};
+        for (int chunk = 1; chunk < nChunks; chunk++) {
+            size_t lo = chunk * chunkSize;
+            size_t hi = std::min(lo + chunkSize, n);
+            tasks[chunk] = pool->Submit([keyAndSortChunk, lo, hi] { keyAndSortChunk(lo, hi); },
+                                        TaskPriority::Interactive);
+        }
+        // the calling thread handles the first chunk instead of idling
+        keyAndSortChunk(0, chunkSize);
+        for (int chunk = 1; chunk < nChunks; chunk++) {
+            tasks[chunk]->Wait();
+            DropTaskHandle(tasks[chunk]);
+        }
+        // merge pairs of neighboring sorted runs until one run is left
+        for (size_t width = chunkSize; width < n; width *= 2) {
+            for (size_t lo = 0; lo + width < n; lo += 2 * width) {
+                size_t hi = std::min(lo + 2 * width, n);
+                std::inplace_merge(items + lo, items + lo + width, items + hi, cmpLess);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        strings[i] = items[i].s;
+        free(items[i].key);
+    }
+    free(items);
+}
+
 static const WCHAR* ParseLimitedNumber(const WCHAR* str, const WCHAR* format, const WCHAR** endOut, void* valueOut) {
     unsigned int width;
     WCHAR f2[] = L"% ";
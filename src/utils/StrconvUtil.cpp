@@ -5,6 +5,56 @@
 
 namespace strconv {
 
+// returns true if all chars are < 0x80, checking a machine word at a time.
+// such strings convert to UTF-16 by zero-extension (and back by truncation),
+// which is much cheaper than a MultiByteToWideChar round-trip and covers
+// the vast majority of paths and extracted text we convert
+static bool IsAsciiOnly(const char* s, size_t len) {
+    constexpr size_t kMask = (size_t)0x8080808080808080ULL;
+    size_t i = 0;
+    for (; i + sizeof(size_t) <= len; i += sizeof(size_t)) {
+        size_t w;
+        memcpy(&w, s + i, sizeof(w));
+        if (w & kMask) {
+            return false;
+        }
+    }
+    for (; i < len; i++) {
+        if ((u8)s[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool IsAsciiOnly(const WCHAR* s, size_t cch) {
+    constexpr size_t kMask = (size_t)0xFF80FF80FF80FF80ULL;
+    constexpr size_t kCharsPerWord = sizeof(size_t) / sizeof(WCHAR);
+    size_t i = 0;
+    for (; i + kCharsPerWord <= cch; i += kCharsPerWord) {
+        size_t w;
+        memcpy(&w, s + i, sizeof(w));
+        if (w & kMask) {
+            return false;
+        }
+    }
+    for (; i < cch; i++) {
+        if (s[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// code pages for which chars < 0x80 encode as a single byte of the same
+// value, so that ASCII-only strings convert by widening/truncation alone.
+// deliberately a short allowlist: exotic pages (UTF-7, SYMBOL, ...) and
+// invalid ones must keep going through the system conversion
+static bool IsAsciiCompatible(uint codePage) {
+    // 20127 is US-ASCII (see the comment in ToMultiByte)
+    return codePage == CP_UTF8 || codePage == CP_ACP || codePage == 20127;
+}
+
 size_t Utf8ToWcharBuf(const char* s, size_t cbLen, WCHAR* bufOut, size_t cchBufOutSize) {
     CrashIf(!bufOut || (0 == cchBufOutSize));
     int cchConverted = MultiByteToWideChar(CP_UTF8, 0, s, (int)cbLen, bufOut, (int)cchBufOutSize);
@@ -36,6 +86,18 @@ std::string_view WstrToCodePage(const WCHAR* txt, uint codePage, int cchTxtLen)
         return {};
     }
 
+    size_t cch = cchTxtLen >= 0 ? (size_t)cchTxtLen : str::Len(txt);
+    if (IsAsciiCompatible(codePage) && IsAsciiOnly(txt, cch)) {
+        char* res = AllocArray<char>(cch + 1); // +1 for terminating 0
+        if (!res) {
+            return {};
+        }
+        for (size_t i = 0; i < cch; i++) {
+            res[i] = (char)txt[i];
+        }
+        return {res, str::Len(res)};
+    }
+
     int bufSize = WideCharToMultiByte(codePage, 0, txt, cchTxtLen, nullptr, 0, nullptr, nullptr);
     if (0 == bufSize) {
         return {};
@@ -56,6 +118,18 @@ WCHAR* ToWideChar(const char* src, uint codePage, int cbSrcLen) {
         return nullptr;
     }
 
+    size_t srcLen = cbSrcLen >= 0 ? (size_t)cbSrcLen : str::Len(src);
+    if (IsAsciiCompatible(codePage) && IsAsciiOnly(src, srcLen)) {
+        WCHAR* res = AllocArray<WCHAR>(srcLen + 1);
+        if (!res) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < srcLen; i++) {
+            res[i] = (WCHAR)(u8)src[i];
+        }
+        return res;
+    }
+
     int requiredBufSize = MultiByteToWideChar(codePage, 0, src, cbSrcLen, nullptr, 0);
     if (0 == requiredBufSize) {
         return str::Dup(L"");
@@ -85,6 +159,12 @@ std::string_view ToMultiByte(const char* src, uint codePageSrc, uint codePageDes
         return std::string_view(str::Dup(src));
     }
 
+    // ASCII-only input encodes identically in both code pages,
+    // so skip the round-trip through UTF-16
+    if (IsAsciiCompatible(codePageSrc) && IsAsciiCompatible(codePageDest) && IsAsciiOnly(src, str::Len(src))) {
+        return std::string_view(str::Dup(src));
+    }
+
     AutoFreeWstr tmp(ToWideChar(src, codePageSrc));
     if (!tmp) {
         return {};
@@ -163,6 +243,14 @@ static void Set(StackWstrToUtf8* o, const WCHAR* s, int cch) {
         return;
     }
 
+    if ((size_t)cch < sizeof(o->buf) && IsAsciiOnly(s, (size_t)cch)) {
+        for (int i = 0; i < cch; i++) {
+            o->buf[i] = (char)s[i];
+        }
+        o->buf[cch] = 0;
+        return;
+    }
+
     int cbBufSize = (int)sizeof(o->buf) - 1; // -1 for terminating zero
     int res = WideCharToMultiByte(CP_UTF8, 0, s, cch, o->buf, cbBufSize, nullptr, nullptr);
     if (res > 0) {
@@ -2,6 +2,7 @@
    License: Simplified BSD (see COPYING.BSD) */
 
 #include "BaseUtil.h"
+#include "Vec.h"
 #include "ThreadUtil.h"
 #include "ScopedWin.h"
 
@@ -99,3 +100,216 @@ void RunAsync(const std::function<void()>& func) {
     auto fp = new std::function<void()>(func);
     AutoCloseHandle h(CreateThread(nullptr, 0, ThreadFunc, fp, 0, 0));
 }
+
+#pragma warning(disable : 28159) // silence /analyze: Consider using 'GetTickCount64' instead of 'GetTickCount'
+
+// how long a poll of the power status stays valid
+#define POWER_STATUS_CACHE_MS 2000
+
+static DWORD gPowerStatusTick = 0;
+static LONG gPowerSaving = 0;
+
+bool IsPowerSavingActive() {
+    DWORD now = GetTickCount();
+    if (0 == gPowerStatusTick || now - gPowerStatusTick >= POWER_STATUS_CACHE_MS) {
+        gPowerStatusTick = now;
+        SYSTEM_POWER_STATUS sps{};
+        LONG saving = 0;
+        if (GetSystemPowerStatus(&sps)) {
+            // AC line offline means running on battery; the status flag is
+            // set while Windows' battery saver is on (which the user can
+            // also force while plugged in)
+            saving = (0 == sps.ACLineStatus) || (0 != (sps.SystemStatusFlag & 1));
+        }
+        InterlockedExchange(&gPowerSaving, saving);
+    }
+    return 0 != InterlockedAdd(&gPowerSaving, 0);
+}
+
+enum {
+    TASK_QUEUED = 0,
+    TASK_RUNNING,
+    TASK_DONE,
+    TASK_CANCELLED,
+};
+
+TaskHandle::TaskHandle(const std::function<void()>& fn) : fn(fn) {
+    doneEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+}
+
+TaskHandle::~TaskHandle() {
+    CloseHandle(doneEvent);
+}
+
+bool TaskHandle::Cancel() {
+    LONG prev = InterlockedCompareExchange(&state, TASK_CANCELLED, TASK_QUEUED);
+    if (TASK_QUEUED != prev) {
+        return false;
+    }
+    SetEvent(doneEvent);
+    return true;
+}
+
+bool TaskHandle::Wait(DWORD waitMs) {
+    return WAIT_OBJECT_0 == WaitForSingleObject(doneEvent, waitMs);
+}
+
+bool TaskHandle::IsDone() {
+    LONG res = InterlockedAdd(&state, 0);
+    return TASK_DONE == res || TASK_CANCELLED == res;
+}
+
+void DropTaskHandle(TaskHandle* task) {
+    if (!task) {
+        return;
+    }
+    if (0 == InterlockedDecrement(&task->refs)) {
+        delete task;
+    }
+}
+
+/* Per-thread state of a pool worker. Each worker owns one queue per
+   priority lane; workers that run out of work steal from the others */
+struct PoolWorker {
+    ThreadPool* pool = nullptr;
+    int no = 0;
+    HANDLE thread = nullptr;
+    Mutex queueAccess;
+    Vec<TaskHandle*> queues[TASK_PRIORITY_COUNT];
+};
+
+ThreadPool::ThreadPool() {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    // leave one core for the thread the submitter runs on
+    threadCount = limitValue((int)si.dwNumberOfProcessors - 1, 1, MAX_POOL_THREADS);
+
+    workAvailable = CreateSemaphore(nullptr, 0, MAXLONG, nullptr);
+    workers = new PoolWorker[threadCount];
+    for (int i = 0; i < threadCount; i++) {
+        PoolWorker* w = &workers[i];
+        w->pool = this;
+        w->no = i;
+        w->thread = CreateThread(nullptr, 0, PoolWorkerThread, w, 0, 0);
+        CrashIf(nullptr == w->thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    InterlockedIncrement(&shuttingDown);
+    ReleaseSemaphore(workAvailable, threadCount, nullptr);
+    for (int i = 0; i < threadCount; i++) {
+        WaitForSingleObject(workers[i].thread, INFINITE);
+        CloseHandle(workers[i].thread);
+    }
+    // drop the tasks that never got to run
+    for (int i = 0; i < threadCount; i++) {
+        PoolWorker* w = &workers[i];
+        for (int prio = 0; prio < TASK_PRIORITY_COUNT; prio++) {
+            for (TaskHandle* task : w->queues[prio]) {
+                task->Cancel();
+                DropTaskHandle(task);
+            }
+        }
+    }
+    delete[] workers;
+    CloseHandle(workAvailable);
+}
+
+TaskHandle* ThreadPool::Submit(const std::function<void()>& fn, TaskPriority prio) {
+    int lane = (int)prio;
+    CrashIf(lane < 0 || lane >= TASK_PRIORITY_COUNT);
+
+    auto task = new TaskHandle(fn);
+    // spread the load round-robin over the workers' queues
+    PoolWorker* w = &workers[(uint)InterlockedIncrement(&nextWorkerNo) % (uint)threadCount];
+    w->queueAccess.Lock();
+    w->queues[lane].Append(task);
+    w->queueAccess.Unlock();
+    ReleaseSemaphore(workAvailable, 1, nullptr);
+    return task;
+}
+
+// while power saving, tasks from the speculative lanes start at most
+// this often, so that queued-up background work trickles out instead of
+// keeping all cores busy
+#define POWER_SAVE_TASK_GAP_MS 1000
+
+/* Grab the most urgent task available: scan each priority lane across all
+   workers before moving on to the next lane, starting with the worker's own
+   queue. A worker pops its own newest task (it's the most cache-warm) but
+   steals the oldest task of another worker, like other work-stealing
+   schedulers do. While power saving is active the Prefetch and Background
+   lanes are throttled to one task per POWER_SAVE_TASK_GAP_MS; Interactive
+   work always runs unrestricted. */
+TaskHandle* ThreadPool::TakeTask(int workerNo) {
+    int laneCount = TASK_PRIORITY_COUNT;
+    bool powerSaving = IsPowerSavingActive();
+    if (powerSaving && 0 != nextSpeculativeTick && GetTickCount() < nextSpeculativeTick) {
+        laneCount = 1;
+    }
+    for (int prio = 0; prio < laneCount; prio++) {
+        for (int i = 0; i < threadCount; i++) {
+            PoolWorker* w = &workers[(workerNo + i) % threadCount];
+            TaskHandle* task = nullptr;
+            w->queueAccess.Lock();
+            Vec<TaskHandle*>& queue = w->queues[prio];
+            if (queue.size() > 0) {
+                task = (0 == i) ? queue.Pop() : queue.PopAt(0);
+            }
+            w->queueAccess.Unlock();
+            if (task) {
+                if (powerSaving && prio > 0) {
+                    // two workers passing the check at once only means one
+                    // extra task starts early, no need for stricter locking
+                    nextSpeculativeTick = GetTickCount() + POWER_SAVE_TASK_GAP_MS;
+                }
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+DWORD WINAPI ThreadPool::PoolWorkerThread(LPVOID data) {
+    PoolWorker* worker = (PoolWorker*)data;
+    ThreadPool* pool = worker->pool;
+    SetThreadName(GetCurrentThreadId(), "PoolWorker");
+
+    for (;;) {
+        WaitForSingleObject(pool->workAvailable, INFINITE);
+        // every semaphore count corresponds to a queued task, but another
+        // woken worker might not have popped "its" task yet while we scan,
+        // so yield and rescan instead of going back to sleep
+        TaskHandle* task = nullptr;
+        for (;;) {
+            if (InterlockedAdd(&pool->shuttingDown, 0) > 0) {
+                return 0;
+            }
+            task = pool->TakeTask(worker->no);
+            if (task) {
+                break;
+            }
+            // while power saving, the remaining work may sit in a lane
+            // that can't be served for a while; poll in larger steps so
+            // the rescan itself doesn't keep the CPU busy
+            Sleep(IsPowerSavingActive() ? 50 : 0);
+        }
+
+        if (TASK_QUEUED == InterlockedCompareExchange(&task->state, TASK_RUNNING, TASK_QUEUED)) {
+            task->fn();
+            InterlockedExchange(&task->state, TASK_DONE);
+            SetEvent(task->doneEvent);
+        }
+        // (else the task was cancelled while it was queued)
+        DropTaskHandle(task);
+    }
+}
+
+/* The pool shared by the whole process. Created on first use and
+   deliberately never destroyed: joining the workers during process
+   shutdown isn't worth the risk of hanging it. */
+ThreadPool* GetThreadPool() {
+    static ThreadPool* gThreadPool = new ThreadPool();
+    return gThreadPool;
+}
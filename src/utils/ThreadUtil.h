@@ -70,3 +70,90 @@ class ThreadBase {
 void SetThreadName(DWORD threadId, const char* threadName);
 
 void RunAsync(const std::function<void()>&);
+
+// true while the machine runs on battery or Windows' battery saver is
+// on; background work should then throttle itself so that an idle
+// SumatraPDF doesn't keep the CPU awake. The state is polled at most
+// every couple of seconds, so this is cheap to ask on hot paths
+bool IsPowerSavingActive();
+
+/* priority lanes of a ThreadPool; lower values are more urgent. Workers
+   drain Interactive work from all queues before touching Prefetch, and
+   Prefetch before Background */
+enum class TaskPriority {
+    Interactive = 0, // work the user is waiting on (e.g. rendering a visible page)
+    Prefetch,        // work that hides future latency (e.g. decoding the next page)
+    Background,      // work without a deadline (e.g. text indexing)
+};
+
+#define TASK_PRIORITY_COUNT 3
+
+// upper limit for the number of pool worker threads; the actual
+// number is derived from the CPU count in the ThreadPool constructor
+#define MAX_POOL_THREADS 8
+
+/* Handle to a task submitted to a ThreadPool. Ref-counted: the pool owns
+   one reference until the task has run, the submitter owns the other and
+   gives it up with DropTaskHandle (fire-and-forget tasks can do so right
+   after submitting) */
+struct TaskHandle {
+    std::function<void()> fn;
+
+    // Queued -> Running -> Done, or Queued -> Cancelled;
+    // only ever changed with interlocked operations
+    LONG state = 0;
+    // signaled once the task is done or cancelled
+    HANDLE doneEvent = nullptr;
+    LONG refs = 2;
+
+    explicit TaskHandle(const std::function<void()>& fn);
+    ~TaskHandle();
+
+    // prevents the task from running if it hasn't started yet; returns
+    // false if it's already running or finished (Wait to be sure it's over)
+    bool Cancel();
+    // returns true when the task is done or cancelled, false if the wait timed out
+    bool Wait(DWORD waitMs = INFINITE);
+    bool IsDone();
+};
+
+void DropTaskHandle(TaskHandle* task);
+
+struct PoolWorker;
+
+/* A small work-stealing thread pool with priority lanes, meant to be
+   shared by all subsystems (see GetThreadPool) so that parallel features
+   don't each spin their own threads and oversubscribe the cores. Tasks
+   are spread round-robin over the workers' queues; an idle worker steals
+   from the other workers' queues. Don't submit tasks that block for a
+   long time: they'd starve everybody else. */
+class ThreadPool {
+  public:
+    // one slot per worker thread (defined in ThreadUtil.cpp)
+    PoolWorker* workers = nullptr;
+    int threadCount = 1;
+    // counts the queued tasks; workers block on it when idle
+    HANDLE workAvailable = nullptr;
+    LONG shuttingDown = 0;
+    // round-robin cursor for distributing submitted tasks
+    LONG nextWorkerNo = 0;
+    // while power saving, the tick before which no further task from the
+    // speculative lanes (Prefetch, Background) may start; written and
+    // read without locking as approximate throttling is good enough
+    DWORD nextSpeculativeTick = 0;
+
+    ThreadPool();
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+    // cancels all tasks that haven't started and joins the workers
+    ~ThreadPool();
+
+    // the returned handle must be given up with DropTaskHandle
+    TaskHandle* Submit(const std::function<void()>& fn, TaskPriority prio = TaskPriority::Background);
+
+    TaskHandle* TakeTask(int workerNo);
+    static DWORD WINAPI PoolWorkerThread(LPVOID data);
+};
+
+// the process-wide pool shared by all subsystems, created on first use
+ThreadPool* GetThreadPool();
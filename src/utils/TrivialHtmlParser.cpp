@@ -63,6 +63,10 @@ static WCHAR IntToChar(int codepoint) {
 // caller needs to free() the result
 WCHAR* DecodeHtmlEntitites(const char* string, uint codepage) {
     WCHAR* fixed = strconv::FromCodePage(string, codepage);
+    if (!str::FindChar(fixed, '&')) {
+        // nothing to decode (the common case for hhc attribute values)
+        return fixed;
+    }
     WCHAR* dst = fixed;
     const WCHAR* src = fixed;
 
@@ -157,6 +161,7 @@ HtmlElement* HtmlParser::AllocElement(HtmlTag tag, char* name, HtmlElement* pare
     el->up = parent;
     el->down = nullptr;
     el->next = nullptr;
+    el->lastChild = nullptr;
     el->codepage = codepage;
     ++elementsCount;
     return el;
@@ -195,13 +200,11 @@ void HtmlParser::StartTag(HtmlToken* tok) {
     } else if (nullptr == parent->down) {
         // parent has no children => set as a first child
         parent->down = currElement;
+        parent->lastChild = currElement;
     } else {
-        // parent has children => set as a sibling
-        HtmlElement* tmp = parent->down;
-        while (tmp->next) {
-            tmp = tmp->next;
-        }
-        tmp->next = currElement;
+        // parent has children => append after the last one
+        parent->lastChild->next = currElement;
+        parent->lastChild = currElement;
     }
 }
 
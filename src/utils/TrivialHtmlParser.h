@@ -25,6 +25,9 @@ struct HtmlElement {
     char* name; // name is nullptr whenever tag != Tag_NotFound
     HtmlAttr* firstAttr;
     HtmlElement *up, *down, *next;
+    // tail of the child list, so appending in StartTag doesn't have to
+    // walk all siblings (quadratic for the huge flat lists in hhc files)
+    HtmlElement* lastChild;
     uint codepage;
 
     bool NameIs(const char* name) const;
@@ -7,22 +7,61 @@
 
 namespace uitask {
 
+// producers push tasks onto a lock-free list (the OS-provided SList)
+// and the UI thread drains all of them in one go. Only the first task
+// of a burst posts a wake-up message, so e.g. 20 render callbacks
+// landing after a fast scroll cost one message-pump roundtrip, not 20
+
+struct TaskEntry {
+    SLIST_ENTRY hdr;
+    std::function<void()> fn;
+
+    explicit TaskEntry(const std::function<void()>& fn) : fn(fn) {
+    }
+};
+
+// SLIST_ENTRY dictates the MEMORY_ALLOCATION_ALIGNMENT of TaskEntry,
+// which operator new honors since C++17
+alignas(MEMORY_ALLOCATION_ALIGNMENT) static SLIST_HEADER gTaskQueue;
+static LONG gWakePending = 0;
 static HWND gTaskDispatchHwnd = nullptr;
 
 #define UITASK_CLASS_NAME L"UITask_Wnd_Class"
 #define WM_EXECUTE_TASK (WM_USER + 104)
 
+static void ExecuteQueuedTasks() {
+    PSLIST_ENTRY e = InterlockedFlushSList(&gTaskQueue);
+    // the list comes back in LIFO order, reverse it so that tasks
+    // run in the order they were posted
+    PSLIST_ENTRY prev = nullptr;
+    while (e) {
+        PSLIST_ENTRY next = e->Next;
+        e->Next = prev;
+        prev = e;
+        e = next;
+    }
+    while (prev) {
+        TaskEntry* task = CONTAINING_RECORD(prev, TaskEntry, hdr);
+        prev = prev->Next;
+        task->fn();
+        delete task;
+    }
+}
+
 static LRESULT CALLBACK WndProcTaskDispatch(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
     if (WM_EXECUTE_TASK == msg) {
-        auto func = (std::function<void()>*)lp;
-        (*func)();
-        delete func;
+        // reset before draining so that tasks pushed while we run
+        // arm another wake-up and are not missed
+        InterlockedExchange(&gWakePending, 0);
+        ExecuteQueuedTasks();
         return 0;
     }
     return DefWindowProc(hwnd, msg, wp, lp);
 }
 
 void Initialize() {
+    InitializeSListHead(&gTaskQueue);
+
     WNDCLASSEX wcex;
     FillWndClassEx(wcex, UITASK_CLASS_NAME, WndProcTaskDispatch);
     RegisterClassEx(&wcex);
@@ -47,8 +86,12 @@ void Destroy() {
 }
 
 void Post(const std::function<void()>& f) {
-    auto func = new std::function<void()>(f);
-    PostMessageW(gTaskDispatchHwnd, WM_EXECUTE_TASK, 0, (LPARAM)func);
+    auto task = new TaskEntry(f);
+    InterlockedPushEntrySList(&gTaskQueue, &task->hdr);
+    // coalesce bursts: only the first task after a drain posts a wake-up
+    if (0 == InterlockedCompareExchange(&gWakePending, 1, 0)) {
+        PostMessageW(gTaskDispatchHwnd, WM_EXECUTE_TASK, 0, 0);
+    }
 } // NOLINT
 
 void PostOptimized(const std::function<void()>& f) {
@@ -58,8 +101,7 @@ void PostOptimized(const std::function<void()>& f) {
         f();
         return;
     }
-    auto func = new std::function<void()>(f);
-    PostMessageW(gTaskDispatchHwnd, WM_EXECUTE_TASK, 0, (LPARAM)func);
+    Post(f);
 } // NOLINT
 
 } // namespace uitask
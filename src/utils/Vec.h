@@ -7,12 +7,16 @@
 store pointer types or POD types
 (http://stackoverflow.com/questions/146452/what-are-pod-types-in-c).
 
+The first N elements are stored inline, inside the Vec itself; only
+growing past N allocates. Short-lived vectors on hot paths can pick
+a larger N so that their typical size never touches the heap.
+
 We always pad the elements with a single 0 value. This makes
 Vec<char> and Vec<WCHAR> a C-compatible string. Although it's
 not useful for other types, the code is simpler if we always do it
 (rather than have it an optional behavior).
 */
-template <typename T>
+template <typename T, size_t N = 16>
 class Vec {
   public:
     Allocator* allocator{nullptr};
@@ -20,7 +24,7 @@ class Vec {
     size_t cap{0};
     size_t capacityHint{0};
     T* els{nullptr};
-    T buf[16];
+    T buf[N];
 
     static constexpr size_t kPadding = 1;
     static constexpr size_t kBufSize = sizeof(buf);
@@ -363,8 +367,8 @@ class Vec {
 };
 
 // only suitable for T that are pointers to C++ objects
-template <typename T>
-inline void DeleteVecMembers(Vec<T>& v) {
+template <typename T, size_t N>
+inline void DeleteVecMembers(Vec<T, N>& v) {
     for (T& el : v) {
         delete el;
     }
@@ -468,14 +472,11 @@ class WStrVec : public Vec<WCHAR*> {
         Vec::Sort(cmpAscii);
     }
     void SortNatural() {
-        Vec::Sort(cmpNatural);
+        // precomputes collation keys and sorts in parallel; see StrUtil_win.cpp
+        str::SortNatural(els, len);
     }
 
   private:
-    static int cmpNatural(const void* a, const void* b) {
-        return str::CmpNatural(*(const WCHAR**)a, *(const WCHAR**)b);
-    }
-
     static int cmpAscii(const void* a, const void* b) {
         return wcscmp(*(const WCHAR**)a, *(const WCHAR**)b);
     }
@@ -25,12 +25,35 @@ Size SizeFromData(std::span<u8> d) {
     return size;
 }
 
-Gdiplus::Bitmap* ImageFromData(std::span<u8> d) {
+Gdiplus::Bitmap* ImageFromData(std::span<u8> d, int maxDx, int maxDy) {
+    const u8* data = (const u8*)d.data();
+    size_t len = d.size();
     int w, h;
-    if (!WebPGetInfo((const u8*)d.data(), d.size(), &w, &h)) {
+    if (!WebPGetInfo(data, len, &w, &h)) {
         return nullptr;
     }
 
+    WebPDecoderConfig config;
+    if (!WebPInitDecoderConfig(&config)) {
+        return nullptr;
+    }
+    // if the result only needs to be maxDx x maxDy big, have the decoder
+    // produce a 1/2, 1/4, ... size image directly, which skips most of
+    // the decoding work (cf. the JPEG DCT scaling in FzImgReader.cpp)
+    int factor = 1;
+    if (maxDx > 0 && maxDy > 0) {
+        while (w / (factor * 2) >= maxDx && h / (factor * 2) >= maxDy) {
+            factor *= 2;
+        }
+    }
+    if (factor > 1) {
+        config.options.use_scaling = 1;
+        config.options.scaled_width = (w + factor - 1) / factor;
+        config.options.scaled_height = (h + factor - 1) / factor;
+        w = config.options.scaled_width;
+        h = config.options.scaled_height;
+    }
+
     Gdiplus::Bitmap bmp(w, h, PixelFormat32bppARGB);
     Gdiplus::Rect bmpRect(0, 0, w, h);
     Gdiplus::BitmapData bmpData;
@@ -38,10 +61,34 @@ Gdiplus::Bitmap* ImageFromData(std::span<u8> d) {
     if (ok != Gdiplus::Ok) {
         return nullptr;
     }
-    if (!WebPDecodeBGRAInto((const u8*)d.data(), d.size(), (u8*)bmpData.Scan0, bmpData.Stride * h, bmpData.Stride)) {
+
+    config.output.colorspace = MODE_BGRA;
+    config.output.is_external_memory = 1;
+    config.output.u.RGBA.rgba = (u8*)bmpData.Scan0;
+    config.output.u.RGBA.stride = bmpData.Stride;
+    config.output.u.RGBA.size = (size_t)bmpData.Stride * h;
+
+    // decode through the incremental decoder in chunks, straight into the
+    // bitmap's pixels; after every WebPIAppend the rows decoded so far are
+    // complete in the output buffer (WebPIDecGetRGB), which is what a
+    // progressive consumer would hook into
+    WebPIDecoder* idec = WebPIDecode(nullptr, 0, &config);
+    if (!idec) {
+        bmp.UnlockBits(&bmpData);
         return nullptr;
     }
+    VP8StatusCode status = VP8_STATUS_SUSPENDED;
+    size_t off = 0;
+    while (off < len && VP8_STATUS_SUSPENDED == status) {
+        size_t chunk = std::min<size_t>(len - off, 256 * 1024);
+        status = WebPIAppend(idec, data + off, chunk);
+        off += chunk;
+    }
+    WebPIDelete(idec);
     bmp.UnlockBits(&bmpData);
+    if (status != VP8_STATUS_OK) {
+        return nullptr;
+    }
 
     // hack to avoid the use of ::new (because there won't be a corresponding ::delete)
     return bmp.Clone(0, 0, w, h, PixelFormat32bppARGB);
@@ -57,7 +104,7 @@ bool HasSignature(std::span<u8>) {
 Size SizeFromData(std::span<u8>) {
     return Size();
 }
-Gdiplus::Bitmap* ImageFromData(std::span<u8>) {
+Gdiplus::Bitmap* ImageFromData(std::span<u8>, int, int) {
     return nullptr;
 }
 } // namespace webp
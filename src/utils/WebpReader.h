@@ -5,6 +5,8 @@ namespace webp {
 
 bool HasSignature(std::span<u8>);
 Size SizeFromData(std::span<u8>);
-Gdiplus::Bitmap* ImageFromData(std::span<u8>);
+// maxDx/maxDy give the size the caller will scale the image down to;
+// the image is then decoded at a fraction of its full resolution
+Gdiplus::Bitmap* ImageFromData(std::span<u8>, int maxDx = 0, int maxDy = 0);
 
 } // namespace webp
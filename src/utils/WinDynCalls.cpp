@@ -14,6 +14,8 @@ NORMALIZ_API_LIST(API_DECLARATION)
 USER32_API_LIST(API_DECLARATION)
 DWMAPI_API_LIST(API_DECLARATION)
 DBGHELP_API_LIST(API_DECLARATION)
+D2D1_API_LIST(API_DECLARATION)
+DWRITE_API_LIST(API_DECLARATION)
 
 #undef API_DECLARATION
 
@@ -71,6 +73,16 @@ void InitDynCalls() {
     if (h) {
         DBGHELP_API_LIST(API_LOAD)
     }
+
+    h = SafeLoadLibrary("d2d1.dll");
+    if (h) {
+        D2D1_API_LIST(API_LOAD);
+    }
+
+    h = SafeLoadLibrary("dwrite.dll");
+    if (h) {
+        DWRITE_API_LIST(API_LOAD);
+    }
 }
 
 #undef API_LOAD
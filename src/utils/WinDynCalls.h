@@ -20,6 +20,8 @@ The intent is to standardize how we do it.
 #include <OleAcc.h>
 #include <WinNls.h>
 #include <processthreadsapi.h>
+#include <d2d1.h>
+#include <dwrite.h>
 
 // dbghelp.h is included here so that warning C4091 can be disabled in a single location
 #pragma warning(push)
@@ -125,6 +127,20 @@ DWMAPI_API_LIST(API_DECLARATION2)
 
 DBGHELP_API_LIST(API_DECLARATION2)
 
+// d2d1.dll
+// d2d1.h also declares inline template overloads of D2D1CreateFactory, which
+// makes decltype() on the name ambiguous, so spell the signature out
+typedef HRESULT(WINAPI* Sig_D2D1CreateFactory)(D2D1_FACTORY_TYPE, REFIID, const D2D1_FACTORY_OPTIONS*, void**);
+
+#define D2D1_API_LIST(V) V(D2D1CreateFactory)
+
+D2D1_API_LIST(API_DECLARATION)
+
+// dwrite.dll
+#define DWRITE_API_LIST(V) V(DWriteCreateFactory)
+
+DWRITE_API_LIST(API_DECLARATION2)
+
 #undef API_DECLARATION
 #undef API_DECLARATION2
 
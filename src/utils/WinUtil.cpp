@@ -1667,6 +1667,75 @@ void UpdateBitmapColors(HBITMAP hbmp, COLORREF textColor, COLORREF bgColor) {
     DeleteDC(hDC);
 }
 
+// Remaps a bitmap that UpdateBitmapColors already mapped to (fromText, fromBg)
+// so that it looks as if it had been rendered with (textColor, bgColor)
+// instead. The two linear channel maps compose into a single 256-entry lookup
+// table per channel, so the pass over the pixels is limited by memory
+// bandwidth (a few ms even for a 4K page). Used by RenderCache to patch its
+// cached renders in place on a theme change. Returns false when the pixel
+// data isn't directly accessible; such bitmaps have to wait for a re-render.
+bool RemapBitmapColors(HBITMAP hbmp, COLORREF fromText, COLORREF fromBg, COLORREF textColor, COLORREF bgColor) {
+    if ((fromText & 0xFFFFFF) == (textColor & 0xFFFFFF) && (fromBg & 0xFFFFFF) == (bgColor & 0xFFFFFF)) {
+        return true;
+    }
+
+    // color order in DIB is blue-green-red-alpha
+    byte rt, gt, bt;
+    UnpackRgb(fromText, rt, gt, bt);
+    int baseOld[4] = {bt, gt, rt, 0};
+    byte rb, gb, bb;
+    UnpackRgb(fromBg, rb, gb, bb);
+    int diffOld[4] = {(int)bb - baseOld[0], (int)gb - baseOld[1], (int)rb - baseOld[2], 255};
+
+    UnpackRgb(textColor, rt, gt, bt);
+    int base[4] = {bt, gt, rt, 0};
+    UnpackRgb(bgColor, rb, gb, bb);
+    int diff[4] = {(int)bb - base[0], (int)gb - base[1], (int)rb - base[2], 255};
+
+    u8 lut[4][256];
+    for (int k = 0; k < 4; k++) {
+        for (int v = 0; v < 256; v++) {
+            // invert v = baseOld + mul255(orig, diffOld), then apply the new map
+            int orig = v;
+            if (diffOld[k] != 0) {
+                orig = limitValue(((v - baseOld[k]) * 255) / diffOld[k], 0, 255);
+            }
+            lut[k][v] = (u8)(base[k] + mul255(orig, diff[k]));
+        }
+    }
+
+    DIBSECTION info = {0};
+    int ret = GetObject(hbmp, sizeof(info), &info);
+    CrashIf(ret < sizeof(info.dsBm));
+    Size size(info.dsBm.bmWidth, info.dsBm.bmHeight);
+
+    // for mapped 32-bit DI bitmaps: directly access the pixel data
+    if (ret >= sizeof(info.dsBm) && info.dsBm.bmBits && 32 == info.dsBm.bmBitsPixel &&
+        size.dx * 4 == info.dsBm.bmWidthBytes) {
+        int bmpBytes = size.dx * size.dy * 4;
+        u8* bmpData = (u8*)info.dsBm.bmBits;
+        for (int i = 0; i < bmpBytes; i++) {
+            bmpData[i] = lut[i % 4][bmpData[i]];
+        }
+        return true;
+    }
+
+    // for mapped 24-bit DI bitmaps: directly access the pixel data
+    if (ret >= sizeof(info.dsBm) && info.dsBm.bmBits && 24 == info.dsBm.bmBitsPixel &&
+        info.dsBm.bmWidthBytes >= size.dx * 3) {
+        u8* bmpData = (u8*)info.dsBm.bmBits;
+        for (int y = 0; y < size.dy; y++) {
+            for (int x = 0; x < size.dx * 3; x++) {
+                bmpData[x] = lut[x % 3][bmpData[x]];
+            }
+            bmpData += info.dsBm.bmWidthBytes;
+        }
+        return true;
+    }
+
+    return false;
+}
+
 // create data for a .bmp file from this bitmap (if saved to disk, the HBITMAP
 // can be deserialized with LoadImage(nullptr, ..., LD_LOADFROMFILE) and its
 // dimensions determined again with GetBitmapSize(...))
@@ -9,6 +9,7 @@
 #include "utils/ScopedWin.h"
 #include "utils/DirIter.h"
 #include "utils/FileUtil.h"
+#include "utils/ThreadUtil.h"
 
 extern "C" {
 #include <unarr.h>
@@ -100,34 +101,89 @@ static u32 zip_compress(void* dst, u32 dstlen, const void* src, u32 srclen) {
     return newdstlen;
 }
 
-bool ZipCreator::AddFileData(const char* nameUtf8, const void* data, size_t size, u32 dosdate) {
-    CrashIf(size >= UINT32_MAX);
-    CrashIf(str::Len(nameUtf8) >= UINT16_MAX);
+// a file read, checksummed and deflated off the output path, to be
+// written into the archive later
+struct ZipPendingFile {
+    AutoFreeWstr filePath;
+    AutoFree nameUtf8;
+    AutoFree compressed;
+    u32 compressedSize = 0;
+    u32 uncompressedSize = 0;
+    u16 method = 0;
+    u32 crc = 0;
+    u32 dosdate = 0;
+    bool ok = false;
+    TaskHandle* task = nullptr;
+};
+
+// the CPU-heavy part of adding a file: checksum and deflate (or fall
+// back to Store); doesn't touch the output stream so it's safe to run
+// on a pool worker
+static bool CompressForZip(const void* data, size_t size, ZipPendingFile* pf) {
     if (size >= UINT32_MAX) {
         return false;
     }
-
-    size_t fileOffset = bytesWritten;
-    u16 flags = (1 << 11); // filename is UTF-8
-    uInt crc = crc32(0, (const Bytef*)data, (uInt)size);
-    size_t namelen = str::Len(nameUtf8);
-    if (namelen >= UINT16_MAX) {
+    pf->crc = crc32(0, (const Bytef*)data, (uInt)size);
+    pf->compressed.Set((char*)malloc(size));
+    if (!pf->compressed.Get()) {
         return false;
     }
+    pf->method = Z_DEFLATED;
+    pf->compressedSize = zip_compress(pf->compressed.Get(), (u32)size, data, (u32)size);
+    if (!pf->compressedSize) {
+        pf->method = 0; // Store
+        memcpy(pf->compressed.Get(), data, size);
+        pf->compressedSize = (u32)size;
+    }
+    pf->uncompressedSize = (u32)size;
+    return true;
+}
 
-    u16 method = Z_DEFLATED;
-    uLongf compressedSize = (u32)size;
-    AutoFree compressed((char*)malloc(size));
-    if (!compressed) {
+static u32 ZipDosDateTime(const WCHAR* filePath) {
+    u32 dosdatetime = 0;
+    FILETIME ft = file::GetModificationTime(filePath);
+    if (ft.dwLowDateTime || ft.dwHighDateTime) {
+        FILETIME ftLocal;
+        WORD dosDate, dosTime;
+        if (FileTimeToLocalFileTime(&ft, &ftLocal) && FileTimeToDosDateTime(&ftLocal, &dosDate, &dosTime)) {
+            dosdatetime = MAKELONG(dosTime, dosDate);
+        }
+    }
+    return dosdatetime;
+}
+
+// the per-file work of AddFileFromDir that doesn't touch the output
+// stream: compute the zip name, read the file and deflate its content
+static bool PrepareFileForZip(const WCHAR* filePath, const WCHAR* dir, ZipPendingFile* pf) {
+    if (str::IsEmpty(dir) || !str::StartsWith(filePath, dir)) {
+        return false;
+    }
+    const WCHAR* nameInZip = filePath + str::Len(dir) + 1;
+    if (!path::IsSep(nameInZip[-1])) {
+        return false;
+    }
+    AutoFree fileData = file::ReadFile(filePath);
+    if (!fileData.data) {
         return false;
     }
-    compressedSize = zip_compress(compressed, (u32)size, data, (u32)size);
-    if (!compressedSize) {
-        method = 0; // Store
-        memcpy(compressed.Get(), data, size);
-        compressedSize = (u32)size;
+    pf->dosdate = ZipDosDateTime(filePath);
+    pf->nameUtf8 = AutoFree(strconv::WstrToUtf8(nameInZip));
+    str::TransChars(pf->nameUtf8.Get(), "\\", "/");
+    return CompressForZip(fileData.Get(), fileData.size(), pf);
+}
+
+// writes local header, name and compressed data, remembers the matching
+// central directory entry for Finish()
+bool ZipCreator::WriteFileEntry(const char* nameUtf8, const void* compressed, u32 compressedSize, u16 method, u32 crc,
+                                u32 uncompressedSize, u32 dosdate) {
+    size_t namelen = str::Len(nameUtf8);
+    if (namelen >= UINT16_MAX) {
+        return false;
     }
 
+    size_t fileOffset = bytesWritten;
+    u16 flags = (1 << 11); // filename is UTF-8
+
     constexpr size_t kHdrSize = 30;
     ByteWriterLE local(kHdrSize);
     local.Write32(0x04034B50); // signature
@@ -137,7 +193,7 @@ bool ZipCreator::AddFileData(const char* nameUtf8, const void* data, size_t size
     local.Write32(dosdate);
     local.Write32(crc);
     local.Write32(compressedSize);
-    local.Write32((u32)size);
+    local.Write32(uncompressedSize);
     local.Write16((u16)namelen);
     local.Write16(0); // extra field length
     CrashIf(local.d.size() != kHdrSize);
@@ -157,7 +213,7 @@ bool ZipCreator::AddFileData(const char* nameUtf8, const void* data, size_t size
     central.Write32(dosdate);
     central.Write32(crc);
     central.Write32(compressedSize);
-    central.Write32((u32)size);
+    central.Write32(uncompressedSize);
     central.Write16((u16)namelen);
     central.Write16(0); // extra field length
     central.Write16(0); // file comment length
@@ -174,6 +230,18 @@ bool ZipCreator::AddFileData(const char* nameUtf8, const void* data, size_t size
     return ok;
 }
 
+bool ZipCreator::AddFileData(const char* nameUtf8, const void* data, size_t size, u32 dosdate) {
+    CrashIf(size >= UINT32_MAX);
+    CrashIf(str::Len(nameUtf8) >= UINT16_MAX);
+
+    ZipPendingFile pf;
+    if (!CompressForZip(data, size, &pf)) {
+        return false;
+    }
+    return WriteFileEntry(nameUtf8, pf.compressed.Get(), pf.compressedSize, pf.method, pf.crc, pf.uncompressedSize,
+                          dosdate);
+}
+
 // add a given file under (optional) nameInZip
 bool ZipCreator::AddFile(const WCHAR* filePath, const WCHAR* nameInZip) {
     AutoFree fileData = file::ReadFile(filePath);
@@ -181,15 +249,7 @@ bool ZipCreator::AddFile(const WCHAR* filePath, const WCHAR* nameInZip) {
         return false;
     }
 
-    u32 dosdatetime = 0;
-    FILETIME ft = file::GetModificationTime(filePath);
-    if (ft.dwLowDateTime || ft.dwHighDateTime) {
-        FILETIME ftLocal;
-        WORD dosDate, dosTime;
-        if (FileTimeToLocalFileTime(&ft, &ftLocal) && FileTimeToDosDateTime(&ftLocal, &dosDate, &dosTime)) {
-            dosdatetime = MAKELONG(dosTime, dosDate);
-        }
-    }
+    u32 dosdatetime = ZipDosDateTime(filePath);
 
     if (!nameInZip) {
         nameInZip = path::IsAbsolute(filePath) ? path::GetBaseNameNoFree(filePath) : filePath;
@@ -214,13 +274,33 @@ bool ZipCreator::AddFileFromDir(const WCHAR* filePath, const WCHAR* dir) {
 }
 
 bool ZipCreator::AddDir(const WCHAR* dirPath, bool recursive) {
+    // reading and deflating the files is the expensive part, so each
+    // file becomes a thread pool task; the output stream is sequential,
+    // so results are written in submission order below, which also
+    // keeps the archive layout identical to a serial run
+    Vec<ZipPendingFile*> pending;
     DirIter di(dirPath, recursive);
-    for (const WCHAR* filePath = di.First(); filePath; filePath = di.Next()) {
-        if (!AddFileFromDir(filePath, dirPath)) {
-            return false;
+    for (const WCHAR* iterPath = di.First(); iterPath; iterPath = di.Next()) {
+        auto* pf = new ZipPendingFile();
+        pf->filePath.SetCopy(iterPath);
+        auto fn = [pf, dirPath] { pf->ok = PrepareFileForZip(pf->filePath, dirPath, pf); };
+        pf->task = GetThreadPool()->Submit(fn, TaskPriority::Interactive);
+        pending.Append(pf);
+    }
+
+    bool ok = true;
+    for (auto* pf : pending) {
+        pf->task->Wait();
+        DropTaskHandle(pf->task);
+        if (ok && pf->ok) {
+            ok = WriteFileEntry(pf->nameUtf8.Get(), pf->compressed.Get(), pf->compressedSize, pf->method, pf->crc,
+                                pf->uncompressedSize, pf->dosdate);
+        } else {
+            ok = false;
         }
+        delete pf;
     }
-    return true;
+    return ok;
 }
 
 bool ZipCreator::Finish() {
@@ -13,6 +13,8 @@ class ZipCreator {
     size_t fileCount;
 
     bool WriteData(const void* data, size_t size);
+    bool WriteFileEntry(const char* nameUtf8, const void* compressed, u32 compressedSize, u16 method, u32 crc,
+                        u32 uncompressedSize, u32 dosdate);
     bool AddFileData(const char* nameUtf8, const void* data, size_t size, u32 dosdate = 0);
 
   public:
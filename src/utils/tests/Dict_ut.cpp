@@ -74,9 +74,48 @@ void DictTestMapStrToInt() {
         ok = d.Remove(k, nullptr);
         utassert(ok);
     }
+    utassert(0 == d.Count());
+
+    // inserting into a table full of tombstones must recycle them
+    ok = d.Insert(toRemove.at(0), 17, nullptr);
+    utassert(ok);
+    ok = d.Get(toRemove.at(0), &val);
+    utassert(ok);
+    utassert(17 == val);
     toRemove.FreeMembers();
 }
 
+static void DictTestMapWStrToPtr() {
+    dict::MapWStrToPtr d(4);
+    bool ok;
+    void* val;
+    int a, b;
+
+    utassert(0 == d.Count());
+    ok = d.Get(L"foo", &val);
+    utassert(!ok);
+
+    ok = d.Insert(L"foo", &a, nullptr);
+    utassert(ok);
+    utassert(1 == d.Count());
+    ok = d.Get(L"foo", &val);
+    utassert(ok);
+    utassert(&a == val);
+
+    // inserting an existing key fails and reports the previous value
+    val = nullptr;
+    ok = d.Insert(L"foo", &b, &val);
+    utassert(!ok);
+    utassert(&a == val);
+    utassert(1 == d.Count());
+
+    ok = d.Remove(L"foo", &val);
+    utassert(ok);
+    utassert(&a == val);
+    utassert(0 == d.Count());
+}
+
 void DictTest() {
     DictTestMapStrToInt();
+    DictTestMapWStrToPtr();
 }
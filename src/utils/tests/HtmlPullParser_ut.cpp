@@ -108,6 +108,31 @@ static void Test03() {
     utassert(!t);
 }
 
+static void Test04() {
+    // exercise the vectorized SkipUntil with matches at every offset
+    // within and past the first 16-byte block
+    char buf[64];
+    memset(buf, 'a', sizeof(buf));
+    for (size_t at = 0; at < sizeof(buf); at++) {
+        buf[at] = '<';
+        const char* s = buf;
+        utassert(SkipUntil(s, buf + sizeof(buf), '<'));
+        utassert(s == buf + at);
+        buf[at] = 'a';
+    }
+    const char* s = buf;
+    utassert(!SkipUntil(s, buf + sizeof(buf) - 1, '<'));
+    utassert(s == buf + sizeof(buf) - 1);
+
+    const char* comment = "no terminator here ............................ --> tail";
+    s = comment;
+    const char* end = comment + str::Len(comment);
+    utassert(SkipUntil(s, end, "-->"));
+    utassert(str::StartsWith(s, "--> tail"));
+    s = comment;
+    utassert(!SkipUntil(s, end, "--!"));
+}
+
 void HtmlPullParser_UnitTests() {
     Test00("<p a1='>' foo=bar />", HtmlToken::EmptyElementTag);
     Test00("<p a1 ='>'     foo=\"bar\"/>", HtmlToken::EmptyElementTag);
@@ -118,4 +143,5 @@ void HtmlPullParser_UnitTests() {
     Test01();
     Test02();
     Test03();
+    Test04();
 }
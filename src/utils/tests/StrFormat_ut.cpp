@@ -34,4 +34,17 @@ void StrFormatTest() {
           "c: x, i: -18, f: 3.45, d: -18.38, s: str, ws: wstr, c: x, i: -18, f: 3.45, d: -18.38, s: str, ws: wstr, i: "
           "-18");
     free(s);
+
+    auto sv = fmt::Format("{1} = {0}", 5, "five");
+    check(sv.data(), "five = 5");
+    free((void*)sv.data());
+
+    // long enough to spill past Fmt::res inline buffer
+    sv = fmt::Format("%s and %s and %c", "a string of 26 characters!", L"a wstring of 27 characters!", '.');
+    check(sv.data(), "a string of 26 characters! and a wstring of 27 characters! and .");
+    free((void*)sv.data());
+
+    sv = fmt::Format("{0}", -18.38);
+    check(sv.data(), "-18.38");
+    free((void*)sv.data());
 }
@@ -632,6 +632,19 @@ void StrTest() {
         AutoFree tmp = strconv::WstrToCodePage(L"abc", 987654);
         utassert(str::IsEmpty(tmp.Get()));
     }
+    {
+        // long enough to exercise the word-at-a-time ASCII fast path
+        AutoFreeWstr wide(strconv::Utf8ToWstr("ascii only, a machine word at a time"));
+        utassert(str::Eq(wide, L"ascii only, a machine word at a time"));
+        AutoFree narrow = strconv::WstrToUtf8(wide.Get());
+        utassert(str::Eq(narrow.Get(), "ascii only, a machine word at a time"));
+    }
+    {
+        AutoFreeWstr wide(strconv::Utf8ToWstr("na\xC3\xAFve"));
+        utassert(str::Eq(wide, L"na\u00EFve"));
+        AutoFree narrow = strconv::WstrToUtf8(wide.Get());
+        utassert(str::Eq(narrow.Get(), "na\xC3\xAFve"));
+    }
 
     {
         char buf1[6] = {0};
@@ -692,6 +705,26 @@ void StrTest() {
         utassert(str::Eq(str::FindI("test", "st"), "st"));
     }
 
+    {
+        // exercise all offsets against the vector kernel's alignment handling
+        // and the tail masking at the terminating 0
+        WCHAR buf[128];
+        for (int off = 0; off < 48; off++) {
+            for (int i = 0; i < off; i++) {
+                buf[i] = '.';
+            }
+            buf[off] = 'X';
+            buf[off + 1] = '\0';
+            utassert(str::FindChar2(buf, 'x', 'X') == buf + off);
+            utassert(str::FindChar2(buf, 'x', 'y') == nullptr);
+            utassert(str::FindI(buf, L"x") == buf + off);
+        }
+        utassert(str::FindChar2(L"", 'x', 'X') == nullptr);
+        const WCHAR* s = L"abxcX";
+        utassert(str::FindChar2(s, 'X', 'x') == s + 2);
+        utassert(str::FindChar2(s, 'X', 'X') == s + 4);
+    }
+
     strStrTest();
     strWStrTest();
     StrIsDigitTest();
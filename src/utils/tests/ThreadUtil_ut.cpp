@@ -0,0 +1,55 @@
+/* Copyright 2021 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "utils/BaseUtil.h"
+#include "utils/ThreadUtil.h"
+
+// must be last due to assert() over-write
+#include "utils/UtAssert.h"
+
+static LONG gTasksRun = 0;
+
+void ThreadUtilTest() {
+    ThreadPool pool;
+
+    // tasks submitted to all lanes run exactly once, Wait sees them finish
+    const int nTasks = 64;
+    TaskHandle* tasks[nTasks];
+    for (int i = 0; i < nTasks; i++) {
+        tasks[i] = pool.Submit([] { InterlockedIncrement(&gTasksRun); }, (TaskPriority)(i % TASK_PRIORITY_COUNT));
+    }
+    for (int i = 0; i < nTasks; i++) {
+        bool ok = tasks[i]->Wait(10 * 1000);
+        utassert(ok);
+        utassert(tasks[i]->IsDone());
+        DropTaskHandle(tasks[i]);
+    }
+    utassert(nTasks == gTasksRun);
+
+    // a task that hasn't started can be cancelled and then never runs;
+    // keep all workers busy so that the victim is guaranteed to still be queued
+    HANDLE gate = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    TaskHandle* blockers[MAX_POOL_THREADS];
+    for (int i = 0; i < MAX_POOL_THREADS; i++) {
+        blockers[i] = pool.Submit([gate] { WaitForSingleObject(gate, 10 * 1000); }, TaskPriority::Interactive);
+    }
+    TaskHandle* victim = pool.Submit([] { InterlockedIncrement(&gTasksRun); }, TaskPriority::Background);
+    bool cancelled = victim->Cancel();
+    utassert(cancelled);
+    // a cancelled task counts as finished and can't be cancelled twice
+    utassert(victim->Wait(1000));
+    utassert(victim->IsDone());
+    utassert(!victim->Cancel());
+    DropTaskHandle(victim);
+
+    SetEvent(gate);
+    for (int i = 0; i < MAX_POOL_THREADS; i++) {
+        bool ok = blockers[i]->Wait(10 * 1000);
+        utassert(ok);
+        DropTaskHandle(blockers[i]);
+    }
+    CloseHandle(gate);
+
+    // the cancelled task must not have run
+    utassert(nTasks == gTasksRun);
+}
@@ -298,6 +298,22 @@ void VecTest() {
         utassert(v.size() == 3 && v.at(0) == 0 && v.at(2) == 2);
     }
 
+    {
+        // a non-default inline capacity must spill to the heap seamlessly
+        Vec<int, 4> v;
+        for (int i = 0; i < 32; i++) {
+            v.Append(i);
+        }
+        utassert(v.size() == 32);
+        for (int i = 0; i < 32; i++) {
+            utassert(v.at(i) == i);
+        }
+        v.Reset();
+        utassert(v.size() == 0);
+        v.Append(5);
+        utassert(v.size() == 1 && v.at(0) == 5);
+    }
+
     {
         str::Str v;
         v.Append("foo");
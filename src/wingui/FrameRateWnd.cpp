@@ -39,7 +39,17 @@ static void FrameRatePaint(FrameRateWnd* w, HDC hdc, [[maybe_unused]] PAINTSTRUC
 
     ScopedSelectObject selFont(hdc, w->font);
     AutoFreeWstr txt(str::Format(L"%d", w->frameRate));
-    DrawCenteredText(hdc, rc, txt);
+    if (!w->perfInfo) {
+        DrawCenteredText(hdc, rc, txt);
+        return;
+    }
+    // frame rate in the top half, perf info below it
+    RECT rcTop = rc;
+    rcTop.bottom = rc.top + (rc.bottom - rc.top) / 2;
+    RECT rcBottom = rc;
+    rcBottom.top = rcTop.bottom;
+    DrawCenteredText(hdc, rcTop, txt);
+    DrawCenteredText(hdc, rcBottom, w->perfInfo);
 }
 
 static void PositionWindow(FrameRateWnd* w, SIZE s) {
@@ -52,6 +62,13 @@ static void PositionWindow(FrameRateWnd* w, SIZE s) {
 static SIZE GetIdealSize(FrameRateWnd* w) {
     WCHAR* txt = str::Format(L"%d", w->frameRate);
     Size s = TextSizeInHwnd(w->hwnd, txt);
+    if (w->perfInfo) {
+        Size s2 = TextSizeInHwnd(w->hwnd, w->perfInfo);
+        if (s2.dx > s.dx) {
+            s.dx = s2.dx;
+        }
+        s.dy += s2.dy;
+    }
 
     // add padding
     s.dy += 4;
@@ -182,6 +199,16 @@ void FrameRateWnd::ShowFrameRateDur(double durMs) {
     this->ShowFrameRate(FrameRateFromDuration(durMs));
 }
 
+void FrameRateWnd::ShowPerfInfo(const WCHAR* txt) {
+    if (str::Eq(this->perfInfo, txt)) {
+        return;
+    }
+    this->perfInfo.SetCopy(txt);
+    SIZE s = GetIdealSize(this);
+    PositionWindow(this, s);
+    ScheduleRepaint(this->hwnd);
+}
+
 FrameRateWnd::~FrameRateWnd() {
     RemoveWindowSubclass(this->hwndAssociatedWithTopLevel, WndProcFrameRateAssociated, 0);
 }
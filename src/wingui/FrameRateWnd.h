@@ -9,6 +9,9 @@ struct FrameRateWnd {
 
     void ShowFrameRate(int frameRate);
     void ShowFrameRateDur(double durMs);
+    // shows txt in a second line under the frame rate (e.g. render
+    // queue depth); nullptr goes back to the single-line display
+    void ShowPerfInfo(const WCHAR* txt);
 
     HWND hwndAssociatedWith = nullptr;
     HWND hwndAssociatedWithTopLevel = nullptr;
@@ -18,6 +21,7 @@ struct FrameRateWnd {
 
     SIZE maxSizeSoFar = {0, 0};
     int frameRate = -1;
+    AutoFreeWstr perfInfo;
 };
 
 int FrameRateFromDuration(double durMs);
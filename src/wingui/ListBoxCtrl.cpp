@@ -52,6 +52,42 @@ static void FillWithItems(ListBoxCtrl* w, ListBoxModel* model) {
     }
 }
 
+// an owner-data (LBS_NODATA) list box never stores the items; it asks
+// us to draw them and we get the text straight from the model
+static void Handle_WM_DRAWITEM(void* user, WndEvent* ev) {
+    auto w = (ListBoxCtrl*)user;
+    DRAWITEMSTRUCT* dis = (DRAWITEMSTRUCT*)ev->lp;
+    CrashIf(dis->hwndItem != w->hwnd);
+    ev->didHandle = true;
+    ev->result = TRUE;
+
+    HDC hdc = dis->hDC;
+    bool isSelected = (dis->itemState & ODS_SELECTED) != 0;
+    FillRect(hdc, &dis->rcItem, GetSysColorBrush(isSelected ? COLOR_HIGHLIGHT : COLOR_WINDOW));
+
+    int itemNo = (int)dis->itemID;
+    if (w->model && itemNo >= 0 && itemNo < w->model->ItemsCount()) {
+        auto sv = w->model->Item(itemNo);
+        AutoFreeWstr ws = strconv::Utf8ToWstr(sv);
+        HGDIOBJ prevFont = SelectObject(hdc, w->GetFont());
+        SetBkMode(hdc, TRANSPARENT);
+        SetTextColor(hdc, GetSysColor(isSelected ? COLOR_HIGHLIGHTTEXT : COLOR_WINDOWTEXT));
+        RECT rc = dis->rcItem;
+        rc.left += DpiScale(w->hwnd, 2);
+        DrawTextW(hdc, ws.Get(), -1, &rc, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+        SelectObject(hdc, prevFont);
+    }
+
+    if (dis->itemState & ODS_FOCUS) {
+        DrawFocusRect(hdc, &dis->rcItem);
+    }
+}
+
+static void SetVirtualItemsCount(ListBoxCtrl* w, ListBoxModel* model) {
+    int count = model ? model->ItemsCount() : 0;
+    SendMessageW(w->hwnd, LB_SETCOUNT, (WPARAM)count, 0);
+}
+
 static void DispatchSelectionChanged(ListBoxCtrl* w, WndEvent* ev) {
     ListBoxSelectionChangedEvent a;
     CopyWndEvent cp(&a, ev);
@@ -76,15 +112,32 @@ static void Handle_WM_COMMAND(void* user, WndEvent* ev) {
 }
 
 bool ListBoxCtrl::Create() {
+    if (isVirtual) {
+        // LBS_NODATA is incompatible with LBS_SORT and LBS_HASSTRINGS
+        // and requires owner draw
+        dwStyle |= LBS_OWNERDRAWFIXED | LBS_NODATA;
+    }
     bool ok = WindowBase::Create();
     // TODO: update ideal size based on the size of the model?
     if (!ok) {
         return false;
     }
+    void* user = this;
+    if (isVirtual) {
+        // WM_MEASUREITEM can't be routed back to us (it carries no hwnd)
+        // so match the height of a non owner-draw item after the fact
+        HFONT f = GetFont();
+        Size sz = HwndMeasureText(hwnd, L"A", f);
+        SendMessageW(hwnd, LB_SETITEMHEIGHT, 0, (LPARAM)sz.dy);
+        RegisterHandlerForMessage(hwnd, WM_DRAWITEM, Handle_WM_DRAWITEM, user);
+    }
     if (model != nullptr) {
-        FillWithItems(this, model);
+        if (isVirtual) {
+            SetVirtualItemsCount(this, model);
+        } else {
+            FillWithItems(this, model);
+        }
     }
-    void* user = this;
     RegisterHandlerForMessage(hwnd, WM_COMMAND, Handle_WM_COMMAND, user);
     return ok;
 }
@@ -136,9 +189,31 @@ bool ListBoxCtrl::SetCurrentSelection(int n) {
 
 void ListBoxCtrl::SetModel(ListBoxModel* model) {
     this->model = model;
-    if (model != nullptr) {
+    if (isVirtual) {
+        SetVirtualItemsCount(this, model);
+    } else if (model != nullptr) {
         FillWithItems(this, model);
     }
     SetCurrentSelection(-1);
     // TODO: update ideal size based on the size of the model
 }
+
+// tell a virtual list box that the number of items in the model changed
+// (this also resets the selection, like SetModel does)
+void ListBoxCtrl::UpdateItemsCount() {
+    CrashIf(!isVirtual);
+    SetVirtualItemsCount(this, model);
+    SetCurrentSelection(-1);
+}
+
+// repaint a single item of a virtual list box after its model data
+// changed; cheaper than re-setting the whole model
+void ListBoxCtrl::UpdateItem(int itemNo) {
+    CrashIf(!isVirtual);
+    RECT rc;
+    LRESULT res = SendMessageW(hwnd, LB_GETITEMRECT, (WPARAM)itemNo, (LPARAM)&rc);
+    if (res == LB_ERR) {
+        return;
+    }
+    InvalidateRect(hwnd, &rc, TRUE);
+}
@@ -34,6 +34,11 @@ struct ListBoxCtrl : WindowBase {
     Size idealSize{};
     int idealSizeLines = 0;
 
+    // create as an owner-data (LBS_NODATA) list box: the control only
+    // stores the item count and we draw the items straight from the
+    // model, so it stays responsive at any item count. Set before Create()
+    bool isVirtual = false;
+
     ListBoxCtrl(HWND parent);
     ~ListBoxCtrl() override;
     bool Create() override;
@@ -45,4 +50,8 @@ struct ListBoxCtrl : WindowBase {
     int GetCurrentSelection();
     bool SetCurrentSelection(int);
     void SetModel(ListBoxModel*);
+    // for virtual list boxes: the model's item count changed
+    void UpdateItemsCount();
+    // for virtual list boxes: redraw a single changed item
+    void UpdateItem(int);
 };
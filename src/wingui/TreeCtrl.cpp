@@ -145,12 +145,18 @@ static void DragStart(TreeCtrl* w, NMTREEVIEWW* nmtv) {
     w->isDragging = true;
 }
 
-static void TreeViewExpandRecursively(HWND hTree, HTREEITEM hItem, uint flag, bool subtree) {
+static void TreeViewExpandRecursively(TreeCtrl* tree, HTREEITEM hItem, uint flag, bool subtree) {
+    HWND hTree = tree->hwnd;
     while (hItem) {
+        if (flag == TVE_EXPAND) {
+            // TVM_EXPAND doesn't send TVN_ITEMEXPANDING, so deferred
+            // children have to be inserted explicitly
+            tree->EnsureChildrenMaterialized(tree->GetTreeItemByHandle(hItem));
+        }
         TreeView_Expand(hTree, hItem, flag);
         HTREEITEM child = TreeView_GetChild(hTree, hItem);
         if (child) {
-            TreeViewExpandRecursively(hTree, child, flag, false);
+            TreeViewExpandRecursively(tree, child, flag, false);
         }
         if (subtree) {
             break;
@@ -182,6 +188,7 @@ static TVITEMW* GetTVITEM(TreeCtrl* tree, TreeItem* ti) {
 // expand if collapse, collapse if expanded
 static void TreeViewToggle(TreeCtrl* tree, HTREEITEM hItem, bool recursive) {
     HWND hTree = tree->hwnd;
+    tree->EnsureChildrenMaterialized(tree->GetTreeItemByHandle(hItem));
     HTREEITEM child = TreeView_GetChild(hTree, hItem);
     if (!child) {
         // only applies to nodes with children
@@ -313,6 +320,15 @@ static void Handle_WM_NOTIFY(void* user, WndEvent* ev) {
         return;
     }
 
+    // https://docs.microsoft.com/en-us/windows/win32/controls/tvn-itemexpanding
+    if (code == TVN_ITEMEXPANDING) {
+        if (w->deferChildren && nmtv->action == TVE_EXPAND) {
+            TreeItem* ti = w->GetTreeItemByHandle(nmtv->itemNew.hItem);
+            w->EnsureChildrenMaterialized(ti);
+        }
+        return;
+    }
+
     // https://docs.microsoft.com/en-us/windows/win32/controls/tvn-itemexpanded
     if (code == TVN_ITEMEXPANDED) {
         if (!w->onTreeItemExpanded) {
@@ -419,9 +435,9 @@ static bool HandleKey(TreeCtrl* tree, WPARAM wp) {
     // consistently expand/collapse whole (sub)trees
     if (VK_MULTIPLY == wp) {
         if (IsShiftPressed()) {
-            TreeViewExpandRecursively(hwnd, TreeView_GetRoot(hwnd), TVE_EXPAND, false);
+            TreeViewExpandRecursively(tree, TreeView_GetRoot(hwnd), TVE_EXPAND, false);
         } else {
-            TreeViewExpandRecursively(hwnd, TreeView_GetSelection(hwnd), TVE_EXPAND, true);
+            TreeViewExpandRecursively(tree, TreeView_GetSelection(hwnd), TVE_EXPAND, true);
         }
     } else if (VK_DIVIDE == wp) {
         if (IsShiftPressed()) {
@@ -429,9 +445,9 @@ static bool HandleKey(TreeCtrl* tree, WPARAM wp) {
             if (!TreeView_GetNextSibling(hwnd, root)) {
                 root = TreeView_GetChild(hwnd, root);
             }
-            TreeViewExpandRecursively(hwnd, root, TVE_COLLAPSE, false);
+            TreeViewExpandRecursively(tree, root, TVE_COLLAPSE, false);
         } else {
-            TreeViewExpandRecursively(hwnd, TreeView_GetSelection(hwnd), TVE_COLLAPSE, true);
+            TreeViewExpandRecursively(tree, TreeView_GetSelection(hwnd), TVE_COLLAPSE, true);
         }
     } else if (wp == 13) {
         // this is Enter key
@@ -544,6 +560,10 @@ bool TreeCtrl::Create() {
 }
 
 bool TreeCtrl::IsExpanded(TreeItem* ti) {
+    if (deferChildren && !GetHandleByTreeItem(ti)) {
+        // a deferred item was never shown, so it can't have been toggled
+        return ti->IsExpanded();
+    }
     auto state = GetItemState(ti);
     return state.isExpanded;
 }
@@ -564,7 +584,7 @@ TreeItem* TreeCtrl::GetSelection() {
 bool TreeCtrl::SelectItem(TreeItem* ti) {
     HTREEITEM hi{nullptr};
     if (ti != nullptr) {
-        hi = GetHandleByTreeItem(ti);
+        hi = MaterializeTreeItem(ti);
     }
     BOOL ok = TreeView_SelectItem(hwnd, hi);
     return ok == TRUE;
@@ -583,14 +603,14 @@ void TreeCtrl::SetTextColor(COLORREF col) {
 void TreeCtrl::ExpandAll() {
     SuspendRedraw();
     auto root = TreeView_GetRoot(this->hwnd);
-    TreeViewExpandRecursively(this->hwnd, root, TVE_EXPAND, false);
+    TreeViewExpandRecursively(this, root, TVE_EXPAND, false);
     ResumeRedraw();
 }
 
 void TreeCtrl::CollapseAll() {
     SuspendRedraw();
     auto root = TreeView_GetRoot(this->hwnd);
-    TreeViewExpandRecursively(this->hwnd, root, TVE_COLLAPSE, false);
+    TreeViewExpandRecursively(this, root, TVE_COLLAPSE, false);
     ResumeRedraw();
 }
 
@@ -698,6 +718,12 @@ static HTREEITEM insertItem(TreeCtrl* tree, HTREEITEM parent, TreeItem* ti) {
     if (onDemand) {
         tvitem->pszText = LPSTR_TEXTCALLBACK;
     }
+    if (tree->deferChildren) {
+        // the children might not be inserted yet; claim them explicitly
+        // so that the item still gets an expand button
+        tvitem->mask |= TVIF_CHILDREN;
+        tvitem->cChildren = ti->ChildCount() > 0 ? 1 : 0;
+    }
     HTREEITEM res = TreeView_InsertItem(tree->hwnd, &toInsert);
     return res;
 }
@@ -727,7 +753,11 @@ static void PopulateTreeItem(TreeCtrl* tree, TreeItem* item, HTREEITEM parent) {
         HTREEITEM h = insertItem(tree, parent, ti);
         auto v = std::make_tuple(ti, h);
         tree->insertedItems.Append(v);
-        PopulateTreeItem(tree, ti, h);
+        // in a deferChildren tree only the visible part is inserted: the
+        // children of collapsed items are added on first expand instead
+        if (!tree->deferChildren || ti->IsExpanded()) {
+            PopulateTreeItem(tree, ti, h);
+        }
     }
 }
 
@@ -739,8 +769,37 @@ static void PopulateTree(TreeCtrl* tree, TreeModel* tm) {
         HTREEITEM h = insertItem(tree, parent, ti);
         auto v = std::make_tuple(ti, h);
         tree->insertedItems.Append(v);
-        PopulateTreeItem(tree, ti, h);
+        if (!tree->deferChildren || ti->IsExpanded()) {
+            PopulateTreeItem(tree, ti, h);
+        }
+    }
+}
+
+void TreeCtrl::EnsureChildrenMaterialized(TreeItem* ti) {
+    if (!ti || ti->ChildCount() == 0) {
+        return;
+    }
+    HTREEITEM h = GetHandleByTreeItem(ti);
+    if (!h || TreeView_GetChild(hwnd, h)) {
+        // not inserted itself / children inserted already
+        return;
+    }
+    PopulateTreeItem(this, ti, h);
+}
+
+HTREEITEM TreeCtrl::MaterializeTreeItem(TreeItem* ti) {
+    HTREEITEM h = GetHandleByTreeItem(ti);
+    if (h || !deferChildren) {
+        return h;
+    }
+    TreeItem* parent = ti->Parent();
+    if (!parent || !MaterializeTreeItem(parent)) {
+        // root items are always inserted, so this is an item that
+        // isn't part of the current model
+        return nullptr;
     }
+    EnsureChildrenMaterialized(parent);
+    return GetHandleByTreeItem(ti);
 }
 
 void TreeCtrl::SetTreeModel(TreeModel* tm) {
@@ -109,6 +109,11 @@ struct TreeCtrl : WindowBase {
     // creation parameters. must be set before CreateTreeCtrl() call
     bool withCheckboxes{false};
 
+    // if true, children are only inserted into the tree view when their
+    // parent is first expanded. Keeps SetTreeModel() fast for models with
+    // tens of thousands of items (e.g. huge PDF outlines)
+    bool deferChildren{false};
+
     // set before Create() to enable drag&drop
     bool supportDragDrop{false};
 
@@ -190,6 +195,13 @@ struct TreeCtrl : WindowBase {
     HTREEITEM GetHandleByTreeItem(TreeItem*);
     TreeItem* GetTreeItemByHandle(HTREEITEM);
 
+    // inserts the deferred children of an item (see deferChildren);
+    // no-op if they were inserted already
+    void EnsureChildrenMaterialized(TreeItem*);
+    // like GetHandleByTreeItem but first inserts the item if its
+    // insertion was deferred (by materializing all its ancestors)
+    HTREEITEM MaterializeTreeItem(TreeItem*);
+
     void SetCheckState(TreeItem*, bool);
     bool GetCheckState(TreeItem*);
 